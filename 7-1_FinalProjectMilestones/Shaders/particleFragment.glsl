@@ -0,0 +1,24 @@
+///////////////////////////////////////////////////////////////////////////////
+// particlefragment.glsl
+// ============
+// fragment shader for the particles - soft round sprites
+//
+///////////////////////////////////////////////////////////////////////////////
+#version 430 core
+
+in vec2 fragmentCorner;
+in vec4 fragmentColor;
+
+out vec4 outFragmentColor;
+
+void main()
+{
+	// fade out towards the edge of the quad's inscribed circle
+	float alpha = fragmentColor.a * (1.0 - smoothstep(0.5, 1.0, length(fragmentCorner)));
+	if (alpha < 0.01)
+	{
+		discard;
+	}
+
+	outFragmentColor = vec4(fragmentColor.rgb, alpha);
+}
@@ -0,0 +1,39 @@
+///////////////////////////////////////////////////////////////////////////////
+// particlevertex.glsl
+// ============
+// vertex shader for the particles - one camera facing quad per instance
+//
+///////////////////////////////////////////////////////////////////////////////
+#version 430 core
+
+// xyz - position, w - fraction of the particle's life used
+layout (location = 0) in vec4 inParticle;
+
+uniform mat4 view;
+uniform mat4 projection;
+// half size at birth and at death
+uniform vec2 particleSize;
+uniform vec4 colorStart;
+uniform vec4 colorEnd;
+
+out vec2 fragmentCorner;
+out vec4 fragmentColor;
+
+// corners of the quad drawn as a four vertex triangle strip
+const vec2 g_Corners[4] = vec2[4](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));
+
+void main()
+{
+	vec2 corner = g_Corners[gl_VertexID];
+	float life = clamp(inParticle.w, 0.0, 1.0);
+	float size = mix(particleSize.x, particleSize.y, life);
+
+	// the camera right and up axes are the first two rows of the view rotation
+	vec3 right = vec3(view[0][0], view[1][0], view[2][0]);
+	vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
+	vec3 position = inParticle.xyz + (right * corner.x + up * corner.y) * size;
+
+	fragmentCorner = corner;
+	fragmentColor = mix(colorStart, colorEnd, life);
+	gl_Position = projection * view * vec4(position, 1.0);
+}
@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenecubegeometry.glsl
+// ============
+// geometry shader for the layered panorama pass - every triangle the scene
+// vertex shader outputs in world space is projected into each of the six
+// cube faces and routed to that face's layer of the cube map
+//
+///////////////////////////////////////////////////////////////////////////////
+#version 430 core
+
+// one invocation per cube face
+layout (triangles, invocations = 6) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+// face cameras - must match CUBE_FACE_CONSTANTS in PanoramaCapture.h
+layout (std140, binding = 3) uniform CubeFaceBlock
+{
+	mat4 faceViewProjection[6];
+};
+
+// the scene vertex shader outputs, by location
+layout (location = 0) in vec3 vertexPosition[];
+layout (location = 1) in vec3 vertexNormal[];
+layout (location = 2) in vec2 vertexTextureCoordinate[];
+layout (location = 3) flat in int vertexInstance[];
+
+// the scene fragment shader inputs, by location
+layout (location = 0) out vec3 fragmentPosition;
+layout (location = 1) out vec3 fragmentVertexNormal;
+layout (location = 2) out vec2 fragmentTextureCoordinate;
+layout (location = 3) flat out int fragmentInstance;
+
+void main()
+{
+	mat4 viewProjection = faceViewProjection[gl_InvocationID];
+	vec4 clipPosition[3];
+	for (int i = 0; i < 3; i++)
+	{
+		// the frame block matrices are identity in this pass, so
+		// the incoming position is the world position
+		clipPosition[i] = viewProjection * gl_in[i].gl_Position;
+	}
+
+	// the objects were only culled against all six faces at once,
+	// so drop the triangles entirely outside of this face
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if ((clipPosition[0][axis] > clipPosition[0].w) &&
+			(clipPosition[1][axis] > clipPosition[1].w) &&
+			(clipPosition[2][axis] > clipPosition[2].w))
+		{
+			return;
+		}
+		if ((clipPosition[0][axis] < -clipPosition[0].w) &&
+			(clipPosition[1][axis] < -clipPosition[1].w) &&
+			(clipPosition[2][axis] < -clipPosition[2].w))
+		{
+			return;
+		}
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		gl_Layer = gl_InvocationID;
+		gl_Position = clipPosition[i];
+		fragmentPosition = vertexPosition[i];
+		fragmentVertexNormal = vertexNormal[i];
+		fragmentTextureCoordinate = vertexTextureCoordinate[i];
+		fragmentInstance = vertexInstance[i];
+		EmitVertex();
+	}
+	EndPrimitive();
+}
@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefragment.glsl
+// ============
+// fragment shader for the 3D scene - colors come from the instance
+// buffer, materials and lights from their own shader storage buffers
+//
+///////////////////////////////////////////////////////////////////////////////
+#version 430 core
+
+// must match INSTANCE_RECORD in SceneBuffers.h
+struct INSTANCE
+{
+	mat4 world;
+	vec4 color;
+	vec2 uvScale;
+	int materialIndex;
+	float windStiffness;
+	float windPhase;
+	float reserved0;
+	float reserved1;
+	float reserved2;
+};
+
+// must match MATERIAL_RECORD in SceneBuffers.h
+struct MATERIAL
+{
+	vec3 ambientColor;
+	float ambientStrength;
+	vec3 diffuseColor;
+	float shininess;
+	vec3 specularColor;
+	float reserved;
+};
+
+// must match LIGHT_RECORD in SceneBuffers.h
+struct LIGHT_SOURCE
+{
+	vec3 position;
+	float focalStrength;
+	vec3 ambientColor;
+	float specularIntensity;
+	vec3 diffuseColor;
+	float reserved0;
+	vec3 specularColor;
+	float reserved1;
+};
+
+layout (std430, binding = 0) readonly buffer InstanceBuffer
+{
+	INSTANCE instances[];
+};
+
+layout (std430, binding = 1) readonly buffer MaterialBuffer
+{
+	MATERIAL materials[];
+};
+
+layout (std430, binding = 2) readonly buffer LightBuffer
+{
+	LIGHT_SOURCE lightSources[];
+};
+
+// explicit locations, so the layered pass can put a geometry
+// shader with its own names for them in between
+layout (location = 0) in vec3 fragmentPosition;
+layout (location = 1) in vec3 fragmentVertexNormal;
+layout (location = 2) in vec2 fragmentTextureCoordinate;
+layout (location = 3) flat in int fragmentInstance;
+
+out vec4 outFragmentColor;
+
+// per-frame constants - must match FRAME_CONSTANTS in SceneBuffers.h
+layout (std140, binding = 1) uniform FrameBlock
+{
+	mat4 view;
+	mat4 projection;
+	// w is unused
+	vec4 viewPosition;
+	int bUseLighting;
+	int lightCount;
+};
+
+// per-draw constants - must match DRAW_CONSTANTS in SceneBuffers.h
+layout (std140, binding = 2) uniform DrawBlock
+{
+	// record of the first instance drawn by the current draw call
+	int instanceBase;
+	// texture unit to sample, or -1 for the instance color
+	int textureSlot;
+};
+
+// samplers cannot live in a uniform block, so every scene texture
+// stays bound to its own unit and the draw block picks one
+uniform sampler2D objectTextures[16];
+
+// ambient, diffuse and specular contribution of one light source
+vec3 CalcLightSource(LIGHT_SOURCE light, MATERIAL material, vec3 lightNormal, vec3 viewDirection)
+{
+	vec3 ambient = light.ambientColor * material.ambientColor * material.ambientStrength;
+
+	vec3 lightDirection = normalize(light.position - fragmentPosition);
+	float impact = max(dot(lightNormal, lightDirection), 0.0);
+	vec3 diffuse = impact * light.diffuseColor * material.diffuseColor;
+
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0), max(light.focalStrength, 1.0));
+	vec3 specular = light.specularIntensity * specularComponent * light.specularColor * material.specularColor;
+
+	return(ambient + diffuse + specular);
+}
+
+void main()
+{
+	INSTANCE instance = instances[fragmentInstance];
+
+	vec4 objectColor = instance.color;
+	if (textureSlot >= 0)
+	{
+		objectColor = texture(objectTextures[textureSlot], fragmentTextureCoordinate);
+	}
+
+	if (bUseLighting != 0)
+	{
+		// objects without a material reflect nothing but ambient light
+		MATERIAL material = MATERIAL(vec3(1.0), 1.0, vec3(0.0), 0.0, vec3(0.0), 0.0);
+		if (instance.materialIndex >= 0)
+		{
+			material = materials[instance.materialIndex];
+		}
+
+		vec3 lightNormal = normalize(fragmentVertexNormal);
+		vec3 viewDirection = normalize(viewPosition.xyz - fragmentPosition);
+		vec3 phongResult = vec3(0.0);
+		for (int i = 0; i < lightCount; i++)
+		{
+			phongResult += CalcLightSource(lightSources[i], material, lightNormal, viewDirection);
+		}
+
+		outFragmentColor = vec4(phongResult * objectColor.xyz, objectColor.w);
+	}
+	else
+	{
+		outFragmentColor = objectColor;
+	}
+}
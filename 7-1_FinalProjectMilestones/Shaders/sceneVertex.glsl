@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenevertex.glsl
+// ============
+// vertex shader for the 3D scene - per-object data comes from the
+// instance buffer and the camera from the frame block, and foliage instances
+// are bent by the wind here so any pass using this shader sways them
+//
+///////////////////////////////////////////////////////////////////////////////
+#version 430 core
+
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+// must match INSTANCE_RECORD in SceneBuffers.h
+struct INSTANCE
+{
+	mat4 world;
+	vec4 color;
+	vec2 uvScale;
+	int materialIndex;
+	float windStiffness;
+	float windPhase;
+	float reserved0;
+	float reserved1;
+	float reserved2;
+};
+
+layout (std430, binding = 0) readonly buffer InstanceBuffer
+{
+	INSTANCE instances[];
+};
+
+// global wind - must match WIND_UNIFORMS in WindSystem.h
+layout (std140, binding = 0) uniform WindBlock
+{
+	// xyz - direction, w - sway strength
+	vec4 windDirection;
+	// x - sway angle, y - gust angle, z - flutter angle, w - gust strength
+	vec4 windParameters;
+};
+
+// per-frame constants - must match FRAME_CONSTANTS in SceneBuffers.h
+layout (std140, binding = 1) uniform FrameBlock
+{
+	mat4 view;
+	mat4 projection;
+	// w is unused
+	vec4 viewPosition;
+	int bUseLighting;
+	int lightCount;
+};
+
+// per-draw constants - must match DRAW_CONSTANTS in SceneBuffers.h
+layout (std140, binding = 2) uniform DrawBlock
+{
+	// record of the first instance drawn by the current draw call
+	int instanceBase;
+	// texture unit to sample, or -1 for the instance color
+	int textureSlot;
+};
+
+// explicit locations, so the layered pass can put a geometry
+// shader with its own names for them in between
+layout (location = 0) out vec3 fragmentPosition;
+layout (location = 1) out vec3 fragmentVertexNormal;
+layout (location = 2) out vec2 fragmentTextureCoordinate;
+layout (location = 3) flat out int fragmentInstance;
+
+// bend a vertex away from the wind, more the higher it is above the
+// instance origin - stiffer plants bend less and rigid ones not at all
+vec3 ApplyWind(vec3 worldPosition, vec3 instanceOrigin, float stiffness, float phase)
+{
+	if (stiffness <= 0.0)
+	{
+		return(worldPosition);
+	}
+
+	float height = max(worldPosition.y - instanceOrigin.y, 0.0);
+
+	float sway = sin(windParameters.x + phase) * windDirection.w;
+	float gust = (sin(windParameters.y + phase * 0.25) * 0.5 + 0.5) * windParameters.w;
+	// leaves flutter faster than the whole plant sways
+	float flutter = sin(windParameters.z + dot(worldPosition, vec3(1.7, 0.9, 1.3))) * windDirection.w * 0.15;
+
+	return(worldPosition + windDirection.xyz * ((sway + gust + flutter) * height / stiffness));
+}
+
+void main()
+{
+	int instance = instanceBase + gl_InstanceID;
+	mat4 model = instances[instance].world;
+	vec4 worldPosition = model * vec4(inVertexPosition, 1.0);
+	worldPosition.xyz = ApplyWind(
+		worldPosition.xyz,
+		model[3].xyz,
+		instances[instance].windStiffness,
+		instances[instance].windPhase);
+
+	fragmentPosition = vec3(worldPosition);
+	fragmentVertexNormal = mat3(transpose(inverse(model))) * inVertexNormal;
+	fragmentTextureCoordinate = inTextureCoordinate * instances[instance].uvScale;
+	fragmentInstance = instance;
+
+	gl_Position = projection * view * worldPosition;
+}
@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchrenderer.cpp
+// ============
+// render a list of camera poses back to back into images, without
+// a visible window
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BatchRenderer.h"
+#include "FrameRecorder.h"
+#include "MemoryTracker.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// declaration of global variables
+namespace
+{
+	// images queued for every encoder before the render thread
+	// waits for them, so a slow disk cannot fill the memory
+	const size_t g_QueuedImagesPerEncoder = 2;
+}
+
+/***********************************************************
+ *  BatchRenderer()
+ *
+ *  The constructor for the class.
+ ***********************************************************/
+BatchRenderer::BatchRenderer(int width, int height)
+{
+	m_width = std::max(width, 1);
+	m_height = std::max(height, 1);
+	m_stats = {};
+}
+
+/***********************************************************
+ *  LoadPoses()
+ *
+ *  This method is used for reading the camera poses from a
+ *  text file.  A line that cannot be read fails the whole
+ *  file, so a typo does not silently leave a pose out of a
+ *  dataset.
+ ***********************************************************/
+bool BatchRenderer::LoadPoses(const char* filename)
+{
+	m_poses.clear();
+
+	std::ifstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << "Could not open camera poses:" << filename << std::endl;
+		return(false);
+	}
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		std::istringstream stream(line);
+		std::string first;
+		if (!(stream >> first) || (first[0] == '#'))
+		{
+			continue;
+		}
+		stream.clear();
+		stream.seekg(0);
+
+		BATCH_POSE pose;
+		if (!(stream >> pose.eye.x >> pose.eye.y >> pose.eye.z
+			>> pose.target.x >> pose.target.y >> pose.target.z
+			>> pose.fieldOfViewDegrees))
+		{
+			std::cout << "WARNING: " << filename << " line " << lineNumber << " is not a camera pose" << std::endl;
+			m_poses.clear();
+			return(false);
+		}
+		if (!(stream >> pose.frameTime))
+		{
+			pose.frameTime = 0.0;
+		}
+		m_poses.push_back(pose);
+	}
+
+	std::cout << "INFO: loaded " << m_poses.size() << " camera poses from " << filename << std::endl;
+	return(!m_poses.empty());
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for rendering every pose and writing
+ *  the images.  The render thread only culls, records and
+ *  starts a readback for each pose, and goes straight on to
+ *  the next one.
+ ***********************************************************/
+bool BatchRenderer::Run(SceneManager* pScene, const char* outputDirectory)
+{
+	m_stats = {};
+	if (m_poses.empty() || !m_target.Create(m_width, m_height, "batch render", MemoryTracker::MEMTAG_CAPTURE))
+	{
+		return(false);
+	}
+
+	std::string directory(outputDirectory);
+	if (!directory.empty() && (directory.back() != '/') && (directory.back() != '\\'))
+	{
+		directory += '/';
+	}
+
+	// the job system's workers cull and record the poses, so the
+	// encoders take the other half of the cores
+	unsigned int encoderCount = std::max(std::thread::hardware_concurrency() / 2, 1u);
+	FrameRecorder recorder(encoderCount);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_target.GetFramebuffer());
+	glViewport(0, 0, m_width, m_height);
+
+	std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+	double renderMilliseconds = 0.0;
+	for (size_t i = 0; i < m_poses.size(); i++)
+	{
+		const BATCH_POSE& pose = m_poses[i];
+		std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
+
+		glEnable(GL_DEPTH_TEST);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		pScene->SetViewProjection(
+			glm::lookAt(pose.eye, pose.target, glm::vec3(0.0f, 1.0f, 0.0f)),
+			glm::perspective(glm::radians(pose.fieldOfViewDegrees), (float)m_width / (float)m_height, 0.1f, 100.0f));
+		pScene->SetFrameTime(pose.frameTime);
+		pScene->RenderScene();
+		renderMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - renderStart).count();
+
+		char filename[32];
+		snprintf(filename, sizeof(filename), "pose_%05u.png", (unsigned int)i);
+		recorder.RequestScreenshot(directory + filename);
+		recorder.EndFrame(m_width, m_height);
+		recorder.WaitForEncoders(encoderCount * g_QueuedImagesPerEncoder);
+
+		GLResourceManager::EndFrame();
+	}
+	recorder.Shutdown();
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	m_target.Destroy();
+
+	m_stats.images = recorder.GetStats().framesWritten;
+	m_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+	m_stats.imagesPerSecond = (m_stats.seconds > 0.0) ? m_stats.images / m_stats.seconds : 0.0;
+	m_stats.renderMilliseconds = renderMilliseconds / m_poses.size();
+	m_stats.readbackWaits = recorder.GetStats().readbackWaits;
+
+	std::cout << "INFO: rendered " << m_stats.images << " of " << m_poses.size() << " poses at "
+		<< m_width << "x" << m_height << " in " << m_stats.seconds << "s - "
+		<< m_stats.imagesPerSecond << " images/s, "
+		<< m_stats.renderMilliseconds << "ms a pose on the render thread, "
+		<< m_stats.readbackWaits << " waits for the GPU, "
+		<< encoderCount << " encoder threads" << std::endl;
+	return(m_stats.images == m_poses.size());
+}
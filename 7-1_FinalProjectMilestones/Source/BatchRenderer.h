@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchrenderer.h
+// ============
+// render a list of camera poses back to back into images, without
+// a visible window
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "OffscreenTarget.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  BATCH_POSE
+ *
+ *  One camera the scene is rendered from.
+ ***********************************************************/
+struct BATCH_POSE
+{
+	glm::vec3 eye;
+	glm::vec3 target;
+	float fieldOfViewDegrees;
+	// wind animation time the pose is rendered at
+	double frameTime;
+};
+
+/***********************************************************
+ *  BATCH_RENDER_STATS
+ *
+ *  Throughput of the last run.
+ ***********************************************************/
+struct BATCH_RENDER_STATS
+{
+	uint32_t images;
+	double seconds;
+	double imagesPerSecond;
+	// render thread time to cull and record one pose
+	double renderMilliseconds;
+	// readbacks the GPU had not finished when the ring needed them
+	uint32_t readbackWaits;
+};
+
+/***********************************************************
+ *  BatchRenderer
+ *
+ *  This class renders every pose of a list into an offscreen
+ *  framebuffer and writes each into its own PNG image.  The
+ *  scene is prepared once, so the buffers, transforms and
+ *  bounds are reused by every pose and only the culling and
+ *  command recording run again.  Nothing waits for a pose to
+ *  finish: the readbacks trail the GPU by a few poses, and
+ *  the encoders write the images in parallel while the next
+ *  poses render.
+ ***********************************************************/
+class BatchRenderer
+{
+public:
+	// constructor
+	BatchRenderer(int width, int height);
+
+	// read the poses from a text file, one per line - the eye,
+	// the target, the vertical field of view in degrees, and
+	// optionally the wind time.  Lines starting with # are
+	// comments.
+	bool LoadPoses(const char* filename);
+	// render every pose into pose_<index>.png in the directory -
+	// the OpenGL context and the job system have to exist
+	bool Run(SceneManager* pScene, const char* outputDirectory);
+
+	size_t GetPoseCount() const { return m_poses.size(); }
+	const BATCH_RENDER_STATS& GetStats() const { return m_stats; }
+
+private:
+	int m_width;
+	int m_height;
+	std::vector<BATCH_POSE> m_poses;
+
+	// offscreen framebuffer the poses render into
+	OffscreenTarget m_target;
+
+	BATCH_RENDER_STATS m_stats;
+};
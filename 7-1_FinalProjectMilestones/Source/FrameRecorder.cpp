@@ -0,0 +1,551 @@
+///////////////////////////////////////////////////////////////////////////////
+// framerecorder.cpp
+// ============
+// read back rendered frames without stalling and encode them in the
+// background, as screenshots or a continuous recording
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameRecorder.h"
+#include "GLDebug.h"
+#include "Metrics.h"
+#include "SoftwareScene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// nanoseconds waited for a fence before the wait is retried
+	const GLuint64 g_FenceTimeout = 1000000000;
+
+	// recorded frames waiting for an encoder before new ones are
+	// dropped - each holds a whole frame of pixels
+	const size_t g_MaxQueuedFrames = 8;
+
+	/***********************************************************
+	 *  g_ConvertToYUV420()
+	 *
+	 *  Convert RGBA8 pixels, top row first, into the full range
+	 *  BT.601 Y, Cb and Cr planes of a C420jpeg Y4M frame.  The
+	 *  chroma of every 2x2 block of pixels is averaged.
+	 ***********************************************************/
+	void g_ConvertToYUV420(const uint32_t* pPixels, int width, int height, std::vector<uint8_t>& planes)
+	{
+		int chromaWidth = (width + 1) / 2;
+		int chromaHeight = (height + 1) / 2;
+		size_t lumaBytes = (size_t)width * height;
+		size_t chromaBytes = (size_t)chromaWidth * chromaHeight;
+		planes.resize(lumaBytes + chromaBytes * 2);
+		uint8_t* pY = planes.data();
+		uint8_t* pCb = pY + lumaBytes;
+		uint8_t* pCr = pCb + chromaBytes;
+
+		for (int y = 0; y < height; y++)
+		{
+			const uint32_t* pRow = pPixels + (size_t)y * width;
+			for (int x = 0; x < width; x++)
+			{
+				int r = pRow[x] & 0xFF;
+				int g = (pRow[x] >> 8) & 0xFF;
+				int b = (pRow[x] >> 16) & 0xFF;
+				pY[(size_t)y * width + x] = (uint8_t)((77 * r + 150 * g + 29 * b + 128) >> 8);
+			}
+		}
+
+		for (int cy = 0; cy < chromaHeight; cy++)
+		{
+			for (int cx = 0; cx < chromaWidth; cx++)
+			{
+				int r = 0;
+				int g = 0;
+				int b = 0;
+				int count = 0;
+				for (int y = cy * 2; y < std::min(cy * 2 + 2, height); y++)
+				{
+					for (int x = cx * 2; x < std::min(cx * 2 + 2, width); x++)
+					{
+						uint32_t pixel = pPixels[(size_t)y * width + x];
+						r += pixel & 0xFF;
+						g += (pixel >> 8) & 0xFF;
+						b += (pixel >> 16) & 0xFF;
+						count++;
+					}
+				}
+				r /= count;
+				g /= count;
+				b /= count;
+				// offset by 128 << 8 before the shift, so it never
+				// shifts a negative value
+				pCb[(size_t)cy * chromaWidth + cx] = (uint8_t)std::min((-43 * r - 85 * g + 128 * b + 32768 + 128) >> 8, 255);
+				pCr[(size_t)cy * chromaWidth + cx] = (uint8_t)std::min((128 * r - 107 * g - 21 * b + 32768 + 128) >> 8, 255);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  ~Y4M_STREAM()
+ *
+ *  The destructor for the recording.  It runs once the last
+ *  of its frames has been written, so the counts are final.
+ ***********************************************************/
+FrameRecorder::Y4M_STREAM::~Y4M_STREAM()
+{
+	if (file.is_open() && !file.good())
+	{
+		std::cout << "WARNING: could not write recording " << filename << std::endl;
+		return;
+	}
+	std::cout << "INFO: wrote " << nextFrame << " frames into " << filename;
+	if (droppedFrames > 0)
+	{
+		std::cout << ", " << droppedFrames << " dropped because the encoders fell behind";
+	}
+	std::cout << std::endl;
+}
+
+/***********************************************************
+ *  FrameRecorder()
+ *
+ *  The constructor for the class.
+ ***********************************************************/
+FrameRecorder::FrameRecorder(unsigned int encoderThreadCount)
+{
+	for (uint32_t i = 0; i < READBACK_COUNT; i++)
+	{
+		m_readbacks[i].bufferBytes = 0;
+		m_readbacks[i].fence = NULL;
+		m_readbacks[i].width = 0;
+		m_readbacks[i].height = 0;
+	}
+	m_nextReadback = 0;
+	m_recordingWidth = 0;
+	m_recordingHeight = 0;
+	m_activeEncodes = 0;
+	m_bStopping = false;
+	m_stats = {};
+
+	encoderThreadCount = std::max(encoderThreadCount, 1u);
+	for (unsigned int i = 0; i < encoderThreadCount; i++)
+	{
+		m_encoders.emplace_back(&FrameRecorder::EncoderMain, this);
+	}
+}
+
+/***********************************************************
+ *  ~FrameRecorder()
+ *
+ *  The destructor for the class.  The encoders finish every
+ *  queued frame before they stop.
+ ***********************************************************/
+FrameRecorder::~FrameRecorder()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_bStopping = true;
+	}
+	m_queueChanged.notify_all();
+	for (size_t i = 0; i < m_encoders.size(); i++)
+	{
+		m_encoders[i].join();
+	}
+}
+
+/***********************************************************
+ *  RequestScreenshot()
+ *
+ *  This method is used for writing the next frame into a
+ *  PNG file.
+ ***********************************************************/
+void FrameRecorder::RequestScreenshot(const std::string& filename)
+{
+	m_screenshotFilename = filename;
+}
+
+/***********************************************************
+ *  StartRecording()
+ *
+ *  This method is used for opening a Y4M file that every
+ *  following frame is written into.  The header is written
+ *  with the first frame, once its size is known.
+ ***********************************************************/
+bool FrameRecorder::StartRecording(const std::string& filename, int framesPerSecond)
+{
+	StopRecording();
+
+	std::shared_ptr<Y4M_STREAM> pRecording = std::make_shared<Y4M_STREAM>();
+	pRecording->filename = filename;
+	pRecording->framesPerSecond = std::max(framesPerSecond, 1);
+	pRecording->queuedFrames = 0;
+	pRecording->droppedFrames = 0;
+	pRecording->nextFrame = 0;
+	pRecording->file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!pRecording->file.is_open())
+	{
+		std::cout << "WARNING: could not write recording " << filename << std::endl;
+		return(false);
+	}
+
+	m_pRecording = pRecording;
+	m_recordingWidth = 0;
+	m_recordingHeight = 0;
+	std::cout << "INFO: recording into " << filename << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  StopRecording()
+ *
+ *  This method is used for ending the recording.  The frames
+ *  already read back are still written, and the file closes
+ *  after the last of them.
+ ***********************************************************/
+void FrameRecorder::StopRecording()
+{
+	if (NULL == m_pRecording)
+	{
+		return;
+	}
+	m_pRecording.reset();
+
+	// the pooled pixel buffers are only worth keeping while
+	// frames keep coming
+	std::lock_guard<std::mutex> lock(m_queueMutex);
+	m_freeBuffers.clear();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for queueing the finished readbacks
+ *  and starting the readback of the frame just drawn.  The
+ *  readbacks finish in the order they were started, so the
+ *  first one still running ends the search.
+ ***********************************************************/
+void FrameRecorder::EndFrame(int width, int height)
+{
+	for (uint32_t i = 0; i < READBACK_COUNT; i++)
+	{
+		READBACK& readback = m_readbacks[(m_nextReadback + i) % READBACK_COUNT];
+		if (NULL == readback.fence)
+		{
+			continue;
+		}
+		if (glClientWaitSync(readback.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			break;
+		}
+		Resolve(readback);
+	}
+
+	// a Y4M file holds frames of one size
+	if ((NULL != m_pRecording) && ((width != m_recordingWidth) || (height != m_recordingHeight)))
+	{
+		if (m_recordingWidth == 0)
+		{
+			m_recordingWidth = width;
+			m_recordingHeight = height;
+		}
+		else
+		{
+			std::cout << "WARNING: the window size changed, so the recording stopped" << std::endl;
+			StopRecording();
+		}
+	}
+
+	if ((m_screenshotFilename.empty() && (NULL == m_pRecording)) || (width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	// the ring has come around to a readback the GPU has not
+	// finished, which only happens when it is more than two
+	// frames behind
+	READBACK& readback = m_readbacks[m_nextReadback];
+	if (NULL != readback.fence)
+	{
+		static MetricHistogram* s_pWaits = Metrics::GetHistogram(
+			"shrine_gpu_wait_seconds", "Time the render thread waited for the GPU, by what it waited for",
+			METRIC_WAIT_BOUNDS, "source=\"frame_readback\"");
+		std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+		m_stats.readbackWaits++;
+		while (glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout) == GL_TIMEOUT_EXPIRED)
+		{
+		}
+		s_pWaits->Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count());
+		Resolve(readback);
+	}
+
+	size_t bytes = (size_t)width * height * sizeof(uint32_t);
+	if (!readback.buffer.IsValid() || (readback.bufferBytes != bytes))
+	{
+		readback.buffer = GLBufferHandle::Create("frame readback");
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.GetName());
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+		readback.bufferBytes = bytes;
+		GLResourceManager::SetMemory(
+			GLResourceManager::GLRES_BUFFER,
+			readback.buffer.GetName(),
+			MemoryTracker::MEMTAG_CAPTURE,
+			bytes);
+		GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, readback.buffer.GetName(), "frame readback");
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.GetName());
+	}
+
+	// with a pack buffer bound the copy goes into the buffer and
+	// the call returns without waiting for the frame to finish
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	// a window swap would submit the fence, but offline
+	// rendering has none, and an unsubmitted fence never signals
+	glFlush();
+
+	readback.width = width;
+	readback.height = height;
+	readback.screenshotFilename.swap(m_screenshotFilename);
+	m_screenshotFilename.clear();
+	readback.pRecording = m_pRecording;
+	m_nextReadback = (m_nextReadback + 1) % READBACK_COUNT;
+}
+
+/***********************************************************
+ *  WaitForEncoders()
+ *
+ *  This method is used for holding up the caller until the
+ *  encoders have caught up with all but the passed in number
+ *  of frames.
+ ***********************************************************/
+void FrameRecorder::WaitForEncoders(size_t maxQueuedFrames)
+{
+	std::unique_lock<std::mutex> lock(m_queueMutex);
+	m_queueChanged.wait(lock, [this, maxQueuedFrames]() { return m_queue.size() <= maxQueuedFrames; });
+}
+
+/***********************************************************
+ *  Resolve()
+ *
+ *  This method is used for copying a finished readback out
+ *  of its buffer and queueing it for the encoders.  The copy
+ *  is the only part of the work left on the render thread.
+ ***********************************************************/
+void FrameRecorder::Resolve(READBACK& readback)
+{
+	std::chrono::steady_clock::time_point copyStart = std::chrono::steady_clock::now();
+
+	glDeleteSync(readback.fence);
+	readback.fence = NULL;
+
+	ENCODE_JOB job;
+	job.width = readback.width;
+	job.height = readback.height;
+	job.screenshotFilename.swap(readback.screenshotFilename);
+	job.pRecording = std::move(readback.pRecording);
+	job.recordingFrame = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		// a screenshot is always written, a recorded frame only
+		// when the encoders are keeping up
+		if ((NULL != job.pRecording) && (m_queue.size() >= g_MaxQueuedFrames))
+		{
+			static MetricCounter* s_pDropped = Metrics::GetCounter(
+				"shrine_recording_frames_dropped_total", "Recorded frames dropped because the encoders fell behind");
+			m_stats.framesDropped++;
+			s_pDropped->Add();
+			job.pRecording->droppedFrames++;
+			job.pRecording.reset();
+			if (job.screenshotFilename.empty())
+			{
+				return;
+			}
+		}
+		if (!m_freeBuffers.empty())
+		{
+			job.pixels = std::move(m_freeBuffers.back());
+			m_freeBuffers.pop_back();
+		}
+	}
+
+	size_t pixelCount = (size_t)job.width * job.height;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.GetName());
+	const void* pMapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pixelCount * sizeof(uint32_t), GL_MAP_READ_BIT);
+	if (NULL != pMapped)
+	{
+		job.pixels.resize(pixelCount);
+		memcpy(job.pixels.data(), pMapped, pixelCount * sizeof(uint32_t));
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	if (NULL == pMapped)
+	{
+		std::cout << "WARNING: could not map a frame readback" << std::endl;
+		return;
+	}
+
+	// frames are numbered here, on the render thread, so the
+	// numbers follow the order the frames were drawn in
+	if (NULL != job.pRecording)
+	{
+		job.recordingFrame = job.pRecording->queuedFrames++;
+	}
+
+	m_stats.framesRead++;
+	m_stats.copyMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - copyStart).count();
+
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_queue.push_back(std::move(job));
+	}
+	m_queueChanged.notify_one();
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for finishing every readback and
+ *  encode still outstanding, and releasing the readback
+ *  buffers while the OpenGL context still exists.
+ ***********************************************************/
+void FrameRecorder::Shutdown()
+{
+	for (uint32_t i = 0; i < READBACK_COUNT; i++)
+	{
+		READBACK& readback = m_readbacks[(m_nextReadback + i) % READBACK_COUNT];
+		if (NULL != readback.fence)
+		{
+			while (glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout) == GL_TIMEOUT_EXPIRED)
+			{
+			}
+			Resolve(readback);
+		}
+	}
+	StopRecording();
+
+	{
+		std::unique_lock<std::mutex> lock(m_queueMutex);
+		m_queueChanged.wait(lock, [this]() { return m_queue.empty() && (m_activeEncodes == 0); });
+		m_freeBuffers.clear();
+	}
+
+	for (uint32_t i = 0; i < READBACK_COUNT; i++)
+	{
+		m_readbacks[i].buffer.Reset();
+		m_readbacks[i].bufferBytes = 0;
+	}
+
+	if (m_stats.framesRead > 0)
+	{
+		std::cout << "INFO: read back " << m_stats.framesRead << " frames, "
+			<< m_stats.copyMilliseconds / m_stats.framesRead << " ms a frame on the render thread, "
+			<< m_stats.readbackWaits << " waits for the GPU" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  EncoderMain()
+ *
+ *  This method is run by every encoder thread.  It takes
+ *  the queued frames in order until the recorder stops and
+ *  the queue is empty.
+ ***********************************************************/
+void FrameRecorder::EncoderMain()
+{
+	for (;;)
+	{
+		ENCODE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_queueChanged.wait(lock, [this]() { return m_bStopping || !m_queue.empty(); });
+			if (m_queue.empty())
+			{
+				return;
+			}
+			job = std::move(m_queue.front());
+			m_queue.pop_front();
+			m_activeEncodes++;
+		}
+
+		Encode(job);
+		// the last frame of a recording closes its file here
+		job.pRecording.reset();
+
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_activeEncodes--;
+			m_stats.framesWritten++;
+			if (m_freeBuffers.size() < g_MaxQueuedFrames)
+			{
+				m_freeBuffers.push_back(std::move(job.pixels));
+			}
+		}
+		m_queueChanged.notify_all();
+	}
+}
+
+/***********************************************************
+ *  Encode()
+ *
+ *  This method is used for writing one frame.  OpenGL reads
+ *  the bottom row first, so the rows are flipped before the
+ *  frame is written as a screenshot, a video frame or both.
+ ***********************************************************/
+void FrameRecorder::Encode(ENCODE_JOB& job)
+{
+	for (int y = 0; y < job.height / 2; y++)
+	{
+		std::swap_ranges(
+			job.pixels.begin() + (size_t)y * job.width,
+			job.pixels.begin() + (size_t)(y + 1) * job.width,
+			job.pixels.begin() + (size_t)(job.height - 1 - y) * job.width);
+	}
+
+	if (!job.screenshotFilename.empty())
+	{
+		WritePNGImage(job.screenshotFilename.c_str(), job.pixels.data(), job.width, job.height, job.width);
+	}
+	if (NULL != job.pRecording)
+	{
+		WriteY4MFrame(job);
+	}
+}
+
+/***********************************************************
+ *  WriteY4MFrame()
+ *
+ *  This method is used for converting a frame into YUV and
+ *  appending it to its recording.  The conversion runs in
+ *  parallel on every encoder, and only the write waits for
+ *  the frames before it.
+ ***********************************************************/
+void FrameRecorder::WriteY4MFrame(ENCODE_JOB& job)
+{
+	thread_local std::vector<uint8_t> planes;
+	g_ConvertToYUV420(job.pixels.data(), job.width, job.height, planes);
+
+	Y4M_STREAM& stream = *job.pRecording;
+	std::unique_lock<std::mutex> lock(stream.mutex);
+	// the frames before this one were queued first, so they are
+	// already being encoded by the other threads
+	stream.written.wait(lock, [&stream, &job]() { return stream.nextFrame == job.recordingFrame; });
+
+	if (job.recordingFrame == 0)
+	{
+		stream.file << "YUV4MPEG2 W" << job.width << " H" << job.height
+			<< " F" << stream.framesPerSecond << ":1 Ip A1:1 C420jpeg\n";
+	}
+	stream.file << "FRAME\n";
+	stream.file.write((const char*)planes.data(), planes.size());
+	stream.nextFrame++;
+
+	lock.unlock();
+	stream.written.notify_all();
+}
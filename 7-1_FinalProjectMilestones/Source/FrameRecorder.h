@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////////////
+// framerecorder.h
+// ============
+// read back rendered frames without stalling and encode them in the
+// background, as screenshots or a continuous recording
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLResources.h"
+#include "MemoryTracker.h"
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  FRAME_RECORDER_STATS
+ *
+ *  What the recorder did since it was created.
+ ***********************************************************/
+struct FRAME_RECORDER_STATS
+{
+	uint32_t framesRead;
+	uint32_t framesWritten;
+	// recorded frames thrown away because the encoders fell behind
+	uint32_t framesDropped;
+	// readbacks the ring needed back before the GPU had finished them
+	uint32_t readbackWaits;
+	// render thread time spent copying finished readbacks
+	double copyMilliseconds;
+};
+
+/***********************************************************
+ *  FrameRecorder
+ *
+ *  This class reads frames back without waiting for the GPU.
+ *  glReadPixels copies the back buffer into one of a ring of
+ *  pixel pack buffers and returns at once, and a fence marks
+ *  when the copy is done.  A readback is only mapped a frame
+ *  or two later, once its fence has signaled, and its pixels
+ *  are handed to a pool of encoder threads that write them
+ *  as PNG screenshots or as frames of a raw Y4M video.
+ *
+ *  The encoders have their own threads rather than using the
+ *  job system, since a thread waiting on scene jobs would
+ *  otherwise pick up a whole image encode in the middle of
+ *  the frame.  When they fall behind, recorded frames are
+ *  dropped instead of holding up the render thread.
+ ***********************************************************/
+class FrameRecorder
+{
+public:
+	// readbacks in flight - the GPU is normally two frames behind
+	static const uint32_t READBACK_COUNT = 3;
+
+	// constructor - starts the encoder threads
+	FrameRecorder(unsigned int encoderThreadCount = 2);
+	// destructor - finishes the queued encodes
+	~FrameRecorder();
+
+	// write the next frame into a PNG file
+	void RequestScreenshot(const std::string& filename);
+	// write every following frame into a Y4M file - the frame
+	// rate is only stored in the file, the frames are the ones
+	// rendered
+	bool StartRecording(const std::string& filename, int framesPerSecond);
+	void StopRecording();
+	bool IsRecording() const { return (NULL != m_pRecording); }
+
+	// read back the frame in the framebuffer bound for reading
+	// if it is wanted, and pass the readbacks the GPU has
+	// finished to the encoders - call after drawing and before
+	// the swap
+	void EndFrame(int width, int height);
+	// wait until no more than the passed in number of frames
+	// are queued - for offline rendering, where the encoders
+	// set the pace instead of the display
+	void WaitForEncoders(size_t maxQueuedFrames);
+	// wait for every readback and encode still outstanding,
+	// and free the readback buffers - call before the OpenGL
+	// context goes away
+	void Shutdown();
+
+	const FRAME_RECORDER_STATS& GetStats() const { return m_stats; }
+
+private:
+	typedef std::vector<uint32_t, TrackedAllocator<uint32_t, MemoryTracker::MEMTAG_CAPTURE>> PIXEL_BUFFER;
+
+	// the open Y4M file, shared by the encodes of its frames so
+	// it stays open until the last of them is written
+	struct Y4M_STREAM
+	{
+		std::string filename;
+		int framesPerSecond;
+		std::ofstream file;
+		// frames queued by the render thread, which numbers them
+		uint64_t queuedFrames;
+		uint32_t droppedFrames;
+		// frames are written in the order they were queued
+		std::mutex mutex;
+		std::condition_variable written;
+		uint64_t nextFrame;
+
+		// report the frames written once the last is done
+		~Y4M_STREAM();
+	};
+
+	struct READBACK
+	{
+		GLBufferHandle buffer;
+		size_t bufferBytes;
+		GLsync fence;
+		int width;
+		int height;
+		std::string screenshotFilename;
+		std::shared_ptr<Y4M_STREAM> pRecording;
+	};
+
+	struct ENCODE_JOB
+	{
+		int width;
+		int height;
+		PIXEL_BUFFER pixels;
+		std::string screenshotFilename;
+		std::shared_ptr<Y4M_STREAM> pRecording;
+		uint64_t recordingFrame;
+	};
+
+	READBACK m_readbacks[READBACK_COUNT];
+	uint32_t m_nextReadback;
+
+	std::string m_screenshotFilename;
+	std::shared_ptr<Y4M_STREAM> m_pRecording;
+	int m_recordingWidth;
+	int m_recordingHeight;
+
+	std::vector<std::thread> m_encoders;
+	std::mutex m_queueMutex;
+	std::condition_variable m_queueChanged;
+	std::deque<ENCODE_JOB> m_queue;
+	// reused pixel buffers, so recording does not allocate a
+	// frame worth of memory every frame
+	std::vector<PIXEL_BUFFER> m_freeBuffers;
+	uint32_t m_activeEncodes;
+	bool m_bStopping;
+
+	FRAME_RECORDER_STATS m_stats;
+
+	// map a finished readback and queue its pixels
+	void Resolve(READBACK& readback);
+	// encoder thread loop
+	void EncoderMain();
+	void Encode(ENCODE_JOB& job);
+	void WriteY4MFrame(ENCODE_JOB& job);
+};
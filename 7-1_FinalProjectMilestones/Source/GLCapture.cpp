@@ -0,0 +1,643 @@
+///////////////////////////////////////////////////////////////////////////////
+// glcapture.cpp
+// ============
+// record the OpenGL command stream of a few frames into a file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLCapture.h"
+#include "GLResources.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+// declaration of global variables
+namespace
+{
+	// texture units, vertex attributes and indexed buffer binding
+	// points whose state is read back - the scene uses fewer
+	const GLint g_MaxCapturedTextureUnits = 16;
+	const GLint g_MaxCapturedAttributes = 16;
+	const GLuint g_MaxCapturedBindings = 8;
+
+	// a buffer mapped during the capture
+	struct MAPPED_RANGE
+	{
+		GLintptr offset;
+		GLsizeiptr length;
+		GLbitfield access;
+		void* pMapped;
+	};
+
+	bool g_bCapturing = false;
+	std::string g_Filename;
+	uint32_t g_FramesLeft = 0;
+	GL_CAPTURE_HEADER g_Header = {};
+	std::vector<uint8_t> g_Stream;
+	std::unordered_map<GLenum, MAPPED_RANGE> g_MappedRanges;
+
+	/***********************************************************
+	 *  g_Append()
+	 *
+	 *  Add a record and its data to the stream.  The data is
+	 *  padded to eight bytes so the records stay aligned.
+	 ***********************************************************/
+	void g_Append(uint32_t call, std::initializer_list<uint64_t> args, const void* pData, size_t dataBytes)
+	{
+		GL_CAPTURE_RECORD record = {};
+		record.call = call;
+		record.dataBytes = (uint32_t)dataBytes;
+		size_t arg = 0;
+		for (uint64_t value : args)
+		{
+			if (arg < sizeof(record.args) / sizeof(record.args[0]))
+			{
+				record.args[arg++] = value;
+			}
+		}
+
+		size_t paddedBytes = (dataBytes + 7) & ~(size_t)7;
+		size_t offset = g_Stream.size();
+		g_Stream.resize(offset + sizeof(record) + paddedBytes, 0);
+		memcpy(&g_Stream[offset], &record, sizeof(record));
+		if (dataBytes > 0)
+		{
+			memcpy(&g_Stream[offset + sizeof(record)], pData, dataBytes);
+		}
+		g_Header.recordCount++;
+	}
+
+	// record whether a capability is enabled
+	void g_AppendCapability(GLenum capability)
+	{
+		g_Append(glIsEnabled(capability) ? GLCAPTURE_ENABLE : GLCAPTURE_DISABLE, { capability }, NULL, 0);
+	}
+
+	/***********************************************************
+	 *  g_CaptureFixedState()
+	 *
+	 *  Record the viewport, clear color, blending and depth
+	 *  state, which are set once at startup.
+	 ***********************************************************/
+	void g_CaptureFixedState()
+	{
+		GLint viewport[4] = { 0, 0, 0, 0 };
+		GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		GLint blendSource = GL_ONE;
+		GLint blendDestination = GL_ZERO;
+		GLboolean depthMask = GL_TRUE;
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+		glGetIntegerv(GL_BLEND_SRC_RGB, &blendSource);
+		glGetIntegerv(GL_BLEND_DST_RGB, &blendDestination);
+		glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+
+		g_Append(GLCAPTURE_VIEWPORT, { (uint64_t)viewport[0], (uint64_t)viewport[1], (uint64_t)viewport[2], (uint64_t)viewport[3] }, NULL, 0);
+		g_Append(GLCAPTURE_CLEAR_COLOR, {
+			GLCapture::FloatBits(clearColor[0]),
+			GLCapture::FloatBits(clearColor[1]),
+			GLCapture::FloatBits(clearColor[2]),
+			GLCapture::FloatBits(clearColor[3]) }, NULL, 0);
+		g_AppendCapability(GL_DEPTH_TEST);
+		g_AppendCapability(GL_BLEND);
+		g_AppendCapability(GL_CULL_FACE);
+		g_Append(GLCAPTURE_BLEND_FUNC, { (uint64_t)blendSource, (uint64_t)blendDestination }, NULL, 0);
+		g_Append(GLCAPTURE_DEPTH_MASK, { depthMask }, NULL, 0);
+	}
+
+	/***********************************************************
+	 *  g_CaptureBuffers()
+	 *
+	 *  Record the size, usage and contents of every live
+	 *  buffer, read back through the copy read binding.
+	 ***********************************************************/
+	void g_CaptureBuffers()
+	{
+		GLint previousBuffer = 0;
+		glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &previousBuffer);
+
+		std::vector<GLuint> buffers;
+		std::vector<uint8_t> contents;
+		GLResourceManager::GetLiveNames(GLResourceManager::GLRES_BUFFER, buffers);
+		for (GLuint buffer : buffers)
+		{
+			GLint size = 0;
+			GLint usage = GL_STATIC_DRAW;
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+			glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_USAGE, &usage);
+			contents.resize((size_t)size);
+			if (size > 0)
+			{
+				glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, contents.data());
+			}
+			g_Append(GLCAPTURE_RESOURCE_BUFFER, { buffer, (uint64_t)size, (uint64_t)usage }, contents.data(), contents.size());
+		}
+
+		glBindBuffer(GL_COPY_READ_BUFFER, previousBuffer);
+	}
+
+	/***********************************************************
+	 *  g_CaptureTextures()
+	 *
+	 *  Record the size, sampling and level zero pixels of every
+	 *  live texture, then the texture bound to every unit.
+	 ***********************************************************/
+	void g_CaptureTextures()
+	{
+		GLint activeTexture = GL_TEXTURE0;
+		GLint previousTexture = 0;
+		glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+
+		std::vector<GLuint> textures;
+		std::vector<uint8_t> pixels;
+		GLResourceManager::GetLiveNames(GLResourceManager::GLRES_TEXTURE, textures);
+		for (GLuint texture : textures)
+		{
+			GLint width = 0;
+			GLint height = 0;
+			GLint minFilter = GL_LINEAR;
+			GLint magFilter = GL_LINEAR;
+			GLint wrapS = GL_REPEAT;
+			GLint wrapT = GL_REPEAT;
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+			glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &minFilter);
+			glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, &magFilter);
+			glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &wrapS);
+			glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, &wrapT);
+			pixels.resize((size_t)width * height * 4);
+			if (!pixels.empty())
+			{
+				glPixelStorei(GL_PACK_ALIGNMENT, 1);
+				glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			}
+			g_Append(GLCAPTURE_RESOURCE_TEXTURE, {
+				texture, (uint64_t)width, (uint64_t)height,
+				(uint64_t)minFilter, (uint64_t)magFilter,
+				((uint64_t)wrapS << 32) | (uint32_t)wrapT }, pixels.data(), pixels.size());
+		}
+		glBindTexture(GL_TEXTURE_2D, previousTexture);
+
+		GLint unitCount = 0;
+		glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &unitCount);
+		unitCount = std::min(unitCount, g_MaxCapturedTextureUnits);
+		for (GLint unit = 0; unit < unitCount; unit++)
+		{
+			GLint texture = 0;
+			glActiveTexture(GL_TEXTURE0 + unit);
+			glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+			if (texture != 0)
+			{
+				g_Append(GLInterceptor::GLCALL_ACTIVE_TEXTURE, { (uint64_t)(GL_TEXTURE0 + unit) }, NULL, 0);
+				g_Append(GLCAPTURE_BIND_TEXTURE, { GL_TEXTURE_2D, (uint64_t)texture }, NULL, 0);
+			}
+		}
+		glActiveTexture(activeTexture);
+		g_Append(GLInterceptor::GLCALL_ACTIVE_TEXTURE, { (uint64_t)activeTexture }, NULL, 0);
+	}
+
+	/***********************************************************
+	 *  g_CaptureUniforms()
+	 *
+	 *  Record the value of every default block uniform of a
+	 *  program, one record per array element, with its name
+	 *  after the values.  Uniforms of types the scene shaders
+	 *  do not use are left out.
+	 ***********************************************************/
+	void g_CaptureUniforms(GLuint program)
+	{
+		GLint uniformCount = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+		for (GLint index = 0; index < uniformCount; index++)
+		{
+			GLchar name[256];
+			GLsizei nameLength = 0;
+			GLint arraySize = 0;
+			GLenum type = 0;
+			glGetActiveUniform(program, index, sizeof(name), &nameLength, &arraySize, &type, name);
+
+			int components = 0;
+			bool bInteger = false;
+			switch (type)
+			{
+			case GL_FLOAT: components = 1; break;
+			case GL_FLOAT_VEC2: components = 2; break;
+			case GL_FLOAT_VEC3: components = 3; break;
+			case GL_FLOAT_VEC4: components = 4; break;
+			case GL_FLOAT_MAT4: components = 16; break;
+			case GL_INT:
+			case GL_BOOL:
+			case GL_SAMPLER_2D:
+				components = 1;
+				bInteger = true;
+				break;
+			default:
+				break;
+			}
+			if (components == 0)
+			{
+				continue;
+			}
+
+			// arrays are reported by their first element
+			std::string baseName(name, nameLength);
+			size_t bracket = baseName.find('[');
+			if (bracket != std::string::npos)
+			{
+				baseName.erase(bracket);
+			}
+
+			for (GLint element = 0; element < arraySize; element++)
+			{
+				std::string elementName = (arraySize > 1) ? baseName + "[" + std::to_string(element) + "]" : baseName;
+				GLint location = glGetUniformLocation(program, elementName.c_str());
+				if (location < 0)
+				{
+					// a member of a uniform block
+					continue;
+				}
+
+				uint32_t values[16];
+				if (bInteger)
+				{
+					glGetUniformiv(program, location, (GLint*)values);
+				}
+				else
+				{
+					glGetUniformfv(program, location, (GLfloat*)values);
+				}
+
+				std::vector<uint8_t> data(components * sizeof(uint32_t) + elementName.size() + 1);
+				memcpy(data.data(), values, components * sizeof(uint32_t));
+				memcpy(&data[components * sizeof(uint32_t)], elementName.c_str(), elementName.size() + 1);
+				g_Append(GLCAPTURE_RESOURCE_UNIFORM, { program, (uint64_t)location, type, (uint64_t)components }, data.data(), data.size());
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  g_CapturePrograms()
+	 *
+	 *  Record the vertex and fragment shader sources of every
+	 *  live program, then its uniform values.  The shaders are
+	 *  still attached after linking, so their sources can be
+	 *  read back even when the shader manager deleted them.
+	 ***********************************************************/
+	void g_CapturePrograms()
+	{
+		std::vector<GLuint> programs;
+		GLResourceManager::GetLiveNames(GLResourceManager::GLRES_PROGRAM, programs);
+		for (GLuint program : programs)
+		{
+			GLuint shaders[4] = { 0, 0, 0, 0 };
+			GLsizei shaderCount = 0;
+			glGetAttachedShaders(program, 4, &shaderCount, shaders);
+
+			std::string vertexSource;
+			std::string fragmentSource;
+			for (GLsizei i = 0; i < shaderCount; i++)
+			{
+				GLint type = 0;
+				GLint sourceLength = 0;
+				glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type);
+				glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &sourceLength);
+
+				std::string source((size_t)std::max(sourceLength, 1), '\0');
+				GLsizei length = 0;
+				glGetShaderSource(shaders[i], (GLsizei)source.size(), &length, &source[0]);
+				source.resize(length);
+				if (type == GL_VERTEX_SHADER)
+				{
+					vertexSource = source;
+				}
+				else if (type == GL_FRAGMENT_SHADER)
+				{
+					fragmentSource = source;
+				}
+			}
+			if (vertexSource.empty() || fragmentSource.empty())
+			{
+				std::cout << "WARNING: the shader sources of program " << program << " could not be captured" << std::endl;
+			}
+
+			std::string sources = vertexSource + fragmentSource;
+			g_Append(GLCAPTURE_RESOURCE_PROGRAM, { program, vertexSource.size(), fragmentSource.size() }, sources.data(), sources.size());
+			g_CaptureUniforms(program);
+		}
+	}
+
+	/***********************************************************
+	 *  g_CaptureVertexArrays()
+	 *
+	 *  Record the element buffer and attribute layout of every
+	 *  live vertex array, as the calls that set them up.
+	 ***********************************************************/
+	void g_CaptureVertexArrays()
+	{
+		GLint previousVertexArray = 0;
+		GLint previousArrayBuffer = 0;
+		GLint attributeCount = 0;
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVertexArray);
+		glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previousArrayBuffer);
+		glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &attributeCount);
+		attributeCount = std::min(attributeCount, g_MaxCapturedAttributes);
+
+		std::vector<GLuint> vertexArrays;
+		GLResourceManager::GetLiveNames(GLResourceManager::GLRES_VERTEX_ARRAY, vertexArrays);
+		for (GLuint vertexArray : vertexArrays)
+		{
+			GLint elementBuffer = 0;
+			glBindVertexArray(vertexArray);
+			glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+			g_Append(GLCAPTURE_RESOURCE_VERTEX_ARRAY, { vertexArray, (uint64_t)elementBuffer }, NULL, 0);
+
+			for (GLint index = 0; index < attributeCount; index++)
+			{
+				GLint bEnabled = 0;
+				GLint buffer = 0;
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &bEnabled);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &buffer);
+				if (!bEnabled && (buffer == 0))
+				{
+					continue;
+				}
+
+				GLint size = 4;
+				GLint type = GL_FLOAT;
+				GLint bNormalized = GL_FALSE;
+				GLint stride = 0;
+				GLint divisor = 0;
+				void* pOffset = NULL;
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_SIZE, &size);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_TYPE, &type);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &bNormalized);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &stride);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &divisor);
+				glGetVertexAttribPointerv(index, GL_VERTEX_ATTRIB_ARRAY_POINTER, &pOffset);
+
+				g_Append(GLInterceptor::GLCALL_BIND_BUFFER, { GL_ARRAY_BUFFER, (uint64_t)buffer }, NULL, 0);
+				g_Append(GLInterceptor::GLCALL_VERTEX_ATTRIB_POINTER, {
+					(uint64_t)index, (uint64_t)size, (uint64_t)type,
+					(uint64_t)bNormalized, (uint64_t)stride, (uint64_t)(uintptr_t)pOffset }, NULL, 0);
+				g_Append(GLInterceptor::GLCALL_VERTEX_ATTRIB_DIVISOR, { (uint64_t)index, (uint64_t)divisor }, NULL, 0);
+				if (bEnabled)
+				{
+					g_Append(GLInterceptor::GLCALL_ENABLE_VERTEX_ATTRIB_ARRAY, { (uint64_t)index }, NULL, 0);
+				}
+			}
+		}
+
+		glBindVertexArray(previousVertexArray);
+		glBindBuffer(GL_ARRAY_BUFFER, previousArrayBuffer);
+		g_Append(GLInterceptor::GLCALL_BIND_VERTEX_ARRAY, { (uint64_t)previousVertexArray }, NULL, 0);
+	}
+
+	/***********************************************************
+	 *  g_CaptureBindings()
+	 *
+	 *  Record the current program and the buffers bound to the
+	 *  indexed and generic binding points.  The indexed ones
+	 *  come first, since binding them also changes the generic
+	 *  binding of their target.
+	 ***********************************************************/
+	void g_CaptureBindings()
+	{
+		const GLenum indexedTargets[2][2] =
+		{
+			{ GL_UNIFORM_BUFFER, GL_UNIFORM_BUFFER_BINDING },
+			{ GL_SHADER_STORAGE_BUFFER, GL_SHADER_STORAGE_BUFFER_BINDING }
+		};
+		const GLenum indexedRanges[2][2] =
+		{
+			{ GL_UNIFORM_BUFFER_START, GL_UNIFORM_BUFFER_SIZE },
+			{ GL_SHADER_STORAGE_BUFFER_START, GL_SHADER_STORAGE_BUFFER_SIZE }
+		};
+		for (int target = 0; target < 2; target++)
+		{
+			for (GLuint index = 0; index < g_MaxCapturedBindings; index++)
+			{
+				GLint buffer = 0;
+				GLint64 start = 0;
+				GLint64 size = 0;
+				glGetIntegeri_v(indexedTargets[target][1], index, &buffer);
+				glGetInteger64i_v(indexedRanges[target][0], index, &start);
+				glGetInteger64i_v(indexedRanges[target][1], index, &size);
+				if (buffer == 0)
+				{
+					continue;
+				}
+				if (size > 0)
+				{
+					g_Append(GLInterceptor::GLCALL_BIND_BUFFER_RANGE, {
+						indexedTargets[target][0], index, (uint64_t)buffer, (uint64_t)start, (uint64_t)size }, NULL, 0);
+				}
+				else
+				{
+					g_Append(GLInterceptor::GLCALL_BIND_BUFFER_BASE, { indexedTargets[target][0], index, (uint64_t)buffer }, NULL, 0);
+				}
+			}
+		}
+
+		const GLenum genericTargets[5][2] =
+		{
+			{ GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING },
+			{ GL_COPY_READ_BUFFER, GL_COPY_READ_BUFFER_BINDING },
+			{ GL_COPY_WRITE_BUFFER, GL_COPY_WRITE_BUFFER_BINDING },
+			{ GL_UNIFORM_BUFFER, GL_UNIFORM_BUFFER_BINDING },
+			{ GL_SHADER_STORAGE_BUFFER, GL_SHADER_STORAGE_BUFFER_BINDING }
+		};
+		for (int target = 0; target < 5; target++)
+		{
+			GLint buffer = 0;
+			glGetIntegerv(genericTargets[target][1], &buffer);
+			g_Append(GLInterceptor::GLCALL_BIND_BUFFER, { genericTargets[target][0], (uint64_t)buffer }, NULL, 0);
+		}
+
+		GLint program = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+		g_Append(GLInterceptor::GLCALL_USE_PROGRAM, { (uint64_t)program }, NULL, 0);
+	}
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for reading back the current state
+ *  into the start of a capture and recording the calls of
+ *  the next frames.  The interceptor is installed if it is
+ *  not already, since the calls are recorded by its wrappers.
+ ***********************************************************/
+bool GLCapture::Begin(const char* filename, uint32_t frameCount, int width, int height)
+{
+	if (g_bCapturing || (frameCount == 0))
+	{
+		return(false);
+	}
+	if (!GLInterceptor::IsInstalled() && !GLInterceptor::Install(NULL))
+	{
+		return(false);
+	}
+
+	g_Filename = filename;
+	g_FramesLeft = frameCount;
+	g_Stream.clear();
+	g_MappedRanges.clear();
+	memcpy(g_Header.magic, "GLCP", 4);
+	g_Header.version = GLCAPTURE_VERSION;
+	g_Header.frameCount = frameCount;
+	g_Header.recordCount = 0;
+	g_Header.width = width;
+	g_Header.height = height;
+
+	// the buffers come first, since the vertex arrays and
+	// bindings refer to them
+	g_CaptureFixedState();
+	g_CaptureBuffers();
+	g_CaptureTextures();
+	g_CapturePrograms();
+	g_CaptureVertexArrays();
+	g_CaptureBindings();
+	g_Append(GLCAPTURE_END_RESOURCES, {}, NULL, 0);
+
+	std::cout << "INFO: capturing " << frameCount << " frames into " << filename
+		<< " - " << g_Header.recordCount << " resource records, "
+		<< g_Stream.size() / 1024 << "KB" << std::endl;
+
+	g_bCapturing = true;
+	return(true);
+}
+
+/***********************************************************
+ *  IsCapturing()
+ *
+ *  This method is used for checking whether calls are being
+ *  recorded.
+ ***********************************************************/
+bool GLCapture::IsCapturing()
+{
+	return(g_bCapturing);
+}
+
+/***********************************************************
+ *  Record()
+ *
+ *  This method is used for adding one call to the capture.
+ ***********************************************************/
+void GLCapture::Record(uint32_t call, std::initializer_list<uint64_t> args, const void* pData, size_t dataBytes)
+{
+	if (!g_bCapturing)
+	{
+		return;
+	}
+	g_Append(call, args, pData, dataBytes);
+}
+
+/***********************************************************
+ *  RecordMap()
+ *
+ *  This method is used for remembering a buffer range that
+ *  was mapped.  Nothing is recorded until it is unmapped,
+ *  since only then are the written contents known.
+ ***********************************************************/
+void GLCapture::RecordMap(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access, void* pMapped)
+{
+	// a persistent mapping is never unmapped, so its owner
+	// records what it writes itself
+	if (!g_bCapturing || (NULL == pMapped) || (access & GL_MAP_PERSISTENT_BIT))
+	{
+		return;
+	}
+	MAPPED_RANGE range = { offset, length, access, pMapped };
+	g_MappedRanges[target] = range;
+}
+
+/***********************************************************
+ *  RecordUnmap()
+ *
+ *  This method is used for recording what was written into
+ *  a mapped buffer range, as one write the replay maps the
+ *  range for again.
+ ***********************************************************/
+void GLCapture::RecordUnmap(GLenum target)
+{
+	auto mapped = g_MappedRanges.find(target);
+	if (mapped == g_MappedRanges.end())
+	{
+		return;
+	}
+
+	const MAPPED_RANGE& range = mapped->second;
+	if (g_bCapturing && (range.access & GL_MAP_WRITE_BIT))
+	{
+		g_Append(GLCAPTURE_MAPPED_WRITE, {
+			target, (uint64_t)range.offset, (uint64_t)range.length, range.access },
+			range.pMapped, (size_t)range.length);
+	}
+	g_MappedRanges.erase(mapped);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for ending a captured frame.  After
+ *  the last frame, the capture is written into its file and
+ *  recording stops.
+ ***********************************************************/
+void GLCapture::EndFrame()
+{
+	if (!g_bCapturing)
+	{
+		return;
+	}
+
+	g_Append(GLCAPTURE_END_FRAME, {}, NULL, 0);
+	if (--g_FramesLeft > 0)
+	{
+		return;
+	}
+	g_bCapturing = false;
+
+	std::ofstream file(g_Filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "WARNING: could not write OpenGL capture " << g_Filename << std::endl;
+		return;
+	}
+	file.write((const char*)&g_Header, sizeof(g_Header));
+	file.write((const char*)g_Stream.data(), g_Stream.size());
+
+	std::cout << "INFO: wrote OpenGL capture " << g_Filename
+		<< " - " << g_Header.frameCount << " frames, "
+		<< g_Header.recordCount << " records, "
+		<< (sizeof(g_Header) + g_Stream.size()) / 1024 << "KB" << std::endl;
+
+	g_Stream.clear();
+	g_Stream.shrink_to_fit();
+}
+
+/***********************************************************
+ *  FloatBits() / BitsFloat()
+ *
+ *  These methods are used for storing a float argument in
+ *  a record and reading it back.
+ ***********************************************************/
+uint64_t GLCapture::FloatBits(float value)
+{
+	uint32_t bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+	return(bits);
+}
+
+float GLCapture::BitsFloat(uint64_t bits)
+{
+	uint32_t low = (uint32_t)bits;
+	float value = 0.0f;
+	memcpy(&value, &low, sizeof(value));
+	return(value);
+}
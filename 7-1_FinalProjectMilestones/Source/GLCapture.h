@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+// glcapture.h
+// ============
+// record the OpenGL command stream of a few frames into a file
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLInterceptor.h"
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  GL_CAPTURE_CALL
+ *
+ *  Records in a capture that are not one of the entry points
+ *  the interceptor wraps.  The OpenGL 1.1 calls made every
+ *  frame are recorded at their call sites, and the basic
+ *  mesh draws are recorded by mesh, since the shape meshes
+ *  issue them through the system library.  The resource
+ *  records at the start of a capture recreate the objects
+ *  that existed when the capture began.
+ ***********************************************************/
+enum GL_CAPTURE_CALL
+{
+	GLCAPTURE_ENABLE = GLInterceptor::GLCALL_COUNT,
+	GLCAPTURE_DISABLE,
+	GLCAPTURE_BLEND_FUNC,
+	GLCAPTURE_DEPTH_MASK,
+	GLCAPTURE_CLEAR_COLOR,
+	GLCAPTURE_CLEAR,
+	GLCAPTURE_VIEWPORT,
+	GLCAPTURE_BIND_TEXTURE,
+	GLCAPTURE_DRAW_MESH,
+	// a buffer written through a mapping - the contents are
+	// recorded when the buffer is unmapped
+	GLCAPTURE_MAPPED_WRITE,
+	GLCAPTURE_RESOURCE_BUFFER,
+	GLCAPTURE_RESOURCE_TEXTURE,
+	GLCAPTURE_RESOURCE_VERTEX_ARRAY,
+	GLCAPTURE_RESOURCE_PROGRAM,
+	GLCAPTURE_RESOURCE_UNIFORM,
+	// the resource records end and the captured frames begin
+	GLCAPTURE_END_RESOURCES,
+	GLCAPTURE_END_FRAME
+};
+
+// version written into the header - raised whenever a record is
+// added, since every record after it is numbered differently
+const uint32_t GLCAPTURE_VERSION = 2;
+
+/***********************************************************
+ *  GL_CAPTURE_HEADER / GL_CAPTURE_RECORD
+ *
+ *  A capture file is the header followed by the records.
+ *  Every record holds the arguments of one call, with any
+ *  memory the call reads, such as uploaded data or a
+ *  uniform name, following it.  Floats are stored by their
+ *  bits.
+ ***********************************************************/
+struct GL_CAPTURE_HEADER
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t frameCount;
+	uint32_t recordCount;
+	int32_t width;
+	int32_t height;
+};
+
+struct GL_CAPTURE_RECORD
+{
+	uint32_t call;
+	uint32_t dataBytes;
+	uint64_t args[6];
+};
+
+/***********************************************************
+ *  GLCapture
+ *
+ *  This class records every call the interceptor sees, and
+ *  the frame calls recorded at their call sites, for a
+ *  number of frames.  When the capture begins, the contents
+ *  of every live buffer and texture, the attributes of
+ *  every vertex array, the shader sources and uniform
+ *  values of every program and the current bindings are
+ *  read back and written first, so the capture replays on
+ *  a fresh context with nothing else loaded.
+ ***********************************************************/
+class GLCapture
+{
+public:
+	// read back the current state and record the next frames -
+	// the file is written once the last frame ends
+	static bool Begin(const char* filename, uint32_t frameCount, int width, int height);
+	static bool IsCapturing();
+
+	// record one call - ignored while not capturing
+	static void Record(
+		uint32_t call,
+		std::initializer_list<uint64_t> args,
+		const void* pData = NULL,
+		size_t dataBytes = 0);
+	// remember a mapping, and record what was written into it
+	static void RecordMap(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access, void* pMapped);
+	static void RecordUnmap(GLenum target);
+	// end the frame, writing the file after the last one
+	static void EndFrame();
+
+	// store a float argument by its bits
+	static uint64_t FloatBits(float value);
+	static float BitsFloat(uint64_t bits);
+};
@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+// gldebug.cpp
+// ============
+// OpenGL debug output, object labels and debug groups
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLDebug.h"
+
+#if defined(GL_DEBUG_OUTPUT_ENABLED)
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// declaration of global variables
+namespace
+{
+	// times the same message is printed before it is only counted,
+	// so a mistake made every frame does not flood the console
+	const uint32_t g_MaxRepeatedMessages = 5;
+
+	bool g_bAvailable = false;
+	std::atomic<uint32_t> g_MessageCount(0);
+	std::atomic<uint32_t> g_ErrorCount(0);
+	std::mutex g_MessageMutex;
+	std::unordered_map<GLuint, uint32_t> g_MessageRepeats;
+}
+
+/***********************************************************
+ *  SourceName()
+ *
+ *  Get the printable name of the source of a message.
+ ***********************************************************/
+static const char* SourceName(GLenum source)
+{
+	switch (source)
+	{
+	case GL_DEBUG_SOURCE_API: return("API");
+	case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return("window system");
+	case GL_DEBUG_SOURCE_SHADER_COMPILER: return("shader compiler");
+	case GL_DEBUG_SOURCE_THIRD_PARTY: return("third party");
+	case GL_DEBUG_SOURCE_APPLICATION: return("application");
+	default: return("other");
+	}
+}
+
+/***********************************************************
+ *  TypeName()
+ *
+ *  Get the printable name of the type of a message.
+ ***********************************************************/
+static const char* TypeName(GLenum type)
+{
+	switch (type)
+	{
+	case GL_DEBUG_TYPE_ERROR: return("error");
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return("deprecated behavior");
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return("undefined behavior");
+	case GL_DEBUG_TYPE_PORTABILITY: return("portability");
+	case GL_DEBUG_TYPE_PERFORMANCE: return("performance");
+	default: return("other");
+	}
+}
+
+/***********************************************************
+ *  DebugCallback()
+ *
+ *  Print a message raised by the driver.  The output is
+ *  synchronous, so a breakpoint here stops on the call
+ *  that raised it.
+ ***********************************************************/
+static void GLAPIENTRY DebugCallback(
+	GLenum source,
+	GLenum type,
+	GLuint id,
+	GLenum severity,
+	GLsizei length,
+	const GLchar* message,
+	const void* /*pUserParam*/)
+{
+	g_MessageCount++;
+	if (type == GL_DEBUG_TYPE_ERROR)
+	{
+		g_ErrorCount++;
+	}
+
+	std::lock_guard<std::mutex> lock(g_MessageMutex);
+	uint32_t repeats = ++g_MessageRepeats[id];
+	if (repeats > g_MaxRepeatedMessages)
+	{
+		return;
+	}
+
+	const char* prefix = ((severity == GL_DEBUG_SEVERITY_HIGH) || (type == GL_DEBUG_TYPE_ERROR)) ? "WARNING" : "INFO";
+	std::cout << prefix << ": OpenGL " << TypeName(type)
+		<< " from " << SourceName(source)
+		<< " (" << id << "): " << std::string(message, (length > 0) ? length : strlen(message))
+		<< std::endl;
+	if (repeats == g_MaxRepeatedMessages)
+	{
+		std::cout << "INFO: further OpenGL messages " << id << " are only counted" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ObjectIdentifier()
+ *
+ *  Get the identifier glObjectLabel takes for a type of
+ *  tracked object.
+ ***********************************************************/
+static GLenum ObjectIdentifier(GLResourceManager::GL_RESOURCE_TYPE type)
+{
+	switch (type)
+	{
+	case GLResourceManager::GLRES_TEXTURE: return(GL_TEXTURE);
+	case GLResourceManager::GLRES_BUFFER: return(GL_BUFFER);
+	case GLResourceManager::GLRES_VERTEX_ARRAY: return(GL_VERTEX_ARRAY);
+	case GLResourceManager::GLRES_PROGRAM: return(GL_PROGRAM);
+	case GLResourceManager::GLRES_FRAMEBUFFER: return(GL_FRAMEBUFFER);
+	case GLResourceManager::GLRES_RENDERBUFFER: return(GL_RENDERBUFFER);
+	default: return(GL_NONE);
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for installing the message callback.
+ *  The notifications every driver raises for normal buffer
+ *  and texture use are filtered out.
+ ***********************************************************/
+bool GLDebug::Initialize()
+{
+	if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug)
+	{
+		std::cout << "INFO: OpenGL debug output is not supported by this context" << std::endl;
+		return(false);
+	}
+
+	glEnable(GL_DEBUG_OUTPUT);
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(DebugCallback, NULL);
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
+	// the push and pop group messages would echo every group
+	glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, NULL, GL_FALSE);
+	glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, NULL, GL_FALSE);
+
+	g_bAvailable = true;
+	std::cout << "INFO: OpenGL debug output enabled" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for reporting the number of messages
+ *  raised over the run and removing the callback.
+ ***********************************************************/
+void GLDebug::Shutdown()
+{
+	if (!g_bAvailable)
+	{
+		return;
+	}
+
+	std::cout << "INFO: " << g_MessageCount.load() << " OpenGL debug messages, "
+		<< g_ErrorCount.load() << " of them errors" << std::endl;
+	glDebugMessageCallback(NULL, NULL);
+	glDisable(GL_DEBUG_OUTPUT);
+	g_bAvailable = false;
+}
+
+/***********************************************************
+ *  LabelObject()
+ *
+ *  This method is used for naming an object in the debug
+ *  messages and frame debuggers.
+ ***********************************************************/
+void GLDebug::LabelObject(GLResourceManager::GL_RESOURCE_TYPE type, GLuint name, const char* label)
+{
+	if (!g_bAvailable || (name == 0) || (NULL == label))
+	{
+		return;
+	}
+	glObjectLabel(ObjectIdentifier(type), name, -1, label);
+}
+
+/***********************************************************
+ *  PushGroup() / PopGroup()
+ *
+ *  These methods are used for opening and closing a named
+ *  group of calls.  Every push needs a matching pop.
+ ***********************************************************/
+void GLDebug::PushGroup(const char* name)
+{
+	if (!g_bAvailable)
+	{
+		return;
+	}
+	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+}
+
+void GLDebug::PopGroup()
+{
+	if (!g_bAvailable)
+	{
+		return;
+	}
+	glPopDebugGroup();
+}
+
+/***********************************************************
+ *  GetMessageCount() / GetErrorCount()
+ *
+ *  These methods are used for getting the number of messages
+ *  and errors raised so far.
+ ***********************************************************/
+uint32_t GLDebug::GetMessageCount()
+{
+	return(g_MessageCount.load());
+}
+
+uint32_t GLDebug::GetErrorCount()
+{
+	return(g_ErrorCount.load());
+}
+
+#endif
@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+// gldebug.h
+// ============
+// OpenGL debug output, object labels and debug groups
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLResources.h"
+
+#include <GL/glew.h>
+
+// the debug output is built into debug builds, and into release
+// builds that define GL_DEBUG_INSTRUMENTED - otherwise every
+// macro below expands to nothing and no debug call is compiled
+#if !defined(NDEBUG) || defined(GL_DEBUG_INSTRUMENTED)
+#define GL_DEBUG_OUTPUT_ENABLED
+#endif
+
+#if defined(GL_DEBUG_OUTPUT_ENABLED)
+
+/***********************************************************
+ *  GLDebug
+ *
+ *  This class installs a KHR_debug message callback, which
+ *  reports every error and warning the driver raises at the
+ *  call that caused it, so no glGetError checks are needed.
+ *  The objects are labelled and the passes of a frame are
+ *  grouped, so the messages and frame debuggers such as
+ *  RenderDoc show names instead of numbers.
+ ***********************************************************/
+class GLDebug
+{
+public:
+	// install the message callback - the context needs to
+	// support OpenGL 4.3 or KHR_debug
+	static bool Initialize();
+	// report how many messages were raised
+	static void Shutdown();
+
+	// name an object in the messages and frame debuggers - the
+	// object has to exist, so buffers, textures and vertex
+	// arrays have to have been bound once
+	static void LabelObject(GLResourceManager::GL_RESOURCE_TYPE type, GLuint name, const char* label);
+	// open and close a named group of calls
+	static void PushGroup(const char* name);
+	static void PopGroup();
+
+	static uint32_t GetMessageCount();
+	static uint32_t GetErrorCount();
+};
+
+#define GL_DEBUG_INITIALIZE() GLDebug::Initialize()
+#define GL_DEBUG_SHUTDOWN() GLDebug::Shutdown()
+#define GL_DEBUG_LABEL(type, name, label) GLDebug::LabelObject(type, name, label)
+#define GL_DEBUG_PUSH_GROUP(name) GLDebug::PushGroup(name)
+#define GL_DEBUG_POP_GROUP() GLDebug::PopGroup()
+
+#else
+
+#define GL_DEBUG_INITIALIZE() ((void)0)
+#define GL_DEBUG_SHUTDOWN() ((void)0)
+#define GL_DEBUG_LABEL(type, name, label) ((void)0)
+#define GL_DEBUG_PUSH_GROUP(name) ((void)0)
+#define GL_DEBUG_POP_GROUP() ((void)0)
+
+#endif
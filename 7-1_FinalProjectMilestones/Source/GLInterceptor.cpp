@@ -0,0 +1,855 @@
+///////////////////////////////////////////////////////////////////////////////
+// glinterceptor.cpp
+// ============
+// count the OpenGL calls of every frame and flag the redundant ones
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLInterceptor.h"
+#include "GLCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+// declaration of global variables
+namespace
+{
+	// the driver entry points the wrappers pass the calls on to
+	struct GL_DRIVER_TABLE
+	{
+		PFNGLACTIVETEXTUREPROC ActiveTexture;
+		PFNGLBINDBUFFERPROC BindBuffer;
+		PFNGLBINDBUFFERBASEPROC BindBufferBase;
+		PFNGLBINDBUFFERRANGEPROC BindBufferRange;
+		PFNGLBINDVERTEXARRAYPROC BindVertexArray;
+		PFNGLUSEPROGRAMPROC UseProgram;
+		PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+		PFNGLUNIFORM1IPROC Uniform1i;
+		PFNGLUNIFORM1FPROC Uniform1f;
+		PFNGLUNIFORM2FPROC Uniform2f;
+		PFNGLUNIFORM2FVPROC Uniform2fv;
+		PFNGLUNIFORM3FPROC Uniform3f;
+		PFNGLUNIFORM3FVPROC Uniform3fv;
+		PFNGLUNIFORM4FPROC Uniform4f;
+		PFNGLUNIFORM4FVPROC Uniform4fv;
+		PFNGLUNIFORMMATRIX4FVPROC UniformMatrix4fv;
+		PFNGLBUFFERDATAPROC BufferData;
+		PFNGLBUFFERSTORAGEPROC BufferStorage;
+		PFNGLBUFFERSUBDATAPROC BufferSubData;
+		PFNGLCOPYBUFFERSUBDATAPROC CopyBufferSubData;
+		PFNGLMAPBUFFERRANGEPROC MapBufferRange;
+		PFNGLUNMAPBUFFERPROC UnmapBuffer;
+		PFNGLGENBUFFERSPROC GenBuffers;
+		PFNGLDELETEBUFFERSPROC DeleteBuffers;
+		PFNGLGENVERTEXARRAYSPROC GenVertexArrays;
+		PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays;
+		PFNGLVERTEXATTRIBPOINTERPROC VertexAttribPointer;
+		PFNGLENABLEVERTEXATTRIBARRAYPROC EnableVertexAttribArray;
+		PFNGLVERTEXATTRIBDIVISORPROC VertexAttribDivisor;
+		PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced;
+		PFNGLDRAWELEMENTSINSTANCEDPROC DrawElementsInstanced;
+		PFNGLGENERATEMIPMAPPROC GenerateMipmap;
+		PFNGLFENCESYNCPROC FenceSync;
+		PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+		PFNGLDELETESYNCPROC DeleteSync;
+		PFNGLDELETEPROGRAMPROC DeleteProgram;
+	};
+
+	const char* g_CallNames[GLInterceptor::GLCALL_COUNT] =
+	{
+		"glActiveTexture",
+		"glBindBuffer",
+		"glBindBufferBase",
+		"glBindBufferRange",
+		"glBindVertexArray",
+		"glUseProgram",
+		"glGetUniformLocation",
+		"glUniform1i",
+		"glUniform1f",
+		"glUniform2f",
+		"glUniform2fv",
+		"glUniform3f",
+		"glUniform3fv",
+		"glUniform4f",
+		"glUniform4fv",
+		"glUniformMatrix4fv",
+		"glBufferData",
+		"glBufferStorage",
+		"glBufferSubData",
+		"glCopyBufferSubData",
+		"glMapBufferRange",
+		"glUnmapBuffer",
+		"glGenBuffers",
+		"glDeleteBuffers",
+		"glGenVertexArrays",
+		"glDeleteVertexArrays",
+		"glVertexAttribPointer",
+		"glEnableVertexAttribArray",
+		"glVertexAttribDivisor",
+		"glDrawArraysInstanced",
+		"glDrawElementsInstanced",
+		"glGenerateMipmap",
+		"glFenceSync",
+		"glClientWaitSync",
+		"glDeleteSync",
+		"glDeleteProgram"
+	};
+
+	// buffer range bound to one indexed binding point
+	struct INDEXED_BINDING
+	{
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+
+	// last value set into one uniform - larger arrays are not
+	// shadowed, so their sets are never flagged
+	struct UNIFORM_VALUE
+	{
+		uint32_t byteSize;
+		uint32_t words[16];
+	};
+
+	// state is unknown until the first call sets it
+	const int64_t g_UnknownState = -1;
+
+	GL_DRIVER_TABLE g_Driver = {};
+	bool g_bInstalled = false;
+	std::ofstream g_Report;
+	uint64_t g_ReportFrame = 0;
+
+	// calls of the current frame, and of every frame together
+	GLInterceptor::GL_CALL_STATS g_FrameStats[GLInterceptor::GLCALL_COUNT];
+	GLInterceptor::GL_CALL_STATS g_TotalStats[GLInterceptor::GLCALL_COUNT];
+
+	// shadow of the bindings and uniforms the wrappers have seen -
+	// the calls only come from the thread owning the context
+	std::unordered_map<GLenum, GLuint> g_BoundBuffers;
+	std::unordered_map<uint64_t, INDEXED_BINDING> g_IndexedBuffers;
+	std::unordered_map<uint64_t, UNIFORM_VALUE> g_UniformValues;
+	int64_t g_BoundVertexArray = g_UnknownState;
+	int64_t g_CurrentProgram = g_UnknownState;
+	int64_t g_ActiveTexture = g_UnknownState;
+
+	/***********************************************************
+	 *  CALL_SCOPE
+	 *
+	 *  Counts one call and times the driver while in scope.
+	 ***********************************************************/
+	struct CALL_SCOPE
+	{
+		GLInterceptor::GL_CALL call;
+		std::chrono::steady_clock::time_point start;
+
+		CALL_SCOPE(GLInterceptor::GL_CALL callType)
+		{
+			call = callType;
+			start = std::chrono::steady_clock::now();
+		}
+		~CALL_SCOPE()
+		{
+			g_FrameStats[call].calls++;
+			g_FrameStats[call].nanoseconds += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now() - start).count();
+		}
+	};
+
+	void g_CountRedundant(GLInterceptor::GL_CALL call)
+	{
+		g_FrameStats[call].redundant++;
+	}
+
+	uint64_t g_IndexedKey(GLenum target, GLuint index)
+	{
+		return(((uint64_t)target << 32) | index);
+	}
+
+	/***********************************************************
+	 *  g_IsSameUniform()
+	 *
+	 *  Whether setting a uniform of the current program to the
+	 *  passed in value would change nothing, recording the
+	 *  value when it would.  A location of -1 is ignored by
+	 *  OpenGL, so setting it is always redundant.
+	 ***********************************************************/
+	bool g_IsSameUniform(GLint location, const void* pData, size_t byteSize)
+	{
+		if (location < 0)
+		{
+			return(true);
+		}
+		if (g_CurrentProgram == g_UnknownState)
+		{
+			return(false);
+		}
+
+		UNIFORM_VALUE& value = g_UniformValues[((uint64_t)g_CurrentProgram << 32) | (uint32_t)location];
+		if (byteSize > sizeof(value.words))
+		{
+			value.byteSize = 0;
+			return(false);
+		}
+
+		bool bSame = (value.byteSize == byteSize) && (memcmp(value.words, pData, byteSize) == 0);
+		value.byteSize = (uint32_t)byteSize;
+		memcpy(value.words, pData, byteSize);
+		return(bSame);
+	}
+
+	// whether an indexed binding point already has the range bound
+	bool g_IsSameBinding(uint64_t key, const INDEXED_BINDING& bound)
+	{
+		auto binding = g_IndexedBuffers.find(key);
+		return((binding != g_IndexedBuffers.end()) &&
+			(binding->second.buffer == bound.buffer) &&
+			(binding->second.offset == bound.offset) &&
+			(binding->second.size == bound.size));
+	}
+
+	// forget the bindings of deleted buffers
+	void g_ForgetBuffer(GLuint buffer)
+	{
+		for (auto binding = g_BoundBuffers.begin(); binding != g_BoundBuffers.end();)
+		{
+			binding = (binding->second == buffer) ? g_BoundBuffers.erase(binding) : std::next(binding);
+		}
+		for (auto binding = g_IndexedBuffers.begin(); binding != g_IndexedBuffers.end();)
+		{
+			binding = (binding->second.buffer == buffer) ? g_IndexedBuffers.erase(binding) : std::next(binding);
+		}
+	}
+
+	// the bind and uniform wrappers
+	void GLAPIENTRY Intercept_ActiveTexture(GLenum texture)
+	{
+		if (g_ActiveTexture == (int64_t)texture)
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_ACTIVE_TEXTURE);
+		}
+		g_ActiveTexture = texture;
+		CALL_SCOPE scope(GLInterceptor::GLCALL_ACTIVE_TEXTURE);
+		g_Driver.ActiveTexture(texture);
+		GLCapture::Record(GLInterceptor::GLCALL_ACTIVE_TEXTURE, { texture });
+	}
+
+	void GLAPIENTRY Intercept_BindBuffer(GLenum target, GLuint buffer)
+	{
+		auto binding = g_BoundBuffers.find(target);
+		if ((binding != g_BoundBuffers.end()) && (binding->second == buffer))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_BIND_BUFFER);
+		}
+		g_BoundBuffers[target] = buffer;
+		CALL_SCOPE scope(GLInterceptor::GLCALL_BIND_BUFFER);
+		g_Driver.BindBuffer(target, buffer);
+		GLCapture::Record(GLInterceptor::GLCALL_BIND_BUFFER, { target, buffer });
+	}
+
+	void GLAPIENTRY Intercept_BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+	{
+		// a whole buffer binding has no range
+		INDEXED_BINDING bound = { buffer, 0, 0 };
+		if (g_IsSameBinding(g_IndexedKey(target, index), bound))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_BIND_BUFFER_BASE);
+		}
+		g_IndexedBuffers[g_IndexedKey(target, index)] = bound;
+		// the generic binding point of the target changes as well
+		g_BoundBuffers[target] = buffer;
+		CALL_SCOPE scope(GLInterceptor::GLCALL_BIND_BUFFER_BASE);
+		g_Driver.BindBufferBase(target, index, buffer);
+		GLCapture::Record(GLInterceptor::GLCALL_BIND_BUFFER_BASE, { target, index, buffer });
+	}
+
+	void GLAPIENTRY Intercept_BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+	{
+		INDEXED_BINDING bound = { buffer, offset, size };
+		if (g_IsSameBinding(g_IndexedKey(target, index), bound))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_BIND_BUFFER_RANGE);
+		}
+		g_IndexedBuffers[g_IndexedKey(target, index)] = bound;
+		g_BoundBuffers[target] = buffer;
+		CALL_SCOPE scope(GLInterceptor::GLCALL_BIND_BUFFER_RANGE);
+		g_Driver.BindBufferRange(target, index, buffer, offset, size);
+		GLCapture::Record(GLInterceptor::GLCALL_BIND_BUFFER_RANGE, { target, index, buffer, (uint64_t)offset, (uint64_t)size });
+	}
+
+	void GLAPIENTRY Intercept_BindVertexArray(GLuint array)
+	{
+		if (g_BoundVertexArray == (int64_t)array)
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_BIND_VERTEX_ARRAY);
+		}
+		else
+		{
+			// the element buffer binding is part of the vertex array
+			g_BoundBuffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+		}
+		g_BoundVertexArray = array;
+		CALL_SCOPE scope(GLInterceptor::GLCALL_BIND_VERTEX_ARRAY);
+		g_Driver.BindVertexArray(array);
+		GLCapture::Record(GLInterceptor::GLCALL_BIND_VERTEX_ARRAY, { array });
+	}
+
+	void GLAPIENTRY Intercept_UseProgram(GLuint program)
+	{
+		if (g_CurrentProgram == (int64_t)program)
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_USE_PROGRAM);
+		}
+		g_CurrentProgram = program;
+		CALL_SCOPE scope(GLInterceptor::GLCALL_USE_PROGRAM);
+		g_Driver.UseProgram(program);
+		GLCapture::Record(GLInterceptor::GLCALL_USE_PROGRAM, { program });
+	}
+
+	GLint GLAPIENTRY Intercept_GetUniformLocation(GLuint program, const GLchar* name)
+	{
+		GLint location = -1;
+		{
+			CALL_SCOPE scope(GLInterceptor::GLCALL_GET_UNIFORM_LOCATION);
+			location = g_Driver.GetUniformLocation(program, name);
+		}
+		GLCapture::Record(GLInterceptor::GLCALL_GET_UNIFORM_LOCATION, { program, (uint64_t)location }, name, strlen(name) + 1);
+		return(location);
+	}
+
+	void GLAPIENTRY Intercept_Uniform1i(GLint location, GLint v0)
+	{
+		if (g_IsSameUniform(location, &v0, sizeof(v0)))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_UNIFORM_1I);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNIFORM_1I);
+		g_Driver.Uniform1i(location, v0);
+		GLCapture::Record(GLInterceptor::GLCALL_UNIFORM_1I, { (uint64_t)location, (uint64_t)v0 });
+	}
+
+	void GLAPIENTRY Intercept_Uniform1f(GLint location, GLfloat v0)
+	{
+		if (g_IsSameUniform(location, &v0, sizeof(v0)))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_UNIFORM_1F);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNIFORM_1F);
+		g_Driver.Uniform1f(location, v0);
+		GLCapture::Record(GLInterceptor::GLCALL_UNIFORM_1F, { (uint64_t)location, GLCapture::FloatBits(v0) });
+	}
+
+	void GLAPIENTRY Intercept_Uniform2f(GLint location, GLfloat v0, GLfloat v1)
+	{
+		GLfloat values[2] = { v0, v1 };
+		if (g_IsSameUniform(location, values, sizeof(values)))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_UNIFORM_2F);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNIFORM_2F);
+		g_Driver.Uniform2f(location, v0, v1);
+		GLCapture::Record(GLInterceptor::GLCALL_UNIFORM_2F, { (uint64_t)location }, values, sizeof(values));
+	}
+
+	void GLAPIENTRY Intercept_Uniform2fv(GLint location, GLsizei count, const GLfloat* value)
+	{
+		if (g_IsSameUniform(location, value, sizeof(GLfloat) * 2 * count))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_UNIFORM_2FV);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNIFORM_2FV);
+		g_Driver.Uniform2fv(location, count, value);
+		GLCapture::Record(GLInterceptor::GLCALL_UNIFORM_2FV, { (uint64_t)location, (uint64_t)count }, value, sizeof(GLfloat) * 2 * count);
+	}
+
+	void GLAPIENTRY Intercept_Uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+	{
+		GLfloat values[3] = { v0, v1, v2 };
+		if (g_IsSameUniform(location, values, sizeof(values)))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_UNIFORM_3F);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNIFORM_3F);
+		g_Driver.Uniform3f(location, v0, v1, v2);
+		GLCapture::Record(GLInterceptor::GLCALL_UNIFORM_3F, { (uint64_t)location }, values, sizeof(values));
+	}
+
+	void GLAPIENTRY Intercept_Uniform3fv(GLint location, GLsizei count, const GLfloat* value)
+	{
+		if (g_IsSameUniform(location, value, sizeof(GLfloat) * 3 * count))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_UNIFORM_3FV);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNIFORM_3FV);
+		g_Driver.Uniform3fv(location, count, value);
+		GLCapture::Record(GLInterceptor::GLCALL_UNIFORM_3FV, { (uint64_t)location, (uint64_t)count }, value, sizeof(GLfloat) * 3 * count);
+	}
+
+	void GLAPIENTRY Intercept_Uniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+	{
+		GLfloat values[4] = { v0, v1, v2, v3 };
+		if (g_IsSameUniform(location, values, sizeof(values)))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_UNIFORM_4F);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNIFORM_4F);
+		g_Driver.Uniform4f(location, v0, v1, v2, v3);
+		GLCapture::Record(GLInterceptor::GLCALL_UNIFORM_4F, { (uint64_t)location }, values, sizeof(values));
+	}
+
+	void GLAPIENTRY Intercept_Uniform4fv(GLint location, GLsizei count, const GLfloat* value)
+	{
+		if (g_IsSameUniform(location, value, sizeof(GLfloat) * 4 * count))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_UNIFORM_4FV);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNIFORM_4FV);
+		g_Driver.Uniform4fv(location, count, value);
+		GLCapture::Record(GLInterceptor::GLCALL_UNIFORM_4FV, { (uint64_t)location, (uint64_t)count }, value, sizeof(GLfloat) * 4 * count);
+	}
+
+	void GLAPIENTRY Intercept_UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+	{
+		// a transposed set stores different values for the same floats
+		if (!transpose && g_IsSameUniform(location, value, sizeof(GLfloat) * 16 * count))
+		{
+			g_CountRedundant(GLInterceptor::GLCALL_UNIFORM_MATRIX_4FV);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNIFORM_MATRIX_4FV);
+		g_Driver.UniformMatrix4fv(location, count, transpose, value);
+		GLCapture::Record(GLInterceptor::GLCALL_UNIFORM_MATRIX_4FV, { (uint64_t)location, (uint64_t)count, transpose }, value, sizeof(GLfloat) * 16 * count);
+	}
+
+	// the buffer and vertex array wrappers
+	void GLAPIENTRY Intercept_BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_BUFFER_DATA);
+		g_Driver.BufferData(target, size, data, usage);
+		GLCapture::Record(GLInterceptor::GLCALL_BUFFER_DATA, { target, (uint64_t)size, usage, (NULL != data) }, data, (NULL != data) ? (size_t)size : 0);
+	}
+
+	void GLAPIENTRY Intercept_BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_BUFFER_STORAGE);
+		g_Driver.BufferStorage(target, size, data, flags);
+		GLCapture::Record(GLInterceptor::GLCALL_BUFFER_STORAGE, { target, (uint64_t)size, flags, (NULL != data) }, data, (NULL != data) ? (size_t)size : 0);
+	}
+
+	void GLAPIENTRY Intercept_BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_BUFFER_SUB_DATA);
+		g_Driver.BufferSubData(target, offset, size, data);
+		GLCapture::Record(GLInterceptor::GLCALL_BUFFER_SUB_DATA, { target, (uint64_t)offset, (uint64_t)size }, data, (size_t)size);
+	}
+
+	void GLAPIENTRY Intercept_CopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_COPY_BUFFER_SUB_DATA);
+		g_Driver.CopyBufferSubData(readTarget, writeTarget, readOffset, writeOffset, size);
+		GLCapture::Record(GLInterceptor::GLCALL_COPY_BUFFER_SUB_DATA, { readTarget, writeTarget, (uint64_t)readOffset, (uint64_t)writeOffset, (uint64_t)size });
+	}
+
+	void* GLAPIENTRY Intercept_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+	{
+		void* pMapped = NULL;
+		{
+			CALL_SCOPE scope(GLInterceptor::GLCALL_MAP_BUFFER_RANGE);
+			pMapped = g_Driver.MapBufferRange(target, offset, length, access);
+		}
+		GLCapture::RecordMap(target, offset, length, access, pMapped);
+		return(pMapped);
+	}
+
+	GLboolean GLAPIENTRY Intercept_UnmapBuffer(GLenum target)
+	{
+		// the written contents are only readable until the unmap
+		GLCapture::RecordUnmap(target);
+		CALL_SCOPE scope(GLInterceptor::GLCALL_UNMAP_BUFFER);
+		return(g_Driver.UnmapBuffer(target));
+	}
+
+	void GLAPIENTRY Intercept_GenBuffers(GLsizei n, GLuint* buffers)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_GEN_BUFFERS);
+		g_Driver.GenBuffers(n, buffers);
+		GLCapture::Record(GLInterceptor::GLCALL_GEN_BUFFERS, { (uint64_t)n }, buffers, sizeof(GLuint) * n);
+	}
+
+	void GLAPIENTRY Intercept_DeleteBuffers(GLsizei n, const GLuint* buffers)
+	{
+		for (GLsizei i = 0; i < n; i++)
+		{
+			g_ForgetBuffer(buffers[i]);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_DELETE_BUFFERS);
+		g_Driver.DeleteBuffers(n, buffers);
+		GLCapture::Record(GLInterceptor::GLCALL_DELETE_BUFFERS, { (uint64_t)n }, buffers, sizeof(GLuint) * n);
+	}
+
+	void GLAPIENTRY Intercept_GenVertexArrays(GLsizei n, GLuint* arrays)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_GEN_VERTEX_ARRAYS);
+		g_Driver.GenVertexArrays(n, arrays);
+		GLCapture::Record(GLInterceptor::GLCALL_GEN_VERTEX_ARRAYS, { (uint64_t)n }, arrays, sizeof(GLuint) * n);
+	}
+
+	void GLAPIENTRY Intercept_DeleteVertexArrays(GLsizei n, const GLuint* arrays)
+	{
+		for (GLsizei i = 0; i < n; i++)
+		{
+			// deleting the bound vertex array binds the default one
+			if (g_BoundVertexArray == (int64_t)arrays[i])
+			{
+				g_BoundVertexArray = 0;
+				g_BoundBuffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+			}
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_DELETE_VERTEX_ARRAYS);
+		g_Driver.DeleteVertexArrays(n, arrays);
+		GLCapture::Record(GLInterceptor::GLCALL_DELETE_VERTEX_ARRAYS, { (uint64_t)n }, arrays, sizeof(GLuint) * n);
+	}
+
+	void GLAPIENTRY Intercept_VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_VERTEX_ATTRIB_POINTER);
+		g_Driver.VertexAttribPointer(index, size, type, normalized, stride, pointer);
+		GLCapture::Record(GLInterceptor::GLCALL_VERTEX_ATTRIB_POINTER, { index, (uint64_t)size, type, normalized, (uint64_t)stride, (uint64_t)(uintptr_t)pointer });
+	}
+
+	void GLAPIENTRY Intercept_EnableVertexAttribArray(GLuint index)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_ENABLE_VERTEX_ATTRIB_ARRAY);
+		g_Driver.EnableVertexAttribArray(index);
+		GLCapture::Record(GLInterceptor::GLCALL_ENABLE_VERTEX_ATTRIB_ARRAY, { index });
+	}
+
+	void GLAPIENTRY Intercept_VertexAttribDivisor(GLuint index, GLuint divisor)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_VERTEX_ATTRIB_DIVISOR);
+		g_Driver.VertexAttribDivisor(index, divisor);
+		GLCapture::Record(GLInterceptor::GLCALL_VERTEX_ATTRIB_DIVISOR, { index, divisor });
+	}
+
+	// the draw, texture, sync and program wrappers
+	void GLAPIENTRY Intercept_DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_DRAW_ARRAYS_INSTANCED);
+		g_Driver.DrawArraysInstanced(mode, first, count, instancecount);
+		GLCapture::Record(GLInterceptor::GLCALL_DRAW_ARRAYS_INSTANCED, { mode, (uint64_t)first, (uint64_t)count, (uint64_t)instancecount });
+	}
+
+	void GLAPIENTRY Intercept_DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_DRAW_ELEMENTS_INSTANCED);
+		g_Driver.DrawElementsInstanced(mode, count, type, indices, instancecount);
+		GLCapture::Record(GLInterceptor::GLCALL_DRAW_ELEMENTS_INSTANCED, { mode, (uint64_t)count, type, (uint64_t)(uintptr_t)indices, (uint64_t)instancecount });
+	}
+
+	void GLAPIENTRY Intercept_GenerateMipmap(GLenum target)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_GENERATE_MIPMAP);
+		g_Driver.GenerateMipmap(target);
+		GLCapture::Record(GLInterceptor::GLCALL_GENERATE_MIPMAP, { target });
+	}
+
+	GLsync GLAPIENTRY Intercept_FenceSync(GLenum condition, GLbitfield flags)
+	{
+		GLsync sync = NULL;
+		{
+			CALL_SCOPE scope(GLInterceptor::GLCALL_FENCE_SYNC);
+			sync = g_Driver.FenceSync(condition, flags);
+		}
+		GLCapture::Record(GLInterceptor::GLCALL_FENCE_SYNC, { condition, flags, (uint64_t)(uintptr_t)sync });
+		return(sync);
+	}
+
+	GLenum GLAPIENTRY Intercept_ClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	{
+		GLCapture::Record(GLInterceptor::GLCALL_CLIENT_WAIT_SYNC, { (uint64_t)(uintptr_t)sync, flags, timeout });
+		CALL_SCOPE scope(GLInterceptor::GLCALL_CLIENT_WAIT_SYNC);
+		return(g_Driver.ClientWaitSync(sync, flags, timeout));
+	}
+
+	void GLAPIENTRY Intercept_DeleteSync(GLsync sync)
+	{
+		CALL_SCOPE scope(GLInterceptor::GLCALL_DELETE_SYNC);
+		g_Driver.DeleteSync(sync);
+		GLCapture::Record(GLInterceptor::GLCALL_DELETE_SYNC, { (uint64_t)(uintptr_t)sync });
+	}
+
+	void GLAPIENTRY Intercept_DeleteProgram(GLuint program)
+	{
+		// a new program may reuse the name, with its own uniforms
+		for (auto value = g_UniformValues.begin(); value != g_UniformValues.end();)
+		{
+			value = ((value->first >> 32) == program) ? g_UniformValues.erase(value) : std::next(value);
+		}
+		CALL_SCOPE scope(GLInterceptor::GLCALL_DELETE_PROGRAM);
+		g_Driver.DeleteProgram(program);
+		GLCapture::Record(GLInterceptor::GLCALL_DELETE_PROGRAM, { program });
+	}
+}
+
+// swap a GLEW entry point for its wrapper, keeping the driver's
+#define GL_INTERCEPT(name) g_Driver.name = __glew##name; __glew##name = Intercept_##name
+// put the driver's entry point back
+#define GL_RESTORE(name) __glew##name = g_Driver.name
+
+/***********************************************************
+ *  Install()
+ *
+ *  This method is used for swapping the GLEW entry points
+ *  for the wrappers and opening the report.  The bindings
+ *  made before are read back once, so the first calls can
+ *  already be checked against them.
+ ***********************************************************/
+bool GLInterceptor::Install(const char* reportFilename)
+{
+	if (g_bInstalled)
+	{
+		return(true);
+	}
+
+	// the calls are only counted, not reported, without a file
+	if (NULL != reportFilename)
+	{
+		g_Report.open(reportFilename, std::ios::out | std::ios::trunc);
+		if (!g_Report.is_open())
+		{
+			std::cout << "WARNING: could not write OpenGL call report " << reportFilename << std::endl;
+			return(false);
+		}
+		g_Report << "frame,call,calls,redundant,microseconds\n";
+	}
+
+	GL_INTERCEPT(ActiveTexture);
+	GL_INTERCEPT(BindBuffer);
+	GL_INTERCEPT(BindBufferBase);
+	GL_INTERCEPT(BindBufferRange);
+	GL_INTERCEPT(BindVertexArray);
+	GL_INTERCEPT(UseProgram);
+	GL_INTERCEPT(GetUniformLocation);
+	GL_INTERCEPT(Uniform1i);
+	GL_INTERCEPT(Uniform1f);
+	GL_INTERCEPT(Uniform2f);
+	GL_INTERCEPT(Uniform2fv);
+	GL_INTERCEPT(Uniform3f);
+	GL_INTERCEPT(Uniform3fv);
+	GL_INTERCEPT(Uniform4f);
+	GL_INTERCEPT(Uniform4fv);
+	GL_INTERCEPT(UniformMatrix4fv);
+	GL_INTERCEPT(BufferData);
+	GL_INTERCEPT(BufferStorage);
+	GL_INTERCEPT(BufferSubData);
+	GL_INTERCEPT(CopyBufferSubData);
+	GL_INTERCEPT(MapBufferRange);
+	GL_INTERCEPT(UnmapBuffer);
+	GL_INTERCEPT(GenBuffers);
+	GL_INTERCEPT(DeleteBuffers);
+	GL_INTERCEPT(GenVertexArrays);
+	GL_INTERCEPT(DeleteVertexArrays);
+	GL_INTERCEPT(VertexAttribPointer);
+	GL_INTERCEPT(EnableVertexAttribArray);
+	GL_INTERCEPT(VertexAttribDivisor);
+	GL_INTERCEPT(DrawArraysInstanced);
+	GL_INTERCEPT(DrawElementsInstanced);
+	GL_INTERCEPT(GenerateMipmap);
+	GL_INTERCEPT(FenceSync);
+	GL_INTERCEPT(ClientWaitSync);
+	GL_INTERCEPT(DeleteSync);
+	GL_INTERCEPT(DeleteProgram);
+
+	GLint program = 0;
+	GLint vertexArray = 0;
+	GLint activeTexture = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	g_CurrentProgram = program;
+	g_BoundVertexArray = vertexArray;
+	g_ActiveTexture = activeTexture;
+
+	memset(g_FrameStats, 0, sizeof(g_FrameStats));
+	memset(g_TotalStats, 0, sizeof(g_TotalStats));
+	g_ReportFrame = 0;
+	g_bInstalled = true;
+	return(true);
+}
+
+/***********************************************************
+ *  Uninstall()
+ *
+ *  This method is used for putting the driver entry points
+ *  back, closing the report and printing the average calls
+ *  of a frame along with the entry points that were called
+ *  redundantly the most.
+ ***********************************************************/
+void GLInterceptor::Uninstall()
+{
+	if (!g_bInstalled)
+	{
+		return;
+	}
+
+	GL_RESTORE(ActiveTexture);
+	GL_RESTORE(BindBuffer);
+	GL_RESTORE(BindBufferBase);
+	GL_RESTORE(BindBufferRange);
+	GL_RESTORE(BindVertexArray);
+	GL_RESTORE(UseProgram);
+	GL_RESTORE(GetUniformLocation);
+	GL_RESTORE(Uniform1i);
+	GL_RESTORE(Uniform1f);
+	GL_RESTORE(Uniform2f);
+	GL_RESTORE(Uniform2fv);
+	GL_RESTORE(Uniform3f);
+	GL_RESTORE(Uniform3fv);
+	GL_RESTORE(Uniform4f);
+	GL_RESTORE(Uniform4fv);
+	GL_RESTORE(UniformMatrix4fv);
+	GL_RESTORE(BufferData);
+	GL_RESTORE(BufferStorage);
+	GL_RESTORE(BufferSubData);
+	GL_RESTORE(CopyBufferSubData);
+	GL_RESTORE(MapBufferRange);
+	GL_RESTORE(UnmapBuffer);
+	GL_RESTORE(GenBuffers);
+	GL_RESTORE(DeleteBuffers);
+	GL_RESTORE(GenVertexArrays);
+	GL_RESTORE(DeleteVertexArrays);
+	GL_RESTORE(VertexAttribPointer);
+	GL_RESTORE(EnableVertexAttribArray);
+	GL_RESTORE(VertexAttribDivisor);
+	GL_RESTORE(DrawArraysInstanced);
+	GL_RESTORE(DrawElementsInstanced);
+	GL_RESTORE(GenerateMipmap);
+	GL_RESTORE(FenceSync);
+	GL_RESTORE(ClientWaitSync);
+	GL_RESTORE(DeleteSync);
+	GL_RESTORE(DeleteProgram);
+	g_bInstalled = false;
+
+	// the calls of an unfinished frame still go into the report
+	for (int call = 0; call < GLCALL_COUNT; call++)
+	{
+		if (g_FrameStats[call].calls > 0)
+		{
+			EndFrame();
+			break;
+		}
+	}
+	g_Report.close();
+
+	uint64_t frames = std::max<uint64_t>(g_ReportFrame, 1);
+	uint64_t totalCalls = 0;
+	uint64_t totalRedundant = 0;
+	for (int call = 0; call < GLCALL_COUNT; call++)
+	{
+		totalCalls += g_TotalStats[call].calls;
+		totalRedundant += g_TotalStats[call].redundant;
+	}
+	std::cout << "INFO: " << (double)totalCalls / frames << " intercepted OpenGL calls a frame over "
+		<< g_ReportFrame << " frames, " << (double)totalRedundant / frames << " of them redundant" << std::endl;
+
+	// the three entry points with the most redundant calls
+	GL_CALL_STATS ranking[GLCALL_COUNT];
+	memcpy(ranking, g_TotalStats, sizeof(ranking));
+	for (int rank = 0; rank < 3; rank++)
+	{
+		int worst = -1;
+		for (int call = 0; call < GLCALL_COUNT; call++)
+		{
+			if ((ranking[call].redundant > 0) &&
+				((worst < 0) || (ranking[call].redundant > ranking[worst].redundant)))
+			{
+				worst = call;
+			}
+		}
+		if (worst < 0)
+		{
+			break;
+		}
+		std::cout << "INFO:   " << g_CallNames[worst] << " - "
+			<< (double)ranking[worst].redundant / frames << " redundant of "
+			<< (double)ranking[worst].calls / frames << " calls a frame" << std::endl;
+		ranking[worst].redundant = 0;
+	}
+}
+
+/***********************************************************
+ *  IsInstalled()
+ *
+ *  This method is used for checking whether the wrappers
+ *  are in place.
+ ***********************************************************/
+bool GLInterceptor::IsInstalled()
+{
+	return(g_bInstalled);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for writing one line per entry point
+ *  called in the frame into the report, followed by the
+ *  frame totals, and starting the counts of the next frame.
+ ***********************************************************/
+void GLInterceptor::EndFrame()
+{
+	GL_CALL_STATS frameTotal = {};
+	for (int call = 0; call < GLCALL_COUNT; call++)
+	{
+		const GL_CALL_STATS& stats = g_FrameStats[call];
+		if (stats.calls == 0)
+		{
+			continue;
+		}
+		if (g_Report.is_open())
+		{
+			g_Report << g_ReportFrame << "," << g_CallNames[call] << ","
+				<< stats.calls << "," << stats.redundant << ","
+				<< stats.nanoseconds / 1000.0 << "\n";
+		}
+
+		frameTotal.calls += stats.calls;
+		frameTotal.redundant += stats.redundant;
+		frameTotal.nanoseconds += stats.nanoseconds;
+		g_TotalStats[call].calls += stats.calls;
+		g_TotalStats[call].redundant += stats.redundant;
+		g_TotalStats[call].nanoseconds += stats.nanoseconds;
+	}
+	if (g_Report.is_open())
+	{
+		g_Report << g_ReportFrame << ",total,"
+			<< frameTotal.calls << "," << frameTotal.redundant << ","
+			<< frameTotal.nanoseconds / 1000.0 << "\n";
+	}
+
+	memset(g_FrameStats, 0, sizeof(g_FrameStats));
+	g_ReportFrame++;
+}
+
+/***********************************************************
+ *  GetFrameStats()
+ *
+ *  This method is used for getting the calls made to one
+ *  entry point in the frame so far.
+ ***********************************************************/
+const GLInterceptor::GL_CALL_STATS& GLInterceptor::GetFrameStats(GL_CALL call)
+{
+	return(g_FrameStats[call]);
+}
+
+/***********************************************************
+ *  GetCallName()
+ *
+ *  This method is used for getting the name of the OpenGL
+ *  function of an entry point.
+ ***********************************************************/
+const char* GLInterceptor::GetCallName(GL_CALL call)
+{
+	return(g_CallNames[call]);
+}
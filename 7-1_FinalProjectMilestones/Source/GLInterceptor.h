@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// glinterceptor.h
+// ============
+// count the OpenGL calls of every frame and flag the redundant ones
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+
+/***********************************************************
+ *  GLInterceptor
+ *
+ *  This class swaps the GLEW entry points the application
+ *  uses for wrappers that count and time every call before
+ *  passing it on to the driver.  Since the shader manager
+ *  and the shape meshes call through the same GLEW function
+ *  pointers, their calls are seen as well, without changing
+ *  any call site.
+ *
+ *  The wrappers shadow the bound buffers, vertex array,
+ *  program and texture unit, and the value of every uniform
+ *  of every program, so binds and uniform sets that change
+ *  nothing are flagged as redundant.  The calls of every
+ *  frame are written into a report, one line per entry
+ *  point that was called.
+ *
+ *  The OpenGL 1.1 entry points, such as glDrawElements and
+ *  glBindTexture, are exported by the system library rather
+ *  than loaded by GLEW, so they cannot be swapped and are
+ *  not counted.
+ ***********************************************************/
+class GLInterceptor
+{
+public:
+	// entry points with a wrapper
+	enum GL_CALL
+	{
+		GLCALL_ACTIVE_TEXTURE = 0,
+		GLCALL_BIND_BUFFER,
+		GLCALL_BIND_BUFFER_BASE,
+		GLCALL_BIND_BUFFER_RANGE,
+		GLCALL_BIND_VERTEX_ARRAY,
+		GLCALL_USE_PROGRAM,
+		GLCALL_GET_UNIFORM_LOCATION,
+		GLCALL_UNIFORM_1I,
+		GLCALL_UNIFORM_1F,
+		GLCALL_UNIFORM_2F,
+		GLCALL_UNIFORM_2FV,
+		GLCALL_UNIFORM_3F,
+		GLCALL_UNIFORM_3FV,
+		GLCALL_UNIFORM_4F,
+		GLCALL_UNIFORM_4FV,
+		GLCALL_UNIFORM_MATRIX_4FV,
+		GLCALL_BUFFER_DATA,
+		GLCALL_BUFFER_STORAGE,
+		GLCALL_BUFFER_SUB_DATA,
+		GLCALL_COPY_BUFFER_SUB_DATA,
+		GLCALL_MAP_BUFFER_RANGE,
+		GLCALL_UNMAP_BUFFER,
+		GLCALL_GEN_BUFFERS,
+		GLCALL_DELETE_BUFFERS,
+		GLCALL_GEN_VERTEX_ARRAYS,
+		GLCALL_DELETE_VERTEX_ARRAYS,
+		GLCALL_VERTEX_ATTRIB_POINTER,
+		GLCALL_ENABLE_VERTEX_ATTRIB_ARRAY,
+		GLCALL_VERTEX_ATTRIB_DIVISOR,
+		GLCALL_DRAW_ARRAYS_INSTANCED,
+		GLCALL_DRAW_ELEMENTS_INSTANCED,
+		GLCALL_GENERATE_MIPMAP,
+		GLCALL_FENCE_SYNC,
+		GLCALL_CLIENT_WAIT_SYNC,
+		GLCALL_DELETE_SYNC,
+		GLCALL_DELETE_PROGRAM,
+		GLCALL_COUNT
+	};
+
+	// calls made to one entry point
+	struct GL_CALL_STATS
+	{
+		uint32_t calls;
+		// binds of what was already bound, and uniform sets of
+		// the value already set or of a location that does not exist
+		uint32_t redundant;
+		// time spent in the driver
+		uint64_t nanoseconds;
+	};
+
+	// swap the entry points for the wrappers - GLEW has to be
+	// initialized, and the report is written into the passed in
+	// file, or not at all when it is NULL
+	static bool Install(const char* reportFilename);
+	// restore the driver entry points and close the report
+	static void Uninstall();
+	static bool IsInstalled();
+
+	// write the calls of the frame into the report and start the next
+	static void EndFrame();
+
+	// calls of the frame so far
+	static const GL_CALL_STATS& GetFrameStats(GL_CALL call);
+	static const char* GetCallName(GL_CALL call);
+};
@@ -0,0 +1,205 @@
+///////////////////////////////////////////////////////////////////////////////
+// glrenderdevice.cpp
+// ============
+// render device that executes command lists with OpenGL
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLRenderDevice.h"
+#include "GLCapture.h"
+#include "SceneBuffers.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_TextureArrayName = "objectTextures";
+}
+
+/***********************************************************
+ *  GLRenderDevice()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLRenderDevice::GLRenderDevice(ShapeMeshes* pMeshes, UniformRing* pUniformRing, ModelMeshes* pModelMeshes)
+{
+	m_pMeshes = pMeshes;
+	m_pUniformRing = pUniformRing;
+	m_pModelMeshes = pModelMeshes;
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for pointing the texture samplers of
+ *  the shader program that is current at the texture units,
+ *  once.  The program has to stay current while command
+ *  lists are submitted.
+ ***********************************************************/
+bool GLRenderDevice::Initialize()
+{
+	GLint programID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	if (programID == 0)
+	{
+		std::cout << "WARNING: the OpenGL render device needs a current shader program" << std::endl;
+		return(false);
+	}
+
+	m_programID = (GLuint)programID;
+	GLint textureUnits[SCENE_TEXTURE_SLOTS];
+	for (int i = 0; i < SCENE_TEXTURE_SLOTS; i++)
+	{
+		textureUnits[i] = i;
+	}
+	glUniform1iv(glGetUniformLocation(m_programID, g_TextureArrayName), SCENE_TEXTURE_SLOTS, textureUnits);
+	return(true);
+}
+
+/***********************************************************
+ *  GetTargetHeight()
+ *
+ *  This method is used for getting the height of the
+ *  viewport the scene is drawn into.
+ ***********************************************************/
+int GLRenderDevice::GetTargetHeight() const
+{
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	return(viewport[3]);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for uploading the scene changes made
+ *  since the last frame.  Each buffer uploads only its dirty
+ *  ranges, then all three are bound for drawing, and the
+ *  camera and lighting are written into the per-frame block.
+ *  Further views of the same frame carry on in the same
+ *  region of the uniform ring, so it is fenced only once.
+ ***********************************************************/
+void GLRenderDevice::BeginFrame(const RENDER_FRAME& frame)
+{
+	frame.pInstances->Flush();
+	frame.pMaterials->Flush();
+	frame.pLights->Flush();
+
+	frame.pInstances->Bind(SCENE_BINDING_INSTANCES);
+	frame.pMaterials->Bind(SCENE_BINDING_MATERIALS);
+	frame.pLights->Bind(SCENE_BINDING_LIGHTS);
+
+	// the foliage is animated entirely in the vertex shader, so
+	// the wind is the only per-frame upload
+	frame.pWind->Update(frame.time);
+
+	// the frame block is written with a plain copy into the
+	// mapped ring buffer
+	if (!frame.bSameFrame)
+	{
+		m_pUniformRing->BeginFrame();
+	}
+	GLintptr offset = 0;
+	void* pConstants = m_pUniformRing->Allocate(sizeof(frame.constants), offset);
+	memcpy(pConstants, &frame.constants, sizeof(frame.constants));
+	m_pUniformRing->Bind(SCENE_BINDING_FRAME, offset, sizeof(frame.constants));
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for executing the command lists in
+ *  order.  Every draw gets its own draw block, written with
+ *  a plain copy into the mapped ring and bound by offset.
+ ***********************************************************/
+void GLRenderDevice::Submit(const RenderCommandList* pLists, size_t listCount)
+{
+	std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+	m_stats = {};
+	m_stats.commandLists = (uint32_t)listCount;
+
+	int previousTextureSlot = -1;
+	for (size_t list = 0; list < listCount; list++)
+	{
+		const RENDER_COMMAND* pCommands = pLists[list].GetCommands();
+		size_t commandCount = pLists[list].GetCount();
+		for (size_t i = 0; i < commandCount; i++)
+		{
+			const RENDER_COMMAND& command = pCommands[i];
+
+			DRAW_CONSTANTS constants = {};
+			constants.instanceBase = (int32_t)command.instance;
+			constants.textureSlot = command.textureSlot;
+			GLintptr offset = 0;
+			void* pConstants = m_pUniformRing->Allocate(sizeof(constants), offset);
+			memcpy(pConstants, &constants, sizeof(constants));
+			m_pUniformRing->Bind(SCENE_BINDING_DRAW, offset, sizeof(constants));
+
+			if (command.textureSlot != previousTextureSlot)
+			{
+				previousTextureSlot = command.textureSlot;
+				m_stats.textureChanges++;
+			}
+
+			DrawMesh((SCENE_MESH)command.mesh, command.lod);
+			m_stats.draws++;
+		}
+	}
+
+	m_stats.submitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing one of the basic shape
+ *  meshes, or a level of detail of one of the imported
+ *  meshes numbered after them.
+ ***********************************************************/
+void GLRenderDevice::DrawMesh(SCENE_MESH mesh, uint32_t lod)
+{
+	// the shape meshes draw through the system library, so the
+	// draw is captured by mesh
+	GLCapture::Record(GLCAPTURE_DRAW_MESH, { (uint64_t)mesh });
+
+	switch (mesh)
+	{
+	case SCENE_MESH_PLANE:
+		m_pMeshes->DrawPlaneMesh();
+		break;
+	case SCENE_MESH_BOX:
+		m_pMeshes->DrawBoxMesh();
+		break;
+	case SCENE_MESH_TORUS:
+		m_pMeshes->DrawTorusMesh();
+		break;
+	case SCENE_MESH_TAPERED_CYLINDER:
+		m_pMeshes->DrawTaperedCylinderMesh();
+		break;
+	case SCENE_MESH_PRISM:
+		m_pMeshes->DrawPrismMesh();
+		break;
+	default:
+		if ((NULL != m_pModelMeshes) && (mesh >= SCENE_MESH_COUNT))
+		{
+			m_pModelMeshes->Draw((uint32_t)mesh - SCENE_MESH_COUNT, lod);
+		}
+		break;
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for fencing the frame's uniform
+ *  blocks - the GPU is done with them once the fence
+ *  signals.
+ ***********************************************************/
+void GLRenderDevice::EndFrame()
+{
+	m_pUniformRing->EndFrame();
+}
@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// glrenderdevice.h
+// ============
+// render device that executes command lists with OpenGL
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderDevice.h"
+#include "UniformRing.h"
+#include "ShapeMeshes.h"
+#include "ModelMeshes.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  GLRenderDevice
+ *
+ *  This class executes command lists with the scene shader
+ *  program and the basic shape meshes.  The instance and
+ *  texture slot of every draw are copied into a draw block
+ *  in the uniform ring and bound by offset, so drawing sets
+ *  no uniforms at all.  The scene textures stay bound to
+ *  their units, and the shader picks one by the slot.
+ *  Mesh numbers past the basic shapes are imported meshes.
+ ***********************************************************/
+class GLRenderDevice : public RenderDevice
+{
+public:
+	// constructor
+	GLRenderDevice(ShapeMeshes* pMeshes, UniformRing* pUniformRing, ModelMeshes* pModelMeshes);
+
+	const char* GetName() const override { return "OpenGL"; }
+	// resolve the uniforms of the current shader program
+	bool Initialize() override;
+	int GetTargetHeight() const override;
+	void BeginFrame(const RENDER_FRAME& frame) override;
+	void Submit(const RenderCommandList* pLists, size_t listCount) override;
+	void EndFrame() override;
+
+private:
+	ShapeMeshes* m_pMeshes;
+	UniformRing* m_pUniformRing;
+	ModelMeshes* m_pModelMeshes;
+	GLuint m_programID;
+
+	// draw one of the basic shape or imported meshes
+	void DrawMesh(SCENE_MESH mesh, uint32_t lod);
+};
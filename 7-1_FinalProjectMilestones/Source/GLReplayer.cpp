@@ -0,0 +1,730 @@
+///////////////////////////////////////////////////////////////////////////////
+// glreplayer.cpp
+// ============
+// re-execute a recorded OpenGL capture in a loop and time its frames
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLReplayer.h"
+#include "GLInterceptor.h"
+#include "SceneFile.h"
+#include "ShapeMeshes.h"
+
+#include "GLFW/glfw3.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// replay objects are labelled with this in the live registry
+	const char* const g_ReplayLabel = "replay";
+
+	// median of a list of times
+	double g_Median(std::vector<double> values)
+	{
+		if (values.empty())
+		{
+			return(0.0);
+		}
+		std::sort(values.begin(), values.end());
+		return(values[values.size() / 2]);
+	}
+
+	// compile one stage of a replayed program
+	GLuint g_CompileShader(GLenum type, const char* pSource, GLint length)
+	{
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &pSource, &length);
+		glCompileShader(shader);
+
+		GLint bCompiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &bCompiled);
+		if (!bCompiled)
+		{
+			GLchar log[512];
+			glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+			std::cout << "WARNING: a captured shader failed to compile - " << log << std::endl;
+		}
+		return(shader);
+	}
+}
+
+/***********************************************************
+ *  GLReplayer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLReplayer::GLReplayer()
+{
+	memset(&m_header, 0, sizeof(m_header));
+	m_resourceEnd = 0;
+	m_pMeshes = NULL;
+	m_currentProgram = 0;
+}
+
+/***********************************************************
+ *  ~GLReplayer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GLReplayer::~GLReplayer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading a capture file and
+ *  finding where its resource records and every frame end,
+ *  so a frame can be executed without parsing the ones
+ *  before it.
+ ***********************************************************/
+bool GLReplayer::Load(const char* filename)
+{
+	std::ifstream file(filename, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << "WARNING: could not open OpenGL capture " << filename << std::endl;
+		return(false);
+	}
+
+	file.read((char*)&m_header, sizeof(m_header));
+	if (!file || (memcmp(m_header.magic, "GLCP", 4) != 0) || (m_header.version != GLCAPTURE_VERSION))
+	{
+		std::cout << "WARNING: " << filename << " is not an OpenGL capture of a supported version" << std::endl;
+		return(false);
+	}
+	m_stream.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	m_resourceEnd = 0;
+	m_frameEnds.clear();
+	size_t offset = 0;
+	uint32_t records = 0;
+	while (offset + sizeof(GL_CAPTURE_RECORD) <= m_stream.size())
+	{
+		GL_CAPTURE_RECORD record;
+		memcpy(&record, &m_stream[offset], sizeof(record));
+		size_t paddedBytes = ((size_t)record.dataBytes + 7) & ~(size_t)7;
+		offset += sizeof(record) + paddedBytes;
+		records++;
+
+		if (record.call == GLCAPTURE_END_RESOURCES)
+		{
+			m_resourceEnd = offset;
+		}
+		else if (record.call == GLCAPTURE_END_FRAME)
+		{
+			m_frameEnds.push_back(offset);
+		}
+	}
+
+	if ((offset != m_stream.size()) || (records != m_header.recordCount) ||
+		(m_resourceEnd == 0) || (m_frameEnds.size() != m_header.frameCount))
+	{
+		std::cout << "WARNING: OpenGL capture " << filename << " is truncated" << std::endl;
+		m_stream.clear();
+		m_frameEnds.clear();
+		return(false);
+	}
+
+	std::cout << "INFO: loaded OpenGL capture " << filename
+		<< " - " << m_header.frameCount << " frames, "
+		<< m_header.recordCount << " records, "
+		<< m_header.width << "x" << m_header.height << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  CreateResources()
+ *
+ *  This method is used for executing the resource records,
+ *  which create the captured objects and set the state that
+ *  was current when the capture began.
+ ***********************************************************/
+bool GLReplayer::CreateResources(ShapeMeshes* pMeshes)
+{
+	if (m_stream.empty() || (NULL == pMeshes))
+	{
+		return(false);
+	}
+	m_pMeshes = pMeshes;
+	ExecuteRange(0, m_resourceEnd);
+
+	std::cout << "INFO: replay created " << m_buffers.size() << " buffers, "
+		<< m_textures.size() << " textures, "
+		<< m_vertexArrays.size() << " vertex arrays and "
+		<< m_programs.size() << " programs" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  ExecuteFrame()
+ *
+ *  This method is used for executing the records of one
+ *  captured frame.  The returned time is what the calls
+ *  cost on the CPU, not when the GPU finished them.
+ ***********************************************************/
+double GLReplayer::ExecuteFrame(uint32_t frame)
+{
+	if (frame >= m_frameEnds.size())
+	{
+		return(0.0);
+	}
+
+	size_t begin = (frame == 0) ? m_resourceEnd : m_frameEnds[frame - 1];
+	auto start = std::chrono::steady_clock::now();
+	ExecuteRange(begin, m_frameEnds[frame]);
+	return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for executing every captured frame
+ *  the given number of times.  The GPU time of a frame is
+ *  measured with a timer query, which is read one loop
+ *  later so waiting for it does not stall the pipeline.
+ ***********************************************************/
+bool GLReplayer::Run(GLFWwindow* pWindow, uint32_t loopCount)
+{
+	uint32_t frameCount = GetFrameCount();
+	if ((frameCount == 0) || (loopCount == 0))
+	{
+		return(false);
+	}
+
+	std::vector<GLuint> queries(frameCount, 0);
+	glGenQueries((GLsizei)frameCount, queries.data());
+	std::vector<std::vector<double>> cpuMilliseconds(frameCount);
+	std::vector<std::vector<double>> gpuMilliseconds(frameCount);
+	std::vector<bool> bQueryPending(frameCount, false);
+
+	auto readQuery = [&](uint32_t frame)
+	{
+		if (bQueryPending[frame])
+		{
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(queries[frame], GL_QUERY_RESULT, &nanoseconds);
+			gpuMilliseconds[frame].push_back(nanoseconds / 1.0e6);
+			bQueryPending[frame] = false;
+		}
+	};
+
+	for (uint32_t loop = 0; (loop < loopCount) && !glfwWindowShouldClose(pWindow); loop++)
+	{
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			readQuery(frame);
+			glBeginQuery(GL_TIME_ELAPSED, queries[frame]);
+			cpuMilliseconds[frame].push_back(ExecuteFrame(frame));
+			glEndQuery(GL_TIME_ELAPSED);
+			bQueryPending[frame] = true;
+
+			glfwSwapBuffers(pWindow);
+			glfwPollEvents();
+			GLResourceManager::EndFrame();
+			if (GLInterceptor::IsInstalled())
+			{
+				GLInterceptor::EndFrame();
+			}
+		}
+	}
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		readQuery(frame);
+	}
+	glDeleteQueries((GLsizei)frameCount, queries.data());
+
+	m_frameStats.assign(frameCount, GL_REPLAY_FRAME_STATS());
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		GL_REPLAY_FRAME_STATS& stats = m_frameStats[frame];
+		size_t begin = (frame == 0) ? m_resourceEnd : m_frameEnds[frame - 1];
+		stats.records = 0;
+		for (size_t offset = begin; offset < m_frameEnds[frame]; stats.records++)
+		{
+			GL_CAPTURE_RECORD record;
+			memcpy(&record, &m_stream[offset], sizeof(record));
+			offset += sizeof(record) + (((size_t)record.dataBytes + 7) & ~(size_t)7);
+		}
+
+		const std::vector<double>& cpu = cpuMilliseconds[frame];
+		const std::vector<double>& gpu = gpuMilliseconds[frame];
+		stats.minCpuMilliseconds = cpu.empty() ? 0.0 : *std::min_element(cpu.begin(), cpu.end());
+		stats.medianCpuMilliseconds = g_Median(cpu);
+		stats.minGpuMilliseconds = gpu.empty() ? 0.0 : *std::min_element(gpu.begin(), gpu.end());
+		stats.medianGpuMilliseconds = g_Median(gpu);
+
+		std::cout << "INFO: replay frame " << frame << " - " << stats.records << " records, "
+			<< cpu.size() << " runs, CPU min " << stats.minCpuMilliseconds
+			<< "ms median " << stats.medianCpuMilliseconds
+			<< "ms, GPU min " << stats.minGpuMilliseconds
+			<< "ms median " << stats.medianGpuMilliseconds << "ms" << std::endl;
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing every object the
+ *  replay created.  The handles queue them for deferred
+ *  deletion.
+ ***********************************************************/
+void GLReplayer::Destroy()
+{
+	for (auto& sync : m_syncs)
+	{
+		glDeleteSync(sync.second);
+	}
+	m_syncs.clear();
+	m_buffers.clear();
+	m_textures.clear();
+	m_vertexArrays.clear();
+	m_programs.clear();
+	m_uniformLocations.clear();
+	m_currentProgram = 0;
+	m_pMeshes = NULL;
+}
+
+/***********************************************************
+ *  ExecuteRange()
+ *
+ *  This method is used for executing the records between
+ *  two offsets of the stream.
+ ***********************************************************/
+void GLReplayer::ExecuteRange(size_t begin, size_t end)
+{
+	size_t offset = begin;
+	while (offset < end)
+	{
+		GL_CAPTURE_RECORD record;
+		memcpy(&record, &m_stream[offset], sizeof(record));
+		const uint8_t* pData = &m_stream[offset] + sizeof(record);
+		Execute(record, pData);
+		offset += sizeof(record) + (((size_t)record.dataBytes + 7) & ~(size_t)7);
+	}
+}
+
+/***********************************************************
+ *  Execute()
+ *
+ *  This method is used for executing one record, with the
+ *  captured object names swapped for the replay ones.
+ ***********************************************************/
+void GLReplayer::Execute(const GL_CAPTURE_RECORD& record, const uint8_t* pData)
+{
+	const uint64_t* args = record.args;
+	const GLfloat* pFloats = (const GLfloat*)pData;
+
+	switch (record.call)
+	{
+	case GLInterceptor::GLCALL_ACTIVE_TEXTURE:
+		glActiveTexture((GLenum)args[0]);
+		break;
+	case GLInterceptor::GLCALL_BIND_BUFFER:
+		glBindBuffer((GLenum)args[0], FindBuffer(args[1]));
+		break;
+	case GLInterceptor::GLCALL_BIND_BUFFER_BASE:
+		glBindBufferBase((GLenum)args[0], (GLuint)args[1], FindBuffer(args[2]));
+		break;
+	case GLInterceptor::GLCALL_BIND_BUFFER_RANGE:
+		glBindBufferRange((GLenum)args[0], (GLuint)args[1], FindBuffer(args[2]), (GLintptr)args[3], (GLsizeiptr)args[4]);
+		break;
+	case GLInterceptor::GLCALL_BIND_VERTEX_ARRAY:
+		glBindVertexArray(FindVertexArray(args[0]));
+		break;
+	case GLInterceptor::GLCALL_USE_PROGRAM:
+		m_currentProgram = args[0];
+		glUseProgram(FindProgram(args[0]));
+		break;
+	case GLInterceptor::GLCALL_GET_UNIFORM_LOCATION:
+		// the location was looked up by name, so look it up again
+		m_uniformLocations[(args[0] << 32) | (uint32_t)args[1]] =
+			glGetUniformLocation(FindProgram(args[0]), (const GLchar*)pData);
+		break;
+	case GLInterceptor::GLCALL_UNIFORM_1I:
+		glUniform1i(FindLocation(args[0]), (GLint)args[1]);
+		break;
+	case GLInterceptor::GLCALL_UNIFORM_1F:
+		glUniform1f(FindLocation(args[0]), GLCapture::BitsFloat(args[1]));
+		break;
+	case GLInterceptor::GLCALL_UNIFORM_2F:
+		glUniform2f(FindLocation(args[0]), pFloats[0], pFloats[1]);
+		break;
+	case GLInterceptor::GLCALL_UNIFORM_2FV:
+		glUniform2fv(FindLocation(args[0]), (GLsizei)args[1], pFloats);
+		break;
+	case GLInterceptor::GLCALL_UNIFORM_3F:
+		glUniform3f(FindLocation(args[0]), pFloats[0], pFloats[1], pFloats[2]);
+		break;
+	case GLInterceptor::GLCALL_UNIFORM_3FV:
+		glUniform3fv(FindLocation(args[0]), (GLsizei)args[1], pFloats);
+		break;
+	case GLInterceptor::GLCALL_UNIFORM_4F:
+		glUniform4f(FindLocation(args[0]), pFloats[0], pFloats[1], pFloats[2], pFloats[3]);
+		break;
+	case GLInterceptor::GLCALL_UNIFORM_4FV:
+		glUniform4fv(FindLocation(args[0]), (GLsizei)args[1], pFloats);
+		break;
+	case GLInterceptor::GLCALL_UNIFORM_MATRIX_4FV:
+		glUniformMatrix4fv(FindLocation(args[0]), (GLsizei)args[1], (GLboolean)args[2], pFloats);
+		break;
+	case GLInterceptor::GLCALL_BUFFER_DATA:
+		glBufferData((GLenum)args[0], (GLsizeiptr)args[1], args[3] ? pData : NULL, (GLenum)args[2]);
+		break;
+	case GLInterceptor::GLCALL_BUFFER_STORAGE:
+		// the replay writes mapped ranges by mapping them again,
+		// which a persistent storage would not allow
+		glBufferData((GLenum)args[0], (GLsizeiptr)args[1], args[3] ? pData : NULL, GL_DYNAMIC_DRAW);
+		break;
+	case GLInterceptor::GLCALL_BUFFER_SUB_DATA:
+		glBufferSubData((GLenum)args[0], (GLintptr)args[1], (GLsizeiptr)args[2], pData);
+		break;
+	case GLInterceptor::GLCALL_COPY_BUFFER_SUB_DATA:
+		glCopyBufferSubData((GLenum)args[0], (GLenum)args[1], (GLintptr)args[2], (GLintptr)args[3], (GLsizeiptr)args[4]);
+		break;
+	case GLInterceptor::GLCALL_GEN_BUFFERS:
+		for (uint64_t i = 0; i < args[0]; i++)
+		{
+			m_buffers[((const GLuint*)pData)[i]] = GLBufferHandle::Create(g_ReplayLabel);
+		}
+		break;
+	case GLInterceptor::GLCALL_DELETE_BUFFERS:
+		for (uint64_t i = 0; i < args[0]; i++)
+		{
+			m_buffers.erase(((const GLuint*)pData)[i]);
+		}
+		break;
+	case GLInterceptor::GLCALL_GEN_VERTEX_ARRAYS:
+		for (uint64_t i = 0; i < args[0]; i++)
+		{
+			m_vertexArrays[((const GLuint*)pData)[i]] = GLVertexArrayHandle::Create(g_ReplayLabel);
+		}
+		break;
+	case GLInterceptor::GLCALL_DELETE_VERTEX_ARRAYS:
+		for (uint64_t i = 0; i < args[0]; i++)
+		{
+			m_vertexArrays.erase(((const GLuint*)pData)[i]);
+		}
+		break;
+	case GLInterceptor::GLCALL_VERTEX_ATTRIB_POINTER:
+		glVertexAttribPointer((GLuint)args[0], (GLint)args[1], (GLenum)args[2], (GLboolean)args[3], (GLsizei)args[4], (const void*)(uintptr_t)args[5]);
+		break;
+	case GLInterceptor::GLCALL_ENABLE_VERTEX_ATTRIB_ARRAY:
+		glEnableVertexAttribArray((GLuint)args[0]);
+		break;
+	case GLInterceptor::GLCALL_VERTEX_ATTRIB_DIVISOR:
+		glVertexAttribDivisor((GLuint)args[0], (GLuint)args[1]);
+		break;
+	case GLInterceptor::GLCALL_DRAW_ARRAYS_INSTANCED:
+		glDrawArraysInstanced((GLenum)args[0], (GLint)args[1], (GLsizei)args[2], (GLsizei)args[3]);
+		break;
+	case GLInterceptor::GLCALL_DRAW_ELEMENTS_INSTANCED:
+		glDrawElementsInstanced((GLenum)args[0], (GLsizei)args[1], (GLenum)args[2], (const void*)(uintptr_t)args[3], (GLsizei)args[4]);
+		break;
+	case GLInterceptor::GLCALL_GENERATE_MIPMAP:
+		glGenerateMipmap((GLenum)args[0]);
+		break;
+	case GLInterceptor::GLCALL_FENCE_SYNC:
+		m_syncs[args[2]] = glFenceSync((GLenum)args[0], (GLbitfield)args[1]);
+		break;
+	case GLInterceptor::GLCALL_CLIENT_WAIT_SYNC:
+	{
+		auto sync = m_syncs.find(args[0]);
+		if (sync != m_syncs.end())
+		{
+			glClientWaitSync(sync->second, (GLbitfield)args[1], args[2]);
+		}
+		break;
+	}
+	case GLInterceptor::GLCALL_DELETE_SYNC:
+	{
+		auto sync = m_syncs.find(args[0]);
+		if (sync != m_syncs.end())
+		{
+			glDeleteSync(sync->second);
+			m_syncs.erase(sync);
+		}
+		break;
+	}
+	case GLInterceptor::GLCALL_DELETE_PROGRAM:
+		m_programs.erase(args[0]);
+		break;
+	case GLCAPTURE_ENABLE:
+		glEnable((GLenum)args[0]);
+		break;
+	case GLCAPTURE_DISABLE:
+		glDisable((GLenum)args[0]);
+		break;
+	case GLCAPTURE_BLEND_FUNC:
+		glBlendFunc((GLenum)args[0], (GLenum)args[1]);
+		break;
+	case GLCAPTURE_DEPTH_MASK:
+		glDepthMask((GLboolean)args[0]);
+		break;
+	case GLCAPTURE_CLEAR_COLOR:
+		glClearColor(
+			GLCapture::BitsFloat(args[0]),
+			GLCapture::BitsFloat(args[1]),
+			GLCapture::BitsFloat(args[2]),
+			GLCapture::BitsFloat(args[3]));
+		break;
+	case GLCAPTURE_CLEAR:
+		glClear((GLbitfield)args[0]);
+		break;
+	case GLCAPTURE_VIEWPORT:
+		glViewport((GLint)args[0], (GLint)args[1], (GLsizei)args[2], (GLsizei)args[3]);
+		break;
+	case GLCAPTURE_BIND_TEXTURE:
+		glBindTexture((GLenum)args[0], FindTexture(args[1]));
+		break;
+	case GLCAPTURE_DRAW_MESH:
+		DrawMesh(args[0]);
+		break;
+	case GLCAPTURE_MAPPED_WRITE:
+	{
+		void* pMapped = glMapBufferRange((GLenum)args[0], (GLintptr)args[1], (GLsizeiptr)args[2], (GLbitfield)args[3]);
+		if (NULL != pMapped)
+		{
+			memcpy(pMapped, pData, (size_t)args[2]);
+			glUnmapBuffer((GLenum)args[0]);
+		}
+		break;
+	}
+	case GLCAPTURE_RESOURCE_BUFFER:
+		CreateBuffer(record, pData);
+		break;
+	case GLCAPTURE_RESOURCE_TEXTURE:
+		CreateTexture(record, pData);
+		break;
+	case GLCAPTURE_RESOURCE_VERTEX_ARRAY:
+	{
+		// the attributes follow as ordinary records
+		GLVertexArrayHandle vertexArray = GLVertexArrayHandle::Create(g_ReplayLabel);
+		glBindVertexArray(vertexArray.GetName());
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, FindBuffer(args[1]));
+		m_vertexArrays[args[0]] = std::move(vertexArray);
+		break;
+	}
+	case GLCAPTURE_RESOURCE_PROGRAM:
+		CreateProgram(record, pData);
+		break;
+	case GLCAPTURE_RESOURCE_UNIFORM:
+		SetUniform(record, pData);
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating a captured buffer with
+ *  its captured contents.
+ ***********************************************************/
+void GLReplayer::CreateBuffer(const GL_CAPTURE_RECORD& record, const uint8_t* pData)
+{
+	GLBufferHandle buffer = GLBufferHandle::Create(g_ReplayLabel);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.GetName());
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)record.args[1], pData, (GLenum)record.args[2]);
+	GLResourceManager::SetMemory(
+		GLResourceManager::GLRES_BUFFER,
+		buffer.GetName(),
+		MemoryTracker::MEMTAG_SCENE,
+		(size_t)record.args[1]);
+	m_buffers[record.args[0]] = std::move(buffer);
+}
+
+/***********************************************************
+ *  CreateTexture()
+ *
+ *  This method is used for creating a captured texture from
+ *  its level zero pixels.  The other levels are generated
+ *  when the texture was sampled with mipmaps.
+ ***********************************************************/
+void GLReplayer::CreateTexture(const GL_CAPTURE_RECORD& record, const uint8_t* pData)
+{
+	GLsizei width = (GLsizei)record.args[1];
+	GLsizei height = (GLsizei)record.args[2];
+	GLint minFilter = (GLint)record.args[3];
+
+	GLTextureHandle texture = GLTextureHandle::Create(g_ReplayLabel);
+	glBindTexture(GL_TEXTURE_2D, texture.GetName());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pData);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (GLint)record.args[4]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (GLint)(record.args[5] >> 32));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (GLint)(uint32_t)record.args[5]);
+	if ((minFilter != GL_NEAREST) && (minFilter != GL_LINEAR))
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+	GLResourceManager::SetMemory(
+		GLResourceManager::GLRES_TEXTURE,
+		texture.GetName(),
+		MemoryTracker::MEMTAG_TEXTURES,
+		(size_t)width * height * 4);
+	m_textures[record.args[0]] = std::move(texture);
+}
+
+/***********************************************************
+ *  CreateProgram()
+ *
+ *  This method is used for compiling and linking a captured
+ *  program from its shader sources.
+ ***********************************************************/
+void GLReplayer::CreateProgram(const GL_CAPTURE_RECORD& record, const uint8_t* pData)
+{
+	const char* pVertexSource = (const char*)pData;
+	const char* pFragmentSource = pVertexSource + record.args[1];
+
+	GLProgramHandle program = GLProgramHandle::Create(g_ReplayLabel);
+	GLuint vertexShader = g_CompileShader(GL_VERTEX_SHADER, pVertexSource, (GLint)record.args[1]);
+	GLuint fragmentShader = g_CompileShader(GL_FRAGMENT_SHADER, pFragmentSource, (GLint)record.args[2]);
+	glAttachShader(program.GetName(), vertexShader);
+	glAttachShader(program.GetName(), fragmentShader);
+	glLinkProgram(program.GetName());
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint bLinked = GL_FALSE;
+	glGetProgramiv(program.GetName(), GL_LINK_STATUS, &bLinked);
+	if (!bLinked)
+	{
+		GLchar log[512];
+		glGetProgramInfoLog(program.GetName(), sizeof(log), NULL, log);
+		std::cout << "WARNING: captured program " << record.args[0] << " failed to link - " << log << std::endl;
+	}
+	m_programs[record.args[0]] = std::move(program);
+}
+
+/***********************************************************
+ *  SetUniform()
+ *
+ *  This method is used for setting a captured uniform value
+ *  on its replayed program, and remembering its location so
+ *  the frame records can refer to it.
+ ***********************************************************/
+void GLReplayer::SetUniform(const GL_CAPTURE_RECORD& record, const uint8_t* pData)
+{
+	GLuint program = FindProgram(record.args[0]);
+	GLenum type = (GLenum)record.args[2];
+	size_t components = (size_t)record.args[3];
+	const GLchar* pName = (const GLchar*)(pData + components * sizeof(uint32_t));
+
+	GLint location = glGetUniformLocation(program, pName);
+	m_uniformLocations[(record.args[0] << 32) | (uint32_t)record.args[1]] = location;
+
+	glUseProgram(program);
+	switch (type)
+	{
+	case GL_INT:
+	case GL_BOOL:
+	case GL_SAMPLER_2D:
+		glUniform1iv(location, 1, (const GLint*)pData);
+		break;
+	case GL_FLOAT:
+		glUniform1fv(location, 1, (const GLfloat*)pData);
+		break;
+	case GL_FLOAT_VEC2:
+		glUniform2fv(location, 1, (const GLfloat*)pData);
+		break;
+	case GL_FLOAT_VEC3:
+		glUniform3fv(location, 1, (const GLfloat*)pData);
+		break;
+	case GL_FLOAT_VEC4:
+		glUniform4fv(location, 1, (const GLfloat*)pData);
+		break;
+	case GL_FLOAT_MAT4:
+		glUniformMatrix4fv(location, 1, GL_FALSE, (const GLfloat*)pData);
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing one of the basic shape
+ *  meshes the capture recorded by mesh.
+ ***********************************************************/
+void GLReplayer::DrawMesh(uint64_t mesh)
+{
+	switch ((SCENE_MESH)mesh)
+	{
+	case SCENE_MESH_PLANE:
+		m_pMeshes->DrawPlaneMesh();
+		break;
+	case SCENE_MESH_BOX:
+		m_pMeshes->DrawBoxMesh();
+		break;
+	case SCENE_MESH_TORUS:
+		m_pMeshes->DrawTorusMesh();
+		break;
+	case SCENE_MESH_TAPERED_CYLINDER:
+		m_pMeshes->DrawTaperedCylinderMesh();
+		break;
+	case SCENE_MESH_PRISM:
+		m_pMeshes->DrawPrismMesh();
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  FindBuffer() / FindTexture() / FindVertexArray() /
+ *  FindProgram()
+ *
+ *  These methods are used for looking up the replay name of
+ *  a captured object.  An object the capture never created,
+ *  such as one deleted before the capture began, replays as
+ *  no object.
+ ***********************************************************/
+GLuint GLReplayer::FindBuffer(uint64_t captured) const
+{
+	auto found = m_buffers.find(captured);
+	return((found != m_buffers.end()) ? found->second.GetName() : 0);
+}
+
+GLuint GLReplayer::FindTexture(uint64_t captured) const
+{
+	auto found = m_textures.find(captured);
+	return((found != m_textures.end()) ? found->second.GetName() : 0);
+}
+
+GLuint GLReplayer::FindVertexArray(uint64_t captured) const
+{
+	auto found = m_vertexArrays.find(captured);
+	return((found != m_vertexArrays.end()) ? found->second.GetName() : 0);
+}
+
+GLuint GLReplayer::FindProgram(uint64_t captured) const
+{
+	auto found = m_programs.find(captured);
+	return((found != m_programs.end()) ? found->second.GetName() : 0);
+}
+
+/***********************************************************
+ *  FindLocation()
+ *
+ *  This method is used for looking up the replay location
+ *  of a captured uniform location in the program in use.
+ *  Locations the capture never looked up replay as -1,
+ *  which OpenGL ignores.
+ ***********************************************************/
+GLint GLReplayer::FindLocation(uint64_t captured) const
+{
+	auto found = m_uniformLocations.find((m_currentProgram << 32) | (uint32_t)captured);
+	return((found != m_uniformLocations.end()) ? found->second : -1);
+}
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// glreplayer.h
+// ============
+// re-execute a recorded OpenGL capture in a loop and time its frames
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLCapture.h"
+#include "GLResources.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class ShapeMeshes;
+struct GLFWwindow;
+
+/***********************************************************
+ *  GL_REPLAY_FRAME_STATS
+ *
+ *  Times of one captured frame over every loop of a replay.
+ ***********************************************************/
+struct GL_REPLAY_FRAME_STATS
+{
+	uint32_t records;
+	double minCpuMilliseconds;
+	double medianCpuMilliseconds;
+	double minGpuMilliseconds;
+	double medianGpuMilliseconds;
+};
+
+/***********************************************************
+ *  GLReplayer
+ *
+ *  This class loads a capture written by GLCapture, creates
+ *  the objects its resource records describe, and executes
+ *  its frames in a loop.  Every object is created under a
+ *  new name, so the names in the capture are looked up in
+ *  maps from the captured name to the replay handle.  The
+ *  basic mesh draws are replayed through a ShapeMeshes of
+ *  the replayer's own, since they were recorded by mesh.
+ ***********************************************************/
+class GLReplayer
+{
+public:
+	// constructor
+	GLReplayer();
+	// destructor
+	~GLReplayer();
+
+	// read a capture file - no OpenGL call is made
+	bool Load(const char* filename);
+	// create the captured objects and set the captured state
+	bool CreateResources(ShapeMeshes* pMeshes);
+	// execute one captured frame and return its CPU time
+	double ExecuteFrame(uint32_t frame);
+	// execute every frame the given number of times, timing
+	// each one on the CPU and the GPU
+	bool Run(GLFWwindow* pWindow, uint32_t loopCount);
+	// release every object the replay created
+	void Destroy();
+
+	uint32_t GetFrameCount() const { return m_header.frameCount; }
+	int GetWidth() const { return m_header.width; }
+	int GetHeight() const { return m_header.height; }
+	const std::vector<GL_REPLAY_FRAME_STATS>& GetFrameStats() const { return m_frameStats; }
+
+private:
+	GL_CAPTURE_HEADER m_header;
+	std::vector<uint8_t> m_stream;
+	// stream offset where the frames begin, and where every
+	// frame ends
+	size_t m_resourceEnd;
+	std::vector<size_t> m_frameEnds;
+	std::vector<GL_REPLAY_FRAME_STATS> m_frameStats;
+
+	ShapeMeshes* m_pMeshes;
+	// replay objects by their captured name
+	std::unordered_map<uint64_t, GLBufferHandle> m_buffers;
+	std::unordered_map<uint64_t, GLTextureHandle> m_textures;
+	std::unordered_map<uint64_t, GLVertexArrayHandle> m_vertexArrays;
+	std::unordered_map<uint64_t, GLProgramHandle> m_programs;
+	std::unordered_map<uint64_t, GLsync> m_syncs;
+	// replay uniform locations by captured program and location
+	std::unordered_map<uint64_t, GLint> m_uniformLocations;
+	// captured name of the program in use
+	uint64_t m_currentProgram;
+
+	// execute the records between two stream offsets
+	void ExecuteRange(size_t begin, size_t end);
+	// execute one record
+	void Execute(const GL_CAPTURE_RECORD& record, const uint8_t* pData);
+	// resource records
+	void CreateBuffer(const GL_CAPTURE_RECORD& record, const uint8_t* pData);
+	void CreateTexture(const GL_CAPTURE_RECORD& record, const uint8_t* pData);
+	void CreateProgram(const GL_CAPTURE_RECORD& record, const uint8_t* pData);
+	void SetUniform(const GL_CAPTURE_RECORD& record, const uint8_t* pData);
+	void DrawMesh(uint64_t mesh);
+
+	// replay names of captured names - zero stays zero
+	GLuint FindBuffer(uint64_t captured) const;
+	GLuint FindTexture(uint64_t captured) const;
+	GLuint FindVertexArray(uint64_t captured) const;
+	GLuint FindProgram(uint64_t captured) const;
+	// replay location of a location in the program in use
+	GLint FindLocation(uint64_t captured) const;
+};
@@ -0,0 +1,470 @@
+///////////////////////////////////////////////////////////////////////////////
+// glresources.cpp
+// ============
+// manage the lifetime of OpenGL objects with deferred deletion
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLResources.h"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+// declaration of global variables
+namespace
+{
+	// registry entry for one live OpenGL object
+	struct RESOURCE_RECORD
+	{
+		std::string label;
+		uint64_t createdFrame;
+		MemoryTracker::MEMORY_TAG memoryTag;
+		size_t byteSize;
+	};
+
+	// object waiting for the GPU to finish with it
+	struct PENDING_DELETE
+	{
+		GLResourceManager::GL_RESOURCE_TYPE type;
+		GLuint name;
+		uint64_t releasedFrame;
+		MemoryTracker::MEMORY_TAG memoryTag;
+		size_t byteSize;
+	};
+
+	// fence inserted at the end of a frame
+	struct FRAME_FENCE
+	{
+		GLsync fence;
+		uint64_t frameIndex;
+	};
+
+	const char* g_TypeNames[GLResourceManager::GLRES_COUNT] =
+	{
+		"texture",
+		"buffer",
+		"vertex array",
+		"program",
+		"framebuffer",
+		"renderbuffer"
+	};
+
+	// handles may be released from worker threads, so the
+	// registry and the deletion queue are guarded
+	std::mutex g_RegistryMutex;
+	std::unordered_map<GLuint, RESOURCE_RECORD> g_Registry[GLResourceManager::GLRES_COUNT];
+	std::vector<PENDING_DELETE> g_PendingDeletes;
+	std::deque<FRAME_FENCE> g_FrameFences;
+	uint64_t g_FrameIndex = 0;
+
+	// the objects created while AdoptNewObjects() runs its code,
+	// and the entry points the recording wrappers pass calls on to
+	std::vector<GLuint> g_CreatedBuffers;
+	std::vector<GLuint> g_CreatedVertexArrays;
+	PFNGLGENBUFFERSPROC g_pGenBuffers = NULL;
+	PFNGLGENVERTEXARRAYSPROC g_pGenVertexArrays = NULL;
+
+	void GLAPIENTRY RecordGenBuffers(GLsizei n, GLuint* buffers)
+	{
+		g_pGenBuffers(n, buffers);
+		g_CreatedBuffers.insert(g_CreatedBuffers.end(), buffers, buffers + n);
+	}
+
+	void GLAPIENTRY RecordGenVertexArrays(GLsizei n, GLuint* arrays)
+	{
+		g_pGenVertexArrays(n, arrays);
+		g_CreatedVertexArrays.insert(g_CreatedVertexArrays.end(), arrays, arrays + n);
+	}
+
+	// delete one object with the call matching its type
+	void DeleteObject(const PENDING_DELETE& pending)
+	{
+		switch (pending.type)
+		{
+		case GLResourceManager::GLRES_TEXTURE:
+			glDeleteTextures(1, &pending.name);
+			break;
+		case GLResourceManager::GLRES_BUFFER:
+			glDeleteBuffers(1, &pending.name);
+			break;
+		case GLResourceManager::GLRES_VERTEX_ARRAY:
+			glDeleteVertexArrays(1, &pending.name);
+			break;
+		case GLResourceManager::GLRES_PROGRAM:
+			glDeleteProgram(pending.name);
+			break;
+		case GLResourceManager::GLRES_FRAMEBUFFER:
+			glDeleteFramebuffers(1, &pending.name);
+			break;
+		case GLResourceManager::GLRES_RENDERBUFFER:
+			glDeleteRenderbuffers(1, &pending.name);
+			break;
+		default:
+			break;
+		}
+
+		if (pending.byteSize > 0)
+		{
+			MemoryTracker::RecordFree(pending.memoryTag, MemoryTracker::POOL_GPU, pending.byteSize);
+		}
+	}
+
+	// delete the pending objects released on or before the frame
+	void DeleteCompleted(uint64_t completedFrame)
+	{
+		size_t kept = 0;
+		for (size_t i = 0; i < g_PendingDeletes.size(); i++)
+		{
+			if (g_PendingDeletes[i].releasedFrame <= completedFrame)
+			{
+				DeleteObject(g_PendingDeletes[i]);
+			}
+			else
+			{
+				g_PendingDeletes[kept++] = g_PendingDeletes[i];
+			}
+		}
+		g_PendingDeletes.resize(kept);
+	}
+}
+
+/***********************************************************
+ *  Register()
+ *
+ *  This method is used for adding a newly created OpenGL
+ *  object to the live resource registry.
+ ***********************************************************/
+void GLResourceManager::Register(GL_RESOURCE_TYPE type, GLuint name, const std::string& label)
+{
+	if (name == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+	RESOURCE_RECORD record;
+	record.label = label;
+	record.createdFrame = g_FrameIndex;
+	record.memoryTag = MemoryTracker::MEMTAG_COUNT;
+	record.byteSize = 0;
+	g_Registry[type][name] = record;
+}
+
+/***********************************************************
+ *  SetMemory()
+ *
+ *  This method is used for charging the GPU memory used by
+ *  a registered object.  The memory is returned when the
+ *  object is actually deleted.
+ ***********************************************************/
+void GLResourceManager::SetMemory(GL_RESOURCE_TYPE type, GLuint name, MemoryTracker::MEMORY_TAG tag, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+	auto found = g_Registry[type].find(name);
+	if (found == g_Registry[type].end())
+	{
+		return;
+	}
+
+	// return any previously charged size before charging the new one
+	if (found->second.byteSize > 0)
+	{
+		MemoryTracker::RecordFree(found->second.memoryTag, MemoryTracker::POOL_GPU, found->second.byteSize);
+	}
+	found->second.memoryTag = tag;
+	found->second.byteSize = bytes;
+	MemoryTracker::RecordAllocation(tag, MemoryTracker::POOL_GPU, bytes);
+}
+
+/***********************************************************
+ *  SetProgramMemory()
+ *
+ *  This method is used for charging the memory of a linked
+ *  program.  The binary length is only reported for programs
+ *  linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT, which the
+ *  shader manager does not set, so otherwise the size of the
+ *  source files stands in for it.
+ ***********************************************************/
+void GLResourceManager::SetProgramMemory(GLuint program, MemoryTracker::MEMORY_TAG tag, const std::vector<const char*>& sourceFiles)
+{
+	GLint binaryBytes = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryBytes);
+
+	size_t bytes = (binaryBytes > 0) ? (size_t)binaryBytes : 0;
+	if (bytes == 0)
+	{
+		for (const char* filename : sourceFiles)
+		{
+			std::ifstream file(filename, std::ios::binary | std::ios::ate);
+			if (file.is_open())
+			{
+				bytes += (size_t)file.tellg();
+			}
+		}
+	}
+
+	SetMemory(GLRES_PROGRAM, program, tag, bytes);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for removing an object from the live
+ *  registry and queueing it for deletion once the GPU has
+ *  finished the current frame.
+ ***********************************************************/
+void GLResourceManager::Release(GL_RESOURCE_TYPE type, GLuint name)
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+	PENDING_DELETE pending;
+	pending.type = type;
+	pending.name = name;
+	pending.releasedFrame = g_FrameIndex;
+	pending.memoryTag = MemoryTracker::MEMTAG_COUNT;
+	pending.byteSize = 0;
+
+	auto found = g_Registry[type].find(name);
+	if (found != g_Registry[type].end())
+	{
+		pending.memoryTag = found->second.memoryTag;
+		pending.byteSize = found->second.byteSize;
+		g_Registry[type].erase(found);
+	}
+
+	g_PendingDeletes.push_back(pending);
+}
+
+/***********************************************************
+ *  AdoptNewObjects()
+ *
+ *  This method is used for running code that creates
+ *  buffers and vertex arrays without a handle, registering
+ *  exactly the objects it created under the passed in label
+ *  and charging the buffer sizes to the passed in memory
+ *  tag.  The GLEW entry points are swapped for recording
+ *  wrappers while the code runs, the same way the call
+ *  interceptor wraps them, and put back afterwards.
+ ***********************************************************/
+void GLResourceManager::AdoptNewObjects(
+	const std::string& label,
+	MemoryTracker::MEMORY_TAG tag,
+	const std::function<void()>& create,
+	std::vector<GLuint>& buffers,
+	std::vector<GLuint>& vertexArrays)
+{
+	buffers.clear();
+	vertexArrays.clear();
+	g_CreatedBuffers.clear();
+	g_CreatedVertexArrays.clear();
+
+	// the wrappers pass the calls on to whatever was installed,
+	// which may be the call interceptor
+	g_pGenBuffers = __glewGenBuffers;
+	g_pGenVertexArrays = __glewGenVertexArrays;
+	__glewGenBuffers = RecordGenBuffers;
+	__glewGenVertexArrays = RecordGenVertexArrays;
+	create();
+	__glewGenBuffers = g_pGenBuffers;
+	__glewGenVertexArrays = g_pGenVertexArrays;
+
+	// the sizes are read through the copy read binding, which
+	// none of the drawing depends on
+	GLint previousBuffer = 0;
+	glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &previousBuffer);
+	for (GLuint name : g_CreatedBuffers)
+	{
+		GLint bufferSize = 0;
+		glBindBuffer(GL_COPY_READ_BUFFER, name);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &bufferSize);
+
+		Register(GLRES_BUFFER, name, label);
+		SetMemory(GLRES_BUFFER, name, tag, (size_t)bufferSize);
+		buffers.push_back(name);
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, (GLuint)previousBuffer);
+
+	for (GLuint name : g_CreatedVertexArrays)
+	{
+		Register(GLRES_VERTEX_ARRAY, name, label);
+		vertexArrays.push_back(name);
+	}
+
+	g_CreatedBuffers.clear();
+	g_CreatedVertexArrays.clear();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for fencing the end of the current
+ *  frame and deleting the released objects from any frames
+ *  the GPU has already completed.  It must be called on
+ *  the thread owning the OpenGL context.
+ ***********************************************************/
+void GLResourceManager::EndFrame()
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+	FRAME_FENCE frameFence;
+	frameFence.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frameFence.frameIndex = g_FrameIndex;
+	g_FrameFences.push_back(frameFence);
+	g_FrameIndex++;
+
+	// poll the oldest fences without blocking the render thread
+	uint64_t completedFrame = 0;
+	bool bCompleted = false;
+	while (!g_FrameFences.empty())
+	{
+		GLenum result = glClientWaitSync(g_FrameFences.front().fence, 0, 0);
+		if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+		{
+			break;
+		}
+		completedFrame = g_FrameFences.front().frameIndex;
+		bCompleted = true;
+		glDeleteSync(g_FrameFences.front().fence);
+		g_FrameFences.pop_front();
+	}
+
+	if (bCompleted)
+	{
+		DeleteCompleted(completedFrame);
+	}
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for waiting until the GPU is idle,
+ *  deleting every pending object and reporting and freeing
+ *  any objects that are still live.
+ ***********************************************************/
+void GLResourceManager::Shutdown()
+{
+	glFinish();
+
+	ReportLiveResources();
+
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+	while (!g_FrameFences.empty())
+	{
+		glDeleteSync(g_FrameFences.front().fence);
+		g_FrameFences.pop_front();
+	}
+
+	// anything still registered was leaked by its owner
+	for (int type = 0; type < GLRES_COUNT; type++)
+	{
+		for (auto& entry : g_Registry[type])
+		{
+			PENDING_DELETE pending;
+			pending.type = (GL_RESOURCE_TYPE)type;
+			pending.name = entry.first;
+			pending.releasedFrame = g_FrameIndex;
+			pending.memoryTag = entry.second.memoryTag;
+			pending.byteSize = entry.second.byteSize;
+			g_PendingDeletes.push_back(pending);
+		}
+		g_Registry[type].clear();
+	}
+
+	DeleteCompleted(g_FrameIndex);
+}
+
+/***********************************************************
+ *  GetLiveCount()
+ *
+ *  This method is used for getting the number of live
+ *  objects of the passed in type.
+ ***********************************************************/
+uint32_t GLResourceManager::GetLiveCount(GL_RESOURCE_TYPE type)
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	return((uint32_t)g_Registry[type].size());
+}
+
+/***********************************************************
+ *  GetLiveNames()
+ *
+ *  This method is used for getting the names of the live
+ *  objects of the passed in type, in ascending order.
+ ***********************************************************/
+void GLResourceManager::GetLiveNames(GL_RESOURCE_TYPE type, std::vector<GLuint>& names)
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	names.clear();
+	for (auto& entry : g_Registry[type])
+	{
+		names.push_back(entry.first);
+	}
+	std::sort(names.begin(), names.end());
+}
+
+/***********************************************************
+ *  GetPendingCount()
+ *
+ *  This method is used for getting the number of released
+ *  objects that are still waiting for the GPU.
+ ***********************************************************/
+uint32_t GLResourceManager::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	return((uint32_t)g_PendingDeletes.size());
+}
+
+/***********************************************************
+ *  GetFrameIndex()
+ *
+ *  This method is used for getting the index of the frame
+ *  currently being recorded.
+ ***********************************************************/
+uint64_t GLResourceManager::GetFrameIndex()
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	return(g_FrameIndex);
+}
+
+/***********************************************************
+ *  GetTypeName()
+ *
+ *  This method is used for getting the display name of the
+ *  passed in resource type.
+ ***********************************************************/
+const char* GLResourceManager::GetTypeName(GL_RESOURCE_TYPE type)
+{
+	if ((type < 0) || (type >= GLRES_COUNT))
+	{
+		return("unknown");
+	}
+	return(g_TypeNames[type]);
+}
+
+/***********************************************************
+ *  ReportLiveResources()
+ *
+ *  This method is used for listing every object that is
+ *  still in the live registry.
+ ***********************************************************/
+void GLResourceManager::ReportLiveResources()
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+	for (int type = 0; type < GLRES_COUNT; type++)
+	{
+		for (auto& entry : g_Registry[type])
+		{
+			std::cout << "WARNING: live " << g_TypeNames[type] << " " << entry.first
+				<< " (" << entry.second.label << ") created in frame "
+				<< entry.second.createdFrame << std::endl;
+		}
+	}
+}
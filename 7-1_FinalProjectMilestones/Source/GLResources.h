@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////////
+// glresources.h
+// ============
+// manage the lifetime of OpenGL objects with deferred deletion
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MemoryTracker.h"
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  GLResourceManager
+ *
+ *  This class keeps a registry of every live OpenGL object
+ *  and defers the deletion of released objects until a
+ *  fence shows the GPU has finished the frames using them.
+ ***********************************************************/
+class GLResourceManager
+{
+public:
+	// kinds of OpenGL objects that are tracked
+	enum GL_RESOURCE_TYPE
+	{
+		GLRES_TEXTURE = 0,
+		GLRES_BUFFER,
+		GLRES_VERTEX_ARRAY,
+		GLRES_PROGRAM,
+		GLRES_FRAMEBUFFER,
+		GLRES_RENDERBUFFER,
+		GLRES_COUNT
+	};
+
+	// add a newly created object to the live registry
+	static void Register(GL_RESOURCE_TYPE type, GLuint name, const std::string& label);
+	// charge the GPU memory used by a registered object
+	static void SetMemory(GL_RESOURCE_TYPE type, GLuint name, MemoryTracker::MEMORY_TAG tag, size_t bytes);
+	// charge a registered program the size of its binary, or of
+	// its source files when the driver does not report one
+	static void SetProgramMemory(GLuint program, MemoryTracker::MEMORY_TAG tag, const std::vector<const char*>& sourceFiles);
+	// remove an object from the registry and queue it for deletion
+	static void Release(GL_RESOURCE_TYPE type, GLuint name);
+
+	// run code creating buffers and vertex arrays outside of the
+	// handles, such as the ShapeMeshes Load methods, then register
+	// the objects it created and return their names
+	static void AdoptNewObjects(
+		const std::string& label,
+		MemoryTracker::MEMORY_TAG tag,
+		const std::function<void()>& create,
+		std::vector<GLuint>& buffers,
+		std::vector<GLuint>& vertexArrays);
+
+	// fence the end of the current frame and delete any released
+	// objects that the GPU has finished with
+	static void EndFrame();
+	// wait for the GPU, delete everything still pending and report
+	// any objects that were never released
+	static void Shutdown();
+
+	// registry queries
+	static uint32_t GetLiveCount(GL_RESOURCE_TYPE type);
+	static void GetLiveNames(GL_RESOURCE_TYPE type, std::vector<GLuint>& names);
+	static uint32_t GetPendingCount();
+	static uint64_t GetFrameIndex();
+	static const char* GetTypeName(GL_RESOURCE_TYPE type);
+	static void ReportLiveResources();
+};
+
+/***********************************************************
+ *  GLHandle
+ *
+ *  Move-only owner of one OpenGL object.  The object is
+ *  registered when created and handed to the deferred
+ *  deletion queue when the handle is reset or destroyed.
+ ***********************************************************/
+template <GLResourceManager::GL_RESOURCE_TYPE TYPE>
+class GLHandle
+{
+public:
+	GLHandle() : m_name(0) {}
+	~GLHandle() { Reset(); }
+
+	GLHandle(const GLHandle&) = delete;
+	GLHandle& operator=(const GLHandle&) = delete;
+
+	GLHandle(GLHandle&& other) noexcept : m_name(other.m_name) { other.m_name = 0; }
+	GLHandle& operator=(GLHandle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Reset();
+			m_name = other.m_name;
+			other.m_name = 0;
+		}
+		return(*this);
+	}
+
+	// create a new OpenGL object of this handle's type
+	static GLHandle Create(const std::string& label)
+	{
+		GLHandle handle;
+		switch (TYPE)
+		{
+		case GLResourceManager::GLRES_TEXTURE:
+			glGenTextures(1, &handle.m_name);
+			break;
+		case GLResourceManager::GLRES_BUFFER:
+			glGenBuffers(1, &handle.m_name);
+			break;
+		case GLResourceManager::GLRES_VERTEX_ARRAY:
+			glGenVertexArrays(1, &handle.m_name);
+			break;
+		case GLResourceManager::GLRES_PROGRAM:
+			handle.m_name = glCreateProgram();
+			break;
+		case GLResourceManager::GLRES_FRAMEBUFFER:
+			glGenFramebuffers(1, &handle.m_name);
+			break;
+		case GLResourceManager::GLRES_RENDERBUFFER:
+			glGenRenderbuffers(1, &handle.m_name);
+			break;
+		default:
+			break;
+		}
+		GLResourceManager::Register(TYPE, handle.m_name, label);
+		return(handle);
+	}
+
+	// take ownership of an object created elsewhere
+	static GLHandle Adopt(GLuint name, const std::string& label)
+	{
+		GLHandle handle;
+		handle.m_name = name;
+		GLResourceManager::Register(TYPE, name, label);
+		return(handle);
+	}
+
+	// wrap an object that has already been registered
+	static GLHandle AdoptRegistered(GLuint name)
+	{
+		GLHandle handle;
+		handle.m_name = name;
+		return(handle);
+	}
+
+	// release the object for deferred deletion
+	void Reset()
+	{
+		if (m_name != 0)
+		{
+			GLResourceManager::Release(TYPE, m_name);
+			m_name = 0;
+		}
+	}
+
+	GLuint GetName() const { return m_name; }
+	bool IsValid() const { return m_name != 0; }
+
+private:
+	GLuint m_name;
+};
+
+typedef GLHandle<GLResourceManager::GLRES_TEXTURE> GLTextureHandle;
+typedef GLHandle<GLResourceManager::GLRES_BUFFER> GLBufferHandle;
+typedef GLHandle<GLResourceManager::GLRES_VERTEX_ARRAY> GLVertexArrayHandle;
+typedef GLHandle<GLResourceManager::GLRES_PROGRAM> GLProgramHandle;
+typedef GLHandle<GLResourceManager::GLRES_FRAMEBUFFER> GLFramebufferHandle;
+typedef GLHandle<GLResourceManager::GLRES_RENDERBUFFER> GLRenderbufferHandle;
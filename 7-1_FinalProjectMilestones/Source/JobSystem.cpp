@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// run small jobs across a pool of worker threads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+#include "Metrics.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	struct QUEUED_JOB
+	{
+		std::function<void()> function;
+		JobCounterPtr counter;
+	};
+
+	std::mutex g_QueueMutex;
+	std::condition_variable g_QueueSignal;
+	std::deque<QUEUED_JOB> g_JobQueue;
+	std::vector<std::thread> g_Workers;
+	bool g_bStopping = false;
+
+	// run one job and mark it finished on its counter
+	void RunJob(QUEUED_JOB& job)
+	{
+		static MetricCounter* s_pJobs = Metrics::GetCounter(
+			"shrine_jobs_total", "Jobs run by the worker threads and the threads waiting on them");
+		job.function();
+		s_pJobs->Add();
+		job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	// take the next queued job without waiting
+	bool TryPopJob(QUEUED_JOB& job)
+	{
+		std::lock_guard<std::mutex> lock(g_QueueMutex);
+		if (g_JobQueue.empty())
+		{
+			return(false);
+		}
+		job = std::move(g_JobQueue.front());
+		g_JobQueue.pop_front();
+		return(true);
+	}
+
+	// main loop of each worker thread
+	void WorkerLoop()
+	{
+		while (true)
+		{
+			QUEUED_JOB job;
+			{
+				std::unique_lock<std::mutex> lock(g_QueueMutex);
+				g_QueueSignal.wait(lock, [] { return g_bStopping || !g_JobQueue.empty(); });
+				if (g_JobQueue.empty())
+				{
+					return;
+				}
+				job = std::move(g_JobQueue.front());
+				g_JobQueue.pop_front();
+			}
+			RunJob(job);
+		}
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for starting the worker threads.
+ ***********************************************************/
+void JobSystem::Initialize(unsigned int workerCount)
+{
+	if (!g_Workers.empty())
+	{
+		return;
+	}
+
+	// leave one core for the thread owning the OpenGL context
+	if (workerCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		workerCount = (cores > 1) ? (cores - 1) : 1;
+	}
+
+	g_bStopping = false;
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		g_Workers.push_back(std::thread(WorkerLoop));
+	}
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for letting the workers finish the
+ *  queued jobs and then stopping them.
+ ***********************************************************/
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(g_QueueMutex);
+		g_bStopping = true;
+	}
+	g_QueueSignal.notify_all();
+
+	for (std::thread& worker : g_Workers)
+	{
+		worker.join();
+	}
+	g_Workers.clear();
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for queueing a job.  If the worker
+ *  threads were never started the job is run right away.
+ ***********************************************************/
+JobCounterPtr JobSystem::Submit(std::function<void()> job, JobCounterPtr counter)
+{
+	if (!counter)
+	{
+		counter = std::make_shared<JobCounter>();
+	}
+	counter->pending.fetch_add(1, std::memory_order_acq_rel);
+
+	QUEUED_JOB queued;
+	queued.function = std::move(job);
+	queued.counter = counter;
+
+	if (g_Workers.empty())
+	{
+		RunJob(queued);
+		return(counter);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(g_QueueMutex);
+		g_JobQueue.push_back(std::move(queued));
+	}
+	g_QueueSignal.notify_one();
+
+	return(counter);
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used for waiting until every job tracked
+ *  by the counter has finished, running queued jobs on the
+ *  calling thread in the meantime.
+ ***********************************************************/
+void JobSystem::Wait(const JobCounterPtr& counter)
+{
+	if (!counter)
+	{
+		return;
+	}
+
+	while (counter->pending.load(std::memory_order_acquire) > 0)
+	{
+		QUEUED_JOB job;
+		if (TryPopJob(job))
+		{
+			RunJob(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for running the function over the
+ *  range in batches spread across the worker threads.
+ ***********************************************************/
+void JobSystem::ParallelFor(
+	size_t count,
+	size_t batchSize,
+	const std::function<void(size_t begin, size_t end)>& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (batchSize == 0)
+	{
+		batchSize = 1;
+	}
+
+	// small ranges are not worth the queueing overhead
+	if ((count <= batchSize) || g_Workers.empty())
+	{
+		function(0, count);
+		return;
+	}
+
+	JobCounterPtr counter = std::make_shared<JobCounter>();
+	for (size_t begin = batchSize; begin < count; begin += batchSize)
+	{
+		size_t end = (begin + batchSize < count) ? (begin + batchSize) : count;
+		Submit([&function, begin, end]() { function(begin, end); }, counter);
+	}
+
+	// the calling thread takes the first batch itself
+	function(0, batchSize);
+
+	Wait(counter);
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of threads
+ *  that run jobs, counting the calling thread.
+ ***********************************************************/
+unsigned int JobSystem::GetThreadCount()
+{
+	return((unsigned int)g_Workers.size() + 1);
+}
@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// run small jobs across a pool of worker threads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+/***********************************************************
+ *  JobCounter
+ *
+ *  Counts the jobs of one submission that have not finished
+ *  yet.  Waiting on a counter returns once it reaches zero.
+ ***********************************************************/
+struct JobCounter
+{
+	std::atomic<int> pending;
+
+	JobCounter() : pending(0) {}
+};
+
+typedef std::shared_ptr<JobCounter> JobCounterPtr;
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class owns the worker threads and the shared job
+ *  queue.  Threads waiting on a counter help run queued
+ *  jobs instead of blocking, so jobs may submit and wait on
+ *  other jobs.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// start the worker threads - zero uses one per spare core
+	static void Initialize(unsigned int workerCount = 0);
+	// finish the queued jobs and stop the worker threads
+	static void Shutdown();
+
+	// queue a job and return the counter tracking it - passing
+	// an existing counter adds the job to that counter
+	static JobCounterPtr Submit(std::function<void()> job, JobCounterPtr counter = nullptr);
+	// run queued jobs on this thread until the counter is zero
+	static void Wait(const JobCounterPtr& counter);
+
+	// split the range into batches and run them in parallel,
+	// returning once every batch has finished
+	static void ParallelFor(
+		size_t count,
+		size_t batchSize,
+		const std::function<void(size_t begin, size_t end)>& function);
+
+	// number of threads that can run jobs, including the caller
+	static unsigned int GetThreadCount();
+};
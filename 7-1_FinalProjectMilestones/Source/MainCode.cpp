@@ -1,5 +1,12 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -13,6 +20,23 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "MemoryTracker.h"
+#include "GLResources.h"
+#include "SoakMonitor.h"
+#include "SceneFile.h"
+#include "JobSystem.h"
+#include "RegressionSuite.h"
+#include "GLInterceptor.h"
+#include "GLCapture.h"
+#include "GLReplayer.h"
+#include "GLDebug.h"
+#include "FrameRecorder.h"
+#include "BatchRenderer.h"
+#include "PanoramaCapture.h"
+#include "RenderServer.h"
+#include "Metrics.h"
+#include "ModelPack.h"
+#include "StartupGraph.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,12 +53,86 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+
+	// file the memory totals are periodically written into
+	const char* const MEMORY_REPORT_FILE = "memory_report.json";
+	// seconds between memory report dumps
+	const double MEMORY_REPORT_INTERVAL = 10.0;
+	// seconds between updates of the memory display in the title bar
+	const double MEMORY_HUD_INTERVAL = 0.5;
+
+	// owning handle for the linked shader program
+	GLProgramHandle g_ShaderProgram;
+
+	// soak test monitor - only created when running a soak test
+	SoakMonitor* g_SoakMonitor = nullptr;
+	// file the soak test samples are written into
+	const char* const SOAK_REPORT_FILE = "soak_report.csv";
+	// seconds between soak test samples
+	const double SOAK_SAMPLE_INTERVAL = 60.0;
+
+	// file the golden image regression results are written into
+	const char* const REGRESSION_REPORT_FILE = "regression_report.csv";
+
+	// reads frames back for screenshots and recordings
+	FrameRecorder* g_FrameRecorder = nullptr;
+	// frame rate stored in recordings started from the keyboard
+	const int RECORDING_FRAME_RATE = 60;
+	// screenshot and recording keys, to act once per press
+	bool g_bScreenshotKeyDown = false;
+	bool g_bRecordKeyDown = false;
+
+	// seconds between rewrites of the metrics file
+	const double METRICS_FILE_INTERVAL = 5.0;
+
+	// file the timeline of the startup steps is written into
+	const char* const STARTUP_TIMELINE_FILE = "startup_timeline.json";
+	// shader files read ahead while the window is created, so
+	// the shader manager finds them in the file cache
+	const char* const STARTUP_SHADER_FILES[] =
+	{
+		"Shaders/sceneVertex.glsl",
+		"Shaders/sceneFragment.glsl",
+		"Shaders/particleVertex.glsl",
+		"Shaders/particleFragment.glsl"
+	};
+
+	// a model imported, or a pack mapped, on the job system
+	// during startup and added once the scene is prepared
+	struct STARTUP_MODEL
+	{
+		IMPORTED_MODEL imported;
+		ModelPack pack;
+		bool bLoaded;
+	};
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void LoadSceneShader();
+int RenderSoftwareImage(const char* sceneFilename, const char* imageFilename);
+int RenderReferenceImage(const char* sceneFilename, const char* imageFilename, int sampleCount);
+int RunRegressionSuite(const char* sceneFilename, const char* goldenDirectory, bool bUpdateGolden);
+int ReplayCapture(const char* captureFilename, uint32_t loopCount, const char* glCallReportFilename);
+int RunBatchRender(const char* sceneFilename, const char* posesFilename, const char* outputDirectory, int width, int height);
+int RunPanoramaCapture(const char* sceneFilename, const glm::vec3& center, const char* imageFilename, int width);
+int RunDeviceBenchmark(const char* sceneFilename, int frameCount);
+void BenchmarkRenderDevice(SceneManager* pScene, int frameCount);
+int RunRenderServer(const char* sceneFilename, const char* socketPath);
+int CompileModelPack(const char* modelFilename, const char* packFilename, const std::vector<float>& lodRatios);
+bool StartInteractiveScene(
+	const char* sceneFilename,
+	const std::vector<const char*>& modelFilenames,
+	const std::vector<glm::vec4>& modelPlacements,
+	const std::vector<float>& modelLodRatios,
+	const char* glCallReportFilename);
+void SetMemoryBudgets();
+void UpdateMemoryReport(double currentTime);
+void ProcessRecorderKeys();
+bool StartMetricsExport(int port, const char* filename);
+void UpdateFrameMetrics(double frameSeconds, double renderSeconds);
 
 
 /***********************************************************
@@ -45,39 +143,307 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
-	// if GLFW fails initialization, then terminate the application
-	if (InitializeGLFW() == false)
+	// compiled scene file to render instead of the hand-coded scene
+	const char* sceneFilename = NULL;
+	// image written by a headless software render
+	const char* softwareImageFilename = NULL;
+	// image and samples per pixel of a headless path traced render
+	const char* referenceImageFilename = NULL;
+	int referenceSampleCount = 0;
+	// directory of the golden images for a headless regression run
+	const char* goldenDirectory = NULL;
+	bool bUpdateGolden = false;
+	// report of the OpenGL calls of every frame, when counting them
+	const char* glCallReportFilename = NULL;
+	// file and frame count of an OpenGL capture to record
+	const char* captureFilename = NULL;
+	uint32_t captureFrameCount = 0;
+	// OpenGL capture to replay instead of the scene, and how
+	// many times its frames are replayed
+	const char* replayFilename = NULL;
+	uint32_t replayLoopCount = 0;
+	// recording written from the first frame, and its frame rate
+	const char* recordingFilename = NULL;
+	int recordingFrameRate = RECORDING_FRAME_RATE;
+	// camera poses rendered into images headlessly, where the
+	// images go and their size
+	const char* batchPosesFilename = NULL;
+	const char* batchOutputDirectory = NULL;
+	int batchWidth = 0;
+	int batchHeight = 0;
+	// point a 360 degree panorama is captured from, its image
+	// and its width
+	glm::vec3 panoramaCenter(0.0f);
+	const char* panoramaFilename = NULL;
+	int panoramaWidth = 0;
+	// frames rendered through each render device when comparing them
+	int benchmarkFrameCount = 0;
+	// socket a render server listens on
+	const char* serverSocketPath = NULL;
+	// loopback port and file the metrics are exported on
+	int metricsPort = 0;
+	const char* metricsFilename = NULL;
+	// models added to the interactive scene, and where each goes
+	std::vector<const char*> modelFilenames;
+	std::vector<glm::vec4> modelPlacements;
+	// fraction of the triangles each level of detail of the
+	// models keeps
+	std::vector<float> modelLodRatios = MESH_DEFAULT_LOD_RATIOS;
+	// scene description compiled into its binary form
+	const char* compileSceneFilename = NULL;
+	const char* compileBinaryFilename = NULL;
+	const char* compileModelFilename = NULL;
+	const char* compilePackFilename = NULL;
+
+	for (int i = 1; i < argc; i++)
 	{
-		return(EXIT_FAILURE);
+		// --soak <hours> runs the scene for the given number of hours
+		// and reports any resource counts that keep growing
+		if ((strcmp(argv[i], "--soak") == 0) && (i + 1 < argc))
+		{
+			g_SoakMonitor = new SoakMonitor(atof(argv[++i]), SOAK_SAMPLE_INTERVAL);
+		}
+		// --compile-scene <text> <binary> compiles a scene description
+		// into its memory-mappable form and exits
+		else if ((strcmp(argv[i], "--compile-scene") == 0) && (i + 2 < argc))
+		{
+			compileSceneFilename = argv[i + 1];
+			compileBinaryFilename = argv[i + 2];
+			i += 2;
+		}
+		// --compile-model <model> <pack> imports a model with its
+		// levels of detail, writes it into a model pack and exits
+		else if ((strcmp(argv[i], "--compile-model") == 0) && (i + 2 < argc))
+		{
+			compileModelFilename = argv[i + 1];
+			compilePackFilename = argv[i + 2];
+			i += 2;
+		}
+		// --scene <binary> renders a compiled scene file
+		else if ((strcmp(argv[i], "--scene") == 0) && (i + 1 < argc))
+		{
+			sceneFilename = argv[++i];
+		}
+		// --software-render <image> renders one frame with the CPU
+		// rasterizer, without a window or OpenGL, into a PPM image
+		else if ((strcmp(argv[i], "--software-render") == 0) && (i + 1 < argc))
+		{
+			softwareImageFilename = argv[++i];
+		}
+		// --path-trace <image> <samples> renders a reference image
+		// with the CPU path tracer and reports its ray throughput -
+		// without --scene, the hand-coded shrine is lit by its four
+		// lights with its materials, which the other renderers leave
+		// off, so the reference is not an image of their scene
+		else if ((strcmp(argv[i], "--path-trace") == 0) && (i + 2 < argc))
+		{
+			referenceImageFilename = argv[i + 1];
+			referenceSampleCount = atoi(argv[i + 2]);
+			i += 2;
+		}
+		// --golden-test <directory> renders the fixed regression
+		// views and compares them with the golden images there -
+		// the project keeps its golden images in Tests/Golden
+		else if ((strcmp(argv[i], "--golden-test") == 0) && (i + 1 < argc))
+		{
+			goldenDirectory = argv[++i];
+		}
+		// --update-golden replaces the golden images and frame time
+		// baselines instead of comparing against them
+		else if (strcmp(argv[i], "--update-golden") == 0)
+		{
+			bUpdateGolden = true;
+		}
+		// --gl-calls <report> counts the OpenGL calls of every frame,
+		// flags the redundant binds and uniform sets, and writes
+		// them into a report
+		else if ((strcmp(argv[i], "--gl-calls") == 0) && (i + 1 < argc))
+		{
+			glCallReportFilename = argv[++i];
+		}
+		// --gl-capture <file> <frames> records the OpenGL calls of
+		// the first frames, with the objects they use, into a file
+		else if ((strcmp(argv[i], "--gl-capture") == 0) && (i + 2 < argc))
+		{
+			captureFilename = argv[i + 1];
+			captureFrameCount = (uint32_t)std::max(atoi(argv[i + 2]), 1);
+			i += 2;
+		}
+		// --replay <file> <loops> replays a capture in a loop with
+		// nothing else running, and reports its frame times
+		else if ((strcmp(argv[i], "--replay") == 0) && (i + 2 < argc))
+		{
+			replayFilename = argv[i + 1];
+			replayLoopCount = (uint32_t)std::max(atoi(argv[i + 2]), 1);
+			i += 2;
+		}
+		// --record <file> <fps> writes every frame into a raw Y4M
+		// video, read back and encoded without stalling the frame
+		else if ((strcmp(argv[i], "--record") == 0) && (i + 2 < argc))
+		{
+			recordingFilename = argv[i + 1];
+			recordingFrameRate = std::max(atoi(argv[i + 2]), 1);
+			i += 2;
+		}
+		// --batch-render <poses> <directory> <width> <height> renders
+		// every camera pose in a file into its own image, with no
+		// visible window, and reports the images per second
+		else if ((strcmp(argv[i], "--batch-render") == 0) && (i + 4 < argc))
+		{
+			batchPosesFilename = argv[i + 1];
+			batchOutputDirectory = argv[i + 2];
+			batchWidth = std::max(atoi(argv[i + 3]), 1);
+			batchHeight = std::max(atoi(argv[i + 4]), 1);
+			i += 4;
+		}
+		// --panorama <x> <y> <z> <image> <width> renders the scene
+		// in every direction from a point, in one layered pass,
+		// into an equirectangular image
+		else if ((strcmp(argv[i], "--panorama") == 0) && (i + 5 < argc))
+		{
+			panoramaCenter = glm::vec3(atof(argv[i + 1]), atof(argv[i + 2]), atof(argv[i + 3]));
+			panoramaFilename = argv[i + 4];
+			panoramaWidth = std::max(atoi(argv[i + 5]), 4);
+			i += 5;
+		}
+		// --benchmark-devices <frames> renders the same frames of the
+		// scene through the OpenGL and the software render devices
+		// and reports the timings of each
+		else if ((strcmp(argv[i], "--benchmark-devices") == 0) && (i + 1 < argc))
+		{
+			benchmarkFrameCount = std::max(atoi(argv[++i]), 1);
+		}
+		// --serve <socket> keeps the scene loaded and renders views
+		// of it for other local processes until one of them asks
+		// the server to shut down
+		else if ((strcmp(argv[i], "--serve") == 0) && (i + 1 < argc))
+		{
+			serverSocketPath = argv[++i];
+		}
+		// --metrics-port <port> answers GET /metrics on the loopback
+		// address with the metrics in the Prometheus text format
+		else if ((strcmp(argv[i], "--metrics-port") == 0) && (i + 1 < argc))
+		{
+			metricsPort = atoi(argv[++i]);
+		}
+		// --metrics-file <file> rewrites the file with the metrics
+		// every few seconds, for a scraper that reads files
+		else if ((strcmp(argv[i], "--metrics-file") == 0) && (i + 1 < argc))
+		{
+			metricsFilename = argv[++i];
+		}
+		// --model <file> <x> <y> <z> <scale> imports a glTF or OBJ
+		// model, or a model pack, and places it in the scene - may
+		// be repeated
+		else if ((strcmp(argv[i], "--model") == 0) && (i + 5 < argc))
+		{
+			modelFilenames.push_back(argv[i + 1]);
+			modelPlacements.push_back(glm::vec4(atof(argv[i + 2]), atof(argv[i + 3]), atof(argv[i + 4]), atof(argv[i + 5])));
+			i += 5;
+		}
+		// --lod-ratios <r1,r2,...> sets the fraction of the triangles
+		// kept by each level of detail of the models, or "none"
+		else if ((strcmp(argv[i], "--lod-ratios") == 0) && (i + 1 < argc))
+		{
+			modelLodRatios.clear();
+			for (const char* pRatio = argv[++i]; (NULL != pRatio) && (*pRatio != '\0'); pRatio = strchr(pRatio, ','))
+			{
+				pRatio += (*pRatio == ',') ? 1 : 0;
+				float ratio = (float)atof(pRatio);
+				if ((ratio > 0.0f) && (ratio < 1.0f))
+				{
+					modelLodRatios.push_back(ratio);
+				}
+			}
+		}
 	}
 
-	// try to create a new shader manager object
-	g_ShaderManager = new ShaderManager();
-	// try to create a new view manager object
-	g_ViewManager = new ViewManager(
-		g_ShaderManager);
+	if (NULL != compileSceneFilename)
+	{
+		bool bCompiled = SceneCompiler::Compile(compileSceneFilename, compileBinaryFilename);
+		return(bCompiled ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	if (NULL != compileModelFilename)
+	{
+		return(CompileModelPack(compileModelFilename, compilePackFilename, modelLodRatios));
+	}
+	if (NULL != softwareImageFilename)
+	{
+		return(RenderSoftwareImage(sceneFilename, softwareImageFilename));
+	}
+	if (NULL != referenceImageFilename)
+	{
+		return(RenderReferenceImage(sceneFilename, referenceImageFilename, referenceSampleCount));
+	}
+	if (NULL != goldenDirectory)
+	{
+		return(RunRegressionSuite(sceneFilename, goldenDirectory, bUpdateGolden));
+	}
+	if (NULL != replayFilename)
+	{
+		return(ReplayCapture(replayFilename, replayLoopCount, glCallReportFilename));
+	}
+	if (NULL != batchPosesFilename)
+	{
+		return(RunBatchRender(sceneFilename, batchPosesFilename, batchOutputDirectory, batchWidth, batchHeight));
+	}
+	if (NULL != panoramaFilename)
+	{
+		return(RunPanoramaCapture(sceneFilename, panoramaCenter, panoramaFilename, panoramaWidth));
+	}
+	if (benchmarkFrameCount > 0)
+	{
+		return(RunDeviceBenchmark(sceneFilename, benchmarkFrameCount));
+	}
 
-	// try to create the main display window
-	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	// the modes left run for long enough to be watched
+	if (StartMetricsExport(metricsPort, metricsFilename) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+	if (NULL != serverSocketPath)
+	{
+		int result = RunRenderServer(sceneFilename, serverSocketPath);
+		Metrics::Shutdown();
+		return(result);
+	}
 
-	// if GLEW fails initialization, then terminate the application
-	if (InitializeGLEW() == false)
+	// start the worker threads used by the scene systems first,
+	// so the startup steps that need no window run on them while
+	// it is created
+	JobSystem::Initialize();
+	SetMemoryBudgets();
+
+	// if the window, OpenGL or the scene fail to start, then
+	// terminate the application
+	if (StartInteractiveScene(sceneFilename, modelFilenames, modelPlacements, modelLodRatios, glCallReportFilename) == false)
 	{
+		JobSystem::Shutdown();
+		Metrics::Shutdown();
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
-	g_ShaderManager->use();
+	// read back everything loaded so far into the capture, and
+	// record the calls of the first frames after it
+	if (NULL != captureFilename)
+	{
+		GLCapture::Begin(
+			captureFilename,
+			captureFrameCount,
+			ViewManager::GetWindowWidth(),
+			ViewManager::GetWindowHeight());
+	}
 
-	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
-	g_SceneManager->PrepareScene();
+	// F12 takes a screenshot and F10 starts and stops a recording
+	g_FrameRecorder = new FrameRecorder();
+	if (NULL != recordingFilename)
+	{
+		g_FrameRecorder->StartRecording(recordingFilename, recordingFrameRate);
+	}
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
+	double lastFrameTime = glfwGetTime();
 	while (!glfwWindowShouldClose(g_Window))
 	{
 		// Enable z-depth
@@ -86,21 +452,71 @@ int main(int argc, char* argv[])
 		// Clear the frame and z buffers
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		GLCapture::Record(GLCAPTURE_ENABLE, { GL_DEPTH_TEST });
+		GLCapture::Record(GLCAPTURE_CLEAR_COLOR, {
+			GLCapture::FloatBits(0.0f), GLCapture::FloatBits(0.0f),
+			GLCapture::FloatBits(0.0f), GLCapture::FloatBits(1.0f) });
+		GLCapture::Record(GLCAPTURE_CLEAR, { GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT });
 
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
+		g_SceneManager->SetViewProjection(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix());
+		g_SceneManager->SetFrameTime(glfwGetTime());
 
 		// refresh the 3D scene
+		double renderStartTime = glfwGetTime();
 		g_SceneManager->RenderScene();
+		double renderSeconds = glfwGetTime() - renderStartTime;
 
+		// start reading the frame back while it is still in the
+		// back buffer, if a screenshot or recording wants it
+		int framebufferWidth = 0;
+		int framebufferHeight = 0;
+		glfwGetFramebufferSize(g_Window, &framebufferWidth, &framebufferHeight);
+		g_FrameRecorder->EndFrame(framebufferWidth, framebufferHeight);
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
 
 		// query the latest GLFW events
 		glfwPollEvents();
+		ProcessRecorderKeys();
+
+		// delete any released OpenGL objects the GPU is done with
+		GLResourceManager::EndFrame();
+
+		// report the OpenGL calls of the frame, and end the frame
+		// of a capture
+		GLCapture::EndFrame();
+		if (GLInterceptor::IsInstalled())
+		{
+			GLInterceptor::EndFrame();
+		}
+
+		// refresh the memory display and periodic report
+		double currentTime = glfwGetTime();
+		UpdateMemoryReport(currentTime);
+		UpdateFrameMetrics(currentTime - lastFrameTime, renderSeconds);
+		lastFrameTime = currentTime;
+
+		// stop once the soak test has run for long enough
+		if ((NULL != g_SoakMonitor) && (g_SoakMonitor->Update(currentTime) == false))
+		{
+			glfwSetWindowShouldClose(g_Window, true);
+		}
 	}
 
+	// write the final memory totals before shutting down
+	MemoryTracker::WriteJSON(MEMORY_REPORT_FILE);
+	Metrics::Shutdown();
+
+	// finish the screenshots and recordings still being written
+	g_FrameRecorder->Shutdown();
+	delete g_FrameRecorder;
+	g_FrameRecorder = NULL;
+
 	// clear the allocated manager objects from memory
 	if (NULL != g_SceneManager)
 	{
@@ -118,10 +534,574 @@ int main(int argc, char* argv[])
 		g_ShaderManager = NULL;
 	}
 
+	// free every remaining OpenGL object and report any leaks
+	g_ShaderProgram.Reset();
+	GLResourceManager::Shutdown();
+	GLInterceptor::Uninstall();
+	GL_DEBUG_SHUTDOWN();
+
+	JobSystem::Shutdown();
+
+	if (NULL != g_SoakMonitor)
+	{
+		g_SoakMonitor->WriteReport(SOAK_REPORT_FILE);
+		delete g_SoakMonitor;
+		g_SoakMonitor = NULL;
+	}
+
 	// Terminates the program successfully
 	exit(EXIT_SUCCESS); 
 }
 
+/***********************************************************
+ *	RenderSoftwareImage()
+ *
+ *  This function is used to render one frame of the scene
+ *  from the default camera with the software rasterizer and
+ *  write it into an image file.  No window is opened and no
+ *  OpenGL call is made.
+ ***********************************************************/
+int RenderSoftwareImage(const char* sceneFilename, const char* imageFilename)
+{
+	int width = ViewManager::GetWindowWidth();
+	int height = ViewManager::GetWindowHeight();
+
+	JobSystem::Initialize();
+	SetMemoryBudgets();
+
+	g_ViewManager = new ViewManager(NULL);
+	g_SceneManager = new SceneManager(NULL);
+	g_SceneManager->SetRenderBackend(SceneManager::RENDER_BACKEND_SOFTWARE, width, height);
+	if (NULL != sceneFilename)
+	{
+		g_SceneManager->LoadSceneFile(sceneFilename);
+	}
+	g_SceneManager->PrepareScene();
+
+	g_ViewManager->PrepareHeadlessView(width, height);
+	g_SceneManager->SetViewProjection(
+		g_ViewManager->GetViewMatrix(),
+		g_ViewManager->GetProjectionMatrix());
+	g_SceneManager->SetFrameTime(0.0);
+	g_SceneManager->RenderScene();
+
+	SoftwareRasterizer* pRasterizer = g_SceneManager->GetSoftwareRasterizer();
+	const SOFTWARE_RENDER_STATS& stats = pRasterizer->GetStats();
+	std::cout << "INFO: software frame " << width << "x" << height
+		<< " - " << stats.drawCount << " draws, "
+		<< stats.triangleCount << " triangles, "
+		<< stats.binnedTriangles << " binned, "
+		<< stats.geometryMilliseconds << "ms geometry, "
+		<< stats.rasterMilliseconds << "ms raster, "
+		<< stats.totalMilliseconds << "ms total on "
+		<< JobSystem::GetThreadCount() << " threads" << std::endl;
+	bool bWritten = pRasterizer->WriteImage(imageFilename);
+
+	delete g_SceneManager;
+	g_SceneManager = NULL;
+	delete g_ViewManager;
+	g_ViewManager = NULL;
+	JobSystem::Shutdown();
+
+	return(bWritten ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	RenderReferenceImage()
+ *
+ *  This function is used to path trace the scene from the
+ *  default camera until every pixel has the requested
+ *  number of samples, then write the image.  The ray
+ *  throughput of every pass is reported, so the same run
+ *  doubles as a benchmark of the ray traversal code.
+ ***********************************************************/
+int RenderReferenceImage(const char* sceneFilename, const char* imageFilename, int sampleCount)
+{
+	int width = ViewManager::GetWindowWidth();
+	int height = ViewManager::GetWindowHeight();
+	sampleCount = std::max(sampleCount, 1);
+
+	JobSystem::Initialize();
+	SetMemoryBudgets();
+
+	g_ViewManager = new ViewManager(NULL);
+	g_SceneManager = new SceneManager(NULL);
+	g_SceneManager->SetRenderBackend(SceneManager::RENDER_BACKEND_PATH_TRACER, width, height);
+	if (NULL != sceneFilename)
+	{
+		g_SceneManager->LoadSceneFile(sceneFilename);
+	}
+	g_SceneManager->PrepareScene();
+
+	g_ViewManager->PrepareHeadlessView(width, height);
+	g_SceneManager->SetViewProjection(
+		g_ViewManager->GetViewMatrix(),
+		g_ViewManager->GetProjectionMatrix());
+	g_SceneManager->SetFrameTime(0.0);
+
+	PathTracer* pPathTracer = g_SceneManager->GetPathTracer();
+	uint64_t totalRays = 0;
+	double totalMilliseconds = 0.0;
+	while ((int)pPathTracer->GetStats().samplesPerPixel < sampleCount)
+	{
+		g_SceneManager->RenderScene();
+
+		const PATH_TRACE_STATS& stats = pPathTracer->GetStats();
+		totalRays += stats.passRays;
+		totalMilliseconds += stats.passMilliseconds;
+		std::cout << "INFO: path trace pass " << stats.samplesPerPixel << "/" << sampleCount
+			<< " - " << stats.passMilliseconds << "ms, "
+			<< stats.raysPerSecond / 1.0e6 << " Mrays/s" << std::endl;
+	}
+
+	const PATH_TRACE_STATS& stats = pPathTracer->GetStats();
+	std::cout << "INFO: path traced " << width << "x" << height
+		<< " at " << stats.samplesPerPixel << " samples - "
+		<< stats.triangleCount << " triangles, "
+		<< stats.nodeCount << " nodes built in "
+		<< stats.buildMilliseconds << "ms, "
+		<< totalRays << " rays in "
+		<< totalMilliseconds << "ms, "
+		<< ((totalMilliseconds > 0.0) ? totalRays / (totalMilliseconds * 1000.0) : 0.0) << " Mrays/s on "
+		<< JobSystem::GetThreadCount() << " threads" << std::endl;
+	bool bWritten = pPathTracer->WriteImage(imageFilename);
+
+	delete g_SceneManager;
+	g_SceneManager = NULL;
+	delete g_ViewManager;
+	g_ViewManager = NULL;
+	JobSystem::Shutdown();
+
+	return(bWritten ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	RunRegressionSuite()
+ *
+ *  This function is used to render the fixed regression
+ *  views headlessly and compare them with the golden images
+ *  and frame time baselines in a directory.  The exit code
+ *  fails when any view does, so a build script can run it.
+ ***********************************************************/
+int RunRegressionSuite(const char* sceneFilename, const char* goldenDirectory, bool bUpdateGolden)
+{
+	JobSystem::Initialize();
+	SetMemoryBudgets();
+
+	RegressionSuite suite(goldenDirectory, bUpdateGolden);
+	bool bPassed = suite.Run(sceneFilename);
+	suite.WriteReport(REGRESSION_REPORT_FILE);
+
+	size_t failedCount = 0;
+	for (const REGRESSION_RESULT& result : suite.GetResults())
+	{
+		if (!result.bImagePassed || !result.bTimingPassed)
+		{
+			failedCount++;
+		}
+	}
+	std::cout << "INFO: regression suite " << (bPassed ? "passed" : "failed") << " - "
+		<< failedCount << " of " << suite.GetResults().size() << " views failed" << std::endl;
+
+	JobSystem::Shutdown();
+
+	return(bPassed ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	ReplayCapture()
+ *
+ *  This function is used to replay an OpenGL capture in a
+ *  window of the captured size, with no scene, shader
+ *  manager or view manager, so the frame times are those of
+ *  the captured GPU work alone.  Buffer swaps do not wait
+ *  for the display, so they do not hide the frame times.
+ ***********************************************************/
+int ReplayCapture(const char* captureFilename, uint32_t loopCount, const char* glCallReportFilename)
+{
+	GLReplayer replayer;
+	if (!replayer.Load(captureFilename) || (InitializeGLFW() == false))
+	{
+		return(EXIT_FAILURE);
+	}
+
+	g_Window = glfwCreateWindow(replayer.GetWidth(), replayer.GetHeight(), WINDOW_TITLE, NULL, NULL);
+	if (g_Window == NULL)
+	{
+		std::cout << "Failed to create GLFW display window" << std::endl;
+		glfwTerminate();
+		return(EXIT_FAILURE);
+	}
+	glfwMakeContextCurrent(g_Window);
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+	glfwSwapInterval(0);
+	if (NULL != glCallReportFilename)
+	{
+		GLInterceptor::Install(glCallReportFilename);
+	}
+
+	// the basic meshes the capture draws by mesh
+	ShapeMeshes* pMeshes = new ShapeMeshes();
+	auto loadMeshes = [pMeshes]()
+	{
+		pMeshes->LoadPlaneMesh();
+		pMeshes->LoadTorusMesh();
+		pMeshes->LoadBoxMesh();
+		pMeshes->LoadTaperedCylinderMesh();
+		pMeshes->LoadPrismMesh();
+	};
+	std::vector<GLuint> buffers;
+	std::vector<GLuint> vertexArrays;
+	GLResourceManager::AdoptNewObjects("basic meshes", MemoryTracker::MEMTAG_MESHES, loadMeshes, buffers, vertexArrays);
+	std::vector<GLBufferHandle> meshBuffers;
+	std::vector<GLVertexArrayHandle> meshVertexArrays;
+	for (GLuint name : buffers)
+	{
+		meshBuffers.push_back(GLBufferHandle::AdoptRegistered(name));
+	}
+	for (GLuint name : vertexArrays)
+	{
+		meshVertexArrays.push_back(GLVertexArrayHandle::AdoptRegistered(name));
+	}
+
+	bool bReplayed = replayer.CreateResources(pMeshes) && replayer.Run(g_Window, loopCount);
+	replayer.Destroy();
+
+	delete pMeshes;
+	meshBuffers.clear();
+	meshVertexArrays.clear();
+
+	GLResourceManager::Shutdown();
+	GLInterceptor::Uninstall();
+	GL_DEBUG_SHUTDOWN();
+	glfwTerminate();
+
+	return(bReplayed ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	RunBatchRender()
+ *
+ *  This function is used to render a list of camera poses
+ *  into images through OpenGL, in a hidden window, with the
+ *  same scene and shader as the interactive loop.  The exit
+ *  code fails when any image was not written.
+ ***********************************************************/
+int RunBatchRender(const char* sceneFilename, const char* posesFilename, const char* outputDirectory, int width, int height)
+{
+	BatchRenderer batch(width, height);
+	if (!batch.LoadPoses(posesFilename) || (InitializeGLFW() == false))
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the poses render into their own framebuffer, so the
+	// window is never shown and its size does not matter
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	g_Window = glfwCreateWindow(width, height, WINDOW_TITLE, NULL, NULL);
+	if (g_Window == NULL)
+	{
+		std::cout << "Failed to create GLFW display window" << std::endl;
+		glfwTerminate();
+		return(EXIT_FAILURE);
+	}
+	glfwMakeContextCurrent(g_Window);
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	JobSystem::Initialize();
+	g_ShaderManager = new ShaderManager();
+	LoadSceneShader();
+	SetMemoryBudgets();
+
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	if (NULL != sceneFilename)
+	{
+		g_SceneManager->LoadSceneFile(sceneFilename);
+	}
+	g_SceneManager->PrepareScene();
+
+	bool bRendered = batch.Run(g_SceneManager, outputDirectory);
+
+	delete g_SceneManager;
+	g_SceneManager = NULL;
+	delete g_ShaderManager;
+	g_ShaderManager = NULL;
+
+	g_ShaderProgram.Reset();
+	GLResourceManager::Shutdown();
+	GL_DEBUG_SHUTDOWN();
+	JobSystem::Shutdown();
+	glfwTerminate();
+
+	return(bRendered ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	RunPanoramaCapture()
+ *
+ *  This function is used to capture a 360 degree panorama
+ *  of the scene from a point, in a hidden window.  The six
+ *  cube faces are rendered with a single layered pass and
+ *  converted into the image on a worker thread.
+ ***********************************************************/
+int RunPanoramaCapture(const char* sceneFilename, const glm::vec3& center, const char* imageFilename, int width)
+{
+	if (InitializeGLFW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the faces render into their own cube map, so the window
+	// is never shown and its size does not matter
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	g_Window = glfwCreateWindow(width, width / 2, WINDOW_TITLE, NULL, NULL);
+	if (g_Window == NULL)
+	{
+		std::cout << "Failed to create GLFW display window" << std::endl;
+		glfwTerminate();
+		return(EXIT_FAILURE);
+	}
+	glfwMakeContextCurrent(g_Window);
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	JobSystem::Initialize();
+	g_ShaderManager = new ShaderManager();
+	LoadSceneShader();
+	SetMemoryBudgets();
+
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	if (NULL != sceneFilename)
+	{
+		g_SceneManager->LoadSceneFile(sceneFilename);
+	}
+	g_SceneManager->PrepareScene();
+
+	PanoramaCapture panorama(width);
+	bool bCaptured = panorama.Initialize() &&
+		panorama.Capture(g_SceneManager, center, imageFilename);
+	panorama.Shutdown();
+
+	delete g_SceneManager;
+	g_SceneManager = NULL;
+	delete g_ShaderManager;
+	g_ShaderManager = NULL;
+
+	g_ShaderProgram.Reset();
+	GLResourceManager::Shutdown();
+	GL_DEBUG_SHUTDOWN();
+	JobSystem::Shutdown();
+	glfwTerminate();
+
+	return(bCaptured ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	RunDeviceBenchmark()
+ *
+ *  This function is used to render the same frames of the
+ *  scene from the default camera, first through the OpenGL
+ *  render device in a hidden window and then through the
+ *  software render device, and report the timings of each.
+ *  Both devices execute the same command lists, so the
+ *  difference is in the devices alone.
+ ***********************************************************/
+int RunDeviceBenchmark(const char* sceneFilename, int frameCount)
+{
+	int width = ViewManager::GetWindowWidth();
+	int height = ViewManager::GetWindowHeight();
+
+	if (InitializeGLFW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the frames are never shown, and buffer swaps would only
+	// wait for the display
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	g_Window = glfwCreateWindow(width, height, WINDOW_TITLE, NULL, NULL);
+	if (g_Window == NULL)
+	{
+		std::cout << "Failed to create GLFW display window" << std::endl;
+		glfwTerminate();
+		return(EXIT_FAILURE);
+	}
+	glfwMakeContextCurrent(g_Window);
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	JobSystem::Initialize();
+	g_ShaderManager = new ShaderManager();
+	LoadSceneShader();
+	SetMemoryBudgets();
+
+	g_ViewManager = new ViewManager(NULL);
+	g_ViewManager->PrepareHeadlessView(width, height);
+
+	// the OpenGL device draws into the hidden window
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	if (NULL != sceneFilename)
+	{
+		g_SceneManager->LoadSceneFile(sceneFilename);
+	}
+	g_SceneManager->PrepareScene();
+	BenchmarkRenderDevice(g_SceneManager, frameCount);
+	delete g_SceneManager;
+
+	// the software device draws the same scene on the CPU
+	g_SceneManager = new SceneManager(NULL);
+	g_SceneManager->SetRenderBackend(SceneManager::RENDER_BACKEND_SOFTWARE, width, height);
+	if (NULL != sceneFilename)
+	{
+		g_SceneManager->LoadSceneFile(sceneFilename);
+	}
+	g_SceneManager->PrepareScene();
+	BenchmarkRenderDevice(g_SceneManager, frameCount);
+	delete g_SceneManager;
+	g_SceneManager = NULL;
+
+	delete g_ViewManager;
+	g_ViewManager = NULL;
+	delete g_ShaderManager;
+	g_ShaderManager = NULL;
+
+	g_ShaderProgram.Reset();
+	GLResourceManager::Shutdown();
+	GL_DEBUG_SHUTDOWN();
+	JobSystem::Shutdown();
+	glfwTerminate();
+
+	return(EXIT_SUCCESS);
+}
+
+/***********************************************************
+ *	BenchmarkRenderDevice()
+ *
+ *  This function is used to render frames of a prepared
+ *  scene through its render device and report the average
+ *  frame and submit times.  The OpenGL frames are finished
+ *  before they are timed, so the GPU work is counted.
+ ***********************************************************/
+void BenchmarkRenderDevice(SceneManager* pScene, int frameCount)
+{
+	pScene->SetViewProjection(
+		g_ViewManager->GetViewMatrix(),
+		g_ViewManager->GetProjectionMatrix());
+
+	RenderDevice* pDevice = pScene->GetRenderDevice();
+	bool bOpenGL = (pScene->GetRenderBackend() == SceneManager::RENDER_BACKEND_OPENGL);
+	double frameMilliseconds = 0.0;
+	double submitMilliseconds = 0.0;
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		if (bOpenGL)
+		{
+			glEnable(GL_DEPTH_TEST);
+			glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		}
+
+		// the frames advance the wind like the interactive scene
+		pScene->SetFrameTime(frame / 60.0);
+		pScene->RenderScene();
+		if (bOpenGL)
+		{
+			glFinish();
+			GLResourceManager::EndFrame();
+		}
+
+		frameMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+		submitMilliseconds += pDevice->GetStats().submitMilliseconds;
+	}
+
+	const RENDER_DEVICE_STATS& stats = pDevice->GetStats();
+	std::cout << "INFO: " << pDevice->GetName() << " device - "
+		<< frameCount << " frames, "
+		<< stats.draws << " draws, "
+		<< frameMilliseconds / frameCount << "ms per frame, "
+		<< submitMilliseconds / frameCount << "ms per submit" << std::endl;
+}
+
+/***********************************************************
+ *	RunRenderServer()
+ *
+ *  This function is used to serve rendered views of the
+ *  scene over a local socket, in a hidden window.  The
+ *  scene is prepared once and stays resident for every
+ *  request.
+ ***********************************************************/
+int RunRenderServer(const char* sceneFilename, const char* socketPath)
+{
+	if (InitializeGLFW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the views render into the server's own framebuffer, so
+	// the window is never shown and its size does not matter
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	g_Window = glfwCreateWindow(64, 64, WINDOW_TITLE, NULL, NULL);
+	if (g_Window == NULL)
+	{
+		std::cout << "Failed to create GLFW display window" << std::endl;
+		glfwTerminate();
+		return(EXIT_FAILURE);
+	}
+	glfwMakeContextCurrent(g_Window);
+	if (InitializeGLEW() == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	JobSystem::Initialize();
+	g_ShaderManager = new ShaderManager();
+	LoadSceneShader();
+	SetMemoryBudgets();
+
+	g_SceneManager = new SceneManager(g_ShaderManager);
+	if (NULL != sceneFilename)
+	{
+		g_SceneManager->LoadSceneFile(sceneFilename);
+	}
+	g_SceneManager->PrepareScene();
+
+	// the server frees its framebuffer while the context exists
+	bool bStarted = false;
+	{
+		RenderServer server;
+		bStarted = server.Start(socketPath);
+		if (bStarted)
+		{
+			server.Run(g_SceneManager);
+			server.Stop();
+		}
+	}
+
+	delete g_SceneManager;
+	g_SceneManager = NULL;
+	delete g_ShaderManager;
+	g_ShaderManager = NULL;
+
+	g_ShaderProgram.Reset();
+	GLResourceManager::Shutdown();
+	GL_DEBUG_SHUTDOWN();
+	JobSystem::Shutdown();
+	glfwTerminate();
+
+	return(bStarted ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
 /***********************************************************
  *	InitializeGLFW()
  * 
@@ -133,16 +1113,16 @@ bool InitializeGLFW()
 	// --------------------------------------
 	glfwInit();
 
-#ifdef __APPLE__
-	// set the version of OpenGL and profile to use
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-#else
-	// set the version of OpenGL and profile to use
+	// set the version of OpenGL and profile to use - the shaders
+	// read the scene records from storage buffers, which need
+	// OpenGL 4.3, so macOS, which stops at OpenGL 4.1, is no
+	// longer supported and its window fails to be created
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if defined(GL_DEBUG_OUTPUT_ENABLED)
+	// a debug context reports every error through the debug output
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
 #endif
 	// GLFW: end -------------------------------
 
@@ -173,5 +1153,368 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Successfully Initialized\n";
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
+	// report the driver errors and warnings as they happen -
+	// compiled out of release builds
+	GL_DEBUG_INITIALIZE();
+
+	return(true);
+}
+
+/***********************************************************
+ *	LoadSceneShader()
+ *
+ *  This function is used to load the scene shader code,
+ *  which reads the per-object data from the scene instance,
+ *  material and light buffers, and to take ownership of the
+ *  linked program.
+ ***********************************************************/
+void LoadSceneShader()
+{
+	const char* vertexShaderFile = "Shaders/sceneVertex.glsl";
+	const char* fragmentShaderFile = "Shaders/sceneFragment.glsl";
+	g_ShaderManager->LoadShaders(vertexShaderFile, fragmentShaderFile);
+	g_ShaderManager->use();
+
+	// charge the program to the shaders subsystem
+	GLint programID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	g_ShaderProgram = GLProgramHandle::Adopt(programID, "scene shader");
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_PROGRAM, programID, "scene shader");
+	GLResourceManager::SetProgramMemory(programID, MemoryTracker::MEMTAG_SHADERS, { vertexShaderFile, fragmentShaderFile });
+}
+
+/***********************************************************
+ *	SetMemoryBudgets()
+ *
+ *  This function is used to set the memory budgets that
+ *  each subsystem is expected to stay within.
+ ***********************************************************/
+void SetMemoryBudgets()
+{
+	const size_t MEGABYTE = 1024 * 1024;
+
+	MemoryTracker::SetBudget(MemoryTracker::MEMTAG_TEXTURES, MemoryTracker::POOL_GPU, 256 * MEGABYTE);
+	MemoryTracker::SetBudget(MemoryTracker::MEMTAG_TEXTURES, MemoryTracker::POOL_CPU, 64 * MEGABYTE);
+	MemoryTracker::SetBudget(MemoryTracker::MEMTAG_MESHES, MemoryTracker::POOL_GPU, 64 * MEGABYTE);
+	MemoryTracker::SetBudget(MemoryTracker::MEMTAG_SHADERS, MemoryTracker::POOL_GPU, 4 * MEGABYTE);
+	MemoryTracker::SetBudget(MemoryTracker::MEMTAG_SCENE, MemoryTracker::POOL_CPU, 16 * MEGABYTE);
+	MemoryTracker::SetBudget(MemoryTracker::MEMTAG_PARTICLES, MemoryTracker::POOL_CPU, 64 * MEGABYTE);
+	MemoryTracker::SetBudget(MemoryTracker::MEMTAG_PARTICLES, MemoryTracker::POOL_GPU, 32 * MEGABYTE);
+	MemoryTracker::SetBudget(MemoryTracker::MEMTAG_CAPTURE, MemoryTracker::POOL_CPU, 192 * MEGABYTE);
+	MemoryTracker::SetBudget(MemoryTracker::MEMTAG_CAPTURE, MemoryTracker::POOL_GPU, 64 * MEGABYTE);
+}
+
+/***********************************************************
+ *	UpdateMemoryReport()
+ *
+ *  This function is used to show the memory totals in the
+ *  window title bar and to periodically write them into
+ *  the memory report file.
+ ***********************************************************/
+void UpdateMemoryReport(double currentTime)
+{
+	static double lastHUDTime = 0.0;
+	static double lastReportTime = 0.0;
+
+	if (currentTime - lastHUDTime >= MEMORY_HUD_INTERVAL)
+	{
+		std::string title = std::string(WINDOW_TITLE) + " | " + MemoryTracker::GetSummary();
+		glfwSetWindowTitle(g_Window, title.c_str());
+		lastHUDTime = currentTime;
+	}
+
+	if (currentTime - lastReportTime >= MEMORY_REPORT_INTERVAL)
+	{
+		MemoryTracker::CheckBudgets();
+		MemoryTracker::WriteJSON(MEMORY_REPORT_FILE);
+		lastReportTime = currentTime;
+	}
+}
+
+/***********************************************************
+ *	ProcessRecorderKeys()
+ *
+ *  This function is used to take a screenshot when F12 is
+ *  pressed, and to start or stop a recording when F10 is.
+ *  The files are named after the frame they start on.
+ ***********************************************************/
+void ProcessRecorderKeys()
+{
+	bool bScreenshotKeyDown = (glfwGetKey(g_Window, GLFW_KEY_F12) == GLFW_PRESS);
+	if (bScreenshotKeyDown && !g_bScreenshotKeyDown)
+	{
+		std::string filename = "screenshot_" + std::to_string(GLResourceManager::GetFrameIndex()) + ".png";
+		g_FrameRecorder->RequestScreenshot(filename);
+		std::cout << "INFO: screenshot " << filename << std::endl;
+	}
+	g_bScreenshotKeyDown = bScreenshotKeyDown;
+
+	bool bRecordKeyDown = (glfwGetKey(g_Window, GLFW_KEY_F10) == GLFW_PRESS);
+	if (bRecordKeyDown && !g_bRecordKeyDown)
+	{
+		if (g_FrameRecorder->IsRecording())
+		{
+			g_FrameRecorder->StopRecording();
+		}
+		else
+		{
+			g_FrameRecorder->StartRecording(
+				"recording_" + std::to_string(GLResourceManager::GetFrameIndex()) + ".y4m",
+				RECORDING_FRAME_RATE);
+		}
+	}
+	g_bRecordKeyDown = bRecordKeyDown;
+}
+
+/***********************************************************
+ *	StartMetricsExport()
+ *
+ *  This function is used to register the collectors that
+ *  copy the memory and OpenGL object totals into the metrics
+ *  and to start exporting them on the passed in loopback
+ *  port or into the passed in file.  Nothing is started
+ *  when neither was asked for.
+ ***********************************************************/
+bool StartMetricsExport(int port, const char* filename)
+{
+	if ((port <= 0) && (NULL == filename))
+	{
+		return(true);
+	}
+
+	// the memory totals are already atomics, so they are read on
+	// the export thread instead of every frame
+	Metrics::AddCollector([]()
+	{
+		const char* const poolNames[MemoryTracker::POOL_COUNT] = { "cpu", "gpu" };
+		for (int tag = 0; tag < MemoryTracker::MEMTAG_COUNT; tag++)
+		{
+			for (int pool = 0; pool < MemoryTracker::POOL_COUNT; pool++)
+			{
+				std::string labels = std::string("subsystem=\"") + MemoryTracker::GetTagName((MemoryTracker::MEMORY_TAG)tag) +
+					"\",pool=\"" + poolNames[pool] + "\"";
+				MemoryTracker::MEMORY_STATS stats = MemoryTracker::GetStats(
+					(MemoryTracker::MEMORY_TAG)tag, (MemoryTracker::MEMORY_POOL)pool);
+				Metrics::GetGauge("shrine_memory_live_bytes", "Memory in use, by subsystem and pool", labels)->Set((double)stats.liveBytes);
+				Metrics::GetGauge("shrine_memory_peak_bytes", "Most memory ever in use, by subsystem and pool", labels)->Set((double)stats.peakBytes);
+				Metrics::GetGauge("shrine_memory_budget_bytes", "Memory budget, by subsystem and pool", labels)->Set((double)stats.budgetBytes);
+			}
+		}
+	});
+
+	// the live textures are the ones resident on the GPU
+	Metrics::AddCollector([]()
+	{
+		for (int type = 0; type < GLResourceManager::GLRES_COUNT; type++)
+		{
+			std::string labels = std::string("type=\"") + GLResourceManager::GetTypeName((GLResourceManager::GL_RESOURCE_TYPE)type) + "\"";
+			Metrics::GetGauge("shrine_gl_live_objects", "OpenGL objects alive, by type", labels)->Set(
+				(double)GLResourceManager::GetLiveCount((GLResourceManager::GL_RESOURCE_TYPE)type));
+		}
+		Metrics::GetGauge("shrine_gl_pending_deletes", "Released OpenGL objects waiting for the GPU to finish with them")->Set(
+			(double)GLResourceManager::GetPendingCount());
+	});
+
+	if ((port > 0) && (Metrics::StartHTTPListener(port) == false))
+	{
+		return(false);
+	}
+	if ((NULL != filename) && (Metrics::StartFileSink(filename, METRICS_FILE_INTERVAL) == false))
+	{
+		Metrics::Shutdown();
+		return(false);
+	}
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *	UpdateFrameMetrics()
+ *
+ *  This function is used to add the time of the last frame,
+ *  and of the rendering within it, to the metrics.  It only
+ *  adds to atomics, so it costs the render thread nothing
+ *  whether anything is exported or not.
+ ***********************************************************/
+void UpdateFrameMetrics(double frameSeconds, double renderSeconds)
+{
+	static MetricCounter* s_pFrames = Metrics::GetCounter(
+		"shrine_frames_total", "Frames rendered by the interactive window");
+	static MetricHistogram* s_pFrameTimes = Metrics::GetHistogram(
+		"shrine_frame_time_seconds", "Time between the starts of successive frames",
+		{ 0.004, 0.008, 0.0167, 0.0333, 0.05, 0.1, 0.25, 1.0 });
+	static MetricHistogram* s_pRenderTimes = Metrics::GetHistogram(
+		"shrine_render_cpu_seconds", "Render thread time spent issuing the scene each frame",
+		{ 0.001, 0.002, 0.004, 0.008, 0.0167, 0.0333, 0.1 });
+
+	s_pFrames->Add();
+	s_pFrameTimes->Observe(frameSeconds);
+	s_pRenderTimes->Observe(renderSeconds);
+}
+
+/***********************************************************
+ *	CompileModelPack()
+ *
+ *  This function is used to import a model file, build the
+ *  levels of detail of its meshes and write it into a model
+ *  pack, so later runs load the pack without either step.
+ *  The lod ratios are read before this runs, so they may be
+ *  given after the flag.
+ ***********************************************************/
+int CompileModelPack(const char* modelFilename, const char* packFilename, const std::vector<float>& lodRatios)
+{
+	JobSystem::Initialize();
+
+	IMPORTED_MODEL model;
+	bool bWritten = ModelImporter::Import(modelFilename, model, lodRatios)
+		&& ModelPack::Write(model, packFilename);
+
+	JobSystem::Shutdown();
+	return(bWritten ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	StartInteractiveScene()
+ *
+ *  This function is used to open the window and load the
+ *  scene and models as a graph of startup steps.  Mapping
+ *  the scene file, decoding the textures, reading the
+ *  shaders and importing the models start on the job system
+ *  right away, while this thread creates the window and the
+ *  OpenGL context, and each OpenGL step waits only on the
+ *  steps whose results it uploads.  The timeline of the
+ *  steps is printed and written into a trace file.
+ ***********************************************************/
+bool StartInteractiveScene(
+	const char* sceneFilename,
+	const std::vector<const char*>& modelFilenames,
+	const std::vector<glm::vec4>& modelPlacements,
+	const std::vector<float>& modelLodRatios,
+	const char* glCallReportFilename)
+{
+	// none of the managers make OpenGL calls until the scene is
+	// prepared, so they are created before the window
+	g_ShaderManager = new ShaderManager();
+	g_ViewManager = new ViewManager(
+		g_ShaderManager);
+	g_SceneManager = new SceneManager(g_ShaderManager);
+
+	// the models are held here between their import and upload
+	std::vector<STARTUP_MODEL> models(modelFilenames.size());
+	StartupGraph startup;
+
+	// a scene file that fails to map leaves the hand-coded scene
+	int sceneStep = startup.AddStep("map scene file", StartupGraph::STARTUP_ANY_THREAD, {}, [sceneFilename]()
+	{
+		if (NULL != sceneFilename)
+		{
+			g_SceneManager->LoadSceneFile(sceneFilename);
+		}
+		return(true);
+	});
+	int decodeStep = startup.AddStep("decode textures", StartupGraph::STARTUP_ANY_THREAD, { sceneStep }, []()
+	{
+		g_SceneManager->DecodeSceneTextures();
+		return(true);
+	});
+	int shaderReadStep = startup.AddStep("read shaders", StartupGraph::STARTUP_ANY_THREAD, {}, []()
+	{
+		// the shader manager reads and compiles its files itself,
+		// so this only brings them into the file cache and warns
+		// about a broken one before the window is even open
+		for (const char* shaderFilename : STARTUP_SHADER_FILES)
+		{
+			std::ifstream shaderFile(shaderFilename, std::ios::binary);
+			std::ostringstream source;
+			source << shaderFile.rdbuf();
+			if (!shaderFile.is_open() || (source.str().find("#version") == std::string::npos))
+			{
+				std::cout << "WARNING: could not read a shader version from " << shaderFilename << std::endl;
+			}
+		}
+		return(true);
+	});
+	// a model that fails to load is left out, as before
+	std::vector<int> modelSteps;
+	for (size_t i = 0; i < modelFilenames.size(); i++)
+	{
+		std::string stepName = std::string("import ") + modelFilenames[i];
+		const char* modelFilename = modelFilenames[i];
+		STARTUP_MODEL* pModel = &models[i];
+		modelSteps.push_back(startup.AddStep(stepName.c_str(), StartupGraph::STARTUP_ANY_THREAD, {}, [modelFilename, pModel, &modelLodRatios]()
+		{
+			if (ModelPack::IsPackFilename(modelFilename))
+			{
+				pModel->bLoaded = pModel->pack.Load(modelFilename);
+			}
+			else
+			{
+				pModel->bLoaded = ModelImporter::Import(modelFilename, pModel->imported, modelLodRatios);
+			}
+			return(true);
+		}));
+	}
+
+	int windowStep = startup.AddStep("create window", StartupGraph::STARTUP_MAIN_THREAD, {}, []()
+	{
+		if (InitializeGLFW() == false)
+		{
+			return(false);
+		}
+		g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+		return(NULL != g_Window);
+	});
+	int contextStep = startup.AddStep("initialize OpenGL", StartupGraph::STARTUP_MAIN_THREAD, { windowStep }, [glCallReportFilename]()
+	{
+		if (InitializeGLEW() == false)
+		{
+			return(false);
+		}
+		// wrap the OpenGL entry points before anything is loaded,
+		// so the startup calls are reported as the first frame
+		if (NULL != glCallReportFilename)
+		{
+			GLInterceptor::Install(glCallReportFilename);
+		}
+		return(true);
+	});
+	int shaderStep = startup.AddStep("compile scene shader", StartupGraph::STARTUP_MAIN_THREAD, { contextStep, shaderReadStep }, []()
+	{
+		LoadSceneShader();
+		return(true);
+	});
+	int prepareStep = startup.AddStep("prepare scene", StartupGraph::STARTUP_MAIN_THREAD, { shaderStep, sceneStep, decodeStep }, []()
+	{
+		g_SceneManager->PrepareScene();
+		return(true);
+	});
+	if (!models.empty())
+	{
+		std::vector<int> uploadDependencies = modelSteps;
+		uploadDependencies.push_back(prepareStep);
+		startup.AddStep("upload models", StartupGraph::STARTUP_MAIN_THREAD, uploadDependencies, [&models, &modelPlacements]()
+		{
+			for (size_t i = 0; i < models.size(); i++)
+			{
+				int model = -1;
+				if (models[i].bLoaded)
+				{
+					model = models[i].pack.IsLoaded()
+						? g_SceneManager->AddModelPack(models[i].pack)
+						: g_SceneManager->AddImportedModel(models[i].imported);
+				}
+				std::vector<EntityID> modelObjects;
+				g_SceneManager->AddModelObject(
+					model,
+					glm::vec3(modelPlacements[i].w),
+					glm::vec3(0.0f),
+					glm::vec3(modelPlacements[i]),
+					modelObjects);
+			}
+			return(true);
+		});
+	}
+
+	bool bStarted = startup.Run();
+	startup.ReportTimeline(STARTUP_TIMELINE_FILE);
+	return(bStarted);
+}
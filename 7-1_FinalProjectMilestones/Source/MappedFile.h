@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// map a whole file into memory read-only
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class maps a file into memory for reading in place.
+ *  The pages are only read from disk as they are touched,
+ *  so parsers can walk the file directly without copying
+ *  it into a buffer first.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor - unmaps the file
+	~MappedFile();
+
+	// map the whole file - an empty file cannot be mapped
+	bool Open(const char* filename);
+	void Close();
+	bool IsOpen() const { return m_pData != nullptr; }
+
+	const unsigned char* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_dataSize; }
+
+private:
+	const unsigned char* m_pData;
+	size_t m_dataSize;
+	// platform handles for the mapping
+	void* m_fileHandle;
+	void* m_mappingHandle;
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+};
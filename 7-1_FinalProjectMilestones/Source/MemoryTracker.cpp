@@ -0,0 +1,264 @@
+///////////////////////////////////////////////////////////////////////////////
+// memorytracker.cpp
+// ============
+// account for the CPU and GPU memory used by each subsystem
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MemoryTracker.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// running totals for every subsystem in every pool
+	struct TAG_COUNTERS
+	{
+		std::atomic<size_t> liveBytes;
+		std::atomic<size_t> peakBytes;
+		std::atomic<size_t> budgetBytes;
+		std::atomic<uint32_t> allocations;
+		std::atomic<bool> bOverBudget;
+	};
+
+	TAG_COUNTERS g_Counters[MemoryTracker::MEMTAG_COUNT][MemoryTracker::POOL_COUNT];
+	std::atomic<size_t> g_PoolLive[MemoryTracker::POOL_COUNT];
+	std::atomic<size_t> g_PoolPeak[MemoryTracker::POOL_COUNT];
+
+	const char* g_TagNames[MemoryTracker::MEMTAG_COUNT] =
+	{
+		"textures",
+		"meshes",
+		"shaders",
+		"scene",
+		"particles",
+		"capture"
+	};
+	const char* g_PoolNames[MemoryTracker::POOL_COUNT] =
+	{
+		"cpu",
+		"gpu"
+	};
+
+	// raise the stored peak if the new value is higher
+	void UpdatePeak(std::atomic<size_t>& peak, size_t value)
+	{
+		size_t current = peak.load(std::memory_order_relaxed);
+		while ((value > current) &&
+			!peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	// format a byte count as megabytes for display
+	std::string FormatMegabytes(size_t bytes)
+	{
+		char text[32];
+		snprintf(text, sizeof(text), "%.1fMB", (double)bytes / (1024.0 * 1024.0));
+		return(text);
+	}
+}
+
+/***********************************************************
+ *  RecordAllocation()
+ *
+ *  This method is used for charging an allocation of the
+ *  passed in size to the subsystem tag.
+ ***********************************************************/
+void MemoryTracker::RecordAllocation(MEMORY_TAG tag, MEMORY_POOL pool, size_t bytes)
+{
+	TAG_COUNTERS& counters = g_Counters[tag][pool];
+
+	size_t live = counters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	UpdatePeak(counters.peakBytes, live);
+
+	size_t poolLive = g_PoolLive[pool].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	UpdatePeak(g_PoolPeak[pool], poolLive);
+}
+
+/***********************************************************
+ *  RecordFree()
+ *
+ *  This method is used for returning a previously charged
+ *  allocation from the subsystem tag.
+ ***********************************************************/
+void MemoryTracker::RecordFree(MEMORY_TAG tag, MEMORY_POOL pool, size_t bytes)
+{
+	TAG_COUNTERS& counters = g_Counters[tag][pool];
+
+	counters.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+	counters.allocations.fetch_sub(1, std::memory_order_relaxed);
+	g_PoolLive[pool].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used for getting the current totals for
+ *  one subsystem tag in one memory pool.
+ ***********************************************************/
+MemoryTracker::MEMORY_STATS MemoryTracker::GetStats(MEMORY_TAG tag, MEMORY_POOL pool)
+{
+	MEMORY_STATS stats;
+	const TAG_COUNTERS& counters = g_Counters[tag][pool];
+
+	stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+	stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+	stats.budgetBytes = counters.budgetBytes.load(std::memory_order_relaxed);
+	stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+
+	return(stats);
+}
+
+/***********************************************************
+ *  GetTotalLive()
+ *
+ *  This method is used for getting the live total for all
+ *  of the subsystems in the passed in pool.
+ ***********************************************************/
+size_t MemoryTracker::GetTotalLive(MEMORY_POOL pool)
+{
+	return(g_PoolLive[pool].load(std::memory_order_relaxed));
+}
+
+/***********************************************************
+ *  GetTotalPeak()
+ *
+ *  This method is used for getting the peak total for all
+ *  of the subsystems in the passed in pool.
+ ***********************************************************/
+size_t MemoryTracker::GetTotalPeak(MEMORY_POOL pool)
+{
+	return(g_PoolPeak[pool].load(std::memory_order_relaxed));
+}
+
+/***********************************************************
+ *  GetTagName()
+ *
+ *  This method is used for getting the display name of the
+ *  passed in subsystem tag.
+ ***********************************************************/
+const char* MemoryTracker::GetTagName(MEMORY_TAG tag)
+{
+	if ((tag < 0) || (tag >= MEMTAG_COUNT))
+	{
+		return("unknown");
+	}
+	return(g_TagNames[tag]);
+}
+
+/***********************************************************
+ *  SetBudget()
+ *
+ *  This method is used for setting the maximum number of
+ *  bytes a subsystem is allowed to use in a pool.
+ ***********************************************************/
+void MemoryTracker::SetBudget(MEMORY_TAG tag, MEMORY_POOL pool, size_t bytes)
+{
+	g_Counters[tag][pool].budgetBytes.store(bytes, std::memory_order_relaxed);
+	g_Counters[tag][pool].bOverBudget.store(false, std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  CheckBudgets()
+ *
+ *  This method is used for checking the peak usage of every
+ *  subsystem against its budget.  Each violation is only
+ *  reported once, and false is returned if any subsystem
+ *  is over its budget.
+ ***********************************************************/
+bool MemoryTracker::CheckBudgets()
+{
+	bool bWithinBudget = true;
+
+	for (int tag = 0; tag < MEMTAG_COUNT; tag++)
+	{
+		for (int pool = 0; pool < POOL_COUNT; pool++)
+		{
+			TAG_COUNTERS& counters = g_Counters[tag][pool];
+			size_t budget = counters.budgetBytes.load(std::memory_order_relaxed);
+			size_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+
+			if ((budget > 0) && (peak > budget))
+			{
+				bWithinBudget = false;
+				if (counters.bOverBudget.exchange(true) == false)
+				{
+					std::cout << "WARNING: " << g_TagNames[tag] << " " << g_PoolNames[pool]
+						<< " memory peak " << FormatMegabytes(peak)
+						<< " is over the budget of " << FormatMegabytes(budget) << std::endl;
+				}
+			}
+		}
+	}
+
+	return(bWithinBudget);
+}
+
+/***********************************************************
+ *  GetSummary()
+ *
+ *  This method is used for building a short text summary
+ *  of the GPU usage per subsystem and the pool totals.
+ ***********************************************************/
+std::string MemoryTracker::GetSummary()
+{
+	std::string summary;
+
+	for (int tag = 0; tag < MEMTAG_COUNT; tag++)
+	{
+		summary += g_TagNames[tag];
+		summary += " ";
+		summary += FormatMegabytes(g_Counters[tag][POOL_GPU].liveBytes.load(std::memory_order_relaxed));
+		summary += " | ";
+	}
+	summary += "CPU " + FormatMegabytes(GetTotalLive(POOL_CPU)) + " (peak " + FormatMegabytes(GetTotalPeak(POOL_CPU)) + ")";
+	summary += " GPU " + FormatMegabytes(GetTotalLive(POOL_GPU)) + " (peak " + FormatMegabytes(GetTotalPeak(POOL_GPU)) + ")";
+
+	return(summary);
+}
+
+/***********************************************************
+ *  WriteJSON()
+ *
+ *  This method is used for writing the totals of every
+ *  subsystem and pool into the passed in JSON file.
+ ***********************************************************/
+bool MemoryTracker::WriteJSON(const char* filename)
+{
+	std::ofstream file(filename, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write memory report:" << filename << std::endl;
+		return(false);
+	}
+
+	file << "{\n";
+	for (int pool = 0; pool < POOL_COUNT; pool++)
+	{
+		file << "  \"" << g_PoolNames[pool] << "\": {\n";
+		file << "    \"live\": " << GetTotalLive((MEMORY_POOL)pool) << ",\n";
+		file << "    \"peak\": " << GetTotalPeak((MEMORY_POOL)pool) << ",\n";
+		file << "    \"tags\": {\n";
+		for (int tag = 0; tag < MEMTAG_COUNT; tag++)
+		{
+			MEMORY_STATS stats = GetStats((MEMORY_TAG)tag, (MEMORY_POOL)pool);
+			file << "      \"" << g_TagNames[tag] << "\": { "
+				<< "\"live\": " << stats.liveBytes << ", "
+				<< "\"peak\": " << stats.peakBytes << ", "
+				<< "\"budget\": " << stats.budgetBytes << ", "
+				<< "\"allocations\": " << stats.allocations << " }"
+				<< ((tag + 1 < MEMTAG_COUNT) ? ",\n" : "\n");
+		}
+		file << "    }\n";
+		file << "  }" << ((pool + 1 < POOL_COUNT) ? ",\n" : "\n");
+	}
+	file << "}\n";
+
+	return(true);
+}
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+// memorytracker.h
+// ============
+// account for the CPU and GPU memory used by each subsystem
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <string>
+
+/***********************************************************
+ *  MemoryTracker
+ *
+ *  This class records every tracked allocation under a
+ *  subsystem tag, so the live and peak memory totals for
+ *  textures, meshes, shaders and scene data can be queried,
+ *  displayed and compared against the configured budgets.
+ ***********************************************************/
+class MemoryTracker
+{
+public:
+	// subsystems that memory can be charged against
+	enum MEMORY_TAG
+	{
+		MEMTAG_TEXTURES = 0,
+		MEMTAG_MESHES,
+		MEMTAG_SHADERS,
+		MEMTAG_SCENE,
+		MEMTAG_PARTICLES,
+		MEMTAG_CAPTURE,
+		MEMTAG_COUNT
+	};
+
+	// where the tracked memory lives
+	enum MEMORY_POOL
+	{
+		POOL_CPU = 0,
+		POOL_GPU,
+		POOL_COUNT
+	};
+
+	struct MEMORY_STATS
+	{
+		size_t liveBytes;
+		size_t peakBytes;
+		size_t budgetBytes;
+		uint32_t allocations;
+	};
+
+	// record an allocation or a free of the passed in size
+	static void RecordAllocation(MEMORY_TAG tag, MEMORY_POOL pool, size_t bytes);
+	static void RecordFree(MEMORY_TAG tag, MEMORY_POOL pool, size_t bytes);
+
+	// get the live/peak totals for one subsystem or for a pool
+	static MEMORY_STATS GetStats(MEMORY_TAG tag, MEMORY_POOL pool);
+	static size_t GetTotalLive(MEMORY_POOL pool);
+	static size_t GetTotalPeak(MEMORY_POOL pool);
+	static const char* GetTagName(MEMORY_TAG tag);
+
+	// set the budget for a subsystem - zero means no budget
+	static void SetBudget(MEMORY_TAG tag, MEMORY_POOL pool, size_t bytes);
+	// report any subsystem whose peak has gone over budget
+	static bool CheckBudgets();
+
+	// short one-line summary used for the on-screen display
+	static std::string GetSummary();
+	// write the full set of totals into a JSON file
+	static bool WriteJSON(const char* filename);
+};
+
+/***********************************************************
+ *  TrackedAllocator
+ *
+ *  Standard library allocator that charges every CPU
+ *  allocation made through it to the given subsystem tag.
+ ***********************************************************/
+template <class T, MemoryTracker::MEMORY_TAG TAG>
+class TrackedAllocator
+{
+public:
+	typedef T value_type;
+
+	template <class U>
+	struct rebind
+	{
+		typedef TrackedAllocator<U, TAG> other;
+	};
+
+	TrackedAllocator() noexcept {}
+	template <class U>
+	TrackedAllocator(const TrackedAllocator<U, TAG>&) noexcept {}
+
+	T* allocate(size_t count)
+	{
+		if (count > std::numeric_limits<size_t>::max() / sizeof(T))
+		{
+			throw std::bad_alloc();
+		}
+		T* pMemory = static_cast<T*>(::operator new(count * sizeof(T)));
+		MemoryTracker::RecordAllocation(TAG, MemoryTracker::POOL_CPU, count * sizeof(T));
+		return(pMemory);
+	}
+
+	void deallocate(T* pMemory, size_t count) noexcept
+	{
+		MemoryTracker::RecordFree(TAG, MemoryTracker::POOL_CPU, count * sizeof(T));
+		::operator delete(pMemory);
+	}
+};
+
+template <class T, class U, MemoryTracker::MEMORY_TAG TAG>
+bool operator==(const TrackedAllocator<T, TAG>&, const TrackedAllocator<U, TAG>&) { return true; }
+template <class T, class U, MemoryTracker::MEMORY_TAG TAG>
+bool operator!=(const TrackedAllocator<T, TAG>&, const TrackedAllocator<U, TAG>&) { return false; }
@@ -0,0 +1,1018 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcodec.cpp
+// ============
+// compress compact meshes and decode them straight into buffers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshCodec.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// the vertex rebuild uses SSE2 whenever the build targets it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define MESH_CODEC_SIMD_SSE
+#endif
+
+// declaration of global variables
+namespace
+{
+	// vertices and indices in one independently decoded block -
+	// the decoded bytes of a vertex block stay within 128KB
+	const uint32_t g_VertexBlockSize = 8192;
+	const uint32_t g_IndexBlockSize = 3 * 8192;
+
+	// 16 bit channels stored per vertex: the quantized position,
+	// the three 10 bit normal components and the two halves of
+	// the texture coordinate
+	const uint32_t g_VertexChannels = 8;
+	const float g_PositionSteps = 65535.0f;
+
+	// size of the vertex cache the triangles are ordered for
+	const uint32_t g_VertexCacheSize = 16;
+
+	// the rANS coder keeps probabilities in 12 bits and its
+	// states between the lower bound and 65536 times it, so it
+	// moves whole 16 bit words in and out, never more than one
+	// per symbol
+	const uint32_t g_RansScaleBits = 12;
+	const uint32_t g_RansScale = 1u << g_RansScaleBits;
+	const uint32_t g_RansLowerBound = 1u << 16;
+	// streams shorter than this are never worth a table
+	const size_t g_MinimumCodedStream = 64;
+
+	// how the bytes of a stream are stored
+	enum STREAM_MODE
+	{
+		STREAM_RAW = 0,
+		STREAM_RANS
+	};
+
+	struct STREAM_HEADER
+	{
+		uint32_t rawSize;
+		uint32_t codedSize;
+		uint32_t mode;
+	};
+
+	const uint32_t g_NoVertex = std::numeric_limits<uint32_t>::max();
+
+	void AppendBytes(std::vector<unsigned char>& output, const void* pData, size_t size)
+	{
+		const unsigned char* pBytes = (const unsigned char*)pData;
+		output.insert(output.end(), pBytes, pBytes + size);
+	}
+
+	uint32_t ReadUint32(const unsigned char* pData)
+	{
+		uint32_t value = 0;
+		memcpy(&value, pData, sizeof(value));
+		return(value);
+	}
+
+	/***********************************************************
+	 *  NormalizeFrequencies()
+	 *
+	 *  Scales the byte counts so they sum to the rANS scale,
+	 *  keeping at least one slot for every byte that occurs.
+	 *  The rounding goes to the most frequent bytes, which
+	 *  notice it the least.
+	 ***********************************************************/
+	void NormalizeFrequencies(const uint32_t counts[256], size_t total, uint32_t frequencies[256])
+	{
+		uint32_t assigned = 0;
+		for (int symbol = 0; symbol < 256; symbol++)
+		{
+			frequencies[symbol] = (counts[symbol] == 0) ? 0 :
+				std::max<uint32_t>(1, (uint32_t)((uint64_t)counts[symbol] * g_RansScale / total));
+			assigned += frequencies[symbol];
+		}
+		while (assigned != g_RansScale)
+		{
+			int largest = 0;
+			for (int symbol = 1; symbol < 256; symbol++)
+			{
+				largest = (frequencies[symbol] > frequencies[largest]) ? symbol : largest;
+			}
+			if (assigned < g_RansScale)
+			{
+				frequencies[largest] += g_RansScale - assigned;
+				assigned = g_RansScale;
+			}
+			else
+			{
+				frequencies[largest]--;
+				assigned--;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  EncodeRans()
+	 *
+	 *  Codes bytes with four interleaved rANS states, byte i
+	 *  going to state i % 4, so the decoder can work on four
+	 *  bytes at once.  Each state pushes its renormalization
+	 *  words into a stream of its own, so the four never wait
+	 *  on one another in the decoder.  The coder runs backwards
+	 *  so the decoder reads forwards.  The output is the symbol
+	 *  table, the four final states, the byte size of each
+	 *  word stream and the streams.
+	 ***********************************************************/
+	void EncodeRans(const unsigned char* pData, size_t size, std::vector<unsigned char>& coded)
+	{
+		uint32_t counts[256] = {};
+		for (size_t i = 0; i < size; i++)
+		{
+			counts[pData[i]]++;
+		}
+		uint32_t frequencies[256];
+		NormalizeFrequencies(counts, size, frequencies);
+		uint32_t starts[256];
+		uint32_t start = 0;
+		for (int symbol = 0; symbol < 256; symbol++)
+		{
+			starts[symbol] = start;
+			start += frequencies[symbol];
+		}
+
+		// a symbol never pushes out more than one word, and each
+		// lane gets a quarter of the symbols
+		size_t laneCapacity = (size / 4 + 1) * sizeof(uint16_t);
+		std::vector<unsigned char> renormalization(laneCapacity * 4);
+		unsigned char* pCursors[4];
+		for (int lane = 0; lane < 4; lane++)
+		{
+			pCursors[lane] = renormalization.data() + laneCapacity * (lane + 1);
+		}
+		uint32_t states[4] = { g_RansLowerBound, g_RansLowerBound, g_RansLowerBound, g_RansLowerBound };
+		for (size_t i = size; i-- > 0;)
+		{
+			uint32_t& state = states[i & 3];
+			uint32_t frequency = frequencies[pData[i]];
+			uint64_t stateLimit = (uint64_t)((g_RansLowerBound >> g_RansScaleBits) * frequency) << 16;
+			if (state >= stateLimit)
+			{
+				uint16_t word = (uint16_t)(state & 0xFFFF);
+				pCursors[i & 3] -= sizeof(word);
+				memcpy(pCursors[i & 3], &word, sizeof(word));
+				state >>= 16;
+			}
+			state = ((state / frequency) << g_RansScaleBits) + (state % frequency) + starts[pData[i]];
+		}
+
+		coded.clear();
+		uint16_t symbolCount = 0;
+		for (int symbol = 0; symbol < 256; symbol++)
+		{
+			symbolCount += (frequencies[symbol] > 0) ? 1 : 0;
+		}
+		AppendBytes(coded, &symbolCount, sizeof(symbolCount));
+		for (int symbol = 0; symbol < 256; symbol++)
+		{
+			if (frequencies[symbol] > 0)
+			{
+				uint16_t frequency = (uint16_t)frequencies[symbol];
+				coded.push_back((unsigned char)symbol);
+				AppendBytes(coded, &frequency, sizeof(frequency));
+			}
+		}
+		AppendBytes(coded, states, sizeof(states));
+		for (int lane = 0; lane < 4; lane++)
+		{
+			uint32_t laneSize = (uint32_t)(renormalization.data() + laneCapacity * (lane + 1) - pCursors[lane]);
+			AppendBytes(coded, &laneSize, sizeof(laneSize));
+		}
+		for (int lane = 0; lane < 4; lane++)
+		{
+			coded.insert(coded.end(), pCursors[lane], renormalization.data() + laneCapacity * (lane + 1));
+		}
+	}
+
+	// decode one symbol from a state, refilling it with a word
+	// from its stream, which must have two bytes left
+	inline unsigned char DecodeRansSymbol(uint32_t& state, const uint32_t* pSlots, const unsigned char*& pWords)
+	{
+		uint32_t entry = pSlots[state & (g_RansScale - 1)];
+		uint32_t next = (((entry >> 8) & 0xFFF) + 1) * (state >> g_RansScaleBits) + (entry >> 20);
+		uint16_t word = 0;
+		memcpy(&word, pWords, sizeof(word));
+		// arithmetic rather than a condition, which compilers
+		// turn into a branch that mispredicts on dense streams
+		uint32_t refill = (next < g_RansLowerBound) ? 1 : 0;
+		state = (next << (refill * 16)) | (word & (0u - refill));
+		pWords += refill * sizeof(word);
+		return((unsigned char)entry);
+	}
+
+	/***********************************************************
+	 *  DecodeRans()
+	 *
+	 *  Decodes what EncodeRans() wrote.  Each slot of the
+	 *  table packs its symbol, frequency and distance from the
+	 *  symbol's first slot into one word, and every symbol
+	 *  reads at most one word back in, which is done without a
+	 *  branch.  A group of four symbols takes at most one word
+	 *  from each stream, so as many groups as the shortest
+	 *  stream has words left run without bounds checks.  A
+	 *  stream that does not end with every state back where
+	 *  the encoder started them, and every byte used, is
+	 *  damaged.
+	 ***********************************************************/
+	bool DecodeRans(const unsigned char* pCoded, size_t codedSize, unsigned char* pOutput, size_t outputSize)
+	{
+		const unsigned char* pCursor = pCoded;
+		const unsigned char* pEnd = pCoded + codedSize;
+		if (codedSize < sizeof(uint16_t))
+		{
+			return(false);
+		}
+		uint16_t symbolCount = 0;
+		memcpy(&symbolCount, pCursor, sizeof(symbolCount));
+		pCursor += sizeof(symbolCount);
+		if ((symbolCount == 0) || (symbolCount > 256) || ((size_t)(pEnd - pCursor) < (size_t)symbolCount * 3 + 32))
+		{
+			return(false);
+		}
+
+		// the symbol in the low byte, the frequency less one in
+		// the next 12 bits and the distance in the top 12 bits
+		uint32_t slots[g_RansScale];
+		uint32_t start = 0;
+		int previousSymbol = -1;
+		for (uint32_t i = 0; i < symbolCount; i++)
+		{
+			int symbol = pCursor[0];
+			uint16_t frequency = 0;
+			memcpy(&frequency, pCursor + 1, sizeof(frequency));
+			pCursor += 3;
+			if ((symbol <= previousSymbol) || (frequency == 0) || (start + frequency > g_RansScale))
+			{
+				return(false);
+			}
+			for (uint32_t slot = 0; slot < frequency; slot++)
+			{
+				slots[start + slot] = (uint32_t)symbol | ((uint32_t)(frequency - 1) << 8) | (slot << 20);
+			}
+			start += frequency;
+			previousSymbol = symbol;
+		}
+		if (start != g_RansScale)
+		{
+			return(false);
+		}
+
+		// the states and stream cursors stay in locals, since
+		// the output bytes could otherwise alias them and force
+		// a reload on every store
+		uint32_t state0 = ReadUint32(pCursor);
+		uint32_t state1 = ReadUint32(pCursor + 4);
+		uint32_t state2 = ReadUint32(pCursor + 8);
+		uint32_t state3 = ReadUint32(pCursor + 12);
+		pCursor += 16;
+		const unsigned char* pWords[4];
+		const unsigned char* pWordsEnd[4];
+		const unsigned char* pLane = pCursor + 16;
+		for (int lane = 0; lane < 4; lane++)
+		{
+			size_t laneSize = ReadUint32(pCursor + lane * 4);
+			if ((laneSize & 1) || (laneSize > (size_t)(pEnd - pLane)))
+			{
+				return(false);
+			}
+			pWords[lane] = pLane;
+			pLane += laneSize;
+			pWordsEnd[lane] = pLane;
+		}
+		if (pLane != pEnd)
+		{
+			return(false);
+		}
+
+		const unsigned char* pWords0 = pWords[0];
+		const unsigned char* pWords1 = pWords[1];
+		const unsigned char* pWords2 = pWords[2];
+		const unsigned char* pWords3 = pWords[3];
+		size_t i = 0;
+		for (;;)
+		{
+			size_t groupCount = (size_t)std::min(
+				std::min(pWordsEnd[0] - pWords0, pWordsEnd[1] - pWords1),
+				std::min(pWordsEnd[2] - pWords2, pWordsEnd[3] - pWords3)) / sizeof(uint16_t);
+			groupCount = std::min(groupCount, (outputSize - i) / 4);
+			if (groupCount == 0)
+			{
+				break;
+			}
+			for (size_t group = 0; group < groupCount; group++)
+			{
+				unsigned char symbol0 = DecodeRansSymbol(state0, slots, pWords0);
+				unsigned char symbol1 = DecodeRansSymbol(state1, slots, pWords1);
+				unsigned char symbol2 = DecodeRansSymbol(state2, slots, pWords2);
+				unsigned char symbol3 = DecodeRansSymbol(state3, slots, pWords3);
+				pOutput[i] = symbol0;
+				pOutput[i + 1] = symbol1;
+				pOutput[i + 2] = symbol2;
+				pOutput[i + 3] = symbol3;
+				i += 4;
+			}
+		}
+		pWords[0] = pWords0;
+		pWords[1] = pWords1;
+		pWords[2] = pWords2;
+		pWords[3] = pWords3;
+		uint32_t states[4] = { state0, state1, state2, state3 };
+		for (; i < outputSize; i++)
+		{
+			int lane = (int)(i & 3);
+			uint32_t& state = states[lane];
+			uint32_t entry = slots[state & (g_RansScale - 1)];
+			pOutput[i] = (unsigned char)entry;
+			state = (((entry >> 8) & 0xFFF) + 1) * (state >> g_RansScaleBits) + (entry >> 20);
+			if (state < g_RansLowerBound)
+			{
+				uint16_t word = 0;
+				if (pWordsEnd[lane] - pWords[lane] < (ptrdiff_t)sizeof(word))
+				{
+					return(false);
+				}
+				memcpy(&word, pWords[lane], sizeof(word));
+				pWords[lane] += sizeof(word);
+				state = (state << 16) | word;
+			}
+		}
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if ((pWords[lane] != pWordsEnd[lane]) || (states[lane] != g_RansLowerBound))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	// append a stream, entropy coded when that makes it smaller
+	void EncodeStream(const unsigned char* pData, size_t size, std::vector<unsigned char>& output)
+	{
+		std::vector<unsigned char> coded;
+		if (size >= g_MinimumCodedStream)
+		{
+			EncodeRans(pData, size, coded);
+		}
+
+		STREAM_HEADER header;
+		header.rawSize = (uint32_t)size;
+		if (!coded.empty() && (coded.size() < size))
+		{
+			header.codedSize = (uint32_t)coded.size();
+			header.mode = STREAM_RANS;
+			AppendBytes(output, &header, sizeof(header));
+			AppendBytes(output, coded.data(), coded.size());
+		}
+		else
+		{
+			header.codedSize = (uint32_t)size;
+			header.mode = STREAM_RAW;
+			AppendBytes(output, &header, sizeof(header));
+			AppendBytes(output, pData, size);
+		}
+	}
+
+	// decode the stream at the cursor and step past it
+	bool DecodeStream(
+		const unsigned char*& pCursor,
+		const unsigned char* pEnd,
+		size_t maximumSize,
+		std::vector<unsigned char>& output)
+	{
+		STREAM_HEADER header;
+		if ((size_t)(pEnd - pCursor) < sizeof(header))
+		{
+			return(false);
+		}
+		memcpy(&header, pCursor, sizeof(header));
+		pCursor += sizeof(header);
+		if ((header.rawSize > maximumSize) || (header.codedSize > (size_t)(pEnd - pCursor)))
+		{
+			return(false);
+		}
+
+		output.resize(header.rawSize);
+		bool bDecoded = false;
+		if (header.mode == STREAM_RAW)
+		{
+			bDecoded = (header.codedSize == header.rawSize);
+			if (bDecoded && (header.rawSize > 0))
+			{
+				memcpy(output.data(), pCursor, header.rawSize);
+			}
+		}
+		else if (header.mode == STREAM_RANS)
+		{
+			bDecoded = DecodeRans(pCursor, header.codedSize, output.data(), header.rawSize);
+		}
+		pCursor += header.codedSize;
+		return(bDecoded);
+	}
+
+	/***********************************************************
+	 *  OptimizeVertexCache()
+	 *
+	 *  Reorders triangles so their vertices are still in the
+	 *  post-transform cache when the next triangles use them,
+	 *  fanning around one vertex at a time (Tipsify, Sander,
+	 *  Nehab and Barczak).  Neighboring triangles then share
+	 *  vertices, which also keeps the index differences small.
+	 ***********************************************************/
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+	{
+		size_t triangleCount = indices.size() / 3;
+		indices.resize(triangleCount * 3);
+
+		std::vector<uint32_t> starts((size_t)vertexCount + 1, 0);
+		for (uint32_t index : indices)
+		{
+			starts[index + 1]++;
+		}
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			starts[v + 1] += starts[v];
+		}
+		std::vector<uint32_t> triangles(indices.size());
+		std::vector<uint32_t> cursor(starts.begin(), starts.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			triangles[cursor[indices[i]]++] = (uint32_t)(i / 3);
+		}
+
+		std::vector<uint32_t> liveTriangles(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			liveTriangles[v] = starts[v + 1] - starts[v];
+		}
+		// when each vertex last went into the cache
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> deadEnd;
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		uint32_t time = g_VertexCacheSize + 1;
+		uint32_t scan = 0;
+		uint32_t fanning = g_NoVertex;
+		while ((scan < vertexCount) && (liveTriangles[scan] == 0))
+		{
+			scan++;
+		}
+		fanning = (scan < vertexCount) ? scan : g_NoVertex;
+
+		while (fanning != g_NoVertex)
+		{
+			candidates.clear();
+			for (uint32_t t = starts[fanning]; t < starts[fanning + 1]; t++)
+			{
+				uint32_t triangle = triangles[t];
+				if (emitted[triangle])
+				{
+					continue;
+				}
+				for (int corner = 0; corner < 3; corner++)
+				{
+					uint32_t v = indices[(size_t)triangle * 3 + corner];
+					output.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					liveTriangles[v]--;
+					if (time - cacheTime[v] > g_VertexCacheSize)
+					{
+						cacheTime[v] = time++;
+					}
+				}
+				emitted[triangle] = 1;
+			}
+
+			// fan next around the neighbor that will still be in the
+			// cache after its own triangles, oldest first
+			fanning = g_NoVertex;
+			int64_t bestPriority = -1;
+			for (uint32_t v : candidates)
+			{
+				if (liveTriangles[v] == 0)
+				{
+					continue;
+				}
+				int64_t priority = 0;
+				if (time - cacheTime[v] + 2 * liveTriangles[v] <= g_VertexCacheSize)
+				{
+					priority = time - cacheTime[v];
+				}
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanning = v;
+				}
+			}
+
+			// at a dead end, go back to recent vertices with triangles
+			// left, and failing those to the next in order
+			while ((fanning == g_NoVertex) && !deadEnd.empty())
+			{
+				uint32_t v = deadEnd.back();
+				deadEnd.pop_back();
+				fanning = (liveTriangles[v] > 0) ? v : g_NoVertex;
+			}
+			if (fanning == g_NoVertex)
+			{
+				while ((scan < vertexCount) && (liveTriangles[scan] == 0))
+				{
+					scan++;
+				}
+				fanning = (scan < vertexCount) ? scan : g_NoVertex;
+			}
+		}
+
+		indices.swap(output);
+	}
+
+	// the 10 bit normal component widened to 16 bits, so
+	// neighboring normals of opposite signs differ by little
+	uint16_t WidenNormalComponent(uint32_t bits)
+	{
+		return((uint16_t)(int16_t)((int32_t)(bits << 22) >> 22));
+	}
+
+	/***********************************************************
+	 *  EncodeVertexBlock()
+	 *
+	 *  Stores each 16 bit channel of the vertices as its zig
+	 *  zag coded difference from the vertex before, with the
+	 *  low bytes and the high bytes in separate streams.  The
+	 *  high bytes are nearly all zero and code to very little.
+	 ***********************************************************/
+	void EncodeVertexBlock(const uint16_t* pChannels, uint32_t vertexCount, std::vector<unsigned char>& output)
+	{
+		std::vector<unsigned char> lowBytes((size_t)vertexCount * g_VertexChannels);
+		std::vector<unsigned char> highBytes((size_t)vertexCount * g_VertexChannels);
+		uint16_t previous[g_VertexChannels] = {};
+		for (size_t i = 0; i < (size_t)vertexCount * g_VertexChannels; i++)
+		{
+			uint32_t channel = (uint32_t)(i % g_VertexChannels);
+			int16_t delta = (int16_t)(uint16_t)(pChannels[i] - previous[channel]);
+			uint16_t code = (uint16_t)((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15);
+			lowBytes[i] = (unsigned char)(code & 0xFF);
+			highBytes[i] = (unsigned char)(code >> 8);
+			previous[channel] = pChannels[i];
+		}
+		EncodeStream(lowBytes.data(), lowBytes.size(), output);
+		EncodeStream(highBytes.data(), highBytes.size(), output);
+	}
+
+	/***********************************************************
+	 *  RebuildVertices()
+	 *
+	 *  Sums the channel differences back up and writes whole
+	 *  vertices to the destination in order, never reading
+	 *  it, since a mapped buffer may be write combined.  With
+	 *  SSE2 the eight channels of a vertex are summed as the
+	 *  eight lanes of one register.
+	 ***********************************************************/
+	void RebuildVertices(
+		const unsigned char* pLowBytes,
+		const unsigned char* pHighBytes,
+		uint32_t vertexCount,
+		const ENCODED_MESH_HEADER& header,
+		COMPACT_VERTEX* pDestination)
+	{
+#if defined(MESH_CODEC_SIMD_SSE)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi16(1);
+		const __m128i normalMask = _mm_setr_epi16(0, 0, 0, 0x3FF, 0x3FF, 0x3FF, 0, 0);
+		const __m128 origin = _mm_setr_ps(header.positionOrigin[0], header.positionOrigin[1], header.positionOrigin[2], 0.0f);
+		const __m128 step = _mm_setr_ps(header.positionStep[0], header.positionStep[1], header.positionStep[2], 0.0f);
+
+		__m128i sum = zero;
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			__m128i code = _mm_unpacklo_epi8(
+				_mm_loadl_epi64((const __m128i*)(pLowBytes + (size_t)i * g_VertexChannels)),
+				_mm_loadl_epi64((const __m128i*)(pHighBytes + (size_t)i * g_VertexChannels)));
+			__m128i delta = _mm_xor_si128(_mm_srli_epi16(code, 1), _mm_sub_epi16(zero, _mm_and_si128(code, one)));
+			sum = _mm_add_epi16(sum, delta);
+
+			COMPACT_VERTEX vertex;
+			float position[4];
+			_mm_storeu_ps(position, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(sum, zero)), step), origin));
+			memcpy(vertex.position, position, sizeof(vertex.position));
+			__m128i normal = _mm_and_si128(sum, normalMask);
+			vertex.normal = (uint32_t)_mm_extract_epi16(normal, 3) |
+				((uint32_t)_mm_extract_epi16(normal, 4) << 10) |
+				((uint32_t)_mm_extract_epi16(normal, 5) << 20);
+			uint32_t uv = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 12));
+			memcpy(vertex.uv, &uv, sizeof(uv));
+			memcpy(pDestination + i, &vertex, sizeof(vertex));
+		}
+#else
+		uint16_t sum[g_VertexChannels] = {};
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			for (uint32_t channel = 0; channel < g_VertexChannels; channel++)
+			{
+				size_t byte = (size_t)i * g_VertexChannels + channel;
+				uint32_t code = (uint32_t)pLowBytes[byte] | ((uint32_t)pHighBytes[byte] << 8);
+				sum[channel] = (uint16_t)(sum[channel] + ((code >> 1) ^ (0u - (code & 1))));
+			}
+
+			COMPACT_VERTEX vertex;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				vertex.position[axis] = (float)sum[axis] * header.positionStep[axis] + header.positionOrigin[axis];
+			}
+			vertex.normal = ((uint32_t)sum[3] & 0x3FF) | (((uint32_t)sum[4] & 0x3FF) << 10) | (((uint32_t)sum[5] & 0x3FF) << 20);
+			vertex.uv[0] = sum[6];
+			vertex.uv[1] = sum[7];
+			memcpy(pDestination + i, &vertex, sizeof(vertex));
+		}
+#endif
+	}
+
+	// append the indices as zig zag coded differences from the
+	// index before, seven bits to a byte
+	void EncodeIndexBlock(const uint32_t* pIndices, uint32_t indexCount, std::vector<unsigned char>& output)
+	{
+		std::vector<unsigned char> bytes;
+		bytes.reserve((size_t)indexCount * 2);
+		uint32_t previous = 0;
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			int32_t delta = (int32_t)(pIndices[i] - previous);
+			uint32_t code = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+			while (code >= 0x80)
+			{
+				bytes.push_back((unsigned char)(code | 0x80));
+				code >>= 7;
+			}
+			bytes.push_back((unsigned char)code);
+			previous = pIndices[i];
+		}
+		EncodeStream(bytes.data(), bytes.size(), output);
+	}
+
+	// sum the index differences back up, checking every index
+	// against the vertices - a difference takes at most five
+	// bytes, so while that many are left the bytes are read
+	// without checking for the end
+	template <class INDEX>
+	bool RebuildIndices(const unsigned char* pBytes, size_t size, uint32_t indexCount, uint32_t vertexCount, INDEX* pDestination)
+	{
+		const unsigned char* pEnd = pBytes + size;
+		uint32_t index = 0;
+		uint32_t invalid = 0;
+		uint32_t i = 0;
+		for (; (i < indexCount) && (pEnd - pBytes >= 5); i++)
+		{
+			uint32_t code = *pBytes++;
+			if (code >= 0x80)
+			{
+				uint32_t shift = 7;
+				code &= 0x7F;
+				uint32_t byte = 0;
+				do
+				{
+					byte = *pBytes++;
+					code |= (byte & 0x7F) << shift;
+					shift += 7;
+				} while ((byte >= 0x80) && (shift < 35));
+				invalid |= (byte >= 0x80) ? 1 : 0;
+			}
+			index += (code >> 1) ^ (0u - (code & 1));
+			invalid |= (index >= vertexCount) ? 1 : 0;
+			pDestination[i] = (INDEX)index;
+		}
+		for (; i < indexCount; i++)
+		{
+			uint32_t code = 0;
+			for (uint32_t shift = 0; ; shift += 7)
+			{
+				if ((pBytes == pEnd) || (shift > 28))
+				{
+					return(false);
+				}
+				uint32_t byte = *pBytes++;
+				code |= (byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0)
+				{
+					break;
+				}
+			}
+			index += (code >> 1) ^ (0u - (code & 1));
+			invalid |= (index >= vertexCount) ? 1 : 0;
+			pDestination[i] = (INDEX)index;
+		}
+		return((invalid == 0) && (pBytes == pEnd));
+	}
+
+	// where a block of the encoded mesh begins and ends
+	void GetBlockRange(const unsigned char* pData, uint32_t block, const unsigned char*& pBegin, const unsigned char*& pEnd)
+	{
+		const unsigned char* pOffsets = pData + sizeof(ENCODED_MESH_HEADER);
+		pBegin = pData + ReadUint32(pOffsets + (size_t)block * sizeof(uint32_t));
+		pEnd = pData + ReadUint32(pOffsets + ((size_t)block + 1) * sizeof(uint32_t));
+	}
+}
+
+/***********************************************************
+ *  Encode()
+ *
+ *  This method is used for compressing a mesh with its
+ *  levels of detail.  Every level is put in vertex cache
+ *  order, and the vertices renumbered in the order the
+ *  levels first use them, which drops any no level uses.
+ ***********************************************************/
+bool MeshCodec::Encode(
+	const COMPACT_VERTEX* pVertices,
+	uint32_t vertexCount,
+	const uint32_t* pIndices,
+	uint32_t indexCount,
+	const std::vector<MESH_LOD>& lods,
+	std::vector<unsigned char>& encoded)
+{
+	encoded.clear();
+	if ((NULL == pVertices) || (NULL == pIndices) || (vertexCount == 0) || (indexCount == 0))
+	{
+		return(false);
+	}
+
+	uint32_t lodCount = (uint32_t)std::min<size_t>(lods.size() + 1, MESH_MAX_LODS);
+	std::vector<std::vector<uint32_t>> levels(lodCount);
+	for (uint32_t lod = 0; lod < lodCount; lod++)
+	{
+		if (lod == 0)
+		{
+			levels[lod].assign(pIndices, pIndices + indexCount);
+		}
+		else
+		{
+			levels[lod].assign(lods[lod - 1].indices.begin(), lods[lod - 1].indices.end());
+		}
+		for (uint32_t index : levels[lod])
+		{
+			if (index >= vertexCount)
+			{
+				return(false);
+			}
+		}
+		OptimizeVertexCache(levels[lod], vertexCount);
+	}
+
+	std::vector<uint32_t> remap(vertexCount, g_NoVertex);
+	std::vector<uint32_t> order;
+	for (std::vector<uint32_t>& level : levels)
+	{
+		for (uint32_t& index : level)
+		{
+			if (remap[index] == g_NoVertex)
+			{
+				remap[index] = (uint32_t)order.size();
+				order.push_back(index);
+			}
+			index = remap[index];
+		}
+	}
+
+	ENCODED_MESH_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.magic = MESH_CODEC_MAGIC;
+	header.version = MESH_CODEC_VERSION;
+	header.vertexCount = (uint32_t)order.size();
+	header.lodCount = lodCount;
+	for (uint32_t lod = 0; lod < lodCount; lod++)
+	{
+		header.lodIndexCount[lod] = (uint32_t)levels[lod].size();
+		header.lodError[lod] = (lod == 0) ? 0.0f : lods[lod - 1].error;
+	}
+
+	// quantize the positions across their bounds
+	glm::vec3 boundsMin(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+	for (uint32_t v : order)
+	{
+		glm::vec3 position(pVertices[v].position[0], pVertices[v].position[1], pVertices[v].position[2]);
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		header.positionOrigin[axis] = boundsMin[axis];
+		header.positionStep[axis] = (boundsMax[axis] - boundsMin[axis]) / g_PositionSteps;
+	}
+
+	std::vector<uint16_t> channels((size_t)header.vertexCount * g_VertexChannels);
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const COMPACT_VERTEX& vertex = pVertices[order[i]];
+		uint16_t* pChannels = &channels[i * g_VertexChannels];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float steps = (header.positionStep[axis] > 0.0f) ?
+				(vertex.position[axis] - header.positionOrigin[axis]) / header.positionStep[axis] : 0.0f;
+			pChannels[axis] = (uint16_t)std::min(std::max(std::lround(steps), 0L), 65535L);
+		}
+		// the unused two bits of the normal are not kept
+		pChannels[3] = WidenNormalComponent(vertex.normal & 0x3FF);
+		pChannels[4] = WidenNormalComponent((vertex.normal >> 10) & 0x3FF);
+		pChannels[5] = WidenNormalComponent((vertex.normal >> 20) & 0x3FF);
+		pChannels[6] = vertex.uv[0];
+		pChannels[7] = vertex.uv[1];
+	}
+
+	std::vector<uint32_t> allIndices;
+	for (const std::vector<uint32_t>& level : levels)
+	{
+		allIndices.insert(allIndices.end(), level.begin(), level.end());
+	}
+	header.vertexBlockCount = (header.vertexCount + g_VertexBlockSize - 1) / g_VertexBlockSize;
+	header.indexBlockCount = (uint32_t)((allIndices.size() + g_IndexBlockSize - 1) / g_IndexBlockSize);
+
+	std::vector<unsigned char> blocks;
+	std::vector<uint32_t> offsets;
+	uint32_t tableEnd = (uint32_t)(sizeof(ENCODED_MESH_HEADER) + (header.vertexBlockCount + header.indexBlockCount + 1) * sizeof(uint32_t));
+	for (uint32_t block = 0; block < header.vertexBlockCount; block++)
+	{
+		uint32_t first = block * g_VertexBlockSize;
+		offsets.push_back(tableEnd + (uint32_t)blocks.size());
+		EncodeVertexBlock(&channels[(size_t)first * g_VertexChannels], std::min(g_VertexBlockSize, header.vertexCount - first), blocks);
+	}
+	for (uint32_t block = 0; block < header.indexBlockCount; block++)
+	{
+		size_t first = (size_t)block * g_IndexBlockSize;
+		offsets.push_back(tableEnd + (uint32_t)blocks.size());
+		EncodeIndexBlock(&allIndices[first], (uint32_t)std::min<size_t>(g_IndexBlockSize, allIndices.size() - first), blocks);
+	}
+	offsets.push_back(tableEnd + (uint32_t)blocks.size());
+
+	AppendBytes(encoded, &header, sizeof(header));
+	AppendBytes(encoded, offsets.data(), offsets.size() * sizeof(uint32_t));
+	AppendBytes(encoded, blocks.data(), blocks.size());
+	return(true);
+}
+
+/***********************************************************
+ *  ReadHeader()
+ *
+ *  This method is used for reading the header of an encoded
+ *  mesh and checking that the counts agree with each other
+ *  and that every block lies inside the data in order.
+ ***********************************************************/
+bool MeshCodec::ReadHeader(const unsigned char* pData, size_t size, ENCODED_MESH_HEADER& header)
+{
+	if ((NULL == pData) || (size < sizeof(ENCODED_MESH_HEADER)))
+	{
+		return(false);
+	}
+	memcpy(&header, pData, sizeof(header));
+	if ((header.magic != MESH_CODEC_MAGIC) || (header.version != MESH_CODEC_VERSION) ||
+		(header.vertexCount == 0) || (header.lodCount == 0) || (header.lodCount > MESH_MAX_LODS))
+	{
+		return(false);
+	}
+
+	uint64_t totalIndexCount = 0;
+	for (uint32_t lod = 0; lod < header.lodCount; lod++)
+	{
+		totalIndexCount += header.lodIndexCount[lod];
+	}
+	if ((totalIndexCount == 0) || (totalIndexCount > std::numeric_limits<uint32_t>::max()) ||
+		(header.vertexBlockCount != (header.vertexCount + g_VertexBlockSize - 1) / g_VertexBlockSize) ||
+		(header.indexBlockCount != (totalIndexCount + g_IndexBlockSize - 1) / g_IndexBlockSize))
+	{
+		return(false);
+	}
+
+	size_t blockCount = (size_t)header.vertexBlockCount + header.indexBlockCount;
+	size_t tableEnd = sizeof(ENCODED_MESH_HEADER) + (blockCount + 1) * sizeof(uint32_t);
+	if (tableEnd > size)
+	{
+		return(false);
+	}
+	size_t previous = tableEnd;
+	for (size_t block = 0; block <= blockCount; block++)
+	{
+		size_t offset = ReadUint32(pData + sizeof(ENCODED_MESH_HEADER) + block * sizeof(uint32_t));
+		if ((offset < previous) || (offset > size))
+		{
+			return(false);
+		}
+		previous = offset;
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  GetTotalIndexCount()
+ *
+ *  This method is used for adding up the indices of every
+ *  level of detail.
+ ***********************************************************/
+uint32_t MeshCodec::GetTotalIndexCount(const ENCODED_MESH_HEADER& header)
+{
+	uint32_t totalIndexCount = 0;
+	for (uint32_t lod = 0; (lod < header.lodCount) && (lod < MESH_MAX_LODS); lod++)
+	{
+		totalIndexCount += header.lodIndexCount[lod];
+	}
+	return(totalIndexCount);
+}
+
+/***********************************************************
+ *  DecodeVertices()
+ *
+ *  This method is used for decoding every vertex block on
+ *  the job system at once, each through its own scratch
+ *  buffer into its part of the destination.
+ ***********************************************************/
+bool MeshCodec::DecodeVertices(const unsigned char* pData, size_t size, COMPACT_VERTEX* pDestination)
+{
+	ENCODED_MESH_HEADER header;
+	if ((NULL == pDestination) || (ReadHeader(pData, size, header) == false))
+	{
+		return(false);
+	}
+
+	std::vector<uint8_t> decoded(header.vertexBlockCount, 0);
+	JobSystem::ParallelFor(header.vertexBlockCount, 1, [&](size_t begin, size_t end)
+	{
+		std::vector<unsigned char> lowBytes;
+		std::vector<unsigned char> highBytes;
+		for (size_t block = begin; block < end; block++)
+		{
+			uint32_t first = (uint32_t)block * g_VertexBlockSize;
+			uint32_t count = std::min(g_VertexBlockSize, header.vertexCount - first);
+			size_t streamSize = (size_t)count * g_VertexChannels;
+			const unsigned char* pCursor = NULL;
+			const unsigned char* pEnd = NULL;
+			GetBlockRange(pData, (uint32_t)block, pCursor, pEnd);
+			if (DecodeStream(pCursor, pEnd, streamSize, lowBytes) &&
+				DecodeStream(pCursor, pEnd, streamSize, highBytes) &&
+				(lowBytes.size() == streamSize) && (highBytes.size() == streamSize) &&
+				(pCursor == pEnd))
+			{
+				RebuildVertices(lowBytes.data(), highBytes.data(), count, header, pDestination + first);
+				decoded[block] = 1;
+			}
+		}
+	});
+
+	return(std::find(decoded.begin(), decoded.end(), 0) == decoded.end());
+}
+
+/***********************************************************
+ *  DecodeIndices()
+ *
+ *  This method is used for decoding every index block on
+ *  the job system at once into 16 or 32 bit indices.  Any
+ *  index past the vertices fails the decode, so a damaged
+ *  file never makes the GPU read outside the vertex buffer.
+ ***********************************************************/
+bool MeshCodec::DecodeIndices(const unsigned char* pData, size_t size, void* pDestination, size_t indexSize)
+{
+	ENCODED_MESH_HEADER header;
+	if ((NULL == pDestination) || ((indexSize != sizeof(uint16_t)) && (indexSize != sizeof(uint32_t))) ||
+		(ReadHeader(pData, size, header) == false) ||
+		((indexSize == sizeof(uint16_t)) && (header.vertexCount > 65536)))
+	{
+		return(false);
+	}
+
+	uint32_t totalIndexCount = GetTotalIndexCount(header);
+	std::vector<uint8_t> decoded(header.indexBlockCount, 0);
+	JobSystem::ParallelFor(header.indexBlockCount, 1, [&](size_t begin, size_t end)
+	{
+		std::vector<unsigned char> bytes;
+		for (size_t block = begin; block < end; block++)
+		{
+			size_t first = block * g_IndexBlockSize;
+			uint32_t count = (uint32_t)std::min<size_t>(g_IndexBlockSize, totalIndexCount - first);
+			const unsigned char* pCursor = NULL;
+			const unsigned char* pEnd = NULL;
+			GetBlockRange(pData, header.vertexBlockCount + (uint32_t)block, pCursor, pEnd);
+			// an index takes at most five bytes
+			if (!DecodeStream(pCursor, pEnd, (size_t)count * 5, bytes) || (pCursor != pEnd))
+			{
+				continue;
+			}
+			bool bRebuilt = (indexSize == sizeof(uint16_t)) ?
+				RebuildIndices(bytes.data(), bytes.size(), count, header.vertexCount, (uint16_t*)pDestination + first) :
+				RebuildIndices(bytes.data(), bytes.size(), count, header.vertexCount, (uint32_t*)pDestination + first);
+			decoded[block] = bRebuilt ? 1 : 0;
+		}
+	});
+
+	return(std::find(decoded.begin(), decoded.end(), 0) == decoded.end());
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcodec.h
+// ============
+// compress compact meshes and decode them straight into buffers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ModelMeshes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// identifies an encoded mesh and its layout version
+const uint32_t MESH_CODEC_MAGIC = 0x4D434D53; // "SMCM"
+const uint32_t MESH_CODEC_VERSION = 1;
+
+/***********************************************************
+ *  ENCODED_MESH_HEADER
+ *
+ *  An encoded mesh is this header, the byte offsets of its
+ *  vertex blocks then its index blocks with one more offset
+ *  for the end of the last, and the blocks.  Every block
+ *  decodes on its own, so the blocks of a mesh are decoded
+ *  on the job system at once.
+ ***********************************************************/
+struct ENCODED_MESH_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertexCount;
+	// levels of detail counting the full mesh, whose indices
+	// follow one another in the index blocks
+	uint32_t lodCount;
+	uint32_t lodIndexCount[MESH_MAX_LODS];
+	float lodError[MESH_MAX_LODS];
+	// a quantized position is the origin plus its steps
+	float positionOrigin[3];
+	float positionStep[3];
+	uint32_t vertexBlockCount;
+	uint32_t indexBlockCount;
+};
+
+static_assert(sizeof(ENCODED_MESH_HEADER) == 112, "encoded mesh header layout changed");
+
+/***********************************************************
+ *  MeshCodec
+ *
+ *  This class compresses a compact mesh with its levels of
+ *  detail for storing on disk.  The triangles are put in
+ *  vertex cache order and the vertices in the order the
+ *  triangles first use them, positions are quantized to 16
+ *  bits across the bounds, and each vertex is stored as the
+ *  difference from the one before.  The indices are stored
+ *  as differences from the index before.  Both then go
+ *  through an order 0 rANS entropy coder.
+ *
+ *  Decoding never builds the mesh in memory first: the
+ *  entropy coded bytes of one block are decoded into a
+ *  small scratch buffer, and the vertices and indices are
+ *  rebuilt from it, with SSE2 where the build targets it,
+ *  directly into the destination, normally a mapped
+ *  OpenGL buffer.
+ ***********************************************************/
+class MeshCodec
+{
+public:
+	// encode a mesh and its levels of detail - false if an
+	// index is past the vertices
+	static bool Encode(
+		const COMPACT_VERTEX* pVertices,
+		uint32_t vertexCount,
+		const uint32_t* pIndices,
+		uint32_t indexCount,
+		const std::vector<MESH_LOD>& lods,
+		std::vector<unsigned char>& encoded);
+
+	// read the header of an encoded mesh, checking that its
+	// block table lies inside the data
+	static bool ReadHeader(const unsigned char* pData, size_t size, ENCODED_MESH_HEADER& header);
+	// the indices of every level of detail together
+	static uint32_t GetTotalIndexCount(const ENCODED_MESH_HEADER& header);
+
+	// decode the vertices into room for the header's vertex count
+	static bool DecodeVertices(const unsigned char* pData, size_t size, COMPACT_VERTEX* pDestination);
+	// decode the indices of every level of detail into room for
+	// the total index count, as 16 or 32 bit indices
+	static bool DecodeIndices(const unsigned char* pData, size_t size, void* pDestination, size_t indexSize);
+};
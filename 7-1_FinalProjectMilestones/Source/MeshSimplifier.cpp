@@ -0,0 +1,689 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.cpp
+// ============
+// quadric error simplification of compact meshes into LOD chains
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshSimplifier.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+const std::vector<float> MESH_DEFAULT_LOD_RATIOS = { 0.5f, 0.25f, 0.1f };
+
+// declaration of global variables
+namespace
+{
+	// how much more an open boundary resists moving than the
+	// faces along it
+	const float g_BorderWeight = 10.0f;
+
+	// a boundary vertex whose two open edges turn by more than
+	// about 25 degrees is a corner, measured as the length of
+	// the difference of their directions
+	const float g_BorderCornerTurn = 0.43f;
+
+	// a pass applies collapses up to the error of the one this
+	// far past the count that would meet the target, leaving
+	// the rest for the cheaper collapses the next pass finds
+	const float g_PassErrorSlack = 1.5f;
+
+	// but never fewer than this share of the candidates, so the
+	// passes close to the target are not left with a handful
+	const size_t g_PassMinimumShare = 16;
+
+	// positions whose collapses are weighed by one job
+	const size_t g_PositionBatchSize = 4096;
+
+	// what each position may do when it is collapsed
+	enum VERTEX_KIND
+	{
+		// inside the surface with a single vertex - may collapse
+		// onto any neighbor
+		VERTEX_MANIFOLD,
+		// on an open boundary - only along the boundary
+		VERTEX_BORDER,
+		// two vertices with different attributes - only along
+		// the seam
+		VERTEX_SEAM,
+		// boundary corners, seam junctions and seams on a
+		// boundary never move
+		VERTEX_LOCKED
+	};
+
+	/***********************************************************
+	 *  QUADRIC
+	 *
+	 *  The summed squared distance to a set of weighted planes,
+	 *  as the symmetric matrix A, the vector b and the constant
+	 *  c of p'Ap + 2b'p + c, along with the summed weight.
+	 *  The terms are far larger than their sum near a plane,
+	 *  so they are kept in doubles - in floats the rounding
+	 *  alone reads as a millimeter of error on a unit mesh.
+	 ***********************************************************/
+	struct QUADRIC
+	{
+		double a00, a11, a22, a01, a02, a12;
+		double b0, b1, b2;
+		double c;
+		double weight;
+	};
+
+	// add the plane with the unit normal through the point
+	void AddPlane(QUADRIC& quadric, const glm::vec3& normal, const glm::vec3& point, double weight)
+	{
+		double x = normal.x;
+		double y = normal.y;
+		double z = normal.z;
+		double distance = -(x * point.x + y * point.y + z * point.z);
+		quadric.a00 += weight * x * x;
+		quadric.a11 += weight * y * y;
+		quadric.a22 += weight * z * z;
+		quadric.a01 += weight * x * y;
+		quadric.a02 += weight * x * z;
+		quadric.a12 += weight * y * z;
+		quadric.b0 += weight * x * distance;
+		quadric.b1 += weight * y * distance;
+		quadric.b2 += weight * z * distance;
+		quadric.c += weight * distance * distance;
+		quadric.weight += weight;
+	}
+
+	void AddQuadric(QUADRIC& quadric, const QUADRIC& other)
+	{
+		quadric.a00 += other.a00;
+		quadric.a11 += other.a11;
+		quadric.a22 += other.a22;
+		quadric.a01 += other.a01;
+		quadric.a02 += other.a02;
+		quadric.a12 += other.a12;
+		quadric.b0 += other.b0;
+		quadric.b1 += other.b1;
+		quadric.b2 += other.b2;
+		quadric.c += other.c;
+		quadric.weight += other.weight;
+	}
+
+	// weighted squared distance of a point to the planes
+	double EvaluateQuadric(const QUADRIC& quadric, const glm::vec3& point)
+	{
+		double x = point.x;
+		double y = point.y;
+		double z = point.z;
+		double error =
+			quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z +
+			2.0 * (quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z) +
+			2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z) +
+			quadric.c;
+		return(std::max(error, 0.0));
+	}
+
+	// the error as an average distance in model units
+	float GetDistanceError(double error, double weight)
+	{
+		return((weight > 0.0) ? (float)std::sqrt(error / weight) : 0.0f);
+	}
+
+	struct COLLAPSE
+	{
+		uint32_t from;
+		uint32_t to;
+		double error;
+	};
+
+	struct POSITION_KEY
+	{
+		uint32_t bits[3];
+
+		bool operator==(const POSITION_KEY& other) const
+		{
+			return((bits[0] == other.bits[0]) && (bits[1] == other.bits[1]) && (bits[2] == other.bits[2]));
+		}
+	};
+
+	struct POSITION_KEY_HASH
+	{
+		size_t operator()(const POSITION_KEY& key) const
+		{
+			uint64_t hash = (uint64_t)key.bits[0] * 0x9E3779B97F4A7C15ull;
+			hash ^= (uint64_t)key.bits[1] * 0xC2B2AE3D27D4EB4Full + (hash >> 29);
+			hash ^= (uint64_t)key.bits[2] * 0x165667B19E3779F9ull + (hash >> 32);
+			return((size_t)(hash ^ (hash >> 31)));
+		}
+	};
+
+	/***********************************************************
+	 *  SIMPLIFY_SESSION
+	 *
+	 *  The state carried from one level of detail to the next.
+	 *  Vertices are grouped by position, and the quadrics,
+	 *  kinds and triangle lists are kept per position - the
+	 *  first vertex found at a position stands for all of its
+	 *  copies.
+	 ***********************************************************/
+	struct SIMPLIFY_SESSION
+	{
+		const COMPACT_VERTEX* pVertices;
+		uint32_t vertexCount;
+		// the vertex standing for the position of each vertex
+		std::vector<uint32_t> positionOf;
+		std::vector<uint8_t> kinds;
+		std::vector<QUADRIC> quadrics;
+		MeshVector<uint32_t> indices;
+		// farthest any collapse so far moved the surface
+		float maxError;
+
+		// triangles around each position, rebuilt every pass
+		std::vector<uint32_t> triangleStarts;
+		std::vector<uint32_t> triangleLists;
+
+		glm::vec3 GetPosition(uint32_t vertex) const
+		{
+			const float* p = pVertices[vertex].position;
+			return(glm::vec3(p[0], p[1], p[2]));
+		}
+	};
+
+	// list the triangles around every position
+	void BuildTriangleLists(SIMPLIFY_SESSION& session)
+	{
+		session.triangleStarts.assign((size_t)session.vertexCount + 1, 0);
+		for (uint32_t index : session.indices)
+		{
+			session.triangleStarts[session.positionOf[index] + 1]++;
+		}
+		for (size_t i = 1; i < session.triangleStarts.size(); i++)
+		{
+			session.triangleStarts[i] += session.triangleStarts[i - 1];
+		}
+
+		session.triangleLists.resize(session.indices.size());
+		std::vector<uint32_t> cursor(session.triangleStarts.begin(), session.triangleStarts.end() - 1);
+		for (size_t i = 0; i < session.indices.size(); i++)
+		{
+			session.triangleLists[cursor[session.positionOf[session.indices[i]]]++] = (uint32_t)(i / 3);
+		}
+	}
+
+	// number of the triangles around one position that also use
+	// another - one for an edge on an open boundary
+	uint32_t CountEdgeTriangles(const SIMPLIFY_SESSION& session, uint32_t from, uint32_t to)
+	{
+		uint32_t count = 0;
+		for (uint32_t t = session.triangleStarts[from]; t < session.triangleStarts[from + 1]; t++)
+		{
+			const uint32_t* pTriangle = &session.indices[(size_t)session.triangleLists[t] * 3];
+			for (int corner = 0; corner < 3; corner++)
+			{
+				count += (session.positionOf[pTriangle[corner]] == to) ? 1 : 0;
+			}
+		}
+		return(count);
+	}
+
+	bool IsCollapseAllowed(const SIMPLIFY_SESSION& session, uint32_t from, uint32_t to)
+	{
+		switch (session.kinds[from])
+		{
+		case VERTEX_MANIFOLD:
+			return(true);
+		case VERTEX_BORDER:
+			return(((session.kinds[to] == VERTEX_BORDER) || (session.kinds[to] == VERTEX_LOCKED)) &&
+				(CountEdgeTriangles(session, from, to) == 1));
+		case VERTEX_SEAM:
+			return((session.kinds[to] == VERTEX_SEAM) || (session.kinds[to] == VERTEX_LOCKED));
+		default:
+			return(false);
+		}
+	}
+
+	/***********************************************************
+	 *  InitializeSession()
+	 *
+	 *  Groups the vertices by position, sorts every position
+	 *  into its kind and sums the plane quadrics of the faces
+	 *  and open boundary edges around it.
+	 ***********************************************************/
+	void InitializeSession(
+		SIMPLIFY_SESSION& session,
+		const COMPACT_VERTEX* pVertices,
+		uint32_t vertexCount,
+		const uint32_t* pIndices,
+		size_t indexCount)
+	{
+		session.pVertices = pVertices;
+		session.vertexCount = vertexCount;
+		session.maxError = 0.0f;
+
+		session.indices.reserve(indexCount - indexCount % 3);
+		for (size_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			if ((pIndices[i] < vertexCount) && (pIndices[i + 1] < vertexCount) && (pIndices[i + 2] < vertexCount))
+			{
+				session.indices.insert(session.indices.end(), pIndices + i, pIndices + i + 3);
+			}
+		}
+
+		// minus zero is the same position as zero
+		session.positionOf.resize(vertexCount);
+		std::unordered_map<POSITION_KEY, uint32_t, POSITION_KEY_HASH> vertexAtPosition;
+		vertexAtPosition.reserve(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			POSITION_KEY key;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float value = pVertices[v].position[axis] + 0.0f;
+				memcpy(&key.bits[axis], &value, sizeof(value));
+			}
+			session.positionOf[v] = vertexAtPosition.emplace(key, v).first->second;
+		}
+
+		// drop the triangles that are already degenerate
+		size_t written = 0;
+		for (size_t i = 0; i < session.indices.size(); i += 3)
+		{
+			uint32_t p0 = session.positionOf[session.indices[i]];
+			uint32_t p1 = session.positionOf[session.indices[i + 1]];
+			uint32_t p2 = session.positionOf[session.indices[i + 2]];
+			if ((p0 != p1) && (p1 != p2) && (p0 != p2))
+			{
+				memmove(&session.indices[written], &session.indices[i], 3 * sizeof(uint32_t));
+				written += 3;
+			}
+		}
+		session.indices.resize(written);
+		BuildTriangleLists(session);
+
+		// the copies of each position the triangles use
+		std::vector<uint8_t> used(vertexCount, 0);
+		std::vector<uint32_t> copies(vertexCount, 0);
+		for (uint32_t index : session.indices)
+		{
+			if (used[index] == 0)
+			{
+				used[index] = 1;
+				copies[session.positionOf[index]]++;
+			}
+		}
+
+		session.quadrics.assign(vertexCount, QUADRIC());
+		std::vector<uint32_t> openEdges(vertexCount, 0);
+		std::vector<glm::vec3> openTurn(vertexCount, glm::vec3(0.0f));
+		for (size_t i = 0; i < session.indices.size(); i += 3)
+		{
+			uint32_t corners[3] =
+			{
+				session.positionOf[session.indices[i]],
+				session.positionOf[session.indices[i + 1]],
+				session.positionOf[session.indices[i + 2]]
+			};
+			glm::vec3 p0 = session.GetPosition(corners[0]);
+			glm::vec3 p1 = session.GetPosition(corners[1]);
+			glm::vec3 p2 = session.GetPosition(corners[2]);
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float length = glm::length(normal);
+			if (length <= 0.0f)
+			{
+				continue;
+			}
+			normal /= length;
+
+			// the faces are weighted by their area
+			QUADRIC face = {};
+			AddPlane(face, normal, p0, length * 0.5);
+			for (int corner = 0; corner < 3; corner++)
+			{
+				AddQuadric(session.quadrics[corners[corner]], face);
+			}
+
+			// an open edge adds a plane at right angles to the face,
+			// so moving its vertices off the boundary line costs
+			for (int edge = 0; edge < 3; edge++)
+			{
+				uint32_t from = corners[edge];
+				uint32_t to = corners[(edge + 1) % 3];
+				if (CountEdgeTriangles(session, from, to) != 1)
+				{
+					continue;
+				}
+				openEdges[from]++;
+				openEdges[to]++;
+
+				glm::vec3 pFrom = session.GetPosition(from);
+				glm::vec3 edgeVector = session.GetPosition(to) - pFrom;
+				glm::vec3 direction = glm::normalize(edgeVector);
+				openTurn[from] -= direction;
+				openTurn[to] += direction;
+				glm::vec3 edgeNormal = glm::cross(edgeVector, normal);
+				float edgeLength = glm::length(edgeNormal);
+				if (edgeLength > 0.0f)
+				{
+					edgeNormal /= edgeLength;
+					QUADRIC border = {};
+					AddPlane(border, edgeNormal, pFrom, (double)glm::dot(edgeVector, edgeVector) * g_BorderWeight);
+					AddQuadric(session.quadrics[from], border);
+					AddQuadric(session.quadrics[to], border);
+				}
+			}
+		}
+
+		// a boundary vertex passes straight along exactly two open
+		// edges, and a seam has one copy on either side
+		session.kinds.assign(vertexCount, VERTEX_LOCKED);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			if ((session.positionOf[v] != v) || (copies[v] == 0))
+			{
+				continue;
+			}
+			if (openEdges[v] == 0)
+			{
+				session.kinds[v] = (copies[v] == 1) ? VERTEX_MANIFOLD : (copies[v] == 2) ? VERTEX_SEAM : VERTEX_LOCKED;
+			}
+			else
+			{
+				bool bStraight = (glm::length(openTurn[v]) < g_BorderCornerTurn);
+				session.kinds[v] = ((openEdges[v] == 2) && (copies[v] == 1) && bStraight) ? VERTEX_BORDER : VERTEX_LOCKED;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  SimplifyPass()
+	 *
+	 *  Picks the cheapest allowed collapse out of every
+	 *  position, then applies them from the cheapest up until
+	 *  the target is met or, when limited, the error passes
+	 *  the limit for this pass.  A collapse changes the triangles around the
+	 *  collapsed position, so every position they touch waits
+	 *  for the next pass.  Returns the number of collapses
+	 *  applied.
+	 ***********************************************************/
+	size_t SimplifyPass(SIMPLIFY_SESSION& session, size_t targetIndexCount, bool bLimitError)
+	{
+		BuildTriangleLists(session);
+
+		// the quadrics add up, so the error of a collapse is the
+		// error of the moved position at the target plus that of
+		// the target where it already is
+		std::vector<double> ownError(session.vertexCount, 0.0);
+		std::vector<COLLAPSE> best(session.vertexCount, { 0, 0, std::numeric_limits<double>::max() });
+		JobSystem::ParallelFor(session.vertexCount, g_PositionBatchSize, [&](size_t begin, size_t end)
+		{
+			for (size_t v = begin; v < end; v++)
+			{
+				if (session.triangleStarts[v] < session.triangleStarts[v + 1])
+				{
+					ownError[v] = EvaluateQuadric(session.quadrics[v], session.GetPosition((uint32_t)v));
+				}
+			}
+		});
+		JobSystem::ParallelFor(session.vertexCount, g_PositionBatchSize, [&](size_t begin, size_t end)
+		{
+			for (size_t v = begin; v < end; v++)
+			{
+				uint32_t from = (uint32_t)v;
+				if (session.kinds[from] == VERTEX_LOCKED)
+				{
+					continue;
+				}
+				for (uint32_t t = session.triangleStarts[from]; t < session.triangleStarts[from + 1]; t++)
+				{
+					const uint32_t* pTriangle = &session.indices[(size_t)session.triangleLists[t] * 3];
+					for (int corner = 0; corner < 3; corner++)
+					{
+						uint32_t to = session.positionOf[pTriangle[corner]];
+						if (to == from)
+						{
+							continue;
+						}
+						double error = EvaluateQuadric(session.quadrics[from], session.GetPosition(to)) + ownError[to];
+						if ((error < best[from].error) && IsCollapseAllowed(session, from, to))
+						{
+							best[from] = { from, to, error };
+						}
+					}
+				}
+			}
+		});
+
+		std::vector<COLLAPSE> collapses;
+		for (const COLLAPSE& collapse : best)
+		{
+			if (collapse.error < std::numeric_limits<double>::max())
+			{
+				collapses.push_back(collapse);
+			}
+		}
+		if (collapses.empty())
+		{
+			return(0);
+		}
+
+		// a collapse removes about two triangles, and only the
+		// collapses under the limit need to be in order
+		size_t needed = (session.indices.size() - std::min(targetIndexCount, session.indices.size())) / 6 + 1;
+		size_t limitIndex = collapses.size() - 1;
+		if (bLimitError)
+		{
+			size_t limited = std::max((size_t)((float)needed * g_PassErrorSlack), collapses.size() / g_PassMinimumShare);
+			limitIndex = std::min(limited, limitIndex);
+		}
+		auto cheaper = [](const COLLAPSE& a, const COLLAPSE& b) { return a.error < b.error; };
+		std::nth_element(collapses.begin(), collapses.begin() + limitIndex, collapses.end(), cheaper);
+		std::sort(collapses.begin(), collapses.begin() + limitIndex, cheaper);
+		double errorLimit = bLimitError ? collapses[limitIndex].error : std::numeric_limits<double>::max();
+
+		std::vector<uint8_t> touched(session.vertexCount, 0);
+		std::vector<uint32_t> replacement(session.vertexCount);
+		for (uint32_t v = 0; v < session.vertexCount; v++)
+		{
+			replacement[v] = v;
+		}
+
+		size_t indexCount = session.indices.size();
+		size_t applied = 0;
+		std::vector<std::pair<uint32_t, uint32_t>> pairs;
+		for (const COLLAPSE& collapse : collapses)
+		{
+			if ((indexCount <= targetIndexCount) || (collapse.error > errorLimit))
+			{
+				break;
+			}
+			if (touched[collapse.from] || touched[collapse.to])
+			{
+				continue;
+			}
+
+			// every copy of the position has to move onto a copy of
+			// the other end it shares an edge with
+			pairs.clear();
+			bool bPaired = true;
+			uint32_t removedTriangles = 0;
+			glm::vec3 target = session.GetPosition(collapse.to);
+			for (uint32_t t = session.triangleStarts[collapse.from]; bPaired && (t < session.triangleStarts[collapse.from + 1]); t++)
+			{
+				const uint32_t* pTriangle = &session.indices[(size_t)session.triangleLists[t] * 3];
+				int fromCorner = -1;
+				int toCorner = -1;
+				for (int corner = 0; corner < 3; corner++)
+				{
+					fromCorner = (session.positionOf[pTriangle[corner]] == collapse.from) ? corner : fromCorner;
+					toCorner = (session.positionOf[pTriangle[corner]] == collapse.to) ? corner : toCorner;
+				}
+				if (toCorner >= 0)
+				{
+					removedTriangles++;
+					bool bKnown = false;
+					for (const std::pair<uint32_t, uint32_t>& pair : pairs)
+					{
+						if (pair.first == pTriangle[fromCorner])
+						{
+							// a copy meeting two copies of the other end
+							// would tear the seam
+							bKnown = true;
+							bPaired = (pair.second == pTriangle[toCorner]);
+						}
+					}
+					if (!bKnown)
+					{
+						pairs.push_back(std::make_pair(pTriangle[fromCorner], pTriangle[toCorner]));
+					}
+					continue;
+				}
+
+				// the triangles left must not fold over
+				glm::vec3 p[3] =
+				{
+					session.GetPosition(pTriangle[0]),
+					session.GetPosition(pTriangle[1]),
+					session.GetPosition(pTriangle[2])
+				};
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				p[fromCorner] = target;
+				glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+				bPaired = (glm::dot(before, after) > 0.0f);
+			}
+			for (uint32_t t = session.triangleStarts[collapse.from]; bPaired && (t < session.triangleStarts[collapse.from + 1]); t++)
+			{
+				const uint32_t* pTriangle = &session.indices[(size_t)session.triangleLists[t] * 3];
+				for (int corner = 0; corner < 3; corner++)
+				{
+					if (session.positionOf[pTriangle[corner]] != collapse.from)
+					{
+						continue;
+					}
+					bool bFound = false;
+					for (const std::pair<uint32_t, uint32_t>& pair : pairs)
+					{
+						bFound |= (pair.first == pTriangle[corner]);
+					}
+					bPaired = bFound;
+				}
+			}
+			if (!bPaired || (removedTriangles == 0))
+			{
+				continue;
+			}
+
+			for (const std::pair<uint32_t, uint32_t>& pair : pairs)
+			{
+				replacement[pair.first] = pair.second;
+			}
+			AddQuadric(session.quadrics[collapse.to], session.quadrics[collapse.from]);
+			session.maxError = std::max(session.maxError,
+				GetDistanceError(collapse.error, session.quadrics[collapse.to].weight));
+
+			touched[collapse.from] = 1;
+			touched[collapse.to] = 1;
+			for (uint32_t t = session.triangleStarts[collapse.from]; t < session.triangleStarts[collapse.from + 1]; t++)
+			{
+				const uint32_t* pTriangle = &session.indices[(size_t)session.triangleLists[t] * 3];
+				for (int corner = 0; corner < 3; corner++)
+				{
+					touched[session.positionOf[pTriangle[corner]]] = 1;
+				}
+			}
+			indexCount -= std::min<size_t>((size_t)removedTriangles * 3, indexCount);
+			applied++;
+		}
+		if (applied == 0)
+		{
+			return(0);
+		}
+
+		// move the collapsed vertices and drop the triangles that
+		// lost an edge
+		size_t written = 0;
+		for (size_t i = 0; i < session.indices.size(); i += 3)
+		{
+			uint32_t v0 = replacement[session.indices[i]];
+			uint32_t v1 = replacement[session.indices[i + 1]];
+			uint32_t v2 = replacement[session.indices[i + 2]];
+			uint32_t p0 = session.positionOf[v0];
+			uint32_t p1 = session.positionOf[v1];
+			uint32_t p2 = session.positionOf[v2];
+			if ((p0 == p1) || (p1 == p2) || (p0 == p2))
+			{
+				continue;
+			}
+			session.indices[written++] = v0;
+			session.indices[written++] = v1;
+			session.indices[written++] = v2;
+		}
+		session.indices.resize(written);
+		return(applied);
+	}
+}
+
+/***********************************************************
+ *  BuildLodChain()
+ *
+ *  This method is used for simplifying a mesh down through
+ *  each ratio in turn and keeping the indices and error at
+ *  every step.
+ ***********************************************************/
+void MeshSimplifier::BuildLodChain(
+	const COMPACT_VERTEX* pVertices,
+	uint32_t vertexCount,
+	const uint32_t* pIndices,
+	size_t indexCount,
+	const std::vector<float>& ratios,
+	std::vector<MESH_LOD>& lods)
+{
+	lods.clear();
+	if ((NULL == pVertices) || (NULL == pIndices) || (indexCount < 3) || ratios.empty())
+	{
+		return;
+	}
+
+	SIMPLIFY_SESSION session;
+	InitializeSession(session, pVertices, vertexCount, pIndices, indexCount);
+
+	// the coarsest level is simplified last
+	std::vector<float> sortedRatios = ratios;
+	std::sort(sortedRatios.begin(), sortedRatios.end(), [](float a, float b) { return a > b; });
+
+	size_t triangleCount = indexCount / 3;
+	size_t previousCount = triangleCount * 3;
+	for (float ratio : sortedRatios)
+	{
+		if (!(ratio > 0.0f) || !(ratio < 1.0f))
+		{
+			continue;
+		}
+		size_t targetIndexCount = std::max<size_t>((size_t)((double)triangleCount * ratio), 1) * 3;
+		bool bStalled = false;
+		while (session.indices.size() > targetIndexCount)
+		{
+			// when every collapse under the limit was rejected, the
+			// more costly ones are all that is left
+			if ((SimplifyPass(session, targetIndexCount, true) == 0) &&
+				(SimplifyPass(session, targetIndexCount, false) == 0))
+			{
+				bStalled = true;
+				break;
+			}
+		}
+
+		// a level that could not lose any triangles is no use
+		if (session.indices.size() < previousCount)
+		{
+			MESH_LOD lod;
+			lod.indices = session.indices;
+			lod.error = session.maxError;
+			lods.push_back(std::move(lod));
+			previousCount = session.indices.size();
+		}
+		if (bStalled)
+		{
+			break;
+		}
+	}
+}
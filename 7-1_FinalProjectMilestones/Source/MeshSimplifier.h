@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.h
+// ============
+// quadric error simplification of compact meshes into LOD chains
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ModelMeshes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// fraction of the triangles kept by each level of detail
+// after the full mesh, unless the importer is told otherwise
+extern const std::vector<float> MESH_DEFAULT_LOD_RATIOS;
+
+/***********************************************************
+ *  MeshSimplifier
+ *
+ *  This class reduces the triangles of a compact mesh by
+ *  collapsing edges in the order of their quadric error
+ *  (Garland and Heckbert).  Every collapse moves a vertex
+ *  onto a neighbor that already exists, so the levels of
+ *  detail only need new indices and share the vertices of
+ *  the full mesh.
+ *
+ *  Vertices at the same position with different normals or
+ *  texture coordinates form a seam and only collapse along
+ *  the seam, every copy onto the matching copy of the other
+ *  end, so texture coordinates never smear across it.
+ *  Vertices on an open boundary only collapse along the
+ *  boundary, whose edges carry an extra quadric keeping
+ *  its outline in place, and vertices where boundaries or
+ *  several seams meet never move.
+ ***********************************************************/
+class MeshSimplifier
+{
+public:
+	// build one level of detail for each ratio of the full
+	// triangle count, in one simplification session.  The
+	// error of each level is the farthest, in model units, any
+	// collapse so far moved the surface - it never shrinks down
+	// the chain.  Levels that could not remove any more
+	// triangles are left out.
+	static void BuildLodChain(
+		const COMPACT_VERTEX* pVertices,
+		uint32_t vertexCount,
+		const uint32_t* pIndices,
+		size_t indexCount,
+		const std::vector<float>& ratios,
+		std::vector<MESH_LOD>& lods);
+};
@@ -0,0 +1,605 @@
+///////////////////////////////////////////////////////////////////////////////
+// metrics.cpp
+// ============
+// counters, gauges and histograms updated from any thread, and exported
+// in the Prometheus text format for a local scraper
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET METRICS_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+typedef int METRICS_SOCKET;
+#endif
+
+// declaration of global variables
+namespace
+{
+	enum METRIC_TYPE
+	{
+		METRIC_COUNTER,
+		METRIC_GAUGE,
+		METRIC_HISTOGRAM
+	};
+
+	// one labelled series of a metric
+	struct METRIC_SERIES
+	{
+		std::string labels;
+		std::unique_ptr<MetricCounter> pCounter;
+		std::unique_ptr<MetricGauge> pGauge;
+		std::unique_ptr<MetricHistogram> pHistogram;
+	};
+
+	// every series sharing a name, exported under one HELP and
+	// TYPE line
+	struct METRIC_FAMILY
+	{
+		std::string name;
+		std::string help;
+		METRIC_TYPE type;
+		std::vector<std::unique_ptr<METRIC_SERIES>> series;
+	};
+
+	// taken to register a metric or to export them, never to
+	// update one
+	std::mutex g_RegistryMutex;
+	std::vector<std::unique_ptr<METRIC_FAMILY>> g_Families;
+	// the HTTP listener and the file sink can export at once, so
+	// the collectors are run one export at a time
+	std::mutex g_CollectorMutex;
+	std::vector<std::function<void()>> g_Collectors;
+
+#if defined(_WIN32)
+	const METRICS_SOCKET g_InvalidSocket = INVALID_SOCKET;
+#else
+	const METRICS_SOCKET g_InvalidSocket = -1;
+#endif
+	METRICS_SOCKET g_ListenSocket = g_InvalidSocket;
+	std::thread g_ListenerThread;
+
+	std::thread g_FileSinkThread;
+	std::mutex g_FileSinkMutex;
+	std::condition_variable g_FileSinkWake;
+	bool g_bFileSinkStopping = false;
+
+	// longest HTTP request header read from a scraper
+	const size_t g_MaxRequestBytes = 8192;
+	// longest a scraper may stall a read or write, as the
+	// scrapers are answered one at a time
+	const int g_ScrapeTimeoutMs = 1000;
+
+	uint64_t g_DoubleBits(double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return(bits);
+	}
+
+	double g_BitsDouble(uint64_t bits)
+	{
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return(value);
+	}
+
+	// format a sample value the way Prometheus reads it, as
+	// short as it can be while still reading back exactly
+	std::string g_FormatValue(double value)
+	{
+		char text[32];
+		snprintf(text, sizeof(text), "%.15g", value);
+		if (strtod(text, NULL) != value)
+		{
+			snprintf(text, sizeof(text), "%.17g", value);
+		}
+		return(text);
+	}
+
+	// find the series of a family, creating both if needed -
+	// called with the registry locked
+	METRIC_SERIES* g_FindSeries(const char* name, const char* help, METRIC_TYPE type, const std::string& labels, bool& bCreated)
+	{
+		METRIC_FAMILY* pFamily = NULL;
+		for (auto& pEntry : g_Families)
+		{
+			if (pEntry->name == name)
+			{
+				pFamily = pEntry.get();
+				break;
+			}
+		}
+		if (NULL == pFamily)
+		{
+			g_Families.emplace_back(new METRIC_FAMILY());
+			pFamily = g_Families.back().get();
+			pFamily->name = name;
+			pFamily->help = help;
+			pFamily->type = type;
+		}
+		else if (pFamily->type != type)
+		{
+			std::cout << "WARNING: metric " << name << " is registered with two different types" << std::endl;
+			return(NULL);
+		}
+
+		for (auto& pSeries : pFamily->series)
+		{
+			if (pSeries->labels == labels)
+			{
+				bCreated = false;
+				return(pSeries.get());
+			}
+		}
+		pFamily->series.emplace_back(new METRIC_SERIES());
+		pFamily->series.back()->labels = labels;
+		bCreated = true;
+		return(pFamily->series.back().get());
+	}
+
+	// the labels of a series with one more added
+	std::string g_JoinLabels(const std::string& labels, const std::string& extra)
+	{
+		return(labels.empty() ? extra : labels + "," + extra);
+	}
+
+	void g_CloseSocket(METRICS_SOCKET socket)
+	{
+#if defined(_WIN32)
+		closesocket(socket);
+#else
+		close(socket);
+#endif
+	}
+
+	// bound how long a scraper that stops reading or writing
+	// holds up the others, and make a scraper that hangs up
+	// fail the write instead of raising SIGPIPE
+	void g_PrepareScrapeSocket(METRICS_SOCKET socket)
+	{
+#if defined(_WIN32)
+		DWORD timeout = (DWORD)g_ScrapeTimeoutMs;
+#else
+		struct timeval timeout;
+		timeout.tv_sec = g_ScrapeTimeoutMs / 1000;
+		timeout.tv_usec = (g_ScrapeTimeoutMs % 1000) * 1000;
+#endif
+		setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+		setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+#if defined(SO_NOSIGPIPE)
+		int noSignal = 1;
+		setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&noSignal, sizeof(noSignal));
+#endif
+	}
+
+	// answer one scraper connection
+	void g_AnswerScrape(METRICS_SOCKET socket)
+	{
+		g_PrepareScrapeSocket(socket);
+
+		std::string request;
+		char received[1024];
+		while ((request.find("\r\n\r\n") == std::string::npos) && (request.size() < g_MaxRequestBytes))
+		{
+			int count = (int)recv(socket, received, sizeof(received), 0);
+			if (count <= 0)
+			{
+				return;
+			}
+			request.append(received, count);
+		}
+
+		std::string status = "200 OK";
+		std::string body;
+		if ((request.compare(0, 13, "GET /metrics ") == 0) || (request.compare(0, 6, "GET / ") == 0))
+		{
+			body = Metrics::WritePrometheus();
+		}
+		else
+		{
+			status = "404 Not Found";
+			body = "only GET /metrics is served\n";
+		}
+
+		std::string response = "HTTP/1.0 " + status + "\r\n"
+			"Content-Type: text/plain; version=0.0.4\r\n"
+			"Content-Length: " + std::to_string(body.size()) + "\r\n"
+			"Connection: close\r\n\r\n" + body;
+#if defined(MSG_NOSIGNAL)
+		const int flags = MSG_NOSIGNAL;
+#else
+		const int flags = 0;
+#endif
+		const char* pBytes = response.data();
+		size_t bytes = response.size();
+		while (bytes > 0)
+		{
+			int sent = (int)send(socket, pBytes, (int)std::min(bytes, (size_t)65536), flags);
+			if (sent <= 0)
+			{
+				return;
+			}
+			pBytes += sent;
+			bytes -= sent;
+		}
+	}
+
+	// accept scrapers one at a time until the socket is shut down
+	void g_ListenerMain()
+	{
+		while (true)
+		{
+			METRICS_SOCKET socket = accept(g_ListenSocket, NULL, NULL);
+			if (socket == g_InvalidSocket)
+			{
+				break;
+			}
+			g_AnswerScrape(socket);
+			g_CloseSocket(socket);
+		}
+	}
+
+	// write the file under a temporary name and move it into
+	// place, so a scraper never reads half of it
+	void g_WriteMetricsFile(const std::string& filename)
+	{
+		std::string temporary = filename + ".tmp";
+		FILE* pFile = fopen(temporary.c_str(), "wb");
+		if (NULL == pFile)
+		{
+			return;
+		}
+		std::string text = Metrics::WritePrometheus();
+		bool bWritten = (fwrite(text.data(), 1, text.size(), pFile) == text.size());
+		bWritten = (fclose(pFile) == 0) && bWritten;
+		if (bWritten)
+		{
+			// rename does not replace an existing file on Windows
+			std::remove(filename.c_str());
+			std::rename(temporary.c_str(), filename.c_str());
+		}
+	}
+}
+
+const std::vector<double> METRIC_WAIT_BOUNDS = { 0.0001, 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05 };
+
+/***********************************************************
+ *  Set()
+ *
+ *  This method is used for setting the gauge value.
+ ***********************************************************/
+void MetricGauge::Set(double value)
+{
+	m_bits.store(g_DoubleBits(value), std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  Get()
+ *
+ *  This method is used for reading the gauge value.
+ ***********************************************************/
+double MetricGauge::Get() const
+{
+	return(g_BitsDouble(m_bits.load(std::memory_order_relaxed)));
+}
+
+/***********************************************************
+ *  MetricHistogram()
+ *
+ *  The constructor for the class.
+ ***********************************************************/
+MetricHistogram::MetricHistogram(const std::vector<double>& bounds)
+{
+	m_boundCount = (bounds.size() < MAX_BUCKETS) ? bounds.size() : MAX_BUCKETS;
+	for (size_t i = 0; i < m_boundCount; i++)
+	{
+		m_bounds[i] = bounds[i];
+	}
+	for (size_t i = 0; i <= MAX_BUCKETS; i++)
+	{
+		m_buckets[i] = 0;
+	}
+	m_count = 0;
+	m_sumBits = g_DoubleBits(0.0);
+}
+
+/***********************************************************
+ *  Observe()
+ *
+ *  This method is used for adding a value to the histogram.
+ *  The buckets and count are plain atomic adds, and the sum
+ *  is added with a compare-exchange that only repeats when
+ *  two threads observe at the same moment.
+ ***********************************************************/
+void MetricHistogram::Observe(double value)
+{
+	size_t bucket = 0;
+	while ((bucket < m_boundCount) && (value > m_bounds[bucket]))
+	{
+		bucket++;
+	}
+	m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+
+	uint64_t bits = m_sumBits.load(std::memory_order_relaxed);
+	while (!m_sumBits.compare_exchange_weak(bits, g_DoubleBits(g_BitsDouble(bits) + value), std::memory_order_relaxed))
+	{
+	}
+}
+
+/***********************************************************
+ *  GetSum()
+ *
+ *  This method is used for reading the sum of every value
+ *  observed.
+ ***********************************************************/
+double MetricHistogram::GetSum() const
+{
+	return(g_BitsDouble(m_sumBits.load(std::memory_order_relaxed)));
+}
+
+/***********************************************************
+ *  GetCounter()
+ *
+ *  This method is used for finding or registering a counter.
+ ***********************************************************/
+MetricCounter* Metrics::GetCounter(const char* name, const char* help, const std::string& labels)
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	bool bCreated = false;
+	METRIC_SERIES* pSeries = g_FindSeries(name, help, METRIC_COUNTER, labels, bCreated);
+	if (NULL == pSeries)
+	{
+		return(NULL);
+	}
+	if (bCreated)
+	{
+		pSeries->pCounter.reset(new MetricCounter());
+	}
+	return(pSeries->pCounter.get());
+}
+
+/***********************************************************
+ *  GetGauge()
+ *
+ *  This method is used for finding or registering a gauge.
+ ***********************************************************/
+MetricGauge* Metrics::GetGauge(const char* name, const char* help, const std::string& labels)
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	bool bCreated = false;
+	METRIC_SERIES* pSeries = g_FindSeries(name, help, METRIC_GAUGE, labels, bCreated);
+	if (NULL == pSeries)
+	{
+		return(NULL);
+	}
+	if (bCreated)
+	{
+		pSeries->pGauge.reset(new MetricGauge());
+	}
+	return(pSeries->pGauge.get());
+}
+
+/***********************************************************
+ *  GetHistogram()
+ *
+ *  This method is used for finding or registering a
+ *  histogram.  The bounds of an existing one are kept.
+ ***********************************************************/
+MetricHistogram* Metrics::GetHistogram(const char* name, const char* help, const std::vector<double>& bounds, const std::string& labels)
+{
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+	bool bCreated = false;
+	METRIC_SERIES* pSeries = g_FindSeries(name, help, METRIC_HISTOGRAM, labels, bCreated);
+	if (NULL == pSeries)
+	{
+		return(NULL);
+	}
+	if (bCreated)
+	{
+		pSeries->pHistogram.reset(new MetricHistogram(bounds));
+	}
+	return(pSeries->pHistogram.get());
+}
+
+/***********************************************************
+ *  AddCollector()
+ *
+ *  This method is used for adding a function that refreshes
+ *  some gauges before every export.
+ ***********************************************************/
+void Metrics::AddCollector(std::function<void()> collector)
+{
+	std::lock_guard<std::mutex> lock(g_CollectorMutex);
+	g_Collectors.push_back(collector);
+}
+
+/***********************************************************
+ *  WritePrometheus()
+ *
+ *  This method is used for formatting every metric in the
+ *  Prometheus text exposition format.  The histogram buckets
+ *  are counted per bucket and made cumulative here.
+ ***********************************************************/
+std::string Metrics::WritePrometheus()
+{
+	// the collectors look their gauges up, so they run before
+	// the registry is locked
+	{
+		std::lock_guard<std::mutex> collectorLock(g_CollectorMutex);
+		for (auto& collector : g_Collectors)
+		{
+			collector();
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(g_RegistryMutex);
+
+	std::string text;
+	text.reserve(16384);
+	for (auto& pFamily : g_Families)
+	{
+		const char* pTypeName = (pFamily->type == METRIC_COUNTER) ? "counter" :
+			(pFamily->type == METRIC_GAUGE) ? "gauge" : "histogram";
+		text += "# HELP " + pFamily->name + " " + pFamily->help + "\n";
+		text += "# TYPE " + pFamily->name + " " + pTypeName + "\n";
+
+		for (auto& pSeries : pFamily->series)
+		{
+			std::string labels = pSeries->labels.empty() ? "" : "{" + pSeries->labels + "}";
+			if (pFamily->type == METRIC_COUNTER)
+			{
+				text += pFamily->name + labels + " " + std::to_string(pSeries->pCounter->Get()) + "\n";
+			}
+			else if (pFamily->type == METRIC_GAUGE)
+			{
+				text += pFamily->name + labels + " " + g_FormatValue(pSeries->pGauge->Get()) + "\n";
+			}
+			else
+			{
+				const MetricHistogram& histogram = *pSeries->pHistogram;
+				uint64_t cumulative = 0;
+				for (size_t i = 0; i <= histogram.GetBucketCount(); i++)
+				{
+					cumulative += histogram.GetBucket(i);
+					std::string bound = (i < histogram.GetBucketCount()) ? g_FormatValue(histogram.GetBound(i)) : "+Inf";
+					text += pFamily->name + "_bucket{" + g_JoinLabels(pSeries->labels, "le=\"" + bound + "\"") + "} " +
+						std::to_string(cumulative) + "\n";
+				}
+				text += pFamily->name + "_sum" + labels + " " + g_FormatValue(histogram.GetSum()) + "\n";
+				text += pFamily->name + "_count" + labels + " " + std::to_string(cumulative) + "\n";
+			}
+		}
+	}
+	return(text);
+}
+
+/***********************************************************
+ *  StartHTTPListener()
+ *
+ *  This method is used for serving the metrics on a TCP
+ *  port of the loopback address only, so nothing outside
+ *  the machine can reach it.
+ ***********************************************************/
+bool Metrics::StartHTTPListener(int port)
+{
+#if defined(_WIN32)
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		std::cout << "WARNING: could not initialize Winsock" << std::endl;
+		return(false);
+	}
+#endif
+
+	g_ListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+	if (g_ListenSocket == g_InvalidSocket)
+	{
+		std::cout << "WARNING: could not create the metrics socket" << std::endl;
+		return(false);
+	}
+	int reuse = 1;
+	setsockopt(g_ListenSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons((unsigned short)port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ((bind(g_ListenSocket, (const sockaddr*)&address, sizeof(address)) != 0) ||
+		(listen(g_ListenSocket, 4) != 0))
+	{
+		std::cout << "Could not listen for metrics scrapes on port:" << port << std::endl;
+		g_CloseSocket(g_ListenSocket);
+		g_ListenSocket = g_InvalidSocket;
+		return(false);
+	}
+
+	g_ListenerThread = std::thread(g_ListenerMain);
+	std::cout << "INFO: metrics at http://127.0.0.1:" << port << "/metrics" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  StartFileSink()
+ *
+ *  This method is used for rewriting a file with the metrics
+ *  at an interval, for a scraper that reads files, such as
+ *  the node exporter textfile collector.
+ ***********************************************************/
+bool Metrics::StartFileSink(const char* filename, double intervalSeconds)
+{
+	std::string path(filename);
+	std::chrono::milliseconds interval((long long)(std::max(intervalSeconds, 0.1) * 1000.0));
+	g_bFileSinkStopping = false;
+	g_FileSinkThread = std::thread([path, interval]()
+	{
+		std::unique_lock<std::mutex> lock(g_FileSinkMutex);
+		while (!g_bFileSinkStopping)
+		{
+			lock.unlock();
+			g_WriteMetricsFile(path);
+			lock.lock();
+			g_FileSinkWake.wait_for(lock, interval, []() { return g_bFileSinkStopping; });
+		}
+		lock.unlock();
+		g_WriteMetricsFile(path);
+	});
+	std::cout << "INFO: metrics written to " << path << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for stopping the listener and the
+ *  file sink.  The metrics themselves stay valid, since
+ *  other threads may still hold them.
+ ***********************************************************/
+void Metrics::Shutdown()
+{
+	if (g_ListenSocket != g_InvalidSocket)
+	{
+#if defined(_WIN32)
+		// closing the socket is what wakes accept() on Windows
+		closesocket(g_ListenSocket);
+		g_ListenerThread.join();
+		WSACleanup();
+#else
+		shutdown(g_ListenSocket, SHUT_RDWR);
+		g_ListenerThread.join();
+		close(g_ListenSocket);
+#endif
+		g_ListenSocket = g_InvalidSocket;
+	}
+
+	if (g_FileSinkThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(g_FileSinkMutex);
+			g_bFileSinkStopping = true;
+		}
+		g_FileSinkWake.notify_all();
+		g_FileSinkThread.join();
+	}
+}
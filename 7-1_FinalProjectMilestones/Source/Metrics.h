@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+// metrics.h
+// ============
+// counters, gauges and histograms updated from any thread, and exported
+// in the Prometheus text format for a local scraper
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// bucket bounds in seconds for the histograms of the waits
+// for the GPU, from a tenth of a millisecond to a few frames
+extern const std::vector<double> METRIC_WAIT_BOUNDS;
+
+/***********************************************************
+ *  MetricCounter
+ *
+ *  Total that only goes up, such as frames or stalls.
+ ***********************************************************/
+class MetricCounter
+{
+public:
+	MetricCounter() : m_value(0) {}
+
+	void Add(uint64_t count = 1) { m_value.fetch_add(count, std::memory_order_relaxed); }
+	uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint64_t> m_value;
+};
+
+/***********************************************************
+ *  MetricGauge
+ *
+ *  Value that is set rather than added to, such as the live
+ *  memory.  The double is stored by its bits, so setting it
+ *  is a single atomic store.
+ ***********************************************************/
+class MetricGauge
+{
+public:
+	MetricGauge() : m_bits(0) {}
+
+	void Set(double value);
+	double Get() const;
+
+private:
+	std::atomic<uint64_t> m_bits;
+};
+
+/***********************************************************
+ *  MetricHistogram
+ *
+ *  Distribution of observed values over fixed buckets, such
+ *  as the frame times.  Observing a value adds to one bucket
+ *  and to the count and sum, all without a lock.
+ ***********************************************************/
+class MetricHistogram
+{
+public:
+	// most bucket bounds a histogram can have
+	static const size_t MAX_BUCKETS = 16;
+
+	// the upper bounds of the buckets, in ascending order - the
+	// +Inf bucket is added
+	MetricHistogram(const std::vector<double>& bounds);
+
+	void Observe(double value);
+
+	size_t GetBucketCount() const { return m_boundCount; }
+	double GetBound(size_t bucket) const { return m_bounds[bucket]; }
+	// values observed at or below each bound - the last bucket
+	// holds the values above every bound
+	uint64_t GetBucket(size_t bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }
+	uint64_t GetCount() const { return m_count.load(std::memory_order_relaxed); }
+	double GetSum() const;
+
+private:
+	double m_bounds[MAX_BUCKETS];
+	size_t m_boundCount;
+	std::atomic<uint64_t> m_buckets[MAX_BUCKETS + 1];
+	std::atomic<uint64_t> m_count;
+	std::atomic<uint64_t> m_sumBits;
+};
+
+/***********************************************************
+ *  Metrics
+ *
+ *  This class keeps the registry of every metric and exports
+ *  them.  Looking a metric up takes a lock, so callers look
+ *  it up once and keep the pointer, which stays valid for
+ *  the life of the process - after that the render and
+ *  worker threads update it with relaxed atomics only.
+ *
+ *  The export runs on a thread of its own, either answering
+ *  a local HTTP listener or rewriting a file at an interval,
+ *  so a scrape never waits on the render thread.  Values
+ *  that already live elsewhere, such as the memory totals,
+ *  are copied into gauges by collectors that run on that
+ *  thread just before each export.
+ ***********************************************************/
+class Metrics
+{
+public:
+	// find or create a metric - the labels are in the Prometheus
+	// form, such as pool="gpu", and can be empty
+	static MetricCounter* GetCounter(const char* name, const char* help, const std::string& labels = "");
+	static MetricGauge* GetGauge(const char* name, const char* help, const std::string& labels = "");
+	static MetricHistogram* GetHistogram(const char* name, const char* help, const std::vector<double>& bounds, const std::string& labels = "");
+
+	// run a function before every export, on the export thread
+	static void AddCollector(std::function<void()> collector);
+
+	// every metric in the Prometheus text exposition format
+	static std::string WritePrometheus();
+
+	// answer GET /metrics on a loopback TCP port
+	static bool StartHTTPListener(int port);
+	// rewrite a file with the metrics at an interval
+	static bool StartFileSink(const char* filename, double intervalSeconds);
+	// stop the export threads, writing the file one last time
+	static void Shutdown();
+};
@@ -0,0 +1,1719 @@
+///////////////////////////////////////////////////////////////////////////////
+// modelimporter.cpp
+// ============
+// import glTF and OBJ models into compact meshes and materials
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ModelImporter.h"
+#include "MappedFile.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+
+// declaration of global variables
+namespace
+{
+	// vertices each job converts
+	const size_t g_VertexBatchSize = 16384;
+	// smallest piece of an OBJ file parsed by one job
+	const size_t g_MinimumChunkBytes = 256 * 1024;
+	// deepest nesting of JSON values or glTF nodes accepted
+	const int g_MaxNestingDepth = 64;
+
+	// glTF binary container
+	const uint32_t g_GLBMagic = 0x46546C67;			// "glTF"
+	const uint32_t g_GLBChunkJSON = 0x4E4F534A;		// "JSON"
+	const uint32_t g_GLBChunkBinary = 0x004E4942;	// "BIN"
+
+	// glTF accessor component types and primitive modes
+	const uint32_t g_ComponentByte = 5120;
+	const uint32_t g_ComponentUnsignedByte = 5121;
+	const uint32_t g_ComponentShort = 5122;
+	const uint32_t g_ComponentUnsignedShort = 5123;
+	const uint32_t g_ComponentUnsignedInt = 5125;
+	const uint32_t g_ComponentFloat = 5126;
+	const int g_ModeTriangles = 4;
+	const int g_ModeTriangleStrip = 5;
+	const int g_ModeTriangleFan = 6;
+
+	const double g_PowersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	double Milliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	// the directory of a path, with its trailing separator
+	std::string GetDirectory(const std::string& path)
+	{
+		size_t separator = path.find_last_of("/\\");
+		return((separator == std::string::npos) ? std::string() : path.substr(0, separator + 1));
+	}
+
+	// the file name of a path without its directory or extension
+	std::string GetBaseName(const std::string& path)
+	{
+		size_t separator = path.find_last_of("/\\");
+		std::string name = (separator == std::string::npos) ? path : path.substr(separator + 1);
+		size_t dot = name.find_last_of('.');
+		return((dot == std::string::npos) ? name : name.substr(0, dot));
+	}
+
+	// parse a decimal number, moving the text pointer past it -
+	// bounded by the end pointer, since a mapped file has no
+	// terminating zero
+	bool ParseNumber(const char*& p, const char* pEnd, double& value)
+	{
+		const char* pText = p;
+		bool bNegative = false;
+		if ((pText < pEnd) && ((*pText == '-') || (*pText == '+')))
+		{
+			bNegative = (*pText == '-');
+			pText++;
+		}
+
+		// keep the first 19 significant digits, which fit in 64 bits
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		int significantDigits = 0;
+		bool bDigits = false;
+		while ((pText < pEnd) && (*pText >= '0') && (*pText <= '9'))
+		{
+			if (significantDigits < 19)
+			{
+				mantissa = mantissa * 10 + (uint64_t)(*pText - '0');
+				significantDigits += (mantissa != 0) ? 1 : 0;
+			}
+			else
+			{
+				exponent++;
+			}
+			bDigits = true;
+			pText++;
+		}
+		if ((pText < pEnd) && (*pText == '.'))
+		{
+			pText++;
+			while ((pText < pEnd) && (*pText >= '0') && (*pText <= '9'))
+			{
+				if (significantDigits < 19)
+				{
+					mantissa = mantissa * 10 + (uint64_t)(*pText - '0');
+					significantDigits += (mantissa != 0) ? 1 : 0;
+					exponent--;
+				}
+				bDigits = true;
+				pText++;
+			}
+		}
+		if (!bDigits)
+		{
+			return(false);
+		}
+		if ((pText < pEnd) && ((*pText == 'e') || (*pText == 'E')))
+		{
+			pText++;
+			bool bNegativeExponent = false;
+			if ((pText < pEnd) && ((*pText == '-') || (*pText == '+')))
+			{
+				bNegativeExponent = (*pText == '-');
+				pText++;
+			}
+			if ((pText >= pEnd) || (*pText < '0') || (*pText > '9'))
+			{
+				return(false);
+			}
+			int exponentValue = 0;
+			while ((pText < pEnd) && (*pText >= '0') && (*pText <= '9'))
+			{
+				exponentValue = std::min(exponentValue * 10 + (*pText - '0'), 1000);
+				pText++;
+			}
+			exponent += bNegativeExponent ? -exponentValue : exponentValue;
+		}
+
+		double result = (double)mantissa;
+		if ((exponent >= 0) && (exponent <= 22))
+		{
+			result *= g_PowersOfTen[exponent];
+		}
+		else if ((exponent < 0) && (exponent >= -22))
+		{
+			result /= g_PowersOfTen[-exponent];
+		}
+		else if (mantissa != 0)
+		{
+			result *= std::pow(10.0, (double)exponent);
+		}
+		value = bNegative ? -result : result;
+		p = pText;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  JSON_VALUE
+	 *
+	 *  One value of a parsed JSON document.  The values are
+	 *  stored flat in document order, and strings and numbers
+	 *  point at their text in the mapped file.  The members of
+	 *  an object alternate between key and value.
+	 ***********************************************************/
+	enum JSON_TYPE
+	{
+		JSON_NULL,
+		JSON_BOOLEAN,
+		JSON_NUMBER,
+		JSON_STRING,
+		JSON_ARRAY,
+		JSON_OBJECT
+	};
+
+	struct JSON_VALUE
+	{
+		JSON_TYPE type;
+		uint32_t childCount;
+		// index of the value after this one and all of its children
+		uint32_t end;
+		const char* pText;
+		uint32_t textLength;
+		double number;
+	};
+
+	struct JSON_PARSER
+	{
+		const char* p;
+		const char* pEnd;
+		std::vector<JSON_VALUE> values;
+	};
+
+	void SkipJSONSpace(JSON_PARSER& parser)
+	{
+		while ((parser.p < parser.pEnd) &&
+			((*parser.p == ' ') || (*parser.p == '\t') || (*parser.p == '\n') || (*parser.p == '\r')))
+		{
+			parser.p++;
+		}
+	}
+
+	bool ParseJSONValue(JSON_PARSER& parser, int depth)
+	{
+		SkipJSONSpace(parser);
+		if ((parser.p >= parser.pEnd) || (depth > g_MaxNestingDepth))
+		{
+			return(false);
+		}
+
+		size_t index = parser.values.size();
+		parser.values.push_back(JSON_VALUE());
+		JSON_VALUE value = {};
+		value.pText = parser.p;
+
+		char first = *parser.p;
+		if ((first == '{') || (first == '['))
+		{
+			bool bObject = (first == '{');
+			char last = bObject ? '}' : ']';
+			value.type = bObject ? JSON_OBJECT : JSON_ARRAY;
+			parser.p++;
+			SkipJSONSpace(parser);
+			if ((parser.p < parser.pEnd) && (*parser.p == last))
+			{
+				parser.p++;
+			}
+			else
+			{
+				while (true)
+				{
+					if (bObject)
+					{
+						SkipJSONSpace(parser);
+						if ((parser.p >= parser.pEnd) || (*parser.p != '"') || !ParseJSONValue(parser, depth + 1))
+						{
+							return(false);
+						}
+						SkipJSONSpace(parser);
+						if ((parser.p >= parser.pEnd) || (*parser.p != ':'))
+						{
+							return(false);
+						}
+						parser.p++;
+						value.childCount++;
+					}
+					if (!ParseJSONValue(parser, depth + 1))
+					{
+						return(false);
+					}
+					value.childCount++;
+
+					SkipJSONSpace(parser);
+					if (parser.p >= parser.pEnd)
+					{
+						return(false);
+					}
+					if (*parser.p == ',')
+					{
+						parser.p++;
+						continue;
+					}
+					if (*parser.p != last)
+					{
+						return(false);
+					}
+					parser.p++;
+					break;
+				}
+			}
+		}
+		else if (first == '"')
+		{
+			// the text is kept as it is in the file - escapes are
+			// only skipped over, since glTF keys never use them
+			value.type = JSON_STRING;
+			const char* pStart = ++parser.p;
+			while ((parser.p < parser.pEnd) && (*parser.p != '"'))
+			{
+				parser.p += (*parser.p == '\\') ? 2 : 1;
+			}
+			if (parser.p >= parser.pEnd)
+			{
+				return(false);
+			}
+			value.pText = pStart;
+			value.textLength = (uint32_t)(parser.p - pStart);
+			parser.p++;
+		}
+		else if ((parser.pEnd - parser.p >= 4) && (memcmp(parser.p, "true", 4) == 0))
+		{
+			value.type = JSON_BOOLEAN;
+			value.number = 1.0;
+			parser.p += 4;
+		}
+		else if ((parser.pEnd - parser.p >= 5) && (memcmp(parser.p, "false", 5) == 0))
+		{
+			value.type = JSON_BOOLEAN;
+			parser.p += 5;
+		}
+		else if ((parser.pEnd - parser.p >= 4) && (memcmp(parser.p, "null", 4) == 0))
+		{
+			value.type = JSON_NULL;
+			parser.p += 4;
+		}
+		else
+		{
+			value.type = JSON_NUMBER;
+			if (!ParseNumber(parser.p, parser.pEnd, value.number))
+			{
+				return(false);
+			}
+			value.textLength = (uint32_t)(parser.p - value.pText);
+		}
+
+		value.end = (uint32_t)parser.values.size();
+		parser.values[index] = value;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  GLTF_DOCUMENT
+	 *
+	 *  The parsed JSON of a glTF file, with lookups that return
+	 *  -1 for anything missing so optional properties chain.
+	 ***********************************************************/
+	struct GLTF_DOCUMENT
+	{
+		std::vector<JSON_VALUE> values;
+
+		int Member(int object, const char* key) const
+		{
+			if ((object < 0) || (values[object].type != JSON_OBJECT))
+			{
+				return(-1);
+			}
+			size_t keyLength = strlen(key);
+			uint32_t child = (uint32_t)object + 1;
+			for (uint32_t i = 0; i < values[object].childCount; i += 2)
+			{
+				const JSON_VALUE& name = values[child];
+				if ((name.textLength == keyLength) && (memcmp(name.pText, key, keyLength) == 0))
+				{
+					return((int)child + 1);
+				}
+				child = values[child + 1].end;
+			}
+			return(-1);
+		}
+
+		int Element(int array, uint32_t element) const
+		{
+			if ((array < 0) || (values[array].type != JSON_ARRAY) || (element >= values[array].childCount))
+			{
+				return(-1);
+			}
+			uint32_t child = (uint32_t)array + 1;
+			for (uint32_t i = 0; i < element; i++)
+			{
+				child = values[child].end;
+			}
+			return((int)child);
+		}
+
+		uint32_t Count(int array) const
+		{
+			return(((array < 0) || (values[array].type != JSON_ARRAY)) ? 0 : values[array].childCount);
+		}
+
+		double Number(int value, double fallback) const
+		{
+			return(((value < 0) || (values[value].type != JSON_NUMBER)) ? fallback : values[value].number);
+		}
+
+		int Index(int value) const
+		{
+			double number = Number(value, -1.0);
+			return(((number < 0.0) || (number > 2147483647.0)) ? -1 : (int)number);
+		}
+
+		std::string String(int value) const
+		{
+			if ((value < 0) || (values[value].type != JSON_STRING))
+			{
+				return(std::string());
+			}
+			return(std::string(values[value].pText, values[value].textLength));
+		}
+
+		// numbers of an array into the passed in floats, leaving
+		// the defaults when the array is missing or too short
+		void Numbers(int array, float* pValues, uint32_t count) const
+		{
+			if (Count(array) < count)
+			{
+				return;
+			}
+			uint32_t child = (uint32_t)array + 1;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				pValues[i] = (float)Number((int)child, pValues[i]);
+				child = values[child].end;
+			}
+		}
+	};
+
+	/***********************************************************
+	 *  GLTF_ACCESSOR
+	 *
+	 *  Zero copy view of one glTF accessor.  The elements are
+	 *  read straight out of the mapped buffer through the
+	 *  accessor's offset and stride, and converted to floats
+	 *  or indices as they are read.
+	 ***********************************************************/
+	struct GLTF_ACCESSOR
+	{
+		const unsigned char* pData;
+		size_t stride;
+		uint32_t count;
+		uint32_t componentType;
+		uint32_t componentCount;
+		uint32_t componentSize;
+		bool bNormalized;
+
+		float ReadFloat(uint32_t element, uint32_t component) const
+		{
+			const unsigned char* pComponent = pData + element * stride + component * componentSize;
+			switch (componentType)
+			{
+			case g_ComponentFloat:
+			{
+				float value = 0.0f;
+				memcpy(&value, pComponent, sizeof(value));
+				return(value);
+			}
+			case g_ComponentUnsignedByte:
+				return(bNormalized ? (float)pComponent[0] / 255.0f : (float)pComponent[0]);
+			case g_ComponentByte:
+				return(bNormalized ? std::max((float)(int8_t)pComponent[0] / 127.0f, -1.0f) : (float)(int8_t)pComponent[0]);
+			case g_ComponentUnsignedShort:
+			{
+				uint16_t value = 0;
+				memcpy(&value, pComponent, sizeof(value));
+				return(bNormalized ? (float)value / 65535.0f : (float)value);
+			}
+			case g_ComponentShort:
+			{
+				int16_t value = 0;
+				memcpy(&value, pComponent, sizeof(value));
+				return(bNormalized ? std::max((float)value / 32767.0f, -1.0f) : (float)value);
+			}
+			default:
+				return(0.0f);
+			}
+		}
+
+		glm::vec3 ReadVec3(uint32_t element) const
+		{
+			if (componentType == g_ComponentFloat)
+			{
+				float values[3];
+				memcpy(values, pData + element * stride, sizeof(values));
+				return(glm::vec3(values[0], values[1], values[2]));
+			}
+			return(glm::vec3(ReadFloat(element, 0), ReadFloat(element, 1), ReadFloat(element, 2)));
+		}
+
+		uint32_t ReadIndex(uint32_t element) const
+		{
+			const unsigned char* pIndex = pData + element * stride;
+			if (componentType == g_ComponentUnsignedByte)
+			{
+				return(pIndex[0]);
+			}
+			if (componentType == g_ComponentUnsignedShort)
+			{
+				uint16_t value = 0;
+				memcpy(&value, pIndex, sizeof(value));
+				return(value);
+			}
+			uint32_t value = 0;
+			memcpy(&value, pIndex, sizeof(value));
+			return(value);
+		}
+	};
+
+	struct GLTF_BUFFER_VIEW
+	{
+		const unsigned char* pData;
+		size_t length;
+		size_t stride;
+	};
+
+	// one primitive of a mesh placed by a node, to be built
+	struct GLTF_PRIMITIVE
+	{
+		std::string name;
+		glm::mat4 world;
+		int primitive;
+		int material;
+	};
+
+	// check an accessor against its buffer view and resolve it
+	// into a pointer into the mapped data
+	bool ResolveAccessor(
+		const GLTF_DOCUMENT& document,
+		const std::vector<GLTF_BUFFER_VIEW>& views,
+		int accessorIndex,
+		GLTF_ACCESSOR& accessor)
+	{
+		int accessorValue = document.Element(document.Member(0, "accessors"), (uint32_t)std::max(accessorIndex, 0));
+		if ((accessorIndex < 0) || (accessorValue < 0) || (document.Member(accessorValue, "sparse") >= 0))
+		{
+			return(false);
+		}
+		int view = document.Index(document.Member(accessorValue, "bufferView"));
+		if ((view < 0) || ((size_t)view >= views.size()) || (NULL == views[view].pData))
+		{
+			return(false);
+		}
+
+		std::string type = document.String(document.Member(accessorValue, "type"));
+		accessor.componentCount = (type == "SCALAR") ? 1 : (type == "VEC2") ? 2 : (type == "VEC3") ? 3 : (type == "VEC4") ? 4 : 0;
+		accessor.componentType = (uint32_t)document.Index(document.Member(accessorValue, "componentType"));
+		accessor.componentSize =
+			((accessor.componentType == g_ComponentByte) || (accessor.componentType == g_ComponentUnsignedByte)) ? 1 :
+			((accessor.componentType == g_ComponentShort) || (accessor.componentType == g_ComponentUnsignedShort)) ? 2 :
+			((accessor.componentType == g_ComponentUnsignedInt) || (accessor.componentType == g_ComponentFloat)) ? 4 : 0;
+		accessor.bNormalized = (document.Number(document.Member(accessorValue, "normalized"), 0.0) != 0.0);
+		int count = document.Index(document.Member(accessorValue, "count"));
+		if ((accessor.componentCount == 0) || (accessor.componentSize == 0) || (count < 0))
+		{
+			return(false);
+		}
+		accessor.count = (uint32_t)count;
+
+		size_t offset = (size_t)std::max(document.Index(document.Member(accessorValue, "byteOffset")), 0);
+		size_t elementSize = (size_t)accessor.componentCount * accessor.componentSize;
+		accessor.stride = (views[view].stride != 0) ? views[view].stride : elementSize;
+		accessor.pData = views[view].pData + std::min(offset, views[view].length);
+		if (accessor.count == 0)
+		{
+			return(true);
+		}
+
+		// the last element has to end inside the view - checked in
+		// 64 bits, since size_t is 32 bits on Win32
+		uint64_t lastByte = (uint64_t)offset + (uint64_t)accessor.stride * (accessor.count - 1) + elementSize;
+		return(lastByte <= views[view].length);
+	}
+
+	// the local transform of a node, from its matrix or from its
+	// translation, rotation and scale
+	glm::mat4 GetNodeTransform(const GLTF_DOCUMENT& document, int node)
+	{
+		int matrixValue = document.Member(node, "matrix");
+		if (document.Count(matrixValue) == 16)
+		{
+			float values[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+			document.Numbers(matrixValue, values, 16);
+			glm::mat4 matrix(1.0f);
+			for (int column = 0; column < 4; column++)
+			{
+				matrix[column] = glm::vec4(values[column * 4], values[column * 4 + 1], values[column * 4 + 2], values[column * 4 + 3]);
+			}
+			return(matrix);
+		}
+
+		float translation[3] = { 0.0f, 0.0f, 0.0f };
+		float rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		float scale[3] = { 1.0f, 1.0f, 1.0f };
+		document.Numbers(document.Member(node, "translation"), translation, 3);
+		document.Numbers(document.Member(node, "rotation"), rotation, 4);
+		document.Numbers(document.Member(node, "scale"), scale, 3);
+
+		// rotation matrix of the unit quaternion x, y, z, w
+		float x = rotation[0], y = rotation[1], z = rotation[2], w = rotation[3];
+		glm::mat4 matrix(1.0f);
+		matrix[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f) * scale[0];
+		matrix[1] = glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f) * scale[1];
+		matrix[2] = glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f) * scale[2];
+		matrix[3] = glm::vec4(translation[0], translation[1], translation[2], 1.0f);
+		return(matrix);
+	}
+
+	// add the primitives of a node and its children, with their
+	// transforms to model space
+	void CollectNodePrimitives(
+		const GLTF_DOCUMENT& document,
+		int nodeIndex,
+		const glm::mat4& parent,
+		int depth,
+		std::vector<GLTF_PRIMITIVE>& primitives)
+	{
+		int node = document.Element(document.Member(0, "nodes"), (uint32_t)std::max(nodeIndex, 0));
+		if ((nodeIndex < 0) || (node < 0) || (depth > g_MaxNestingDepth))
+		{
+			return;
+		}
+
+		glm::mat4 world = parent * GetNodeTransform(document, node);
+		int meshIndex = document.Index(document.Member(node, "mesh"));
+		int mesh = document.Element(document.Member(0, "meshes"), (uint32_t)std::max(meshIndex, 0));
+		if ((meshIndex >= 0) && (mesh >= 0))
+		{
+			std::string meshName = document.String(document.Member(mesh, "name"));
+			if (meshName.empty())
+			{
+				meshName = "mesh " + std::to_string(meshIndex);
+			}
+			int primitiveArray = document.Member(mesh, "primitives");
+			for (uint32_t i = 0; i < document.Count(primitiveArray); i++)
+			{
+				GLTF_PRIMITIVE primitive;
+				primitive.name = meshName + "/" + std::to_string(i);
+				primitive.world = world;
+				primitive.primitive = document.Element(primitiveArray, i);
+				primitive.material = document.Index(document.Member(primitive.primitive, "material"));
+				primitives.push_back(primitive);
+			}
+		}
+
+		int children = document.Member(node, "children");
+		for (uint32_t i = 0; i < document.Count(children); i++)
+		{
+			CollectNodePrimitives(document, document.Index(document.Element(children, i)), world, depth + 1, primitives);
+		}
+	}
+
+	// convert a glTF metallic roughness material into the scene's
+	// Phong terms
+	IMPORTED_MATERIAL ConvertGLTFMaterial(const GLTF_DOCUMENT& document, int material, uint32_t index)
+	{
+		IMPORTED_MATERIAL converted;
+		converted.name = document.String(document.Member(material, "name"));
+		if (converted.name.empty())
+		{
+			converted.name = "material " + std::to_string(index);
+		}
+
+		int pbr = document.Member(material, "pbrMetallicRoughness");
+		float baseColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		document.Numbers(document.Member(pbr, "baseColorFactor"), baseColor, 4);
+		float metallic = (float)document.Number(document.Member(pbr, "metallicFactor"), 1.0);
+		float roughness = (float)document.Number(document.Member(pbr, "roughnessFactor"), 1.0);
+		metallic = std::min(std::max(metallic, 0.0f), 1.0f);
+		roughness = std::min(std::max(roughness, 0.0f), 1.0f);
+
+		// metals have no diffuse light of their own and a stronger
+		// highlight, and rough surfaces a wider, dimmer one
+		converted.baseColor = glm::vec4(baseColor[0], baseColor[1], baseColor[2], baseColor[3]);
+		converted.ambientColor = glm::vec3(1.0f);
+		converted.ambientStrength = 0.15f;
+		converted.diffuseColor = glm::vec3(1.0f - 0.5f * metallic);
+		converted.specularColor = glm::vec3((0.04f + 0.96f * metallic) * (1.0f - roughness));
+		float roughnessSquared = std::max(roughness * roughness, 0.01f);
+		converted.shininess = std::min(std::max(2.0f / (roughnessSquared * roughnessSquared) - 2.0f, 1.0f), 256.0f);
+		return(converted);
+	}
+
+	// bounds and the radius around the model origin of a mesh
+	void ComputeBounds(IMPORTED_MESH& mesh)
+	{
+		mesh.boundsMin = glm::vec3(0.0f);
+		mesh.boundsMax = glm::vec3(0.0f);
+		float radiusSquared = 0.0f;
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			glm::vec3 position(mesh.vertices[i].position[0], mesh.vertices[i].position[1], mesh.vertices[i].position[2]);
+			mesh.boundsMin = (i == 0) ? position : glm::min(mesh.boundsMin, position);
+			mesh.boundsMax = (i == 0) ? position : glm::max(mesh.boundsMax, position);
+			radiusSquared = std::max(radiusSquared, glm::dot(position, position));
+		}
+		mesh.radius = std::sqrt(radiusSquared);
+	}
+
+	// smooth normals from the area weighted normals of the
+	// triangles around each vertex - only the vertices flagged in
+	// the mask are replaced, or all of them without a mask
+	void GenerateNormals(IMPORTED_MESH& mesh, const std::vector<uint8_t>* pMask)
+	{
+		std::vector<glm::vec3> normals(mesh.vertices.size(), glm::vec3(0.0f));
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			const float* p0 = mesh.vertices[mesh.indices[i]].position;
+			const float* p1 = mesh.vertices[mesh.indices[i + 1]].position;
+			const float* p2 = mesh.vertices[mesh.indices[i + 2]].position;
+			glm::vec3 edge1(p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]);
+			glm::vec3 edge2(p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]);
+			glm::vec3 faceNormal = glm::cross(edge1, edge2);
+			for (size_t corner = 0; corner < 3; corner++)
+			{
+				normals[mesh.indices[i + corner]] += faceNormal;
+			}
+		}
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			if ((NULL != pMask) && ((*pMask)[i] == 0))
+			{
+				continue;
+			}
+			float length = glm::length(normals[i]);
+			mesh.vertices[i].normal = PackCompactNormal((length > 0.0f) ? normals[i] / length : glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+	}
+
+	// build one glTF primitive into a compact mesh in model space
+	bool BuildGLTFPrimitive(
+		const GLTF_DOCUMENT& document,
+		const std::vector<GLTF_BUFFER_VIEW>& views,
+		const GLTF_PRIMITIVE& primitive,
+		IMPORTED_MESH& mesh)
+	{
+		mesh.name = primitive.name;
+		mesh.material = primitive.material;
+
+		int mode = document.Index(document.Member(primitive.primitive, "mode"));
+		if (mode < 0)
+		{
+			mode = g_ModeTriangles;
+		}
+		if ((mode != g_ModeTriangles) && (mode != g_ModeTriangleStrip) && (mode != g_ModeTriangleFan))
+		{
+			// points and lines are not drawn by the scene
+			return(false);
+		}
+
+		int attributes = document.Member(primitive.primitive, "attributes");
+		GLTF_ACCESSOR positions = {};
+		GLTF_ACCESSOR normals = {};
+		GLTF_ACCESSOR uvs = {};
+		if (!ResolveAccessor(document, views, document.Index(document.Member(attributes, "POSITION")), positions) ||
+			(positions.componentCount != 3))
+		{
+			return(false);
+		}
+		bool bNormals = ResolveAccessor(document, views, document.Index(document.Member(attributes, "NORMAL")), normals) &&
+			(normals.componentCount == 3) && (normals.count == positions.count);
+		bool bUVs = ResolveAccessor(document, views, document.Index(document.Member(attributes, "TEXCOORD_0")), uvs) &&
+			(uvs.componentCount == 2) && (uvs.count == positions.count);
+
+		// normals are moved by the inverse transpose, and a mirroring
+		// transform turns the triangles inside out
+		glm::mat3 linear(primitive.world);
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+		bool bMirrored = (glm::dot(linear[0], glm::cross(linear[1], linear[2])) < 0.0f);
+
+		mesh.vertices.resize(positions.count);
+		JobSystem::ParallelFor(positions.count, g_VertexBatchSize, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				COMPACT_VERTEX& vertex = mesh.vertices[i];
+				glm::vec4 position = primitive.world * glm::vec4(positions.ReadVec3((uint32_t)i), 1.0f);
+				vertex.position[0] = position.x;
+				vertex.position[1] = position.y;
+				vertex.position[2] = position.z;
+				vertex.normal = 0;
+				if (bNormals)
+				{
+					glm::vec3 normal = normalMatrix * normals.ReadVec3((uint32_t)i);
+					float length = glm::length(normal);
+					vertex.normal = PackCompactNormal((length > 0.0f) ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f));
+				}
+				// glTF puts the texture origin at the top left, and the
+				// scene textures are loaded flipped to the bottom left
+				float u = bUVs ? uvs.ReadFloat((uint32_t)i, 0) : 0.0f;
+				float v = bUVs ? 1.0f - uvs.ReadFloat((uint32_t)i, 1) : 0.0f;
+				vertex.uv[0] = PackHalfFloat(u);
+				vertex.uv[1] = PackHalfFloat(v);
+			}
+		});
+
+		// the vertex order of every triangle, unrolled from strips
+		// and fans, dropping any that reference missing vertices
+		GLTF_ACCESSOR indices = {};
+		bool bIndexed = ResolveAccessor(document, views, document.Index(document.Member(primitive.primitive, "indices")), indices);
+		if (bIndexed &&
+			((indices.componentCount != 1) ||
+			((indices.componentType != g_ComponentUnsignedByte) &&
+			(indices.componentType != g_ComponentUnsignedShort) &&
+			(indices.componentType != g_ComponentUnsignedInt))))
+		{
+			return(false);
+		}
+		uint32_t elementCount = bIndexed ? indices.count : positions.count;
+		auto readIndex = [&](uint32_t element) { return(bIndexed ? indices.ReadIndex(element) : element); };
+
+		uint32_t triangleCount = (mode == g_ModeTriangles) ? elementCount / 3 : ((elementCount >= 3) ? elementCount - 2 : 0);
+		mesh.indices.resize((size_t)triangleCount * 3);
+		size_t written = 0;
+		for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			uint32_t corners[3];
+			if (mode == g_ModeTriangles)
+			{
+				corners[0] = readIndex(triangle * 3);
+				corners[1] = readIndex(triangle * 3 + 1);
+				corners[2] = readIndex(triangle * 3 + 2);
+			}
+			else if (mode == g_ModeTriangleStrip)
+			{
+				// every other strip triangle is wound the other way
+				corners[0] = readIndex(triangle + (triangle & 1));
+				corners[1] = readIndex(triangle + 1 - (triangle & 1));
+				corners[2] = readIndex(triangle + 2);
+			}
+			else
+			{
+				corners[0] = readIndex(0);
+				corners[1] = readIndex(triangle + 1);
+				corners[2] = readIndex(triangle + 2);
+			}
+			if ((corners[0] >= positions.count) || (corners[1] >= positions.count) || (corners[2] >= positions.count))
+			{
+				continue;
+			}
+			if (bMirrored)
+			{
+				std::swap(corners[1], corners[2]);
+			}
+			mesh.indices[written++] = corners[0];
+			mesh.indices[written++] = corners[1];
+			mesh.indices[written++] = corners[2];
+		}
+		mesh.indices.resize(written);
+
+		if (!bNormals)
+		{
+			GenerateNormals(mesh, NULL);
+		}
+		ComputeBounds(mesh);
+		return(!mesh.indices.empty());
+	}
+
+	/***********************************************************
+	 *  ImportGLTF()
+	 *
+	 *  Maps a .glb or .gltf file and the external buffers it
+	 *  names, walks the node hierarchy of the default scene and
+	 *  builds every triangle primitive it places in parallel.
+	 ***********************************************************/
+	bool ImportGLTF(const std::string& filename, bool bBinary, IMPORTED_MODEL& model)
+	{
+		std::chrono::steady_clock::time_point parseStart = std::chrono::steady_clock::now();
+
+		MappedFile file;
+		if (!file.Open(filename.c_str()))
+		{
+			std::cout << "WARNING: could not map the model " << filename << std::endl;
+			return(false);
+		}
+		model.stats.fileBytes = file.GetSize();
+
+		// a binary file is a header and chunks of 32 bit words - the
+		// JSON chunk comes first and the binary buffer after it
+		const char* pJSON = (const char*)file.GetData();
+		size_t jsonLength = file.GetSize();
+		const unsigned char* pBinary = NULL;
+		size_t binaryLength = 0;
+		if (bBinary)
+		{
+			uint32_t header[5] = {};
+			if (file.GetSize() >= sizeof(header))
+			{
+				memcpy(header, file.GetData(), sizeof(header));
+			}
+			if ((header[0] != g_GLBMagic) || (header[1] != 2) || (header[2] > file.GetSize()) ||
+				(header[4] != g_GLBChunkJSON) || ((uint64_t)header[3] + 20 > header[2]))
+			{
+				std::cout << "WARNING: not a glTF 2.0 binary model " << filename << std::endl;
+				return(false);
+			}
+			pJSON = (const char*)file.GetData() + 20;
+			jsonLength = header[3];
+
+			size_t binaryChunk = 20 + (size_t)header[3];
+			uint32_t chunkHeader[2] = {};
+			if (binaryChunk + sizeof(chunkHeader) <= header[2])
+			{
+				memcpy(chunkHeader, file.GetData() + binaryChunk, sizeof(chunkHeader));
+				if ((chunkHeader[1] == g_GLBChunkBinary) &&
+					((uint64_t)binaryChunk + sizeof(chunkHeader) + chunkHeader[0] <= header[2]))
+				{
+					pBinary = file.GetData() + binaryChunk + sizeof(chunkHeader);
+					binaryLength = chunkHeader[0];
+				}
+			}
+		}
+
+		JSON_PARSER parser;
+		parser.p = pJSON;
+		parser.pEnd = pJSON + jsonLength;
+		parser.values.reserve(jsonLength / 8 + 16);
+		if (!ParseJSONValue(parser, 0) || (parser.values[0].type != JSON_OBJECT))
+		{
+			std::cout << "WARNING: could not parse the glTF of the model " << filename << std::endl;
+			return(false);
+		}
+		GLTF_DOCUMENT document;
+		document.values.swap(parser.values);
+
+		// the first buffer of a binary file is its binary chunk, and
+		// the others are mapped from their own files
+		std::vector<std::unique_ptr<MappedFile>> bufferFiles;
+		std::vector<GLTF_BUFFER_VIEW> buffers;
+		int bufferArray = document.Member(0, "buffers");
+		for (uint32_t i = 0; i < document.Count(bufferArray); i++)
+		{
+			int buffer = document.Element(bufferArray, i);
+			std::string uri = document.String(document.Member(buffer, "uri"));
+			GLTF_BUFFER_VIEW span = {};
+			if (uri.empty() && (i == 0))
+			{
+				span.pData = pBinary;
+				span.length = binaryLength;
+			}
+			else if (!uri.empty() && (uri.compare(0, 5, "data:") != 0))
+			{
+				std::unique_ptr<MappedFile> pBufferFile(new MappedFile());
+				if (pBufferFile->Open((GetDirectory(filename) + uri).c_str()))
+				{
+					span.pData = pBufferFile->GetData();
+					span.length = pBufferFile->GetSize();
+					model.stats.fileBytes += span.length;
+					bufferFiles.push_back(std::move(pBufferFile));
+				}
+			}
+			if (NULL == span.pData)
+			{
+				std::cout << "WARNING: could not read buffer " << i << " of the model " << filename << std::endl;
+			}
+			// a buffer declares its length, which may be shorter
+			span.length = std::min(span.length, (size_t)std::max(document.Number(document.Member(buffer, "byteLength"), 0.0), 0.0));
+			buffers.push_back(span);
+		}
+
+		std::vector<GLTF_BUFFER_VIEW> views;
+		int viewArray = document.Member(0, "bufferViews");
+		for (uint32_t i = 0; i < document.Count(viewArray); i++)
+		{
+			int view = document.Element(viewArray, i);
+			int buffer = document.Index(document.Member(view, "buffer"));
+			size_t offset = (size_t)std::max(document.Index(document.Member(view, "byteOffset")), 0);
+			size_t length = (size_t)std::max(document.Index(document.Member(view, "byteLength")), 0);
+			GLTF_BUFFER_VIEW span = {};
+			if ((buffer >= 0) && ((size_t)buffer < buffers.size()) && (NULL != buffers[buffer].pData) &&
+				((uint64_t)offset + length <= buffers[buffer].length))
+			{
+				span.pData = buffers[buffer].pData + offset;
+				span.length = length;
+				span.stride = (size_t)std::max(document.Index(document.Member(view, "byteStride")), 0);
+			}
+			views.push_back(span);
+		}
+
+		int materialArray = document.Member(0, "materials");
+		for (uint32_t i = 0; i < document.Count(materialArray); i++)
+		{
+			model.materials.push_back(ConvertGLTFMaterial(document, document.Element(materialArray, i), i));
+		}
+
+		// place the meshes the way the default scene does, or every
+		// mesh at the origin when the file has no scene
+		std::vector<GLTF_PRIMITIVE> primitives;
+		int sceneArray = document.Member(0, "scenes");
+		int scene = document.Element(sceneArray, (uint32_t)std::max(document.Index(document.Member(0, "scene")), 0));
+		if (scene >= 0)
+		{
+			int rootNodes = document.Member(scene, "nodes");
+			for (uint32_t i = 0; i < document.Count(rootNodes); i++)
+			{
+				CollectNodePrimitives(document, document.Index(document.Element(rootNodes, i)), glm::mat4(1.0f), 0, primitives);
+			}
+		}
+		else
+		{
+			int meshArray = document.Member(0, "meshes");
+			for (uint32_t mesh = 0; mesh < document.Count(meshArray); mesh++)
+			{
+				int primitiveArray = document.Member(document.Element(meshArray, mesh), "primitives");
+				for (uint32_t i = 0; i < document.Count(primitiveArray); i++)
+				{
+					GLTF_PRIMITIVE primitive;
+					primitive.name = "mesh " + std::to_string(mesh) + "/" + std::to_string(i);
+					primitive.world = glm::mat4(1.0f);
+					primitive.primitive = document.Element(primitiveArray, i);
+					primitive.material = document.Index(document.Member(primitive.primitive, "material"));
+					primitives.push_back(primitive);
+				}
+			}
+		}
+		for (GLTF_PRIMITIVE& primitive : primitives)
+		{
+			if ((size_t)std::max(primitive.material, 0) >= model.materials.size())
+			{
+				primitive.material = -1;
+			}
+		}
+		model.stats.parseMilliseconds = Milliseconds(parseStart);
+
+		// the primitives are built at once, and the vertices of each
+		// primitive in batches
+		std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+		std::vector<IMPORTED_MESH> meshes(primitives.size());
+		std::vector<uint8_t> built(primitives.size(), 0);
+		JobSystem::ParallelFor(primitives.size(), 1, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				built[i] = BuildGLTFPrimitive(document, views, primitives[i], meshes[i]) ? 1 : 0;
+			}
+		});
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			if (built[i])
+			{
+				model.meshes.push_back(std::move(meshes[i]));
+			}
+		}
+		model.stats.buildMilliseconds = Milliseconds(buildStart);
+		return(true);
+	}
+
+	/***********************************************************
+	 *  OBJ parsing
+	 *
+	 *  The file is split into chunks at line breaks.  A first
+	 *  pass counts the vertex lines of every chunk, so each
+	 *  chunk knows where its positions, texture coordinates
+	 *  and normals go in the shared arrays and how to resolve
+	 *  relative indices.  A second pass parses every chunk at
+	 *  once.  The faces are then gathered per material and the
+	 *  materials built at once.
+	 ***********************************************************/
+	struct OBJ_CORNER
+	{
+		int32_t position;
+		int32_t uv;
+		int32_t normal;
+
+		bool operator==(const OBJ_CORNER& other) const
+		{
+			return((position == other.position) && (uv == other.uv) && (normal == other.normal));
+		}
+	};
+
+	struct OBJ_CORNER_HASH
+	{
+		size_t operator()(const OBJ_CORNER& corner) const
+		{
+			uint64_t hash = (uint64_t)(uint32_t)corner.position * 0x9E3779B97F4A7C15ull;
+			hash ^= (uint64_t)(uint32_t)corner.uv * 0xC2B2AE3D27D4EB4Full + (hash >> 29);
+			hash ^= (uint64_t)(uint32_t)corner.normal * 0x165667B19E3779F9ull + (hash >> 32);
+			return((size_t)(hash ^ (hash >> 31)));
+		}
+	};
+
+	// a usemtl line - applies from the face it precedes
+	struct OBJ_MATERIAL_SWITCH
+	{
+		uint32_t face;
+		std::string name;
+	};
+
+	struct OBJ_CHUNK
+	{
+		const char* pBegin;
+		const char* pEnd;
+		// vertex lines in the chunk, and before it
+		uint32_t positionCount;
+		uint32_t uvCount;
+		uint32_t normalCount;
+		uint32_t positionBase;
+		uint32_t uvBase;
+		uint32_t normalBase;
+		std::vector<OBJ_CORNER> corners;
+		// first corner of every face, and one past the last
+		std::vector<uint32_t> faceStarts;
+		std::vector<OBJ_MATERIAL_SWITCH> materialSwitches;
+		std::string materialLibrary;
+	};
+
+	// the faces of one chunk that use one material
+	struct OBJ_SEGMENT
+	{
+		uint32_t chunk;
+		uint32_t firstFace;
+		uint32_t endFace;
+	};
+
+	struct OBJ_GROUP
+	{
+		std::string material;
+		std::vector<OBJ_SEGMENT> segments;
+	};
+
+	const char* SkipSpace(const char* p, const char* pEnd)
+	{
+		while ((p < pEnd) && ((*p == ' ') || (*p == '\t')))
+		{
+			p++;
+		}
+		return(p);
+	}
+
+	// the rest of a line without surrounding white space
+	std::string GetLineText(const char* p, const char* pLineEnd)
+	{
+		p = SkipSpace(p, pLineEnd);
+		while ((pLineEnd > p) && ((pLineEnd[-1] == ' ') || (pLineEnd[-1] == '\t') || (pLineEnd[-1] == '\r')))
+		{
+			pLineEnd--;
+		}
+		return(std::string(p, pLineEnd));
+	}
+
+	// whether a line starts with the keyword followed by a space
+	bool IsKeyword(const char* p, const char* pLineEnd, const char* keyword, size_t length)
+	{
+		return((pLineEnd - p > (ptrdiff_t)length) && (memcmp(p, keyword, length) == 0) &&
+			((p[length] == ' ') || (p[length] == '\t')));
+	}
+
+	// read up to the passed in count of floats from the line
+	uint32_t ReadFloats(const char* p, const char* pLineEnd, float* pValues, uint32_t count)
+	{
+		uint32_t read = 0;
+		while (read < count)
+		{
+			p = SkipSpace(p, pLineEnd);
+			double value = 0.0;
+			if (!ParseNumber(p, pLineEnd, value))
+			{
+				break;
+			}
+			pValues[read++] = (float)value;
+		}
+		return(read);
+	}
+
+	// turn a 1 based or negative relative OBJ index into a 0 based
+	// one, or -1 when it is missing
+	int32_t ResolveOBJIndex(const char*& p, const char* pLineEnd, uint32_t definedSoFar)
+	{
+		double value = 0.0;
+		if (!ParseNumber(p, pLineEnd, value))
+		{
+			return(-1);
+		}
+		int64_t index = (int64_t)value;
+		if (index > 0)
+		{
+			return((index <= 0x7FFFFFFF) ? (int32_t)(index - 1) : -1);
+		}
+		if (index < 0)
+		{
+			int64_t resolved = (int64_t)definedSoFar + index;
+			return((resolved >= 0) ? (int32_t)resolved : -1);
+		}
+		return(-1);
+	}
+
+	// calls the function with the start and end of every line
+	template <class FUNCTION>
+	void ForEachLine(const char* p, const char* pEnd, FUNCTION function)
+	{
+		while (p < pEnd)
+		{
+			const char* pLineEnd = (const char*)memchr(p, '\n', (size_t)(pEnd - p));
+			if (NULL == pLineEnd)
+			{
+				pLineEnd = pEnd;
+			}
+			function(SkipSpace(p, pLineEnd), pLineEnd);
+			p = pLineEnd + 1;
+		}
+	}
+
+	void CountOBJChunk(OBJ_CHUNK& chunk)
+	{
+		chunk.positionCount = 0;
+		chunk.uvCount = 0;
+		chunk.normalCount = 0;
+		ForEachLine(chunk.pBegin, chunk.pEnd, [&chunk](const char* p, const char* pLineEnd)
+		{
+			if ((pLineEnd - p < 2) || (p[0] != 'v'))
+			{
+				return;
+			}
+			if ((p[1] == ' ') || (p[1] == '\t'))
+			{
+				chunk.positionCount++;
+			}
+			else if (IsKeyword(p, pLineEnd, "vt", 2))
+			{
+				chunk.uvCount++;
+			}
+			else if (IsKeyword(p, pLineEnd, "vn", 2))
+			{
+				chunk.normalCount++;
+			}
+		});
+	}
+
+	void ParseOBJChunk(
+		OBJ_CHUNK& chunk,
+		std::vector<glm::vec3>& positions,
+		std::vector<glm::vec2>& uvs,
+		std::vector<glm::vec3>& normals)
+	{
+		uint32_t positionIndex = chunk.positionBase;
+		uint32_t uvIndex = chunk.uvBase;
+		uint32_t normalIndex = chunk.normalBase;
+		ForEachLine(chunk.pBegin, chunk.pEnd, [&](const char* p, const char* pLineEnd)
+		{
+			if ((pLineEnd - p < 2) || (p[0] == '#'))
+			{
+				return;
+			}
+			if ((p[0] == 'v') && ((p[1] == ' ') || (p[1] == '\t')))
+			{
+				float values[3] = { 0.0f, 0.0f, 0.0f };
+				ReadFloats(p + 2, pLineEnd, values, 3);
+				positions[positionIndex++] = glm::vec3(values[0], values[1], values[2]);
+			}
+			else if (IsKeyword(p, pLineEnd, "vt", 2))
+			{
+				float values[2] = { 0.0f, 0.0f };
+				ReadFloats(p + 3, pLineEnd, values, 2);
+				uvs[uvIndex++] = glm::vec2(values[0], values[1]);
+			}
+			else if (IsKeyword(p, pLineEnd, "vn", 2))
+			{
+				float values[3] = { 0.0f, 0.0f, 0.0f };
+				ReadFloats(p + 3, pLineEnd, values, 3);
+				normals[normalIndex++] = glm::vec3(values[0], values[1], values[2]);
+			}
+			else if ((p[0] == 'f') && ((p[1] == ' ') || (p[1] == '\t')))
+			{
+				// each corner is position[/uv][/normal], and the uv can
+				// be left empty
+				size_t firstCorner = chunk.corners.size();
+				const char* pCorner = SkipSpace(p + 2, pLineEnd);
+				while ((pCorner < pLineEnd) && (*pCorner != '\r'))
+				{
+					OBJ_CORNER corner = { -1, -1, -1 };
+					corner.position = ResolveOBJIndex(pCorner, pLineEnd, positionIndex);
+					if ((pCorner < pLineEnd) && (*pCorner == '/'))
+					{
+						pCorner++;
+						if ((pCorner < pLineEnd) && (*pCorner != '/'))
+						{
+							corner.uv = ResolveOBJIndex(pCorner, pLineEnd, uvIndex);
+						}
+						if ((pCorner < pLineEnd) && (*pCorner == '/'))
+						{
+							pCorner++;
+							corner.normal = ResolveOBJIndex(pCorner, pLineEnd, normalIndex);
+						}
+					}
+					if (corner.position < 0)
+					{
+						// a corner that cannot be read drops the face
+						chunk.corners.resize(firstCorner);
+						return;
+					}
+					chunk.corners.push_back(corner);
+					pCorner = SkipSpace(pCorner, pLineEnd);
+				}
+				if (chunk.corners.size() - firstCorner < 3)
+				{
+					chunk.corners.resize(firstCorner);
+					return;
+				}
+				chunk.faceStarts.push_back((uint32_t)firstCorner);
+			}
+			else if (IsKeyword(p, pLineEnd, "usemtl", 6))
+			{
+				OBJ_MATERIAL_SWITCH materialSwitch;
+				materialSwitch.face = (uint32_t)chunk.faceStarts.size();
+				materialSwitch.name = GetLineText(p + 6, pLineEnd);
+				chunk.materialSwitches.push_back(materialSwitch);
+			}
+			else if (IsKeyword(p, pLineEnd, "mtllib", 6) && chunk.materialLibrary.empty())
+			{
+				chunk.materialLibrary = GetLineText(p + 6, pLineEnd);
+			}
+		});
+		chunk.faceStarts.push_back((uint32_t)chunk.corners.size());
+	}
+
+	// read the materials of an OBJ material library
+	void ReadMaterialLibrary(const std::string& filename, IMPORTED_MODEL& model)
+	{
+		MappedFile file;
+		if (!file.Open(filename.c_str()))
+		{
+			std::cout << "WARNING: could not map the material library " << filename << std::endl;
+			return;
+		}
+		model.stats.fileBytes += file.GetSize();
+
+		const char* pText = (const char*)file.GetData();
+		ForEachLine(pText, pText + file.GetSize(), [&model](const char* p, const char* pLineEnd)
+		{
+			if (IsKeyword(p, pLineEnd, "newmtl", 6))
+			{
+				IMPORTED_MATERIAL material;
+				material.name = GetLineText(p + 6, pLineEnd);
+				material.baseColor = glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
+				material.ambientColor = glm::vec3(1.0f);
+				material.ambientStrength = 0.15f;
+				material.diffuseColor = glm::vec3(1.0f);
+				material.specularColor = glm::vec3(0.0f);
+				material.shininess = 1.0f;
+				model.materials.push_back(material);
+				return;
+			}
+			if (model.materials.empty())
+			{
+				return;
+			}
+
+			// the diffuse color is the object color, since the scene
+			// multiplies the lighting by it
+			IMPORTED_MATERIAL& material = model.materials.back();
+			float values[3] = { 0.0f, 0.0f, 0.0f };
+			if (IsKeyword(p, pLineEnd, "Kd", 2) && (ReadFloats(p + 2, pLineEnd, values, 3) == 3))
+			{
+				material.baseColor = glm::vec4(values[0], values[1], values[2], material.baseColor.w);
+			}
+			else if (IsKeyword(p, pLineEnd, "Ka", 2) && (ReadFloats(p + 2, pLineEnd, values, 3) == 3))
+			{
+				material.ambientColor = glm::vec3(values[0], values[1], values[2]);
+				material.ambientStrength = 1.0f;
+			}
+			else if (IsKeyword(p, pLineEnd, "Ks", 2) && (ReadFloats(p + 2, pLineEnd, values, 3) == 3))
+			{
+				material.specularColor = glm::vec3(values[0], values[1], values[2]);
+			}
+			else if (IsKeyword(p, pLineEnd, "Ns", 2) && (ReadFloats(p + 2, pLineEnd, values, 1) == 1))
+			{
+				material.shininess = std::min(std::max(values[0], 1.0f), 256.0f);
+			}
+			else if (IsKeyword(p, pLineEnd, "d", 1) && (ReadFloats(p + 1, pLineEnd, values, 1) == 1))
+			{
+				material.baseColor.w = values[0];
+			}
+			else if (IsKeyword(p, pLineEnd, "Tr", 2) && (ReadFloats(p + 2, pLineEnd, values, 1) == 1))
+			{
+				material.baseColor.w = 1.0f - values[0];
+			}
+		});
+	}
+
+	// build the faces of one material into a compact mesh, sharing
+	// the vertices of corners that are exactly the same
+	void BuildOBJGroup(
+		const OBJ_GROUP& group,
+		const std::vector<OBJ_CHUNK>& chunks,
+		const std::vector<glm::vec3>& positions,
+		const std::vector<glm::vec2>& uvs,
+		const std::vector<glm::vec3>& normals,
+		IMPORTED_MESH& mesh)
+	{
+		size_t cornerCount = 0;
+		for (const OBJ_SEGMENT& segment : group.segments)
+		{
+			const OBJ_CHUNK& chunk = chunks[segment.chunk];
+			cornerCount += chunk.faceStarts[segment.endFace] - chunk.faceStarts[segment.firstFace];
+		}
+
+		std::unordered_map<OBJ_CORNER, uint32_t, OBJ_CORNER_HASH> vertexOfCorner;
+		vertexOfCorner.reserve(cornerCount);
+		std::vector<uint8_t> missingNormals;
+		bool bMissingNormals = false;
+		mesh.vertices.reserve(cornerCount);
+		mesh.indices.reserve(cornerCount * 3);
+
+		std::vector<uint32_t> faceVertices;
+		for (const OBJ_SEGMENT& segment : group.segments)
+		{
+			const OBJ_CHUNK& chunk = chunks[segment.chunk];
+			for (uint32_t face = segment.firstFace; face < segment.endFace; face++)
+			{
+				faceVertices.clear();
+				for (uint32_t c = chunk.faceStarts[face]; c < chunk.faceStarts[face + 1]; c++)
+				{
+					OBJ_CORNER corner = chunk.corners[c];
+					if ((size_t)corner.position >= positions.size())
+					{
+						break;
+					}
+					if ((corner.uv >= 0) && ((size_t)corner.uv >= uvs.size()))
+					{
+						corner.uv = -1;
+					}
+					if ((corner.normal >= 0) && ((size_t)corner.normal >= normals.size()))
+					{
+						corner.normal = -1;
+					}
+
+					auto found = vertexOfCorner.find(corner);
+					if (found != vertexOfCorner.end())
+					{
+						faceVertices.push_back(found->second);
+						continue;
+					}
+
+					COMPACT_VERTEX vertex;
+					const glm::vec3& position = positions[corner.position];
+					vertex.position[0] = position.x;
+					vertex.position[1] = position.y;
+					vertex.position[2] = position.z;
+					glm::vec3 normal = (corner.normal >= 0) ? normals[corner.normal] : glm::vec3(0.0f);
+					float length = glm::length(normal);
+					vertex.normal = PackCompactNormal((length > 0.0f) ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f));
+					glm::vec2 uv = (corner.uv >= 0) ? uvs[corner.uv] : glm::vec2(0.0f);
+					vertex.uv[0] = PackHalfFloat(uv.x);
+					vertex.uv[1] = PackHalfFloat(uv.y);
+
+					uint32_t index = (uint32_t)mesh.vertices.size();
+					mesh.vertices.push_back(vertex);
+					missingNormals.push_back((length > 0.0f) ? 0 : 1);
+					bMissingNormals |= !(length > 0.0f);
+					vertexOfCorner.emplace(corner, index);
+					faceVertices.push_back(index);
+				}
+
+				// polygons are split into a fan of triangles
+				if (faceVertices.size() != chunk.faceStarts[face + 1] - chunk.faceStarts[face])
+				{
+					continue;
+				}
+				for (size_t i = 1; i + 1 < faceVertices.size(); i++)
+				{
+					mesh.indices.push_back(faceVertices[0]);
+					mesh.indices.push_back(faceVertices[i]);
+					mesh.indices.push_back(faceVertices[i + 1]);
+				}
+			}
+		}
+
+		if (bMissingNormals)
+		{
+			GenerateNormals(mesh, &missingNormals);
+		}
+		mesh.vertices.shrink_to_fit();
+		mesh.indices.shrink_to_fit();
+		ComputeBounds(mesh);
+	}
+
+	/***********************************************************
+	 *  ImportOBJ()
+	 *
+	 *  Maps an OBJ file, parses its chunks in parallel and
+	 *  builds one mesh per material in parallel.
+	 ***********************************************************/
+	bool ImportOBJ(const std::string& filename, IMPORTED_MODEL& model)
+	{
+		std::chrono::steady_clock::time_point parseStart = std::chrono::steady_clock::now();
+
+		MappedFile file;
+		if (!file.Open(filename.c_str()))
+		{
+			std::cout << "WARNING: could not map the model " << filename << std::endl;
+			return(false);
+		}
+		model.stats.fileBytes = file.GetSize();
+
+		// enough chunks to keep every thread busy, each ending on a
+		// line break
+		const char* pText = (const char*)file.GetData();
+		const char* pTextEnd = pText + file.GetSize();
+		size_t chunkCount = std::max<size_t>(1, std::min<size_t>(
+			file.GetSize() / g_MinimumChunkBytes, (size_t)JobSystem::GetThreadCount() * 4));
+		std::vector<OBJ_CHUNK> chunks;
+		const char* pChunk = pText;
+		for (size_t i = 0; (i < chunkCount) && (pChunk < pTextEnd); i++)
+		{
+			const char* pChunkEnd = (i + 1 == chunkCount) ? pTextEnd : pText + file.GetSize() * (i + 1) / chunkCount;
+			pChunkEnd = std::max(pChunkEnd, pChunk);
+			const char* pLineBreak = (const char*)memchr(pChunkEnd, '\n', (size_t)(pTextEnd - pChunkEnd));
+			pChunkEnd = (NULL == pLineBreak) ? pTextEnd : pLineBreak + 1;
+
+			OBJ_CHUNK chunk;
+			chunk.pBegin = pChunk;
+			chunk.pEnd = pChunkEnd;
+			chunks.push_back(chunk);
+			pChunk = pChunkEnd;
+		}
+
+		JobSystem::ParallelFor(chunks.size(), 1, [&chunks](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				CountOBJChunk(chunks[i]);
+			}
+		});
+
+		uint64_t positionTotal = 0;
+		uint64_t uvTotal = 0;
+		uint64_t normalTotal = 0;
+		for (OBJ_CHUNK& chunk : chunks)
+		{
+			chunk.positionBase = (uint32_t)positionTotal;
+			chunk.uvBase = (uint32_t)uvTotal;
+			chunk.normalBase = (uint32_t)normalTotal;
+			positionTotal += chunk.positionCount;
+			uvTotal += chunk.uvCount;
+			normalTotal += chunk.normalCount;
+		}
+		if (positionTotal > 0x7FFFFFFF)
+		{
+			std::cout << "WARNING: too many vertices in the model " << filename << std::endl;
+			return(false);
+		}
+
+		std::vector<glm::vec3> positions((size_t)positionTotal);
+		std::vector<glm::vec2> uvs((size_t)uvTotal);
+		std::vector<glm::vec3> normals((size_t)normalTotal);
+		JobSystem::ParallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				ParseOBJChunk(chunks[i], positions, uvs, normals);
+			}
+		});
+
+		for (const OBJ_CHUNK& chunk : chunks)
+		{
+			if (!chunk.materialLibrary.empty())
+			{
+				ReadMaterialLibrary(GetDirectory(filename) + chunk.materialLibrary, model);
+				break;
+			}
+		}
+
+		// gather the faces by the material in use when they appear
+		std::vector<OBJ_GROUP> groups;
+		std::unordered_map<std::string, size_t> groupOfMaterial;
+		std::string material;
+		for (uint32_t c = 0; c < chunks.size(); c++)
+		{
+			const OBJ_CHUNK& chunk = chunks[c];
+			uint32_t faceCount = (uint32_t)chunk.faceStarts.size() - 1;
+			uint32_t firstFace = 0;
+			for (size_t s = 0; s <= chunk.materialSwitches.size(); s++)
+			{
+				uint32_t endFace = (s < chunk.materialSwitches.size()) ? chunk.materialSwitches[s].face : faceCount;
+				if (endFace > firstFace)
+				{
+					auto found = groupOfMaterial.find(material);
+					if (found == groupOfMaterial.end())
+					{
+						found = groupOfMaterial.emplace(material, groups.size()).first;
+						groups.push_back(OBJ_GROUP());
+						groups.back().material = material;
+					}
+					groups[found->second].segments.push_back({ c, firstFace, endFace });
+				}
+				if (s < chunk.materialSwitches.size())
+				{
+					material = chunk.materialSwitches[s].name;
+					firstFace = endFace;
+				}
+			}
+		}
+		model.stats.parseMilliseconds = Milliseconds(parseStart);
+
+		std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+		model.meshes.resize(groups.size());
+		JobSystem::ParallelFor(groups.size(), 1, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				BuildOBJGroup(groups[i], chunks, positions, uvs, normals, model.meshes[i]);
+			}
+		});
+
+		// point the meshes at their materials, adding a plain one for
+		// any material the library did not define
+		for (size_t i = 0; i < groups.size(); i++)
+		{
+			IMPORTED_MESH& mesh = model.meshes[i];
+			mesh.name = groups[i].material.empty() ? "default" : groups[i].material;
+			mesh.material = -1;
+			if (groups[i].material.empty() || mesh.indices.empty())
+			{
+				continue;
+			}
+			for (size_t m = 0; m < model.materials.size(); m++)
+			{
+				if (model.materials[m].name == groups[i].material)
+				{
+					mesh.material = (int32_t)m;
+					break;
+				}
+			}
+			if (mesh.material < 0)
+			{
+				IMPORTED_MATERIAL plain;
+				plain.name = groups[i].material;
+				plain.baseColor = glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
+				plain.ambientColor = glm::vec3(1.0f);
+				plain.ambientStrength = 0.15f;
+				plain.diffuseColor = glm::vec3(1.0f);
+				plain.specularColor = glm::vec3(0.0f);
+				plain.shininess = 1.0f;
+				model.materials.push_back(plain);
+				mesh.material = (int32_t)model.materials.size() - 1;
+			}
+		}
+		model.meshes.erase(
+			std::remove_if(model.meshes.begin(), model.meshes.end(), [](const IMPORTED_MESH& mesh) { return mesh.indices.empty(); }),
+			model.meshes.end());
+		model.stats.buildMilliseconds = Milliseconds(buildStart);
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  Import()
+ *
+ *  This method is used for importing a model file, choosing
+ *  the format by its extension, building the levels of
+ *  detail of its meshes, and reporting how long it took and
+ *  how many bytes it read and built.
+ ***********************************************************/
+bool ModelImporter::Import(const char* filename, IMPORTED_MODEL& model, const std::vector<float>& lodRatios)
+{
+	std::chrono::steady_clock::time_point importStart = std::chrono::steady_clock::now();
+
+	model = IMPORTED_MODEL();
+	model.stats = {};
+	model.name = GetBaseName(filename);
+
+	std::string path = filename;
+	std::string extension = path.substr(std::min(path.find_last_of('.'), path.size()));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+
+	bool bImported = false;
+	if ((extension == ".glb") || (extension == ".gltf"))
+	{
+		bImported = ImportGLTF(path, extension == ".glb", model);
+	}
+	else if (extension == ".obj")
+	{
+		bImported = ImportOBJ(path, model);
+	}
+	else
+	{
+		std::cout << "WARNING: unknown model format " << filename << std::endl;
+	}
+	if (!bImported || model.meshes.empty())
+	{
+		if (bImported)
+		{
+			std::cout << "WARNING: no triangles in the model " << filename << std::endl;
+		}
+		return(false);
+	}
+
+	// each mesh is simplified on its own, largest first so a big
+	// mesh does not start last
+	std::chrono::steady_clock::time_point lodStart = std::chrono::steady_clock::now();
+	std::vector<size_t> lodOrder(model.meshes.size());
+	for (size_t i = 0; i < lodOrder.size(); i++)
+	{
+		lodOrder[i] = i;
+	}
+	std::sort(lodOrder.begin(), lodOrder.end(), [&model](size_t a, size_t b)
+		{ return model.meshes[a].indices.size() > model.meshes[b].indices.size(); });
+	JobSystem::ParallelFor(lodOrder.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			IMPORTED_MESH& mesh = model.meshes[lodOrder[i]];
+			MeshSimplifier::BuildLodChain(
+				mesh.vertices.data(),
+				(uint32_t)mesh.vertices.size(),
+				mesh.indices.data(),
+				mesh.indices.size(),
+				lodRatios,
+				mesh.lods);
+		}
+	});
+	model.stats.lodMilliseconds = Milliseconds(lodStart);
+
+	for (const IMPORTED_MESH& mesh : model.meshes)
+	{
+		model.stats.lodTriangleCount += (uint32_t)((mesh.lods.empty() ? mesh.indices.size() : mesh.lods.back().indices.size()) / 3);
+		model.stats.vertexCount += (uint32_t)mesh.vertices.size();
+		model.stats.triangleCount += (uint32_t)(mesh.indices.size() / 3);
+		model.stats.vertexBytes += mesh.vertices.size() * sizeof(COMPACT_VERTEX);
+		model.stats.indexBytes += mesh.indices.size() * sizeof(uint32_t);
+		for (const MESH_LOD& lod : mesh.lods)
+		{
+			model.stats.indexBytes += lod.indices.size() * sizeof(uint32_t);
+		}
+	}
+	model.stats.totalMilliseconds = Milliseconds(importStart);
+
+	std::cout << "INFO: imported model " << model.name << ": " << model.meshes.size() << " meshes, "
+		<< model.stats.vertexCount << " vertices, " << model.stats.triangleCount << " triangles from "
+		<< model.stats.fileBytes / 1024 << " KB in " << model.stats.totalMilliseconds << " ms (parse "
+		<< model.stats.parseMilliseconds << " ms, build " << model.stats.buildMilliseconds << " ms, levels of detail "
+		<< model.stats.lodMilliseconds << " ms down to " << model.stats.lodTriangleCount << " triangles), "
+		<< model.stats.vertexBytes / 1024 << " KB of vertices, " << model.stats.indexBytes / 1024 << " KB of indices"
+		<< std::endl;
+	return(true);
+}
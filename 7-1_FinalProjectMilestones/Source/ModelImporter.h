@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+// modelimporter.h
+// ============
+// import glTF and OBJ models into compact meshes and materials
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ModelMeshes.h"
+#include "MeshSimplifier.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  IMPORTED_MATERIAL
+ *
+ *  One material of an imported model, in the terms of the
+ *  scene's Phong materials.  glTF metallic roughness values
+ *  are converted when the model is read.  The scene shader
+ *  multiplies the lighting by the object color, so the base
+ *  color becomes the color of the objects using it.
+ ***********************************************************/
+struct IMPORTED_MATERIAL
+{
+	std::string name;
+	glm::vec4 baseColor;
+	glm::vec3 ambientColor;
+	float ambientStrength;
+	glm::vec3 diffuseColor;
+	glm::vec3 specularColor;
+	float shininess;
+};
+
+/***********************************************************
+ *  IMPORTED_MESH
+ *
+ *  One part of an imported model drawn with one material,
+ *  as an indexed triangle list in model space.
+ ***********************************************************/
+struct IMPORTED_MESH
+{
+	std::string name;
+	MeshVector<COMPACT_VERTEX> vertices;
+	MeshVector<uint32_t> indices;
+	// index into the model's materials, or -1 for none
+	int32_t material;
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+	// radius of the sphere around the model origin holding
+	// every vertex
+	float radius;
+	// simplified levels of detail, coarser down the list
+	std::vector<MESH_LOD> lods;
+};
+
+/***********************************************************
+ *  MODEL_IMPORT_STATS
+ *
+ *  What importing one model took.
+ ***********************************************************/
+struct MODEL_IMPORT_STATS
+{
+	// bytes of the mapped files, including buffers and materials
+	size_t fileBytes;
+	// bytes of the compact vertices and 32 bit indices built,
+	// including the levels of detail
+	size_t vertexBytes;
+	size_t indexBytes;
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+	// triangles in the coarsest levels of detail
+	uint32_t lodTriangleCount;
+	double parseMilliseconds;
+	double buildMilliseconds;
+	double lodMilliseconds;
+	double totalMilliseconds;
+};
+
+/***********************************************************
+ *  IMPORTED_MODEL
+ *
+ *  Every mesh and material read from a model file.
+ ***********************************************************/
+struct IMPORTED_MODEL
+{
+	std::string name;
+	std::vector<IMPORTED_MESH> meshes;
+	std::vector<IMPORTED_MATERIAL> materials;
+	MODEL_IMPORT_STATS stats;
+};
+
+/***********************************************************
+ *  ModelImporter
+ *
+ *  This class reads glTF 2.0 (.glb, or .gltf with external
+ *  buffers) and Wavefront OBJ models.  The files are mapped
+ *  rather than read, and parsed in place: glTF accessors
+ *  read the mapped binary buffer directly through their
+ *  offsets and strides, and OBJ text is split into chunks
+ *  at line breaks that are parsed on the job system at
+ *  once.  The meshes are then built into the compact vertex
+ *  format in parallel, and simplified into their levels of
+ *  detail in parallel.
+ ***********************************************************/
+class ModelImporter
+{
+public:
+	// import a model, choosing the format by the extension, with
+	// a level of detail for each ratio of the triangles - none
+	// when the list is empty
+	static bool Import(
+		const char* filename,
+		IMPORTED_MODEL& model,
+		const std::vector<float>& lodRatios = MESH_DEFAULT_LOD_RATIOS);
+};
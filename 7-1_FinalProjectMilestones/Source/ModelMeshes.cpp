@@ -0,0 +1,401 @@
+///////////////////////////////////////////////////////////////////////////////
+// modelmeshes.cpp
+// ============
+// the compact vertex format and the OpenGL buffers of imported meshes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ModelMeshes.h"
+#include "MeshCodec.h"
+#include "GLDebug.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// largest vertex count that 16 bit indices can address
+	const uint32_t g_ShortIndexVertexLimit = 65536;
+
+	// one signed normalized 10 bit component
+	uint32_t PackSignedTenBits(float value)
+	{
+		float clamped = std::min(std::max(value, -1.0f), 1.0f);
+		int32_t scaled = (int32_t)std::lround(clamped * 511.0f);
+		return((uint32_t)scaled & 0x3FF);
+	}
+
+	float UnpackSignedTenBits(uint32_t bits)
+	{
+		// sign extend the 10 bit value
+		int32_t value = (int32_t)(bits << 22) >> 22;
+		return(std::max((float)value / 511.0f, -1.0f));
+	}
+
+	// point the attribute locations the basic shapes use at the
+	// compact layout of the bound vertex buffer, so the scene
+	// shader draws both
+	void SetCompactVertexLayout()
+	{
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(COMPACT_VERTEX), (const void*)offsetof(COMPACT_VERTEX, position));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(COMPACT_VERTEX), (const void*)offsetof(COMPACT_VERTEX, normal));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(COMPACT_VERTEX), (const void*)offsetof(COMPACT_VERTEX, uv));
+		glEnableVertexAttribArray(2);
+	}
+}
+
+/***********************************************************
+ *  PackCompactNormal()
+ *
+ *  This function is used for packing a unit normal into the
+ *  signed normalized 10:10:10:2 layout OpenGL reads as
+ *  GL_INT_2_10_10_10_REV, x in the lowest bits.
+ ***********************************************************/
+uint32_t PackCompactNormal(const glm::vec3& normal)
+{
+	return(PackSignedTenBits(normal.x) |
+		(PackSignedTenBits(normal.y) << 10) |
+		(PackSignedTenBits(normal.z) << 20));
+}
+
+/***********************************************************
+ *  UnpackCompactNormal()
+ *
+ *  This function is used for reading a packed normal back
+ *  the way OpenGL does.
+ ***********************************************************/
+glm::vec3 UnpackCompactNormal(uint32_t packed)
+{
+	return(glm::vec3(
+		UnpackSignedTenBits(packed & 0x3FF),
+		UnpackSignedTenBits((packed >> 10) & 0x3FF),
+		UnpackSignedTenBits((packed >> 20) & 0x3FF)));
+}
+
+/***********************************************************
+ *  PackHalfFloat()
+ *
+ *  This function is used for converting a float into an
+ *  IEEE half float, rounding to nearest.  Values too large
+ *  for a half become infinity and tiny ones denormals.
+ ***********************************************************/
+uint16_t PackHalfFloat(float value)
+{
+	uint32_t bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t exponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	// infinity and NaN keep their meaning
+	if (exponent == 0xFF)
+	{
+		return((uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0)));
+	}
+
+	int32_t halfExponent = (int32_t)exponent - 127 + 15;
+	if (halfExponent >= 31)
+	{
+		return((uint16_t)(sign | 0x7C00));
+	}
+	if (halfExponent <= 0)
+	{
+		// too small even for a denormal
+		if (halfExponent < -10)
+		{
+			return((uint16_t)sign);
+		}
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - halfExponent);
+		uint32_t halfMantissa = mantissa >> shift;
+		// round half to even on the bits shifted out
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if ((remainder > halfway) || ((remainder == halfway) && (halfMantissa & 1)))
+		{
+			halfMantissa++;
+		}
+		return((uint16_t)(sign | halfMantissa));
+	}
+
+	uint32_t half = sign | ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1FFF;
+	// a carry out of the mantissa correctly bumps the exponent
+	if ((remainder > 0x1000) || ((remainder == 0x1000) && (half & 1)))
+	{
+		half++;
+	}
+	return((uint16_t)half);
+}
+
+/***********************************************************
+ *  UnpackHalfFloat()
+ *
+ *  This function is used for converting an IEEE half float
+ *  back into a float.
+ ***********************************************************/
+float UnpackHalfFloat(uint16_t half)
+{
+	uint32_t sign = ((uint32_t)half & 0x8000) << 16;
+	uint32_t exponent = ((uint32_t)half >> 10) & 0x1F;
+	uint32_t mantissa = (uint32_t)half & 0x3FF;
+
+	uint32_t bits = 0;
+	if (exponent == 0)
+	{
+		if (mantissa == 0)
+		{
+			bits = sign;
+		}
+		else
+		{
+			// renormalize the denormal
+			exponent = 127 - 15 + 1;
+			while ((mantissa & 0x400) == 0)
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+	}
+	else if (exponent == 31)
+	{
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+
+	float value = 0.0f;
+	memcpy(&value, &bits, sizeof(value));
+	return(value);
+}
+
+/***********************************************************
+ *  ModelMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ModelMeshes::ModelMeshes()
+{
+	m_uploadedBytes = 0;
+}
+
+/***********************************************************
+ *  AddMesh()
+ *
+ *  This method is used for creating the vertex array and
+ *  buffers of one mesh.  An imported mesh never changes once
+ *  it is uploaded, so the buffers are static.  The indices
+ *  of the levels of detail are appended to the indices of
+ *  the full mesh, past any that do not fit.
+ ***********************************************************/
+int ModelMeshes::AddMesh(
+	const std::string& name,
+	const COMPACT_VERTEX* pVertices,
+	uint32_t vertexCount,
+	const uint32_t* pIndices,
+	uint32_t indexCount,
+	const std::vector<MESH_LOD>& lods)
+{
+	if ((vertexCount == 0) || (indexCount == 0))
+	{
+		return(-1);
+	}
+
+	GPU_MESH mesh;
+	mesh.indexType = (vertexCount <= g_ShortIndexVertexLimit) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	mesh.lodCount = (uint32_t)std::min<size_t>(lods.size() + 1, MESH_MAX_LODS);
+	mesh.lodFirstIndex[0] = 0;
+	mesh.lodIndexCount[0] = indexCount;
+	mesh.lodError[0] = 0.0f;
+	uint32_t totalIndexCount = indexCount;
+	for (uint32_t lod = 1; lod < mesh.lodCount; lod++)
+	{
+		mesh.lodFirstIndex[lod] = totalIndexCount;
+		mesh.lodIndexCount[lod] = (uint32_t)lods[lod - 1].indices.size();
+		mesh.lodError[lod] = lods[lod - 1].error;
+		totalIndexCount += mesh.lodIndexCount[lod];
+	}
+	mesh.vertexArray = GLVertexArrayHandle::Create(name + " vertex array");
+	mesh.vertexBuffer = GLBufferHandle::Create(name + " vertices");
+	mesh.indexBuffer = GLBufferHandle::Create(name + " indices");
+
+	glBindVertexArray(mesh.vertexArray.GetName());
+
+	size_t vertexBytes = (size_t)vertexCount * sizeof(COMPACT_VERTEX);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer.GetName());
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, pVertices, GL_STATIC_DRAW);
+
+	SetCompactVertexLayout();
+
+	// every level goes into one array of the index type
+	size_t indexSize = (mesh.indexType == GL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(uint32_t);
+	size_t indexBytes = (size_t)totalIndexCount * indexSize;
+	std::vector<unsigned char> indexData(indexBytes);
+	for (uint32_t lod = 0; lod < mesh.lodCount; lod++)
+	{
+		const uint32_t* pLodIndices = (lod == 0) ? pIndices : lods[lod - 1].indices.data();
+		unsigned char* pDestination = indexData.data() + (size_t)mesh.lodFirstIndex[lod] * indexSize;
+		if (mesh.indexType == GL_UNSIGNED_SHORT)
+		{
+			for (uint32_t i = 0; i < mesh.lodIndexCount[lod]; i++)
+			{
+				uint16_t index = (uint16_t)pLodIndices[i];
+				memcpy(pDestination + i * sizeof(uint16_t), &index, sizeof(index));
+			}
+		}
+		else
+		{
+			memcpy(pDestination, pLodIndices, (size_t)mesh.lodIndexCount[lod] * sizeof(uint32_t));
+		}
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer.GetName());
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return(FinishMesh(name, mesh, vertexBytes, indexBytes));
+}
+
+/***********************************************************
+ *  AddEncodedMesh()
+ *
+ *  This method is used for creating the vertex array and
+ *  buffers of a mesh stored by the mesh codec.  The buffers
+ *  are allocated empty and mapped for writing, and the
+ *  codec decodes into the mappings, so the mesh never sits
+ *  decoded in memory on the way to the GPU.
+ ***********************************************************/
+int ModelMeshes::AddEncodedMesh(const std::string& name, const unsigned char* pData, size_t size)
+{
+	ENCODED_MESH_HEADER header;
+	if (MeshCodec::ReadHeader(pData, size, header) == false)
+	{
+		return(-1);
+	}
+
+	GPU_MESH mesh;
+	mesh.indexType = (header.vertexCount <= g_ShortIndexVertexLimit) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	mesh.lodCount = header.lodCount;
+	uint32_t totalIndexCount = 0;
+	for (uint32_t lod = 0; lod < mesh.lodCount; lod++)
+	{
+		mesh.lodFirstIndex[lod] = totalIndexCount;
+		mesh.lodIndexCount[lod] = header.lodIndexCount[lod];
+		mesh.lodError[lod] = header.lodError[lod];
+		totalIndexCount += header.lodIndexCount[lod];
+	}
+	mesh.vertexArray = GLVertexArrayHandle::Create(name + " vertex array");
+	mesh.vertexBuffer = GLBufferHandle::Create(name + " vertices");
+	mesh.indexBuffer = GLBufferHandle::Create(name + " indices");
+
+	glBindVertexArray(mesh.vertexArray.GetName());
+
+	// a buffer whose contents were lost while it was mapped
+	// reports it when unmapped
+	size_t vertexBytes = (size_t)header.vertexCount * sizeof(COMPACT_VERTEX);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer.GetName());
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, NULL, GL_STATIC_DRAW);
+	void* pVertices = glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	bool bDecoded = (NULL != pVertices) && MeshCodec::DecodeVertices(pData, size, (COMPACT_VERTEX*)pVertices);
+	bDecoded = (NULL != pVertices) && (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE) && bDecoded;
+	SetCompactVertexLayout();
+
+	size_t indexSize = (mesh.indexType == GL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(uint32_t);
+	size_t indexBytes = (size_t)totalIndexCount * indexSize;
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer.GetName());
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, NULL, GL_STATIC_DRAW);
+	void* pIndices = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, indexBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	bool bIndicesDecoded = (NULL != pIndices) && MeshCodec::DecodeIndices(pData, size, pIndices, indexSize);
+	bDecoded = (NULL != pIndices) && (glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE) && bIndicesDecoded && bDecoded;
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the handles delete the buffers of a mesh that failed
+	if (bDecoded == false)
+	{
+		return(-1);
+	}
+	return(FinishMesh(name, mesh, vertexBytes, indexBytes));
+}
+
+/***********************************************************
+ *  FinishMesh()
+ *
+ *  This method is used for labeling the objects of a mesh
+ *  whose buffers are filled, charging their memory and
+ *  adding the mesh to the list.
+ ***********************************************************/
+int ModelMeshes::FinishMesh(const std::string& name, GPU_MESH& mesh, size_t vertexBytes, size_t indexBytes)
+{
+	// the labels are compiled out of release builds
+	(void)name;
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_VERTEX_ARRAY, mesh.vertexArray.GetName(), (name + " vertex array").c_str());
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, mesh.vertexBuffer.GetName(), (name + " vertices").c_str());
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, mesh.indexBuffer.GetName(), (name + " indices").c_str());
+	GLResourceManager::SetMemory(GLResourceManager::GLRES_BUFFER, mesh.vertexBuffer.GetName(), MemoryTracker::MEMTAG_MESHES, vertexBytes);
+	GLResourceManager::SetMemory(GLResourceManager::GLRES_BUFFER, mesh.indexBuffer.GetName(), MemoryTracker::MEMTAG_MESHES, indexBytes);
+	m_uploadedBytes += vertexBytes + indexBytes;
+
+	m_meshes.push_back(std::move(mesh));
+	return((int)m_meshes.size() - 1);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing every triangle of one
+ *  level of detail of one of the meshes.
+ ***********************************************************/
+void ModelMeshes::Draw(uint32_t mesh, uint32_t lod) const
+{
+	if (mesh >= m_meshes.size())
+	{
+		return;
+	}
+
+	const GPU_MESH& gpuMesh = m_meshes[mesh];
+	lod = std::min(lod, gpuMesh.lodCount - 1);
+	size_t indexSize = (gpuMesh.indexType == GL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(uint32_t);
+	glBindVertexArray(gpuMesh.vertexArray.GetName());
+	glDrawElements(
+		GL_TRIANGLES,
+		(GLsizei)gpuMesh.lodIndexCount[lod],
+		gpuMesh.indexType,
+		(const void*)((size_t)gpuMesh.lodFirstIndex[lod] * indexSize));
+}
+
+/***********************************************************
+ *  SelectLod()
+ *
+ *  This method is used for choosing the coarsest level of
+ *  detail of a mesh that strays no farther than the passed
+ *  in distance from the full mesh.  The errors only grow
+ *  down the chain, so the first one too large ends it.
+ ***********************************************************/
+uint32_t ModelMeshes::SelectLod(uint32_t mesh, float allowedError) const
+{
+	if (mesh >= m_meshes.size())
+	{
+		return(0);
+	}
+
+	const GPU_MESH& gpuMesh = m_meshes[mesh];
+	uint32_t lod = 0;
+	while ((lod + 1 < gpuMesh.lodCount) && (gpuMesh.lodError[lod + 1] <= allowedError))
+	{
+		lod++;
+	}
+	return(lod);
+}
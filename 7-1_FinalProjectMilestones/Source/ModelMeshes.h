@@ -0,0 +1,124 @@
+///////////////////////////////////////////////////////////////////////////////
+// modelmeshes.h
+// ============
+// the compact vertex format and the OpenGL buffers of imported meshes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLResources.h"
+#include "MemoryTracker.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CPU copies of imported geometry are charged to the mesh tag
+template <class T>
+using MeshVector = std::vector<T, TrackedAllocator<T, MemoryTracker::MEMTAG_MESHES>>;
+
+/***********************************************************
+ *  COMPACT_VERTEX
+ *
+ *  Vertex of an imported mesh in 20 bytes, where the basic
+ *  shapes use 32.  The normal is a signed normalized
+ *  10:10:10:2 value and the texture coordinate two half
+ *  floats, so the scene vertex shader reads the same vec3
+ *  and vec2 inputs without any change.
+ ***********************************************************/
+struct COMPACT_VERTEX
+{
+	float position[3];
+	uint32_t normal;
+	uint16_t uv[2];
+};
+
+static_assert(sizeof(COMPACT_VERTEX) == 20, "COMPACT_VERTEX must match the vertex array layout");
+
+/***********************************************************
+ *  MESH_LOD
+ *
+ *  A simplified level of detail of a mesh, drawn from the
+ *  vertices of the full mesh, and the farthest in model
+ *  units its surface is from the full one.
+ ***********************************************************/
+struct MESH_LOD
+{
+	MeshVector<uint32_t> indices;
+	float error;
+};
+
+// most levels of detail a mesh keeps, including the full mesh
+const uint32_t MESH_MAX_LODS = 8;
+
+// convert to and from the packed normal and the half floats
+uint32_t PackCompactNormal(const glm::vec3& normal);
+glm::vec3 UnpackCompactNormal(uint32_t packed);
+uint16_t PackHalfFloat(float value);
+float UnpackHalfFloat(uint16_t half);
+
+/***********************************************************
+ *  ModelMeshes
+ *
+ *  This class keeps the vertex arrays and buffers of the
+ *  imported meshes.  Every mesh gets its own vertex array
+ *  with the compact layout on the attribute locations the
+ *  basic shapes use, and 16 bit indices whenever it has few
+ *  enough vertices.  The levels of detail of a mesh follow
+ *  the full mesh in the same index buffer.  Meshes come
+ *  either as compact vertices or encoded by the mesh codec.
+ ***********************************************************/
+class ModelMeshes
+{
+public:
+	// constructor
+	ModelMeshes();
+
+	// upload a mesh and its levels of detail, and return its
+	// index, or -1 if it is empty
+	int AddMesh(
+		const std::string& name,
+		const COMPACT_VERTEX* pVertices,
+		uint32_t vertexCount,
+		const uint32_t* pIndices,
+		uint32_t indexCount,
+		const std::vector<MESH_LOD>& lods);
+	// decode a mesh encoded by the mesh codec straight into its
+	// buffers, and return its index, or -1 if it is damaged
+	int AddEncodedMesh(const std::string& name, const unsigned char* pData, size_t size);
+	// draw a level of detail of a mesh, 0 being the full mesh,
+	// with the vertex array left bound
+	void Draw(uint32_t mesh, uint32_t lod) const;
+	// the coarsest level of detail of a mesh whose error is
+	// within the passed in distance in model units
+	uint32_t SelectLod(uint32_t mesh, float allowedError) const;
+
+	uint32_t GetMeshCount() const { return (uint32_t)m_meshes.size(); }
+	// bytes of vertices and indices uploaded so far
+	size_t GetUploadedBytes() const { return m_uploadedBytes; }
+
+private:
+	struct GPU_MESH
+	{
+		GLVertexArrayHandle vertexArray;
+		GLBufferHandle vertexBuffer;
+		GLBufferHandle indexBuffer;
+		GLenum indexType;
+		// where each level of detail is in the index buffer, and
+		// its error - the full mesh first
+		uint32_t lodCount;
+		uint32_t lodFirstIndex[MESH_MAX_LODS];
+		uint32_t lodIndexCount[MESH_MAX_LODS];
+		float lodError[MESH_MAX_LODS];
+	};
+
+	std::vector<GPU_MESH> m_meshes;
+	size_t m_uploadedBytes;
+
+	// label and charge the filled buffers of a mesh and keep it
+	int FinishMesh(const std::string& name, GPU_MESH& mesh, size_t vertexBytes, size_t indexBytes);
+};
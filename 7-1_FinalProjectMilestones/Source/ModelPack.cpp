@@ -0,0 +1,328 @@
+///////////////////////////////////////////////////////////////////////////////
+// modelpack.cpp
+// ============
+// write imported models into packs of encoded meshes and map them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ModelPack.h"
+#include "MeshCodec.h"
+#include "JobSystem.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// sections start on this alignment, and so does every encoded
+	// mesh inside its section
+	const uint32_t g_SectionAlignment = 16;
+
+	uint32_t AlignOffset(uint32_t offset)
+	{
+		return((offset + g_SectionAlignment - 1) & ~(g_SectionAlignment - 1));
+	}
+
+	// add a string to the string table and return its offset
+	uint32_t AddString(std::vector<char>& strings, const std::string& text)
+	{
+		uint32_t offset = (uint32_t)strings.size();
+		strings.insert(strings.end(), text.begin(), text.end());
+		strings.push_back('\0');
+		return(offset);
+	}
+}
+
+/***********************************************************
+ *  ModelPack()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ModelPack::ModelPack()
+{
+	m_pHeader = nullptr;
+	m_pMaterials = nullptr;
+	m_pMeshes = nullptr;
+	m_pStrings = nullptr;
+	m_pEncoded = nullptr;
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for encoding the meshes of a model
+ *  and laying them out with its materials behind the pack
+ *  header.  The meshes are encoded on the job system, one
+ *  per job.
+ ***********************************************************/
+bool ModelPack::Write(const IMPORTED_MODEL& model, const char* filename)
+{
+	std::chrono::steady_clock::time_point writeStart = std::chrono::steady_clock::now();
+
+	std::vector<std::vector<unsigned char>> encodedMeshes(model.meshes.size());
+	std::vector<uint8_t> encodedFlags(model.meshes.size(), 0);
+	JobSystem::ParallelFor(model.meshes.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const IMPORTED_MESH& mesh = model.meshes[i];
+			encodedFlags[i] = MeshCodec::Encode(
+				mesh.vertices.data(),
+				(uint32_t)mesh.vertices.size(),
+				mesh.indices.data(),
+				(uint32_t)mesh.indices.size(),
+				mesh.lods,
+				encodedMeshes[i]) ? 1 : 0;
+		}
+	});
+
+	std::vector<char> strings;
+	MODEL_PACK_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.magic = MODEL_PACK_MAGIC;
+	header.version = MODEL_PACK_VERSION;
+	header.nameOffset = AddString(strings, model.name);
+
+	std::vector<MODEL_PACK_MATERIAL_RECORD> materialRecords(model.materials.size());
+	for (size_t i = 0; i < model.materials.size(); i++)
+	{
+		const IMPORTED_MATERIAL& material = model.materials[i];
+		MODEL_PACK_MATERIAL_RECORD& record = materialRecords[i];
+		memcpy(record.baseColor, glm::value_ptr(material.baseColor), sizeof(record.baseColor));
+		memcpy(record.ambientColor, glm::value_ptr(material.ambientColor), sizeof(record.ambientColor));
+		record.ambientStrength = material.ambientStrength;
+		memcpy(record.diffuseColor, glm::value_ptr(material.diffuseColor), sizeof(record.diffuseColor));
+		record.shininess = material.shininess;
+		memcpy(record.specularColor, glm::value_ptr(material.specularColor), sizeof(record.specularColor));
+		record.nameOffset = AddString(strings, material.name);
+	}
+
+	// the raw size counts the vertices and indices the way they
+	// are uploaded
+	std::vector<MODEL_PACK_MESH_RECORD> meshRecords;
+	uint32_t encodedBytes = 0;
+	size_t rawBytes = 0;
+	for (size_t i = 0; i < model.meshes.size(); i++)
+	{
+		if (encodedFlags[i] == 0)
+		{
+			continue;
+		}
+		const IMPORTED_MESH& mesh = model.meshes[i];
+		MODEL_PACK_MESH_RECORD record;
+		memset(&record, 0, sizeof(record));
+		record.nameOffset = AddString(strings, mesh.name);
+		record.material = mesh.material;
+		memcpy(record.boundsMin, glm::value_ptr(mesh.boundsMin), sizeof(record.boundsMin));
+		memcpy(record.boundsMax, glm::value_ptr(mesh.boundsMax), sizeof(record.boundsMax));
+		record.radius = mesh.radius;
+		record.encodedOffset = encodedBytes;
+		record.encodedSize = (uint32_t)encodedMeshes[i].size();
+		encodedBytes = AlignOffset(encodedBytes + record.encodedSize);
+		meshRecords.push_back(record);
+
+		size_t indexCount = mesh.indices.size();
+		for (const MESH_LOD& lod : mesh.lods)
+		{
+			indexCount += lod.indices.size();
+		}
+		rawBytes += mesh.vertices.size() * sizeof(COMPACT_VERTEX) +
+			indexCount * ((mesh.vertices.size() <= 65536) ? sizeof(uint16_t) : sizeof(uint32_t));
+	}
+
+	uint32_t offset = AlignOffset(sizeof(MODEL_PACK_HEADER));
+	header.materials.offset = offset;
+	header.materials.count = (uint32_t)materialRecords.size();
+	offset = AlignOffset(offset + header.materials.count * sizeof(MODEL_PACK_MATERIAL_RECORD));
+	header.meshes.offset = offset;
+	header.meshes.count = (uint32_t)meshRecords.size();
+	offset = AlignOffset(offset + header.meshes.count * sizeof(MODEL_PACK_MESH_RECORD));
+	header.strings.offset = offset;
+	header.strings.count = (uint32_t)strings.size();
+	offset = AlignOffset(offset + header.strings.count);
+	header.encoded.offset = offset;
+	header.encoded.count = encodedBytes;
+	header.fileSize = offset + encodedBytes;
+
+	std::vector<unsigned char> image(header.fileSize, 0);
+	memcpy(image.data(), &header, sizeof(header));
+	if (!materialRecords.empty())
+	{
+		memcpy(image.data() + header.materials.offset, materialRecords.data(), materialRecords.size() * sizeof(MODEL_PACK_MATERIAL_RECORD));
+	}
+	if (!meshRecords.empty())
+	{
+		memcpy(image.data() + header.meshes.offset, meshRecords.data(), meshRecords.size() * sizeof(MODEL_PACK_MESH_RECORD));
+	}
+	memcpy(image.data() + header.strings.offset, strings.data(), strings.size());
+	size_t record = 0;
+	for (size_t i = 0; i < model.meshes.size(); i++)
+	{
+		if (encodedFlags[i] != 0)
+		{
+			memcpy(image.data() + header.encoded.offset + meshRecords[record].encodedOffset, encodedMeshes[i].data(), encodedMeshes[i].size());
+			record++;
+		}
+	}
+
+	std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "WARNING: could not write the model pack " << filename << std::endl;
+		return(false);
+	}
+	file.write((const char*)image.data(), image.size());
+
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - writeStart).count();
+	std::cout << "INFO: wrote model pack " << filename << ": " << header.meshes.count << " meshes, "
+		<< header.materials.count << " materials, " << rawBytes / 1024 << " KB of vertices and indices encoded into "
+		<< encodedBytes / 1024 << " KB (" << ((encodedBytes > 0) ? (double)rawBytes / encodedBytes : 0.0) << " to 1) in "
+		<< milliseconds << " ms" << std::endl;
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  IsPackFilename()
+ *
+ *  This method is used for telling a model pack from the
+ *  model formats the importer reads by its extension.
+ ***********************************************************/
+bool ModelPack::IsPackFilename(const char* filename)
+{
+	std::string path = (NULL != filename) ? filename : "";
+	std::string extension = path.substr(std::min(path.find_last_of('.'), path.size()));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+	return(extension == ".mpk");
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for mapping a pack file and checking
+ *  that every section, string and encoded mesh it refers to
+ *  lies inside it.  The encoded meshes check themselves as
+ *  they are decoded.
+ ***********************************************************/
+bool ModelPack::Load(const char* filename)
+{
+	Unload();
+	if (m_file.Open(filename) == false)
+	{
+		std::cout << "WARNING: could not map the model pack " << filename << std::endl;
+		return(false);
+	}
+
+	const MODEL_PACK_HEADER* pHeader = (const MODEL_PACK_HEADER*)m_file.GetData();
+	if ((m_file.GetSize() < sizeof(MODEL_PACK_HEADER)) ||
+		(pHeader->magic != MODEL_PACK_MAGIC) ||
+		(pHeader->version != MODEL_PACK_VERSION) ||
+		(pHeader->fileSize != m_file.GetSize()))
+	{
+		std::cout << "WARNING: not a model pack of version " << MODEL_PACK_VERSION << ": " << filename << std::endl;
+		Unload();
+		return(false);
+	}
+
+	const unsigned char* pData = m_file.GetData();
+	bool bValid = IsSectionValid(pHeader->materials, sizeof(MODEL_PACK_MATERIAL_RECORD)) &&
+		IsSectionValid(pHeader->meshes, sizeof(MODEL_PACK_MESH_RECORD)) &&
+		IsSectionValid(pHeader->strings, 1) &&
+		IsSectionValid(pHeader->encoded, 1) &&
+		(pHeader->strings.count > 0) && (pData[pHeader->strings.offset + pHeader->strings.count - 1] == '\0') &&
+		(pHeader->nameOffset < pHeader->strings.count);
+
+	const MODEL_PACK_MATERIAL_RECORD* pMaterials = (const MODEL_PACK_MATERIAL_RECORD*)(pData + pHeader->materials.offset);
+	for (uint32_t i = 0; bValid && (i < pHeader->materials.count); i++)
+	{
+		bValid = (pMaterials[i].nameOffset < pHeader->strings.count);
+	}
+	const MODEL_PACK_MESH_RECORD* pMeshes = (const MODEL_PACK_MESH_RECORD*)(pData + pHeader->meshes.offset);
+	for (uint32_t i = 0; bValid && (i < pHeader->meshes.count); i++)
+	{
+		const MODEL_PACK_MESH_RECORD& mesh = pMeshes[i];
+		bValid = (mesh.nameOffset < pHeader->strings.count) &&
+			(mesh.material >= -1) && (mesh.material < (int32_t)pHeader->materials.count) &&
+			((uint64_t)mesh.encodedOffset + mesh.encodedSize <= pHeader->encoded.count);
+	}
+	if (bValid == false)
+	{
+		std::cout << "WARNING: the model pack is damaged: " << filename << std::endl;
+		Unload();
+		return(false);
+	}
+
+	// fix up the section pointers into the mapped file
+	m_pHeader = pHeader;
+	m_pMaterials = pMaterials;
+	m_pMeshes = pMeshes;
+	m_pStrings = (const char*)(pData + pHeader->strings.offset);
+	m_pEncoded = pData + pHeader->encoded.offset;
+	return(true);
+}
+
+/***********************************************************
+ *  Unload()
+ *
+ *  This method is used for unmapping the pack file.
+ ***********************************************************/
+void ModelPack::Unload()
+{
+	m_file.Close();
+	m_pHeader = nullptr;
+	m_pMaterials = nullptr;
+	m_pMeshes = nullptr;
+	m_pStrings = nullptr;
+	m_pEncoded = nullptr;
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting a string from the string
+ *  table by its byte offset.
+ ***********************************************************/
+const char* ModelPack::GetString(uint32_t offset) const
+{
+	if ((m_pHeader == nullptr) || (offset >= m_pHeader->strings.count))
+	{
+		return("");
+	}
+	return(m_pStrings + offset);
+}
+
+/***********************************************************
+ *  GetEncodedMesh()
+ *
+ *  This method is used for getting where the encoded bytes
+ *  of a mesh begin in the mapped file.
+ ***********************************************************/
+const unsigned char* ModelPack::GetEncodedMesh(uint32_t mesh) const
+{
+	if ((m_pHeader == nullptr) || (mesh >= m_pHeader->meshes.count))
+	{
+		return(nullptr);
+	}
+	return(m_pEncoded + m_pMeshes[mesh].encodedOffset);
+}
+
+/***********************************************************
+ *  IsSectionValid()
+ *
+ *  This method is used for checking that a section and all
+ *  of its records lie inside the mapped file.
+ ***********************************************************/
+bool ModelPack::IsSectionValid(const SCENE_SECTION& section, size_t recordSize) const
+{
+	uint64_t sectionEnd = (uint64_t)section.offset + (uint64_t)section.count * recordSize;
+	return((section.offset % 4 == 0) && (sectionEnd <= m_file.GetSize()));
+}
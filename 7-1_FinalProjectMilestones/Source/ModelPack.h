@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+// modelpack.h
+// ============
+// write imported models into packs of encoded meshes and map them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+#include "ModelImporter.h"
+#include "SceneFile.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// identifies a model pack and its layout version
+const uint32_t MODEL_PACK_MAGIC = 0x4B504D53; // "SMPK"
+const uint32_t MODEL_PACK_VERSION = 1;
+
+/***********************************************************
+ *  Model pack records
+ *
+ *  A model pack is the header followed by flat arrays of
+ *  these records, a string table and the meshes encoded by
+ *  the mesh codec, laid out like a compiled scene so it is
+ *  used in place from a memory mapping.
+ ***********************************************************/
+struct MODEL_PACK_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t fileSize;
+	// byte offset of the model name into the string table
+	uint32_t nameOffset;
+	SCENE_SECTION materials;
+	SCENE_SECTION meshes;
+	SCENE_SECTION strings;
+	// the count is in bytes
+	SCENE_SECTION encoded;
+};
+
+struct MODEL_PACK_MATERIAL_RECORD
+{
+	float baseColor[4];
+	float ambientColor[3];
+	float ambientStrength;
+	float diffuseColor[3];
+	float shininess;
+	float specularColor[3];
+	uint32_t nameOffset;
+};
+
+struct MODEL_PACK_MESH_RECORD
+{
+	uint32_t nameOffset;
+	// index into the materials, or -1 for none
+	int32_t material;
+	float boundsMin[3];
+	float boundsMax[3];
+	float radius;
+	// byte range of the encoded mesh in the encoded section
+	uint32_t encodedOffset;
+	uint32_t encodedSize;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(MODEL_PACK_HEADER) == 48, "model pack header layout changed");
+static_assert(sizeof(MODEL_PACK_MATERIAL_RECORD) == 64, "model pack material layout changed");
+static_assert(sizeof(MODEL_PACK_MESH_RECORD) == 48, "model pack mesh layout changed");
+
+/***********************************************************
+ *  ModelPack
+ *
+ *  This class writes an imported model, with the levels of
+ *  detail of its meshes, into a pack file, and maps a pack
+ *  file so its encoded meshes can be decoded straight into
+ *  their buffers.  Loading a pack skips parsing the model
+ *  and building its levels of detail, and reads a fraction
+ *  of the bytes.
+ ***********************************************************/
+class ModelPack
+{
+public:
+	// constructor
+	ModelPack();
+
+	// encode the meshes of a model on the job system and write
+	// them with its materials into a pack file
+	static bool Write(const IMPORTED_MODEL& model, const char* filename);
+	// whether a file name has the .mpk extension of a pack
+	static bool IsPackFilename(const char* filename);
+
+	// map a pack file and check its records
+	bool Load(const char* filename);
+	void Unload();
+	bool IsLoaded() const { return m_pHeader != nullptr; }
+
+	const char* GetName() const { return GetString(m_pHeader ? m_pHeader->nameOffset : 0); }
+	uint32_t GetMaterialCount() const { return m_pHeader ? m_pHeader->materials.count : 0; }
+	uint32_t GetMeshCount() const { return m_pHeader ? m_pHeader->meshes.count : 0; }
+	const MODEL_PACK_MATERIAL_RECORD* GetMaterials() const { return m_pMaterials; }
+	const MODEL_PACK_MESH_RECORD* GetMeshes() const { return m_pMeshes; }
+	size_t GetFileSize() const { return m_file.GetSize(); }
+
+	// get a string from the string table by byte offset
+	const char* GetString(uint32_t offset) const;
+	// get the encoded bytes of a mesh, whose size is in its record
+	const unsigned char* GetEncodedMesh(uint32_t mesh) const;
+
+private:
+	MappedFile m_file;
+
+	// section pointers fixed up from the header offsets
+	const MODEL_PACK_HEADER* m_pHeader;
+	const MODEL_PACK_MATERIAL_RECORD* m_pMaterials;
+	const MODEL_PACK_MESH_RECORD* m_pMeshes;
+	const char* m_pStrings;
+	const unsigned char* m_pEncoded;
+
+	// check that a section lies inside the mapped file
+	bool IsSectionValid(const SCENE_SECTION& section, size_t recordSize) const;
+};
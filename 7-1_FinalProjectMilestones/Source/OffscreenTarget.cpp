@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreentarget.cpp
+// ============
+// a color and depth framebuffer to render into without a window
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OffscreenTarget.h"
+#include "GLDebug.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the color and depth
+ *  renderbuffers and attaching them to a new framebuffer.
+ *  Each renderbuffer is charged four bytes a pixel.
+ ***********************************************************/
+bool OffscreenTarget::Create(int width, int height, const std::string& label, MemoryTracker::MEMORY_TAG tag)
+{
+	Destroy();
+
+	m_colorRenderbuffer = GLRenderbufferHandle::Create(label + " color");
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorRenderbuffer.GetName());
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	m_depthRenderbuffer = GLRenderbufferHandle::Create(label + " depth");
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbuffer.GetName());
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	size_t bufferBytes = (size_t)width * height * 4;
+	GLResourceManager::SetMemory(GLResourceManager::GLRES_RENDERBUFFER, m_colorRenderbuffer.GetName(), tag, bufferBytes);
+	GLResourceManager::SetMemory(GLResourceManager::GLRES_RENDERBUFFER, m_depthRenderbuffer.GetName(), tag, bufferBytes);
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_RENDERBUFFER, m_colorRenderbuffer.GetName(), (label + " color").c_str());
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_RENDERBUFFER, m_depthRenderbuffer.GetName(), (label + " depth").c_str());
+
+	m_framebuffer = GLFramebufferHandle::Create(label);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer.GetName());
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorRenderbuffer.GetName());
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer.GetName());
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "WARNING: the " << label << " framebuffer is incomplete (" << status << ")" << std::endl;
+		Destroy();
+		return(false);
+	}
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_FRAMEBUFFER, m_framebuffer.GetName(), label.c_str());
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the framebuffer and its
+ *  renderbuffers.  They are deleted, and their memory is
+ *  returned, once the GPU has finished the current frame.
+ ***********************************************************/
+void OffscreenTarget::Destroy()
+{
+	m_framebuffer.Reset();
+	m_colorRenderbuffer.Reset();
+	m_depthRenderbuffer.Reset();
+}
@@ -0,0 +1,41 @@
+///////////////////////////////////////////////////////////////////////////////
+// offscreentarget.h
+// ============
+// a color and depth framebuffer to render into without a window
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLResources.h"
+#include "MemoryTracker.h"
+
+#include <string>
+
+/***********************************************************
+ *  OffscreenTarget
+ *
+ *  This class owns an offscreen framebuffer with a color and
+ *  a depth renderbuffer.  Renderbuffers are used rather than
+ *  textures, so creating them does not disturb the scene
+ *  textures bound to every unit.  The objects are held by
+ *  handles, so they are tracked and deleted once the GPU has
+ *  finished with them.
+ ***********************************************************/
+class OffscreenTarget
+{
+public:
+	// create the buffers, charging their memory to the tag -
+	// false if the framebuffer is incomplete
+	bool Create(int width, int height, const std::string& label, MemoryTracker::MEMORY_TAG tag);
+	// release the buffers for deferred deletion
+	void Destroy();
+
+	GLuint GetFramebuffer() const { return m_framebuffer.GetName(); }
+	bool IsValid() const { return m_framebuffer.IsValid(); }
+
+private:
+	GLFramebufferHandle m_framebuffer;
+	GLRenderbufferHandle m_colorRenderbuffer;
+	GLRenderbufferHandle m_depthRenderbuffer;
+};
@@ -0,0 +1,514 @@
+///////////////////////////////////////////////////////////////////////////////
+// panoramacapture.cpp
+// ============
+// render the six cube faces around a point in one pass and turn them into
+// an equirectangular 360 degree panorama
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PanoramaCapture.h"
+#include "SoftwareScene.h"
+#include "SceneBuffers.h"
+#include "GLDebug.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_VertexShaderFile = "Shaders/sceneVertex.glsl";
+	const char* g_GeometryShaderFile = "Shaders/sceneCubeGeometry.glsl";
+	const char* g_FragmentShaderFile = "Shaders/sceneFragment.glsl";
+	const char* g_TextureArrayName = "objectTextures";
+
+	// same depth range as the interactive camera
+	const float g_NearPlane = 0.1f;
+	const float g_FarPlane = 100.0f;
+
+	// nanoseconds waited for a fence before the wait is retried
+	const GLuint64 g_FenceTimeout = 1000000000;
+
+	// look direction and up vector of every face, in the order
+	// of GL_TEXTURE_CUBE_MAP_POSITIVE_X onwards
+	const glm::vec3 g_FaceDirections[6] = {
+		glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+		glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+	const glm::vec3 g_FaceUp[6] = {
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+		glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) };
+
+	// read a whole shader file
+	bool g_ReadShaderFile(const char* filename, std::string& source)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		if (!file.is_open())
+		{
+			std::cout << "Could not open shader file:" << filename << std::endl;
+			return(false);
+		}
+		std::ostringstream stream;
+		stream << file.rdbuf();
+		source = stream.str();
+		return(true);
+	}
+
+	// compile one stage of the layered program
+	GLuint g_CompileShader(GLenum type, const char* filename)
+	{
+		std::string source;
+		if (!g_ReadShaderFile(filename, source))
+		{
+			return(0);
+		}
+
+		const char* pSource = source.c_str();
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &pSource, NULL);
+		glCompileShader(shader);
+
+		GLint bCompiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &bCompiled);
+		if (!bCompiled)
+		{
+			GLchar log[512];
+			glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+			std::cout << "WARNING: " << filename << " failed to compile - " << log << std::endl;
+			glDeleteShader(shader);
+			return(0);
+		}
+		return(shader);
+	}
+
+	// filter one channel of the four texels around a sample
+	inline float g_Bilinear(uint32_t t00, uint32_t t10, uint32_t t01, uint32_t t11, int shift, float fx, float fy)
+	{
+		float top = (float)((t00 >> shift) & 0xFF) * (1.0f - fx) + (float)((t10 >> shift) & 0xFF) * fx;
+		float bottom = (float)((t01 >> shift) & 0xFF) * (1.0f - fx) + (float)((t11 >> shift) & 0xFF) * fx;
+		return(top * (1.0f - fy) + bottom * fy);
+	}
+
+	// sample the cube faces in a direction - the face and its
+	// coordinates follow the cube map selection rules of the
+	// OpenGL specification, so they match how the faces were
+	// rendered
+	uint32_t g_SampleCube(const uint32_t* pFaces, int faceSize, const glm::vec3& direction)
+	{
+		glm::vec3 magnitude = glm::abs(direction);
+		int face = 0;
+		float sc = 0.0f;
+		float tc = 0.0f;
+		float ma = 1.0f;
+		if ((magnitude.x >= magnitude.y) && (magnitude.x >= magnitude.z))
+		{
+			face = (direction.x >= 0.0f) ? 0 : 1;
+			sc = (direction.x >= 0.0f) ? -direction.z : direction.z;
+			tc = -direction.y;
+			ma = magnitude.x;
+		}
+		else if (magnitude.y >= magnitude.z)
+		{
+			face = (direction.y >= 0.0f) ? 2 : 3;
+			sc = direction.x;
+			tc = (direction.y >= 0.0f) ? direction.z : -direction.z;
+			ma = magnitude.y;
+		}
+		else
+		{
+			face = (direction.z >= 0.0f) ? 4 : 5;
+			sc = (direction.z >= 0.0f) ? direction.x : -direction.x;
+			tc = -direction.y;
+			ma = magnitude.z;
+		}
+
+		// texel centers, clamped at the face edges
+		float x = (sc / ma + 1.0f) * 0.5f * faceSize - 0.5f;
+		float y = (tc / ma + 1.0f) * 0.5f * faceSize - 0.5f;
+		x = std::min(std::max(x, 0.0f), (float)(faceSize - 1));
+		y = std::min(std::max(y, 0.0f), (float)(faceSize - 1));
+		int x0 = (int)x;
+		int y0 = (int)y;
+		int x1 = std::min(x0 + 1, faceSize - 1);
+		int y1 = std::min(y0 + 1, faceSize - 1);
+		float fx = x - x0;
+		float fy = y - y0;
+
+		const uint32_t* pFace = pFaces + (size_t)face * faceSize * faceSize;
+		uint32_t t00 = pFace[(size_t)y0 * faceSize + x0];
+		uint32_t t10 = pFace[(size_t)y0 * faceSize + x1];
+		uint32_t t01 = pFace[(size_t)y1 * faceSize + x0];
+		uint32_t t11 = pFace[(size_t)y1 * faceSize + x1];
+
+		uint32_t pixel = 0xFF000000;
+		for (int shift = 0; shift < 24; shift += 8)
+		{
+			pixel |= (uint32_t)(g_Bilinear(t00, t10, t01, t11, shift, fx, fy) + 0.5f) << shift;
+		}
+		return(pixel);
+	}
+
+	// resample the faces into an equirectangular image, top row
+	// first - the middle of the image looks down -Z and the
+	// right side towards +X
+	void g_ConvertToEquirectangular(const uint32_t* pFaces, int faceSize, uint32_t* pPanorama, int width, int height)
+	{
+		const float pi = 3.14159265358979f;
+		for (int y = 0; y < height; y++)
+		{
+			float latitude = (0.5f - (y + 0.5f) / height) * pi;
+			float cosLatitude = std::cos(latitude);
+			float sinLatitude = std::sin(latitude);
+			uint32_t* pRow = pPanorama + (size_t)y * width;
+			for (int x = 0; x < width; x++)
+			{
+				float longitude = ((x + 0.5f) / width - 0.5f) * 2.0f * pi;
+				glm::vec3 direction(
+					std::sin(longitude) * cosLatitude,
+					sinLatitude,
+					-std::cos(longitude) * cosLatitude);
+				pRow[x] = g_SampleCube(pFaces, faceSize, direction);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  PanoramaCapture()
+ *
+ *  The constructor for the class.  Four faces go around the
+ *  equator, so a face is a quarter of the panorama wide.
+ ***********************************************************/
+PanoramaCapture::PanoramaCapture(int panoramaWidth)
+{
+	m_panoramaWidth = std::max(panoramaWidth / 2, 2) * 2;
+	m_panoramaHeight = m_panoramaWidth / 2;
+	m_faceSize = std::max(m_panoramaWidth / 4, 1);
+	m_readbackFence = NULL;
+}
+
+/***********************************************************
+ *  ~PanoramaCapture()
+ *
+ *  The destructor for the class.
+ ***********************************************************/
+PanoramaCapture::~PanoramaCapture()
+{
+	Shutdown();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the layered program and
+ *  the cube map the faces render into.
+ ***********************************************************/
+bool PanoramaCapture::Initialize()
+{
+	if (!CreateProgram() || !CreateCubeMap())
+	{
+		Shutdown();
+		return(false);
+	}
+
+	m_faceConstants = GLBufferHandle::Create("panorama faces");
+	glBindBuffer(GL_UNIFORM_BUFFER, m_faceConstants.GetName());
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(CUBE_FACE_CONSTANTS), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, m_faceConstants.GetName(), "panorama faces");
+
+	// all six faces are read back together
+	size_t readbackBytes = (size_t)m_faceSize * m_faceSize * 4 * 6;
+	m_readback = GLBufferHandle::Create("panorama readback");
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readback.GetName());
+	glBufferData(GL_PIXEL_PACK_BUFFER, readbackBytes, NULL, GL_STREAM_READ);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	GLResourceManager::SetMemory(
+		GLResourceManager::GLRES_BUFFER,
+		m_readback.GetName(),
+		MemoryTracker::MEMTAG_CAPTURE,
+		readbackBytes);
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, m_readback.GetName(), "panorama readback");
+	return(true);
+}
+
+/***********************************************************
+ *  CreateProgram()
+ *
+ *  This method is used for linking the scene vertex and
+ *  fragment shaders with the cube face geometry shader.  The
+ *  shader manager only builds vertex and fragment programs,
+ *  so this one is compiled here.
+ ***********************************************************/
+bool PanoramaCapture::CreateProgram()
+{
+	GLuint vertexShader = g_CompileShader(GL_VERTEX_SHADER, g_VertexShaderFile);
+	GLuint geometryShader = g_CompileShader(GL_GEOMETRY_SHADER, g_GeometryShaderFile);
+	GLuint fragmentShader = g_CompileShader(GL_FRAGMENT_SHADER, g_FragmentShaderFile);
+	bool bCompiled = (vertexShader != 0) && (geometryShader != 0) && (fragmentShader != 0);
+
+	GLint bLinked = GL_FALSE;
+	if (bCompiled)
+	{
+		m_program = GLProgramHandle::Create("panorama shader");
+		glAttachShader(m_program.GetName(), vertexShader);
+		glAttachShader(m_program.GetName(), geometryShader);
+		glAttachShader(m_program.GetName(), fragmentShader);
+		// so the driver reports the size of the linked binary
+		glProgramParameteri(m_program.GetName(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(m_program.GetName());
+		glGetProgramiv(m_program.GetName(), GL_LINK_STATUS, &bLinked);
+		if (!bLinked)
+		{
+			GLchar log[512];
+			glGetProgramInfoLog(m_program.GetName(), sizeof(log), NULL, log);
+			std::cout << "WARNING: the panorama shader failed to link - " << log << std::endl;
+			m_program.Reset();
+		}
+	}
+	glDeleteShader(vertexShader);
+	glDeleteShader(geometryShader);
+	glDeleteShader(fragmentShader);
+	if (!bLinked)
+	{
+		return(false);
+	}
+
+	GLResourceManager::SetProgramMemory(
+		m_program.GetName(),
+		MemoryTracker::MEMTAG_SHADERS,
+		{ g_VertexShaderFile, g_GeometryShaderFile, g_FragmentShaderFile });
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_PROGRAM, m_program.GetName(), "panorama shader");
+
+	// the scene textures stay bound to the same units, so the
+	// sampler array points at them like the scene program's
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glUseProgram(m_program.GetName());
+	GLint textureUnits[SCENE_TEXTURE_SLOTS];
+	for (int i = 0; i < SCENE_TEXTURE_SLOTS; i++)
+	{
+		textureUnits[i] = i;
+	}
+	glUniform1iv(glGetUniformLocation(m_program.GetName(), g_TextureArrayName), SCENE_TEXTURE_SLOTS, textureUnits);
+	glUseProgram(previousProgram);
+	return(true);
+}
+
+/***********************************************************
+ *  CreateCubeMap()
+ *
+ *  This method is used for creating the color and depth cube
+ *  maps and attaching every face of both at once, so the
+ *  geometry shader picks the face a triangle is drawn into.
+ *  They are bound to the cube map target only, which leaves
+ *  the scene textures on every unit alone.
+ ***********************************************************/
+bool PanoramaCapture::CreateCubeMap()
+{
+	m_colorCube = GLTextureHandle::Create("panorama color");
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_colorCube.GetName());
+	glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGBA8, m_faceSize, m_faceSize);
+	m_depthCube = GLTextureHandle::Create("panorama depth");
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_depthCube.GetName());
+	glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_DEPTH_COMPONENT24, m_faceSize, m_faceSize);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	// four bytes of color and four of depth a texel
+	size_t cubeBytes = (size_t)m_faceSize * m_faceSize * 4 * 6;
+	GLResourceManager::SetMemory(GLResourceManager::GLRES_TEXTURE, m_colorCube.GetName(), MemoryTracker::MEMTAG_CAPTURE, cubeBytes);
+	GLResourceManager::SetMemory(GLResourceManager::GLRES_TEXTURE, m_depthCube.GetName(), MemoryTracker::MEMTAG_CAPTURE, cubeBytes);
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_TEXTURE, m_colorCube.GetName(), "panorama color");
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_TEXTURE, m_depthCube.GetName(), "panorama depth");
+
+	m_framebuffer = GLFramebufferHandle::Create("panorama");
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer.GetName());
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_colorCube.GetName(), 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthCube.GetName(), 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "WARNING: the panorama framebuffer is incomplete (" << status << ")" << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Capture()
+ *
+ *  This method is used for rendering the six faces around
+ *  the point in one traversal of the scene and starting
+ *  their readback.  The scene is left in the layered view,
+ *  so the caller sets its camera again before rendering it
+ *  normally.
+ ***********************************************************/
+bool PanoramaCapture::Capture(SceneManager* pScene, const glm::vec3& center, const std::string& filename)
+{
+	if (!m_program.IsValid() || !m_framebuffer.IsValid())
+	{
+		return(false);
+	}
+
+	// only one capture is read back at a time
+	if (NULL != m_readbackFence)
+	{
+		ResolveReadback();
+	}
+
+	GL_DEBUG_PUSH_GROUP("panorama capture");
+
+	CUBE_FACE_CONSTANTS faces;
+	glm::mat4 faceProjection = glm::perspective(glm::radians(90.0f), 1.0f, g_NearPlane, g_FarPlane);
+	for (int i = 0; i < 6; i++)
+	{
+		faces.faceViewProjection[i] = faceProjection * glm::lookAt(center, center + g_FaceDirections[i], g_FaceUp[i]);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, m_faceConstants.GetName());
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(faces), &faces);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, PANORAMA_BINDING_CUBE_FACES, m_faceConstants.GetName());
+
+	GLint previousProgram = 0;
+	GLint previousFramebuffer = 0;
+	GLint previousViewport[4];
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+
+	// the clear covers every layer of the attachments
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer.GetName());
+	glViewport(0, 0, m_faceSize, m_faceSize);
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// six faces of 90 degrees around the center fill the cube
+	// reaching out to the far plane, so the union of their
+	// frustums is culled against as one box
+	glm::mat4 cullViewProjection =
+		glm::ortho(-g_FarPlane, g_FarPlane, -g_FarPlane, g_FarPlane, -g_FarPlane, g_FarPlane) *
+		glm::translate(glm::mat4(1.0f), -center);
+
+	glUseProgram(m_program.GetName());
+	pScene->SetLayeredView(cullViewProjection, center);
+	pScene->RenderScene();
+	glUseProgram(previousProgram);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+
+	// with a pack buffer bound the copies go into the buffer and
+	// return without waiting for the faces to finish rendering
+	size_t faceBytes = (size_t)m_faceSize * m_faceSize * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readback.GetName());
+	glBindTexture(GL_TEXTURE_CUBE_MAP, m_colorCube.GetName());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	for (int i = 0; i < 6; i++)
+	{
+		glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, GL_UNSIGNED_BYTE, (void*)(i * faceBytes));
+	}
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	m_readbackFilename = filename;
+
+	GL_DEBUG_POP_GROUP();
+	return(true);
+}
+
+/***********************************************************
+ *  ResolveReadback()
+ *
+ *  This method is used for copying the faces out of the
+ *  readback buffer once the GPU has written them, and
+ *  starting the worker that converts them.  The previous
+ *  conversion is finished first, so at most one runs.
+ ***********************************************************/
+void PanoramaCapture::ResolveReadback()
+{
+	GLenum result = glClientWaitSync(m_readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (result == GL_TIMEOUT_EXPIRED)
+	{
+		result = glClientWaitSync(m_readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout);
+	}
+	glDeleteSync(m_readbackFence);
+	m_readbackFence = NULL;
+
+	size_t faceTexels = (size_t)m_faceSize * m_faceSize;
+	PIXEL_BUFFER faces(faceTexels * 6);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readback.GetName());
+	const void* pMapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, faces.size() * 4, GL_MAP_READ_BIT);
+	if (NULL == pMapped)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		std::cout << "WARNING: could not map the panorama readback" << std::endl;
+		return;
+	}
+	memcpy(faces.data(), pMapped, faces.size() * 4);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (m_converter.joinable())
+	{
+		m_converter.join();
+	}
+
+	int faceSize = m_faceSize;
+	int width = m_panoramaWidth;
+	int height = m_panoramaHeight;
+	std::string filename;
+	filename.swap(m_readbackFilename);
+	m_converter = std::thread([faces = std::move(faces), faceSize, width, height, filename]()
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		PIXEL_BUFFER panorama((size_t)width * height);
+		g_ConvertToEquirectangular(faces.data(), faceSize, panorama.data(), width, height);
+		bool bWritten = WritePNGImage(filename.c_str(), panorama.data(), width, height, width);
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (bWritten)
+		{
+			std::cout << "INFO: panorama " << filename << " " << width << "x" << height
+				<< " from " << faceSize << "x" << faceSize << " faces, converted in " << milliseconds << "ms" << std::endl;
+		}
+		else
+		{
+			std::cout << "WARNING: could not write the panorama " << filename << std::endl;
+		}
+	});
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for writing the outstanding capture
+ *  and releasing the OpenGL objects.
+ ***********************************************************/
+void PanoramaCapture::Shutdown()
+{
+	if (NULL != m_readbackFence)
+	{
+		ResolveReadback();
+	}
+	if (m_converter.joinable())
+	{
+		m_converter.join();
+	}
+
+	m_framebuffer.Reset();
+	m_program.Reset();
+	m_colorCube.Reset();
+	m_depthCube.Reset();
+	m_faceConstants.Reset();
+	m_readback.Reset();
+}
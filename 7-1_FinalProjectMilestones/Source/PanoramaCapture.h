@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+// panoramacapture.h
+// ============
+// render the six cube faces around a point in one pass and turn them into
+// an equirectangular 360 degree panorama
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "GLResources.h"
+#include "MemoryTracker.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+// uniform block binding point of the face cameras - the scene
+// shaders use bindings 0 to 2
+const GLuint PANORAMA_BINDING_CUBE_FACES = 3;
+
+/***********************************************************
+ *  CUBE_FACE_CONSTANTS
+ *
+ *  Camera of every cube face, in the OpenGL face order.  The
+ *  layout matches the std140 CubeFaceBlock in
+ *  Shaders/sceneCubeGeometry.glsl.
+ ***********************************************************/
+struct CUBE_FACE_CONSTANTS
+{
+	glm::mat4 faceViewProjection[6];
+};
+
+/***********************************************************
+ *  PanoramaCapture
+ *
+ *  This class captures the scene in every direction from a
+ *  point.  Rather than rendering the scene six times, the
+ *  objects are culled once against a box holding all six
+ *  face frustums and drawn once, and a geometry shader with
+ *  six invocations sends each triangle to the layers of the
+ *  cube map it falls in.  The faces are copied into a pixel
+ *  pack buffer without waiting, and a worker thread turns
+ *  them into the equirectangular image and writes it, while
+ *  the render thread moves on to the next capture.
+ ***********************************************************/
+class PanoramaCapture
+{
+public:
+	// constructor - the panorama is twice as wide as it is high
+	PanoramaCapture(int panoramaWidth);
+	// destructor - finishes a capture still outstanding
+	~PanoramaCapture();
+
+	// compile the layered scene program and create the cube map
+	// - the OpenGL context has to exist
+	bool Initialize();
+	// render the scene around the point and write the panorama
+	// into the PNG file once the GPU and the worker are done
+	bool Capture(SceneManager* pScene, const glm::vec3& center, const std::string& filename);
+	// wait for the outstanding capture to be written, and free
+	// the OpenGL objects - call before the context goes away
+	void Shutdown();
+
+	int GetFaceSize() const { return m_faceSize; }
+
+private:
+	typedef std::vector<uint32_t, TrackedAllocator<uint32_t, MemoryTracker::MEMTAG_CAPTURE>> PIXEL_BUFFER;
+
+	int m_panoramaWidth;
+	int m_panoramaHeight;
+	int m_faceSize;
+
+	GLProgramHandle m_program;
+	GLTextureHandle m_colorCube;
+	GLTextureHandle m_depthCube;
+	GLBufferHandle m_faceConstants;
+	GLFramebufferHandle m_framebuffer;
+
+	// faces copied out of the cube map and not yet converted
+	GLBufferHandle m_readback;
+	GLsync m_readbackFence;
+	std::string m_readbackFilename;
+
+	// converts and writes the previous capture
+	std::thread m_converter;
+
+	// compile the scene shaders with the cube face geometry shader
+	bool CreateProgram();
+	bool CreateCubeMap();
+	// hand the faces read back to the worker, once the GPU has
+	// copied them
+	void ResolveReadback();
+};
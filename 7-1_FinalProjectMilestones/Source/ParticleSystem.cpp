@@ -0,0 +1,572 @@
+///////////////////////////////////////////////////////////////////////////////
+// particlesystem.cpp
+// ============
+// simulate particles on the CPU with SIMD kernels and draw them instanced
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ParticleSystem.h"
+#include "JobSystem.h"
+#include "GLCapture.h"
+#include "GLDebug.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// pick the widest instruction set the build targets
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PARTICLE_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define PARTICLE_SIMD_SSE
+#endif
+
+// declaration of global variables
+namespace
+{
+	// particles handled by one SIMD step - the arrays are padded
+	// to a multiple of this
+#if defined(PARTICLE_SIMD_AVX)
+	const uint32_t g_SimdWidth = 8;
+#else
+	const uint32_t g_SimdWidth = 4;
+#endif
+
+	// floats written into the stream buffer per particle
+	const size_t g_FloatsPerParticle = 4;
+	// emitters written into the stream buffer by each job
+	const size_t g_StreamBatchSize = 1;
+
+	// round a count up to a multiple of the SIMD width
+	uint32_t PadToSimdWidth(uint32_t count)
+	{
+		return((count + g_SimdWidth - 1) / g_SimdWidth * g_SimdWidth);
+	}
+}
+
+/***********************************************************
+ *  ParticleEmitter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ParticleEmitter::ParticleEmitter(const EMITTER_DESC& desc, uint32_t randomSeed)
+{
+	m_desc = desc;
+	m_count = 0;
+	m_capacity = PadToSimdWidth(std::max(desc.maxParticles, 1u));
+	m_spawnAccumulator = 0.0f;
+	// xorshift state must never be zero
+	m_randomState = (randomSeed != 0) ? randomSeed : 0x9E3779B9;
+
+	m_positionX.resize(m_capacity, 0.0f);
+	m_positionY.resize(m_capacity, 0.0f);
+	m_positionZ.resize(m_capacity, 0.0f);
+	m_velocityX.resize(m_capacity, 0.0f);
+	m_velocityY.resize(m_capacity, 0.0f);
+	m_velocityZ.resize(m_capacity, 0.0f);
+	m_age.resize(m_capacity, 0.0f);
+	m_inverseLifetime.resize(m_capacity, 1.0f);
+}
+
+/***********************************************************
+ *  RandomRange()
+ *
+ *  This method is used for getting a random value between
+ *  the passed in limits from the emitter's xorshift state.
+ ***********************************************************/
+float ParticleEmitter::RandomRange(float minimum, float maximum)
+{
+	m_randomState ^= m_randomState << 13;
+	m_randomState ^= m_randomState >> 17;
+	m_randomState ^= m_randomState << 5;
+
+	float unit = (float)(m_randomState >> 8) * (1.0f / 16777216.0f);
+	return(minimum + (maximum - minimum) * unit);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for advancing the emitter by the
+ *  passed in number of seconds.
+ ***********************************************************/
+void ParticleEmitter::Update(float deltaTime)
+{
+	Integrate(deltaTime);
+	Compact();
+	Spawn(deltaTime);
+}
+
+/***********************************************************
+ *  Spawn()
+ *
+ *  This method is used for adding the particles due this
+ *  frame at the end of the arrays.
+ ***********************************************************/
+void ParticleEmitter::Spawn(float deltaTime)
+{
+	m_spawnAccumulator += m_desc.spawnRate * deltaTime;
+	uint32_t spawnCount = (uint32_t)m_spawnAccumulator;
+	m_spawnAccumulator -= (float)spawnCount;
+
+	spawnCount = std::min(spawnCount, m_desc.maxParticles - std::min(m_count, m_desc.maxParticles));
+
+	const glm::vec3& center = m_desc.position;
+	const glm::vec3& extents = m_desc.spawnExtents;
+	for (uint32_t n = 0; n < spawnCount; n++)
+	{
+		uint32_t i = m_count++;
+		m_positionX[i] = center.x + RandomRange(-extents.x, extents.x);
+		m_positionY[i] = center.y + RandomRange(-extents.y, extents.y);
+		m_positionZ[i] = center.z + RandomRange(-extents.z, extents.z);
+		m_velocityX[i] = RandomRange(m_desc.velocityMin.x, m_desc.velocityMax.x);
+		m_velocityY[i] = RandomRange(m_desc.velocityMin.y, m_desc.velocityMax.y);
+		m_velocityZ[i] = RandomRange(m_desc.velocityMin.z, m_desc.velocityMax.z);
+		m_age[i] = 0.0f;
+		m_inverseLifetime[i] = 1.0f / std::max(RandomRange(m_desc.lifetimeMin, m_desc.lifetimeMax), 0.001f);
+	}
+}
+
+/***********************************************************
+ *  Integrate()
+ *
+ *  This method is the update kernel.  Velocities gain the
+ *  acceleration and lose the drag, positions move by the
+ *  velocity and ages advance, SIMD width particles at a
+ *  time.  The lanes past the live count are padding, so they
+ *  are updated too but never reported as dead.
+ ***********************************************************/
+void ParticleEmitter::Integrate(float deltaTime)
+{
+	m_deadParticles.clear();
+	if (m_count == 0)
+	{
+		return;
+	}
+
+	float damping = std::max(1.0f - m_desc.drag * deltaTime, 0.0f);
+	glm::vec3 velocityStep = m_desc.acceleration * deltaTime;
+	uint32_t paddedCount = PadToSimdWidth(m_count);
+
+#if defined(PARTICLE_SIMD_AVX)
+	const __m256 dt = _mm256_set1_ps(deltaTime);
+	const __m256 drag = _mm256_set1_ps(damping);
+	const __m256 stepX = _mm256_set1_ps(velocityStep.x);
+	const __m256 stepY = _mm256_set1_ps(velocityStep.y);
+	const __m256 stepZ = _mm256_set1_ps(velocityStep.z);
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	for (uint32_t i = 0; i < paddedCount; i += 8)
+	{
+		__m256 velocityX = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&m_velocityX[i]), stepX), drag);
+		__m256 velocityY = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&m_velocityY[i]), stepY), drag);
+		__m256 velocityZ = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(&m_velocityZ[i]), stepZ), drag);
+		_mm256_storeu_ps(&m_velocityX[i], velocityX);
+		_mm256_storeu_ps(&m_velocityY[i], velocityY);
+		_mm256_storeu_ps(&m_velocityZ[i], velocityZ);
+
+		_mm256_storeu_ps(&m_positionX[i], _mm256_add_ps(_mm256_loadu_ps(&m_positionX[i]), _mm256_mul_ps(velocityX, dt)));
+		_mm256_storeu_ps(&m_positionY[i], _mm256_add_ps(_mm256_loadu_ps(&m_positionY[i]), _mm256_mul_ps(velocityY, dt)));
+		_mm256_storeu_ps(&m_positionZ[i], _mm256_add_ps(_mm256_loadu_ps(&m_positionZ[i]), _mm256_mul_ps(velocityZ, dt)));
+
+		__m256 age = _mm256_add_ps(_mm256_loadu_ps(&m_age[i]), dt);
+		_mm256_storeu_ps(&m_age[i], age);
+
+		int deadMask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_mul_ps(age, _mm256_loadu_ps(&m_inverseLifetime[i])), one, _CMP_GE_OQ));
+		while (deadMask != 0)
+		{
+			uint32_t lane = 0;
+			while ((deadMask & (1 << lane)) == 0)
+			{
+				lane++;
+			}
+			deadMask &= ~(1 << lane);
+			if (i + lane < m_count)
+			{
+				m_deadParticles.push_back(i + lane);
+			}
+		}
+	}
+#elif defined(PARTICLE_SIMD_SSE)
+	const __m128 dt = _mm_set1_ps(deltaTime);
+	const __m128 drag = _mm_set1_ps(damping);
+	const __m128 stepX = _mm_set1_ps(velocityStep.x);
+	const __m128 stepY = _mm_set1_ps(velocityStep.y);
+	const __m128 stepZ = _mm_set1_ps(velocityStep.z);
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (uint32_t i = 0; i < paddedCount; i += 4)
+	{
+		__m128 velocityX = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocityX[i]), stepX), drag);
+		__m128 velocityY = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocityY[i]), stepY), drag);
+		__m128 velocityZ = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocityZ[i]), stepZ), drag);
+		_mm_storeu_ps(&m_velocityX[i], velocityX);
+		_mm_storeu_ps(&m_velocityY[i], velocityY);
+		_mm_storeu_ps(&m_velocityZ[i], velocityZ);
+
+		_mm_storeu_ps(&m_positionX[i], _mm_add_ps(_mm_loadu_ps(&m_positionX[i]), _mm_mul_ps(velocityX, dt)));
+		_mm_storeu_ps(&m_positionY[i], _mm_add_ps(_mm_loadu_ps(&m_positionY[i]), _mm_mul_ps(velocityY, dt)));
+		_mm_storeu_ps(&m_positionZ[i], _mm_add_ps(_mm_loadu_ps(&m_positionZ[i]), _mm_mul_ps(velocityZ, dt)));
+
+		__m128 age = _mm_add_ps(_mm_loadu_ps(&m_age[i]), dt);
+		_mm_storeu_ps(&m_age[i], age);
+
+		int deadMask = _mm_movemask_ps(_mm_cmpge_ps(_mm_mul_ps(age, _mm_loadu_ps(&m_inverseLifetime[i])), one));
+		for (uint32_t lane = 0; (deadMask != 0) && (lane < 4); lane++)
+		{
+			if ((deadMask & (1 << lane)) && (i + lane < m_count))
+			{
+				m_deadParticles.push_back(i + lane);
+			}
+		}
+	}
+#else
+	for (uint32_t i = 0; i < paddedCount; i++)
+	{
+		m_velocityX[i] = (m_velocityX[i] + velocityStep.x) * damping;
+		m_velocityY[i] = (m_velocityY[i] + velocityStep.y) * damping;
+		m_velocityZ[i] = (m_velocityZ[i] + velocityStep.z) * damping;
+		m_positionX[i] += m_velocityX[i] * deltaTime;
+		m_positionY[i] += m_velocityY[i] * deltaTime;
+		m_positionZ[i] += m_velocityZ[i] * deltaTime;
+		m_age[i] += deltaTime;
+
+		if ((i < m_count) && (m_age[i] * m_inverseLifetime[i] >= 1.0f))
+		{
+			m_deadParticles.push_back(i);
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  Compact()
+ *
+ *  This method is used for removing the dead particles.
+ *  They are handled from the highest index down, so the
+ *  last particle moved into each slot is always alive.
+ ***********************************************************/
+void ParticleEmitter::Compact()
+{
+	for (size_t n = m_deadParticles.size(); n > 0; n--)
+	{
+		uint32_t i = m_deadParticles[n - 1];
+		uint32_t last = --m_count;
+		if (i != last)
+		{
+			m_positionX[i] = m_positionX[last];
+			m_positionY[i] = m_positionY[last];
+			m_positionZ[i] = m_positionZ[last];
+			m_velocityX[i] = m_velocityX[last];
+			m_velocityY[i] = m_velocityY[last];
+			m_velocityZ[i] = m_velocityZ[last];
+			m_age[i] = m_age[last];
+			m_inverseLifetime[i] = m_inverseLifetime[last];
+		}
+	}
+	m_deadParticles.clear();
+}
+
+/***********************************************************
+ *  WriteVertices()
+ *
+ *  This method is used for writing the stream buffer data
+ *  of every particle - the position and the fraction of its
+ *  life used, which the shader turns into size and color.
+ *  Four particles at a time are transposed from the
+ *  component arrays into vertices.
+ ***********************************************************/
+void ParticleEmitter::WriteVertices(float* pDestination) const
+{
+	uint32_t i = 0;
+
+#if defined(PARTICLE_SIMD_AVX) || defined(PARTICLE_SIMD_SSE)
+	for (; i + 4 <= m_count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&m_positionX[i]);
+		__m128 y = _mm_loadu_ps(&m_positionY[i]);
+		__m128 z = _mm_loadu_ps(&m_positionZ[i]);
+		__m128 life = _mm_mul_ps(_mm_loadu_ps(&m_age[i]), _mm_loadu_ps(&m_inverseLifetime[i]));
+		_MM_TRANSPOSE4_PS(x, y, z, life);
+		_mm_storeu_ps(pDestination + (i + 0) * g_FloatsPerParticle, x);
+		_mm_storeu_ps(pDestination + (i + 1) * g_FloatsPerParticle, y);
+		_mm_storeu_ps(pDestination + (i + 2) * g_FloatsPerParticle, z);
+		_mm_storeu_ps(pDestination + (i + 3) * g_FloatsPerParticle, life);
+	}
+#endif
+
+	for (; i < m_count; i++)
+	{
+		float* pVertex = pDestination + i * g_FloatsPerParticle;
+		pVertex[0] = m_positionX[i];
+		pVertex[1] = m_positionY[i];
+		pVertex[2] = m_positionZ[i];
+		pVertex[3] = m_age[i] * m_inverseLifetime[i];
+	}
+}
+
+/***********************************************************
+ *  ParticleSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ParticleSystem::ParticleSystem()
+{
+	m_nextEmitterID = 0;
+	m_pShaderManager = NULL;
+	m_streamCapacity = 0;
+}
+
+/***********************************************************
+ *  ~ParticleSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ParticleSystem::~ParticleSystem()
+{
+	for (ParticleEmitter* pEmitter : m_emitters)
+	{
+		delete pEmitter;
+	}
+	m_emitters.clear();
+	m_emitterIDs.clear();
+
+	if (NULL != m_pShaderManager)
+	{
+		delete m_pShaderManager;
+		m_pShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the particle shaders and
+ *  creating the vertex array that reads one particle per
+ *  instance from the stream buffer.  The previously used
+ *  program is restored afterwards.
+ ***********************************************************/
+bool ParticleSystem::Initialize(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+	m_pShaderManager = new ShaderManager();
+	m_pShaderManager->LoadShaders(vertexShaderFile, fragmentShaderFile);
+	m_pShaderManager->use();
+
+	GLint programID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	if ((programID == 0) || (programID == previousProgram))
+	{
+		std::cout << "Could not load the particle shaders:" << vertexShaderFile << std::endl;
+		glUseProgram(previousProgram);
+		return(false);
+	}
+	m_program = GLProgramHandle::Adopt(programID, "particle shader");
+	GLResourceManager::SetProgramMemory(programID, MemoryTracker::MEMTAG_SHADERS, { vertexShaderFile, fragmentShaderFile });
+
+	m_vertexArray = GLVertexArrayHandle::Create("particle vertex array");
+	m_streamBuffer = GLBufferHandle::Create("particle stream");
+	glBindVertexArray(m_vertexArray.GetName());
+	glBindBuffer(GL_ARRAY_BUFFER, m_streamBuffer.GetName());
+	glEnableVertexAttribArray(0);
+	glVertexAttribDivisor(0, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_PROGRAM, m_program.GetName(), "particle shader");
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_VERTEX_ARRAY, m_vertexArray.GetName(), "particle vertex array");
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, m_streamBuffer.GetName(), "particle stream");
+
+	glUseProgram(previousProgram);
+	return(true);
+}
+
+/***********************************************************
+ *  AddEmitter()
+ *
+ *  This method is used for adding a new emitter.
+ ***********************************************************/
+EmitterID ParticleSystem::AddEmitter(const EMITTER_DESC& desc)
+{
+	EmitterID emitter = m_nextEmitterID++;
+	m_emitters.push_back(new ParticleEmitter(desc, emitter * 0x2545F491 + 1));
+	m_emitterIDs.push_back(emitter);
+	return(emitter);
+}
+
+/***********************************************************
+ *  RemoveEmitter()
+ *
+ *  This method is used for removing an emitter and all of
+ *  its particles.
+ ***********************************************************/
+bool ParticleSystem::RemoveEmitter(EmitterID emitter)
+{
+	for (size_t i = 0; i < m_emitterIDs.size(); i++)
+	{
+		if (m_emitterIDs[i] == emitter)
+		{
+			delete m_emitters[i];
+			m_emitters.erase(m_emitters.begin() + i);
+			m_emitterIDs.erase(m_emitterIDs.begin() + i);
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for updating every emitter.  Each
+ *  emitter only touches its own particles, so each one is
+ *  a separate job.
+ ***********************************************************/
+void ParticleSystem::Update(float deltaTime)
+{
+	JobSystem::ParallelFor(m_emitters.size(), 1,
+		[this, deltaTime](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				m_emitters[i]->Update(deltaTime);
+			}
+		});
+}
+
+/***********************************************************
+ *  GetParticleCount()
+ *
+ *  This method is used for getting the number of live
+ *  particles across every emitter.
+ ***********************************************************/
+uint32_t ParticleSystem::GetParticleCount() const
+{
+	uint32_t count = 0;
+	for (const ParticleEmitter* pEmitter : m_emitters)
+	{
+		count += pEmitter->GetCount();
+	}
+	return(count);
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for drawing every emitter.  The
+ *  stream buffer is orphaned and mapped, the emitters write
+ *  their particles into it in parallel, and then each
+ *  emitter is one instanced draw of a four vertex strip.
+ *  Particles are blended without writing depth, and the
+ *  blend and depth write state of the scene is restored
+ *  afterwards.
+ ***********************************************************/
+void ParticleSystem::Render(const glm::mat4& view, const glm::mat4& projection)
+{
+	if ((NULL == m_pShaderManager) || !m_program.IsValid())
+	{
+		return;
+	}
+
+	// byte offset of each emitter in the stream buffer
+	std::vector<size_t> offsets(m_emitters.size() + 1, 0);
+	for (size_t i = 0; i < m_emitters.size(); i++)
+	{
+		offsets[i + 1] = offsets[i] + m_emitters[i]->GetCount() * g_FloatsPerParticle * sizeof(float);
+	}
+	size_t totalBytes = offsets[m_emitters.size()];
+	if (totalBytes == 0)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_streamBuffer.GetName());
+	if (totalBytes > m_streamCapacity)
+	{
+		m_streamCapacity = std::max(totalBytes, m_streamCapacity * 2);
+		GLResourceManager::SetMemory(
+			GLResourceManager::GLRES_BUFFER,
+			m_streamBuffer.GetName(),
+			MemoryTracker::MEMTAG_PARTICLES,
+			m_streamCapacity);
+	}
+
+	// orphan last frame's storage so the driver never waits for
+	// the GPU to finish reading it
+	glBufferData(GL_ARRAY_BUFFER, m_streamCapacity, NULL, GL_STREAM_DRAW);
+	float* pStream = (float*)glMapBufferRange(
+		GL_ARRAY_BUFFER, 0, totalBytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (NULL == pStream)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return;
+	}
+
+	JobSystem::ParallelFor(m_emitters.size(), g_StreamBatchSize,
+		[this, pStream, &offsets](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				m_emitters[i]->WriteVertices(pStream + offsets[i] / sizeof(float));
+			}
+		});
+
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	m_pShaderManager->use();
+	m_pShaderManager->setMat4Value("view", view);
+	m_pShaderManager->setMat4Value("projection", projection);
+
+	GLboolean bPreviousBlend = glIsEnabled(GL_BLEND);
+	GLint previousBlendSource = GL_ONE;
+	GLint previousBlendDestination = GL_ZERO;
+	GLboolean bPreviousDepthMask = GL_TRUE;
+	glGetIntegerv(GL_BLEND_SRC_RGB, &previousBlendSource);
+	glGetIntegerv(GL_BLEND_DST_RGB, &previousBlendDestination);
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &bPreviousDepthMask);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+	GLCapture::Record(GLCAPTURE_ENABLE, { GL_BLEND });
+	GLCapture::Record(GLCAPTURE_BLEND_FUNC, { GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA });
+	GLCapture::Record(GLCAPTURE_DEPTH_MASK, { GL_FALSE });
+	glBindVertexArray(m_vertexArray.GetName());
+
+	for (size_t i = 0; i < m_emitters.size(); i++)
+	{
+		const ParticleEmitter* pEmitter = m_emitters[i];
+		if (pEmitter->GetCount() == 0)
+		{
+			continue;
+		}
+
+		const EMITTER_DESC& desc = pEmitter->GetDesc();
+		m_pShaderManager->setVec2Value("particleSize", glm::vec2(desc.sizeStart, desc.sizeEnd));
+		m_pShaderManager->setVec4Value("colorStart", desc.colorStart);
+		m_pShaderManager->setVec4Value("colorEnd", desc.colorEnd);
+
+		// point the per-instance attribute at this emitter's particles
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const void*)offsets[i]);
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, pEmitter->GetCount());
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDepthMask(bPreviousDepthMask);
+	glBlendFunc((GLenum)previousBlendSource, (GLenum)previousBlendDestination);
+	GLCapture::Record(GLCAPTURE_DEPTH_MASK, { bPreviousDepthMask });
+	GLCapture::Record(GLCAPTURE_BLEND_FUNC, { (uint64_t)previousBlendSource, (uint64_t)previousBlendDestination });
+	if (bPreviousBlend == GL_FALSE)
+	{
+		glDisable(GL_BLEND);
+		GLCapture::Record(GLCAPTURE_DISABLE, { GL_BLEND });
+	}
+	glUseProgram(previousProgram);
+}
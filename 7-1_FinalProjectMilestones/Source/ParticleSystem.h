@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// particlesystem.h
+// ============
+// simulate particles on the CPU with SIMD kernels and draw them instanced
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLResources.h"
+#include "MemoryTracker.h"
+#include "ShaderManager.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// identifies one emitter for as long as it exists
+typedef uint32_t EmitterID;
+const EmitterID INVALID_EMITTER = 0xFFFFFFFF;
+
+// particle component arrays are charged to the particles memory tag
+typedef std::vector<float, TrackedAllocator<float, MemoryTracker::MEMTAG_PARTICLES>> ParticleVector;
+
+/***********************************************************
+ *  EMITTER_DESC
+ *
+ *  Settings of one particle emitter.  New particles start
+ *  at a random point in the spawn box with a random velocity
+ *  between the minimum and maximum.
+ ***********************************************************/
+struct EMITTER_DESC
+{
+	// center and half size of the spawn box
+	glm::vec3 position;
+	glm::vec3 spawnExtents;
+	// range of the starting velocity
+	glm::vec3 velocityMin;
+	glm::vec3 velocityMax;
+	// constant acceleration - gravity, buoyancy and steady wind
+	glm::vec3 acceleration;
+	// fraction of the velocity lost per second
+	float drag;
+	// particles spawned per second
+	float spawnRate;
+	// range of the particle lifetime in seconds
+	float lifetimeMin;
+	float lifetimeMax;
+	// billboard half size at birth and at death
+	float sizeStart;
+	float sizeEnd;
+	// color at birth and at death - alpha fades with it
+	glm::vec4 colorStart;
+	glm::vec4 colorEnd;
+	// most particles alive at once
+	uint32_t maxParticles;
+};
+
+/***********************************************************
+ *  ParticleEmitter
+ *
+ *  This class keeps the particles of one emitter as
+ *  structure-of-arrays components.  The arrays are padded
+ *  to the SIMD width so the update kernels never need a
+ *  scalar tail; dead particles are removed by moving the
+ *  last particle into their slot.
+ ***********************************************************/
+class ParticleEmitter
+{
+public:
+	// constructor
+	ParticleEmitter(const EMITTER_DESC& desc, uint32_t randomSeed);
+
+	// spawn, integrate and expire particles
+	void Update(float deltaTime);
+	// write one xyz position plus life fraction per particle
+	void WriteVertices(float* pDestination) const;
+
+	uint32_t GetCount() const { return m_count; }
+	const EMITTER_DESC& GetDesc() const { return m_desc; }
+
+private:
+	EMITTER_DESC m_desc;
+	uint32_t m_count;
+	uint32_t m_capacity;
+	float m_spawnAccumulator;
+	uint32_t m_randomState;
+
+	ParticleVector m_positionX, m_positionY, m_positionZ;
+	ParticleVector m_velocityX, m_velocityY, m_velocityZ;
+	ParticleVector m_age;
+	ParticleVector m_inverseLifetime;
+	// particles found dead by the last integration, ascending
+	std::vector<uint32_t> m_deadParticles;
+
+	// random value between the passed in limits
+	float RandomRange(float minimum, float maximum);
+	// add the particles due this frame
+	void Spawn(float deltaTime);
+	// SIMD kernel - apply forces, move and age every particle,
+	// collecting the ones that outlived their lifetime
+	void Integrate(float deltaTime);
+	// remove the dead particles
+	void Compact();
+};
+
+/***********************************************************
+ *  ParticleSystem
+ *
+ *  This class owns the emitters, updates them in parallel
+ *  on the job system and draws each one with a single
+ *  instanced draw call.  The particle data of every emitter
+ *  is streamed each frame into one orphaned vertex buffer.
+ ***********************************************************/
+class ParticleSystem
+{
+public:
+	// constructor
+	ParticleSystem();
+	// destructor
+	~ParticleSystem();
+
+	// load the particle shaders and create the stream buffer
+	bool Initialize(const char* vertexShaderFile, const char* fragmentShaderFile);
+
+	// add and remove emitters
+	EmitterID AddEmitter(const EMITTER_DESC& desc);
+	bool RemoveEmitter(EmitterID emitter);
+
+	// update every emitter - one job per emitter
+	void Update(float deltaTime);
+	// stream the particles and draw every emitter
+	void Render(const glm::mat4& view, const glm::mat4& projection);
+
+	// total number of live particles
+	uint32_t GetParticleCount() const;
+
+private:
+	std::vector<ParticleEmitter*> m_emitters;
+	std::vector<EmitterID> m_emitterIDs;
+	EmitterID m_nextEmitterID;
+
+	ShaderManager* m_pShaderManager;
+	GLProgramHandle m_program;
+	GLVertexArrayHandle m_vertexArray;
+	GLBufferHandle m_streamBuffer;
+	// bytes the stream buffer has room for
+	size_t m_streamCapacity;
+};
@@ -0,0 +1,446 @@
+///////////////////////////////////////////////////////////////////////////////
+// pathtracer.cpp
+// ============
+// progressive multithreaded CPU path tracer used to render
+// reference images of the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PathTracer.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	const float g_TwoPi = 6.28318530718f;
+
+	// width and height of a tile in pixels
+	const int g_TileSize = 16;
+	// rays that hit nothing closer than this reach the sky
+	const float g_MaxRayDistance = 1.0e6f;
+	// distance new rays start off a surface, so they do not hit it again
+	const float g_RayOffset = 1.0e-3f;
+	// bounces always traced before paths may be ended at random
+	const int g_RouletteBounces = 2;
+
+	// scramble the pixel and sample index into a random seed
+	uint32_t HashSeed(uint32_t x, uint32_t y, uint32_t sample)
+	{
+		uint32_t hash = (x * 0x9E3779B1u) ^ (y * 0x85EBCA77u) ^ (sample * 0xC2B2AE3Du);
+		hash ^= hash >> 16;
+		hash *= 0x7FEB352Du;
+		hash ^= hash >> 15;
+		hash *= 0x846CA68Bu;
+		hash ^= hash >> 16;
+		return((hash == 0) ? 1 : hash);
+	}
+
+	// xorshift random number in [0, 1)
+	float NextRandom(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return((state >> 8) * (1.0f / 16777216.0f));
+	}
+
+	// random direction around the normal, more likely near it -
+	// the distribution cancels the cosine of a diffuse bounce
+	glm::vec3 SampleCosineHemisphere(glm::vec3 normal, uint32_t& randomState)
+	{
+		float radius = std::sqrt(NextRandom(randomState));
+		float angle = g_TwoPi * NextRandom(randomState);
+		float x = radius * std::cos(angle);
+		float y = radius * std::sin(angle);
+		float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+
+		// two axes perpendicular to the normal
+		float sign = (normal.z >= 0.0f) ? 1.0f : -1.0f;
+		float a = -1.0f / (sign + normal.z);
+		float b = normal.x * normal.y * a;
+		glm::vec3 tangent = glm::vec3(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+		glm::vec3 bitangent = glm::vec3(b, sign + normal.y * normal.y * a, -normal.y);
+
+		return(glm::normalize(tangent * x + bitangent * y + normal * z));
+	}
+
+	double GetElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+}
+
+/***********************************************************
+ *  PathTracer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+PathTracer::PathTracer(int width, int height)
+{
+	m_width = 0;
+	m_height = 0;
+	m_tilesX = 0;
+	m_tilesY = 0;
+	m_settings.samplesPerPass = 1;
+	m_settings.maxBounces = 4;
+	m_settings.skyColor = glm::vec3(0.2f, 0.22f, 0.25f);
+	m_scene = {};
+	m_view = glm::mat4(1.0f);
+	m_projection = glm::mat4(1.0f);
+	m_inverseViewProjection = glm::mat4(1.0f);
+	m_sampleCount = 0;
+	m_bColorCurrent = false;
+	m_stats = {};
+	Resize(width, height);
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for resizing the accumulation buffer
+ *  and the tile grid.
+ ***********************************************************/
+void PathTracer::Resize(int width, int height)
+{
+	m_width = std::max(width, 1);
+	m_height = std::max(height, 1);
+	m_tilesX = (m_width + g_TileSize - 1) / g_TileSize;
+	m_tilesY = (m_height + g_TileSize - 1) / g_TileSize;
+	m_accumulation.assign((size_t)m_width * m_height * 3, 0.0f);
+	m_color.assign((size_t)m_width * m_height, 0);
+	Reset();
+}
+
+/***********************************************************
+ *  SetSettings()
+ *
+ *  This method is used for changing how the passes are
+ *  traced.  The samples traced with the old settings are
+ *  thrown away.
+ ***********************************************************/
+void PathTracer::SetSettings(const PATH_TRACE_SETTINGS& settings)
+{
+	m_settings = settings;
+	m_settings.samplesPerPass = std::max(m_settings.samplesPerPass, 1);
+	m_settings.maxBounces = std::max(m_settings.maxBounces, 0);
+	Reset();
+}
+
+/***********************************************************
+ *  SetScene()
+ *
+ *  This method is used for taking a new version of the
+ *  scene.  The tree is rebuilt and the accumulated samples
+ *  are thrown away.
+ ***********************************************************/
+void PathTracer::SetScene(const SOFTWARE_SCENE& scene)
+{
+	m_scene = scene;
+	m_bvh.Build(m_scene);
+	m_stats.triangleCount = (uint32_t)m_bvh.GetTriangleCount();
+	m_stats.nodeCount = (uint32_t)m_bvh.GetNodeCount();
+	m_stats.buildMilliseconds = m_bvh.GetBuildMilliseconds();
+	Reset();
+}
+
+/***********************************************************
+ *  SetCamera()
+ *
+ *  This method is used for moving the camera.  The samples
+ *  are only thrown away when the camera actually changed,
+ *  so calling it every frame keeps refining a still image.
+ ***********************************************************/
+void PathTracer::SetCamera(const glm::mat4& view, const glm::mat4& projection)
+{
+	if ((view == m_view) && (projection == m_projection))
+	{
+		return;
+	}
+
+	m_view = view;
+	m_projection = projection;
+	m_inverseViewProjection = glm::inverse(projection * view);
+	Reset();
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for starting the image over.
+ ***********************************************************/
+void PathTracer::Reset()
+{
+	std::fill(m_accumulation.begin(), m_accumulation.end(), 0.0f);
+	m_sampleCount = 0;
+	m_bColorCurrent = false;
+	m_stats.samplesPerPixel = 0;
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for tracing one pass over the whole
+ *  image.  The tiles are handed out to the job system one
+ *  at a time, so threads that finish cheap tiles of sky
+ *  pick up more of the busy ones.
+ ***********************************************************/
+void PathTracer::Render()
+{
+	std::chrono::steady_clock::time_point passStart = std::chrono::steady_clock::now();
+
+	std::atomic<uint64_t> rayCount(0);
+	JobSystem::ParallelFor((size_t)m_tilesX * m_tilesY, 1,
+		[this, &rayCount](size_t begin, size_t end)
+		{
+			uint64_t tileRays = 0;
+			for (size_t tile = begin; tile < end; tile++)
+			{
+				tileRays += RenderTile((int)tile);
+			}
+			rayCount += tileRays;
+		});
+
+	m_sampleCount += m_settings.samplesPerPass;
+	m_bColorCurrent = false;
+
+	m_stats.samplesPerPixel = m_sampleCount;
+	m_stats.passRays = rayCount;
+	m_stats.passMilliseconds = GetElapsedMilliseconds(passStart);
+	m_stats.raysPerSecond = (m_stats.passMilliseconds > 0.0) ? m_stats.passRays * 1000.0 / m_stats.passMilliseconds : 0.0;
+}
+
+/***********************************************************
+ *  RenderTile()
+ *
+ *  This method is used for adding the samples of one pass
+ *  to the pixels of a tile.  Each sample jitters its camera
+ *  ray inside the pixel, which also smooths the edges.
+ ***********************************************************/
+uint64_t PathTracer::RenderTile(int tile)
+{
+	int x0 = (tile % m_tilesX) * g_TileSize;
+	int y0 = (tile / m_tilesX) * g_TileSize;
+	int x1 = std::min(x0 + g_TileSize, m_width);
+	int y1 = std::min(y0 + g_TileSize, m_height);
+
+	// every tile owns its own pixels, so the buffer needs no locking
+	float* pAccumulation = m_accumulation.data();
+	uint64_t rayCount = 0;
+	for (int y = y0; y < y1; y++)
+	{
+		for (int x = x0; x < x1; x++)
+		{
+			glm::vec3 pixelSum = glm::vec3(0.0f);
+			for (int sample = 0; sample < m_settings.samplesPerPass; sample++)
+			{
+				uint32_t randomState = HashSeed((uint32_t)x, (uint32_t)y, m_sampleCount + (uint32_t)sample);
+
+				// row zero is the top of the image
+				float ndcX = (x + NextRandom(randomState)) / m_width * 2.0f - 1.0f;
+				float ndcY = 1.0f - (y + NextRandom(randomState)) / m_height * 2.0f;
+				glm::vec4 nearPoint = m_inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+				glm::vec4 farPoint = m_inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+				glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+				glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+
+				glm::vec3 radiance = TracePath(origin, direction, randomState, rayCount);
+				// a rare degenerate triangle must not poison the pixel
+				if (std::isfinite(radiance.x) && std::isfinite(radiance.y) && std::isfinite(radiance.z))
+				{
+					pixelSum += radiance;
+				}
+			}
+
+			float* pPixel = pAccumulation + ((size_t)y * m_width + x) * 3;
+			pPixel[0] += pixelSum.x;
+			pPixel[1] += pixelSum.y;
+			pPixel[2] += pixelSum.z;
+		}
+	}
+	return(rayCount);
+}
+
+/***********************************************************
+ *  TracePath()
+ *
+ *  This method is used for following one path through the
+ *  scene.  At every hit the lights are sampled directly,
+ *  then the path bounces in a random diffuse direction.
+ *  After a few bounces dim paths are ended at random, and
+ *  the ones that survive are weighted up to make up for it.
+ ***********************************************************/
+glm::vec3 PathTracer::TracePath(glm::vec3 origin, glm::vec3 direction, uint32_t& randomState, uint64_t& rayCount) const
+{
+	glm::vec3 radiance = glm::vec3(0.0f);
+	glm::vec3 throughput = glm::vec3(1.0f);
+
+	for (int bounce = 0; ; bounce++)
+	{
+		BVH_HIT hit;
+		rayCount++;
+		if (!m_bvh.Intersect(origin, direction, g_MaxRayDistance, hit))
+		{
+			radiance += throughput * m_settings.skyColor;
+			break;
+		}
+
+		BVH_SURFACE surface = m_bvh.GetSurface(hit);
+		const SOFTWARE_DRAW& draw = m_scene.draws[surface.draw];
+		const INSTANCE_RECORD& instance = m_scene.pInstances[draw.instance];
+		glm::vec3 surfaceColor = glm::vec3(GetSurfaceColor(m_scene, instance, draw.textureSlot, surface.uv));
+
+		// objects without a material are plain matte surfaces
+		glm::vec3 diffuseColor = surfaceColor;
+		glm::vec3 specularColor = glm::vec3(0.0f);
+		if ((instance.materialIndex >= 0) && ((size_t)instance.materialIndex < m_scene.materialCount))
+		{
+			const MATERIAL_RECORD& material = m_scene.pMaterials[instance.materialIndex];
+			diffuseColor = surfaceColor * material.diffuseColor;
+			specularColor = surfaceColor * material.specularColor;
+		}
+		diffuseColor = glm::min(diffuseColor, glm::vec3(1.0f));
+
+		// light both sides of a surface, like the scene shader
+		glm::vec3 geometricNormal = surface.geometricNormal;
+		if (glm::dot(geometricNormal, direction) > 0.0f)
+		{
+			geometricNormal = -geometricNormal;
+		}
+		glm::vec3 normal = surface.normal;
+		if (glm::dot(normal, geometricNormal) < 0.0f)
+		{
+			normal = -normal;
+		}
+		glm::vec3 position = surface.position + geometricNormal * g_RayOffset;
+
+		radiance += throughput * SampleLights(position, normal, -direction, diffuseColor, specularColor, rayCount);
+
+		if (bounce >= m_settings.maxBounces)
+		{
+			break;
+		}
+
+		throughput *= diffuseColor;
+		if (bounce >= g_RouletteBounces)
+		{
+			float survival = std::min(std::max(std::max(throughput.x, std::max(throughput.y, throughput.z)), 0.05f), 0.95f);
+			if (NextRandom(randomState) >= survival)
+			{
+				break;
+			}
+			throughput /= survival;
+		}
+
+		direction = SampleCosineHemisphere(normal, randomState);
+		// the smooth normal can point bounces into the surface
+		if (glm::dot(direction, geometricNormal) <= 0.0f)
+		{
+			break;
+		}
+		origin = position;
+	}
+
+	return(radiance);
+}
+
+/***********************************************************
+ *  SampleLights()
+ *
+ *  This method is used for adding up the light every light
+ *  source reflects towards the viewer.  The diffuse and
+ *  specular terms are the ones the scene shader uses, but
+ *  each light is only counted when a shadow ray reaches it.
+ ***********************************************************/
+glm::vec3 PathTracer::SampleLights(
+	glm::vec3 position,
+	glm::vec3 normal,
+	glm::vec3 viewDirection,
+	glm::vec3 diffuseColor,
+	glm::vec3 specularColor,
+	uint64_t& rayCount) const
+{
+	glm::vec3 result = glm::vec3(0.0f);
+	for (size_t i = 0; i < m_scene.lightCount; i++)
+	{
+		const LIGHT_RECORD& light = m_scene.pLights[i];
+
+		glm::vec3 toLight = light.position - position;
+		float distance = glm::length(toLight);
+		if (distance <= g_RayOffset)
+		{
+			continue;
+		}
+		glm::vec3 lightDirection = toLight / distance;
+		float impact = glm::dot(normal, lightDirection);
+		if (impact <= 0.0f)
+		{
+			continue;
+		}
+
+		rayCount++;
+		if (m_bvh.IsOccluded(position, lightDirection, distance - g_RayOffset))
+		{
+			continue;
+		}
+
+		glm::vec3 diffuse = impact * light.diffuseColor * diffuseColor;
+
+		glm::vec3 reflectDirection = 2.0f * impact * normal - lightDirection;
+		float specularComponent = std::pow(std::max(glm::dot(viewDirection, reflectDirection), 0.0f), std::max(light.focalStrength, 1.0f));
+		glm::vec3 specular = light.specularIntensity * specularComponent * light.specularColor * specularColor;
+
+		result += diffuse + specular;
+	}
+	return(result);
+}
+
+/***********************************************************
+ *  ResolveImage()
+ *
+ *  This method is used for averaging the accumulated
+ *  samples into RGBA8 pixels, clamped like the framebuffer.
+ ***********************************************************/
+void PathTracer::ResolveImage()
+{
+	if (m_bColorCurrent)
+	{
+		return;
+	}
+
+	float scale = (m_sampleCount > 0) ? 1.0f / m_sampleCount : 0.0f;
+	for (size_t i = 0; i < m_color.size(); i++)
+	{
+		const float* pPixel = &m_accumulation[i * 3];
+		m_color[i] = PackColor(glm::vec4(pPixel[0] * scale, pPixel[1] * scale, pPixel[2] * scale, 1.0f));
+	}
+	m_bColorCurrent = true;
+}
+
+/***********************************************************
+ *  GetRow()
+ *
+ *  This method is used for reading one row of the averaged
+ *  image.
+ ***********************************************************/
+const uint32_t* PathTracer::GetRow(int y)
+{
+	ResolveImage();
+	return(&m_color[(size_t)y * m_width]);
+}
+
+/***********************************************************
+ *  WriteImage()
+ *
+ *  This method is used for writing the averaged image into
+ *  a binary PPM file, top row first.
+ ***********************************************************/
+bool PathTracer::WriteImage(const char* filename)
+{
+	ResolveImage();
+	return(WritePPMImage(filename, m_color.data(), m_width, m_height, m_width));
+}
@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+// pathtracer.h
+// ============
+// progressive multithreaded CPU path tracer used to render
+// reference images of the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneBVH.h"
+#include "SceneEntities.h"
+#include "SoftwareScene.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+/***********************************************************
+ *  PATH_TRACE_SETTINGS
+ *
+ *  How each pass of the path tracer is traced.
+ ***********************************************************/
+struct PATH_TRACE_SETTINGS
+{
+	// samples added to every pixel by each pass
+	int samplesPerPass;
+	// diffuse bounces after the first hit - zero is direct light only
+	int maxBounces;
+	// light arriving along rays that leave the scene
+	glm::vec3 skyColor;
+};
+
+/***********************************************************
+ *  PATH_TRACE_STATS
+ *
+ *  The size of the tree and the work done by the last pass.
+ ***********************************************************/
+struct PATH_TRACE_STATS
+{
+	uint32_t triangleCount;
+	uint32_t nodeCount;
+	double buildMilliseconds;
+	// samples accumulated in every pixel so far
+	uint32_t samplesPerPixel;
+	// camera, bounce and shadow rays traced by the last pass
+	uint64_t passRays;
+	double passMilliseconds;
+	double raysPerSecond;
+};
+
+/***********************************************************
+ *  PathTracer
+ *
+ *  This class renders ground truth images of a software
+ *  scene to judge the lighting approximations of the
+ *  shaders against.  Every pass adds samples to each pixel
+ *  until the image converges:
+ *
+ *  - the lights are sampled directly at every hit with a
+ *    shadow ray, using the diffuse and specular terms of the
+ *    scene shader
+ *  - the ambient terms are left out - the light they stand
+ *    in for is traced as diffuse bounces and sky light
+ *  - surface colors come from the same textures and
+ *    instance records the rasterizers read
+ *
+ *  The image is split into tiles that are traced in
+ *  parallel.  Each sample draws its random numbers from its
+ *  pixel and sample index, so the result never depends on
+ *  the number of threads.
+ ***********************************************************/
+class PathTracer
+{
+public:
+	// constructor
+	PathTracer(int width, int height);
+
+	// change the size of the image - clears the accumulated samples
+	void Resize(int width, int height);
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+	void SetSettings(const PATH_TRACE_SETTINGS& settings);
+	const PATH_TRACE_SETTINGS& GetSettings() const { return m_settings; }
+
+	// take the scene and rebuild the tree - the records the scene
+	// points at must stay valid until the next call
+	void SetScene(const SOFTWARE_SCENE& scene);
+	// move the camera - clears the accumulated samples when it moved
+	void SetCamera(const glm::mat4& view, const glm::mat4& projection);
+	// throw away the accumulated samples
+	void Reset();
+
+	// trace one pass
+	void Render();
+
+	// the average of the accumulated samples, one row of RGBA8
+	// pixels - row zero is the top of the image
+	const uint32_t* GetRow(int y);
+	// write the average of the accumulated samples into a binary PPM file
+	bool WriteImage(const char* filename);
+
+	const PATH_TRACE_STATS& GetStats() const { return m_stats; }
+	const SceneBVH& GetBVH() const { return m_bvh; }
+
+private:
+	int m_width;
+	int m_height;
+	int m_tilesX;
+	int m_tilesY;
+
+	PATH_TRACE_SETTINGS m_settings;
+	SOFTWARE_SCENE m_scene;
+	SceneBVH m_bvh;
+
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
+	glm::mat4 m_inverseViewProjection;
+
+	// sum of the samples of each pixel, three floats per pixel
+	SceneVector<float> m_accumulation;
+	uint32_t m_sampleCount;
+	// averaged image, rebuilt when it is read after a pass
+	SceneVector<uint32_t> m_color;
+	bool m_bColorCurrent;
+
+	PATH_TRACE_STATS m_stats;
+
+	// trace the pass for the pixels of one tile, returns the rays traced
+	uint64_t RenderTile(int tile);
+	// light arriving at the origin along the ray
+	glm::vec3 TracePath(glm::vec3 origin, glm::vec3 direction, uint32_t& randomState, uint64_t& rayCount) const;
+	// light reflected towards the viewer by every light source
+	glm::vec3 SampleLights(
+		glm::vec3 position,
+		glm::vec3 normal,
+		glm::vec3 viewDirection,
+		glm::vec3 diffuseColor,
+		glm::vec3 specularColor,
+		uint64_t& rayCount) const;
+	// average the samples into the RGBA8 image
+	void ResolveImage();
+};
@@ -0,0 +1,540 @@
+///////////////////////////////////////////////////////////////////////////////
+// regressionsuite.cpp
+// ============
+// headless image and frame time regression checks against
+// stored golden images
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RegressionSuite.h"
+#include "SoftwareScene.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// size of the rendered images - small enough to keep the
+	// suite fast, large enough to show a moved object
+	const int g_ImageWidth = 400;
+	const int g_ImageHeight = 320;
+
+	// frames rendered before the timed frames, to fill the caches
+	const int g_WarmupFrames = 1;
+	// frames the median frame time is taken over
+	const int g_TimedFrames = 9;
+
+	// the YIQ difference a pixel needs to be seen as changed,
+	// as a fraction of the largest possible difference
+	const double g_PixelThreshold = 0.1;
+	// largest squared YIQ difference, between black and white
+	const double g_MaxYIQDelta = 35215.0;
+	// fraction of the pixels allowed to change before the image fails
+	const double g_MaxDifferentFraction = 0.001;
+
+	// a frame time fails when it is slower than the baseline by
+	// this factor plus the slack, which absorbs timer noise on
+	// the views that take only a few milliseconds
+	const double g_TimingTolerance = 1.25;
+	const double g_TimingSlackMilliseconds = 1.0;
+
+	const char* const g_BaselineFilename = "timings.csv";
+
+	// the fixed cameras - the stress views come last, since the
+	// extra objects stay in the scene once they are added
+	const REGRESSION_VIEW g_RegressionViews[] =
+	{
+		{ "shrine_front", glm::vec3(0.0f, 5.0f, 12.0f), glm::vec3(0.0f, 4.5f, 10.0f), 80.0f, 0.0, false },
+		{ "shrine_side", glm::vec3(10.0f, 4.0f, 4.0f), glm::vec3(0.0f, 2.0f, 0.0f), 60.0f, 0.0, false },
+		{ "shrine_top", glm::vec3(0.0f, 14.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), 60.0f, 0.0, false },
+		// close on the hedge, the only object the wind bends, mid gust
+		{ "shrine_wind", glm::vec3(6.0f, 2.0f, 10.0f), glm::vec3(4.0f, 0.0f, 7.0f), 40.0f, 1.5, false },
+		{ "stress_wide", glm::vec3(0.0f, 8.0f, 20.0f), glm::vec3(0.0f, 0.0f, 0.0f), 70.0f, 0.0, true },
+		{ "stress_low", glm::vec3(-14.0f, 2.0f, 10.0f), glm::vec3(0.0f, 1.0f, 0.0f), 80.0f, 2.0, true }
+	};
+
+	// half size of the stress object field, and the spacing of its grid
+	const int g_StressHalfExtent = 20;
+	const float g_StressSpacing = 1.0f;
+	// the field leaves the shrine itself clear
+	const float g_StressClearRadius = 4.0f;
+
+	/***********************************************************
+	 *  g_ToYIQ()
+	 *
+	 *  Convert an RGBA8 pixel into the YIQ color space, which
+	 *  separates brightness from color like the eye does.
+	 ***********************************************************/
+	glm::vec3 g_ToYIQ(uint32_t pixel)
+	{
+		float r = (float)(pixel & 0xFF);
+		float g = (float)((pixel >> 8) & 0xFF);
+		float b = (float)((pixel >> 16) & 0xFF);
+		return(glm::vec3(
+			r * 0.29889531f + g * 0.58662247f + b * 0.11448223f,
+			r * 0.59597799f - g * 0.27417610f - b * 0.32180189f,
+			r * 0.21147017f - g * 0.52261711f + b * 0.31114694f));
+	}
+
+	/***********************************************************
+	 *  g_PixelDelta()
+	 *
+	 *  Squared perceptual difference of two pixels, with the
+	 *  brightness weighted more than the color.
+	 ***********************************************************/
+	double g_PixelDelta(uint32_t a, uint32_t b)
+	{
+		if ((a & 0x00FFFFFF) == (b & 0x00FFFFFF))
+		{
+			return(0.0);
+		}
+		glm::vec3 delta = g_ToYIQ(a) - g_ToYIQ(b);
+		return(0.5053 * delta.x * delta.x + 0.299 * delta.y * delta.y + 0.1957 * delta.z * delta.z);
+	}
+
+	/***********************************************************
+	 *  IsFlatImage()
+	 *
+	 *  Whether every pixel of an image has the same color - a
+	 *  camera inside or right against an object, which cannot
+	 *  show any change to the scene.
+	 ***********************************************************/
+	bool IsFlatImage(const std::vector<uint32_t>& image)
+	{
+		for (uint32_t pixel : image)
+		{
+			if ((pixel & 0x00FFFFFF) != (image[0] & 0x00FFFFFF))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  RegressionSuite()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RegressionSuite::RegressionSuite(const char* goldenDirectory, bool bUpdateGolden)
+{
+	m_goldenDirectory = goldenDirectory;
+	if (!m_goldenDirectory.empty() &&
+		(m_goldenDirectory.back() != '/') &&
+		(m_goldenDirectory.back() != '\\'))
+	{
+		m_goldenDirectory += "/";
+	}
+	m_bUpdateGolden = bUpdateGolden;
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for rendering every view with the
+ *  software backend and checking the images and frame
+ *  times.  The job system has to be running.  The scene is
+ *  drawn without its textures, whose image files are kept
+ *  outside the project, so the golden images depend on
+ *  nothing but the project itself.  Golden images and
+ *  baselines are only written when updating - a missing
+ *  one fails its view, as does a golden image of a single
+ *  color, which could never catch a change.
+ ***********************************************************/
+bool RegressionSuite::Run(const char* sceneFilename)
+{
+	m_results.clear();
+	LoadBaselines();
+
+	SceneManager* pScene = new SceneManager(NULL);
+	pScene->SetRenderBackend(SceneManager::RENDER_BACKEND_SOFTWARE, g_ImageWidth, g_ImageHeight);
+	pScene->SetTexturesEnabled(false);
+	if (NULL != sceneFilename)
+	{
+		pScene->LoadSceneFile(sceneFilename);
+	}
+	pScene->PrepareScene();
+
+	bool bStressAdded = false;
+	bool bAllPassed = true;
+	for (const REGRESSION_VIEW& view : g_RegressionViews)
+	{
+		if (view.bStressScene && !bStressAdded)
+		{
+			AddStressObjects(pScene);
+			bStressAdded = true;
+		}
+
+		REGRESSION_RESULT result = RunView(pScene, view);
+		std::cout << (result.bImagePassed && result.bTimingPassed ? "INFO: passed " : "WARNING: failed ")
+			<< result.name << " - "
+			<< result.differentFraction * 100.0 << "% pixels differ, max difference "
+			<< result.maxDifference << ", median "
+			<< result.medianMilliseconds << "ms against a baseline of "
+			<< result.baselineMilliseconds << "ms"
+			<< (result.bGoldenWritten ? " (golden written)" : "") << std::endl;
+
+		bAllPassed = bAllPassed && result.bImagePassed && result.bTimingPassed;
+		m_results.push_back(result);
+	}
+
+	delete pScene;
+	pScene = NULL;
+
+	if (m_bUpdateGolden)
+	{
+		SaveBaselines();
+	}
+	return(bAllPassed);
+}
+
+/***********************************************************
+ *  RunView()
+ *
+ *  This method is used for rendering one view, timing the
+ *  frames and comparing the image with its golden image.
+ *  A failed image is written next to the golden image with
+ *  a map of the pixels that changed.
+ ***********************************************************/
+REGRESSION_RESULT RegressionSuite::RunView(SceneManager* pScene, const REGRESSION_VIEW& view)
+{
+	REGRESSION_RESULT result;
+	result.name = view.name;
+	result.bGoldenWritten = false;
+	result.bImagePassed = true;
+	result.differentFraction = 0.0;
+	result.maxDifference = 0.0;
+	result.bTimingPassed = true;
+	result.medianMilliseconds = 0.0;
+	result.baselineMilliseconds = 0.0;
+
+	glm::mat4 viewMatrix = glm::lookAt(view.eye, view.target, glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(
+		glm::radians(view.fieldOfViewDegrees),
+		(float)g_ImageWidth / (float)g_ImageHeight,
+		0.1f, 100.0f);
+	pScene->SetViewProjection(viewMatrix, projection);
+	pScene->SetFrameTime(view.frameTime);
+
+	std::vector<double> frameMilliseconds;
+	for (int frame = 0; frame < g_WarmupFrames + g_TimedFrames; frame++)
+	{
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		pScene->RenderScene();
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+		if (frame >= g_WarmupFrames)
+		{
+			frameMilliseconds.push_back(milliseconds);
+		}
+	}
+	std::sort(frameMilliseconds.begin(), frameMilliseconds.end());
+	result.medianMilliseconds = frameMilliseconds[frameMilliseconds.size() / 2];
+
+	// gather the rows of the color buffer into one image
+	SoftwareRasterizer* pRasterizer = pScene->GetSoftwareRasterizer();
+	std::vector<uint32_t> image((size_t)g_ImageWidth * g_ImageHeight);
+	for (int y = 0; y < g_ImageHeight; y++)
+	{
+		std::copy(pRasterizer->GetRow(y), pRasterizer->GetRow(y) + g_ImageWidth, &image[(size_t)y * g_ImageWidth]);
+	}
+
+	std::string goldenFilename = m_goldenDirectory + view.name + ".ppm";
+	std::vector<uint32_t> golden;
+	int goldenWidth = 0;
+	int goldenHeight = 0;
+	if (m_bUpdateGolden && IsFlatImage(image))
+	{
+		std::cout << "WARNING: " << view.name << " is a single color - move its camera "
+			<< "so it shows the scene before recording it" << std::endl;
+		result.bImagePassed = false;
+		result.differentFraction = 1.0;
+		result.maxDifference = 1.0;
+	}
+	else if (m_bUpdateGolden)
+	{
+		WritePPMImage(goldenFilename.c_str(), image.data(), g_ImageWidth, g_ImageHeight, g_ImageWidth);
+		result.bGoldenWritten = true;
+	}
+	else if (!ReadPPMImage(goldenFilename.c_str(), golden, goldenWidth, goldenHeight))
+	{
+		std::cout << "WARNING: no golden image " << goldenFilename
+			<< " - record the golden images with --update-golden" << std::endl;
+		result.bImagePassed = false;
+		result.differentFraction = 1.0;
+		result.maxDifference = 1.0;
+	}
+	else if ((goldenWidth != g_ImageWidth) || (goldenHeight != g_ImageHeight))
+	{
+		std::cout << "WARNING: golden image " << goldenFilename << " is "
+			<< goldenWidth << "x" << goldenHeight << ", expected "
+			<< g_ImageWidth << "x" << g_ImageHeight << std::endl;
+		result.bImagePassed = false;
+		result.differentFraction = 1.0;
+		result.maxDifference = 1.0;
+	}
+	else if (IsFlatImage(golden))
+	{
+		std::cout << "WARNING: golden image " << goldenFilename << " is a single color, "
+			<< "so it cannot catch a change - move the camera and record it again" << std::endl;
+		result.bImagePassed = false;
+		result.differentFraction = 1.0;
+		result.maxDifference = 1.0;
+	}
+	else
+	{
+		CompareImages(image, golden, g_ImageWidth, g_ImageHeight, result);
+	}
+
+	if (!result.bImagePassed)
+	{
+		std::string actualFilename = m_goldenDirectory + view.name + "_actual.ppm";
+		WritePPMImage(actualFilename.c_str(), image.data(), g_ImageWidth, g_ImageHeight, g_ImageWidth);
+	}
+
+	double baseline = FindBaseline(result.name);
+	if (m_bUpdateGolden)
+	{
+		SetBaseline(result.name, result.medianMilliseconds);
+		baseline = result.medianMilliseconds;
+	}
+	else if (baseline <= 0.0)
+	{
+		std::cout << "WARNING: no frame time baseline for " << result.name
+			<< " - record the baselines with --update-golden" << std::endl;
+	}
+	result.baselineMilliseconds = baseline;
+	result.bTimingPassed = (baseline > 0.0) &&
+		(result.medianMilliseconds <= baseline * g_TimingTolerance + g_TimingSlackMilliseconds);
+
+	return(result);
+}
+
+/***********************************************************
+ *  CompareImages()
+ *
+ *  This method is used for counting the pixels of an image
+ *  that differ visibly from the golden image.  When the
+ *  image fails, a map of the changed pixels is written over
+ *  a faded copy of the golden image, so the change can be
+ *  found at a glance.
+ ***********************************************************/
+void RegressionSuite::CompareImages(
+	const std::vector<uint32_t>& image,
+	const std::vector<uint32_t>& golden,
+	int width,
+	int height,
+	REGRESSION_RESULT& result) const
+{
+	double pixelThreshold = g_MaxYIQDelta * g_PixelThreshold * g_PixelThreshold;
+	std::vector<uint32_t> differences((size_t)width * height);
+	size_t differentPixels = 0;
+	double maxDelta = 0.0;
+
+	for (int y = 0; y < height; y++)
+	{
+		const uint32_t* pRow = &image[(size_t)y * width];
+		const uint32_t* pGoldenRow = &golden[(size_t)y * width];
+		for (int x = 0; x < width; x++)
+		{
+			double delta = g_PixelDelta(pRow[x], pGoldenRow[x]);
+			maxDelta = std::max(maxDelta, delta);
+
+			uint32_t& difference = differences[(size_t)y * width + x];
+			if (delta > pixelThreshold)
+			{
+				differentPixels++;
+				difference = 0xFF0000FFu;
+			}
+			else
+			{
+				// faded brightness of the golden pixel
+				uint32_t luma = (uint32_t)(g_ToYIQ(pGoldenRow[x]).x * 0.25f + 160.0f);
+				difference = 0xFF000000u | (luma << 16) | (luma << 8) | luma;
+			}
+		}
+	}
+
+	result.differentFraction = (double)differentPixels / (double)((size_t)width * height);
+	result.maxDifference = std::sqrt(maxDelta / g_MaxYIQDelta);
+	result.bImagePassed = (result.differentFraction <= g_MaxDifferentFraction);
+
+	if (!result.bImagePassed)
+	{
+		std::string differenceFilename = m_goldenDirectory + result.name + "_diff.ppm";
+		WritePPMImage(differenceFilename.c_str(), differences.data(), width, height, width);
+	}
+}
+
+/***********************************************************
+ *  AddStressObjects()
+ *
+ *  This method is used for filling the ground around the
+ *  shrine with a grid of small objects of every mesh, to
+ *  load the culling, binning and rasterizing much more than
+ *  the shrine does.  The colors and rotations come from the
+ *  grid position, so every run builds the same field.
+ ***********************************************************/
+void RegressionSuite::AddStressObjects(SceneManager* pScene)
+{
+	const SCENE_MESH meshes[] = { SCENE_MESH_BOX, SCENE_MESH_TORUS, SCENE_MESH_TAPERED_CYLINDER, SCENE_MESH_PRISM };
+	const char* textures[] = { "stone", "bush", "", "stone" };
+	const char* materials[] = { "box1", "torus", "box2", "prism" };
+
+	size_t objectCount = 0;
+	for (int z = -g_StressHalfExtent; z <= g_StressHalfExtent; z++)
+	{
+		for (int x = -g_StressHalfExtent; x <= g_StressHalfExtent; x++)
+		{
+			glm::vec3 position((float)x * g_StressSpacing, 0.25f, (float)z * g_StressSpacing);
+			if ((std::abs(position.x) < g_StressClearRadius) && (std::abs(position.z) < g_StressClearRadius))
+			{
+				continue;
+			}
+
+			int kind = ((x * 7 + z * 13) % 4 + 4) % 4;
+			glm::vec4 color(
+				0.3f + 0.7f * (float)((x + g_StressHalfExtent) % 5) / 4.0f,
+				0.3f + 0.7f * (float)((z + g_StressHalfExtent) % 7) / 6.0f,
+				0.5f,
+				1.0f);
+			pScene->AddSceneObject(
+				meshes[kind],
+				glm::vec3(0.35f, 0.5f, 0.35f),
+				glm::vec3(0.0f, (float)(((x * 31 + z * 17) % 12 + 12) % 12) * 30.0f, 0.0f),
+				position,
+				color,
+				textures[kind],
+				materials[kind]);
+			objectCount++;
+		}
+	}
+
+	std::cout << "INFO: added " << objectCount << " stress objects" << std::endl;
+}
+
+/***********************************************************
+ *  WriteReport()
+ *
+ *  This method is used for writing the results of the last
+ *  run as comma separated values, one view per line.
+ ***********************************************************/
+bool RegressionSuite::WriteReport(const char* filename) const
+{
+	std::ofstream file(filename, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "WARNING: could not write regression report " << filename << std::endl;
+		return(false);
+	}
+
+	file << "view,image_passed,different_percent,max_difference,timing_passed,median_ms,baseline_ms,golden_written\n";
+	for (const REGRESSION_RESULT& result : m_results)
+	{
+		file << result.name << ","
+			<< (result.bImagePassed ? 1 : 0) << ","
+			<< result.differentFraction * 100.0 << ","
+			<< result.maxDifference << ","
+			<< (result.bTimingPassed ? 1 : 0) << ","
+			<< result.medianMilliseconds << ","
+			<< result.baselineMilliseconds << ","
+			<< (result.bGoldenWritten ? 1 : 0) << "\n";
+	}
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  LoadBaselines()
+ *
+ *  This method is used for reading the stored median frame
+ *  times of the views from the golden directory.
+ ***********************************************************/
+void RegressionSuite::LoadBaselines()
+{
+	m_baselines.clear();
+
+	std::ifstream file(m_goldenDirectory + g_BaselineFilename);
+	std::string line;
+	while (std::getline(file, line))
+	{
+		size_t comma = line.find(',');
+		if (comma == std::string::npos)
+		{
+			continue;
+		}
+		double milliseconds = atof(line.c_str() + comma + 1);
+		if (milliseconds > 0.0)
+		{
+			m_baselines.push_back(std::make_pair(line.substr(0, comma), milliseconds));
+		}
+	}
+}
+
+/***********************************************************
+ *  SaveBaselines()
+ *
+ *  This method is used for writing the median frame times
+ *  of the views back into the golden directory.
+ ***********************************************************/
+bool RegressionSuite::SaveBaselines() const
+{
+	std::string filename = m_goldenDirectory + g_BaselineFilename;
+	std::ofstream file(filename, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "WARNING: could not write frame time baselines " << filename << std::endl;
+		return(false);
+	}
+
+	file << "view,median_ms\n";
+	for (const std::pair<std::string, double>& baseline : m_baselines)
+	{
+		file << baseline.first << "," << baseline.second << "\n";
+	}
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  FindBaseline()
+ *
+ *  This method is used for getting the stored frame time of
+ *  a view, or zero when none is stored.
+ ***********************************************************/
+double RegressionSuite::FindBaseline(const std::string& name) const
+{
+	for (const std::pair<std::string, double>& baseline : m_baselines)
+	{
+		if (baseline.first == name)
+		{
+			return(baseline.second);
+		}
+	}
+	return(0.0);
+}
+
+/***********************************************************
+ *  SetBaseline()
+ *
+ *  This method is used for storing the frame time of a view.
+ ***********************************************************/
+void RegressionSuite::SetBaseline(const std::string& name, double milliseconds)
+{
+	for (std::pair<std::string, double>& baseline : m_baselines)
+	{
+		if (baseline.first == name)
+		{
+			baseline.second = milliseconds;
+			return;
+		}
+	}
+	m_baselines.push_back(std::make_pair(name, milliseconds));
+}
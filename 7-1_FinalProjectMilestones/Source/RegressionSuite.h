@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// regressionsuite.h
+// ============
+// headless image and frame time regression checks against
+// stored golden images
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  REGRESSION_VIEW
+ *
+ *  One fixed camera the suite renders the scene from.  The
+ *  stress views see the shrine with a large field of extra
+ *  objects added around it.
+ ***********************************************************/
+struct REGRESSION_VIEW
+{
+	const char* name;
+	glm::vec3 eye;
+	glm::vec3 target;
+	float fieldOfViewDegrees;
+	// wind animation time the view is rendered at
+	double frameTime;
+	bool bStressScene;
+};
+
+/***********************************************************
+ *  REGRESSION_RESULT
+ *
+ *  Outcome of one view - how far the image is from the
+ *  golden image, and how its frame time compares to the
+ *  stored baseline.
+ ***********************************************************/
+struct REGRESSION_RESULT
+{
+	std::string name;
+	// updating was asked for, so this run wrote the golden
+	// image and the baseline
+	bool bGoldenWritten;
+	bool bImagePassed;
+	// pixels the eye would see as different, out of all pixels
+	double differentFraction;
+	// largest perceptual difference of any pixel, from 0 to 1
+	double maxDifference;
+	bool bTimingPassed;
+	double medianMilliseconds;
+	double baselineMilliseconds;
+};
+
+/***********************************************************
+ *  RegressionSuite
+ *
+ *  This class renders every view with the software backend,
+ *  without a window or OpenGL, and compares the images with
+ *  the golden images in a directory.  Pixels are compared
+ *  in the YIQ color space, weighted the way the eye weighs
+ *  brightness and color changes, so the small rounding
+ *  differences between compilers and SIMD paths pass while
+ *  a moved or recolored object fails.  The median frame
+ *  time of every view is compared with a stored baseline
+ *  as well, to catch performance regressions.
+ ***********************************************************/
+class RegressionSuite
+{
+public:
+	// constructor
+	RegressionSuite(const char* goldenDirectory, bool bUpdateGolden);
+
+	// render and check every view - returns true when all passed
+	bool Run(const char* sceneFilename);
+	// write one line per view with the comparison and timing
+	bool WriteReport(const char* filename) const;
+
+	const std::vector<REGRESSION_RESULT>& GetResults() const { return m_results; }
+
+private:
+	std::string m_goldenDirectory;
+	bool m_bUpdateGolden;
+	std::vector<REGRESSION_RESULT> m_results;
+	// stored median frame time of each view, by view name
+	std::vector<std::pair<std::string, double>> m_baselines;
+
+	// render one view and check it against its golden image
+	REGRESSION_RESULT RunView(SceneManager* pScene, const REGRESSION_VIEW& view);
+	// add the field of extra objects the stress views draw
+	void AddStressObjects(SceneManager* pScene);
+	// compare an image with the golden image pixel by pixel
+	void CompareImages(
+		const std::vector<uint32_t>& image,
+		const std::vector<uint32_t>& golden,
+		int width,
+		int height,
+		REGRESSION_RESULT& result) const;
+	// read and write the stored baseline frame times
+	void LoadBaselines();
+	bool SaveBaselines() const;
+	double FindBaseline(const std::string& name) const;
+	void SetBaseline(const std::string& name, double milliseconds);
+};
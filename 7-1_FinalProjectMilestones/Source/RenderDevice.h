@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderdevice.h
+// ============
+// graphics API independent command lists and the device
+// interface that executes them
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneBuffers.h"
+#include "SceneFile.h"
+#include "WindSystem.h"
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  RENDER_COMMAND
+ *
+ *  One recorded draw - a mesh drawn with an instance record
+ *  and the texture in a texture slot, or no texture when
+ *  the slot is negative.  Imported meshes are also drawn at
+ *  a level of detail, 0 being the full mesh.
+ ***********************************************************/
+struct RENDER_COMMAND
+{
+	uint32_t instance;
+	int16_t textureSlot;
+	uint8_t mesh;
+	uint8_t lod;
+};
+
+/***********************************************************
+ *  RenderCommandList
+ *
+ *  This class records draws without touching the graphics
+ *  API, so any number of lists can be recorded at once on
+ *  the job system.  The lists are executed in order by
+ *  RenderDevice::Submit() afterwards.
+ ***********************************************************/
+class RenderCommandList
+{
+public:
+	// forget the recorded commands, keeping the memory
+	void Reset() { m_commands.clear(); }
+
+	void Draw(SCENE_MESH mesh, uint32_t instance, int textureSlot, uint32_t lod = 0)
+	{
+		RENDER_COMMAND command;
+		command.instance = instance;
+		command.textureSlot = (int16_t)textureSlot;
+		command.mesh = (uint8_t)mesh;
+		command.lod = (uint8_t)lod;
+		m_commands.push_back(command);
+	}
+
+	const RENDER_COMMAND* GetCommands() const { return m_commands.data(); }
+	size_t GetCount() const { return m_commands.size(); }
+
+private:
+	std::vector<RENDER_COMMAND> m_commands;
+};
+
+/***********************************************************
+ *  RENDER_FRAME
+ *
+ *  What the draws of a frame read besides their commands -
+ *  the scene records, the camera and lighting, and the wind
+ *  at the frame's time.
+ ***********************************************************/
+struct RENDER_FRAME
+{
+	GPUArrayBuffer* pInstances;
+	GPUArrayBuffer* pMaterials;
+	GPUArrayBuffer* pLights;
+	FRAME_CONSTANTS constants;
+	WindSystem* pWind;
+	double time;
+	// another view of a frame already begun - the device keeps
+	// writing into the same per-frame resources
+	bool bSameFrame;
+};
+
+/***********************************************************
+ *  RENDER_DEVICE_STATS
+ *
+ *  Work done by the last submission.
+ ***********************************************************/
+struct RENDER_DEVICE_STATS
+{
+	uint32_t commandLists;
+	uint32_t draws;
+	// texture changes the device could not skip
+	uint32_t textureChanges;
+	double submitMilliseconds;
+};
+
+/***********************************************************
+ *  RenderDevice
+ *
+ *  This is the interface the scene draws through.  The
+ *  scene records what to draw into command lists, and a
+ *  device turns them into calls of one graphics API, or
+ *  draws them itself.  The frame's records are handed over
+ *  before submission, so the commands only carry the per
+ *  draw state.
+ ***********************************************************/
+class RenderDevice
+{
+public:
+	virtual ~RenderDevice() {}
+
+	// name of the graphics API, for reports
+	virtual const char* GetName() const = 0;
+	// set up the device once the scene shader is loaded
+	virtual bool Initialize() = 0;
+	// height in pixels of the image drawn into, for choosing
+	// the level of detail of the meshes
+	virtual int GetTargetHeight() const = 0;
+	// take the scene records changed since the last frame and
+	// the frame's constants
+	virtual void BeginFrame(const RENDER_FRAME& frame) = 0;
+	// execute the command lists in order - only from the thread
+	// that owns the graphics context
+	virtual void Submit(const RenderCommandList* pLists, size_t listCount) = 0;
+	// finish the frame once everything has been submitted
+	virtual void EndFrame() = 0;
+
+	const RENDER_DEVICE_STATS& GetStats() const { return m_stats; }
+
+protected:
+	RENDER_DEVICE_STATS m_stats = {};
+};
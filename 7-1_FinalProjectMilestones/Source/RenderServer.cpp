@@ -0,0 +1,825 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderserver.cpp
+// ============
+// serve rendered views of the scene to other processes on the same host
+// over a unix domain socket
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderServer.h"
+#include "SoftwareScene.h"
+#include "MemoryTracker.h"
+#include "GLDebug.h"
+#include "Metrics.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#if defined(_WIN32)
+// AF_UNIX sockets are part of Winsock since Windows 10 1803
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+#if defined(_WIN32)
+	const SERVER_SOCKET g_InvalidSocket = (SERVER_SOCKET)INVALID_SOCKET;
+#else
+	const SERVER_SOCKET g_InvalidSocket = -1;
+#endif
+
+	// longest request line a client may send
+	const size_t g_MaxRequestLine = 1024;
+	// clients waiting to be accepted
+	const int g_ListenBacklog = 16;
+	// nanoseconds waited for a fence before the wait is retried
+	const GLuint64 g_FenceTimeout = 1000000000;
+
+	// same depth range as the interactive camera
+	const float g_NearPlane = 0.1f;
+	const float g_FarPlane = 100.0f;
+
+	void g_CloseSocket(SERVER_SOCKET socket)
+	{
+#if defined(_WIN32)
+		closesocket((SOCKET)socket);
+#else
+		close(socket);
+#endif
+	}
+
+	// wake a thread blocked in accept() or recv() on the socket
+	void g_ShutdownSocket(SERVER_SOCKET socket)
+	{
+#if defined(_WIN32)
+		shutdown((SOCKET)socket, SD_BOTH);
+#else
+		shutdown(socket, SHUT_RDWR);
+#endif
+	}
+
+	// write all of the bytes, false once the client is gone
+	bool g_SendAll(SERVER_SOCKET socket, const void* pData, size_t bytes)
+	{
+#if defined(MSG_NOSIGNAL)
+		const int flags = MSG_NOSIGNAL;
+#else
+		const int flags = 0;
+#endif
+		const char* pBytes = (const char*)pData;
+		while (bytes > 0)
+		{
+			int chunk = (int)std::min(bytes, (size_t)(1 << 20));
+			int sent = (int)send(socket, pBytes, chunk, flags);
+			if (sent <= 0)
+			{
+				return(false);
+			}
+			pBytes += sent;
+			bytes -= sent;
+		}
+		return(true);
+	}
+
+	bool g_SendLine(SERVER_SOCKET socket, const std::string& line)
+	{
+		std::string text = line + "\n";
+		return(g_SendAll(socket, text.data(), text.size()));
+	}
+
+	// the OK line and its payload
+	bool g_SendPayload(SERVER_SOCKET socket, const void* pData, size_t bytes)
+	{
+		return(g_SendLine(socket, "OK " + std::to_string(bytes)) &&
+			((bytes == 0) || g_SendAll(socket, pData, bytes)));
+	}
+
+	// delete a socket file left behind by a server that did not
+	// shut down cleanly - anything else at the path is kept, and
+	// the bind reports it
+	void g_RemoveStaleSocket(const char* socketPath)
+	{
+#if defined(_WIN32)
+		DWORD attributes = GetFileAttributesA(socketPath);
+		if ((attributes != INVALID_FILE_ATTRIBUTES) && (attributes & FILE_ATTRIBUTE_REPARSE_POINT))
+		{
+			DeleteFileA(socketPath);
+		}
+#else
+		struct stat status;
+		if ((stat(socketPath, &status) == 0) && S_ISSOCK(status.st_mode))
+		{
+			unlink(socketPath);
+		}
+#endif
+	}
+
+	// requests that would render the same image
+	bool g_SameView(const BATCH_POSE& a, int aWidth, int aHeight, const BATCH_POSE& b, int bWidth, int bHeight)
+	{
+		return((aWidth == bWidth) && (aHeight == bHeight) &&
+			(a.eye == b.eye) && (a.target == b.target) &&
+			(a.fieldOfViewDegrees == b.fieldOfViewDegrees) &&
+			(a.frameTime == b.frameTime));
+	}
+}
+
+/***********************************************************
+ *  RenderServer()
+ *
+ *  The constructor for the class.
+ ***********************************************************/
+RenderServer::RenderServer()
+{
+	m_listenSocket = g_InvalidSocket;
+	m_bListening = false;
+	m_bStopping = false;
+	m_readbackBytes[0] = 0;
+	m_readbackBytes[1] = 0;
+	m_nextReadback = 0;
+	m_stats = {};
+	m_totalLatencyMilliseconds = 0.0;
+}
+
+/***********************************************************
+ *  ~RenderServer()
+ *
+ *  The destructor for the class.
+ ***********************************************************/
+RenderServer::~RenderServer()
+{
+	Stop();
+	DestroyFramebuffer();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for creating the listening socket
+ *  and starting the thread that accepts the clients.
+ ***********************************************************/
+bool RenderServer::Start(const char* socketPath)
+{
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if (strlen(socketPath) >= sizeof(address.sun_path))
+	{
+		std::cout << "WARNING: the render server socket path is too long:" << socketPath << std::endl;
+		return(false);
+	}
+	strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+
+#if defined(_WIN32)
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+	{
+		std::cout << "WARNING: could not initialize Winsock" << std::endl;
+		return(false);
+	}
+#endif
+
+	m_listenSocket = (SERVER_SOCKET)socket(AF_UNIX, SOCK_STREAM, 0);
+	if (m_listenSocket == g_InvalidSocket)
+	{
+		std::cout << "WARNING: could not create the render server socket" << std::endl;
+		return(false);
+	}
+	g_RemoveStaleSocket(socketPath);
+	if ((bind(m_listenSocket, (const sockaddr*)&address, sizeof(address)) != 0) ||
+		(listen(m_listenSocket, g_ListenBacklog) != 0))
+	{
+		std::cout << "Could not listen on the render server socket:" << socketPath << std::endl;
+		g_CloseSocket(m_listenSocket);
+		m_listenSocket = g_InvalidSocket;
+		return(false);
+	}
+
+	m_socketPath = socketPath;
+	m_bListening = true;
+	m_bStopping = false;
+	m_startTime = std::chrono::steady_clock::now();
+	m_acceptor = std::thread(&RenderServer::AcceptorMain, this);
+
+	std::cout << "INFO: render server listening on " << m_socketPath << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for closing the listening socket and
+ *  every client connection, and waiting for their threads.
+ ***********************************************************/
+void RenderServer::Stop()
+{
+	if (!m_bListening)
+	{
+		return;
+	}
+
+	// requests Run() did not get to are failed, so no client
+	// thread is left waiting for them
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_bStopping = true;
+		for (auto& pRequest : m_queue)
+		{
+			pRequest->result.set_value({ false, {} });
+		}
+		m_queue.clear();
+	}
+	m_queueChanged.notify_all();
+
+#if defined(_WIN32)
+	// shutting down a listening socket does not wake accept() on
+	// Windows, closing it does
+	g_CloseSocket(m_listenSocket);
+	if (m_acceptor.joinable())
+	{
+		m_acceptor.join();
+	}
+#else
+	g_ShutdownSocket(m_listenSocket);
+	if (m_acceptor.joinable())
+	{
+		m_acceptor.join();
+	}
+	g_CloseSocket(m_listenSocket);
+#endif
+	m_listenSocket = g_InvalidSocket;
+
+	// the client threads are blocked reading their sockets
+	std::list<std::unique_ptr<CLIENT>> clients;
+	{
+		std::lock_guard<std::mutex> lock(m_clientsMutex);
+		clients.swap(m_clients);
+		for (auto& pClient : clients)
+		{
+			g_ShutdownSocket(pClient->socket);
+		}
+	}
+	for (auto& pClient : clients)
+	{
+		pClient->thread.join();
+		g_CloseSocket(pClient->socket);
+	}
+
+	std::remove(m_socketPath.c_str());
+#if defined(_WIN32)
+	WSACleanup();
+#endif
+	m_bListening = false;
+
+	RENDER_SERVER_STATS stats = GetStats();
+	std::cout << "INFO: render server stopped - " << stats.requestsServed << " requests served, "
+		<< stats.requestsFailed << " failed, " << stats.frames << " frames, "
+		<< stats.averageRequestsPerFrame << " requests a frame, "
+		<< stats.imagesPerSecond << " images/s, "
+		<< stats.averageLatencyMilliseconds << "ms average latency, "
+		<< stats.maxQueueDepth << " most requests queued" << std::endl;
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used for reading a snapshot of the server
+ *  counters, from any thread.
+ ***********************************************************/
+RENDER_SERVER_STATS RenderServer::GetStats()
+{
+	uint32_t queueDepth = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		queueDepth = (uint32_t)m_queue.size();
+	}
+	uint32_t clients = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_clientsMutex);
+		for (auto& pClient : m_clients)
+		{
+			clients += pClient->bFinished ? 0 : 1;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	RENDER_SERVER_STATS stats = m_stats;
+	stats.queueDepth = queueDepth;
+	stats.clients = clients;
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+	stats.imagesPerSecond = (seconds > 0.0) ? stats.requestsServed / seconds : 0.0;
+	stats.averageLatencyMilliseconds = (stats.requestsServed > 0) ? m_totalLatencyMilliseconds / stats.requestsServed : 0.0;
+	stats.averageRequestsPerFrame = (stats.frames > 0) ? (double)stats.requestsServed / stats.frames : 0.0;
+	return(stats);
+}
+
+/***********************************************************
+ *  DestroyFramebuffer()
+ *
+ *  This method is used for releasing the shared frame and
+ *  its readback buffers.
+ ***********************************************************/
+void RenderServer::DestroyFramebuffer()
+{
+	m_frame.Destroy();
+	for (int i = 0; i < 2; i++)
+	{
+		m_readbacks[i].Reset();
+		m_readbackBytes[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for rendering the queued requests
+ *  until the server is asked to shut down.  A frame is
+ *  issued before the previous one is resolved, so the wait
+ *  for the GPU only happens once there is nothing more to
+ *  render.
+ ***********************************************************/
+void RenderServer::Run(SceneManager* pScene)
+{
+	if (!m_bListening)
+	{
+		return;
+	}
+	if (!m_frame.IsValid() && !m_frame.Create(FRAME_SIZE, FRAME_SIZE, "render server frame", MemoryTracker::MEMTAG_CAPTURE))
+	{
+		return;
+	}
+
+	std::unique_ptr<PENDING_FRAME> pPending;
+	while (true)
+	{
+		std::unique_ptr<PENDING_FRAME> pFrame(new PENDING_FRAME());
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			if (NULL == pPending)
+			{
+				m_queueChanged.wait(lock, [this]() { return m_bStopping || !m_queue.empty(); });
+			}
+			if (m_bStopping && m_queue.empty() && (NULL == pPending))
+			{
+				break;
+			}
+			TakeFrameRequests(*pFrame);
+		}
+
+		if (!pFrame->requests.empty())
+		{
+			RenderFrame(pScene, *pFrame);
+		}
+		else
+		{
+			pFrame.reset();
+		}
+		if (NULL != pPending)
+		{
+			ResolveFrame(*pPending);
+		}
+		pPending = std::move(pFrame);
+	}
+}
+
+/***********************************************************
+ *  TakeFrameRequests()
+ *
+ *  This method is used for moving the queued requests that
+ *  fit into one shared frame out of the queue.  The slots
+ *  are packed in rows, left to right, and a request for the
+ *  same view as an earlier one reuses its slot.  Called with
+ *  the queue locked.
+ ***********************************************************/
+void RenderServer::TakeFrameRequests(PENDING_FRAME& frame)
+{
+	int rowX = 0;
+	int rowY = 0;
+	int rowHeight = 0;
+	frame.readWidth = 0;
+	frame.readHeight = 0;
+
+	while (!m_queue.empty() && (frame.requests.size() < MAX_FRAME_REQUESTS))
+	{
+		RENDER_REQUEST& request = *m_queue.front();
+
+		uint32_t slot = (uint32_t)frame.slots.size();
+		for (size_t i = 0; i < frame.requests.size(); i++)
+		{
+			const RENDER_REQUEST& other = *frame.requests[i];
+			if (g_SameView(request.pose, request.width, request.height, other.pose, other.width, other.height))
+			{
+				slot = frame.requestSlots[i];
+				break;
+			}
+		}
+
+		if (slot == frame.slots.size())
+		{
+			if (rowX + request.width > FRAME_SIZE)
+			{
+				rowX = 0;
+				rowY += rowHeight;
+				rowHeight = 0;
+			}
+			if (rowY + request.height > FRAME_SIZE)
+			{
+				// the rest waits for the next frame
+				break;
+			}
+			frame.slots.push_back({ rowX, rowY, request.width, request.height });
+			rowX += request.width;
+			rowHeight = std::max(rowHeight, request.height);
+			frame.readWidth = std::max(frame.readWidth, rowX);
+			frame.readHeight = std::max(frame.readHeight, rowY + rowHeight);
+		}
+
+		frame.requestSlots.push_back(slot);
+		frame.requests.push_back(std::move(m_queue.front()));
+		m_queue.pop_front();
+	}
+}
+
+/***********************************************************
+ *  RenderFrame()
+ *
+ *  This method is used for rendering every slot of a shared
+ *  frame into its own viewport, and copying the part of the
+ *  frame they cover into a pixel pack buffer.  The copy
+ *  returns at once, and a fence marks when it is done.
+ ***********************************************************/
+void RenderServer::RenderFrame(SceneManager* pScene, PENDING_FRAME& frame)
+{
+	GL_DEBUG_PUSH_GROUP("render server frame");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_frame.GetFramebuffer());
+	glViewport(0, 0, frame.readWidth, frame.readHeight);
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// the slots are one frame to the render device, so the views
+	// share a region of the uniform ring and one fence
+	pScene->BeginSharedFrame();
+	std::vector<bool> bDrawn(frame.slots.size(), false);
+	for (size_t i = 0; i < frame.requests.size(); i++)
+	{
+		uint32_t slotIndex = frame.requestSlots[i];
+		if (bDrawn[slotIndex])
+		{
+			continue;
+		}
+		bDrawn[slotIndex] = true;
+
+		const RENDER_REQUEST& request = *frame.requests[i];
+		const FRAME_SLOT& slot = frame.slots[slotIndex];
+		glViewport(slot.x, slot.y, slot.width, slot.height);
+		pScene->SetViewProjection(
+			glm::lookAt(request.pose.eye, request.pose.target, glm::vec3(0.0f, 1.0f, 0.0f)),
+			glm::perspective(glm::radians(request.pose.fieldOfViewDegrees), (float)slot.width / (float)slot.height, g_NearPlane, g_FarPlane));
+		pScene->SetFrameTime(request.pose.frameTime);
+		pScene->RenderScene();
+	}
+	pScene->EndSharedFrame();
+
+	// the two readbacks take turns, so the one being resolved
+	// is never written by the next frame
+	uint32_t readbackIndex = m_nextReadback;
+	m_nextReadback = (m_nextReadback + 1) % 2;
+	GLBufferHandle& readback = m_readbacks[readbackIndex];
+	size_t bytes = (size_t)frame.readWidth * frame.readHeight * 4;
+	if (!readback.IsValid() || (m_readbackBytes[readbackIndex] < bytes))
+	{
+		readback = GLBufferHandle::Create("render server readback");
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.GetName());
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+		m_readbackBytes[readbackIndex] = bytes;
+		GLResourceManager::SetMemory(
+			GLResourceManager::GLRES_BUFFER,
+			readback.GetName(),
+			MemoryTracker::MEMTAG_CAPTURE,
+			bytes);
+		GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, readback.GetName(), "render server readback");
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.GetName());
+	}
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, frame.readWidth, frame.readHeight, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	frame.pReadback = &readback;
+	frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	// there is no window swap to submit the fence
+	glFlush();
+
+	GLResourceManager::EndFrame();
+	GL_DEBUG_POP_GROUP();
+
+	static MetricCounter* s_pFrames = Metrics::GetCounter(
+		"shrine_server_frames_total", "Shared frames the render server rendered requests in");
+	s_pFrames->Add();
+
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	m_stats.frames++;
+}
+
+/***********************************************************
+ *  ResolveFrame()
+ *
+ *  This method is used for waiting for a frame's readback,
+ *  cutting every request's pixels out of it with the top row
+ *  first, and handing them to the waiting client threads.
+ ***********************************************************/
+void RenderServer::ResolveFrame(PENDING_FRAME& frame)
+{
+	GLenum result = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (result == GL_TIMEOUT_EXPIRED)
+	{
+		result = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout);
+	}
+	glDeleteSync(frame.fence);
+	frame.fence = NULL;
+
+	size_t bytes = (size_t)frame.readWidth * frame.readHeight * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, frame.pReadback->GetName());
+	const uint32_t* pFrame = (const uint32_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+
+	static MetricHistogram* s_pLatency = Metrics::GetHistogram(
+		"shrine_server_request_latency_seconds", "Time from a render request being queued to its pixels being read back",
+		{ 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0 });
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	double latencyMilliseconds = 0.0;
+	uint64_t served = 0;
+	for (size_t i = 0; i < frame.requests.size(); i++)
+	{
+		RENDER_REQUEST& request = *frame.requests[i];
+		RENDER_RESULT renderResult;
+		renderResult.bRendered = (NULL != pFrame);
+		if (renderResult.bRendered)
+		{
+			const FRAME_SLOT& slot = frame.slots[frame.requestSlots[i]];
+			renderResult.pixels.resize((size_t)slot.width * slot.height);
+			for (int y = 0; y < slot.height; y++)
+			{
+				// the frame was read from the bottom row up
+				const uint32_t* pSource = pFrame + (size_t)(slot.y + slot.height - 1 - y) * frame.readWidth + slot.x;
+				memcpy(&renderResult.pixels[(size_t)y * slot.width], pSource, (size_t)slot.width * 4);
+			}
+			double requestMilliseconds = std::chrono::duration<double, std::milli>(now - request.queued).count();
+			s_pLatency->Observe(requestMilliseconds / 1000.0);
+			latencyMilliseconds += requestMilliseconds;
+			served++;
+		}
+		request.result.set_value(std::move(renderResult));
+	}
+
+	if (NULL != pFrame)
+	{
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else
+	{
+		std::cout << "WARNING: could not map the render server readback" << std::endl;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	static MetricCounter* s_pServed = Metrics::GetCounter(
+		"shrine_server_requests_total", "Render requests answered, by result", "result=\"served\"");
+	static MetricCounter* s_pFailed = Metrics::GetCounter(
+		"shrine_server_requests_total", "Render requests answered, by result", "result=\"failed\"");
+	s_pServed->Add(served);
+	s_pFailed->Add(frame.requests.size() - served);
+
+	std::lock_guard<std::mutex> lock(m_statsMutex);
+	m_stats.requestsServed += served;
+	m_stats.requestsFailed += frame.requests.size() - served;
+	m_totalLatencyMilliseconds += latencyMilliseconds;
+}
+
+/***********************************************************
+ *  AcceptorMain()
+ *
+ *  This method is used for accepting client connections
+ *  and giving each its own thread, until the listening
+ *  socket is shut down.
+ ***********************************************************/
+void RenderServer::AcceptorMain()
+{
+	while (true)
+	{
+		SERVER_SOCKET socket = (SERVER_SOCKET)accept(m_listenSocket, NULL, NULL);
+		if (socket == g_InvalidSocket)
+		{
+			break;
+		}
+
+		std::lock_guard<std::mutex> lock(m_clientsMutex);
+		if (m_bStopping)
+		{
+			g_CloseSocket(socket);
+			break;
+		}
+		RemoveFinishedClients();
+
+		std::unique_ptr<CLIENT> pClient(new CLIENT());
+		pClient->socket = socket;
+		pClient->bFinished = false;
+		pClient->thread = std::thread(&RenderServer::ClientMain, this, pClient.get());
+		m_clients.push_back(std::move(pClient));
+	}
+}
+
+/***********************************************************
+ *  RemoveFinishedClients()
+ *
+ *  This method is used for joining the threads of clients
+ *  that have disconnected, so a server running for weeks
+ *  does not keep one for every connection it ever had.
+ *  Called with the clients locked.
+ ***********************************************************/
+void RenderServer::RemoveFinishedClients()
+{
+	for (auto it = m_clients.begin(); it != m_clients.end();)
+	{
+		if ((*it)->bFinished)
+		{
+			(*it)->thread.join();
+			g_CloseSocket((*it)->socket);
+			it = m_clients.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+/***********************************************************
+ *  ClientMain()
+ *
+ *  This method is used for reading the request lines of one
+ *  client and answering them in order, until the client
+ *  disconnects or the server stops.
+ ***********************************************************/
+void RenderServer::ClientMain(CLIENT* pClient)
+{
+	std::string buffer;
+	char received[4096];
+	bool bOpen = true;
+	while (bOpen)
+	{
+		size_t lineEnd = buffer.find('\n');
+		if (lineEnd == std::string::npos)
+		{
+			if (buffer.size() > g_MaxRequestLine)
+			{
+				g_SendLine(pClient->socket, "ERROR request line too long");
+				break;
+			}
+			int count = (int)recv(pClient->socket, received, sizeof(received), 0);
+			if (count <= 0)
+			{
+				break;
+			}
+			buffer.append(received, count);
+			continue;
+		}
+
+		std::string line = buffer.substr(0, lineEnd);
+		buffer.erase(0, lineEnd + 1);
+		if (!line.empty() && (line.back() == '\r'))
+		{
+			line.pop_back();
+		}
+		if (!line.empty())
+		{
+			bOpen = HandleRequest(pClient->socket, line);
+		}
+	}
+
+	// the client sees the connection end now, and the socket is
+	// closed when the thread is joined
+	g_ShutdownSocket(pClient->socket);
+	pClient->bFinished = true;
+}
+
+/***********************************************************
+ *  HandleRequest()
+ *
+ *  This method is used for answering one request line.  A
+ *  render request waits here, on the client's own thread,
+ *  for its frame to be read back, and its image is encoded
+ *  here as well.
+ ***********************************************************/
+bool RenderServer::HandleRequest(SERVER_SOCKET socket, const std::string& line)
+{
+	std::istringstream stream(line);
+	std::string command;
+	stream >> command;
+
+	if (command == "QUIT")
+	{
+		return(false);
+	}
+	if (command == "SHUTDOWN")
+	{
+		// answered first, since stopping closes the connection
+		g_SendPayload(socket, NULL, 0);
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_bStopping = true;
+		}
+		m_queueChanged.notify_all();
+		return(false);
+	}
+	if (command == "STATS")
+	{
+		RENDER_SERVER_STATS stats = GetStats();
+		std::ostringstream text;
+		text << "requests_served " << stats.requestsServed << "\n"
+			<< "requests_failed " << stats.requestsFailed << "\n"
+			<< "frames " << stats.frames << "\n"
+			<< "clients " << stats.clients << "\n"
+			<< "queue_depth " << stats.queueDepth << "\n"
+			<< "max_queue_depth " << stats.maxQueueDepth << "\n"
+			<< "images_per_second " << stats.imagesPerSecond << "\n"
+			<< "average_latency_ms " << stats.averageLatencyMilliseconds << "\n"
+			<< "requests_per_frame " << stats.averageRequestsPerFrame << "\n";
+		std::string payload = text.str();
+		return(g_SendPayload(socket, payload.data(), payload.size()));
+	}
+	if (command != "RENDER")
+	{
+		return(g_SendLine(socket, "ERROR unknown request " + command));
+	}
+
+	std::unique_ptr<RENDER_REQUEST> pRequest(new RENDER_REQUEST());
+	std::string formatName;
+	BATCH_POSE& pose = pRequest->pose;
+	if (!(stream >> pose.eye.x >> pose.eye.y >> pose.eye.z
+		>> pose.target.x >> pose.target.y >> pose.target.z
+		>> pose.fieldOfViewDegrees >> pRequest->width >> pRequest->height >> formatName))
+	{
+		return(g_SendLine(socket, "ERROR expected RENDER <eye xyz> <target xyz> <fov> <width> <height> <png|rgba> [time]"));
+	}
+	if (!(stream >> pose.frameTime))
+	{
+		pose.frameTime = 0.0;
+	}
+	if ((formatName != "png") && (formatName != "rgba"))
+	{
+		return(g_SendLine(socket, "ERROR unknown format " + formatName));
+	}
+	if ((pRequest->width < 1) || (pRequest->height < 1) ||
+		(pRequest->width > FRAME_SIZE) || (pRequest->height > FRAME_SIZE))
+	{
+		return(g_SendLine(socket, "ERROR the size must be from 1 to " + std::to_string(FRAME_SIZE)));
+	}
+	RENDER_FORMAT format = (formatName == "png") ? RENDER_FORMAT_PNG : RENDER_FORMAT_RGBA;
+	int width = pRequest->width;
+	int height = pRequest->height;
+
+	std::future<RENDER_RESULT> future = pRequest->result.get_future();
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		if (m_bStopping)
+		{
+			return(g_SendLine(socket, "ERROR the server is shutting down"));
+		}
+		pRequest->queued = std::chrono::steady_clock::now();
+		m_queue.push_back(std::move(pRequest));
+
+		std::lock_guard<std::mutex> statsLock(m_statsMutex);
+		m_stats.maxQueueDepth = std::max(m_stats.maxQueueDepth, (uint32_t)m_queue.size());
+	}
+	m_queueChanged.notify_all();
+
+	RENDER_RESULT renderResult = future.get();
+	if (!renderResult.bRendered)
+	{
+		return(g_SendLine(socket, "ERROR the view could not be read back"));
+	}
+	if (format == RENDER_FORMAT_RGBA)
+	{
+		return(g_SendPayload(socket, renderResult.pixels.data(), renderResult.pixels.size() * 4));
+	}
+
+	thread_local std::vector<unsigned char> png;
+	EncodePNGImage(renderResult.pixels.data(), width, height, width, png);
+	return(g_SendPayload(socket, png.data(), png.size()));
+}
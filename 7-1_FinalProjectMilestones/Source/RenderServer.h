@@ -0,0 +1,205 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderserver.h
+// ============
+// serve rendered views of the scene to other processes on the same host
+// over a unix domain socket
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "BatchRenderer.h"
+#include "GLResources.h"
+#include "OffscreenTarget.h"
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+typedef uintptr_t SERVER_SOCKET;
+#else
+typedef int SERVER_SOCKET;
+#endif
+
+/***********************************************************
+ *  RENDER_SERVER_STATS
+ *
+ *  What the server did since it was started.
+ ***********************************************************/
+struct RENDER_SERVER_STATS
+{
+	uint64_t requestsServed;
+	uint64_t requestsFailed;
+	// shared frames the requests were rendered in
+	uint64_t frames;
+	uint32_t clients;
+	// requests waiting to be rendered now, and the most at once
+	uint32_t queueDepth;
+	uint32_t maxQueueDepth;
+	double imagesPerSecond;
+	// from a request being queued to its pixels being read back
+	double averageLatencyMilliseconds;
+	double averageRequestsPerFrame;
+};
+
+/***********************************************************
+ *  RenderServer
+ *
+ *  This class keeps the scene resident and renders views of
+ *  it for local clients.  Every client connection has its
+ *  own thread, which reads the text requests, queues them
+ *  and streams each result back as soon as it is ready.
+ *
+ *  The render thread takes all of the queued requests it can
+ *  fit into one shared frame: each gets its own viewport of
+ *  a large offscreen framebuffer, identical requests share
+ *  one, and the whole frame is read back with a single copy.
+ *  The readback of a frame is only waited for after the next
+ *  frame has been issued, so the GPU and the render thread
+ *  overlap while requests keep arriving.  The client threads
+ *  encode their own images.
+ *
+ *  The protocol is one line a request:
+ *
+ *    RENDER <eye xyz> <target xyz> <fov> <width> <height> <png|rgba> [time]
+ *    STATS
+ *    SHUTDOWN
+ *    QUIT
+ *
+ *  and every answer is either "OK <bytes>" followed by that
+ *  many bytes, or "ERROR <reason>", on a line of its own.  A
+ *  rendered image is a PNG, or raw RGBA8 rows from the top.
+ ***********************************************************/
+class RenderServer
+{
+public:
+	// size of the shared frame - larger requests are refused
+	static const int FRAME_SIZE = 2048;
+	// most requests rendered in one shared frame
+	static const uint32_t MAX_FRAME_REQUESTS = 16;
+
+	// constructor
+	RenderServer();
+	// destructor - stops the server
+	~RenderServer();
+
+	// create the socket and start accepting clients
+	bool Start(const char* socketPath);
+	// render the queued requests until a client sends SHUTDOWN -
+	// call on the thread that owns the OpenGL context
+	void Run(SceneManager* pScene);
+	// close every client and remove the socket
+	void Stop();
+
+	RENDER_SERVER_STATS GetStats();
+
+private:
+	enum RENDER_FORMAT
+	{
+		RENDER_FORMAT_PNG,
+		RENDER_FORMAT_RGBA
+	};
+
+	struct RENDER_RESULT
+	{
+		bool bRendered;
+		std::vector<uint32_t> pixels;
+	};
+
+	struct RENDER_REQUEST
+	{
+		BATCH_POSE pose;
+		int width;
+		int height;
+		std::chrono::steady_clock::time_point queued;
+		std::promise<RENDER_RESULT> result;
+	};
+
+	// where a request was drawn in the shared frame
+	struct FRAME_SLOT
+	{
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	// a shared frame whose readback has been started
+	struct PENDING_FRAME
+	{
+		std::vector<std::unique_ptr<RENDER_REQUEST>> requests;
+		// slot of every request - identical requests share one
+		std::vector<uint32_t> requestSlots;
+		std::vector<FRAME_SLOT> slots;
+		int readWidth;
+		int readHeight;
+		GLBufferHandle* pReadback;
+		GLsync fence;
+	};
+
+	struct CLIENT
+	{
+		SERVER_SOCKET socket;
+		std::thread thread;
+		std::atomic<bool> bFinished;
+	};
+
+	std::string m_socketPath;
+	SERVER_SOCKET m_listenSocket;
+	bool m_bListening;
+	std::thread m_acceptor;
+
+	std::mutex m_clientsMutex;
+	std::list<std::unique_ptr<CLIENT>> m_clients;
+
+	std::mutex m_queueMutex;
+	std::condition_variable m_queueChanged;
+	std::deque<std::unique_ptr<RENDER_REQUEST>> m_queue;
+	// set under the queue mutex, so a wait on the queue never
+	// misses it, and atomic, since the acceptor reads it under
+	// the clients mutex instead
+	std::atomic<bool> m_bStopping;
+
+	// offscreen frame the requests share
+	OffscreenTarget m_frame;
+	// two readbacks, so one frame can be read while the next
+	// renders
+	GLBufferHandle m_readbacks[2];
+	size_t m_readbackBytes[2];
+	uint32_t m_nextReadback;
+
+	std::mutex m_statsMutex;
+	RENDER_SERVER_STATS m_stats;
+	std::chrono::steady_clock::time_point m_startTime;
+	double m_totalLatencyMilliseconds;
+
+	// release the shared frame and its readbacks
+	void DestroyFramebuffer();
+	// take the queued requests that fit into one frame
+	void TakeFrameRequests(PENDING_FRAME& frame);
+	// render the requests of a frame and start its readback
+	void RenderFrame(SceneManager* pScene, PENDING_FRAME& frame);
+	// wait for a frame's readback and hand out the results
+	void ResolveFrame(PENDING_FRAME& frame);
+
+	// accept connections until the server stops
+	void AcceptorMain();
+	// read and answer the requests of one client
+	void ClientMain(CLIENT* pClient);
+	// answer one request line, false to close the connection
+	bool HandleRequest(SERVER_SOCKET socket, const std::string& line);
+	void RemoveFinishedClients();
+};
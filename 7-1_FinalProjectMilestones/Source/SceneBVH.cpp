@@ -0,0 +1,680 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.cpp
+// ============
+// four wide bounding volume hierarchy over the world space
+// triangles of a software scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBVH.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+// four child boxes per test when the build targets SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define BVH_SIMD_SSE
+#endif
+
+// declaration of global variables
+namespace
+{
+	// triangles a leaf holds before splitting is considered
+	const uint32_t g_MinSplitTriangles = 4;
+	// largest leaf kept when no split beats it
+	const uint32_t g_MaxLeafTriangles = 16;
+	// buckets the centroids are sorted into when searching for a split
+	const int g_SplitBinCount = 12;
+	// cost of visiting a node relative to testing one triangle
+	const float g_TraversalCost = 1.0f;
+	// entries on the traversal stack - each wide node adds at most four
+	const int g_MaxStackDepth = 128;
+	// stand-in for a zero direction component, keeps the slab test free of NaNs
+	const float g_MinDirection = 1e-12f;
+
+	// half of the surface area of a box
+	float HalfArea(glm::vec3 boundsMin, glm::vec3 boundsMax)
+	{
+		glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+		return(extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+	}
+
+	// one over a direction component, never infinite
+	float SafeInverse(float value)
+	{
+		if (std::fabs(value) < g_MinDirection)
+		{
+			value = (value < 0.0f) ? -g_MinDirection : g_MinDirection;
+		}
+		return(1.0f / value);
+	}
+
+	double GetElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+}
+
+/***********************************************************
+ *  SceneBVH()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneBVH::SceneBVH()
+{
+	m_buildMilliseconds = 0.0;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for transforming every triangle of
+ *  the scene's draws into world space and building the four
+ *  wide tree over them.  The vertices are moved by the wind
+ *  exactly as the rasterizers move them, so both see the
+ *  same geometry.
+ ***********************************************************/
+void SceneBVH::Build(const SOFTWARE_SCENE& scene)
+{
+	std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+
+	m_triangles.clear();
+	m_attributes.clear();
+	m_nodes.clear();
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	for (uint32_t drawIndex = 0; drawIndex < (uint32_t)scene.draws.size(); drawIndex++)
+	{
+		const SOFTWARE_DRAW& draw = scene.draws[drawIndex];
+		if (draw.instance >= scene.instanceCount)
+		{
+			continue;
+		}
+
+		const INSTANCE_RECORD& instance = scene.pInstances[draw.instance];
+		const SOFTWARE_MESH& mesh = GetSoftwareMesh(draw.mesh);
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(instance.world)));
+		glm::vec3 origin = glm::vec3(instance.world[3]);
+
+		positions.resize(mesh.vertices.size());
+		normals.resize(mesh.vertices.size());
+		uvs.resize(mesh.vertices.size());
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			const SOFTWARE_VERTEX& vertex = mesh.vertices[i];
+			glm::vec3 world = glm::vec3(instance.world * glm::vec4(vertex.position, 1.0f));
+			positions[i] = WindSystem::ApplyWind(scene.wind, world, origin, instance.windStiffness, instance.windPhase);
+			normals[i] = normalMatrix * vertex.normal;
+			uvs[i] = vertex.uv * instance.uvScale;
+		}
+
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			uint32_t a = mesh.indices[i];
+			uint32_t b = mesh.indices[i + 1];
+			uint32_t c = mesh.indices[i + 2];
+
+			BVH_TRIANGLE triangle;
+			triangle.vertex0 = positions[a];
+			triangle.edge1 = positions[b] - positions[a];
+			triangle.edge2 = positions[c] - positions[a];
+			m_triangles.push_back(triangle);
+
+			BVH_ATTRIBUTES attributes;
+			attributes.normals[0] = normals[a];
+			attributes.normals[1] = normals[b];
+			attributes.normals[2] = normals[c];
+			attributes.uvs[0] = uvs[a];
+			attributes.uvs[1] = uvs[b];
+			attributes.uvs[2] = uvs[c];
+			attributes.draw = drawIndex;
+			m_attributes.push_back(attributes);
+		}
+	}
+
+	uint32_t triangleCount = (uint32_t)m_triangles.size();
+	if (triangleCount == 0)
+	{
+		m_buildMilliseconds = GetElapsedMilliseconds(buildStart);
+		return;
+	}
+
+	std::vector<glm::vec3> boundsMin(triangleCount);
+	std::vector<glm::vec3> boundsMax(triangleCount);
+	std::vector<glm::vec3> centroids(triangleCount);
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		const BVH_TRIANGLE& triangle = m_triangles[i];
+		glm::vec3 vertex1 = triangle.vertex0 + triangle.edge1;
+		glm::vec3 vertex2 = triangle.vertex0 + triangle.edge2;
+		boundsMin[i] = glm::min(triangle.vertex0, glm::min(vertex1, vertex2));
+		boundsMax[i] = glm::max(triangle.vertex0, glm::max(vertex1, vertex2));
+		centroids[i] = (boundsMin[i] + boundsMax[i]) * 0.5f;
+	}
+
+	std::vector<BUILD_NODE> buildNodes;
+	std::vector<uint32_t> order(triangleCount);
+	std::iota(order.begin(), order.end(), 0);
+	BuildBinaryTree(buildNodes, order, boundsMin, boundsMax, centroids);
+
+	// a single leaf still needs a wide node above it
+	if (buildNodes[0].count > 0)
+	{
+		WIDE_NODE root = {};
+		root.minX[0] = buildNodes[0].boundsMin.x;
+		root.minY[0] = buildNodes[0].boundsMin.y;
+		root.minZ[0] = buildNodes[0].boundsMin.z;
+		root.maxX[0] = buildNodes[0].boundsMax.x;
+		root.maxY[0] = buildNodes[0].boundsMax.y;
+		root.maxZ[0] = buildNodes[0].boundsMax.z;
+		root.child[0] = 0;
+		root.triangleCount[0] = buildNodes[0].count;
+		root.childCount = 1;
+		m_nodes.push_back(root);
+	}
+	else
+	{
+		CollapseNode(buildNodes, 0);
+	}
+
+	// store the triangles in leaf order so every leaf is one range
+	SceneVector<BVH_TRIANGLE> sortedTriangles(triangleCount);
+	SceneVector<BVH_ATTRIBUTES> sortedAttributes(triangleCount);
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		sortedTriangles[i] = m_triangles[order[i]];
+		sortedAttributes[i] = m_attributes[order[i]];
+	}
+	m_triangles.swap(sortedTriangles);
+	m_attributes.swap(sortedAttributes);
+
+	m_buildMilliseconds = GetElapsedMilliseconds(buildStart);
+}
+
+/***********************************************************
+ *  BuildBinaryTree()
+ *
+ *  This method is used for splitting the triangles into a
+ *  binary tree.  Each node sorts its triangle centroids into
+ *  buckets along its longest axis and splits where the
+ *  surface area heuristic is lowest, or stays a leaf when
+ *  no split is cheaper than testing all of its triangles.
+ ***********************************************************/
+void SceneBVH::BuildBinaryTree(
+	std::vector<BUILD_NODE>& buildNodes,
+	std::vector<uint32_t>& order,
+	const std::vector<glm::vec3>& boundsMin,
+	const std::vector<glm::vec3>& boundsMax,
+	const std::vector<glm::vec3>& centroids) const
+{
+	BUILD_NODE root = {};
+	root.first = 0;
+	root.count = (uint32_t)order.size();
+	buildNodes.push_back(root);
+
+	std::vector<uint32_t> pending;
+	pending.push_back(0);
+	while (!pending.empty())
+	{
+		uint32_t nodeIndex = pending.back();
+		pending.pop_back();
+
+		uint32_t first = buildNodes[nodeIndex].first;
+		uint32_t count = buildNodes[nodeIndex].count;
+		glm::vec3 nodeMin = boundsMin[order[first]];
+		glm::vec3 nodeMax = boundsMax[order[first]];
+		glm::vec3 centroidMin = centroids[order[first]];
+		glm::vec3 centroidMax = centroidMin;
+		for (uint32_t i = first + 1; i < first + count; i++)
+		{
+			uint32_t triangle = order[i];
+			nodeMin = glm::min(nodeMin, boundsMin[triangle]);
+			nodeMax = glm::max(nodeMax, boundsMax[triangle]);
+			centroidMin = glm::min(centroidMin, centroids[triangle]);
+			centroidMax = glm::max(centroidMax, centroids[triangle]);
+		}
+		buildNodes[nodeIndex].boundsMin = nodeMin;
+		buildNodes[nodeIndex].boundsMax = nodeMax;
+
+		if (count <= g_MinSplitTriangles)
+		{
+			continue;
+		}
+
+		glm::vec3 centroidExtent = centroidMax - centroidMin;
+		int axis = 0;
+		if (centroidExtent.y > centroidExtent[axis])
+		{
+			axis = 1;
+		}
+		if (centroidExtent.z > centroidExtent[axis])
+		{
+			axis = 2;
+		}
+
+		uint32_t middle = first;
+		if (centroidExtent[axis] > 0.0f)
+		{
+			// bucket the centroids along the axis
+			uint32_t binCounts[g_SplitBinCount] = {};
+			glm::vec3 binMin[g_SplitBinCount];
+			glm::vec3 binMax[g_SplitBinCount];
+			float binScale = g_SplitBinCount / centroidExtent[axis];
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				uint32_t triangle = order[i];
+				int bin = std::min((int)((centroids[triangle][axis] - centroidMin[axis]) * binScale), g_SplitBinCount - 1);
+				if (binCounts[bin] == 0)
+				{
+					binMin[bin] = boundsMin[triangle];
+					binMax[bin] = boundsMax[triangle];
+				}
+				else
+				{
+					binMin[bin] = glm::min(binMin[bin], boundsMin[triangle]);
+					binMax[bin] = glm::max(binMax[bin], boundsMax[triangle]);
+				}
+				binCounts[bin]++;
+			}
+
+			// area and count left of every split plane, then sweep
+			// back from the right to price each plane
+			float leftArea[g_SplitBinCount - 1];
+			uint32_t leftCount[g_SplitBinCount - 1];
+			glm::vec3 sweepMin = glm::vec3(0.0f);
+			glm::vec3 sweepMax = glm::vec3(0.0f);
+			uint32_t sweepCount = 0;
+			for (int plane = 0; plane < g_SplitBinCount - 1; plane++)
+			{
+				if (binCounts[plane] > 0)
+				{
+					sweepMin = (sweepCount == 0) ? binMin[plane] : glm::min(sweepMin, binMin[plane]);
+					sweepMax = (sweepCount == 0) ? binMax[plane] : glm::max(sweepMax, binMax[plane]);
+					sweepCount += binCounts[plane];
+				}
+				leftArea[plane] = HalfArea(sweepMin, sweepMax);
+				leftCount[plane] = sweepCount;
+			}
+
+			int bestPlane = -1;
+			float bestCost = 0.0f;
+			sweepCount = 0;
+			for (int plane = g_SplitBinCount - 2; plane >= 0; plane--)
+			{
+				int bin = plane + 1;
+				if (binCounts[bin] > 0)
+				{
+					sweepMin = (sweepCount == 0) ? binMin[bin] : glm::min(sweepMin, binMin[bin]);
+					sweepMax = (sweepCount == 0) ? binMax[bin] : glm::max(sweepMax, binMax[bin]);
+					sweepCount += binCounts[bin];
+				}
+				if ((leftCount[plane] == 0) || (sweepCount == 0))
+				{
+					continue;
+				}
+				float cost = leftArea[plane] * leftCount[plane] + HalfArea(sweepMin, sweepMax) * sweepCount;
+				if ((bestPlane < 0) || (cost < bestCost))
+				{
+					bestPlane = plane;
+					bestCost = cost;
+				}
+			}
+
+			// a small node stays a leaf unless a split is cheaper than
+			// testing every one of its triangles
+			float nodeArea = HalfArea(nodeMin, nodeMax);
+			float splitCost = g_TraversalCost + ((nodeArea > 0.0f) ? bestCost / nodeArea : (float)count);
+			if ((count <= g_MaxLeafTriangles) && ((bestPlane < 0) || (splitCost >= (float)count)))
+			{
+				continue;
+			}
+
+			if (bestPlane >= 0)
+			{
+				std::vector<uint32_t>::iterator split = std::partition(
+					order.begin() + first,
+					order.begin() + first + count,
+					[&](uint32_t triangle)
+					{
+						int bin = std::min((int)((centroids[triangle][axis] - centroidMin[axis]) * binScale), g_SplitBinCount - 1);
+						return(bin <= bestPlane);
+					});
+				middle = (uint32_t)(split - order.begin());
+			}
+		}
+
+		// identical centroids or a one sided split fall back to
+		// halving the node by count
+		if ((middle == first) || (middle == first + count))
+		{
+			middle = first + count / 2;
+			std::nth_element(
+				order.begin() + first,
+				order.begin() + middle,
+				order.begin() + first + count,
+				[&](uint32_t a, uint32_t b) { return(centroids[a][axis] < centroids[b][axis]); });
+		}
+
+		BUILD_NODE left = {};
+		left.first = first;
+		left.count = middle - first;
+		BUILD_NODE right = {};
+		right.first = middle;
+		right.count = first + count - middle;
+
+		buildNodes[nodeIndex].left = (uint32_t)buildNodes.size();
+		buildNodes.push_back(left);
+		buildNodes[nodeIndex].right = (uint32_t)buildNodes.size();
+		buildNodes.push_back(right);
+		// an inner node keeps no triangles of its own
+		buildNodes[nodeIndex].count = 0;
+
+		pending.push_back(buildNodes[nodeIndex].left);
+		pending.push_back(buildNodes[nodeIndex].right);
+	}
+}
+
+/***********************************************************
+ *  CollapseNode()
+ *
+ *  This method is used for building the wide node for an
+ *  inner binary node.  The children are opened largest
+ *  first until there are four of them or only leaves are
+ *  left, then each inner child is collapsed the same way.
+ ***********************************************************/
+uint32_t SceneBVH::CollapseNode(const std::vector<BUILD_NODE>& buildNodes, uint32_t buildIndex)
+{
+	uint32_t children[4];
+	uint32_t childCount = 2;
+	children[0] = buildNodes[buildIndex].left;
+	children[1] = buildNodes[buildIndex].right;
+	while (childCount < 4)
+	{
+		int largest = -1;
+		float largestArea = -1.0f;
+		for (uint32_t i = 0; i < childCount; i++)
+		{
+			const BUILD_NODE& child = buildNodes[children[i]];
+			float area = HalfArea(child.boundsMin, child.boundsMax);
+			if ((child.count == 0) && (area > largestArea))
+			{
+				largest = (int)i;
+				largestArea = area;
+			}
+		}
+		if (largest < 0)
+		{
+			break;
+		}
+
+		const BUILD_NODE& opened = buildNodes[children[largest]];
+		children[largest] = opened.left;
+		children[childCount++] = opened.right;
+	}
+
+	uint32_t wideIndex = (uint32_t)m_nodes.size();
+	m_nodes.push_back(WIDE_NODE());
+	WIDE_NODE node = {};
+	node.childCount = childCount;
+	for (uint32_t i = 0; i < childCount; i++)
+	{
+		const BUILD_NODE& child = buildNodes[children[i]];
+		node.minX[i] = child.boundsMin.x;
+		node.minY[i] = child.boundsMin.y;
+		node.minZ[i] = child.boundsMin.z;
+		node.maxX[i] = child.boundsMax.x;
+		node.maxY[i] = child.boundsMax.y;
+		node.maxZ[i] = child.boundsMax.z;
+		if (child.count > 0)
+		{
+			node.child[i] = child.first;
+			node.triangleCount[i] = child.count;
+		}
+		else
+		{
+			node.child[i] = CollapseNode(buildNodes, children[i]);
+			node.triangleCount[i] = 0;
+		}
+	}
+	// the recursion may have moved the node array
+	m_nodes[wideIndex] = node;
+
+	return(wideIndex);
+}
+
+/***********************************************************
+ *  Intersect()
+ *
+ *  This method is used for finding the nearest triangle
+ *  along a ray.
+ ***********************************************************/
+bool SceneBVH::Intersect(glm::vec3 origin, glm::vec3 direction, float maxDistance, BVH_HIT& hit) const
+{
+	return(Traverse(origin, direction, maxDistance, false, hit));
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for shadow rays - the traversal
+ *  stops at the first triangle found.
+ ***********************************************************/
+bool SceneBVH::IsOccluded(glm::vec3 origin, glm::vec3 direction, float maxDistance) const
+{
+	BVH_HIT hit;
+	return(Traverse(origin, direction, maxDistance, true, hit));
+}
+
+/***********************************************************
+ *  Traverse()
+ *
+ *  This method is used for walking the tree front to back.
+ *  Each node tests the ray against its four child boxes at
+ *  once, tests the triangles of the leaves it hits right
+ *  away, and pushes the inner children it hits so the
+ *  nearest one is visited next.  Nodes further away than
+ *  the nearest hit so far are skipped when popped.
+ ***********************************************************/
+bool SceneBVH::Traverse(glm::vec3 origin, glm::vec3 direction, float maxDistance, bool bAnyHit, BVH_HIT& hit) const
+{
+	if (m_nodes.empty())
+	{
+		return(false);
+	}
+
+	struct STACK_ENTRY
+	{
+		uint32_t node;
+		float distance;
+	};
+	STACK_ENTRY stack[g_MaxStackDepth];
+	int stackSize = 0;
+	stack[stackSize++] = { 0, 0.0f };
+
+	glm::vec3 inverseDirection = glm::vec3(
+		SafeInverse(direction.x),
+		SafeInverse(direction.y),
+		SafeInverse(direction.z));
+
+#if defined(BVH_SIMD_SSE)
+	const __m128 originX = _mm_set1_ps(origin.x);
+	const __m128 originY = _mm_set1_ps(origin.y);
+	const __m128 originZ = _mm_set1_ps(origin.z);
+	const __m128 inverseX = _mm_set1_ps(inverseDirection.x);
+	const __m128 inverseY = _mm_set1_ps(inverseDirection.y);
+	const __m128 inverseZ = _mm_set1_ps(inverseDirection.z);
+#endif
+
+	bool bHit = false;
+	hit.distance = maxDistance;
+	while (stackSize > 0)
+	{
+		STACK_ENTRY entry = stack[--stackSize];
+		if (entry.distance > hit.distance)
+		{
+			continue;
+		}
+
+		const WIDE_NODE& node = m_nodes[entry.node];
+		float entryDistances[4];
+		int hitMask = 0;
+
+#if defined(BVH_SIMD_SSE)
+		// slab test of all four boxes
+		__m128 nearX = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), originX), inverseX);
+		__m128 farX = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxX), originX), inverseX);
+		__m128 nearY = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), originY), inverseY);
+		__m128 farY = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxY), originY), inverseY);
+		__m128 nearZ = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), originZ), inverseZ);
+		__m128 farZ = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxZ), originZ), inverseZ);
+
+		__m128 entryTimes = _mm_max_ps(
+			_mm_max_ps(_mm_min_ps(nearX, farX), _mm_min_ps(nearY, farY)),
+			_mm_max_ps(_mm_min_ps(nearZ, farZ), _mm_setzero_ps()));
+		__m128 exitTimes = _mm_min_ps(
+			_mm_min_ps(_mm_max_ps(nearX, farX), _mm_max_ps(nearY, farY)),
+			_mm_min_ps(_mm_max_ps(nearZ, farZ), _mm_set1_ps(hit.distance)));
+
+		hitMask = _mm_movemask_ps(_mm_cmple_ps(entryTimes, exitTimes));
+		_mm_storeu_ps(entryDistances, entryTimes);
+#else
+		for (int i = 0; i < 4; i++)
+		{
+			float nearX = (node.minX[i] - origin.x) * inverseDirection.x;
+			float farX = (node.maxX[i] - origin.x) * inverseDirection.x;
+			float nearY = (node.minY[i] - origin.y) * inverseDirection.y;
+			float farY = (node.maxY[i] - origin.y) * inverseDirection.y;
+			float nearZ = (node.minZ[i] - origin.z) * inverseDirection.z;
+			float farZ = (node.maxZ[i] - origin.z) * inverseDirection.z;
+
+			float entryTime = std::max(
+				std::max(std::min(nearX, farX), std::min(nearY, farY)),
+				std::max(std::min(nearZ, farZ), 0.0f));
+			float exitTime = std::min(
+				std::min(std::max(nearX, farX), std::max(nearY, farY)),
+				std::min(std::max(nearZ, farZ), hit.distance));
+
+			entryDistances[i] = entryTime;
+			if (entryTime <= exitTime)
+			{
+				hitMask |= 1 << i;
+			}
+		}
+#endif
+		// the unused slots hold empty boxes at the origin
+		hitMask &= (1 << node.childCount) - 1;
+
+		STACK_ENTRY innerChildren[4];
+		int innerCount = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			if ((hitMask & (1 << i)) == 0)
+			{
+				continue;
+			}
+
+			if (node.triangleCount[i] > 0)
+			{
+				if (IntersectLeaf(node.child[i], node.triangleCount[i], origin, direction, hit))
+				{
+					bHit = true;
+					if (bAnyHit)
+					{
+						return(true);
+					}
+				}
+			}
+			else
+			{
+				innerChildren[innerCount++] = { node.child[i], entryDistances[i] };
+			}
+		}
+
+		// push the furthest first so the nearest is popped next
+		std::sort(innerChildren, innerChildren + innerCount,
+			[](const STACK_ENTRY& a, const STACK_ENTRY& b) { return(a.distance > b.distance); });
+		for (int i = 0; (i < innerCount) && (stackSize < g_MaxStackDepth); i++)
+		{
+			stack[stackSize++] = innerChildren[i];
+		}
+	}
+
+	return(bHit);
+}
+
+/***********************************************************
+ *  IntersectLeaf()
+ *
+ *  This method is used for testing the ray against a range
+ *  of triangles, keeping the nearest hit closer than the
+ *  current hit distance.
+ ***********************************************************/
+bool SceneBVH::IntersectLeaf(uint32_t first, uint32_t count, glm::vec3 origin, glm::vec3 direction, BVH_HIT& hit) const
+{
+	bool bHit = false;
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		const BVH_TRIANGLE& triangle = m_triangles[i];
+
+		glm::vec3 p = glm::cross(direction, triangle.edge2);
+		float determinant = glm::dot(triangle.edge1, p);
+		if (std::fabs(determinant) < 1e-12f)
+		{
+			continue;
+		}
+		float inverseDeterminant = 1.0f / determinant;
+
+		glm::vec3 t = origin - triangle.vertex0;
+		float u = glm::dot(t, p) * inverseDeterminant;
+		if ((u < 0.0f) || (u > 1.0f))
+		{
+			continue;
+		}
+
+		glm::vec3 q = glm::cross(t, triangle.edge1);
+		float v = glm::dot(direction, q) * inverseDeterminant;
+		if ((v < 0.0f) || (u + v > 1.0f))
+		{
+			continue;
+		}
+
+		float distance = glm::dot(triangle.edge2, q) * inverseDeterminant;
+		if ((distance > 0.0f) && (distance < hit.distance))
+		{
+			hit.distance = distance;
+			hit.triangle = i;
+			hit.u = u;
+			hit.v = v;
+			bHit = true;
+		}
+	}
+	return(bHit);
+}
+
+/***********************************************************
+ *  GetSurface()
+ *
+ *  This method is used for interpolating the position,
+ *  normal and texture coordinate at a hit.
+ ***********************************************************/
+BVH_SURFACE SceneBVH::GetSurface(const BVH_HIT& hit) const
+{
+	const BVH_TRIANGLE& triangle = m_triangles[hit.triangle];
+	const BVH_ATTRIBUTES& attributes = m_attributes[hit.triangle];
+	float w = 1.0f - hit.u - hit.v;
+
+	BVH_SURFACE surface;
+	surface.position = triangle.vertex0 + triangle.edge1 * hit.u + triangle.edge2 * hit.v;
+	surface.geometricNormal = glm::normalize(glm::cross(triangle.edge1, triangle.edge2));
+	glm::vec3 normal = attributes.normals[0] * w + attributes.normals[1] * hit.u + attributes.normals[2] * hit.v;
+	float normalLength = glm::length(normal);
+	surface.normal = (normalLength > 0.0f) ? normal / normalLength : surface.geometricNormal;
+	surface.uv = attributes.uvs[0] * w + attributes.uvs[1] * hit.u + attributes.uvs[2] * hit.v;
+	surface.draw = attributes.draw;
+	return(surface);
+}
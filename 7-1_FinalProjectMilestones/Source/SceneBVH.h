@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.h
+// ============
+// four wide bounding volume hierarchy over the world space
+// triangles of a software scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneEntities.h"
+#include "SoftwareScene.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  BVH_HIT / BVH_SURFACE
+ *
+ *  The nearest triangle a ray hit, and the interpolated
+ *  surface at that point.
+ ***********************************************************/
+struct BVH_HIT
+{
+	float distance;
+	uint32_t triangle;
+	// barycentric weights of the second and third vertex
+	float u;
+	float v;
+};
+
+struct BVH_SURFACE
+{
+	glm::vec3 position;
+	// interpolated vertex normal, normalized
+	glm::vec3 normal;
+	// face normal from the winding, normalized
+	glm::vec3 geometricNormal;
+	// texture coordinate scaled by the instance
+	glm::vec2 uv;
+	// index into the scene's draws
+	uint32_t draw;
+};
+
+/***********************************************************
+ *  SceneBVH
+ *
+ *  This class keeps every triangle of a software scene in
+ *  world space, with the instance transforms and the wind
+ *  already applied, in a bounding volume hierarchy for ray
+ *  queries.  The tree is built as a binary tree with the
+ *  surface area heuristic, then collapsed into nodes with
+ *  four children each, so one ray tests all four child
+ *  boxes at once with SIMD.
+ ***********************************************************/
+class SceneBVH
+{
+public:
+	// constructor
+	SceneBVH();
+
+	// rebuild the tree over the draws of the scene
+	void Build(const SOFTWARE_SCENE& scene);
+
+	// find the nearest triangle along the ray closer than maxDistance
+	bool Intersect(glm::vec3 origin, glm::vec3 direction, float maxDistance, BVH_HIT& hit) const;
+	// whether any triangle lies along the ray closer than maxDistance
+	bool IsOccluded(glm::vec3 origin, glm::vec3 direction, float maxDistance) const;
+	// the interpolated surface at a hit
+	BVH_SURFACE GetSurface(const BVH_HIT& hit) const;
+
+	size_t GetTriangleCount() const { return m_triangles.size(); }
+	size_t GetNodeCount() const { return m_nodes.size(); }
+	double GetBuildMilliseconds() const { return m_buildMilliseconds; }
+
+private:
+	// one triangle ready for the intersection test
+	struct BVH_TRIANGLE
+	{
+		glm::vec3 vertex0;
+		glm::vec3 edge1;
+		glm::vec3 edge2;
+	};
+
+	// what the surface lookup needs about one triangle
+	struct BVH_ATTRIBUTES
+	{
+		glm::vec3 normals[3];
+		glm::vec2 uvs[3];
+		uint32_t draw;
+	};
+
+	// node of the binary tree the four wide tree is made from
+	struct BUILD_NODE
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// children of an inner node, or the triangles of a leaf
+		uint32_t left;
+		uint32_t right;
+		uint32_t first;
+		uint32_t count;
+	};
+
+	// node of the four wide tree - the child boxes are stored
+	// component by component so four of them load as one vector
+	struct WIDE_NODE
+	{
+		float minX[4];
+		float minY[4];
+		float minZ[4];
+		float maxX[4];
+		float maxY[4];
+		float maxZ[4];
+		// node index of an inner child, first triangle of a leaf
+		uint32_t child[4];
+		// triangles of a leaf child, zero for an inner child
+		uint32_t triangleCount[4];
+		// children in use - they always fill the first slots
+		uint32_t childCount;
+	};
+
+	SceneVector<BVH_TRIANGLE> m_triangles;
+	SceneVector<BVH_ATTRIBUTES> m_attributes;
+	SceneVector<WIDE_NODE> m_nodes;
+	double m_buildMilliseconds;
+
+	// split the triangles into a binary tree
+	void BuildBinaryTree(
+		std::vector<BUILD_NODE>& buildNodes,
+		std::vector<uint32_t>& order,
+		const std::vector<glm::vec3>& boundsMin,
+		const std::vector<glm::vec3>& boundsMax,
+		const std::vector<glm::vec3>& centroids) const;
+	// turn a binary node and up to three levels below it into one wide node
+	uint32_t CollapseNode(const std::vector<BUILD_NODE>& buildNodes, uint32_t buildIndex);
+	// test the ray against the triangles of a leaf
+	bool IntersectLeaf(uint32_t first, uint32_t count, glm::vec3 origin, glm::vec3 direction, BVH_HIT& hit) const;
+	// shared traversal of Intersect() and IsOccluded()
+	bool Traverse(glm::vec3 origin, glm::vec3 direction, float maxDistance, bool bAnyHit, BVH_HIT& hit) const;
+};
@@ -0,0 +1,242 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebuffers.cpp
+// ============
+// GPU copies of the scene instance, material and light data
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBuffers.h"
+#include "GLDebug.h"
+
+#include <algorithm>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// dirty ranges closer than this are uploaded as one range,
+	// since a few extra bytes cost less than another call
+	const size_t g_MergeGapBytes = 256;
+	// smallest number of elements a buffer is created with
+	const size_t g_MinimumCapacity = 64;
+}
+
+/***********************************************************
+ *  GPUArrayBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GPUArrayBuffer::GPUArrayBuffer(size_t elementSize, const std::string& label)
+{
+	m_elementSize = elementSize;
+	m_count = 0;
+	m_capacity = 0;
+	m_label = label;
+	m_lastFlushBytes = 0;
+	m_lastFlushRanges = 0;
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for changing the number of elements.
+ *  Shrinking only drops the elements at the end, so nothing
+ *  is uploaded for it.
+ ***********************************************************/
+void GPUArrayBuffer::Resize(size_t count)
+{
+	size_t oldCount = m_count;
+	m_shadow.resize(count * m_elementSize, 0);
+	m_count = count;
+
+	if (count > oldCount)
+	{
+		MarkDirty(oldCount, count);
+	}
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for copying one element into the
+ *  shadow copy and marking it for upload.
+ ***********************************************************/
+void GPUArrayBuffer::Write(size_t index, const void* pData)
+{
+	if (index >= m_count)
+	{
+		return;
+	}
+
+	memcpy(&m_shadow[index * m_elementSize], pData, m_elementSize);
+	MarkDirty(index, index + 1);
+}
+
+/***********************************************************
+ *  Move()
+ *
+ *  This method is used for copying one element over another
+ *  and marking the destination for upload.
+ ***********************************************************/
+void GPUArrayBuffer::Move(size_t from, size_t to)
+{
+	if ((from >= m_count) || (to >= m_count) || (from == to))
+	{
+		return;
+	}
+
+	memcpy(&m_shadow[to * m_elementSize], &m_shadow[from * m_elementSize], m_elementSize);
+	MarkDirty(to, to + 1);
+}
+
+/***********************************************************
+ *  Read()
+ *
+ *  This method is used for getting one element from the
+ *  shadow copy, or NULL if the index is out of range.
+ ***********************************************************/
+const void* GPUArrayBuffer::Read(size_t index) const
+{
+	if (index >= m_count)
+	{
+		return(NULL);
+	}
+	return(&m_shadow[index * m_elementSize]);
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used for recording a range of elements
+ *  that needs uploading.  Consecutive writes extend the last
+ *  range instead of adding a new one.
+ ***********************************************************/
+void GPUArrayBuffer::MarkDirty(size_t begin, size_t end)
+{
+	if (!m_dirtyRanges.empty())
+	{
+		DIRTY_RANGE& last = m_dirtyRanges.back();
+		if ((begin <= last.end) && (end >= last.begin))
+		{
+			last.begin = std::min(last.begin, begin);
+			last.end = std::max(last.end, end);
+			return;
+		}
+	}
+
+	DIRTY_RANGE range;
+	range.begin = begin;
+	range.end = end;
+	m_dirtyRanges.push_back(range);
+}
+
+/***********************************************************
+ *  GrowBuffer()
+ *
+ *  This method is used for replacing the GPU buffer with a
+ *  larger one.  The elements already on the GPU are copied
+ *  across with glCopyBufferSubData and the old buffer goes
+ *  to the deferred deletion queue.
+ ***********************************************************/
+void GPUArrayBuffer::GrowBuffer()
+{
+	size_t capacity = std::max(std::max(m_capacity * 2, m_count), g_MinimumCapacity);
+
+	GLBufferHandle buffer = GLBufferHandle::Create(m_label);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.GetName());
+	glBufferData(GL_COPY_WRITE_BUFFER, capacity * m_elementSize, NULL, GL_DYNAMIC_DRAW);
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, buffer.GetName(), m_label.c_str());
+	GLResourceManager::SetMemory(
+		GLResourceManager::GLRES_BUFFER,
+		buffer.GetName(),
+		MemoryTracker::MEMTAG_SCENE,
+		capacity * m_elementSize);
+
+	if (m_buffer.IsValid())
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, m_buffer.GetName());
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_capacity * m_elementSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	m_buffer = std::move(buffer);
+	m_capacity = capacity;
+}
+
+/***********************************************************
+ *  Flush()
+ *
+ *  This method is used for uploading the dirty ranges.  The
+ *  ranges are sorted and merged first so each contiguous run
+ *  of changed elements is a single glBufferSubData call.
+ ***********************************************************/
+void GPUArrayBuffer::Flush()
+{
+	m_lastFlushBytes = 0;
+	m_lastFlushRanges = 0;
+
+	if ((m_count > m_capacity) || !m_buffer.IsValid())
+	{
+		GrowBuffer();
+	}
+
+	if (m_dirtyRanges.empty())
+	{
+		return;
+	}
+
+	std::sort(m_dirtyRanges.begin(), m_dirtyRanges.end(),
+		[](const DIRTY_RANGE& a, const DIRTY_RANGE& b) { return a.begin < b.begin; });
+
+	size_t mergeGap = g_MergeGapBytes / m_elementSize;
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer.GetName());
+
+	size_t index = 0;
+	while (index < m_dirtyRanges.size())
+	{
+		size_t begin = m_dirtyRanges[index].begin;
+		size_t end = m_dirtyRanges[index].end;
+		index++;
+
+		while ((index < m_dirtyRanges.size()) && (m_dirtyRanges[index].begin <= end + mergeGap))
+		{
+			end = std::max(end, m_dirtyRanges[index].end);
+			index++;
+		}
+
+		// elements dropped by a shrink since they were written
+		end = std::min(end, m_count);
+		if (begin >= end)
+		{
+			continue;
+		}
+
+		glBufferSubData(
+			GL_COPY_WRITE_BUFFER,
+			begin * m_elementSize,
+			(end - begin) * m_elementSize,
+			&m_shadow[begin * m_elementSize]);
+
+		m_lastFlushBytes += (end - begin) * m_elementSize;
+		m_lastFlushRanges++;
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	m_dirtyRanges.clear();
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the buffer to a shader
+ *  storage binding point.
+ ***********************************************************/
+void GPUArrayBuffer::Bind(GLuint bindingPoint) const
+{
+	if (m_buffer.IsValid())
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bindingPoint, m_buffer.GetName());
+	}
+}
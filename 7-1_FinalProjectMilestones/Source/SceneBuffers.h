@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebuffers.h
+// ============
+// GPU copies of the scene instance, material and light data
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLResources.h"
+#include "MemoryTracker.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// shader storage binding points used by the scene shaders
+enum SCENE_BUFFER_BINDING
+{
+	SCENE_BINDING_INSTANCES = 0,
+	SCENE_BINDING_MATERIALS = 1,
+	SCENE_BINDING_LIGHTS = 2
+};
+
+// uniform block binding points used by the scene shaders - the
+// wind block uses binding 0
+enum SCENE_UNIFORM_BINDING
+{
+	SCENE_BINDING_FRAME = 1,
+	SCENE_BINDING_DRAW = 2
+};
+
+// texture units the scene textures are bound to - matches the
+// size of objectTextures in Shaders/sceneFragment.glsl
+const int SCENE_TEXTURE_SLOTS = 16;
+
+/***********************************************************
+ *  INSTANCE_RECORD
+ *
+ *  Per-object data read by the vertex and fragment shaders.
+ *  The layout matches the std430 INSTANCE struct in
+ *  Shaders/sceneVertex.glsl.
+ ***********************************************************/
+struct INSTANCE_RECORD
+{
+	glm::mat4 world;
+	glm::vec4 color;
+	glm::vec2 uvScale;
+	int32_t materialIndex;
+	// how much the wind bends the instance - 0 for rigid objects
+	float windStiffness;
+	// sway phase offset in radians
+	float windPhase;
+	float reserved[3];
+};
+
+/***********************************************************
+ *  MATERIAL_RECORD
+ *
+ *  One material as read by the fragment shader.
+ ***********************************************************/
+struct MATERIAL_RECORD
+{
+	glm::vec3 ambientColor;
+	float ambientStrength;
+	glm::vec3 diffuseColor;
+	float shininess;
+	glm::vec3 specularColor;
+	float reserved;
+};
+
+/***********************************************************
+ *  LIGHT_RECORD
+ *
+ *  One light source as read by the fragment shader.
+ ***********************************************************/
+struct LIGHT_RECORD
+{
+	glm::vec3 position;
+	float focalStrength;
+	glm::vec3 ambientColor;
+	float specularIntensity;
+	glm::vec3 diffuseColor;
+	float reserved0;
+	glm::vec3 specularColor;
+	float reserved1;
+};
+
+/***********************************************************
+ *  FRAME_CONSTANTS / DRAW_CONSTANTS
+ *
+ *  The per-frame and per-draw uniform blocks of the scene
+ *  shaders, written into the uniform ring.  The layouts
+ *  match the std140 FrameBlock and DrawBlock.
+ ***********************************************************/
+struct FRAME_CONSTANTS
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	// w is unused
+	glm::vec4 viewPosition;
+	int32_t bUseLighting;
+	int32_t lightCount;
+	int32_t reserved[2];
+};
+
+struct DRAW_CONSTANTS
+{
+	// record of the first instance the draw reads
+	int32_t instanceBase;
+	// texture unit to sample, or -1 for the instance color
+	int32_t textureSlot;
+	int32_t reserved[2];
+};
+
+static_assert(sizeof(FRAME_CONSTANTS) == 160, "FRAME_CONSTANTS must match the std140 shader layout");
+static_assert(sizeof(DRAW_CONSTANTS) == 16, "DRAW_CONSTANTS must match the std140 shader layout");
+static_assert(sizeof(INSTANCE_RECORD) == 112, "INSTANCE_RECORD must match the std430 shader layout");
+static_assert(sizeof(MATERIAL_RECORD) == 48, "MATERIAL_RECORD must match the std430 shader layout");
+static_assert(sizeof(LIGHT_RECORD) == 64, "LIGHT_RECORD must match the std430 shader layout");
+
+/***********************************************************
+ *  GPUArrayBuffer
+ *
+ *  This class keeps an array of fixed size records in a CPU
+ *  shadow copy and a shader storage buffer.  Writes only
+ *  change the shadow copy and record the dirty element
+ *  range; Flush() merges the ranges and uploads just those
+ *  bytes.  When the array outgrows the buffer, a larger one
+ *  is created and the old contents are copied on the GPU,
+ *  so growing never re-uploads the existing records.
+ ***********************************************************/
+class GPUArrayBuffer
+{
+public:
+	// constructor
+	GPUArrayBuffer(size_t elementSize, const std::string& label);
+
+	// change the number of elements - new elements are zeroed
+	// and marked dirty
+	void Resize(size_t count);
+	size_t GetCount() const { return m_count; }
+
+	// copy one element into the shadow copy and mark it dirty
+	void Write(size_t index, const void* pData);
+	// copy one element over another, as used by swap-removes
+	void Move(size_t from, size_t to);
+	// read back one element from the shadow copy
+	const void* Read(size_t index) const;
+
+	// upload the dirty ranges - call once per frame
+	void Flush();
+	// forget the dirty ranges without uploading them, for the
+	// software renderers that read the shadow copy directly
+	void DiscardChanges() { m_dirtyRanges.clear(); }
+	// whether any element was written since the last flush or discard
+	bool HasChanges() const { return !m_dirtyRanges.empty(); }
+	// bind the buffer to a shader storage binding point
+	void Bind(GLuint bindingPoint) const;
+
+	// upload statistics of the last flush
+	size_t GetLastFlushBytes() const { return m_lastFlushBytes; }
+	size_t GetLastFlushRanges() const { return m_lastFlushRanges; }
+
+private:
+	struct DIRTY_RANGE
+	{
+		size_t begin;
+		size_t end;
+	};
+
+	size_t m_elementSize;
+	size_t m_count;
+	// number of elements the GPU buffer has room for
+	size_t m_capacity;
+	std::string m_label;
+	std::vector<uint8_t, TrackedAllocator<uint8_t, MemoryTracker::MEMTAG_SCENE>> m_shadow;
+	std::vector<DIRTY_RANGE> m_dirtyRanges;
+	GLBufferHandle m_buffer;
+	size_t m_lastFlushBytes;
+	size_t m_lastFlushRanges;
+
+	// mark a range of elements as needing upload
+	void MarkDirty(size_t begin, size_t end);
+	// make the GPU buffer large enough for every element
+	void GrowBuffer();
+};
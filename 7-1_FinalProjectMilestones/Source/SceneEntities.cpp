@@ -0,0 +1,704 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneentities.cpp
+// ============
+// store scene objects as entities with structure-of-arrays components
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneEntities.h"
+#include "JobSystem.h"
+#include "StaticScene.h"
+#include "WindSystem.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// number of entities each job processes
+	const size_t g_EntityBatchSize = 256;
+
+	// build the sort key that groups packets by mesh, then
+	// texture, then material
+	uint32_t MakeSortKey(uint32_t mesh, int textureSlot, int materialIndex)
+	{
+		return((mesh << 24) |
+			(((uint32_t)(textureSlot + 1) & 0xFF) << 16) |
+			((uint32_t)(materialIndex + 1) & 0xFFFF));
+	}
+}
+
+/***********************************************************
+ *  EntityStore()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+EntityStore::EntityStore()
+{
+	m_bTransformsDirty = false;
+	m_instanceBase = 0;
+}
+
+/***********************************************************
+ *  GetMeshRadius()
+ *
+ *  This method is used for getting the bounding sphere
+ *  radius of the passed in unit sized basic mesh, or of an
+ *  imported mesh around its model origin.
+ ***********************************************************/
+float EntityStore::GetMeshRadius(SCENE_MESH mesh) const
+{
+	if ((mesh >= SCENE_MESH_COUNT) && ((size_t)(mesh - SCENE_MESH_COUNT) < m_importedMeshRadii.size()))
+	{
+		return(m_importedMeshRadii[mesh - SCENE_MESH_COUNT]);
+	}
+	return(GetStaticMeshRadius(mesh));
+}
+
+/***********************************************************
+ *  SetMeshRadius()
+ *
+ *  This method is used for setting the bounding sphere
+ *  radius of an imported mesh, before any entity uses it.
+ ***********************************************************/
+void EntityStore::SetMeshRadius(SCENE_MESH mesh, float radius)
+{
+	if (mesh < SCENE_MESH_COUNT)
+	{
+		return;
+	}
+	size_t index = (size_t)(mesh - SCENE_MESH_COUNT);
+	if (index >= m_importedMeshRadii.size())
+	{
+		m_importedMeshRadii.resize(index + 1, 1.0f);
+	}
+	m_importedMeshRadii[index] = radius;
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for reserving room in every
+ *  component array for the passed in number of entities.
+ ***********************************************************/
+void EntityStore::Reserve(size_t count)
+{
+	m_positionX.reserve(count); m_positionY.reserve(count); m_positionZ.reserve(count);
+	m_scaleX.reserve(count); m_scaleY.reserve(count); m_scaleZ.reserve(count);
+	m_rotationX.reserve(count); m_rotationY.reserve(count); m_rotationZ.reserve(count);
+	m_worldMatrices.reserve(count);
+	m_transformDirty.reserve(count);
+	m_boundsX.reserve(count); m_boundsY.reserve(count); m_boundsZ.reserve(count); m_boundsRadius.reserve(count);
+	m_meshes.reserve(count);
+	m_colors.reserve(count);
+	m_uvScales.reserve(count);
+	m_textureSlots.reserve(count);
+	m_materialIndexes.reserve(count);
+	m_windStiffness.reserve(count);
+	m_windPhases.reserve(count);
+	m_hidden.reserve(count);
+	m_visible.reserve(count);
+	m_instanceDirty.reserve(count);
+	m_entityOfIndex.reserve(count);
+	m_indexOfEntity.reserve(count);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for destroying every entity.
+ ***********************************************************/
+void EntityStore::Clear()
+{
+	while (!m_entityOfIndex.empty())
+	{
+		PopComponents();
+	}
+	m_indexOfEntity.clear();
+	m_freeEntities.clear();
+	m_dirtyInstances.clear();
+	m_bTransformsDirty = false;
+}
+
+/***********************************************************
+ *  CreateEntity()
+ *
+ *  This method is used for creating a new entity and
+ *  appending its components to the end of the arrays.
+ ***********************************************************/
+EntityID EntityStore::CreateEntity(const ENTITY_DESC& desc)
+{
+	EntityID entity;
+	uint32_t index = (uint32_t)m_entityOfIndex.size();
+
+	// reuse the ID of a destroyed entity when one is available
+	if (!m_freeEntities.empty())
+	{
+		entity = m_freeEntities.back();
+		m_freeEntities.pop_back();
+		m_indexOfEntity[entity] = index;
+	}
+	else
+	{
+		entity = (EntityID)m_indexOfEntity.size();
+		m_indexOfEntity.push_back(index);
+	}
+	m_entityOfIndex.push_back(entity);
+
+	m_positionX.push_back(desc.position.x);
+	m_positionY.push_back(desc.position.y);
+	m_positionZ.push_back(desc.position.z);
+	m_scaleX.push_back(desc.scale.x);
+	m_scaleY.push_back(desc.scale.y);
+	m_scaleZ.push_back(desc.scale.z);
+	m_rotationX.push_back(desc.rotationDegrees.x);
+	m_rotationY.push_back(desc.rotationDegrees.y);
+	m_rotationZ.push_back(desc.rotationDegrees.z);
+	m_worldMatrices.push_back(glm::mat4(1.0f));
+	m_transformDirty.push_back(1);
+	m_boundsX.push_back(desc.position.x);
+	m_boundsY.push_back(desc.position.y);
+	m_boundsZ.push_back(desc.position.z);
+	m_boundsRadius.push_back(0.0f);
+	m_meshes.push_back((uint8_t)desc.mesh);
+	m_colors.push_back(desc.color);
+	m_uvScales.push_back(desc.uvScale);
+	m_textureSlots.push_back(desc.textureSlot);
+	m_materialIndexes.push_back(desc.materialIndex);
+	m_windStiffness.push_back(desc.windStiffness);
+	m_windPhases.push_back(WindSystem::GetInstancePhase(desc.position));
+	m_hidden.push_back(0);
+	m_visible.push_back(1);
+	m_instanceDirty.push_back(0);
+
+	m_bTransformsDirty = true;
+	MarkInstanceDirty(index);
+
+	return(entity);
+}
+
+/***********************************************************
+ *  DestroyEntity()
+ *
+ *  This method is used for destroying an entity.  The last
+ *  entity is moved into its slot so the arrays stay dense.
+ ***********************************************************/
+bool EntityStore::DestroyEntity(EntityID entity)
+{
+	int64_t index = GetIndex(entity);
+	if (index < 0)
+	{
+		return(false);
+	}
+
+	size_t lastIndex = m_entityOfIndex.size() - 1;
+	if ((size_t)index != lastIndex)
+	{
+		MoveComponents(lastIndex, (size_t)index);
+		EntityID movedEntity = m_entityOfIndex[lastIndex];
+		m_entityOfIndex[(size_t)index] = movedEntity;
+		m_indexOfEntity[movedEntity] = (uint32_t)index;
+		// only the moved record changes - the buffer just shrinks
+		MarkInstanceDirty((size_t)index);
+	}
+	PopComponents();
+
+	m_indexOfEntity[entity] = INVALID_ENTITY;
+	m_freeEntities.push_back(entity);
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsAlive()
+ *
+ *  This method is used for checking whether an entity
+ *  exists in the store.
+ ***********************************************************/
+bool EntityStore::IsAlive(EntityID entity) const
+{
+	return(GetIndex(entity) >= 0);
+}
+
+/***********************************************************
+ *  GetIndex()
+ *
+ *  This method is used for getting the array index of the
+ *  components of an entity.
+ ***********************************************************/
+int64_t EntityStore::GetIndex(EntityID entity) const
+{
+	if ((entity >= m_indexOfEntity.size()) || (m_indexOfEntity[entity] == INVALID_ENTITY))
+	{
+		return(-1);
+	}
+	return((int64_t)m_indexOfEntity[entity]);
+}
+
+/***********************************************************
+ *  MoveComponents()
+ *
+ *  This method is used for copying every component at one
+ *  array index over the components at another.
+ ***********************************************************/
+void EntityStore::MoveComponents(size_t from, size_t to)
+{
+	m_positionX[to] = m_positionX[from];
+	m_positionY[to] = m_positionY[from];
+	m_positionZ[to] = m_positionZ[from];
+	m_scaleX[to] = m_scaleX[from];
+	m_scaleY[to] = m_scaleY[from];
+	m_scaleZ[to] = m_scaleZ[from];
+	m_rotationX[to] = m_rotationX[from];
+	m_rotationY[to] = m_rotationY[from];
+	m_rotationZ[to] = m_rotationZ[from];
+	m_worldMatrices[to] = m_worldMatrices[from];
+	m_transformDirty[to] = m_transformDirty[from];
+	m_boundsX[to] = m_boundsX[from];
+	m_boundsY[to] = m_boundsY[from];
+	m_boundsZ[to] = m_boundsZ[from];
+	m_boundsRadius[to] = m_boundsRadius[from];
+	m_meshes[to] = m_meshes[from];
+	m_colors[to] = m_colors[from];
+	m_uvScales[to] = m_uvScales[from];
+	m_textureSlots[to] = m_textureSlots[from];
+	m_materialIndexes[to] = m_materialIndexes[from];
+	m_windStiffness[to] = m_windStiffness[from];
+	m_windPhases[to] = m_windPhases[from];
+	m_hidden[to] = m_hidden[from];
+	m_visible[to] = m_visible[from];
+}
+
+/***********************************************************
+ *  PopComponents()
+ *
+ *  This method is used for removing the components at the
+ *  end of every array.
+ ***********************************************************/
+void EntityStore::PopComponents()
+{
+	m_positionX.pop_back(); m_positionY.pop_back(); m_positionZ.pop_back();
+	m_scaleX.pop_back(); m_scaleY.pop_back(); m_scaleZ.pop_back();
+	m_rotationX.pop_back(); m_rotationY.pop_back(); m_rotationZ.pop_back();
+	m_worldMatrices.pop_back();
+	m_transformDirty.pop_back();
+	m_boundsX.pop_back(); m_boundsY.pop_back(); m_boundsZ.pop_back(); m_boundsRadius.pop_back();
+	m_meshes.pop_back();
+	m_colors.pop_back();
+	m_uvScales.pop_back();
+	m_textureSlots.pop_back();
+	m_materialIndexes.pop_back();
+	m_windStiffness.pop_back();
+	m_windPhases.pop_back();
+	m_hidden.pop_back();
+	m_visible.pop_back();
+	m_instanceDirty.pop_back();
+	m_entityOfIndex.pop_back();
+}
+
+/***********************************************************
+ *  SetTransform()
+ *
+ *  This method is used for changing the transform of an
+ *  entity.  The world matrix is rebuilt by the transform
+ *  system on the next update.
+ ***********************************************************/
+void EntityStore::SetTransform(EntityID entity, glm::vec3 scale, glm::vec3 rotationDegrees, glm::vec3 position)
+{
+	int64_t index = GetIndex(entity);
+	if (index < 0)
+	{
+		return;
+	}
+
+	m_scaleX[index] = scale.x;
+	m_scaleY[index] = scale.y;
+	m_scaleZ[index] = scale.z;
+	m_rotationX[index] = rotationDegrees.x;
+	m_rotationY[index] = rotationDegrees.y;
+	m_rotationZ[index] = rotationDegrees.z;
+	m_positionX[index] = position.x;
+	m_positionY[index] = position.y;
+	m_positionZ[index] = position.z;
+	m_transformDirty[index] = 1;
+	m_bTransformsDirty = true;
+	// the record is written after the transform system has
+	// rebuilt the world matrix
+	MarkInstanceDirty((size_t)index);
+}
+
+/***********************************************************
+ *  SetColor()
+ *
+ *  This method is used for changing the color of an entity.
+ ***********************************************************/
+void EntityStore::SetColor(EntityID entity, glm::vec4 color)
+{
+	int64_t index = GetIndex(entity);
+	if (index >= 0)
+	{
+		m_colors[index] = color;
+		MarkInstanceDirty((size_t)index);
+	}
+}
+
+/***********************************************************
+ *  SetTexture()
+ *
+ *  This method is used for changing the texture slot used
+ *  by an entity.
+ ***********************************************************/
+void EntityStore::SetTexture(EntityID entity, int textureSlot)
+{
+	int64_t index = GetIndex(entity);
+	if (index >= 0)
+	{
+		m_textureSlots[index] = textureSlot;
+	}
+}
+
+/***********************************************************
+ *  SetMaterial()
+ *
+ *  This method is used for changing the material used by
+ *  an entity.
+ ***********************************************************/
+void EntityStore::SetMaterial(EntityID entity, int materialIndex)
+{
+	int64_t index = GetIndex(entity);
+	if (index >= 0)
+	{
+		m_materialIndexes[index] = materialIndex;
+		MarkInstanceDirty((size_t)index);
+	}
+}
+
+/***********************************************************
+ *  SetHidden()
+ *
+ *  This method is used for hiding or showing an entity
+ *  regardless of the culling result.
+ ***********************************************************/
+void EntityStore::SetHidden(EntityID entity, bool bHidden)
+{
+	int64_t index = GetIndex(entity);
+	if (index >= 0)
+	{
+		m_hidden[index] = bHidden ? 1 : 0;
+	}
+}
+
+/***********************************************************
+ *  SetWindStiffness()
+ *
+ *  This method is used for changing how much the wind bends
+ *  an entity.  Zero makes the entity rigid.
+ ***********************************************************/
+void EntityStore::SetWindStiffness(EntityID entity, float windStiffness)
+{
+	int64_t index = GetIndex(entity);
+	if (index >= 0)
+	{
+		m_windStiffness[index] = windStiffness;
+		MarkInstanceDirty((size_t)index);
+	}
+}
+
+/***********************************************************
+ *  GetDesc()
+ *
+ *  This method is used for reading back the current
+ *  component values of an entity.
+ ***********************************************************/
+bool EntityStore::GetDesc(EntityID entity, ENTITY_DESC& desc) const
+{
+	int64_t index = GetIndex(entity);
+	if (index < 0)
+	{
+		return(false);
+	}
+
+	desc.mesh = (SCENE_MESH)m_meshes[index];
+	desc.scale = glm::vec3(m_scaleX[index], m_scaleY[index], m_scaleZ[index]);
+	desc.rotationDegrees = glm::vec3(m_rotationX[index], m_rotationY[index], m_rotationZ[index]);
+	desc.position = glm::vec3(m_positionX[index], m_positionY[index], m_positionZ[index]);
+	desc.color = m_colors[index];
+	desc.uvScale = m_uvScales[index];
+	desc.textureSlot = m_textureSlots[index];
+	desc.materialIndex = m_materialIndexes[index];
+	desc.windStiffness = m_windStiffness[index];
+
+	return(true);
+}
+
+/***********************************************************
+ *  RemapMaterial()
+ *
+ *  This method is used for pointing every entity that uses
+ *  one material index at another, as needed when a material
+ *  is removed or moved in the materials list.
+ ***********************************************************/
+void EntityStore::RemapMaterial(int fromIndex, int toIndex)
+{
+	for (size_t i = 0; i < m_materialIndexes.size(); i++)
+	{
+		if (m_materialIndexes[i] == fromIndex)
+		{
+			m_materialIndexes[i] = toIndex;
+			MarkInstanceDirty(i);
+		}
+	}
+}
+
+/***********************************************************
+ *  MarkInstanceDirty()
+ *
+ *  This method is used for queueing the instance record at
+ *  an index for the next upload.  Each index is queued once
+ *  no matter how many of its components change.
+ ***********************************************************/
+void EntityStore::MarkInstanceDirty(size_t index)
+{
+	if (m_instanceDirty[index] == 0)
+	{
+		m_instanceDirty[index] = 1;
+		m_dirtyInstances.push_back((uint32_t)index);
+	}
+}
+
+/***********************************************************
+ *  FlushInstances()
+ *
+ *  This method is the instance upload system.  It writes the
+ *  record of every changed entity into the instance buffer,
+ *  which then uploads only those ranges.  Removing entities
+ *  just shrinks the buffer.
+ ***********************************************************/
+void EntityStore::FlushInstances(GPUArrayBuffer& instances, size_t instanceBase)
+{
+	size_t entityCount = m_entityOfIndex.size();
+
+	// a new base moves every record
+	if (instanceBase != m_instanceBase)
+	{
+		m_instanceBase = instanceBase;
+		for (size_t i = 0; i < entityCount; i++)
+		{
+			MarkInstanceDirty(i);
+		}
+	}
+
+	instances.Resize(instanceBase + entityCount);
+
+	for (uint32_t index : m_dirtyInstances)
+	{
+		// indexes queued before a later removal shrank the arrays
+		if (index >= entityCount)
+		{
+			continue;
+		}
+
+		INSTANCE_RECORD record;
+		record.world = m_worldMatrices[index];
+		record.color = m_colors[index];
+		record.uvScale = m_uvScales[index];
+		record.materialIndex = m_materialIndexes[index];
+		record.windStiffness = m_windStiffness[index];
+		record.windPhase = m_windPhases[index];
+		record.reserved[0] = record.reserved[1] = record.reserved[2] = 0.0f;
+		instances.Write(instanceBase + index, &record);
+
+		m_instanceDirty[index] = 0;
+	}
+	m_dirtyInstances.clear();
+}
+
+/***********************************************************
+ *  UpdateTransforms()
+ *
+ *  This method is the transform system.  It rebuilds the
+ *  world matrix and bounding sphere of every entity whose
+ *  transform changed, applying the transforms in the order
+ *  translation * rotationX * rotationY * rotationZ * scale.
+ ***********************************************************/
+void EntityStore::UpdateTransforms()
+{
+	if (m_bTransformsDirty == false)
+	{
+		return;
+	}
+
+	JobSystem::ParallelFor(m_entityOfIndex.size(), g_EntityBatchSize,
+		[this](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				if (m_transformDirty[i] == 0)
+				{
+					continue;
+				}
+
+				glm::vec3 position(m_positionX[i], m_positionY[i], m_positionZ[i]);
+				glm::mat4 scale = glm::scale(glm::vec3(m_scaleX[i], m_scaleY[i], m_scaleZ[i]));
+				glm::mat4 rotationX = glm::rotate(glm::radians(m_rotationX[i]), glm::vec3(1.0f, 0.0f, 0.0f));
+				glm::mat4 rotationY = glm::rotate(glm::radians(m_rotationY[i]), glm::vec3(0.0f, 1.0f, 0.0f));
+				glm::mat4 rotationZ = glm::rotate(glm::radians(m_rotationZ[i]), glm::vec3(0.0f, 0.0f, 1.0f));
+				glm::mat4 translation = glm::translate(position);
+
+				m_worldMatrices[i] = translation * rotationX * rotationY * rotationZ * scale;
+
+				// rotation does not change the size of a sphere around
+				// the origin, so only the largest scale matters
+				float maxScale = std::fmax(std::fabs(m_scaleX[i]), std::fmax(std::fabs(m_scaleY[i]), std::fabs(m_scaleZ[i])));
+				m_boundsX[i] = position.x;
+				m_boundsY[i] = position.y;
+				m_boundsZ[i] = position.z;
+				m_boundsRadius[i] = GetMeshRadius((SCENE_MESH)m_meshes[i]) * maxScale;
+
+				m_transformDirty[i] = 0;
+			}
+		});
+
+	m_bTransformsDirty = false;
+}
+
+/***********************************************************
+ *  CullEntities()
+ *
+ *  This method is the culling system.  It extracts the six
+ *  frustum planes from the view projection matrix and marks
+ *  each entity visible if its bounding sphere is not fully
+ *  outside any of them.
+ ***********************************************************/
+void EntityStore::CullEntities(const glm::mat4& viewProjection)
+{
+	VIEW_FRUSTUM frustum;
+	frustum.Extract(viewProjection);
+
+	JobSystem::ParallelFor(m_entityOfIndex.size(), g_EntityBatchSize,
+		[this, &frustum](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				bool bVisible = (m_hidden[i] == 0) &&
+					frustum.IsSphereVisible(m_boundsX[i], m_boundsY[i], m_boundsZ[i], m_boundsRadius[i]);
+				m_visible[i] = bVisible ? 1 : 0;
+			}
+		});
+}
+
+/***********************************************************
+ *  MarkAllVisible()
+ *
+ *  This method is used instead of the culling system when
+ *  the renderer needs the objects outside of the view too.
+ ***********************************************************/
+void EntityStore::MarkAllVisible()
+{
+	for (size_t i = 0; i < m_entityOfIndex.size(); i++)
+	{
+		m_visible[i] = (m_hidden[i] == 0) ? 1 : 0;
+	}
+}
+
+/***********************************************************
+ *  Extract()
+ *
+ *  This method is used for extracting the six frustum
+ *  planes from the rows of the view projection matrix.
+ ***********************************************************/
+void VIEW_FRUSTUM::Extract(const glm::mat4& viewProjection)
+{
+	glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	planes[0] = row3 + row0;   // left
+	planes[1] = row3 - row0;   // right
+	planes[2] = row3 + row1;   // bottom
+	planes[3] = row3 - row1;   // top
+	planes[4] = row3 + row2;   // near
+	planes[5] = row3 - row2;   // far
+
+	for (int p = 0; p < 6; p++)
+	{
+		float length = std::sqrt(planes[p].x * planes[p].x + planes[p].y * planes[p].y + planes[p].z * planes[p].z);
+		if (length > 0.0f)
+		{
+			planes[p] = planes[p] * (1.0f / length);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildRenderPackets()
+ *
+ *  This method is the render packet system.  Each batch of
+ *  entities first counts its visible entities, the counts
+ *  are turned into output offsets, and then every batch
+ *  writes its packets into its own part of the output.
+ ***********************************************************/
+void EntityStore::BuildRenderPackets(std::vector<RENDER_PACKET>& packets) const
+{
+	size_t entityCount = m_entityOfIndex.size();
+	size_t batchCount = (entityCount + g_EntityBatchSize - 1) / g_EntityBatchSize;
+	std::vector<size_t> batchOffsets(batchCount + 1, 0);
+
+	JobSystem::ParallelFor(batchCount, 1,
+		[this, entityCount, &batchOffsets](size_t beginBatch, size_t endBatch)
+		{
+			for (size_t batch = beginBatch; batch < endBatch; batch++)
+			{
+				size_t begin = batch * g_EntityBatchSize;
+				size_t end = std::min(begin + g_EntityBatchSize, entityCount);
+				size_t visibleCount = 0;
+				for (size_t i = begin; i < end; i++)
+				{
+					visibleCount += m_visible[i];
+				}
+				batchOffsets[batch + 1] = visibleCount;
+			}
+		});
+
+	for (size_t batch = 0; batch < batchCount; batch++)
+	{
+		batchOffsets[batch + 1] += batchOffsets[batch];
+	}
+	packets.resize(batchOffsets[batchCount]);
+
+	JobSystem::ParallelFor(batchCount, 1,
+		[this, entityCount, &batchOffsets, &packets](size_t beginBatch, size_t endBatch)
+		{
+			for (size_t batch = beginBatch; batch < endBatch; batch++)
+			{
+				size_t begin = batch * g_EntityBatchSize;
+				size_t end = std::min(begin + g_EntityBatchSize, entityCount);
+				size_t output = batchOffsets[batch];
+				for (size_t i = begin; i < end; i++)
+				{
+					if (m_visible[i] == 0)
+					{
+						continue;
+					}
+					RENDER_PACKET& packet = packets[output++];
+					packet.world = m_worldMatrices[i];
+					packet.color = m_colors[i];
+					packet.uvScale = m_uvScales[i];
+					packet.textureSlot = m_textureSlots[i];
+					packet.materialIndex = m_materialIndexes[i];
+					packet.mesh = m_meshes[i];
+					packet.instance = (uint32_t)(m_instanceBase + i);
+					packet.sortKey = MakeSortKey(packet.mesh, packet.textureSlot, packet.materialIndex);
+				}
+			}
+		});
+
+	// group packets sharing the same state - the stable sort
+	// keeps the authored order within each group
+	std::stable_sort(packets.begin(), packets.end(),
+		[](const RENDER_PACKET& a, const RENDER_PACKET& b) { return a.sortKey < b.sortKey; });
+}
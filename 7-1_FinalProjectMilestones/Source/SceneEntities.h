@@ -0,0 +1,197 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneentities.h
+// ============
+// store scene objects as entities with structure-of-arrays components
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MemoryTracker.h"
+#include "SceneBuffers.h"
+#include "SceneFile.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// identifies one entity for as long as it is alive
+typedef uint32_t EntityID;
+const EntityID INVALID_ENTITY = 0xFFFFFFFF;
+
+// component arrays are charged to the scene memory tag
+template <class T>
+using SceneVector = std::vector<T, TrackedAllocator<T, MemoryTracker::MEMTAG_SCENE>>;
+
+/***********************************************************
+ *  ENTITY_DESC
+ *
+ *  Initial component values for a new entity.
+ ***********************************************************/
+struct ENTITY_DESC
+{
+	SCENE_MESH mesh;
+	glm::vec3 scale;
+	glm::vec3 rotationDegrees;
+	glm::vec3 position;
+	glm::vec4 color;
+	glm::vec2 uvScale;
+	// -1 when the entity has no texture or material
+	int textureSlot;
+	int materialIndex;
+	// how much the wind bends the entity - 0 for rigid objects
+	float windStiffness;
+};
+
+/***********************************************************
+ *  RENDER_PACKET
+ *
+ *  Everything needed to draw one visible entity, built
+ *  each frame by the render packet system.
+ ***********************************************************/
+struct RENDER_PACKET
+{
+	glm::mat4 world;
+	glm::vec4 color;
+	glm::vec2 uvScale;
+	int textureSlot;
+	int materialIndex;
+	uint32_t mesh;
+	// index of the entity's record in the GPU instance buffer
+	uint32_t instance;
+	// packets are sorted by mesh, texture and material
+	uint32_t sortKey;
+};
+
+/***********************************************************
+ *  VIEW_FRUSTUM
+ *
+ *  The six planes of a view frustum, extracted from a view
+ *  projection matrix, for testing bounding spheres.
+ ***********************************************************/
+struct VIEW_FRUSTUM
+{
+	glm::vec4 planes[6];
+
+	// extract the normalized planes from the matrix
+	void Extract(const glm::mat4& viewProjection);
+	// true unless the sphere is fully outside any plane
+	bool IsSphereVisible(float x, float y, float z, float radius) const
+	{
+		for (int p = 0; p < 6; p++)
+		{
+			if (planes[p].x * x + planes[p].y * y + planes[p].z * z + planes[p].w < -radius)
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+};
+
+/***********************************************************
+ *  EntityStore
+ *
+ *  This class keeps every scene object as an entity whose
+ *  transform, bounds, render mesh, material and visibility
+ *  components live in parallel contiguous arrays.  All of
+ *  the scene objects share the same set of components, so
+ *  there is a single archetype table; removing an entity
+ *  moves the last entity into its slot to keep the arrays
+ *  densely packed.  The systems walk the arrays in batches
+ *  on the job system.
+ ***********************************************************/
+class EntityStore
+{
+public:
+	// constructor
+	EntityStore();
+
+	// create and destroy entities
+	EntityID CreateEntity(const ENTITY_DESC& desc);
+	bool DestroyEntity(EntityID entity);
+	bool IsAlive(EntityID entity) const;
+	size_t GetEntityCount() const { return m_entityOfIndex.size(); }
+	void Reserve(size_t count);
+	void Clear();
+
+	// change the components of an entity
+	void SetTransform(EntityID entity, glm::vec3 scale, glm::vec3 rotationDegrees, glm::vec3 position);
+	void SetColor(EntityID entity, glm::vec4 color);
+	void SetTexture(EntityID entity, int textureSlot);
+	void SetMaterial(EntityID entity, int materialIndex);
+	void SetHidden(EntityID entity, bool bHidden);
+	void SetWindStiffness(EntityID entity, float windStiffness);
+	bool GetDesc(EntityID entity, ENTITY_DESC& desc) const;
+	// point every entity using one material at another
+	void RemapMaterial(int fromIndex, int toIndex);
+
+	// transform system - rebuild the world matrices and bounds
+	// of every entity whose transform changed
+	void UpdateTransforms();
+	// culling system - test the bounds against the view frustum
+	void CullEntities(const glm::mat4& viewProjection);
+	// mark every entity that is not hidden visible, for renderers
+	// that see the whole scene
+	void MarkAllVisible();
+	// render packet system - gather the visible entities into
+	// packets sorted to minimize state changes
+	void BuildRenderPackets(std::vector<RENDER_PACKET>& packets) const;
+	// instance upload system - write the records of the entities
+	// changed since the last flush into the instance buffer,
+	// starting at the passed in record index
+	void FlushInstances(GPUArrayBuffer& instances, size_t instanceBase);
+
+	// bounding sphere radius of the unit sized basic meshes, or
+	// of an imported mesh once it is set
+	float GetMeshRadius(SCENE_MESH mesh) const;
+	void SetMeshRadius(SCENE_MESH mesh, float radius);
+
+private:
+	// transform components
+	SceneVector<float> m_positionX, m_positionY, m_positionZ;
+	SceneVector<float> m_scaleX, m_scaleY, m_scaleZ;
+	SceneVector<float> m_rotationX, m_rotationY, m_rotationZ;
+	SceneVector<glm::mat4> m_worldMatrices;
+	SceneVector<uint8_t> m_transformDirty;
+	// bounds components - world space bounding spheres
+	SceneVector<float> m_boundsX, m_boundsY, m_boundsZ, m_boundsRadius;
+	// render mesh components
+	SceneVector<uint8_t> m_meshes;
+	// material components
+	SceneVector<glm::vec4> m_colors;
+	SceneVector<glm::vec2> m_uvScales;
+	SceneVector<int32_t> m_textureSlots;
+	SceneVector<int32_t> m_materialIndexes;
+	// wind components - the phase is fixed when the entity is created
+	SceneVector<float> m_windStiffness;
+	SceneVector<float> m_windPhases;
+	// visibility components - hidden by request and culling result
+	SceneVector<uint8_t> m_hidden;
+	SceneVector<uint8_t> m_visible;
+	// instance records waiting for upload
+	SceneVector<uint8_t> m_instanceDirty;
+	SceneVector<uint32_t> m_dirtyInstances;
+	// index of the first entity record in the instance buffer
+	size_t m_instanceBase;
+	// bounding sphere radius of the imported meshes, numbered
+	// from SCENE_MESH_COUNT
+	std::vector<float> m_importedMeshRadii;
+
+	// mapping between entity IDs and array indexes
+	SceneVector<uint32_t> m_indexOfEntity;
+	SceneVector<EntityID> m_entityOfIndex;
+	SceneVector<EntityID> m_freeEntities;
+	// true when any transform is waiting for the transform system
+	bool m_bTransformsDirty;
+
+	// get the array index of an entity, or -1 if it is not alive
+	int64_t GetIndex(EntityID entity) const;
+	// move the components at one index over another
+	void MoveComponents(size_t from, size_t to);
+	// remove the components at the end of the arrays
+	void PopComponents();
+	// queue the instance record at an index for upload
+	void MarkInstanceDirty(size_t index);
+};
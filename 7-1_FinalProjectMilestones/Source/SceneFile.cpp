@@ -0,0 +1,498 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// compile text scene descriptions and map the compiled form
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// names of the meshes used in the text format
+	const char* g_MeshNames[SCENE_MESH_COUNT] =
+	{
+		"plane",
+		"box",
+		"torus",
+		"taperedCylinder",
+		"prism"
+	};
+
+	// sections are aligned so the records can be read in place
+	const uint32_t g_SectionAlignment = 16;
+
+	// parsed text records before they are flattened
+	struct PARSED_TEXTURE
+	{
+		std::string tag;
+		std::string path;
+	};
+
+	struct PARSED_MATERIAL
+	{
+		std::string tag;
+		SCENE_MATERIAL_RECORD record;
+	};
+
+	struct PARSED_OBJECT
+	{
+		std::string textureTag;
+		std::string materialTag;
+		SCENE_OBJECT_RECORD record;
+	};
+
+	// read a number of floats following a keyword
+	bool ReadFloats(std::istringstream& stream, float* pValues, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (!(stream >> pValues[i]))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	// round an offset up to the section alignment
+	uint32_t AlignOffset(uint32_t offset)
+	{
+		return((offset + g_SectionAlignment - 1) & ~(g_SectionAlignment - 1));
+	}
+
+	// add a string to the string table and return its offset
+	uint32_t AddString(std::vector<char>& strings, const std::string& text)
+	{
+		uint32_t offset = (uint32_t)strings.size();
+		strings.insert(strings.end(), text.begin(), text.end());
+		strings.push_back('\0');
+		return(offset);
+	}
+}
+
+/***********************************************************
+ *  ParseMeshName()
+ *
+ *  This method is used for getting the mesh associated
+ *  with the passed in text format name.
+ ***********************************************************/
+bool SceneCompiler::ParseMeshName(const std::string& name, SCENE_MESH& mesh)
+{
+	for (int i = 0; i < SCENE_MESH_COUNT; i++)
+	{
+		if (name.compare(g_MeshNames[i]) == 0)
+		{
+			mesh = (SCENE_MESH)i;
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  Compile()
+ *
+ *  This method is used for parsing the text scene file and
+ *  writing it out as a compiled scene file.  Texture and
+ *  material tags are resolved to indexes here, so nothing
+ *  needs to be looked up by name at load or render time.
+ *
+ *  Each line of the text file is one of:
+ *    texture <tag> <path>
+ *    material <tag> ambient r g b strength s
+ *             diffuse r g b specular r g b shininess s
+ *    light position x y z ambient r g b diffuse r g b
+ *          specular r g b focal f intensity i
+ *    object <mesh> scale x y z rotation x y z position x y z
+ *           color r g b a uv u v texture <tag> material <tag>
+ *  Blank lines and lines starting with # are ignored.
+ ***********************************************************/
+bool SceneCompiler::Compile(const char* textFilename, const char* binaryFilename)
+{
+	std::ifstream textFile(textFilename);
+	if (!textFile.is_open())
+	{
+		std::cout << "Could not open scene description:" << textFilename << std::endl;
+		return(false);
+	}
+
+	std::vector<PARSED_TEXTURE> textures;
+	std::vector<PARSED_MATERIAL> materials;
+	std::vector<SCENE_LIGHT_RECORD> lights;
+	std::vector<PARSED_OBJECT> objects;
+
+	std::string line;
+	int lineNumber = 0;
+	bool bSuccess = true;
+
+	while (std::getline(textFile, line))
+	{
+		lineNumber++;
+
+		std::istringstream stream(line);
+		std::string keyword;
+		if (!(stream >> keyword) || (keyword[0] == '#'))
+		{
+			continue;
+		}
+
+		bool bLineValid = true;
+		std::string key;
+
+		if (keyword == "texture")
+		{
+			PARSED_TEXTURE texture;
+			bLineValid = (bool)(stream >> texture.tag >> texture.path);
+			textures.push_back(texture);
+		}
+		else if (keyword == "material")
+		{
+			PARSED_MATERIAL material;
+			memset(&material.record, 0, sizeof(material.record));
+			bLineValid = (bool)(stream >> material.tag);
+			while (bLineValid && (stream >> key))
+			{
+				if (key == "ambient") bLineValid = ReadFloats(stream, material.record.ambientColor, 3);
+				else if (key == "strength") bLineValid = ReadFloats(stream, &material.record.ambientStrength, 1);
+				else if (key == "diffuse") bLineValid = ReadFloats(stream, material.record.diffuseColor, 3);
+				else if (key == "specular") bLineValid = ReadFloats(stream, material.record.specularColor, 3);
+				else if (key == "shininess") bLineValid = ReadFloats(stream, &material.record.shininess, 1);
+				else bLineValid = false;
+			}
+			materials.push_back(material);
+		}
+		else if (keyword == "light")
+		{
+			SCENE_LIGHT_RECORD light;
+			memset(&light, 0, sizeof(light));
+			while (bLineValid && (stream >> key))
+			{
+				if (key == "position") bLineValid = ReadFloats(stream, light.position, 3);
+				else if (key == "ambient") bLineValid = ReadFloats(stream, light.ambientColor, 3);
+				else if (key == "diffuse") bLineValid = ReadFloats(stream, light.diffuseColor, 3);
+				else if (key == "specular") bLineValid = ReadFloats(stream, light.specularColor, 3);
+				else if (key == "focal") bLineValid = ReadFloats(stream, &light.focalStrength, 1);
+				else if (key == "intensity") bLineValid = ReadFloats(stream, &light.specularIntensity, 1);
+				else bLineValid = false;
+			}
+			lights.push_back(light);
+		}
+		else if (keyword == "object")
+		{
+			PARSED_OBJECT object;
+			std::string meshName;
+			SCENE_MESH mesh = SCENE_MESH_PLANE;
+
+			// default to an untextured white object at the origin
+			memset(&object.record, 0, sizeof(object.record));
+			for (int i = 0; i < 3; i++) object.record.scale[i] = 1.0f;
+			for (int i = 0; i < 4; i++) object.record.color[i] = 1.0f;
+			object.record.uvScale[0] = 1.0f;
+			object.record.uvScale[1] = 1.0f;
+
+			bLineValid = (bool)(stream >> meshName) && ParseMeshName(meshName, mesh);
+			object.record.mesh = mesh;
+			while (bLineValid && (stream >> key))
+			{
+				if (key == "scale") bLineValid = ReadFloats(stream, object.record.scale, 3);
+				else if (key == "rotation") bLineValid = ReadFloats(stream, object.record.rotation, 3);
+				else if (key == "position") bLineValid = ReadFloats(stream, object.record.position, 3);
+				else if (key == "color") bLineValid = ReadFloats(stream, object.record.color, 4);
+				else if (key == "uv") bLineValid = ReadFloats(stream, object.record.uvScale, 2);
+				else if (key == "texture") bLineValid = (bool)(stream >> object.textureTag);
+				else if (key == "material") bLineValid = (bool)(stream >> object.materialTag);
+				else bLineValid = false;
+			}
+			objects.push_back(object);
+		}
+		else
+		{
+			bLineValid = false;
+		}
+
+		if (bLineValid == false)
+		{
+			std::cout << textFilename << "(" << lineNumber << "): could not parse line: " << line << std::endl;
+			bSuccess = false;
+		}
+	}
+
+	if (textures.size() > SCENE_FILE_MAX_TEXTURES)
+	{
+		std::cout << textFilename << ": " << textures.size() << " textures, but at most " << SCENE_FILE_MAX_TEXTURES << " can be used" << std::endl;
+		bSuccess = false;
+	}
+
+	if (bSuccess == false)
+	{
+		return(false);
+	}
+
+	// flatten the parsed records and resolve the tag references -
+	// the string table starts with an empty string, so it is never
+	// empty and always ends with a terminator
+	std::vector<char> strings(1, '\0');
+	std::vector<SCENE_TEXTURE_RECORD> textureRecords(textures.size());
+	std::vector<SCENE_MATERIAL_RECORD> materialRecords(materials.size());
+	std::vector<SCENE_OBJECT_RECORD> objectRecords(objects.size());
+
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		textureRecords[i].tagOffset = AddString(strings, textures[i].tag);
+		textureRecords[i].pathOffset = AddString(strings, textures[i].path);
+	}
+	for (size_t i = 0; i < materials.size(); i++)
+	{
+		materialRecords[i] = materials[i].record;
+		materialRecords[i].tagOffset = AddString(strings, materials[i].tag);
+	}
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		objectRecords[i] = objects[i].record;
+		objectRecords[i].textureIndex = -1;
+		objectRecords[i].materialIndex = -1;
+
+		for (size_t t = 0; t < textures.size(); t++)
+		{
+			if (textures[t].tag == objects[i].textureTag)
+			{
+				objectRecords[i].textureIndex = (int32_t)t;
+			}
+		}
+		for (size_t m = 0; m < materials.size(); m++)
+		{
+			if (materials[m].tag == objects[i].materialTag)
+			{
+				objectRecords[i].materialIndex = (int32_t)m;
+			}
+		}
+
+		if (!objects[i].textureTag.empty() && (objectRecords[i].textureIndex < 0))
+		{
+			std::cout << textFilename << ": object " << i << " uses unknown texture " << objects[i].textureTag << std::endl;
+			bSuccess = false;
+		}
+		if (!objects[i].materialTag.empty() && (objectRecords[i].materialIndex < 0))
+		{
+			std::cout << textFilename << ": object " << i << " uses unknown material " << objects[i].materialTag << std::endl;
+			bSuccess = false;
+		}
+	}
+
+	if (bSuccess == false)
+	{
+		return(false);
+	}
+
+	// lay out the sections one after another behind the header
+	SCENE_FILE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+
+	uint32_t offset = AlignOffset(sizeof(SCENE_FILE_HEADER));
+	header.textures.offset = offset;
+	header.textures.count = (uint32_t)textureRecords.size();
+	offset = AlignOffset(offset + header.textures.count * sizeof(SCENE_TEXTURE_RECORD));
+	header.materials.offset = offset;
+	header.materials.count = (uint32_t)materialRecords.size();
+	offset = AlignOffset(offset + header.materials.count * sizeof(SCENE_MATERIAL_RECORD));
+	header.lights.offset = offset;
+	header.lights.count = (uint32_t)lights.size();
+	offset = AlignOffset(offset + header.lights.count * sizeof(SCENE_LIGHT_RECORD));
+	header.objects.offset = offset;
+	header.objects.count = (uint32_t)objectRecords.size();
+	offset = AlignOffset(offset + header.objects.count * sizeof(SCENE_OBJECT_RECORD));
+	header.strings.offset = offset;
+	header.strings.count = (uint32_t)strings.size();
+	header.fileSize = offset + header.strings.count;
+
+	std::vector<unsigned char> image(header.fileSize, 0);
+	memcpy(image.data(), &header, sizeof(header));
+	if (!textureRecords.empty())
+		memcpy(image.data() + header.textures.offset, textureRecords.data(), textureRecords.size() * sizeof(SCENE_TEXTURE_RECORD));
+	if (!materialRecords.empty())
+		memcpy(image.data() + header.materials.offset, materialRecords.data(), materialRecords.size() * sizeof(SCENE_MATERIAL_RECORD));
+	if (!lights.empty())
+		memcpy(image.data() + header.lights.offset, lights.data(), lights.size() * sizeof(SCENE_LIGHT_RECORD));
+	if (!objectRecords.empty())
+		memcpy(image.data() + header.objects.offset, objectRecords.data(), objectRecords.size() * sizeof(SCENE_OBJECT_RECORD));
+	if (!strings.empty())
+		memcpy(image.data() + header.strings.offset, strings.data(), strings.size());
+
+	std::ofstream binaryFile(binaryFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!binaryFile.is_open())
+	{
+		std::cout << "Could not write compiled scene:" << binaryFilename << std::endl;
+		return(false);
+	}
+	binaryFile.write((const char*)image.data(), image.size());
+
+	std::cout << "Compiled scene:" << binaryFilename << ", objects:" << header.objects.count
+		<< ", materials:" << header.materials.count << ", textures:" << header.textures.count
+		<< ", lights:" << header.lights.count << ", bytes:" << header.fileSize << std::endl;
+
+	return(binaryFile.good());
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pHeader = nullptr;
+	m_pTextures = nullptr;
+	m_pMaterials = nullptr;
+	m_pLights = nullptr;
+	m_pObjects = nullptr;
+	m_pStrings = nullptr;
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Unload();
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for mapping a compiled scene file
+ *  into memory and fixing up the section pointers from the
+ *  offsets stored in the header.
+ ***********************************************************/
+bool SceneFile::Load(const char* filename)
+{
+	Unload();
+
+	if (m_file.Open(filename) == false)
+	{
+		std::cout << "Could not map compiled scene:" << filename << std::endl;
+		return(false);
+	}
+
+	const unsigned char* pData = m_file.GetData();
+	const SCENE_FILE_HEADER* pHeader = (const SCENE_FILE_HEADER*)pData;
+	if ((m_file.GetSize() < sizeof(SCENE_FILE_HEADER)) ||
+		(pHeader->magic != SCENE_FILE_MAGIC) ||
+		(pHeader->version != SCENE_FILE_VERSION) ||
+		(pHeader->fileSize != m_file.GetSize()))
+	{
+		std::cout << "Not a compiled scene of version " << SCENE_FILE_VERSION << ":" << filename << std::endl;
+		Unload();
+		return(false);
+	}
+
+	if (!IsSectionValid(pHeader->textures, sizeof(SCENE_TEXTURE_RECORD)) ||
+		(pHeader->textures.count > SCENE_FILE_MAX_TEXTURES) ||
+		!IsSectionValid(pHeader->materials, sizeof(SCENE_MATERIAL_RECORD)) ||
+		!IsSectionValid(pHeader->lights, sizeof(SCENE_LIGHT_RECORD)) ||
+		!IsSectionValid(pHeader->objects, sizeof(SCENE_OBJECT_RECORD)) ||
+		!IsSectionValid(pHeader->strings, 1))
+	{
+		std::cout << "Compiled scene is damaged:" << filename << std::endl;
+		Unload();
+		return(false);
+	}
+
+	// the records index into the other sections and the string
+	// table, so each index is checked before anything reads
+	// through it - the table must end with the terminator of its
+	// last string, so no string runs past the mapping
+	const unsigned char* pStrings = pData + pHeader->strings.offset;
+	bool bValid = (pHeader->strings.count > 0) && (pStrings[pHeader->strings.count - 1] == '\0');
+	const SCENE_TEXTURE_RECORD* pTextures = (const SCENE_TEXTURE_RECORD*)(pData + pHeader->textures.offset);
+	for (uint32_t i = 0; bValid && (i < pHeader->textures.count); i++)
+	{
+		bValid = (pTextures[i].tagOffset < pHeader->strings.count) &&
+			(pTextures[i].pathOffset < pHeader->strings.count);
+	}
+	const SCENE_MATERIAL_RECORD* pMaterials = (const SCENE_MATERIAL_RECORD*)(pData + pHeader->materials.offset);
+	for (uint32_t i = 0; bValid && (i < pHeader->materials.count); i++)
+	{
+		bValid = (pMaterials[i].tagOffset < pHeader->strings.count);
+	}
+	const SCENE_OBJECT_RECORD* pObjects = (const SCENE_OBJECT_RECORD*)(pData + pHeader->objects.offset);
+	for (uint32_t i = 0; bValid && (i < pHeader->objects.count); i++)
+	{
+		const SCENE_OBJECT_RECORD& object = pObjects[i];
+		bValid = (object.mesh < SCENE_MESH_COUNT) &&
+			(object.textureIndex >= -1) && (object.textureIndex < (int64_t)pHeader->textures.count) &&
+			(object.materialIndex >= -1) && (object.materialIndex < (int64_t)pHeader->materials.count);
+	}
+	if (bValid == false)
+	{
+		std::cout << "Compiled scene is damaged:" << filename << std::endl;
+		Unload();
+		return(false);
+	}
+
+	// fix up the section pointers into the mapped file
+	m_pHeader = pHeader;
+	m_pTextures = (const SCENE_TEXTURE_RECORD*)(pData + pHeader->textures.offset);
+	m_pMaterials = (const SCENE_MATERIAL_RECORD*)(pData + pHeader->materials.offset);
+	m_pLights = (const SCENE_LIGHT_RECORD*)(pData + pHeader->lights.offset);
+	m_pObjects = (const SCENE_OBJECT_RECORD*)(pData + pHeader->objects.offset);
+	m_pStrings = (const char*)(pData + pHeader->strings.offset);
+
+	std::cout << "Mapped compiled scene:" << filename << ", objects:" << GetObjectCount() << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Unload()
+ *
+ *  This method is used for unmapping the scene file.
+ ***********************************************************/
+void SceneFile::Unload()
+{
+	m_file.Close();
+	m_pHeader = nullptr;
+	m_pTextures = nullptr;
+	m_pMaterials = nullptr;
+	m_pLights = nullptr;
+	m_pObjects = nullptr;
+	m_pStrings = nullptr;
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting a string from the string
+ *  table by its byte offset.
+ ***********************************************************/
+const char* SceneFile::GetString(uint32_t offset) const
+{
+	if ((m_pHeader == nullptr) || (offset >= m_pHeader->strings.count))
+	{
+		return("");
+	}
+	return(m_pStrings + offset);
+}
+
+/***********************************************************
+ *  IsSectionValid()
+ *
+ *  This method is used for checking that a section and all
+ *  of its records lie inside the mapped file.
+ ***********************************************************/
+bool SceneFile::IsSectionValid(const SCENE_SECTION& section, size_t recordSize) const
+{
+	size_t sectionEnd = (size_t)section.offset + (size_t)section.count * recordSize;
+	return((section.offset % 4 == 0) && (sectionEnd <= m_file.GetSize()));
+}
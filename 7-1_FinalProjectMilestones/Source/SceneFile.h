@@ -0,0 +1,172 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// compile text scene descriptions and map the compiled form
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// identifies a compiled scene file and its layout version
+const uint32_t SCENE_FILE_MAGIC = 0x4E524853; // "SHRN"
+const uint32_t SCENE_FILE_VERSION = 1;
+// most textures a scene can use - one per texture slot of the
+// scene shader
+const uint32_t SCENE_FILE_MAX_TEXTURES = 16;
+
+// basic shape meshes an object can be drawn with
+enum SCENE_MESH
+{
+	SCENE_MESH_PLANE = 0,
+	SCENE_MESH_BOX,
+	SCENE_MESH_TORUS,
+	SCENE_MESH_TAPERED_CYLINDER,
+	SCENE_MESH_PRISM,
+	SCENE_MESH_COUNT
+};
+
+/***********************************************************
+ *  Compiled scene records
+ *
+ *  The compiled file is the header followed by flat arrays
+ *  of these records and a string table.  All references
+ *  between records are indexes or byte offsets, so the file
+ *  can be used in place straight from a memory mapping.
+ ***********************************************************/
+struct SCENE_SECTION
+{
+	uint32_t offset;
+	uint32_t count;
+};
+
+struct SCENE_FILE_HEADER
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t fileSize;
+	uint32_t reserved;
+	SCENE_SECTION textures;
+	SCENE_SECTION materials;
+	SCENE_SECTION lights;
+	SCENE_SECTION objects;
+	SCENE_SECTION strings;
+};
+
+struct SCENE_TEXTURE_RECORD
+{
+	// byte offsets into the string table
+	uint32_t tagOffset;
+	uint32_t pathOffset;
+};
+
+struct SCENE_MATERIAL_RECORD
+{
+	float ambientColor[3];
+	float ambientStrength;
+	float diffuseColor[3];
+	float shininess;
+	float specularColor[3];
+	uint32_t tagOffset;
+};
+
+struct SCENE_LIGHT_RECORD
+{
+	float position[3];
+	float focalStrength;
+	float ambientColor[3];
+	float specularIntensity;
+	float diffuseColor[3];
+	float reserved0;
+	float specularColor[3];
+	float reserved1;
+};
+
+struct SCENE_OBJECT_RECORD
+{
+	float scale[3];
+	float rotation[3];
+	float position[3];
+	float color[4];
+	float uvScale[2];
+	uint32_t mesh;
+	// -1 when the object has no texture or material
+	int32_t textureIndex;
+	int32_t materialIndex;
+};
+
+static_assert(sizeof(SCENE_FILE_HEADER) == 56, "scene header layout changed");
+static_assert(sizeof(SCENE_MATERIAL_RECORD) == 48, "scene material layout changed");
+static_assert(sizeof(SCENE_LIGHT_RECORD) == 64, "scene light layout changed");
+static_assert(sizeof(SCENE_OBJECT_RECORD) == 72, "scene object layout changed");
+
+/***********************************************************
+ *  SceneCompiler
+ *
+ *  This class parses the text scene description used for
+ *  authoring and writes the flat compiled form.
+ ***********************************************************/
+class SceneCompiler
+{
+public:
+	// compile the text scene file into the binary scene file
+	static bool Compile(const char* textFilename, const char* binaryFilename);
+
+	// get the mesh for a name used in the text format
+	static bool ParseMeshName(const std::string& name, SCENE_MESH& mesh);
+};
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class maps a compiled scene file into memory and
+ *  gives direct access to its record arrays.  Loading is a
+ *  single mapping plus fixing up the section pointers.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+	// map the compiled scene file into memory
+	bool Load(const char* filename);
+	// unmap the scene file
+	void Unload();
+	bool IsLoaded() const { return m_pHeader != nullptr; }
+
+	uint32_t GetTextureCount() const { return m_pHeader ? m_pHeader->textures.count : 0; }
+	uint32_t GetMaterialCount() const { return m_pHeader ? m_pHeader->materials.count : 0; }
+	uint32_t GetLightCount() const { return m_pHeader ? m_pHeader->lights.count : 0; }
+	uint32_t GetObjectCount() const { return m_pHeader ? m_pHeader->objects.count : 0; }
+
+	const SCENE_TEXTURE_RECORD* GetTextures() const { return m_pTextures; }
+	const SCENE_MATERIAL_RECORD* GetMaterials() const { return m_pMaterials; }
+	const SCENE_LIGHT_RECORD* GetLights() const { return m_pLights; }
+	const SCENE_OBJECT_RECORD* GetObjects() const { return m_pObjects; }
+
+	// get a string from the string table by byte offset
+	const char* GetString(uint32_t offset) const;
+
+private:
+	// mapped file contents
+	MappedFile m_file;
+
+	// section pointers fixed up from the header offsets
+	const SCENE_FILE_HEADER* m_pHeader;
+	const SCENE_TEXTURE_RECORD* m_pTextures;
+	const SCENE_MATERIAL_RECORD* m_pMaterials;
+	const SCENE_LIGHT_RECORD* m_pLights;
+	const SCENE_OBJECT_RECORD* m_pObjects;
+	const char* m_pStrings;
+
+	// check that a section lies inside the mapped file
+	bool IsSectionValid(const SCENE_SECTION& section, size_t recordSize) const;
+};
@@ -8,6 +8,11 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "ShrineLayout.h"
+#include "JobSystem.h"
+#include "GLDebug.h"
+#include "ModelImporter.h"
+#include "ModelPack.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -15,15 +20,61 @@
 #endif
 
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static_assert(SCENE_FILE_MAX_TEXTURES == SCENE_TEXTURE_SLOTS, "a compiled scene must fit its textures into the texture slots");
 
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	// objects with this texture are foliage that sways in the wind
+	const char* g_FoliageTextureTag = "bush";
+	// how much the wind bends foliage - larger values are stiffer
+	const float g_FoliageStiffness = 0.5f;
+
+	// get the wind stiffness of objects using a texture
+	float GetFoliageStiffness(const char* textureTag)
+	{
+		if ((NULL != textureTag) && (strcmp(textureTag, g_FoliageTextureTag) == 0))
+		{
+			return(g_FoliageStiffness);
+		}
+		return(0.0f);
+	}
+
+	// longest frame step the particles are advanced by, so a stall
+	// does not throw every particle far from its emitter
+	const float g_MaxParticleStep = 0.1f;
+	// the leaves fall across the shrine in this many strips, one
+	// emitter each, so they are simulated in parallel
+	const int g_LeafStripCount = 4;
+	// draws recorded by each command list job
+	const size_t g_CommandListDraws = 64;
+	// bytes of the uniform ring each frame starts with - every draw
+	// block takes one uniform buffer offset alignment, usually 256
+	// bytes, so this fits about a thousand draws before growing
+	const size_t g_UniformRingRegionBytes = 256 * 1024;
+	// farthest on screen, in pixels, the level of detail of an
+	// imported mesh may stray from the full mesh
+	const float g_LodPixelError = 1.0f;
+
+	// texture image files of the hand-coded scene, and their tags
+	struct SCENE_TEXTURE_FILE
+	{
+		const char* filename;
+		const char* tag;
+	};
+	const SCENE_TEXTURE_FILE g_SceneTextureFiles[] =
+	{
+		{ "../../Utilities/textures/stoneTexture.jpg", "stone" },
+		{ "../../Utilities/textures/bushTexture.jpg", "bush" },
+		{ "../../Utilities/textures/groundTexture.jpg", "ground" },
+		{ "../../Utilities/textures/skyTexture.jpg", "sky" }
+	};
 }
 
 /***********************************************************
@@ -35,6 +86,33 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
 	m_basicMeshes = new ShapeMeshes();
+	m_pModelMeshes = NULL;
+	m_loadedTextures = 0;
+	m_pSceneFile = NULL;
+	m_sceneMaterialBase = 0;
+	m_pEntities = new EntityStore();
+	m_bViewProjectionSet = false;
+	m_bLayeredView = false;
+	m_bSharedFrame = false;
+	m_bSharedFrameBegun = false;
+	m_viewPosition = glm::vec3(0.0f);
+	m_pInstanceBuffer = new GPUArrayBuffer(sizeof(INSTANCE_RECORD), "scene instances");
+	m_pMaterialBuffer = new GPUArrayBuffer(sizeof(MATERIAL_RECORD), "scene materials");
+	m_pLightBuffer = new GPUArrayBuffer(sizeof(LIGHT_RECORD), "scene lights");
+	m_staticInstanceCount = 0;
+	m_pUniformRing = NULL;
+	m_pRenderDevice = NULL;
+	m_pWind = new WindSystem();
+	m_frameTime = 0.0;
+	m_previousFrameTime = -1.0;
+	m_pParticles = new ParticleSystem();
+	m_renderBackend = RENDER_BACKEND_OPENGL;
+	m_bUseLighting = false;
+	m_bTexturesEnabled = true;
+	m_pSoftwareRasterizer = NULL;
+	m_softwareScene = {};
+	m_pPathTracer = NULL;
+	m_pathTracedFrameTime = -1.0;
 }
 
 /***********************************************************
@@ -47,6 +125,55 @@ SceneManager::~SceneManager()
 	m_pShaderManager = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+
+	// release the OpenGL objects for deferred deletion
+	FreeDecodedImages();
+	DestroyGLTextures();
+	m_meshBuffers.clear();
+	m_meshVertexArrays.clear();
+	if (NULL != m_pModelMeshes)
+	{
+		delete m_pModelMeshes;
+		m_pModelMeshes = NULL;
+	}
+
+	if (NULL != m_pSceneFile)
+	{
+		delete m_pSceneFile;
+		m_pSceneFile = NULL;
+	}
+	delete m_pEntities;
+	m_pEntities = NULL;
+	delete m_pInstanceBuffer;
+	m_pInstanceBuffer = NULL;
+	delete m_pMaterialBuffer;
+	m_pMaterialBuffer = NULL;
+	delete m_pLightBuffer;
+	m_pLightBuffer = NULL;
+	delete m_pWind;
+	m_pWind = NULL;
+	delete m_pParticles;
+	m_pParticles = NULL;
+	if (NULL != m_pSoftwareRasterizer)
+	{
+		delete m_pSoftwareRasterizer;
+		m_pSoftwareRasterizer = NULL;
+	}
+	if (NULL != m_pPathTracer)
+	{
+		delete m_pPathTracer;
+		m_pPathTracer = NULL;
+	}
+	if (NULL != m_pRenderDevice)
+	{
+		delete m_pRenderDevice;
+		m_pRenderDevice = NULL;
+	}
+	if (NULL != m_pUniformRing)
+	{
+		delete m_pUniformRing;
+		m_pUniformRing = NULL;
+	}
 }
 
 /***********************************************************
@@ -59,29 +186,88 @@ SceneManager::~SceneManager()
  ***********************************************************/
 bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 {
+	if (!m_bTexturesEnabled)
+	{
+		return(false);
+	}
+
+	// the shader samples a fixed number of texture slots
+	if (m_loadedTextures >= SCENE_TEXTURE_SLOTS)
+	{
+		std::cout << "Could not load image:" << filename << " - all " << SCENE_TEXTURE_SLOTS << " texture slots are in use" << std::endl;
+		return false;
+	}
+
 	int width = 0;
 	int height = 0;
 	int colorChannels = 0;
-	GLuint textureID = 0;
+	unsigned char* image = NULL;
 
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
+	// take the image if DecodeSceneTextures() already decoded it,
+	// in which case its memory was counted then
+	bool bPredecoded = false;
+	for (DECODED_IMAGE& decoded : m_decodedImages)
+	{
+		if ((NULL != decoded.pixels) && (decoded.filename == filename))
+		{
+			image = decoded.pixels;
+			width = decoded.width;
+			height = decoded.height;
+			colorChannels = decoded.colorChannels;
+			decoded.pixels = NULL;
+			bPredecoded = true;
+			break;
+		}
+	}
 
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
+	if (NULL == image)
+	{
+		// indicate to always flip images vertically when loaded
+		stbi_set_flip_vertically_on_load(true);
+
+		// try to parse the image data from the specified image file
+		image = stbi_load(
+			filename,
+			&width,
+			&height,
+			&colorChannels,
+			0);
+	}
 
 	// if the image was successfully read from the image file
 	if (image)
 	{
 		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
 
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		// the decoded image is held in local memory until it is uploaded
+		size_t imageBytes = (size_t)width * height * colorChannels;
+		if (!bPredecoded)
+		{
+			MemoryTracker::RecordAllocation(MemoryTracker::MEMTAG_TEXTURES, MemoryTracker::POOL_CPU, imageBytes);
+		}
+
+		// the CPU backends sample a copy in memory instead of an
+		// OpenGL texture
+		if (m_renderBackend != RENDER_BACKEND_OPENGL)
+		{
+			m_softwareTextures.resize(m_loadedTextures + 1);
+			bool bCopied = m_softwareTextures[m_loadedTextures].SetImage(image, width, height, colorChannels);
+			stbi_image_free(image);
+			MemoryTracker::RecordFree(MemoryTracker::MEMTAG_TEXTURES, MemoryTracker::POOL_CPU, imageBytes);
+			if (!bCopied)
+			{
+				std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+				return false;
+			}
+
+			m_textureIDs[m_loadedTextures].ID = 0;
+			m_textureIDs[m_loadedTextures].tag = tag;
+			m_loadedTextures++;
+			return true;
+		}
+
+		GLTextureHandle texture = GLTextureHandle::Create(tag);
+		glBindTexture(GL_TEXTURE_2D, texture.GetName());
 
 		// set the texture wrapping parameters
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -99,298 +285,1099 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 		else
 		{
 			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+			stbi_image_free(image);
+			MemoryTracker::RecordFree(MemoryTracker::MEMTAG_TEXTURES, MemoryTracker::POOL_CPU, imageBytes);
+			glBindTexture(GL_TEXTURE_2D, 0);
 			return false;
 		}
 
 		// generate the texture mipmaps for mapping textures to lower resolutions
 		glGenerateMipmap(GL_TEXTURE_2D);
+		GL_DEBUG_LABEL(GLResourceManager::GLRES_TEXTURE, texture.GetName(), tag.c_str());
 
 		// free the image data from local memory
 		stbi_image_free(image);
+		MemoryTracker::RecordFree(MemoryTracker::MEMTAG_TEXTURES, MemoryTracker::POOL_CPU, imageBytes);
 		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
 
+		// the full mipmap chain adds one third to the base level size,
+		// and the driver stores RGB8 textures with four bytes per texel
+		size_t textureBytes = ((size_t)width * height * 4 * 4) / 3;
+		GLResourceManager::SetMemory(
+			GLResourceManager::GLRES_TEXTURE,
+			texture.GetName(),
+			MemoryTracker::MEMTAG_TEXTURES,
+			textureBytes);
+
 		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
+		m_textureIDs[m_loadedTextures].ID = texture.GetName();
 		m_textureIDs[m_loadedTextures].tag = tag;
+		m_textureIDs[m_loadedTextures].handle = std::move(texture);
 		m_loadedTextures++;
 
 		return true;
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	std::cout << "Could not load image:" << filename << std::endl;
+
+	// Error loading the image
+	return false;
+}
+
+/***********************************************************
+ *  FreeDecodedImages()
+ *
+ *  This method is used for freeing the images decoded ahead
+ *  of time that no texture was created from.
+ ***********************************************************/
+void SceneManager::FreeDecodedImages()
+{
+	for (DECODED_IMAGE& decoded : m_decodedImages)
+	{
+		if (NULL != decoded.pixels)
+		{
+			stbi_image_free(decoded.pixels);
+			MemoryTracker::RecordFree(
+				MemoryTracker::MEMTAG_TEXTURES,
+				MemoryTracker::POOL_CPU,
+				(size_t)decoded.width * decoded.height * decoded.colorChannels);
+			decoded.pixels = NULL;
+		}
+	}
+	m_decodedImages.clear();
+}
+
+/***********************************************************
+ *  BindGLTextures()
+ *
+ *  This method is used for binding the loaded textures to
+ *  OpenGL texture memory slots.  There are up to 16 slots.
+ ***********************************************************/
+void SceneManager::BindGLTextures()
+{
+	if (m_renderBackend != RENDER_BACKEND_OPENGL)
+	{
+		return;
+	}
+
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		// bind textures on corresponding texture units
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+	}
+}
+
+/***********************************************************
+ *  DestroyGLTextures()
+ *
+ *  This method is used for freeing the memory in all the
+ *  used texture memory slots.
+ ***********************************************************/
+void SceneManager::DestroyGLTextures()
+{
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		// the texture is deleted once the GPU has finished with it
+		m_textureIDs[i].handle.Reset();
+		m_textureIDs[i].ID = 0;
+		m_textureIDs[i].tag.clear();
+	}
+	m_loadedTextures = 0;
+}
+
+/***********************************************************
+ *  FindTextureSlot()
+ *
+ *  This method is used for getting a slot index for the previously
+ *  loaded texture bitmap associated with the passed in tag.
+ ***********************************************************/
+int SceneManager::FindTextureSlot(std::string tag)
+{
+	int textureSlot = -1;
+	int index = 0;
+	bool bFound = false;
+
+	while ((index < m_loadedTextures) && (bFound == false))
+	{
+		if (m_textureIDs[index].tag.compare(tag) == 0)
+		{
+			textureSlot = index;
+			bFound = true;
+		}
+		else
+			index++;
+	}
+
+	return(textureSlot);
+}
+
+/***********************************************************
+* LoadSceneTextures()
+*
+* This method is used for preparing the 3D scene by loading
+* the shapes, textures in memory to support the 3D scene
+* rendering
+***********************************************************/
+void SceneManager::LoadSceneTextures()
+{
+	for (const SCENE_TEXTURE_FILE& texture : g_SceneTextureFiles)
+	{
+		CreateGLTexture(texture.filename, texture.tag);
+	}
+
+	// after the texture image data is loaded into memory, the
+	// loaded textures need to be bound to texture slots - there
+	// are a total of 16 available slots for scene textures
+	BindGLTextures();
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used for mapping a compiled scene file,
+ *  which is then rendered in place of the hand-coded scene.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(const char* filename)
+{
+	if (NULL == m_pSceneFile)
+	{
+		m_pSceneFile = new SceneFile();
+	}
+
+	if (m_pSceneFile->Load(filename) == false)
+	{
+		delete m_pSceneFile;
+		m_pSceneFile = NULL;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  DecodeSceneTextures()
+ *
+ *  This method is used for decoding the texture images of
+ *  the compiled scene, or of the hand-coded scene when none
+ *  is loaded, one job per image.  Decoding is most of the
+ *  time spent loading a texture and needs no OpenGL
+ *  context, so it can be done while the window is created.
+ ***********************************************************/
+void SceneManager::DecodeSceneTextures()
+{
+	FreeDecodedImages();
+	if (!m_bTexturesEnabled)
+	{
+		return;
+	}
+	if (NULL != m_pSceneFile)
+	{
+		const SCENE_TEXTURE_RECORD* pTextures = m_pSceneFile->GetTextures();
+		for (uint32_t i = 0; i < m_pSceneFile->GetTextureCount(); i++)
+		{
+			m_decodedImages.push_back({ m_pSceneFile->GetString(pTextures[i].pathOffset), NULL, 0, 0, 0 });
+		}
+	}
+	else
+	{
+		for (const SCENE_TEXTURE_FILE& texture : g_SceneTextureFiles)
+		{
+			m_decodedImages.push_back({ texture.filename, NULL, 0, 0, 0 });
+		}
+	}
+
+	// the flip is a setting of the whole image loader, so it is
+	// set once here rather than by each job
+	stbi_set_flip_vertically_on_load(true);
+	JobSystem::ParallelFor(m_decodedImages.size(), 1, [this](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			DECODED_IMAGE& decoded = m_decodedImages[i];
+			decoded.pixels = stbi_load(
+				decoded.filename.c_str(),
+				&decoded.width,
+				&decoded.height,
+				&decoded.colorChannels,
+				0);
+			if (NULL != decoded.pixels)
+			{
+				MemoryTracker::RecordAllocation(
+					MemoryTracker::MEMTAG_TEXTURES,
+					MemoryTracker::POOL_CPU,
+					(size_t)decoded.width * decoded.height * decoded.colorChannels);
+			}
+		}
+	});
+}
+
+/***********************************************************
+ *  LoadSceneFileResources()
+ *
+ *  This method is used for loading the textures, defining
+ *  the materials and setting up the lights listed in the
+ *  compiled scene file.
+ ***********************************************************/
+void SceneManager::LoadSceneFileResources()
+{
+	const SCENE_TEXTURE_RECORD* pTextures = m_pSceneFile->GetTextures();
+	const SCENE_MATERIAL_RECORD* pMaterials = m_pSceneFile->GetMaterials();
+	const SCENE_LIGHT_RECORD* pLights = m_pSceneFile->GetLights();
+
+	// textures that fail to load leave their objects untextured
+	m_sceneTextureSlots.clear();
+	m_sceneTextureWind.clear();
+	for (uint32_t i = 0; i < m_pSceneFile->GetTextureCount(); i++)
+	{
+		std::string tag = m_pSceneFile->GetString(pTextures[i].tagOffset);
+		CreateGLTexture(m_pSceneFile->GetString(pTextures[i].pathOffset), tag);
+		m_sceneTextureSlots.push_back(FindTextureSlot(tag));
+		m_sceneTextureWind.push_back(GetFoliageStiffness(tag.c_str()));
+	}
+	BindGLTextures();
+
+	m_sceneMaterialBase = m_objectMaterials.size();
+	for (uint32_t i = 0; i < m_pSceneFile->GetMaterialCount(); i++)
+	{
+		OBJECT_MATERIAL material;
+		material.ambientColor = glm::vec3(pMaterials[i].ambientColor[0], pMaterials[i].ambientColor[1], pMaterials[i].ambientColor[2]);
+		material.ambientStrength = pMaterials[i].ambientStrength;
+		material.diffuseColor = glm::vec3(pMaterials[i].diffuseColor[0], pMaterials[i].diffuseColor[1], pMaterials[i].diffuseColor[2]);
+		material.specularColor = glm::vec3(pMaterials[i].specularColor[0], pMaterials[i].specularColor[1], pMaterials[i].specularColor[2]);
+		material.shininess = pMaterials[i].shininess;
+		material.tag = m_pSceneFile->GetString(pMaterials[i].tagOffset);
+		m_objectMaterials.push_back(material);
+	}
+
+	uint32_t lightCount = m_pSceneFile->GetLightCount();
+	for (uint32_t i = 0; i < lightCount; i++)
+	{
+		LIGHT_SOURCE light;
+		light.position = glm::vec3(pLights[i].position[0], pLights[i].position[1], pLights[i].position[2]);
+		light.ambientColor = glm::vec3(pLights[i].ambientColor[0], pLights[i].ambientColor[1], pLights[i].ambientColor[2]);
+		light.diffuseColor = glm::vec3(pLights[i].diffuseColor[0], pLights[i].diffuseColor[1], pLights[i].diffuseColor[2]);
+		light.specularColor = glm::vec3(pLights[i].specularColor[0], pLights[i].specularColor[1], pLights[i].specularColor[2]);
+		light.focalStrength = pLights[i].focalStrength;
+		light.specularIntensity = pLights[i].specularIntensity;
+		AddLight(light);
+	}
+	if (lightCount > 0)
+	{
+		m_bUseLighting = true;
+	}
+}
+
+/***********************************************************
+ *  AddSceneFileObjects()
+ *
+ *  This method is used for adding every object of the
+ *  compiled scene to the entity store in a single pass over
+ *  the mapped records.  The texture and material references
+ *  were resolved when the scene was compiled, so no tags
+ *  are looked up here.
+ ***********************************************************/
+void SceneManager::AddSceneFileObjects()
+{
+	const SCENE_OBJECT_RECORD* pObjects = m_pSceneFile->GetObjects();
+	uint32_t objectCount = m_pSceneFile->GetObjectCount();
+
+	m_pEntities->Reserve(m_pEntities->GetEntityCount() + objectCount);
+
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		const SCENE_OBJECT_RECORD& object = pObjects[i];
+		ENTITY_DESC desc;
+
+		desc.mesh = (SCENE_MESH)object.mesh;
+		desc.scale = glm::vec3(object.scale[0], object.scale[1], object.scale[2]);
+		desc.rotationDegrees = glm::vec3(object.rotation[0], object.rotation[1], object.rotation[2]);
+		desc.position = glm::vec3(object.position[0], object.position[1], object.position[2]);
+		desc.color = glm::vec4(object.color[0], object.color[1], object.color[2], object.color[3]);
+		desc.uvScale = glm::vec2(object.uvScale[0], object.uvScale[1]);
+		desc.textureSlot = -1;
+		desc.materialIndex = -1;
+		desc.windStiffness = 0.0f;
+
+		if ((object.textureIndex >= 0) && (object.textureIndex < (int32_t)m_sceneTextureSlots.size()))
+		{
+			desc.textureSlot = m_sceneTextureSlots[object.textureIndex];
+			desc.windStiffness = m_sceneTextureWind[object.textureIndex];
+		}
+		if ((object.materialIndex >= 0) && (object.materialIndex < (int32_t)m_pSceneFile->GetMaterialCount()))
+		{
+			desc.materialIndex = (int)(m_sceneMaterialBase + object.materialIndex);
+		}
+
+		m_pEntities->CreateEntity(desc);
+	}
+}
+
+/***********************************************************
+ *  AddSceneObject()
+ *
+ *  This method is used for adding one object to the entity
+ *  store, looking up its texture and material by tag.  The
+ *  object's instance record is uploaded on the next frame.
+ ***********************************************************/
+EntityID SceneManager::AddSceneObject(
+	SCENE_MESH mesh,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegreesXYZ,
+	glm::vec3 positionXYZ,
+	glm::vec4 color,
+	std::string textureTag,
+	std::string materialTag)
+{
+	ENTITY_DESC desc;
+
+	desc.mesh = mesh;
+	desc.scale = scaleXYZ;
+	desc.rotationDegrees = rotationDegreesXYZ;
+	desc.position = positionXYZ;
+	desc.color = color;
+	desc.uvScale = glm::vec2(1.0f, 1.0f);
+	desc.textureSlot = FindTextureSlot(textureTag);
+	desc.materialIndex = FindMaterialIndex(materialTag);
+	desc.windStiffness = GetFoliageStiffness(textureTag.c_str());
+
+	return(m_pEntities->CreateEntity(desc));
+}
+
+/***********************************************************
+ *  ImportModel()
+ *
+ *  This method is used for importing a model file, adding
+ *  its materials to the materials list as "<model>/<name>"
+ *  and uploading its meshes with their levels of detail.
+ *  The meshes are numbered after the basic shapes, and the
+ *  entities keep the mesh number in a byte, so only so many
+ *  imported meshes fit.
+ ***********************************************************/
+int SceneManager::ImportModel(const char* filename, const std::vector<float>& lodRatios)
+{
+	if (NULL == m_pModelMeshes)
+	{
+		std::cout << "WARNING: models can only be imported for the OpenGL backend after the scene is prepared" << std::endl;
+		return(-1);
+	}
+	if (ModelPack::IsPackFilename(filename))
+	{
+		ModelPack pack;
+		if (pack.Load(filename) == false)
+		{
+			return(-1);
+		}
+		return(AddModelPack(pack));
+	}
+
+	IMPORTED_MODEL model;
+	if (ModelImporter::Import(filename, model, lodRatios) == false)
+	{
+		return(-1);
+	}
+	return(AddImportedModel(model));
+}
+
+/***********************************************************
+ *  AddImportedModel()
+ *
+ *  This method is used for adding the materials of a model
+ *  imported by ModelImporter and uploading its meshes, for
+ *  ImportModel() or after importing it on another thread.
+ ***********************************************************/
+int SceneManager::AddImportedModel(const IMPORTED_MODEL& model)
+{
+	if (NULL == m_pModelMeshes)
+	{
+		std::cout << "WARNING: models can only be imported for the OpenGL backend after the scene is prepared" << std::endl;
+		return(-1);
+	}
+	if (SCENE_MESH_COUNT + m_pModelMeshes->GetMeshCount() + model.meshes.size() > 256)
+	{
+		std::cout << "WARNING: no room for the " << model.meshes.size() << " meshes of the model " << model.name << std::endl;
+		return(-1);
+	}
+
+	std::vector<int> materialIndexes;
+	for (const IMPORTED_MATERIAL& imported : model.materials)
+	{
+		OBJECT_MATERIAL material;
+		material.ambientStrength = imported.ambientStrength;
+		material.ambientColor = imported.ambientColor;
+		material.diffuseColor = imported.diffuseColor;
+		material.specularColor = imported.specularColor;
+		material.shininess = imported.shininess;
+		material.tag = model.name + "/" + imported.name;
+		materialIndexes.push_back(AddMaterial(material));
+	}
+
+	std::vector<MODEL_PART> parts;
+	for (const IMPORTED_MESH& mesh : model.meshes)
+	{
+		int index = m_pModelMeshes->AddMesh(
+			model.name + "/" + mesh.name,
+			mesh.vertices.data(),
+			(uint32_t)mesh.vertices.size(),
+			mesh.indices.data(),
+			(uint32_t)mesh.indices.size(),
+			mesh.lods);
+		if (index < 0)
+		{
+			continue;
+		}
+
+		MODEL_PART part;
+		part.mesh = (SCENE_MESH)(SCENE_MESH_COUNT + index);
+		part.color = (mesh.material >= 0) ? model.materials[mesh.material].baseColor : glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
+		part.materialIndex = (mesh.material >= 0) ? materialIndexes[mesh.material] : -1;
+		m_pEntities->SetMeshRadius(part.mesh, mesh.radius);
+		parts.push_back(part);
+	}
+
+	m_models.push_back(parts);
+	return((int)m_models.size() - 1);
+}
+
+/***********************************************************
+ *  AddModelPack()
+ *
+ *  This method is used for adding a mapped model pack the
+ *  way AddImportedModel() adds an imported model, decoding
+ *  its meshes straight into their buffers.  The pack only
+ *  has to stay mapped until this returns.
+ ***********************************************************/
+int SceneManager::AddModelPack(const ModelPack& pack)
+{
+	if (NULL == m_pModelMeshes)
+	{
+		std::cout << "WARNING: models can only be imported for the OpenGL backend after the scene is prepared" << std::endl;
+		return(-1);
+	}
+	std::string modelName = pack.GetName();
+	if (SCENE_MESH_COUNT + m_pModelMeshes->GetMeshCount() + pack.GetMeshCount() > 256)
+	{
+		std::cout << "WARNING: no room for the " << pack.GetMeshCount() << " meshes of the model " << modelName << std::endl;
+		return(-1);
+	}
+
+	std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+	std::vector<int> materialIndexes;
+	const MODEL_PACK_MATERIAL_RECORD* pMaterials = pack.GetMaterials();
+	for (uint32_t i = 0; i < pack.GetMaterialCount(); i++)
+	{
+		OBJECT_MATERIAL material;
+		material.ambientStrength = pMaterials[i].ambientStrength;
+		material.ambientColor = glm::make_vec3(pMaterials[i].ambientColor);
+		material.diffuseColor = glm::make_vec3(pMaterials[i].diffuseColor);
+		material.specularColor = glm::make_vec3(pMaterials[i].specularColor);
+		material.shininess = pMaterials[i].shininess;
+		material.tag = modelName + "/" + pack.GetString(pMaterials[i].nameOffset);
+		materialIndexes.push_back(AddMaterial(material));
+	}
+
+	size_t uploadedBytes = m_pModelMeshes->GetUploadedBytes();
+	std::vector<MODEL_PART> parts;
+	const MODEL_PACK_MESH_RECORD* pMeshes = pack.GetMeshes();
+	for (uint32_t i = 0; i < pack.GetMeshCount(); i++)
+	{
+		std::string meshName = pack.GetString(pMeshes[i].nameOffset);
+		int index = m_pModelMeshes->AddEncodedMesh(
+			modelName + "/" + meshName,
+			pack.GetEncodedMesh(i),
+			pMeshes[i].encodedSize);
+		if (index < 0)
+		{
+			std::cout << "WARNING: could not decode the mesh " << meshName << " of the model pack " << modelName << std::endl;
+			continue;
+		}
+
+		int32_t material = pMeshes[i].material;
+		MODEL_PART part;
+		part.mesh = (SCENE_MESH)(SCENE_MESH_COUNT + index);
+		part.color = (material >= 0) ? glm::make_vec4(pMaterials[material].baseColor) : glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
+		part.materialIndex = (material >= 0) ? materialIndexes[material] : -1;
+		m_pEntities->SetMeshRadius(part.mesh, pMeshes[i].radius);
+		parts.push_back(part);
+	}
+
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+	std::cout << "INFO: loaded model pack " << modelName << ": " << parts.size() << " meshes, "
+		<< pack.GetFileSize() / 1024 << " KB decoded into " << (m_pModelMeshes->GetUploadedBytes() - uploadedBytes) / 1024
+		<< " KB of buffers in " << milliseconds << " ms" << std::endl;
+
+	m_models.push_back(parts);
+	return((int)m_models.size() - 1);
+}
+
+/***********************************************************
+ *  AddModelObject()
+ *
+ *  This method is used for adding one object for each part
+ *  of an imported model, all with the same transform, and
+ *  returning them in the passed in list.
+ ***********************************************************/
+bool SceneManager::AddModelObject(
+	int model,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegreesXYZ,
+	glm::vec3 positionXYZ,
+	std::vector<EntityID>& objects)
+{
+	if ((model < 0) || ((size_t)model >= m_models.size()))
+	{
+		return(false);
+	}
+
+	for (const MODEL_PART& part : m_models[model])
+	{
+		ENTITY_DESC desc;
+		desc.mesh = part.mesh;
+		desc.scale = scaleXYZ;
+		desc.rotationDegrees = rotationDegreesXYZ;
+		desc.position = positionXYZ;
+		desc.color = part.color;
+		desc.uvScale = glm::vec2(1.0f, 1.0f);
+		desc.textureSlot = -1;
+		desc.materialIndex = part.materialIndex;
+		desc.windStiffness = 0.0f;
+		objects.push_back(m_pEntities->CreateEntity(desc));
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of a defined
+ *  material in the materials list, or -1 if not found.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(std::string tag)
+{
+	for (size_t index = 0; index < m_objectMaterials.size(); index++)
+	{
+		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		{
+			return((int)index);
+		}
+	}
+	return(-1);
+}
+
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for setting the camera matrices that
+ *  the scene objects are culled against and the particles
+ *  are drawn with.
+ ***********************************************************/
+void SceneManager::SetViewProjection(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_view = view;
+	m_projection = projection;
+	m_viewProjection = projection * view;
+	m_viewPosition = glm::vec3(glm::inverse(view)[3]);
+	m_bViewProjectionSet = true;
+	m_bLayeredView = false;
+}
+
+/***********************************************************
+ *  SetLayeredView()
+ *
+ *  This method is used for setting up a pass that draws
+ *  every object into several layers at once.  The camera
+ *  matrices in the frame block become identity, so the scene
+ *  vertex shader outputs world positions, and the objects
+ *  are culled a single time against a volume that holds all
+ *  of the layers' frustums.
+ ***********************************************************/
+void SceneManager::SetLayeredView(const glm::mat4& cullViewProjection, const glm::vec3& viewPosition)
+{
+	m_view = glm::mat4(1.0f);
+	m_projection = glm::mat4(1.0f);
+	m_viewProjection = cullViewProjection;
+	m_viewPosition = viewPosition;
+	m_bViewProjectionSet = true;
+	m_bLayeredView = true;
+}
+
+/***********************************************************
+ *  RemoveObject()
+ *
+ *  This method is used for removing a scene object.  Only
+ *  the instance record moved into its place is uploaded.
+ ***********************************************************/
+bool SceneManager::RemoveObject(EntityID object)
+{
+	return(m_pEntities->DestroyEntity(object));
+}
+
+/***********************************************************
+ *  MoveObject()
+ *
+ *  This method is used for changing the scale, rotation and
+ *  position of a scene object.
+ ***********************************************************/
+bool SceneManager::MoveObject(
+	EntityID object,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegreesXYZ,
+	glm::vec3 positionXYZ)
+{
+	if (m_pEntities->IsAlive(object) == false)
+	{
+		return(false);
+	}
+	m_pEntities->SetTransform(object, scaleXYZ, rotationDegreesXYZ, positionXYZ);
+	return(true);
+}
+
+/***********************************************************
+ *  SetObjectColor()
+ *
+ *  This method is used for recoloring a scene object.
+ ***********************************************************/
+bool SceneManager::SetObjectColor(EntityID object, glm::vec4 color)
+{
+	if (m_pEntities->IsAlive(object) == false)
+	{
+		return(false);
+	}
+	m_pEntities->SetColor(object, color);
+	return(true);
+}
+
+/***********************************************************
+ *  SetObjectTexture()
+ *
+ *  This method is used for changing the texture of a scene
+ *  object.  An unknown tag leaves the object untextured.
+ ***********************************************************/
+bool SceneManager::SetObjectTexture(EntityID object, std::string textureTag)
+{
+	if (m_pEntities->IsAlive(object) == false)
+	{
+		return(false);
+	}
+	m_pEntities->SetTexture(object, FindTextureSlot(textureTag));
+	return(true);
+}
+
+/***********************************************************
+ *  SetObjectMaterial()
+ *
+ *  This method is used for changing the material of a scene
+ *  object.  An unknown tag leaves the object without one.
+ ***********************************************************/
+bool SceneManager::SetObjectMaterial(EntityID object, std::string materialTag)
+{
+	if (m_pEntities->IsAlive(object) == false)
+	{
+		return(false);
+	}
+	m_pEntities->SetMaterial(object, FindMaterialIndex(materialTag));
+	return(true);
+}
 
-	// Error loading the image
-	return false;
+/***********************************************************
+ *  SetObjectHidden()
+ *
+ *  This method is used for hiding or showing a scene object.
+ ***********************************************************/
+bool SceneManager::SetObjectHidden(EntityID object, bool bHidden)
+{
+	if (m_pEntities->IsAlive(object) == false)
+	{
+		return(false);
+	}
+	m_pEntities->SetHidden(object, bHidden);
+	return(true);
 }
 
 /***********************************************************
- *  BindGLTextures()
+ *  SetObjectWindStiffness()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for changing how much the wind bends
+ *  a scene object.  Zero makes the object rigid.
  ***********************************************************/
-void SceneManager::BindGLTextures()
+bool SceneManager::SetObjectWindStiffness(EntityID object, float windStiffness)
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	if (m_pEntities->IsAlive(object) == false)
 	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		return(false);
 	}
+	m_pEntities->SetWindStiffness(object, windStiffness);
+	return(true);
 }
 
 /***********************************************************
- *  DestroyGLTextures()
+ *  SetFrameTime()
  *
- *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  This method is used for setting the time in seconds that
+ *  the wind animation of the next frame is evaluated at.
  ***********************************************************/
-void SceneManager::DestroyGLTextures()
+void SceneManager::SetFrameTime(double timeSeconds)
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	m_frameTime = timeSeconds;
+}
+
+/***********************************************************
+ *  BeginSharedFrame()
+ *
+ *  This method is used for starting a frame that several
+ *  views are drawn into, such as the viewports of one
+ *  offscreen target.  Each view still writes its own
+ *  constants, but the device begins and ends the frame
+ *  only once, so the views do not wait on the fences of
+ *  each other.
+ ***********************************************************/
+void SceneManager::BeginSharedFrame()
+{
+	m_bSharedFrame = true;
+	m_bSharedFrameBegun = false;
+}
+
+/***********************************************************
+ *  EndSharedFrame()
+ *
+ *  This method is used for ending the frame started by
+ *  BeginSharedFrame() once its last view has been drawn.
+ ***********************************************************/
+void SceneManager::EndSharedFrame()
+{
+	if (m_bSharedFrameBegun && (NULL != m_pRenderDevice))
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		m_pRenderDevice->EndFrame();
 	}
+	m_bSharedFrame = false;
+	m_bSharedFrameBegun = false;
 }
 
 /***********************************************************
- *  FindTextureID()
+ *  SetRenderBackend()
  *
- *  This method is used for getting an ID for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for choosing whether the scene is
+ *  drawn with OpenGL or the software rasterizer, and the
+ *  size of the software rasterizer's image.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+void SceneManager::SetRenderBackend(RENDER_BACKEND backend, int width, int height)
 {
-	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
+	m_renderBackend = backend;
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	if (backend == RENDER_BACKEND_SOFTWARE)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		if (NULL == m_pSoftwareRasterizer)
 		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
+			m_pSoftwareRasterizer = new SoftwareRasterizer(width, height);
 		}
 		else
-			index++;
+		{
+			m_pSoftwareRasterizer->Resize(width, height);
+		}
+	}
+	else if (NULL != m_pSoftwareRasterizer)
+	{
+		delete m_pSoftwareRasterizer;
+		m_pSoftwareRasterizer = NULL;
 	}
 
-	return(textureID);
+	if (backend == RENDER_BACKEND_PATH_TRACER)
+	{
+		if (NULL == m_pPathTracer)
+		{
+			m_pPathTracer = new PathTracer(width, height);
+		}
+		else
+		{
+			m_pPathTracer->Resize(width, height);
+		}
+		m_pathTracedFrameTime = -1.0;
+	}
+	else if (NULL != m_pPathTracer)
+	{
+		delete m_pPathTracer;
+		m_pPathTracer = NULL;
+	}
 }
 
 /***********************************************************
- *  FindTextureSlot()
+ *  AddMaterial()
  *
- *  This method is used for getting a slot index for the previously
- *  loaded texture bitmap associated with the passed in tag.
+ *  This method is used for adding a material to the
+ *  materials list and returning its index.  A material with
+ *  an existing tag is modified instead.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::AddMaterial(const OBJECT_MATERIAL& material)
 {
-	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
-
-	while ((index < m_loadedTextures) && (bFound == false))
+	int index = FindMaterialIndex(material.tag);
+	if (index >= 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureSlot = index;
-			bFound = true;
-		}
-		else
-			index++;
+		ModifyMaterial(material);
+		return(index);
 	}
 
-	return(textureSlot);
+	m_objectMaterials.push_back(material);
+	index = (int)m_objectMaterials.size() - 1;
+
+	// the record is written when the buffer catches up with the
+	// list on the next flush
+	return(index);
 }
 
 /***********************************************************
-* LoadSceneTextures()
-*
-* This method is used for preparing the 3D scene by loading
-* the shapes, textures in memory to support the 3D scene
-* rendering
-***********************************************************/
-void SceneManager::LoadSceneTextures()
+ *  ModifyMaterial()
+ *
+ *  This method is used for changing the values of the
+ *  material with the same tag.
+ ***********************************************************/
+bool SceneManager::ModifyMaterial(const OBJECT_MATERIAL& material)
 {
-	bool bReturn = false;
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/stoneTexture.jpg",
-		"stone");
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/bushTexture.jpg",
-		"bush");
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/groundTexture.jpg",
-		"ground");
-	bReturn = CreateGLTexture(
-		"../../Utilities/textures/skyTexture.jpg",
-		"sky");
+	int index = FindMaterialIndex(material.tag);
+	if (index < 0)
+	{
+		return(false);
+	}
 
-	// after the texture image data is loaded into memory, the
-	// loaded textures need to be bound to texture slots - there
-	// are a total of 16 available slots for scene textures
-	BindGLTextures();
+	m_objectMaterials[index] = material;
+	WriteMaterialRecord((size_t)index);
+	return(true);
 }
 
 /***********************************************************
- *  FindMaterial()
+ *  RemoveMaterial()
  *
- *  This method is used for getting a material from the previously
- *  defined materials list that is associated with the passed in tag.
+ *  This method is used for removing a material.  The last
+ *  material is moved into its slot, so only that record and
+ *  the objects that used either material are uploaded.
+ *  Objects using the removed material are left without one.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+bool SceneManager::RemoveMaterial(std::string materialTag)
 {
-	if (m_objectMaterials.size() == 0)
+	int index = FindMaterialIndex(materialTag);
+	if (index < 0)
 	{
 		return(false);
 	}
+	int lastIndex = (int)m_objectMaterials.size() - 1;
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	RemapStaticMaterial(index, -1);
+	m_pEntities->RemapMaterial(index, -1);
+	if (index != lastIndex)
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
+		m_objectMaterials[index] = m_objectMaterials[lastIndex];
+		RemapStaticMaterial(lastIndex, index);
+		m_pEntities->RemapMaterial(lastIndex, index);
 	}
+	m_objectMaterials.pop_back();
 
+	// materials not uploaded yet are written by the next flush
+	if (m_pMaterialBuffer->GetCount() > m_objectMaterials.size())
+	{
+		m_pMaterialBuffer->Resize(m_objectMaterials.size());
+	}
+	if ((size_t)index < m_pMaterialBuffer->GetCount())
+	{
+		WriteMaterialRecord((size_t)index);
+	}
 	return(true);
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  AddLight()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for adding a light source and
+ *  returning its index.
  ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
+int SceneManager::AddLight(const LIGHT_SOURCE& light)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
+	m_lightSources.push_back(light);
+	size_t index = m_lightSources.size() - 1;
 
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+	m_pLightBuffer->Resize(m_lightSources.size());
+	WriteLightRecord(index);
+	return((int)index);
+}
 
-	if (NULL != m_pShaderManager)
+/***********************************************************
+ *  ModifyLight()
+ *
+ *  This method is used for changing a light source.
+ ***********************************************************/
+bool SceneManager::ModifyLight(int index, const LIGHT_SOURCE& light)
+{
+	if ((index < 0) || (index >= (int)m_lightSources.size()))
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		return(false);
 	}
+
+	m_lightSources[index] = light;
+	WriteLightRecord((size_t)index);
+	return(true);
 }
 
 /***********************************************************
- *  SetShaderColor()
+ *  RemoveLight()
  *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  This method is used for removing a light source.  Light
+ *  order does not matter to the shader, so the last light
+ *  is moved into its slot.
  ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
+bool SceneManager::RemoveLight(int index)
 {
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
+	if ((index < 0) || (index >= (int)m_lightSources.size()))
+	{
+		return(false);
+	}
 
-	if (NULL != m_pShaderManager)
+	size_t lastIndex = m_lightSources.size() - 1;
+	if ((size_t)index != lastIndex)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		m_lightSources[index] = m_lightSources[lastIndex];
+		m_pLightBuffer->Move(lastIndex, (size_t)index);
 	}
+	m_lightSources.pop_back();
+	m_pLightBuffer->Resize(m_lightSources.size());
+	return(true);
 }
 
 /***********************************************************
- *  SetShaderTexture()
+ *  WriteMaterialRecord()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for copying one material into the
+ *  material buffer.
  ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
+void SceneManager::WriteMaterialRecord(size_t index)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+	const OBJECT_MATERIAL& material = m_objectMaterials[index];
+
+	MATERIAL_RECORD record;
+	record.ambientColor = material.ambientColor;
+	record.ambientStrength = material.ambientStrength;
+	record.diffuseColor = material.diffuseColor;
+	record.shininess = material.shininess;
+	record.specularColor = material.specularColor;
+	record.reserved = 0.0f;
+	m_pMaterialBuffer->Write(index, &record);
+}
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
-	}
+/***********************************************************
+ *  WriteLightRecord()
+ *
+ *  This method is used for copying one light source into
+ *  the light buffer.
+ ***********************************************************/
+void SceneManager::WriteLightRecord(size_t index)
+{
+	const LIGHT_SOURCE& light = m_lightSources[index];
+
+	LIGHT_RECORD record;
+	record.position = light.position;
+	record.focalStrength = light.focalStrength;
+	record.ambientColor = light.ambientColor;
+	record.specularIntensity = light.specularIntensity;
+	record.diffuseColor = light.diffuseColor;
+	record.reserved0 = 0.0f;
+	record.specularColor = light.specularColor;
+	record.reserved1 = 0.0f;
+	m_pLightBuffer->Write(index, &record);
+}
+
+/***********************************************************
+ *  WriteStaticRecord()
+ *
+ *  This method is used for copying one static shrine draw
+ *  into its record at the start of the instance buffer.
+ ***********************************************************/
+void SceneManager::WriteStaticRecord(size_t index)
+{
+	const STATIC_DRAW& draw = g_ShrineTable.draws[index];
+
+	INSTANCE_RECORD record;
+	record.world = glm::make_mat4(draw.world);
+	record.color = glm::vec4(draw.color[0], draw.color[1], draw.color[2], draw.color[3]);
+	record.uvScale = glm::vec2(1.0f, 1.0f);
+	record.materialIndex = m_staticMaterialIndexes[index];
+	record.windStiffness = GetFoliageStiffness(draw.textureTag);
+	record.windPhase = WindSystem::GetInstancePhase(
+		glm::vec3(draw.boundsCenter[0], draw.boundsCenter[1], draw.boundsCenter[2]));
+	record.reserved[0] = record.reserved[1] = record.reserved[2] = 0.0f;
+	m_pInstanceBuffer->Write(index, &record);
 }
 
 /***********************************************************
- *  SetTextureUVScale()
+ *  RemapStaticMaterial()
  *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  This method is used for pointing the static draws that
+ *  use one material index at another.
  ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
+void SceneManager::RemapStaticMaterial(int fromIndex, int toIndex)
 {
-	if (NULL != m_pShaderManager)
+	for (size_t i = 0; i < m_staticInstanceCount; i++)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		if (m_staticMaterialIndexes[i] == fromIndex)
+		{
+			m_staticMaterialIndexes[i] = toIndex;
+			WriteStaticRecord(i);
+		}
 	}
 }
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  UpdateSceneRecords()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for writing the scene changes made
+ *  since the last frame into the shadow copies of the
+ *  instance and material buffers.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+void SceneManager::UpdateSceneRecords()
 {
-	if (m_objectMaterials.size() > 0)
+	// materials pushed straight onto the list, such as the ones
+	// made by DefineObjectMaterials() or a scene file
+	size_t uploadedMaterials = m_pMaterialBuffer->GetCount();
+	if (m_objectMaterials.size() > uploadedMaterials)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+		m_pMaterialBuffer->Resize(m_objectMaterials.size());
+		for (size_t i = uploadedMaterials; i < m_objectMaterials.size(); i++)
 		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			WriteMaterialRecord(i);
 		}
 	}
+
+	m_pEntities->FlushInstances(*m_pInstanceBuffer, m_staticInstanceCount);
+}
+
+/***********************************************************
+ *  FlushSceneEdits()
+ *
+ *  This method is used for writing the scene changes made
+ *  since the last frame into the shadow buffers, then handing
+ *  them to the render device with the camera and lighting.
+ *  The device uploads only the dirty ranges, or reads the
+ *  shadow copies directly.
+ ***********************************************************/
+void SceneManager::FlushSceneEdits()
+{
+	UpdateSceneRecords();
+
+	if (NULL == m_pRenderDevice)
+	{
+		return;
+	}
+
+	RENDER_FRAME frame = {};
+	frame.pInstances = m_pInstanceBuffer;
+	frame.pMaterials = m_pMaterialBuffer;
+	frame.pLights = m_pLightBuffer;
+	frame.constants.view = m_view;
+	frame.constants.projection = m_projection;
+	frame.constants.viewPosition = glm::vec4(m_viewPosition, 1.0f);
+	frame.constants.bUseLighting = m_bUseLighting ? 1 : 0;
+	frame.constants.lightCount = (int32_t)m_lightSources.size();
+	frame.pWind = m_pWind;
+	frame.time = m_frameTime;
+	frame.bSameFrame = m_bSharedFrameBegun;
+	m_pRenderDevice->BeginFrame(frame);
+	m_bSharedFrameBegun = m_bSharedFrame;
 }
 
 /**************************************************************/
@@ -498,81 +1485,86 @@ void SceneManager::DefineObjectMaterials()
  *  SetupSceneLights()
  *
  *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
+ *  sources for the 3D scene.
  ***********************************************************/
 void SceneManager::SetupSceneLights()
 {
-	// this line of code is NEEDED for telling the shaders to render 
-	// the 3D scene with custom lighting, if no light sources have
-	// been added then the display window will be black - to use the 
-	// default OpenGL lighting then comment out the following line
-	//m_pShaderManager->setBoolValue(g_UseLightingName, true);
+	// the shaders render the 3D scene with custom lighting once
+	// m_bUseLighting is set at the end of this method, so if no light
+	// sources have been added then the display window will be black
 
 	/*** STUDENTS - add the code BELOW for setting up light sources ***/
-	/*** Up to four light sources can be defined. Refer to the code ***/
-	/*** in the OpenGL Sample for help                              ***/
+	/*** Each light is added to the light buffer with AddLight()   ***/
+	/*** Refer to the code in the OpenGL Sample for help           ***/
+
+	LIGHT_SOURCE light = {};
 
 	//light source 1 - mimicking the sun at midday (slight yellow tint)
 	
 	//sunlight angle 30-45 degrees above the horixon
-	m_pShaderManager->setVec3Value("lightSources[0].position", 10.0f, 14.0f, 5.0f);
+	light.position = glm::vec3(10.0f, 14.0f, 5.0f);
 	//light blue tint for the sky
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.2f, 0.2f, 0.5f);
+	light.ambientColor = glm::vec3(0.2f, 0.2f, 0.5f);
 	//yellowish sunlight tone
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 1.0f, 0.95f, 0.8f);
+	light.diffuseColor = glm::vec3(1.0f, 0.95f, 0.8f);
 	//bright highlights
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 1.0f, 1.0f, 0.9f);
+	light.specularColor = glm::vec3(1.0f, 1.0f, 0.9f);
 	//shininess factor
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 64.0f);
+	light.focalStrength = 64.0f;
 	//intensity for reflective areas
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.8f);
+	light.specularIntensity = 0.8f;
+	AddLight(light);
 
 
 	//after more research - adding more sources of light as light bounces off and it is not just from the sunlight
 	//light source 2 - Fill light - light reflecting off surrounding objects
 
 	//opposite side of the sunlight
-	m_pShaderManager->setVec3Value("lightSources[1].position", -5.0f, 5.0f, -3.0f);
+	light.position = glm::vec3(-5.0f, 5.0f, -3.0f);
 	//soft green tint for light reflecting off the bushes
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.05f, 0.1f, 0.05f);
+	light.ambientColor = glm::vec3(0.05f, 0.1f, 0.05f);
 	//low intensity, greenish fill light
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.2f, 0.3f, 0.2f);
+	light.diffuseColor = glm::vec3(0.2f, 0.3f, 0.2f);
 	//Fill
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.0f, 0.0f, 0.0f);
-	//m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 32.0f);
+	light.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+	//light.focalStrength = 32.0f;
 	//no reflection
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.0f);
+	light.specularIntensity = 0.0f;
+	AddLight(light);
 
 	//light source 3 - Bounce Light  - stimulating the light bouncing off the ground
 	
 	//near the ground, close to the monument
-	m_pShaderManager->setVec3Value("lightSources[2].position", 0.0f, 0.5f, 0.0f);
+	light.position = glm::vec3(0.0f, 0.5f, 0.0f);
 	//warm reflection off the ground
-	m_pShaderManager->setVec3Value("lightSources[2].ambientColor", 0.05f, 0.04f, 0.03f);
+	light.ambientColor = glm::vec3(0.05f, 0.04f, 0.03f);
 	//low intensity, soft light
-	m_pShaderManager->setVec3Value("lightSources[2].diffuseColor", 0.1f, 0.1f, 0.08f);
+	light.diffuseColor = glm::vec3(0.1f, 0.1f, 0.08f);
 	//No specular
-	m_pShaderManager->setVec3Value("lightSources[2].specularColor", 0.0f, 0.0f, 0.0f);
-	//m_pShaderManager->setFloatValue("lightSources[2].focalStrength", 23.0f);
+	light.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+	//light.focalStrength = 23.0f;
 	//no specular reflection
-	m_pShaderManager->setFloatValue("lightSources[2].specularIntensity", 0.0f);
+	light.specularIntensity = 0.0f;
+	AddLight(light);
 
 	//light soure 4 - Backlight to provide constrast, ligthing the scene from behind the monument
 
 	//behind the monument
-	m_pShaderManager->setVec3Value("lightSources[3].position", 0.0f, 14.0f, -10.0f);
+	light.position = glm::vec3(0.0f, 14.0f, -10.0f);
 	//soft backlight
-	m_pShaderManager->setVec3Value("lightSources[3].ambientColor", 0.05f, 0.05f, 0.05f);
+	light.ambientColor = glm::vec3(0.05f, 0.05f, 0.05f);
 	//low intensity
-	m_pShaderManager->setVec3Value("lightSources[3].diffuseColor", 0.2f, 0.2f, 0.2f);
+	light.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
 	//no specular
-	m_pShaderManager->setVec3Value("lightSources[3].specularColor", 0.0f, 0.0f, 0.0f);
-	//m_pShaderManager->setFloatValue("lightSources[3].focalStrength", 23.0f);
+	light.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+	//light.focalStrength = 23.0f;
 	//no specular reflection
-	m_pShaderManager->setFloatValue("lightSources[3].specularIntensity", 0.0f);
+	light.specularIntensity = 0.0f;
+	AddLight(light);
 
-	//enabling custom lighting
-	m_pShaderManager->setBoolValue("bUseLighting", true);
+	//enabling custom lighting - handed to the shaders in the
+	//per-frame uniform block
+	m_bUseLighting = true;
 }
 
 /***********************************************************
@@ -586,301 +1578,419 @@ void SceneManager::PrepareScene()
 {
 	// load the texture image files for the textures applied
 	// to objects in the 3D scene
-	LoadSceneTextures();
+	if (NULL != m_pSceneFile)
+	{
+		LoadSceneFileResources();
+	}
+	else
+	{
+		LoadSceneTextures();
+	}
+	FreeDecodedImages();
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+	// in the rendered 3D scene - the CPU backends build their
+	// own copies, so they make no OpenGL calls at all
+	if (m_renderBackend == RENDER_BACKEND_OPENGL)
+	{
+		// take ownership of the vertex arrays and buffers created by the
+		// mesh loading, so they are tracked and freed on shutdown - the
+		// meshes are loaded one at a time, so their objects are
+		// registered and labelled under the mesh name
+		auto adoptMesh = [this](const char* meshName, const std::function<void()>& load)
+		{
+			std::vector<GLuint> buffers;
+			std::vector<GLuint> vertexArrays;
+			GLResourceManager::AdoptNewObjects(meshName, MemoryTracker::MEMTAG_MESHES, load, buffers, vertexArrays);
+			for (GLuint name : buffers)
+			{
+				GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, name, meshName);
+				m_meshBuffers.push_back(GLBufferHandle::AdoptRegistered(name));
+			}
+			for (GLuint name : vertexArrays)
+			{
+				GL_DEBUG_LABEL(GLResourceManager::GLRES_VERTEX_ARRAY, name, meshName);
+				m_meshVertexArrays.push_back(GLVertexArrayHandle::AdoptRegistered(name));
+			}
+		};
+		adoptMesh("plane mesh", [this]() { m_basicMeshes->LoadPlaneMesh(); });
+		adoptMesh("torus mesh", [this]() { m_basicMeshes->LoadTorusMesh(); });
+		adoptMesh("box mesh", [this]() { m_basicMeshes->LoadBoxMesh(); });
+		adoptMesh("tapered cylinder mesh", [this]() { m_basicMeshes->LoadTaperedCylinderMesh(); });
+		adoptMesh("prism mesh", [this]() { m_basicMeshes->LoadPrismMesh(); });
+
+		// the scene shader is current, so the device can resolve
+		// its uniforms now
+		m_pUniformRing = new UniformRing("scene uniforms", g_UniformRingRegionBytes);
+		m_pModelMeshes = new ModelMeshes();
+		m_pRenderDevice = new GLRenderDevice(m_basicMeshes, m_pUniformRing, m_pModelMeshes);
+		m_pRenderDevice->Initialize();
+	}
+	else if (m_renderBackend == RENDER_BACKEND_SOFTWARE)
+	{
+		// the same command lists are drawn by the rasterizer
+		m_pRenderDevice = new SoftwareRenderDevice(m_pSoftwareRasterizer, &m_softwareTextures);
+		m_pRenderDevice->Initialize();
+	}
 
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadTorusMesh();
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadTaperedCylinderMesh();
-	m_basicMeshes->LoadPrismMesh();
+	// add the compiled scene objects to the entity store, or
+	// resolve the static shrine tables when no scene was loaded
+	if (NULL != m_pSceneFile)
+	{
+		AddSceneFileObjects();
+	}
+	else
+	{
+		// the path tracer has no light but the scene's own, so the
+		// hand-coded shrine gets its materials and lights for it -
+		// the raster backends keep drawing it unlit
+		if (m_renderBackend == RENDER_BACKEND_PATH_TRACER)
+		{
+			DefineObjectMaterials();
+			SetupSceneLights();
+		}
+		ResolveStaticScene();
+	}
 
+	// the particles are only drawn by the OpenGL backend
+	if (m_renderBackend == RENDER_BACKEND_OPENGL)
+	{
+		CreateParticleEffects();
+	}
 }
 
 /***********************************************************
- *  RenderScene()
+ *  CreateParticleEffects()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for loading the particle shaders and
+ *  adding the leaves falling over the shrine and the smoke
+ *  rising from the incense at its front.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::CreateParticleEffects()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// Bottom Plane - GROUND
-	
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+	if (!m_pParticles->Initialize("Shaders/particleVertex.glsl", "Shaders/particleFragment.glsl"))
+	{
+		return;
+	}
+
+	// leaves drift down and sideways across the whole scene
+	EMITTER_DESC leaves;
+	leaves.spawnExtents = glm::vec3(10.0f / g_LeafStripCount, 0.5f, 5.0f);
+	leaves.velocityMin = glm::vec3(-0.6f, -1.2f, -0.3f);
+	leaves.velocityMax = glm::vec3(0.6f, -0.6f, 0.6f);
+	leaves.acceleration = glm::vec3(0.15f, -0.4f, 0.0f);
+	leaves.drag = 0.3f;
+	leaves.spawnRate = 6.0f;
+	leaves.lifetimeMin = 8.0f;
+	leaves.lifetimeMax = 12.0f;
+	leaves.sizeStart = 0.08f;
+	leaves.sizeEnd = 0.06f;
+	leaves.colorStart = glm::vec4(0.85f, 0.45f, 0.1f, 1.0f);
+	leaves.colorEnd = glm::vec4(0.45f, 0.25f, 0.08f, 0.0f);
+	leaves.maxParticles = 128;
+	for (int strip = 0; strip < g_LeafStripCount; strip++)
+	{
+		float stripCenter = -10.0f + (2.0f * strip + 1.0f) * leaves.spawnExtents.x;
+		leaves.position = glm::vec3(stripCenter, 13.0f, 0.0f);
+		m_pParticles->AddEmitter(leaves);
+	}
+
+	// thin smoke rises and spreads from an incense stick at
+	// each side of the shrine entrance
+	EMITTER_DESC smoke;
+	smoke.spawnExtents = glm::vec3(0.02f, 0.02f, 0.02f);
+	smoke.velocityMin = glm::vec3(-0.05f, 0.3f, -0.05f);
+	smoke.velocityMax = glm::vec3(0.05f, 0.5f, 0.05f);
+	smoke.acceleration = glm::vec3(0.02f, 0.15f, 0.0f);
+	smoke.drag = 0.5f;
+	smoke.spawnRate = 40.0f;
+	smoke.lifetimeMin = 3.0f;
+	smoke.lifetimeMax = 5.0f;
+	smoke.sizeStart = 0.04f;
+	smoke.sizeEnd = 0.35f;
+	smoke.colorStart = glm::vec4(0.8f, 0.8f, 0.8f, 0.5f);
+	smoke.colorEnd = glm::vec4(0.6f, 0.6f, 0.65f, 0.0f);
+	smoke.maxParticles = 256;
+	smoke.position = glm::vec3(-3.0f, 0.8f, 5.0f);
+	m_pParticles->AddEmitter(smoke);
+	smoke.position = glm::vec3(3.0f, 0.8f, 5.0f);
+	m_pParticles->AddEmitter(smoke);
+}
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+/***********************************************************
+ *  ResolveStaticScene()
+ *
+ *  This method is used for looking up the texture slot and
+ *  material index of every precomputed static draw once and
+ *  writing its instance record, so the static part of each
+ *  frame needs no tag lookups or uploads.
+ ***********************************************************/
+void SceneManager::ResolveStaticScene()
+{
+	m_staticInstanceCount = g_ShrineTable.count;
+	m_staticTextureSlots.resize(g_ShrineTable.count);
+	m_staticMaterialIndexes.resize(g_ShrineTable.count);
+
+	// the static records never change, so they are written once
+	// at the start of the instance buffer
+	m_pInstanceBuffer->Resize(m_staticInstanceCount);
+	for (size_t i = 0; i < g_ShrineTable.count; i++)
+	{
+		const STATIC_DRAW& draw = g_ShrineTable.draws[i];
+		m_staticTextureSlots[i] = FindTextureSlot(draw.textureTag);
+		m_staticMaterialIndexes[i] = FindMaterialIndex(draw.materialTag);
+		WriteStaticRecord(i);
+	}
+}
+
+/***********************************************************
+ *  RecordSceneCommands()
+ *
+ *  This method is used for recording the frame's draws -
+ *  the static shrine draws inside the view frustum, then
+ *  the render packets.  The draws are split into command
+ *  lists of a fixed size that are culled and recorded in
+ *  parallel, and submitted in order, so the result is the
+ *  same as drawing them one by one.
+ ***********************************************************/
+void SceneManager::RecordSceneCommands()
+{
+	if (NULL == m_pRenderDevice)
+	{
+		return;
+	}
+
+	VIEW_FRUSTUM frustum;
+	if (m_bViewProjectionSet)
+	{
+		frustum.Extract(m_viewProjection);
+	}
+
+	// the static shrine is only drawn when no scene file replaced it
+	size_t staticCount = (NULL == m_pSceneFile) ? g_ShrineTable.count : 0;
+	size_t drawCount = staticCount + m_renderPackets.size();
+	size_t listCount = (drawCount + g_CommandListDraws - 1) / g_CommandListDraws;
+	if (m_commandLists.size() < listCount)
+	{
+		m_commandLists.resize(listCount);
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+	// the model space error one pixel stands for, at unit distance
+	// with a perspective projection or anywhere with an orthographic
+	// one - layered views have no single camera, so they always draw
+	// the full meshes
+	int targetHeight = m_pRenderDevice->GetTargetHeight();
+	bool bSelectLods = (NULL != m_pModelMeshes) && m_bViewProjectionSet && !m_bLayeredView &&
+		(targetHeight > 0) && (m_projection[1][1] > 0.0f);
+	bool bPerspective = (m_projection[3][3] == 0.0f);
+	float pixelError = bSelectLods ? g_LodPixelError * 2.0f / (m_projection[1][1] * (float)targetHeight) : 0.0f;
+
+	JobSystem::ParallelFor(listCount, 1,
+		[this, &frustum, staticCount, drawCount, bSelectLods, bPerspective, pixelError](size_t begin, size_t end)
+		{
+			for (size_t list = begin; list < end; list++)
+			{
+				RenderCommandList& commands = m_commandLists[list];
+				commands.Reset();
+
+				size_t last = std::min((list + 1) * g_CommandListDraws, drawCount);
+				for (size_t i = list * g_CommandListDraws; i < last; i++)
+				{
+					if (i < staticCount)
+					{
+						// skip the draws outside of the view frustum
+						const STATIC_DRAW& draw = g_ShrineTable.draws[i];
+						if (m_bViewProjectionSet &&
+							!frustum.IsSphereVisible(draw.boundsCenter[0], draw.boundsCenter[1], draw.boundsCenter[2], draw.boundsRadius))
+						{
+							continue;
+						}
+						commands.Draw((SCENE_MESH)draw.mesh, (uint32_t)i, m_staticTextureSlots[i]);
+					}
+					else
+					{
+						const RENDER_PACKET& packet = m_renderPackets[i - staticCount];
+						uint32_t lod = 0;
+						if (bSelectLods && (packet.mesh >= SCENE_MESH_COUNT))
+						{
+							// measured from the near side of the bounds, and
+							// scaled back into model units
+							float scale = std::max(std::max(
+								glm::length(glm::vec3(packet.world[0])),
+								glm::length(glm::vec3(packet.world[1]))),
+								glm::length(glm::vec3(packet.world[2])));
+							float allowedError = pixelError / std::max(scale, 1e-6f);
+							if (bPerspective)
+							{
+								float distance = glm::length(glm::vec3(packet.world[3]) - m_viewPosition) -
+									m_pEntities->GetMeshRadius((SCENE_MESH)packet.mesh) * scale;
+								allowedError *= std::max(distance, 0.0f);
+							}
+							lod = m_pModelMeshes->SelectLod(packet.mesh - SCENE_MESH_COUNT, allowedError);
+						}
+						commands.Draw((SCENE_MESH)packet.mesh, packet.instance, packet.textureSlot, lod);
+					}
+				}
+			}
+		});
+
+	m_pRenderDevice->Submit(m_commandLists.data(), listCount);
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  drawing the static shrine tables, then running the
+ *  entity systems and drawing the resulting render packets
+ *  through the render device.  With OpenGL the particles
+ *  are updated on the job system meanwhile and drawn last.
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	if (m_renderBackend == RENDER_BACKEND_PATH_TRACER)
+	{
+		RenderScenePathTraced();
+		return;
+	}
 
-	SetShaderColor(1, 1, 1, 1);
+	// advance the particles on the workers while the scene
+	// objects are drawn
+	JobCounterPtr particleJob;
+	if (m_renderBackend == RENDER_BACKEND_OPENGL)
+	{
+		float particleStep = 0.0f;
+		if (m_previousFrameTime >= 0.0)
+		{
+			particleStep = (float)std::min(std::max(m_frameTime - m_previousFrameTime, 0.0), (double)g_MaxParticleStep);
+		}
+		m_previousFrameTime = m_frameTime;
+		ParticleSystem* pParticles = m_pParticles;
+		particleJob = JobSystem::Submit(
+			[pParticles, particleStep]() { pParticles->Update(particleStep); });
+	}
 
-	//ground texture
-	SetShaderTexture("ground");
+	// rebuild the world matrices of any moved objects
+	m_pEntities->UpdateTransforms();
 
-	//lighting
-	SetShaderMaterial("bottomPlane");
+	// hand over only the instance, material and light records
+	// changed since the last frame
+	GL_DEBUG_PUSH_GROUP("scene uploads");
+	FlushSceneEdits();
+	GL_DEBUG_POP_GROUP();
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	/****************************************************************/
-	// Top Plane - Background
+	// skip the objects outside of the view frustum
+	if (m_bViewProjectionSet)
+	{
+		m_pEntities->CullEntities(m_viewProjection);
+	}
 
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+	// gather the visible objects sorted by mesh, texture and material
+	m_pEntities->BuildRenderPackets(m_renderPackets);
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	// record the static shrine and the packets, then draw them
+	GL_DEBUG_PUSH_GROUP("scene draws");
+	RecordSceneCommands();
+	GL_DEBUG_POP_GROUP();
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 9.0f, -10.0f);
+	// the particles are blended over the finished opaque scene -
+	// their shader has no layered variant
+	JobSystem::Wait(particleJob);
+	if ((m_renderBackend == RENDER_BACKEND_OPENGL) && m_bViewProjectionSet && !m_bLayeredView)
+	{
+		GL_DEBUG_PUSH_GROUP("particles");
+		m_pParticles->Render(m_view, m_projection);
+		GL_DEBUG_POP_GROUP();
+	}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	// the last view of a shared frame ends it instead
+	if ((NULL != m_pRenderDevice) && !m_bSharedFrame)
+	{
+		m_pRenderDevice->EndFrame();
+	}
+}
 
-	SetShaderColor(1, 1, 1, 1);
-
-	//sky texture
-	SetShaderTexture("sky");
-
-	//lighting
-	SetShaderMaterial("topPlane");
+/***********************************************************
+ *  GatherSoftwareScene()
+ *
+ *  This method is used for filling in the path tracer's frame
+ *  with the same draws that are handed to the render device
+ *  and the shadow copies of the instance, material and light
+ *  buffers.  The path tracer needs the draws behind the
+ *  camera too, for shadows and bounced light, so nothing is
+ *  culled.
+ ***********************************************************/
+void SceneManager::GatherSoftwareScene()
+{
+	SOFTWARE_SCENE& scene = m_softwareScene;
+	scene.draws.clear();
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	/****************************************************************/
+	// the static shrine is only drawn when no scene file replaced it
+	if (NULL == m_pSceneFile)
+	{
+		for (size_t i = 0; i < g_ShrineTable.count; i++)
+		{
+			const STATIC_DRAW& draw = g_ShrineTable.draws[i];
+			scene.draws.push_back({ (SCENE_MESH)draw.mesh, (uint32_t)i, m_staticTextureSlots[i] });
+		}
+	}
 
-	/****************************************************************/
-	// Torus
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(10.0f, 6.0f, 2.0f);
-
-	// set the XYZ rotation for the mesh
-	// rotated to 90 degress to match the ground
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	m_pEntities->MarkAllVisible();
+	m_pEntities->BuildRenderPackets(m_renderPackets);
+	for (const RENDER_PACKET& packet : m_renderPackets)
+	{
+		// imported meshes only exist on the GPU
+		if (packet.mesh >= SCENE_MESH_COUNT)
+		{
+			continue;
+		}
+		scene.draws.push_back({ (SCENE_MESH)packet.mesh, packet.instance, packet.textureSlot });
+	}
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 2.0f);
+	scene.pInstances = (const INSTANCE_RECORD*)m_pInstanceBuffer->Read(0);
+	scene.instanceCount = m_pInstanceBuffer->GetCount();
+	scene.pMaterials = (const MATERIAL_RECORD*)m_pMaterialBuffer->Read(0);
+	scene.materialCount = m_pMaterialBuffer->GetCount();
+	scene.pLights = (const LIGHT_RECORD*)m_pLightBuffer->Read(0);
+	scene.lightCount = m_pLightBuffer->GetCount();
+	scene.pTextures = m_softwareTextures.empty() ? NULL : &m_softwareTextures[0];
+	scene.textureCount = m_softwareTextures.size();
+	scene.bUseLighting = m_bUseLighting;
+	scene.wind = m_pWind->GetUniforms(m_frameTime);
+	scene.viewPosition = m_viewPosition;
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	//setting color to green - hedge torys
-	SetShaderColor(0.243, 0.651, 0.286, 1);
-
-	//torus texture
-	SetShaderTexture("bush");
-
-	//lighting
-	SetShaderMaterial("torus");
-
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawTorusMesh();
-	/****************************************************************/
-
-	/****************************************************************/
-	// Box 1 - first box for the structure (from bottom to top)
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(7.0f, 4.0f, 3.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 1.0f, 2.5f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	//Structure Color - Light Brown
-	SetShaderColor(0.871, 0.804, 0.675, 1);
-	//Texture to stone
-	SetShaderTexture("stone");
-
-	//lighting
-	SetShaderMaterial("box1");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
-	// Box 2 -  box for the structure (from bottom to top)
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(5.0f, 2.5f, 3.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f,3.5f, 2.5f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	//Structure Color - Light Brown
-	SetShaderColor(0.871, 0.804, 0.675, 1);
-	//Texture to stone
-	SetShaderTexture("stone");
-
-	//ligting
-	SetShaderMaterial("box2");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
-	// Box 3 -  box for the structure (from bottom to top)
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(3.5f, 3.0f, 2.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 6.0f, 2.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	//Structure Color - Light Brown
-	SetShaderColor(0.871, 0.804, 0.675, 1);
-	//Texture to stone
-	SetShaderTexture("stone");
-
-	//lighting
-	SetShaderMaterial("box3");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-	/****************************************************************/
-	// Box 4 -  box for the structure (from bottom to top)
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(2.0f, 1.0f, 2.5f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 8.0f, 2.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	//Structure Color - Light Brown
-	SetShaderColor(0.871, 0.804, 0.675, 1);
-	//Texture to stone
-	SetShaderTexture("stone");
-
-	//lighting
-	SetShaderMaterial("box4");
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawBoxMesh();
-
-	/****************************************************************/
-	// Prism -  prism for the top for the structure (from bottom to top)
-	// there will be a sphere on top of prism which will be added later
-
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(1.75f, 2.0f, 2.3f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = -90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 9.3f, 2.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
-
-	//Structure Color - Light Brown
-	SetShaderColor(0.871, 0.804, 0.675, 1);
-	//Texture to stone
-	SetShaderTexture("stone");
-	
-	//lighting
-	SetShaderMaterial("prism");
+/***********************************************************
+ *  RenderScenePathTraced()
+ *
+ *  This method is used for adding one pass of samples to the
+ *  path traced image.  The tree is only rebuilt when a scene
+ *  record changed or the wind moved the foliage, so a still
+ *  scene keeps refining the same image.
+ ***********************************************************/
+void SceneManager::RenderScenePathTraced()
+{
+	m_pEntities->UpdateTransforms();
+	UpdateSceneRecords();
+	bool bSceneChanged = m_pInstanceBuffer->HasChanges() ||
+		m_pMaterialBuffer->HasChanges() ||
+		m_pLightBuffer->HasChanges() ||
+		(m_frameTime != m_pathTracedFrameTime);
+	m_pInstanceBuffer->DiscardChanges();
+	m_pMaterialBuffer->DiscardChanges();
+	m_pLightBuffer->DiscardChanges();
+
+	if ((NULL == m_pPathTracer) || !m_bViewProjectionSet)
+	{
+		return;
+	}
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPrismMesh();
-	/****************************************************************/
+	if (bSceneChanged)
+	{
+		GatherSoftwareScene();
+		m_pPathTracer->SetScene(m_softwareScene);
+		m_pathTracedFrameTime = m_frameTime;
+	}
+	m_pPathTracer->SetCamera(m_view, m_projection);
+	m_pPathTracer->Render();
 }
@@ -11,6 +11,22 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "ModelMeshes.h"
+#include "MeshSimplifier.h"
+#include "MemoryTracker.h"
+#include "GLResources.h"
+#include "SceneFile.h"
+#include "SceneEntities.h"
+#include "SceneBuffers.h"
+#include "WindSystem.h"
+#include "ParticleSystem.h"
+#include "GLRenderDevice.h"
+#include "SoftwareRenderDevice.h"
+#include "UniformRing.h"
+#include "PathTracer.h"
+#include "SoftwareRasterizer.h"
+#include "ModelImporter.h"
+#include "ModelPack.h"
 
 #include <string>
 #include <vector>
@@ -33,6 +49,8 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// owning handle for the OpenGL texture object
+		GLTextureHandle handle;
 	};
 
 	struct OBJECT_MATERIAL
@@ -45,6 +63,29 @@ public:
 		std::string tag;
 	};
 
+	// what the scene is drawn with
+	enum RENDER_BACKEND
+	{
+		RENDER_BACKEND_OPENGL = 0,
+		// the CPU rasterizer - makes no OpenGL calls at all, so
+		// it runs without a window or driver
+		RENDER_BACKEND_SOFTWARE,
+		// the CPU path tracer for reference images - also makes
+		// no OpenGL calls, and refines the same image every frame
+		// until the camera or the scene changes
+		RENDER_BACKEND_PATH_TRACER
+	};
+
+	struct LIGHT_SOURCE
+	{
+		glm::vec3 position;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float focalStrength;
+		float specularIntensity;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
@@ -53,51 +94,142 @@ private:
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	TEXTURE_INFO m_textureIDs[SCENE_TEXTURE_SLOTS];
+	// buffers and vertex arrays created by the basic shapes object
+	std::vector<GLBufferHandle> m_meshBuffers;
+	std::vector<GLVertexArrayHandle> m_meshVertexArrays;
+	// imported meshes - only created for the OpenGL backend
+	ModelMeshes* m_pModelMeshes;
+	// the mesh, color and material of every part of each
+	// imported model
+	struct MODEL_PART
+	{
+		SCENE_MESH mesh;
+		glm::vec4 color;
+		int materialIndex;
+	};
+	std::vector<std::vector<MODEL_PART>> m_models;
 	// defined object materials
-	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	std::vector<OBJECT_MATERIAL, TrackedAllocator<OBJECT_MATERIAL, MemoryTracker::MEMTAG_SCENE>> m_objectMaterials;
+	// compiled scene description - replaces the hand-coded scene when loaded
+	SceneFile* m_pSceneFile;
+	// texture slot for each texture in the compiled scene
+	std::vector<int> m_sceneTextureSlots;
+	// wind stiffness of the objects using each compiled scene texture
+	std::vector<float> m_sceneTextureWind;
+	// index of the first compiled scene material in the materials list
+	size_t m_sceneMaterialBase;
+	// scene objects stored as entities
+	EntityStore* m_pEntities;
+	// visible objects gathered for drawing this frame
+	std::vector<RENDER_PACKET> m_renderPackets;
+	// camera matrices used for culling and the particles
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
+	glm::mat4 m_viewProjection;
+	glm::vec3 m_viewPosition;
+	bool m_bViewProjectionSet;
+	bool m_bLayeredView;
+	// inside BeginSharedFrame(), and whether a view of the shared
+	// frame has been drawn yet
+	bool m_bSharedFrame;
+	bool m_bSharedFrameBegun;
+	// texture slot and material index of each static shrine draw
+	std::vector<int> m_staticTextureSlots;
+	std::vector<int> m_staticMaterialIndexes;
+	// number of static shrine records at the start of the instance buffer
+	size_t m_staticInstanceCount;
+	// defined light sources
+	std::vector<LIGHT_SOURCE> m_lightSources;
+	// GPU copies of the instance, material and light records
+	GPUArrayBuffer* m_pInstanceBuffer;
+	GPUArrayBuffer* m_pMaterialBuffer;
+	GPUArrayBuffer* m_pLightBuffer;
+	// per-frame and per-draw uniform blocks - only created for
+	// the OpenGL backend
+	UniformRing* m_pUniformRing;
+	// executes the recorded draws with the graphics API
+	RenderDevice* m_pRenderDevice;
+	// draws recorded for the current frame, one list per job
+	std::vector<RenderCommandList> m_commandLists;
+	// global wind for the foliage animation
+	WindSystem* m_pWind;
+	// time the next frame is rendered at, in seconds
+	double m_frameTime;
+	// time the previous frame was rendered at, or -1 before the first
+	double m_previousFrameTime;
+	// falling leaves and incense smoke
+	ParticleSystem* m_pParticles;
+	// backend the scene is drawn with
+	RENDER_BACKEND m_renderBackend;
+	// whether the lights are applied - mirrors bUseLighting in the shader
+	bool m_bUseLighting;
+	// whether the texture images are loaded at all
+	bool m_bTexturesEnabled;
+	// CPU copies of the loaded textures, indexed by texture slot
+	std::vector<SoftwareTexture> m_softwareTextures;
+	// CPU renderer, drawn through a SoftwareRenderDevice
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+	// frame handed to the path tracer
+	SOFTWARE_SCENE m_softwareScene;
+	// reference renderer, and the frame time its scene was built at
+	PathTracer* m_pPathTracer;
+	double m_pathTracedFrameTime;
+	// images decoded by DecodeSceneTextures() ahead of the scene
+	// being prepared, waiting for their textures to be created
+	struct DECODED_IMAGE
+	{
+		std::string filename;
+		unsigned char* pixels;
+		int width;
+		int height;
+		int colorChannels;
+	};
+	std::vector<DECODED_IMAGE> m_decodedImages;
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
+	// free the decoded images no texture was created from
+	void FreeDecodedImages();
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
 	int FindTextureSlot(std::string tag);
 	// load all of the needed textures before rendering
 	void LoadSceneTextures();
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
-
-	// set the transformation values 
-	// into the transform buffer
-	void SetTransformations(
-		glm::vec3 scaleXYZ,
-		float XrotationDegrees,
-		float YrotationDegrees,
-		float ZrotationDegrees,
-		glm::vec3 positionXYZ);
-
-	// set the color values into the shader
-	void SetShaderColor(
-		float redColorValue,
-		float greenColorValue,
-		float blueColorValue,
-		float alphaValue);
-
-	// set the texture data into the shader
-	void SetShaderTexture(
-		std::string textureTag);
-
-	// set the UV scale for the texture mapping
-	void SetTextureUVScale(
-		float u, float v);
+	int FindMaterialIndex(std::string tag);
 
-	// set the object material into the shader
-	void SetShaderMaterial(
-		std::string materialTag);
+	// load the textures, materials and lights of the compiled scene
+	void LoadSceneFileResources();
+	// add every object in the compiled scene to the entity store
+	void AddSceneFileObjects();
+	// look up the textures and materials of the static shrine draws
+	void ResolveStaticScene();
+	// record the visible static draws and render packets into
+	// command lists, in parallel
+	void RecordSceneCommands();
+	// add the falling leaves and incense smoke
+	void CreateParticleEffects();
+	// copy one material, light or static draw into its GPU record
+	void WriteMaterialRecord(size_t index);
+	void WriteLightRecord(size_t index);
+	void WriteStaticRecord(size_t index);
+	// point the static draws using one material at another
+	void RemapStaticMaterial(int fromIndex, int toIndex);
+	// write the changed entity and material records into the
+	// shadow copies of the scene buffers
+	void UpdateSceneRecords();
+	// hand the changed records and the frame's constants to the
+	// render device
+	void FlushSceneEdits();
+	// fill in the path tracer's frame from the shadow buffers,
+	// with every draw
+	void GatherSoftwareScene();
+	// add a pass to the path traced image
+	void RenderScenePathTraced();
 
 public:
 
@@ -107,6 +239,97 @@ public:
 	//pre-define the object materials for lighting
 	void DefineObjectMaterials();
 
+	// map a compiled scene file to render instead of the
+	// hand-coded scene - must be called before PrepareScene()
+	bool LoadSceneFile(const char* filename);
+	// decode the texture images of the scene on the job system,
+	// so PrepareScene() only has to upload them - may run on
+	// any thread, after LoadSceneFile() and before PrepareScene()
+	void DecodeSceneTextures();
+
+	// set the camera matrices used for culling and the particles
+	void SetViewProjection(const glm::mat4& view, const glm::mat4& projection);
+	// set up a layered pass - the scene shader leaves the vertices
+	// in world space for a geometry shader that projects them into
+	// each layer, the objects are culled once against the passed in
+	// matrix, the lighting is seen from the passed in position, and
+	// the particles are left out.  Lasts until SetViewProjection().
+	void SetLayeredView(const glm::mat4& cullViewProjection, const glm::vec3& viewPosition);
+
+	// runtime scene edits - every change is uploaded on the next
+	// RenderScene() as a partial update of the GPU buffers
+	EntityID AddSceneObject(
+		SCENE_MESH mesh,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegreesXYZ,
+		glm::vec3 positionXYZ,
+		glm::vec4 color,
+		std::string textureTag,
+		std::string materialTag);
+	bool RemoveObject(EntityID object);
+	bool MoveObject(
+		EntityID object,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegreesXYZ,
+		glm::vec3 positionXYZ);
+	bool SetObjectColor(EntityID object, glm::vec4 color);
+	bool SetObjectTexture(EntityID object, std::string textureTag);
+	bool SetObjectMaterial(EntityID object, std::string materialTag);
+	bool SetObjectHidden(EntityID object, bool bHidden);
+	bool SetObjectWindStiffness(EntityID object, float windStiffness);
+	// import a glTF or OBJ model with a level of detail for each
+	// ratio of its triangles, or a model pack with the levels it
+	// was written with, and return its index, or -1 - must be
+	// called after PrepareScene() with the OpenGL backend
+	int ImportModel(const char* filename, const std::vector<float>& lodRatios = MESH_DEFAULT_LOD_RATIOS);
+	// upload a model already imported, or a model pack already
+	// mapped, the way ImportModel() does - so the importing and
+	// mapping can be done on other threads beforehand
+	int AddImportedModel(const IMPORTED_MODEL& model);
+	int AddModelPack(const ModelPack& pack);
+	// add an object for every part of an imported model
+	bool AddModelObject(
+		int model,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegreesXYZ,
+		glm::vec3 positionXYZ,
+		std::vector<EntityID>& objects);
+	int AddMaterial(const OBJECT_MATERIAL& material);
+	bool ModifyMaterial(const OBJECT_MATERIAL& material);
+	bool RemoveMaterial(std::string materialTag);
+	int AddLight(const LIGHT_SOURCE& light);
+	bool ModifyLight(int index, const LIGHT_SOURCE& light);
+	bool RemoveLight(int index);
+	int GetLightCount() const { return (int)m_lightSources.size(); }
+
+	// set the time the next frame is animated at
+	void SetFrameTime(double timeSeconds);
+	// draw the views of the RenderScene() calls until
+	// EndSharedFrame() as one frame, so they share the per-frame
+	// resources of the render device instead of each turning
+	// them over
+	void BeginSharedFrame();
+	void EndSharedFrame();
+	// global wind applied to the foliage
+	WindSystem* GetWind() { return m_pWind; }
+	// particle effects drawn after the scene objects
+	ParticleSystem* GetParticles() { return m_pParticles; }
+
+	// choose the backend and its image size - must be called
+	// before PrepareScene()
+	void SetRenderBackend(RENDER_BACKEND backend, int width, int height);
+	RENDER_BACKEND GetRenderBackend() const { return m_renderBackend; }
+	// leave the texture images out, so the objects are drawn in
+	// their colors - must be called before PrepareScene()
+	void SetTexturesEnabled(bool bEnabled) { m_bTexturesEnabled = bEnabled; }
+	// the software renderer, or NULL with the other backends
+	SoftwareRasterizer* GetSoftwareRasterizer() { return m_pSoftwareRasterizer; }
+	// the path tracer, or NULL with the other backends
+	PathTracer* GetPathTracer() { return m_pPathTracer; }
+	// the device the OpenGL or software backend draws through,
+	// or NULL with the path tracer
+	RenderDevice* GetRenderDevice() { return m_pRenderDevice; }
+
 	// The following methods are for the students to 
 	// customize for their own 3D scene
 	void PrepareScene();
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// shrinelayout.h
+// ============
+// fixed layout of the Liberty Shrine compiled into static tables
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "StaticScene.h"
+
+/**************************************************************/
+/*** The shrine layout never changes after the build, so    ***/
+/*** its world matrices, bounds and draw order are computed ***/
+/*** by the compiler.  Changing a value below only needs a  ***/
+/*** rebuild.                                               ***/
+/**************************************************************/
+
+constexpr STATIC_OBJECT_DESC g_ShrineObjects[] =
+{
+	// mesh, scale, XYZ rotation degrees, position, color, texture, material
+
+	// Bottom Plane - GROUND
+	{ SCENE_MESH_PLANE, { 20.0f, 1.0f, 10.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f },
+		{ 1.0f, 1.0f, 1.0f, 1.0f }, "ground", "bottomPlane" },
+	// Top Plane - Background
+	{ SCENE_MESH_PLANE, { 20.0f, 1.0f, 10.0f }, { 90.0f, 0.0f, 0.0f }, { 0.0f, 9.0f, -10.0f },
+		{ 1.0f, 1.0f, 1.0f, 1.0f }, "sky", "topPlane" },
+	// Torus - green hedge, rotated to 90 degress to match the ground
+	{ SCENE_MESH_TORUS, { 10.0f, 6.0f, 2.0f }, { 90.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 2.0f },
+		{ 0.243f, 0.651f, 0.286f, 1.0f }, "bush", "torus" },
+	// Box 1 - first box for the structure (from bottom to top)
+	{ SCENE_MESH_BOX, { 7.0f, 4.0f, 3.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 2.5f },
+		{ 0.871f, 0.804f, 0.675f, 1.0f }, "stone", "box1" },
+	// Box 2 -  box for the structure (from bottom to top)
+	{ SCENE_MESH_BOX, { 5.0f, 2.5f, 3.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 3.5f, 2.5f },
+		{ 0.871f, 0.804f, 0.675f, 1.0f }, "stone", "box2" },
+	// Box 3 -  box for the structure (from bottom to top)
+	{ SCENE_MESH_BOX, { 3.5f, 3.0f, 2.5f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 6.0f, 2.0f },
+		{ 0.871f, 0.804f, 0.675f, 1.0f }, "stone", "box3" },
+	// Box 4 -  box for the structure (from bottom to top)
+	{ SCENE_MESH_BOX, { 2.0f, 1.0f, 2.5f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 8.0f, 2.0f },
+		{ 0.871f, 0.804f, 0.675f, 1.0f }, "stone", "box4" },
+	// Prism -  prism for the top for the structure (from bottom to top)
+	{ SCENE_MESH_PRISM, { 1.75f, 2.0f, 2.3f }, { -90.0f, 0.0f, 0.0f }, { 0.0f, 9.3f, 2.0f },
+		{ 0.871f, 0.804f, 0.675f, 1.0f }, "stone", "prism" },
+};
+
+// precomputed world matrices, bounds and sorted draws
+constexpr STATIC_SCENE_TABLE<sizeof(g_ShrineObjects) / sizeof(g_ShrineObjects[0])> g_ShrineTable =
+	BuildStaticScene(g_ShrineObjects);
+
+static_assert(g_ShrineTable.count == 8, "unexpected number of shrine objects");
+static_assert(g_ShrineTable.draws[0].mesh == SCENE_MESH_PLANE, "static draws are not sorted by mesh");
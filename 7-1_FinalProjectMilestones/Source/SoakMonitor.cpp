@@ -0,0 +1,184 @@
+///////////////////////////////////////////////////////////////////////////////
+// soakmonitor.cpp
+// ============
+// watch resource counts over long runs to find leaks
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoakMonitor.h"
+#include "GLResources.h"
+#include "MemoryTracker.h"
+
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the first samples are taken while the scene is still
+	// warming up, so they are left out of the growth check
+	const size_t g_WarmupSamples = 2;
+	// number of samples needed before growth is reported
+	const size_t g_MinimumSamples = 4;
+}
+
+/***********************************************************
+ *  SoakMonitor()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoakMonitor::SoakMonitor(double durationHours, double sampleIntervalSeconds)
+{
+	m_durationSeconds = durationHours * 3600.0;
+	m_sampleInterval = sampleIntervalSeconds;
+	m_startTime = -1.0;
+	m_lastSampleTime = 0.0;
+
+	// one series per tracked resource type and memory pool
+	for (int type = 0; type < GLResourceManager::GLRES_COUNT; type++)
+	{
+		SAMPLE_SERIES series;
+		series.name = std::string("live ") + GLResourceManager::GetTypeName((GLResourceManager::GL_RESOURCE_TYPE)type);
+		m_series.push_back(series);
+	}
+
+	SAMPLE_SERIES pending;
+	pending.name = "pending deletes";
+	m_series.push_back(pending);
+
+	SAMPLE_SERIES cpuMemory;
+	cpuMemory.name = "cpu memory";
+	m_series.push_back(cpuMemory);
+
+	SAMPLE_SERIES gpuMemory;
+	gpuMemory.name = "gpu memory";
+	m_series.push_back(gpuMemory);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is called once per frame to take a sample
+ *  whenever the sample interval has passed.
+ ***********************************************************/
+bool SoakMonitor::Update(double currentTime)
+{
+	if (m_startTime < 0.0)
+	{
+		m_startTime = currentTime;
+		TakeSample(currentTime);
+	}
+
+	if (currentTime - m_lastSampleTime >= m_sampleInterval)
+	{
+		TakeSample(currentTime);
+	}
+
+	return((currentTime - m_startTime) < m_durationSeconds);
+}
+
+/***********************************************************
+ *  TakeSample()
+ *
+ *  This method is used for recording the current value of
+ *  every monitored series.
+ ***********************************************************/
+void SoakMonitor::TakeSample(double currentTime)
+{
+	size_t index = 0;
+
+	for (int type = 0; type < GLResourceManager::GLRES_COUNT; type++)
+	{
+		m_series[index++].values.push_back(
+			GLResourceManager::GetLiveCount((GLResourceManager::GL_RESOURCE_TYPE)type));
+	}
+	m_series[index++].values.push_back(GLResourceManager::GetPendingCount());
+	m_series[index++].values.push_back((double)MemoryTracker::GetTotalLive(MemoryTracker::POOL_CPU));
+	m_series[index++].values.push_back((double)MemoryTracker::GetTotalLive(MemoryTracker::POOL_GPU));
+
+	m_sampleTimes.push_back(currentTime - m_startTime);
+	m_lastSampleTime = currentTime;
+}
+
+/***********************************************************
+ *  IsMonotonicallyGrowing()
+ *
+ *  This method is used for checking whether a series never
+ *  went down after the warmup samples and ended higher
+ *  than it started.
+ ***********************************************************/
+bool SoakMonitor::IsMonotonicallyGrowing(const SAMPLE_SERIES& series) const
+{
+	if (series.values.size() < g_WarmupSamples + g_MinimumSamples)
+	{
+		return(false);
+	}
+
+	for (size_t i = g_WarmupSamples + 1; i < series.values.size(); i++)
+	{
+		if (series.values[i] < series.values[i - 1])
+		{
+			return(false);
+		}
+	}
+
+	return(series.values.back() > series.values[g_WarmupSamples]);
+}
+
+/***********************************************************
+ *  WriteReport()
+ *
+ *  This method is used for writing every sampled series
+ *  into a CSV file and printing the growing ones.  False
+ *  is returned if any series looks like a leak.
+ ***********************************************************/
+bool SoakMonitor::WriteReport(const char* filename)
+{
+	bool bClean = true;
+
+	std::ofstream file(filename, std::ios::out | std::ios::trunc);
+	if (file.is_open())
+	{
+		file << "seconds";
+		for (const SAMPLE_SERIES& series : m_series)
+		{
+			file << "," << series.name;
+		}
+		file << "\n";
+
+		for (size_t sample = 0; sample < m_sampleTimes.size(); sample++)
+		{
+			file << m_sampleTimes[sample];
+			for (const SAMPLE_SERIES& series : m_series)
+			{
+				file << "," << series.values[sample];
+			}
+			file << "\n";
+		}
+	}
+	else
+	{
+		std::cout << "Could not write soak test report:" << filename << std::endl;
+	}
+
+	std::cout << "INFO: Soak test ran for " << (m_sampleTimes.empty() ? 0.0 : m_sampleTimes.back())
+		<< " seconds with " << m_sampleTimes.size() << " samples" << std::endl;
+
+	for (const SAMPLE_SERIES& series : m_series)
+	{
+		if (IsMonotonicallyGrowing(series))
+		{
+			bClean = false;
+			std::cout << "WARNING: " << series.name << " grew from "
+				<< series.values[g_WarmupSamples] << " to " << series.values.back()
+				<< " without ever shrinking" << std::endl;
+		}
+	}
+
+	if (bClean)
+	{
+		std::cout << "INFO: No growing resource counts were found" << std::endl;
+	}
+
+	return(bClean);
+}
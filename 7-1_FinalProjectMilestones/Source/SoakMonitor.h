@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// soakmonitor.h
+// ============
+// watch resource counts over long runs to find leaks
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SoakMonitor
+ *
+ *  This class samples the live OpenGL object counts and
+ *  memory totals at a fixed interval during a long-running
+ *  soak test and reports any of them that keep growing.
+ ***********************************************************/
+class SoakMonitor
+{
+public:
+	// constructor
+	SoakMonitor(double durationHours, double sampleIntervalSeconds);
+
+	// take a sample if the interval has passed - returns false
+	// once the soak test duration has been reached
+	bool Update(double currentTime);
+
+	// print the sampled series and flag the growing ones
+	bool WriteReport(const char* filename);
+
+private:
+	struct SAMPLE_SERIES
+	{
+		std::string name;
+		std::vector<double> values;
+	};
+
+	double m_durationSeconds;
+	double m_sampleInterval;
+	double m_startTime;
+	double m_lastSampleTime;
+	std::vector<double> m_sampleTimes;
+	std::vector<SAMPLE_SERIES> m_series;
+
+	// record the current value of every series
+	void TakeSample(double currentTime);
+	// true when a series never shrinks and has grown overall
+	bool IsMonotonicallyGrowing(const SAMPLE_SERIES& series) const;
+};
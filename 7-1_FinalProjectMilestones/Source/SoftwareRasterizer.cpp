@@ -0,0 +1,599 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.cpp
+// ============
+// multithreaded tile based CPU rasterizer for the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// four pixel coverage and depth tests when the build targets SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define RASTER_SIMD_SSE
+#endif
+
+// declaration of global variables
+namespace
+{
+	// width and height of a screen tile in pixels - a multiple of four
+	const int g_TileSize = 64;
+	// visibility buffer value of pixels no triangle covers
+	const uint32_t g_NoTriangle = 0xFFFFFFFF;
+	// draws set up by each geometry job
+	const size_t g_DrawBatchSize = 8;
+	// world position, normal and texture coordinate
+	const int g_AttributeCount = 8;
+	// most vertices a triangle can have after clipping to two planes
+	const int g_MaxClipVertices = 5;
+
+	double GetElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+	{
+		return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+}
+
+/***********************************************************
+ *  SoftwareRasterizer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoftwareRasterizer::SoftwareRasterizer(int width, int height)
+{
+	m_width = 0;
+	m_height = 0;
+	m_stride = 0;
+	m_tilesX = 0;
+	m_tilesY = 0;
+	m_stats = {};
+	Resize(width, height);
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for resizing the color, depth and
+ *  visibility buffers and the tile grid.
+ ***********************************************************/
+void SoftwareRasterizer::Resize(int width, int height)
+{
+	m_width = std::max(width, 1);
+	m_height = std::max(height, 1);
+	m_stride = (m_width + 3) & ~3;
+	m_tilesX = (m_width + g_TileSize - 1) / g_TileSize;
+	m_tilesY = (m_height + g_TileSize - 1) / g_TileSize;
+
+	size_t pixelCount = (size_t)m_stride * m_height;
+	m_color.assign(pixelCount, 0);
+	m_depth.assign(pixelCount, 1.0f);
+	m_triangleIDs.assign(pixelCount, g_NoTriangle);
+	m_weightB.assign(pixelCount, 0.0f);
+	m_weightC.assign(pixelCount, 0.0f);
+	m_tileBins.resize((size_t)m_tilesX * m_tilesY);
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for rendering one frame of the
+ *  passed in scene into the color buffer.
+ ***********************************************************/
+void SoftwareRasterizer::Render(
+	const SOFTWARE_SCENE& scene,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	glm::vec4 clearColor)
+{
+	std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+	m_stats = {};
+	m_stats.drawCount = (uint32_t)scene.draws.size();
+
+	// transform, clip and set up the triangles of every draw
+	glm::mat4 viewProjection = projection * view;
+	m_drawTriangles.resize(scene.draws.size());
+	JobSystem::ParallelFor(scene.draws.size(), g_DrawBatchSize,
+		[this, &scene, &viewProjection](size_t begin, size_t end)
+		{
+			std::vector<CLIP_VERTEX> clipVertices;
+			for (size_t i = begin; i < end; i++)
+			{
+				m_drawTriangles[i].clear();
+				SetupDraw(scene, (uint32_t)i, viewProjection, clipVertices, m_drawTriangles[i]);
+			}
+		});
+
+	// gather the triangles in draw order and bin them into the
+	// tiles they overlap
+	m_triangles.clear();
+	for (const std::vector<SETUP_TRIANGLE>& drawTriangles : m_drawTriangles)
+	{
+		m_triangles.insert(m_triangles.end(), drawTriangles.begin(), drawTriangles.end());
+	}
+	for (std::vector<uint32_t>& bin : m_tileBins)
+	{
+		bin.clear();
+	}
+	for (uint32_t i = 0; i < (uint32_t)m_triangles.size(); i++)
+	{
+		const SETUP_TRIANGLE& triangle = m_triangles[i];
+		int tileMaxX = triangle.maxX / g_TileSize;
+		int tileMaxY = triangle.maxY / g_TileSize;
+		for (int tileY = triangle.minY / g_TileSize; tileY <= tileMaxY; tileY++)
+		{
+			for (int tileX = triangle.minX / g_TileSize; tileX <= tileMaxX; tileX++)
+			{
+				m_tileBins[(size_t)tileY * m_tilesX + tileX].push_back(i);
+				m_stats.binnedTriangles++;
+			}
+		}
+	}
+	m_stats.triangleCount = (uint32_t)m_triangles.size();
+	m_stats.geometryMilliseconds = GetElapsedMilliseconds(frameStart);
+
+	// every tile owns its own pixels, so the tiles need no locking
+	std::chrono::steady_clock::time_point rasterStart = std::chrono::steady_clock::now();
+	uint32_t clearPixel = PackColor(clearColor);
+	JobSystem::ParallelFor(m_tileBins.size(), 1,
+		[this, &scene, clearPixel](size_t begin, size_t end)
+		{
+			for (size_t tile = begin; tile < end; tile++)
+			{
+				RenderTile(scene, (int)tile, clearPixel);
+			}
+		});
+	m_stats.rasterMilliseconds = GetElapsedMilliseconds(rasterStart);
+	m_stats.totalMilliseconds = GetElapsedMilliseconds(frameStart);
+}
+
+/***********************************************************
+ *  SetupDraw()
+ *
+ *  This method is used for running the vertex stage of one
+ *  draw - the same world transform, wind and normal matrix
+ *  as the scene vertex shader - and then clipping and
+ *  setting up each of its triangles.
+ ***********************************************************/
+void SoftwareRasterizer::SetupDraw(
+	const SOFTWARE_SCENE& scene,
+	uint32_t drawIndex,
+	const glm::mat4& viewProjection,
+	std::vector<CLIP_VERTEX>& clipVertices,
+	std::vector<SETUP_TRIANGLE>& triangles) const
+{
+	const SOFTWARE_DRAW& draw = scene.draws[drawIndex];
+	if (draw.instance >= scene.instanceCount)
+	{
+		return;
+	}
+
+	const INSTANCE_RECORD& instance = scene.pInstances[draw.instance];
+	const SOFTWARE_MESH& mesh = GetSoftwareMesh(draw.mesh);
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(instance.world)));
+	glm::vec3 origin = glm::vec3(instance.world[3]);
+
+	clipVertices.resize(mesh.vertices.size());
+	for (size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		const SOFTWARE_VERTEX& vertex = mesh.vertices[i];
+		glm::vec3 world = glm::vec3(instance.world * glm::vec4(vertex.position, 1.0f));
+		world = WindSystem::ApplyWind(scene.wind, world, origin, instance.windStiffness, instance.windPhase);
+		glm::vec3 normal = normalMatrix * vertex.normal;
+		glm::vec2 uv = vertex.uv * instance.uvScale;
+
+		CLIP_VERTEX& clipVertex = clipVertices[i];
+		clipVertex.position = viewProjection * glm::vec4(world, 1.0f);
+		clipVertex.attributes[0] = world.x;
+		clipVertex.attributes[1] = world.y;
+		clipVertex.attributes[2] = world.z;
+		clipVertex.attributes[3] = normal.x;
+		clipVertex.attributes[4] = normal.y;
+		clipVertex.attributes[5] = normal.z;
+		clipVertex.attributes[6] = uv.x;
+		clipVertex.attributes[7] = uv.y;
+	}
+
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		ClipTriangle(
+			clipVertices[mesh.indices[i]],
+			clipVertices[mesh.indices[i + 1]],
+			clipVertices[mesh.indices[i + 2]],
+			drawIndex,
+			triangles);
+	}
+}
+
+/***********************************************************
+ *  ClipTriangle()
+ *
+ *  This method is used for dropping triangles that are
+ *  entirely outside of the view volume and clipping the
+ *  rest to the near and far planes.  The sides need no
+ *  clipping because the pixel bounds are clamped to the
+ *  screen.
+ ***********************************************************/
+void SoftwareRasterizer::ClipTriangle(
+	const CLIP_VERTEX& a,
+	const CLIP_VERTEX& b,
+	const CLIP_VERTEX& c,
+	uint32_t drawIndex,
+	std::vector<SETUP_TRIANGLE>& triangles) const
+{
+	const glm::vec4& pa = a.position;
+	const glm::vec4& pb = b.position;
+	const glm::vec4& pc = c.position;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if ((pa[axis] > pa.w) && (pb[axis] > pb.w) && (pc[axis] > pc.w))
+		{
+			return;
+		}
+		if ((pa[axis] < -pa.w) && (pb[axis] < -pb.w) && (pc[axis] < -pc.w))
+		{
+			return;
+		}
+	}
+
+	// most triangles are entirely between the near and far planes
+	bool bInside = true;
+	for (const glm::vec4* pPosition : { &pa, &pb, &pc })
+	{
+		if ((pPosition->z < -pPosition->w) || (pPosition->z > pPosition->w))
+		{
+			bInside = false;
+		}
+	}
+	if (bInside)
+	{
+		SetupTriangle(a, b, c, drawIndex, triangles);
+		return;
+	}
+
+	CLIP_VERTEX polygons[2][g_MaxClipVertices];
+	polygons[0][0] = a;
+	polygons[0][1] = b;
+	polygons[0][2] = c;
+	int count = 3;
+	int current = 0;
+
+	// near plane z >= -w, then far plane z <= w
+	for (int plane = 0; plane < 2; plane++)
+	{
+		const CLIP_VERTEX* pInput = polygons[current];
+		CLIP_VERTEX* pOutput = polygons[current ^ 1];
+		int outputCount = 0;
+
+		for (int i = 0; i < count; i++)
+		{
+			const CLIP_VERTEX& vertex = pInput[i];
+			const CLIP_VERTEX& next = pInput[(i + 1) % count];
+			float distance = (plane == 0) ? (vertex.position.z + vertex.position.w) : (vertex.position.w - vertex.position.z);
+			float nextDistance = (plane == 0) ? (next.position.z + next.position.w) : (next.position.w - next.position.z);
+
+			if (distance >= 0.0f)
+			{
+				pOutput[outputCount++] = vertex;
+			}
+			if ((distance >= 0.0f) != (nextDistance >= 0.0f))
+			{
+				float t = distance / (distance - nextDistance);
+				CLIP_VERTEX& crossing = pOutput[outputCount++];
+				crossing.position = glm::mix(vertex.position, next.position, t);
+				for (int k = 0; k < g_AttributeCount; k++)
+				{
+					crossing.attributes[k] = vertex.attributes[k] + (next.attributes[k] - vertex.attributes[k]) * t;
+				}
+			}
+		}
+
+		count = outputCount;
+		current ^= 1;
+		if (count < 3)
+		{
+			return;
+		}
+	}
+
+	for (int i = 1; i + 1 < count; i++)
+	{
+		SetupTriangle(polygons[current][0], polygons[current][i], polygons[current][i + 1], drawIndex, triangles);
+	}
+}
+
+/***********************************************************
+ *  SetupTriangle()
+ *
+ *  This method is used for projecting a clipped triangle to
+ *  the screen and computing its edge functions and pixel
+ *  bounds.  The triangle is turned to a consistent winding,
+ *  since the scene is drawn without back face culling.
+ ***********************************************************/
+void SoftwareRasterizer::SetupTriangle(
+	const CLIP_VERTEX& a,
+	const CLIP_VERTEX& b,
+	const CLIP_VERTEX& c,
+	uint32_t drawIndex,
+	std::vector<SETUP_TRIANGLE>& triangles) const
+{
+	const CLIP_VERTEX* vertices[3] = { &a, &b, &c };
+	float screenX[3];
+	float screenY[3];
+	SETUP_TRIANGLE triangle;
+
+	for (int i = 0; i < 3; i++)
+	{
+		const glm::vec4& position = vertices[i]->position;
+		if (position.w <= 1e-6f)
+		{
+			return;
+		}
+
+		float inverseW = 1.0f / position.w;
+		screenX[i] = (position.x * inverseW * 0.5f + 0.5f) * m_width;
+		screenY[i] = (0.5f - position.y * inverseW * 0.5f) * m_height;
+		triangle.depth[i] = position.z * inverseW * 0.5f + 0.5f;
+		triangle.inverseW[i] = inverseW;
+		for (int k = 0; k < g_AttributeCount; k++)
+		{
+			triangle.attributes[i][k] = vertices[i]->attributes[k] * inverseW;
+		}
+	}
+
+	float area = (screenX[1] - screenX[0]) * (screenY[2] - screenY[0]) - (screenY[1] - screenY[0]) * (screenX[2] - screenX[0]);
+	if (!(std::fabs(area) > 0.0f) || !std::isfinite(area))
+	{
+		return;
+	}
+	if (area < 0.0f)
+	{
+		std::swap(screenX[1], screenX[2]);
+		std::swap(screenY[1], screenY[2]);
+		std::swap(triangle.depth[1], triangle.depth[2]);
+		std::swap(triangle.inverseW[1], triangle.inverseW[2]);
+		std::swap(triangle.attributes[1], triangle.attributes[2]);
+		area = -area;
+	}
+	triangle.inverseArea = 1.0f / area;
+
+	for (int i = 0; i < 3; i++)
+	{
+		int from = (i + 1) % 3;
+		int to = (i + 2) % 3;
+		triangle.edgeA[i] = screenY[from] - screenY[to];
+		triangle.edgeB[i] = screenX[to] - screenX[from];
+		triangle.edgeC[i] = -(triangle.edgeA[i] * screenX[from] + triangle.edgeB[i] * screenY[from]);
+		triangle.bOwnedEdge[i] = (triangle.edgeA[i] > 0.0f) || ((triangle.edgeA[i] == 0.0f) && (triangle.edgeB[i] > 0.0f));
+	}
+
+	// pixels whose centers fall inside the bounds, clamped to the screen
+	float minX = std::min(std::min(screenX[0], screenX[1]), screenX[2]);
+	float maxX = std::max(std::max(screenX[0], screenX[1]), screenX[2]);
+	float minY = std::min(std::min(screenY[0], screenY[1]), screenY[2]);
+	float maxY = std::max(std::max(screenY[0], screenY[1]), screenY[2]);
+	triangle.minX = (int)std::ceil(glm::clamp(minX - 0.5f, 0.0f, (float)m_width));
+	triangle.maxX = (int)std::floor(glm::clamp(maxX - 0.5f, -1.0f, (float)(m_width - 1)));
+	triangle.minY = (int)std::ceil(glm::clamp(minY - 0.5f, 0.0f, (float)m_height));
+	triangle.maxY = (int)std::floor(glm::clamp(maxY - 0.5f, -1.0f, (float)(m_height - 1)));
+	if ((triangle.minX > triangle.maxX) || (triangle.minY > triangle.maxY))
+	{
+		return;
+	}
+
+	triangle.draw = drawIndex;
+	triangles.push_back(triangle);
+}
+
+/***********************************************************
+ *  RenderTile()
+ *
+ *  This method is used for rendering one tile.  The binned
+ *  triangles are rasterized in draw order into the
+ *  visibility buffer, then each covered pixel is shaded
+ *  once with its nearest triangle.
+ ***********************************************************/
+void SoftwareRasterizer::RenderTile(const SOFTWARE_SCENE& scene, int tile, uint32_t clearColor)
+{
+	int tileX0 = (tile % m_tilesX) * g_TileSize;
+	int tileY0 = (tile / m_tilesX) * g_TileSize;
+	int tileX1 = std::min(tileX0 + g_TileSize, m_width);
+	int tileY1 = std::min(tileY0 + g_TileSize, m_height);
+
+	for (int y = tileY0; y < tileY1; y++)
+	{
+		size_t row = (size_t)y * m_stride;
+		std::fill(&m_depth[row + tileX0], &m_depth[row + tileX1], 1.0f);
+		std::fill(&m_triangleIDs[row + tileX0], &m_triangleIDs[row + tileX1], g_NoTriangle);
+	}
+
+	for (uint32_t triangleID : m_tileBins[tile])
+	{
+		RasterizeTriangle(m_triangles[triangleID], triangleID, tileX0, tileY0, tileX1, tileY1);
+	}
+
+	for (int y = tileY0; y < tileY1; y++)
+	{
+		for (int x = tileX0; x < tileX1; x++)
+		{
+			size_t index = (size_t)y * m_stride + x;
+			uint32_t triangleID = m_triangleIDs[index];
+			if (triangleID == g_NoTriangle)
+			{
+				m_color[index] = clearColor;
+				continue;
+			}
+
+			// perspective correct attributes at the pixel
+			const SETUP_TRIANGLE& triangle = m_triangles[triangleID];
+			float weights[3];
+			weights[1] = m_weightB[index];
+			weights[2] = m_weightC[index];
+			weights[0] = 1.0f - weights[1] - weights[2];
+			float inverseW = weights[0] * triangle.inverseW[0] + weights[1] * triangle.inverseW[1] + weights[2] * triangle.inverseW[2];
+			float w = 1.0f / inverseW;
+
+			float attributes[g_AttributeCount];
+			for (int k = 0; k < g_AttributeCount; k++)
+			{
+				attributes[k] = (weights[0] * triangle.attributes[0][k] +
+					weights[1] * triangle.attributes[1][k] +
+					weights[2] * triangle.attributes[2][k]) * w;
+			}
+
+			const SOFTWARE_DRAW& draw = scene.draws[triangle.draw];
+			glm::vec4 color = ShadeSceneFragment(
+				scene,
+				scene.pInstances[draw.instance],
+				draw.textureSlot,
+				glm::vec3(attributes[0], attributes[1], attributes[2]),
+				glm::vec3(attributes[3], attributes[4], attributes[5]),
+				glm::vec2(attributes[6], attributes[7]));
+			m_color[index] = PackColor(color);
+		}
+	}
+}
+
+/***********************************************************
+ *  RasterizeTriangle()
+ *
+ *  This method is used for finding the pixels of the tile
+ *  the triangle covers and is nearest at, recording the
+ *  triangle and its barycentric weights there.  With SSE2
+ *  the edge functions, depth and weights are evaluated for
+ *  four pixels of a row at once.
+ ***********************************************************/
+void SoftwareRasterizer::RasterizeTriangle(
+	const SETUP_TRIANGLE& triangle,
+	uint32_t triangleID,
+	int tileX0,
+	int tileY0,
+	int tileX1,
+	int tileY1)
+{
+	int minX = std::max(triangle.minX, tileX0);
+	int maxX = std::min(triangle.maxX, tileX1 - 1);
+	int minY = std::max(triangle.minY, tileY0);
+	int maxY = std::min(triangle.maxY, tileY1 - 1);
+	if ((minX > maxX) || (minY > maxY))
+	{
+		return;
+	}
+
+	float depthB = triangle.depth[1] - triangle.depth[0];
+	float depthC = triangle.depth[2] - triangle.depth[0];
+
+#if defined(RASTER_SIMD_SSE)
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 endX = _mm_set1_ps((float)(maxX + 1));
+	const __m128 inverseArea = _mm_set1_ps(triangle.inverseArea);
+	const __m128 depth0 = _mm_set1_ps(triangle.depth[0]);
+	const __m128 depthStepB = _mm_set1_ps(depthB);
+	const __m128 depthStepC = _mm_set1_ps(depthC);
+	const __m128i id = _mm_set1_epi32((int)triangleID);
+	__m128 edgeA[3];
+	for (int i = 0; i < 3; i++)
+	{
+		edgeA[i] = _mm_set1_ps(triangle.edgeA[i]);
+	}
+
+	// the tiles start on a multiple of four, so aligning the first
+	// step down never leaves the tile
+	int startX = minX & ~3;
+	for (int y = minY; y <= maxY; y++)
+	{
+		float centerY = (float)y + 0.5f;
+		__m128 rowEdge[3];
+		for (int i = 0; i < 3; i++)
+		{
+			rowEdge[i] = _mm_set1_ps(triangle.edgeB[i] * centerY + triangle.edgeC[i]);
+		}
+
+		for (int x = startX; x <= maxX; x += 4)
+		{
+			__m128 centerX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+			__m128 coverage = _mm_cmplt_ps(centerX, endX);
+			__m128 edges[3];
+			for (int i = 0; i < 3; i++)
+			{
+				edges[i] = _mm_add_ps(_mm_mul_ps(edgeA[i], centerX), rowEdge[i]);
+				__m128 inside = triangle.bOwnedEdge[i] ? _mm_cmpge_ps(edges[i], zero) : _mm_cmpgt_ps(edges[i], zero);
+				coverage = _mm_and_ps(coverage, inside);
+			}
+			if (_mm_movemask_ps(coverage) == 0)
+			{
+				continue;
+			}
+
+			__m128 weightB = _mm_mul_ps(edges[1], inverseArea);
+			__m128 weightC = _mm_mul_ps(edges[2], inverseArea);
+			__m128 depth = _mm_add_ps(depth0, _mm_add_ps(_mm_mul_ps(weightB, depthStepB), _mm_mul_ps(weightC, depthStepC)));
+
+			size_t index = (size_t)y * m_stride + x;
+			__m128 storedDepth = _mm_loadu_ps(&m_depth[index]);
+			__m128 pass = _mm_and_ps(coverage, _mm_cmplt_ps(depth, storedDepth));
+			if (_mm_movemask_ps(pass) == 0)
+			{
+				continue;
+			}
+
+			_mm_storeu_ps(&m_depth[index], _mm_or_ps(_mm_and_ps(pass, depth), _mm_andnot_ps(pass, storedDepth)));
+			_mm_storeu_ps(&m_weightB[index], _mm_or_ps(_mm_and_ps(pass, weightB), _mm_andnot_ps(pass, _mm_loadu_ps(&m_weightB[index]))));
+			_mm_storeu_ps(&m_weightC[index], _mm_or_ps(_mm_and_ps(pass, weightC), _mm_andnot_ps(pass, _mm_loadu_ps(&m_weightC[index]))));
+
+			__m128i passMask = _mm_castps_si128(pass);
+			__m128i storedIDs = _mm_loadu_si128((const __m128i*)&m_triangleIDs[index]);
+			_mm_storeu_si128((__m128i*)&m_triangleIDs[index],
+				_mm_or_si128(_mm_and_si128(passMask, id), _mm_andnot_si128(passMask, storedIDs)));
+		}
+	}
+#else
+	for (int y = minY; y <= maxY; y++)
+	{
+		float centerY = (float)y + 0.5f;
+		for (int x = minX; x <= maxX; x++)
+		{
+			float centerX = (float)x + 0.5f;
+			float edges[3];
+			bool bCovered = true;
+			for (int i = 0; i < 3; i++)
+			{
+				edges[i] = triangle.edgeA[i] * centerX + triangle.edgeB[i] * centerY + triangle.edgeC[i];
+				bCovered = bCovered && (triangle.bOwnedEdge[i] ? (edges[i] >= 0.0f) : (edges[i] > 0.0f));
+			}
+			if (!bCovered)
+			{
+				continue;
+			}
+
+			float weightB = edges[1] * triangle.inverseArea;
+			float weightC = edges[2] * triangle.inverseArea;
+			float depth = triangle.depth[0] + weightB * depthB + weightC * depthC;
+
+			size_t index = (size_t)y * m_stride + x;
+			if (depth < m_depth[index])
+			{
+				m_depth[index] = depth;
+				m_weightB[index] = weightB;
+				m_weightC[index] = weightC;
+				m_triangleIDs[index] = triangleID;
+			}
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  WriteImage()
+ *
+ *  This method is used for writing the color buffer into a
+ *  binary PPM image, top row first.
+ ***********************************************************/
+bool SoftwareRasterizer::WriteImage(const char* filename) const
+{
+	return(WritePPMImage(filename, m_color.data(), m_width, m_height, m_stride));
+}
@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.h
+// ============
+// multithreaded tile based CPU rasterizer for the scene
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneEntities.h"
+#include "SoftwareScene.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SOFTWARE_RENDER_STATS
+ *
+ *  Work done and time taken by the last software frame.
+ ***********************************************************/
+struct SOFTWARE_RENDER_STATS
+{
+	uint32_t drawCount;
+	// triangles left after clipping
+	uint32_t triangleCount;
+	// triangle references across all of the tile bins
+	uint32_t binnedTriangles;
+	double geometryMilliseconds;
+	double rasterMilliseconds;
+	double totalMilliseconds;
+};
+
+/***********************************************************
+ *  SoftwareRasterizer
+ *
+ *  This class renders a SOFTWARE_SCENE into its own color
+ *  buffer without any OpenGL driver.  Each frame runs in
+ *  three steps:
+ *
+ *  1. the draws are transformed, clipped and set up in
+ *     parallel, one job per batch of draws
+ *  2. the triangles are binned into screen tiles in draw
+ *     order, so the result never depends on thread timing
+ *  3. the tiles are rasterized in parallel - coverage and
+ *     depth are tested four pixels at a time with SIMD into
+ *     a visibility buffer, then every visible pixel is
+ *     shaded exactly once
+ ***********************************************************/
+class SoftwareRasterizer
+{
+public:
+	// constructor
+	SoftwareRasterizer(int width, int height);
+
+	// change the size of the color buffer
+	void Resize(int width, int height);
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+	// render one frame
+	void Render(
+		const SOFTWARE_SCENE& scene,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		glm::vec4 clearColor);
+
+	// one row of RGBA8 pixels - row zero is the top of the image
+	const uint32_t* GetRow(int y) const { return &m_color[(size_t)y * m_stride]; }
+	// write the color buffer into a binary PPM file
+	bool WriteImage(const char* filename) const;
+
+	const SOFTWARE_RENDER_STATS& GetStats() const { return m_stats; }
+
+private:
+	// a triangle ready for rasterization, in screen space
+	struct SETUP_TRIANGLE
+	{
+		// edge functions A * x + B * y + C - edge i is opposite vertex i
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		// pixels exactly on an owned edge are covered, so pixels on an
+		// edge shared by two triangles are only drawn once
+		bool bOwnedEdge[3];
+		float inverseArea;
+		float depth[3];
+		float inverseW[3];
+		// world position, normal and texture coordinate of each
+		// vertex, divided by w for perspective correct interpolation
+		float attributes[3][8];
+		// pixel bounds, inclusive
+		int minX, minY, maxX, maxY;
+		uint32_t draw;
+	};
+
+	// a vertex in clip space with its attributes
+	struct CLIP_VERTEX
+	{
+		glm::vec4 position;
+		float attributes[8];
+	};
+
+	int m_width;
+	int m_height;
+	// pixels per buffer row - padded so four pixel steps never
+	// run past the end of a row
+	int m_stride;
+	int m_tilesX;
+	int m_tilesY;
+
+	SceneVector<uint32_t> m_color;
+	SceneVector<float> m_depth;
+	// visibility buffer - nearest triangle and its second and
+	// third barycentric weights at each pixel
+	SceneVector<uint32_t> m_triangleIDs;
+	SceneVector<float> m_weightB;
+	SceneVector<float> m_weightC;
+
+	// set up triangles of each draw, then all of them in draw order
+	std::vector<std::vector<SETUP_TRIANGLE>> m_drawTriangles;
+	std::vector<SETUP_TRIANGLE> m_triangles;
+	// triangle indexes overlapping each tile
+	std::vector<std::vector<uint32_t>> m_tileBins;
+
+	SOFTWARE_RENDER_STATS m_stats;
+
+	// transform and clip the triangles of one draw
+	void SetupDraw(
+		const SOFTWARE_SCENE& scene,
+		uint32_t drawIndex,
+		const glm::mat4& viewProjection,
+		std::vector<CLIP_VERTEX>& clipVertices,
+		std::vector<SETUP_TRIANGLE>& triangles) const;
+	// clip a triangle to the near and far planes and set up the pieces
+	void ClipTriangle(
+		const CLIP_VERTEX& a,
+		const CLIP_VERTEX& b,
+		const CLIP_VERTEX& c,
+		uint32_t drawIndex,
+		std::vector<SETUP_TRIANGLE>& triangles) const;
+	// project a triangle in front of the camera to screen space
+	void SetupTriangle(
+		const CLIP_VERTEX& a,
+		const CLIP_VERTEX& b,
+		const CLIP_VERTEX& c,
+		uint32_t drawIndex,
+		std::vector<SETUP_TRIANGLE>& triangles) const;
+	// rasterize and shade one tile
+	void RenderTile(const SOFTWARE_SCENE& scene, int tile, uint32_t clearColor);
+	// find the nearest triangle at each pixel of the tile
+	void RasterizeTriangle(const SETUP_TRIANGLE& triangle, uint32_t triangleID, int tileX0, int tileY0, int tileX1, int tileY1);
+};
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerenderdevice.cpp
+// ============
+// render device that executes command lists with the software rasterizer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRenderDevice.h"
+
+#include <chrono>
+
+/***********************************************************
+ *  SoftwareRenderDevice()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoftwareRenderDevice::SoftwareRenderDevice(SoftwareRasterizer* pRasterizer, const std::vector<SoftwareTexture>* pTextures)
+{
+	m_pRasterizer = pRasterizer;
+	m_pTextures = pTextures;
+	m_scene = {};
+	m_view = glm::mat4(1.0f);
+	m_projection = glm::mat4(1.0f);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for pointing the software frame at
+ *  the shadow copies of the scene buffers.  Nothing reads
+ *  the GPU copies, so their pending uploads are dropped.
+ ***********************************************************/
+void SoftwareRenderDevice::BeginFrame(const RENDER_FRAME& frame)
+{
+	frame.pInstances->DiscardChanges();
+	frame.pMaterials->DiscardChanges();
+	frame.pLights->DiscardChanges();
+
+	m_scene.pInstances = (const INSTANCE_RECORD*)frame.pInstances->Read(0);
+	m_scene.instanceCount = frame.pInstances->GetCount();
+	m_scene.pMaterials = (const MATERIAL_RECORD*)frame.pMaterials->Read(0);
+	m_scene.materialCount = frame.pMaterials->GetCount();
+	m_scene.pLights = (const LIGHT_RECORD*)frame.pLights->Read(0);
+	m_scene.lightCount = frame.pLights->GetCount();
+	m_scene.pTextures = m_pTextures->empty() ? NULL : &(*m_pTextures)[0];
+	m_scene.textureCount = m_pTextures->size();
+	m_scene.bUseLighting = (frame.constants.bUseLighting != 0);
+	m_scene.wind = frame.pWind->GetUniforms(frame.time);
+	m_scene.viewPosition = glm::vec3(frame.constants.viewPosition);
+
+	m_view = frame.constants.view;
+	m_projection = frame.constants.projection;
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for gathering the draws of the
+ *  command lists, in order, into the software frame and
+ *  rendering it.
+ ***********************************************************/
+void SoftwareRenderDevice::Submit(const RenderCommandList* pLists, size_t listCount)
+{
+	std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+	m_stats = {};
+	m_stats.commandLists = (uint32_t)listCount;
+
+	m_scene.draws.clear();
+	int previousTextureSlot = -1;
+	for (size_t list = 0; list < listCount; list++)
+	{
+		const RENDER_COMMAND* pCommands = pLists[list].GetCommands();
+		size_t commandCount = pLists[list].GetCount();
+		for (size_t i = 0; i < commandCount; i++)
+		{
+			const RENDER_COMMAND& command = pCommands[i];
+			if (command.mesh >= SCENE_MESH_COUNT)
+			{
+				continue;
+			}
+
+			if (command.textureSlot != previousTextureSlot)
+			{
+				previousTextureSlot = command.textureSlot;
+				m_stats.textureChanges++;
+			}
+
+			m_scene.draws.push_back({ (SCENE_MESH)command.mesh, command.instance, command.textureSlot });
+			m_stats.draws++;
+		}
+	}
+
+	m_pRasterizer->Render(m_scene, m_view, m_projection, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+	m_stats.submitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+}
@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerenderdevice.h
+// ============
+// render device that executes command lists with the software rasterizer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "RenderDevice.h"
+#include "SoftwareRasterizer.h"
+#include "SoftwareScene.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SoftwareRenderDevice
+ *
+ *  This class executes the same command lists as the OpenGL
+ *  device on the CPU.  The draws of all the lists become
+ *  one software frame, which reads the shadow copies of the
+ *  scene buffers and is rendered when it is submitted, so
+ *  no OpenGL calls are made at all.  Imported meshes only
+ *  exist on the GPU, so their draws are skipped.
+ ***********************************************************/
+class SoftwareRenderDevice : public RenderDevice
+{
+public:
+	// constructor - the textures are indexed by texture slot
+	SoftwareRenderDevice(SoftwareRasterizer* pRasterizer, const std::vector<SoftwareTexture>* pTextures);
+
+	const char* GetName() const override { return "Software"; }
+	bool Initialize() override { return(true); }
+	int GetTargetHeight() const override { return m_pRasterizer->GetHeight(); }
+	void BeginFrame(const RENDER_FRAME& frame) override;
+	void Submit(const RenderCommandList* pLists, size_t listCount) override;
+	void EndFrame() override {}
+
+private:
+	SoftwareRasterizer* m_pRasterizer;
+	const std::vector<SoftwareTexture>* m_pTextures;
+	SOFTWARE_SCENE m_scene;
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
+};
@@ -0,0 +1,632 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarescene.cpp
+// ============
+// CPU copies of the scene meshes, textures and shading for the
+// software renderers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareScene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	const float g_TwoPi = 6.28318530718f;
+
+	// tessellation of the curved shapes
+	const int g_TorusMainSegments = 48;
+	const int g_TorusTubeSegments = 16;
+	const int g_CylinderSegments = 36;
+
+	// torus ring and tube radius
+	const float g_TorusMainRadius = 1.0f;
+	const float g_TorusTubeRadius = 0.1f;
+	// tapered cylinder radius at the base and the top
+	const float g_CylinderBaseRadius = 1.0f;
+	const float g_CylinderTopRadius = 0.5f;
+
+	// append a vertex and return its index
+	uint32_t AddVertex(SOFTWARE_MESH& mesh, glm::vec3 position, glm::vec3 normal, glm::vec2 uv)
+	{
+		SOFTWARE_VERTEX vertex;
+		vertex.position = position;
+		vertex.normal = normal;
+		vertex.uv = uv;
+		mesh.vertices.push_back(vertex);
+		return((uint32_t)(mesh.vertices.size() - 1));
+	}
+
+	void AddTriangle(SOFTWARE_MESH& mesh, uint32_t a, uint32_t b, uint32_t c)
+	{
+		mesh.indices.push_back(a);
+		mesh.indices.push_back(b);
+		mesh.indices.push_back(c);
+	}
+
+	// add a flat quad with counter-clockwise corners
+	void AddQuad(SOFTWARE_MESH& mesh, glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, glm::vec3 normal)
+	{
+		uint32_t a = AddVertex(mesh, p0, normal, glm::vec2(0.0f, 0.0f));
+		uint32_t b = AddVertex(mesh, p1, normal, glm::vec2(1.0f, 0.0f));
+		uint32_t c = AddVertex(mesh, p2, normal, glm::vec2(1.0f, 1.0f));
+		uint32_t d = AddVertex(mesh, p3, normal, glm::vec2(0.0f, 1.0f));
+		AddTriangle(mesh, a, b, c);
+		AddTriangle(mesh, a, c, d);
+	}
+
+	// unit square in the XZ plane, facing up
+	SOFTWARE_MESH BuildPlane()
+	{
+		SOFTWARE_MESH mesh;
+		AddQuad(mesh,
+			glm::vec3(-1.0f, 0.0f, 1.0f),
+			glm::vec3(1.0f, 0.0f, 1.0f),
+			glm::vec3(1.0f, 0.0f, -1.0f),
+			glm::vec3(-1.0f, 0.0f, -1.0f),
+			glm::vec3(0.0f, 1.0f, 0.0f));
+		return(mesh);
+	}
+
+	// unit cube centered on the origin with one quad per face
+	SOFTWARE_MESH BuildBox()
+	{
+		// face normal and the two axes spanning the face, with
+		// cross(u, v) equal to the normal
+		const glm::vec3 faces[6][3] =
+		{
+			{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+			{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+			{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+			{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) },
+			{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+			{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) }
+		};
+
+		SOFTWARE_MESH mesh;
+		for (int face = 0; face < 6; face++)
+		{
+			glm::vec3 center = faces[face][0] * 0.5f;
+			glm::vec3 u = faces[face][1] * 0.5f;
+			glm::vec3 v = faces[face][2] * 0.5f;
+			AddQuad(mesh, center - u - v, center + u - v, center + u + v, center - u + v, faces[face][0]);
+		}
+		return(mesh);
+	}
+
+	// ring in the XY plane around the Z axis
+	SOFTWARE_MESH BuildTorus()
+	{
+		SOFTWARE_MESH mesh;
+		for (int i = 0; i <= g_TorusMainSegments; i++)
+		{
+			float theta = g_TwoPi * i / g_TorusMainSegments;
+			glm::vec3 ringDirection = glm::vec3(std::cos(theta), std::sin(theta), 0.0f);
+			for (int j = 0; j <= g_TorusTubeSegments; j++)
+			{
+				float phi = g_TwoPi * j / g_TorusTubeSegments;
+				glm::vec3 normal = ringDirection * std::cos(phi) + glm::vec3(0.0f, 0.0f, std::sin(phi));
+				AddVertex(mesh,
+					ringDirection * g_TorusMainRadius + normal * g_TorusTubeRadius,
+					normal,
+					glm::vec2((float)i / g_TorusMainSegments, (float)j / g_TorusTubeSegments));
+			}
+		}
+
+		const uint32_t row = g_TorusTubeSegments + 1;
+		for (uint32_t i = 0; i < (uint32_t)g_TorusMainSegments; i++)
+		{
+			for (uint32_t j = 0; j < (uint32_t)g_TorusTubeSegments; j++)
+			{
+				uint32_t a = i * row + j;
+				uint32_t b = (i + 1) * row + j;
+				AddTriangle(mesh, a, b, b + 1);
+				AddTriangle(mesh, a, b + 1, a + 1);
+			}
+		}
+		return(mesh);
+	}
+
+	// cone frustum standing on the XZ plane, one unit high
+	SOFTWARE_MESH BuildTaperedCylinder()
+	{
+		SOFTWARE_MESH mesh;
+
+		// the side normals lean up by the change in radius
+		float slope = g_CylinderBaseRadius - g_CylinderTopRadius;
+		for (int i = 0; i <= g_CylinderSegments; i++)
+		{
+			float theta = g_TwoPi * i / g_CylinderSegments;
+			glm::vec3 direction = glm::vec3(std::cos(theta), 0.0f, std::sin(theta));
+			glm::vec3 normal = glm::normalize(direction + glm::vec3(0.0f, slope, 0.0f));
+			float u = (float)i / g_CylinderSegments;
+			AddVertex(mesh, direction * g_CylinderBaseRadius, normal, glm::vec2(u, 0.0f));
+			AddVertex(mesh, direction * g_CylinderTopRadius + glm::vec3(0.0f, 1.0f, 0.0f), normal, glm::vec2(u, 1.0f));
+		}
+		for (uint32_t i = 0; i < (uint32_t)g_CylinderSegments; i++)
+		{
+			uint32_t a = i * 2;
+			AddTriangle(mesh, a, a + 1, a + 3);
+			AddTriangle(mesh, a, a + 3, a + 2);
+		}
+
+		// the base and top caps are fans around their centers
+		for (int cap = 0; cap < 2; cap++)
+		{
+			float height = (float)cap;
+			float radius = (cap == 0) ? g_CylinderBaseRadius : g_CylinderTopRadius;
+			glm::vec3 normal = glm::vec3(0.0f, (cap == 0) ? -1.0f : 1.0f, 0.0f);
+			uint32_t center = AddVertex(mesh, glm::vec3(0.0f, height, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+			for (int i = 0; i <= g_CylinderSegments; i++)
+			{
+				float theta = g_TwoPi * i / g_CylinderSegments;
+				glm::vec2 rim = glm::vec2(std::cos(theta), std::sin(theta));
+				AddVertex(mesh,
+					glm::vec3(rim.x * radius, height, rim.y * radius),
+					normal,
+					rim * 0.5f + glm::vec2(0.5f));
+			}
+			for (uint32_t i = 0; i < (uint32_t)g_CylinderSegments; i++)
+			{
+				AddTriangle(mesh, center, center + 1 + i, center + 2 + i);
+			}
+		}
+		return(mesh);
+	}
+
+	// triangular prism - the triangle lies in the XZ plane with its
+	// apex towards +Z, and is extruded along Y
+	SOFTWARE_MESH BuildPrism()
+	{
+		const glm::vec3 corners[3] =
+		{
+			glm::vec3(-0.5f, 0.0f, -0.5f),
+			glm::vec3(0.5f, 0.0f, -0.5f),
+			glm::vec3(0.0f, 0.0f, 0.5f)
+		};
+		const glm::vec3 up = glm::vec3(0.0f, 0.5f, 0.0f);
+
+		SOFTWARE_MESH mesh;
+		for (int i = 0; i < 3; i++)
+		{
+			glm::vec3 a = corners[i];
+			glm::vec3 b = corners[(i + 1) % 3];
+			glm::vec3 normal = glm::normalize(glm::vec3(b.z - a.z, 0.0f, a.x - b.x));
+			AddQuad(mesh, a - up, b - up, b + up, a + up, normal);
+		}
+		for (int cap = 0; cap < 2; cap++)
+		{
+			glm::vec3 offset = (cap == 0) ? -up : up;
+			glm::vec3 normal = glm::normalize(offset);
+			uint32_t first = (uint32_t)mesh.vertices.size();
+			for (int i = 0; i < 3; i++)
+			{
+				AddVertex(mesh, corners[i] + offset, normal, glm::vec2(corners[i].x + 0.5f, corners[i].z + 0.5f));
+			}
+			AddTriangle(mesh, first, first + 1, first + 2);
+		}
+		return(mesh);
+	}
+
+	std::vector<SOFTWARE_MESH> BuildSoftwareMeshes()
+	{
+		std::vector<SOFTWARE_MESH> meshes(SCENE_MESH_COUNT);
+		meshes[SCENE_MESH_PLANE] = BuildPlane();
+		meshes[SCENE_MESH_BOX] = BuildBox();
+		meshes[SCENE_MESH_TORUS] = BuildTorus();
+		meshes[SCENE_MESH_TAPERED_CYLINDER] = BuildTaperedCylinder();
+		meshes[SCENE_MESH_PRISM] = BuildPrism();
+		return(meshes);
+	}
+
+	// unpack an RGBA8 texel
+	glm::vec4 UnpackColor(uint32_t texel)
+	{
+		return(glm::vec4(
+			(float)(texel & 0xFF),
+			(float)((texel >> 8) & 0xFF),
+			(float)((texel >> 16) & 0xFF),
+			(float)(texel >> 24)) * (1.0f / 255.0f));
+	}
+}
+
+/***********************************************************
+ *  GetSoftwareMesh()
+ *
+ *  This function is used for getting the CPU copy of one of
+ *  the basic shapes.  The shapes are all built on the first
+ *  call, which is safe from any thread.
+ ***********************************************************/
+const SOFTWARE_MESH& GetSoftwareMesh(SCENE_MESH mesh)
+{
+	static const std::vector<SOFTWARE_MESH> meshes = BuildSoftwareMeshes();
+
+	if ((mesh < 0) || (mesh >= SCENE_MESH_COUNT))
+	{
+		mesh = SCENE_MESH_BOX;
+	}
+	return(meshes[mesh]);
+}
+
+/***********************************************************
+ *  SoftwareTexture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoftwareTexture::SoftwareTexture()
+{
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  SetImage()
+ *
+ *  This method is used for copying a decoded image into the
+ *  texture, expanding RGB images to RGBA.
+ ***********************************************************/
+bool SoftwareTexture::SetImage(const unsigned char* pPixels, int width, int height, int channels)
+{
+	if ((NULL == pPixels) || (width <= 0) || (height <= 0) || ((channels != 3) && (channels != 4)))
+	{
+		return(false);
+	}
+
+	m_width = width;
+	m_height = height;
+	m_texels.resize((size_t)width * height);
+	for (size_t i = 0; i < m_texels.size(); i++)
+	{
+		const unsigned char* pTexel = pPixels + i * channels;
+		uint32_t alpha = (channels == 4) ? pTexel[3] : 255;
+		m_texels[i] = pTexel[0] | (pTexel[1] << 8) | (pTexel[2] << 16) | (alpha << 24);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Sample()
+ *
+ *  This method is used for getting the bilinear filtered
+ *  color at a texture coordinate, wrapping outside of the
+ *  zero to one range.
+ ***********************************************************/
+glm::vec4 SoftwareTexture::Sample(glm::vec2 uv) const
+{
+	if (m_texels.empty())
+	{
+		return(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	}
+
+	float x = uv.x * m_width - 0.5f;
+	float y = uv.y * m_height - 0.5f;
+	float floorX = std::floor(x);
+	float floorY = std::floor(y);
+	float fractionX = x - floorX;
+	float fractionY = y - floorY;
+
+	// wrap with a positive remainder
+	int x0 = ((int)floorX % m_width + m_width) % m_width;
+	int y0 = ((int)floorY % m_height + m_height) % m_height;
+	int x1 = (x0 + 1 == m_width) ? 0 : x0 + 1;
+	int y1 = (y0 + 1 == m_height) ? 0 : y0 + 1;
+
+	glm::vec4 bottom = glm::mix(
+		UnpackColor(m_texels[(size_t)y0 * m_width + x0]),
+		UnpackColor(m_texels[(size_t)y0 * m_width + x1]),
+		fractionX);
+	glm::vec4 top = glm::mix(
+		UnpackColor(m_texels[(size_t)y1 * m_width + x0]),
+		UnpackColor(m_texels[(size_t)y1 * m_width + x1]),
+		fractionX);
+	return(glm::mix(bottom, top, fractionY));
+}
+
+/***********************************************************
+ *  GetSurfaceColor()
+ *
+ *  This function is used for getting the unlit color of a
+ *  surface point - the texture bound to the draw's slot, or
+ *  the instance color when there is none.
+ ***********************************************************/
+glm::vec4 GetSurfaceColor(
+	const SOFTWARE_SCENE& scene,
+	const INSTANCE_RECORD& instance,
+	int textureSlot,
+	glm::vec2 uv)
+{
+	if ((textureSlot >= 0) && ((size_t)textureSlot < scene.textureCount))
+	{
+		return(scene.pTextures[textureSlot].Sample(uv));
+	}
+	return(instance.color);
+}
+
+/***********************************************************
+ *  ShadeSceneFragment()
+ *
+ *  This function is used for shading a surface point the
+ *  same way the scene fragment shader does - the object
+ *  color or texture, lit by every light with the ambient,
+ *  diffuse and specular terms of the instance's material.
+ ***********************************************************/
+glm::vec4 ShadeSceneFragment(
+	const SOFTWARE_SCENE& scene,
+	const INSTANCE_RECORD& instance,
+	int textureSlot,
+	glm::vec3 position,
+	glm::vec3 normal,
+	glm::vec2 uv)
+{
+	glm::vec4 objectColor = GetSurfaceColor(scene, instance, textureSlot, uv);
+	if (!scene.bUseLighting)
+	{
+		return(objectColor);
+	}
+
+	// objects without a material reflect nothing but ambient light
+	MATERIAL_RECORD material = {};
+	material.ambientColor = glm::vec3(1.0f);
+	material.ambientStrength = 1.0f;
+	if ((instance.materialIndex >= 0) && ((size_t)instance.materialIndex < scene.materialCount))
+	{
+		material = scene.pMaterials[instance.materialIndex];
+	}
+
+	glm::vec3 lightNormal = glm::normalize(normal);
+	glm::vec3 viewDirection = glm::normalize(scene.viewPosition - position);
+	glm::vec3 phongResult = glm::vec3(0.0f);
+	for (size_t i = 0; i < scene.lightCount; i++)
+	{
+		const LIGHT_RECORD& light = scene.pLights[i];
+
+		glm::vec3 ambient = light.ambientColor * material.ambientColor * material.ambientStrength;
+
+		glm::vec3 lightDirection = glm::normalize(light.position - position);
+		float impact = std::max(glm::dot(lightNormal, lightDirection), 0.0f);
+		glm::vec3 diffuse = impact * light.diffuseColor * material.diffuseColor;
+
+		glm::vec3 reflectDirection = 2.0f * glm::dot(lightNormal, lightDirection) * lightNormal - lightDirection;
+		float specularComponent = std::pow(std::max(glm::dot(viewDirection, reflectDirection), 0.0f), std::max(light.focalStrength, 1.0f));
+		glm::vec3 specular = light.specularIntensity * specularComponent * light.specularColor * material.specularColor;
+
+		phongResult += ambient + diffuse + specular;
+	}
+
+	return(glm::vec4(phongResult * glm::vec3(objectColor), objectColor.a));
+}
+
+/***********************************************************
+ *  WritePPMImage()
+ *
+ *  This function is used for writing an image of RGBA8
+ *  pixels into a binary PPM file, dropping the alpha.
+ ***********************************************************/
+bool WritePPMImage(const char* filename, const uint32_t* pPixels, int width, int height, int stride)
+{
+	std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write image:" << filename << std::endl;
+		return(false);
+	}
+
+	file << "P6\n" << width << " " << height << "\n255\n";
+	std::vector<unsigned char> row((size_t)width * 3);
+	for (int y = 0; y < height; y++)
+	{
+		const uint32_t* pRow = pPixels + (size_t)y * stride;
+		for (int x = 0; x < width; x++)
+		{
+			row[x * 3 + 0] = (unsigned char)(pRow[x] & 0xFF);
+			row[x * 3 + 1] = (unsigned char)((pRow[x] >> 8) & 0xFF);
+			row[x * 3 + 2] = (unsigned char)((pRow[x] >> 16) & 0xFF);
+		}
+		file.write((const char*)row.data(), row.size());
+	}
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  ReadPPMImage()
+ *
+ *  This function is used for reading a binary PPM file with
+ *  8 bits per channel into RGBA8 pixels.  Comments in the
+ *  header are not supported, since WritePPMImage() never
+ *  writes any.
+ ***********************************************************/
+bool ReadPPMImage(const char* filename, std::vector<uint32_t>& pixels, int& width, int& height)
+{
+	std::ifstream file(filename, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	std::string magic;
+	int maxValue = 0;
+	file >> magic >> width >> height >> maxValue;
+	// a single whitespace character separates the header from the pixels
+	file.get();
+	if ((magic != "P6") || (width <= 0) || (height <= 0) || (maxValue != 255) || !file.good())
+	{
+		std::cout << "Could not read image:" << filename << std::endl;
+		return(false);
+	}
+
+	std::vector<unsigned char> data((size_t)width * height * 3);
+	file.read((char*)data.data(), data.size());
+	if ((size_t)file.gcount() != data.size())
+	{
+		std::cout << "Could not read image:" << filename << std::endl;
+		return(false);
+	}
+
+	pixels.resize((size_t)width * height);
+	for (size_t i = 0; i < pixels.size(); i++)
+	{
+		pixels[i] = (uint32_t)data[i * 3 + 0] |
+			((uint32_t)data[i * 3 + 1] << 8) |
+			((uint32_t)data[i * 3 + 2] << 16) |
+			0xFF000000u;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  EncodePNGImage()
+ *
+ *  This function is used for encoding an image of RGBA8
+ *  pixels as a PNG in memory, dropping the alpha.  There is
+ *  no zlib in the project, so the image data is kept in
+ *  stored deflate blocks - the file is about as large as a
+ *  PPM, but every viewer opens it and encoding it costs no
+ *  more than the checksums.
+ ***********************************************************/
+void EncodePNGImage(const uint32_t* pPixels, int width, int height, int stride, std::vector<unsigned char>& png)
+{
+	png.clear();
+
+	static const uint32_t* s_pCrcTable = []()
+	{
+		static uint32_t table[256];
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++)
+			{
+				c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+			}
+			table[n] = c;
+		}
+		return(table);
+	}();
+
+	// chunks are written big endian, with a CRC over the type
+	// and the data
+	std::vector<unsigned char> chunk;
+	auto put32 = [&chunk](uint32_t value)
+	{
+		chunk.push_back((unsigned char)(value >> 24));
+		chunk.push_back((unsigned char)(value >> 16));
+		chunk.push_back((unsigned char)(value >> 8));
+		chunk.push_back((unsigned char)value);
+	};
+	auto writeChunk = [&png, &chunk](const char* type)
+	{
+		uint32_t crc = 0xFFFFFFFFu;
+		auto update = [&crc](const unsigned char* pBytes, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				crc = s_pCrcTable[(crc ^ pBytes[i]) & 0xFF] ^ (crc >> 8);
+			}
+		};
+		update((const unsigned char*)type, 4);
+		update(chunk.data(), chunk.size());
+		crc ^= 0xFFFFFFFFu;
+
+		unsigned char length[4] = {
+			(unsigned char)(chunk.size() >> 24), (unsigned char)(chunk.size() >> 16),
+			(unsigned char)(chunk.size() >> 8), (unsigned char)chunk.size() };
+		unsigned char check[4] = {
+			(unsigned char)(crc >> 24), (unsigned char)(crc >> 16),
+			(unsigned char)(crc >> 8), (unsigned char)crc };
+		png.insert(png.end(), length, length + 4);
+		png.insert(png.end(), type, type + 4);
+		png.insert(png.end(), chunk.begin(), chunk.end());
+		png.insert(png.end(), check, check + 4);
+		chunk.clear();
+	};
+
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	size_t rawBytes = (size_t)height * ((size_t)width * 3 + 1);
+	png.reserve(rawBytes + rawBytes / 65535 * 5 + 64);
+	png.insert(png.end(), signature, signature + sizeof(signature));
+
+	// 8 bits per channel RGB, no interlacing
+	put32((uint32_t)width);
+	put32((uint32_t)height);
+	chunk.insert(chunk.end(), { 8, 2, 0, 0, 0 });
+	writeChunk("IHDR");
+
+	// every row starts with filter type 0
+	std::vector<unsigned char> raw;
+	raw.reserve((size_t)height * ((size_t)width * 3 + 1));
+	for (int y = 0; y < height; y++)
+	{
+		const uint32_t* pRow = pPixels + (size_t)y * stride;
+		raw.push_back(0);
+		for (int x = 0; x < width; x++)
+		{
+			raw.push_back((unsigned char)(pRow[x] & 0xFF));
+			raw.push_back((unsigned char)((pRow[x] >> 8) & 0xFF));
+			raw.push_back((unsigned char)((pRow[x] >> 16) & 0xFF));
+		}
+	}
+
+	// zlib header, stored blocks of at most 65535 bytes, and the
+	// Adler-32 of the raw data
+	chunk.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	chunk.push_back(0x78);
+	chunk.push_back(0x01);
+	size_t offset = 0;
+	do
+	{
+		size_t blockBytes = std::min(raw.size() - offset, (size_t)65535);
+		chunk.push_back((offset + blockBytes == raw.size()) ? 1 : 0);
+		chunk.push_back((unsigned char)(blockBytes & 0xFF));
+		chunk.push_back((unsigned char)(blockBytes >> 8));
+		chunk.push_back((unsigned char)(~blockBytes & 0xFF));
+		chunk.push_back((unsigned char)((~blockBytes >> 8) & 0xFF));
+		chunk.insert(chunk.end(), raw.begin() + offset, raw.begin() + offset + blockBytes);
+		offset += blockBytes;
+	} while (offset < raw.size());
+
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	// 5552 bytes is the most that can be summed before the
+	// modulo without overflowing
+	for (size_t start = 0; start < raw.size(); start += 5552)
+	{
+		size_t end = std::min(start + 5552, raw.size());
+		for (size_t i = start; i < end; i++)
+		{
+			adlerA += raw[i];
+			adlerB += adlerA;
+		}
+		adlerA %= 65521;
+		adlerB %= 65521;
+	}
+	put32((adlerB << 16) | adlerA);
+	writeChunk("IDAT");
+	writeChunk("IEND");
+}
+
+/***********************************************************
+ *  WritePNGImage()
+ *
+ *  This function is used for writing an image of RGBA8
+ *  pixels into a PNG file.
+ ***********************************************************/
+bool WritePNGImage(const char* filename, const uint32_t* pPixels, int width, int height, int stride)
+{
+	std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write image:" << filename << std::endl;
+		return(false);
+	}
+
+	thread_local std::vector<unsigned char> png;
+	EncodePNGImage(pPixels, width, height, stride, png);
+	file.write((const char*)png.data(), png.size());
+	return(file.good());
+}
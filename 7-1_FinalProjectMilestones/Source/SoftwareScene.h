@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarescene.h
+// ============
+// CPU copies of the scene meshes, textures and shading for the
+// software renderers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MemoryTracker.h"
+#include "SceneBuffers.h"
+#include "SceneFile.h"
+#include "WindSystem.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SOFTWARE_VERTEX / SOFTWARE_MESH
+ *
+ *  One of the basic shapes as an indexed triangle list in
+ *  object space.  ShapeMeshes only keeps its vertices in
+ *  OpenGL buffers, so the software renderers build their
+ *  own copies of the same unit sized shapes.
+ ***********************************************************/
+struct SOFTWARE_VERTEX
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 uv;
+};
+
+struct SOFTWARE_MESH
+{
+	std::vector<SOFTWARE_VERTEX> vertices;
+	std::vector<uint32_t> indices;
+};
+
+// get the CPU copy of a basic shape - built on first use
+const SOFTWARE_MESH& GetSoftwareMesh(SCENE_MESH mesh);
+
+/***********************************************************
+ *  SoftwareTexture
+ *
+ *  This class keeps an RGBA8 copy of a scene texture and
+ *  samples it the way the scene shader's texture unit is
+ *  configured - bilinear filtering with repeat wrapping.
+ *  Rows are stored bottom to top, as they are uploaded to
+ *  OpenGL.
+ ***********************************************************/
+class SoftwareTexture
+{
+public:
+	// constructor
+	SoftwareTexture();
+
+	// copy an 8 bit RGB or RGBA image
+	bool SetImage(const unsigned char* pPixels, int width, int height, int channels);
+	// filtered color at the texture coordinate
+	glm::vec4 Sample(glm::vec2 uv) const;
+
+	bool IsValid() const { return !m_texels.empty(); }
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+private:
+	int m_width;
+	int m_height;
+	std::vector<uint32_t, TrackedAllocator<uint32_t, MemoryTracker::MEMTAG_TEXTURES>> m_texels;
+};
+
+/***********************************************************
+ *  SOFTWARE_DRAW
+ *
+ *  One draw in a software frame - the same mesh, instance
+ *  record and texture slot that DrawInstance() passes to
+ *  OpenGL.
+ ***********************************************************/
+struct SOFTWARE_DRAW
+{
+	SCENE_MESH mesh;
+	uint32_t instance;
+	int textureSlot;
+};
+
+/***********************************************************
+ *  SOFTWARE_SCENE
+ *
+ *  Everything a software renderer needs for one frame.  The
+ *  record arrays point at the shadow copies of the scene
+ *  buffers, so they hold exactly what the shaders would
+ *  read.
+ ***********************************************************/
+struct SOFTWARE_SCENE
+{
+	std::vector<SOFTWARE_DRAW> draws;
+	const INSTANCE_RECORD* pInstances;
+	size_t instanceCount;
+	const MATERIAL_RECORD* pMaterials;
+	size_t materialCount;
+	const LIGHT_RECORD* pLights;
+	size_t lightCount;
+	// indexed by texture slot
+	const SoftwareTexture* pTextures;
+	size_t textureCount;
+	bool bUseLighting;
+	WIND_UNIFORMS wind;
+	glm::vec3 viewPosition;
+};
+
+// the instance color, or the texture color when the draw has a texture
+glm::vec4 GetSurfaceColor(
+	const SOFTWARE_SCENE& scene,
+	const INSTANCE_RECORD& instance,
+	int textureSlot,
+	glm::vec2 uv);
+
+// CPU version of main() in Shaders/sceneFragment.glsl - the color of
+// a surface point with the passed in world position, normal and
+// scaled texture coordinate
+glm::vec4 ShadeSceneFragment(
+	const SOFTWARE_SCENE& scene,
+	const INSTANCE_RECORD& instance,
+	int textureSlot,
+	glm::vec3 position,
+	glm::vec3 normal,
+	glm::vec2 uv);
+
+// write RGBA8 pixels, top row first, into a binary PPM file
+bool WritePPMImage(const char* filename, const uint32_t* pPixels, int width, int height, int stride);
+// read a binary PPM file written by WritePPMImage() back into
+// RGBA8 pixels with an opaque alpha
+bool ReadPPMImage(const char* filename, std::vector<uint32_t>& pixels, int& width, int& height);
+// encode RGBA8 pixels, top row first, as an uncompressed PNG in memory
+void EncodePNGImage(const uint32_t* pPixels, int width, int height, int stride, std::vector<unsigned char>& png);
+// write RGBA8 pixels, top row first, into an uncompressed PNG file
+bool WritePNGImage(const char* filename, const uint32_t* pPixels, int width, int height, int stride);
+
+// pack a color into an RGBA8 pixel, clamping it like the framebuffer
+inline uint32_t PackColor(glm::vec4 color)
+{
+	uint32_t r = (uint32_t)(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f + 0.5f);
+	uint32_t g = (uint32_t)(glm::clamp(color.g, 0.0f, 1.0f) * 255.0f + 0.5f);
+	uint32_t b = (uint32_t)(glm::clamp(color.b, 0.0f, 1.0f) * 255.0f + 0.5f);
+	uint32_t a = (uint32_t)(glm::clamp(color.a, 0.0f, 1.0f) * 255.0f + 0.5f);
+	return(r | (g << 8) | (b << 16) | (a << 24));
+}
@@ -0,0 +1,322 @@
+///////////////////////////////////////////////////////////////////////////////
+// startupgraph.cpp
+// ============
+// run the startup steps as a dependency graph on the job system
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StartupGraph.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// write a string as a JSON string, as step names may hold
+	// file paths with backslashes
+	void WriteJSONString(std::ofstream& file, const std::string& text)
+	{
+		file << '"';
+		for (char c : text)
+		{
+			if ((c == '"') || (c == '\\'))
+			{
+				file << '\\' << c;
+			}
+			else if ((unsigned char)c >= 0x20)
+			{
+				file << c;
+			}
+		}
+		file << '"';
+	}
+
+	// name a timeline lane - lane zero is the main thread
+	std::string GetLaneName(int lane)
+	{
+		return((lane == 0) ? std::string("main") : "worker " + std::to_string(lane));
+	}
+}
+
+/***********************************************************
+ *  StartupGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StartupGraph::StartupGraph()
+{
+	m_runMs = 0.0;
+}
+
+/***********************************************************
+ *  AddStep()
+ *
+ *  This method is used for adding a step to the graph.  A
+ *  step may only depend on steps added before it, so the
+ *  graph cannot hold a cycle, and the main thread steps
+ *  running in the order they were added never wait on a
+ *  main thread step still to come.
+ ***********************************************************/
+int StartupGraph::AddStep(
+	const char* name,
+	STARTUP_THREAD thread,
+	const std::vector<int>& dependencies,
+	std::function<bool()> function)
+{
+	int index = (int)m_steps.size();
+
+	std::unique_ptr<STARTUP_STEP> step(new STARTUP_STEP());
+	step->name = name;
+	step->thread = thread;
+	step->function = std::move(function);
+	step->remaining = 0;
+	step->state = STEP_PENDING;
+	step->startMs = 0.0;
+	step->endMs = 0.0;
+	step->lane = 0;
+	for (int dependency : dependencies)
+	{
+		if ((dependency < 0) || (dependency >= index))
+		{
+			std::cout << "WARNING: startup step " << name << " ignores the dependency " << dependency << std::endl;
+			continue;
+		}
+		step->dependencies.push_back(dependency);
+		m_steps[dependency]->dependents.push_back(index);
+	}
+
+	m_steps.push_back(std::move(step));
+	return(index);
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for running the graph.  The steps
+ *  for any thread with nothing to wait on are queued right
+ *  away and queue the steps they release as they finish,
+ *  while this thread works through its own steps.  Waiting
+ *  through the job system runs queued steps on this thread
+ *  in the meantime, so it is never idle while work remains.
+ ***********************************************************/
+bool StartupGraph::Run()
+{
+	m_runStart = std::chrono::steady_clock::now();
+	m_laneThreads.clear();
+	m_laneThreads.push_back(std::this_thread::get_id());
+	m_pJobs = std::make_shared<JobCounter>();
+
+	for (std::unique_ptr<STARTUP_STEP>& step : m_steps)
+	{
+		step->remaining = (int)step->dependencies.size();
+		step->done = std::make_shared<JobCounter>();
+		step->done->pending = 1;
+		step->state = STEP_PENDING;
+	}
+
+	for (int i = 0; i < (int)m_steps.size(); i++)
+	{
+		if ((m_steps[i]->thread == STARTUP_ANY_THREAD) && m_steps[i]->dependencies.empty())
+		{
+			JobSystem::Submit([this, i]() { ExecuteStep(i); }, m_pJobs);
+		}
+	}
+
+	for (int i = 0; i < (int)m_steps.size(); i++)
+	{
+		if (m_steps[i]->thread != STARTUP_MAIN_THREAD)
+		{
+			continue;
+		}
+		for (int dependency : m_steps[i]->dependencies)
+		{
+			JobSystem::Wait(m_steps[dependency]->done);
+		}
+		ExecuteStep(i);
+	}
+
+	// the steps for any thread still running were all queued,
+	// or are released by steps already queued
+	bool bSucceeded = true;
+	for (std::unique_ptr<STARTUP_STEP>& step : m_steps)
+	{
+		JobSystem::Wait(step->done);
+		bSucceeded = bSucceeded && (step->state == STEP_DONE);
+	}
+	JobSystem::Wait(m_pJobs);
+	m_runMs = GetElapsedMs();
+
+	return(bSucceeded);
+}
+
+/***********************************************************
+ *  ExecuteStep()
+ *
+ *  This method is used for running one step, or skipping it
+ *  if a step it depends on failed or was skipped, then
+ *  marking it finished and queueing each step for any
+ *  thread that was only waiting on it.  The state is written
+ *  before the counters are, so whoever sees the step
+ *  finished also sees how it went.
+ ***********************************************************/
+void StartupGraph::ExecuteStep(int index)
+{
+	STARTUP_STEP& step = *m_steps[index];
+
+	bool bReady = true;
+	for (int dependency : step.dependencies)
+	{
+		bReady = bReady && (m_steps[dependency]->state == STEP_DONE);
+	}
+
+	step.lane = GetThreadLane();
+	step.startMs = GetElapsedMs();
+	if (bReady)
+	{
+		bool bSucceeded = step.function();
+		step.state = bSucceeded ? STEP_DONE : STEP_FAILED;
+		if (!bSucceeded)
+		{
+			std::cout << "WARNING: startup step " << step.name << " failed" << std::endl;
+		}
+	}
+	else
+	{
+		step.state = STEP_SKIPPED;
+	}
+	step.endMs = GetElapsedMs();
+
+	step.done->pending.fetch_sub(1, std::memory_order_acq_rel);
+	for (int dependent : step.dependents)
+	{
+		STARTUP_STEP& next = *m_steps[dependent];
+		if ((next.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) && (next.thread == STARTUP_ANY_THREAD))
+		{
+			JobSystem::Submit([this, dependent]() { ExecuteStep(dependent); }, m_pJobs);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetThreadLane()
+ *
+ *  This method is used for numbering the threads in the
+ *  order they first ran a step.
+ ***********************************************************/
+int StartupGraph::GetThreadLane()
+{
+	std::lock_guard<std::mutex> lock(m_laneMutex);
+	std::thread::id thread = std::this_thread::get_id();
+	for (size_t lane = 0; lane < m_laneThreads.size(); lane++)
+	{
+		if (m_laneThreads[lane] == thread)
+		{
+			return((int)lane);
+		}
+	}
+	m_laneThreads.push_back(thread);
+	return((int)m_laneThreads.size() - 1);
+}
+
+/***********************************************************
+ *  GetElapsedMs()
+ *
+ *  This method is used for getting the milliseconds since
+ *  the start of the run.
+ ***********************************************************/
+double StartupGraph::GetElapsedMs() const
+{
+	return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_runStart).count());
+}
+
+/***********************************************************
+ *  ReportTimeline()
+ *
+ *  This method is used for printing when each step of the
+ *  last run started and ended, on which thread, and the
+ *  chain of steps the startup time was spent waiting on -
+ *  each step's last finishing dependency, back from the
+ *  step that finished last.  The same timeline is written
+ *  as a trace, one row per thread.
+ ***********************************************************/
+void StartupGraph::ReportTimeline(const char* filename) const
+{
+	double busyMs = 0.0;
+	int lastStep = -1;
+	for (int i = 0; i < (int)m_steps.size(); i++)
+	{
+		const STARTUP_STEP& step = *m_steps[i];
+		busyMs += step.endMs - step.startMs;
+		if ((lastStep < 0) || (step.endMs > m_steps[lastStep]->endMs))
+		{
+			lastStep = i;
+		}
+	}
+
+	size_t laneCount = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_laneMutex);
+		laneCount = m_laneThreads.size();
+	}
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "INFO: startup took " << m_runMs << " ms, " << busyMs << " ms of steps on "
+		<< laneCount << " threads" << std::endl;
+	for (const std::unique_ptr<STARTUP_STEP>& step : m_steps)
+	{
+		const char* pState = (step->state == STEP_DONE) ? "" : ((step->state == STEP_FAILED) ? " (failed)" : " (skipped)");
+		std::cout << "INFO:   " << std::setw(8) << step->startMs << " - " << std::setw(8) << step->endMs << " ms  "
+			<< std::left << std::setw(10) << GetLaneName(step->lane) << std::right << step->name << pState << std::endl;
+	}
+
+	std::string criticalPath;
+	for (int i = lastStep; i >= 0;)
+	{
+		const STARTUP_STEP& step = *m_steps[i];
+		criticalPath = step.name + (criticalPath.empty() ? "" : " > ") + criticalPath;
+		int previous = -1;
+		for (int dependency : step.dependencies)
+		{
+			if ((previous < 0) || (m_steps[dependency]->endMs > m_steps[previous]->endMs))
+			{
+				previous = dependency;
+			}
+		}
+		i = previous;
+	}
+	std::cout << "INFO: startup critical path: " << criticalPath << std::endl;
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	if (NULL == filename)
+	{
+		return;
+	}
+	std::ofstream file(filename, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write startup timeline:" << filename << std::endl;
+		return;
+	}
+
+	file << "{\n  \"traceEvents\": [\n";
+	for (size_t lane = 0; lane < laneCount; lane++)
+	{
+		file << "    { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << lane
+			<< ", \"args\": { \"name\": \"" << GetLaneName((int)lane) << "\" } },\n";
+	}
+	for (size_t i = 0; i < m_steps.size(); i++)
+	{
+		const STARTUP_STEP& step = *m_steps[i];
+		file << std::fixed << std::setprecision(0);
+		file << "    { \"name\": ";
+		WriteJSONString(file, step.name);
+		file << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << step.lane
+			<< ", \"ts\": " << step.startMs * 1000.0
+			<< ", \"dur\": " << (step.endMs - step.startMs) * 1000.0
+			<< ", \"args\": { \"state\": \""
+			<< ((step.state == STEP_DONE) ? "done" : ((step.state == STEP_FAILED) ? "failed" : "skipped")) << "\" } }"
+			<< ((i + 1 < m_steps.size()) ? ",\n" : "\n");
+	}
+	file << "  ],\n  \"displayTimeUnit\": \"ms\"\n}\n";
+}
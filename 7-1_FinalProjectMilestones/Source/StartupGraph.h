@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////
+// startupgraph.h
+// ============
+// run the startup steps as a dependency graph on the job system
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  StartupGraph
+ *
+ *  This class runs the steps of starting up once the steps
+ *  they depend on have finished.  Steps that only read files
+ *  and work on memory go on the job system the moment they
+ *  are ready, while the steps needing the OpenGL context run
+ *  on the thread that owns it, in the order they were added,
+ *  helping with the queued jobs whenever they have to wait.
+ *  The start and end of every step are kept for a timeline.
+ ***********************************************************/
+class StartupGraph
+{
+public:
+	// where a step may run
+	enum STARTUP_THREAD
+	{
+		// on a worker, or on the main thread while it waits
+		STARTUP_ANY_THREAD = 0,
+		// on the thread calling Run() - for the OpenGL steps
+		STARTUP_MAIN_THREAD
+	};
+
+	// constructor
+	StartupGraph();
+
+	// add a step, run once every step it depends on has
+	// finished, and return its index - a step may only depend
+	// on steps added before it, and returns false on failure
+	int AddStep(
+		const char* name,
+		STARTUP_THREAD thread,
+		const std::vector<int>& dependencies,
+		std::function<bool()> function);
+
+	// run every step and return once all have finished - false
+	// if a step failed, in which case the steps depending on it
+	// were skipped
+	bool Run();
+
+	// print the timeline of the last run and write it into a
+	// trace file for chrome://tracing or Perfetto
+	void ReportTimeline(const char* filename) const;
+
+private:
+	enum STEP_STATE
+	{
+		STEP_PENDING = 0,
+		STEP_DONE,
+		STEP_FAILED,
+		STEP_SKIPPED
+	};
+
+	struct STARTUP_STEP
+	{
+		std::string name;
+		STARTUP_THREAD thread;
+		std::function<bool()> function;
+		std::vector<int> dependencies;
+		std::vector<int> dependents;
+		// dependencies that have not finished yet
+		std::atomic<int> remaining;
+		// reaches zero once the step has finished, so the main
+		// thread can wait on it through the job system
+		JobCounterPtr done;
+		STEP_STATE state;
+		// milliseconds since the start of the run, and the
+		// timeline lane of the thread the step ran on
+		double startMs;
+		double endMs;
+		int lane;
+	};
+
+	// the steps are not movable, as they hold atomics
+	std::vector<std::unique_ptr<STARTUP_STEP>> m_steps;
+	std::chrono::steady_clock::time_point m_runStart;
+	double m_runMs;
+	// lane of each thread that ran a step - the main thread is
+	// always lane zero
+	std::vector<std::thread::id> m_laneThreads;
+	mutable std::mutex m_laneMutex;
+	// tracks the any thread steps submitted to the job system
+	JobCounterPtr m_pJobs;
+
+	// run one step, or skip it when a dependency did not
+	// succeed, and release the steps waiting on it
+	void ExecuteStep(int index);
+	// get the timeline lane of the calling thread
+	int GetThreadLane();
+	double GetElapsedMs() const;
+};
@@ -0,0 +1,273 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticscene.h
+// ============
+// build world matrices, bounds and sorted draw lists at compile time
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneFile.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/***********************************************************
+ *  STATIC_OBJECT_DESC
+ *
+ *  One object of a static scene, declared with its mesh,
+ *  transform, color, texture and material.
+ ***********************************************************/
+struct STATIC_OBJECT_DESC
+{
+	SCENE_MESH mesh;
+	float scale[3];
+	float rotationDegrees[3];
+	float position[3];
+	float color[4];
+	const char* textureTag;
+	const char* materialTag;
+};
+
+/***********************************************************
+ *  STATIC_DRAW
+ *
+ *  One precomputed draw of a static scene.  The world matrix
+ *  is column-major, the same layout as glm::mat4.
+ ***********************************************************/
+struct STATIC_DRAW
+{
+	float world[16];
+	float boundsCenter[3];
+	float boundsRadius;
+	float color[4];
+	uint32_t mesh;
+	const char* textureTag;
+	const char* materialTag;
+};
+
+template <size_t COUNT>
+struct STATIC_SCENE_TABLE
+{
+	STATIC_DRAW draws[COUNT];
+	size_t count;
+};
+
+// compile-time math used to build the static scene tables
+namespace StaticSceneMath
+{
+	constexpr double PI = 3.14159265358979323846;
+
+	// wrap an angle in radians into [-pi, pi]
+	constexpr double WrapAngle(double radians)
+	{
+		while (radians > PI) radians -= 2.0 * PI;
+		while (radians < -PI) radians += 2.0 * PI;
+		return radians;
+	}
+
+	// Taylor series - accurate to well below float precision
+	// once the angle has been wrapped
+	constexpr double Sine(double radians)
+	{
+		double x = WrapAngle(radians);
+		double term = x;
+		double sum = x;
+		for (int n = 1; n < 12; n++)
+		{
+			term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+			sum += term;
+		}
+		return sum;
+	}
+
+	constexpr double Cosine(double radians)
+	{
+		return Sine(radians + PI / 2.0);
+	}
+
+	constexpr double SquareRoot(double value)
+	{
+		if (value <= 0.0)
+		{
+			return 0.0;
+		}
+		double estimate = (value > 1.0) ? value : 1.0;
+		for (int i = 0; i < 64; i++)
+		{
+			estimate = 0.5 * (estimate + value / estimate);
+		}
+		return estimate;
+	}
+
+	struct MATRIX
+	{
+		double m[16];
+	};
+
+	constexpr MATRIX Identity()
+	{
+		MATRIX result = {};
+		result.m[0] = result.m[5] = result.m[10] = result.m[15] = 1.0;
+		return result;
+	}
+
+	// column-major multiply, the same as glm
+	constexpr MATRIX Multiply(const MATRIX& a, const MATRIX& b)
+	{
+		MATRIX result = {};
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				double sum = 0.0;
+				for (int k = 0; k < 4; k++)
+				{
+					sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+				}
+				result.m[column * 4 + row] = sum;
+			}
+		}
+		return result;
+	}
+
+	// rotation about one of the X, Y or Z axes
+	constexpr MATRIX Rotation(int axis, double degrees)
+	{
+		double radians = degrees * PI / 180.0;
+		double c = Cosine(radians);
+		double s = Sine(radians);
+		MATRIX result = Identity();
+		int a = (axis + 1) % 3;
+		int b = (axis + 2) % 3;
+		result.m[a * 4 + a] = c;
+		result.m[a * 4 + b] = s;
+		result.m[b * 4 + a] = -s;
+		result.m[b * 4 + b] = c;
+		return result;
+	}
+
+	// compare two tags, treating null as the smallest
+	constexpr int CompareTags(const char* a, const char* b)
+	{
+		if (a == b) return 0;
+		if (a == nullptr) return -1;
+		if (b == nullptr) return 1;
+		while ((*a != '\0') && (*a == *b))
+		{
+			a++;
+			b++;
+		}
+		return (int)(unsigned char)*a - (int)(unsigned char)*b;
+	}
+
+	// true when draw a should be issued before draw b
+	constexpr bool DrawsBefore(const STATIC_DRAW& a, const STATIC_DRAW& b)
+	{
+		if (a.mesh != b.mesh) return a.mesh < b.mesh;
+		int texture = CompareTags(a.textureTag, b.textureTag);
+		if (texture != 0) return texture < 0;
+		return CompareTags(a.materialTag, b.materialTag) < 0;
+	}
+}
+
+/***********************************************************
+ *  GetStaticMeshRadius()
+ *
+ *  Bounding sphere radius around the origin of each of the
+ *  unit sized basic meshes.  This matches the radii the
+ *  entity store uses for dynamic objects.
+ ***********************************************************/
+constexpr float GetStaticMeshRadius(SCENE_MESH mesh)
+{
+	return (mesh == SCENE_MESH_PLANE) ? 1.415f :
+		(mesh == SCENE_MESH_BOX) ? 0.867f :
+		(mesh == SCENE_MESH_TORUS) ? 1.5f :
+		(mesh == SCENE_MESH_TAPERED_CYLINDER) ? 1.415f : 1.0f;
+}
+
+/***********************************************************
+ *  BuildStaticScene()
+ *
+ *  Builds the world matrix and bounding sphere of every
+ *  declared object in the same order the entity store
+ *  applies them (translation * rotationX * rotationY *
+ *  rotationZ * scale), then sorts the draws by mesh,
+ *  texture and material.  Assign the result to a constexpr
+ *  variable so all of this happens at compile time and the
+ *  table is placed in read-only data.
+ ***********************************************************/
+template <size_t COUNT>
+constexpr STATIC_SCENE_TABLE<COUNT> BuildStaticScene(const STATIC_OBJECT_DESC (&objects)[COUNT])
+{
+	using namespace StaticSceneMath;
+
+	STATIC_SCENE_TABLE<COUNT> table = {};
+	table.count = COUNT;
+
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		const STATIC_OBJECT_DESC& object = objects[i];
+
+		MATRIX scale = Identity();
+		scale.m[0] = object.scale[0];
+		scale.m[5] = object.scale[1];
+		scale.m[10] = object.scale[2];
+
+		MATRIX translation = Identity();
+		translation.m[12] = object.position[0];
+		translation.m[13] = object.position[1];
+		translation.m[14] = object.position[2];
+
+		MATRIX world = Multiply(
+			Multiply(
+				Multiply(
+					Multiply(translation, Rotation(0, object.rotationDegrees[0])),
+					Rotation(1, object.rotationDegrees[1])),
+				Rotation(2, object.rotationDegrees[2])),
+			scale);
+
+		STATIC_DRAW& draw = table.draws[i];
+		for (int e = 0; e < 16; e++)
+		{
+			draw.world[e] = (float)world.m[e];
+		}
+
+		// rotation does not change the size of a sphere around the
+		// origin, so only the largest scale matters
+		double maxScale = 0.0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			double axisScale = (object.scale[axis] < 0.0f) ? -object.scale[axis] : object.scale[axis];
+			maxScale = (axisScale > maxScale) ? axisScale : maxScale;
+		}
+		draw.boundsCenter[0] = object.position[0];
+		draw.boundsCenter[1] = object.position[1];
+		draw.boundsCenter[2] = object.position[2];
+		draw.boundsRadius = (float)(GetStaticMeshRadius(object.mesh) * maxScale);
+
+		for (int c = 0; c < 4; c++)
+		{
+			draw.color[c] = object.color[c];
+		}
+		draw.mesh = (uint32_t)object.mesh;
+		draw.textureTag = object.textureTag;
+		draw.materialTag = object.materialTag;
+	}
+
+	// insertion sort - stable, so the declared order is kept
+	// within each group of draws sharing the same state
+	for (size_t i = 1; i < COUNT; i++)
+	{
+		STATIC_DRAW current = table.draws[i];
+		size_t j = i;
+		while ((j > 0) && DrawsBefore(current, table.draws[j - 1]))
+		{
+			table.draws[j] = table.draws[j - 1];
+			j--;
+		}
+		table.draws[j] = current;
+	}
+
+	return table;
+}
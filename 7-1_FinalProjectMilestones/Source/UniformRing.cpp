@@ -0,0 +1,244 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformring.cpp
+// ============
+// persistently mapped ring buffer for per-frame and per-draw uniform blocks
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformRing.h"
+#include "GLCapture.h"
+#include "GLDebug.h"
+#include "Metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// nanoseconds waited for a fence before the wait is retried
+	const GLuint64 g_FenceTimeout = 1000000000;
+}
+
+/***********************************************************
+ *  UniformRing()
+ *
+ *  The constructor for the class.  The buffer is created on
+ *  the first frame, once an OpenGL context exists.
+ ***********************************************************/
+UniformRing::UniformRing(const std::string& label, size_t regionBytes)
+{
+	m_label = label;
+	m_regionBytes = regionBytes;
+	m_alignment = 256;
+	m_bPersistent = false;
+	m_pMapped = NULL;
+	m_region = 0;
+	m_regionOffset = 0;
+	for (uint32_t i = 0; i < REGION_COUNT; i++)
+	{
+		m_fences[i] = NULL;
+	}
+	m_stats = {};
+}
+
+/***********************************************************
+ *  ~UniformRing()
+ *
+ *  The destructor for the class.  The buffer goes to the
+ *  deferred deletion queue, which waits for the GPU.
+ ***********************************************************/
+UniformRing::~UniformRing()
+{
+	DeleteFences();
+}
+
+/***********************************************************
+ *  CreateBuffer()
+ *
+ *  This method is used for creating the buffer with the
+ *  passed in region size.  A previous buffer is released to
+ *  the deferred deletion queue, so draws already issued
+ *  from it still read valid memory.
+ ***********************************************************/
+void UniformRing::CreateBuffer(size_t regionBytes)
+{
+	DeleteFences();
+
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	m_alignment = std::max((size_t)alignment, (size_t)16);
+	m_regionBytes = (regionBytes + m_alignment - 1) / m_alignment * m_alignment;
+	size_t totalBytes = m_regionBytes * REGION_COUNT;
+
+	m_buffer = GLBufferHandle::Create(m_label);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer.GetName());
+
+	m_bPersistent = false;
+	m_pMapped = NULL;
+	if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, totalBytes, NULL, flags);
+		m_pMapped = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, totalBytes, flags);
+		m_bPersistent = (NULL != m_pMapped);
+	}
+	if (!m_bPersistent)
+	{
+		glBufferData(GL_UNIFORM_BUFFER, totalBytes, NULL, GL_DYNAMIC_DRAW);
+		m_shadow.assign(totalBytes, 0);
+		m_pMapped = m_shadow.data();
+	}
+	else
+	{
+		m_shadow.clear();
+		m_shadow.shrink_to_fit();
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	GLResourceManager::SetMemory(
+		GLResourceManager::GLRES_BUFFER,
+		m_buffer.GetName(),
+		MemoryTracker::MEMTAG_SCENE,
+		totalBytes);
+	GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, m_buffer.GetName(), m_label.c_str());
+}
+
+/***********************************************************
+ *  DeleteFences()
+ *
+ *  This method is used for deleting the fences of every
+ *  region.
+ ***********************************************************/
+void UniformRing::DeleteFences()
+{
+	for (uint32_t i = 0; i < REGION_COUNT; i++)
+	{
+		if (NULL != m_fences[i])
+		{
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = NULL;
+		}
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving to the next region.  With
+ *  three regions the GPU is normally two frames behind at
+ *  most, so the fence has already signaled and nothing
+ *  waits.
+ ***********************************************************/
+void UniformRing::BeginFrame()
+{
+	if (!m_buffer.IsValid())
+	{
+		CreateBuffer(m_regionBytes);
+	}
+
+	m_region = (m_region + 1) % REGION_COUNT;
+	m_regionOffset = 0;
+	m_stats = {};
+
+	GLsync fence = m_fences[m_region];
+	if (NULL != fence)
+	{
+		auto waitStart = std::chrono::steady_clock::now();
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		while (result == GL_TIMEOUT_EXPIRED)
+		{
+			m_stats.bWaited = true;
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout);
+		}
+		m_stats.waitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+		if (m_stats.bWaited)
+		{
+			static MetricHistogram* s_pWaits = Metrics::GetHistogram(
+				"shrine_gpu_wait_seconds", "Time the render thread waited for the GPU, by what it waited for",
+				METRIC_WAIT_BOUNDS, "source=\"uniform_ring\"");
+			s_pWaits->Observe(m_stats.waitMilliseconds / 1000.0);
+		}
+		glDeleteSync(fence);
+		m_fences[m_region] = NULL;
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for fencing the draws that read the
+ *  current region.
+ ***********************************************************/
+void UniformRing::EndFrame()
+{
+	if (!m_buffer.IsValid())
+	{
+		return;
+	}
+	if (NULL != m_fences[m_region])
+	{
+		glDeleteSync(m_fences[m_region]);
+	}
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for reserving a range of the current
+ *  region.  A frame that does not fit replaces the buffer
+ *  with one twice the size, and carries on at the start of
+ *  the same region of the new buffer.
+ ***********************************************************/
+void* UniformRing::Allocate(size_t bytes, GLintptr& offset)
+{
+	if (!m_buffer.IsValid())
+	{
+		CreateBuffer(m_regionBytes);
+	}
+
+	size_t alignedOffset = (m_regionOffset + m_alignment - 1) / m_alignment * m_alignment;
+	if (alignedOffset + bytes > m_regionBytes)
+	{
+		size_t regionBytes = std::max(m_regionBytes * 2, bytes);
+		std::cout << "INFO: " << m_label << " grew to " << regionBytes / 1024 << "KB a frame" << std::endl;
+		CreateBuffer(regionBytes);
+		alignedOffset = 0;
+	}
+
+	offset = (GLintptr)(m_region * m_regionBytes + alignedOffset);
+	m_regionOffset = alignedOffset + bytes;
+	m_stats.allocations++;
+	m_stats.bytesUsed = m_regionOffset;
+	return(m_pMapped + offset);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding a written range to a
+ *  uniform block.  The persistent mapping is coherent, so
+ *  the writes are visible to the draws without a flush.
+ ***********************************************************/
+void UniformRing::Bind(GLuint binding, GLintptr offset, size_t bytes)
+{
+	if (!m_bPersistent)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer.GetName());
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, bytes, m_pMapped + offset);
+	}
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_buffer.GetName(), offset, bytes);
+
+	// the writes through the mapping make no OpenGL call, so a
+	// capture records them here, through the buffer the bind
+	// left on the generic binding point
+	if (m_bPersistent && GLCapture::IsCapturing())
+	{
+		GLCapture::Record(GLCAPTURE_MAPPED_WRITE, {
+			GL_UNIFORM_BUFFER, (uint64_t)offset, (uint64_t)bytes, GL_MAP_WRITE_BIT },
+			m_pMapped + offset, bytes);
+	}
+}
@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformring.h
+// ============
+// persistently mapped ring buffer for per-frame and per-draw uniform blocks
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLResources.h"
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  UNIFORM_RING_STATS
+ *
+ *  What the ring did in the last frame.
+ ***********************************************************/
+struct UNIFORM_RING_STATS
+{
+	uint32_t allocations;
+	size_t bytesUsed;
+	// the GPU was still reading the region the frame reuses
+	bool bWaited;
+	double waitMilliseconds;
+};
+
+/***********************************************************
+ *  UniformRing
+ *
+ *  This class hands out uniform block ranges from one buffer
+ *  split into a region per frame in flight.  The buffer is
+ *  mapped once, persistently and coherently, so a block is
+ *  written with a plain memcpy and bound with
+ *  glBindBufferRange, without any upload call.  A fence is
+ *  placed after the draws of every frame, and a region is
+ *  only reused once the fence of the frame that last used
+ *  it has signaled.
+ *
+ *  When the context lacks buffer storage, the blocks are
+ *  written into a copy in memory and uploaded with
+ *  glBufferSubData when they are bound.
+ ***********************************************************/
+class UniformRing
+{
+public:
+	// regions the buffer is split into - one is written while
+	// the GPU may still read the other two
+	static const uint32_t REGION_COUNT = 3;
+
+	// constructor
+	UniformRing(const std::string& label, size_t regionBytes);
+	// destructor
+	~UniformRing();
+
+	// move to the next region, waiting for the GPU to finish
+	// with it first
+	void BeginFrame();
+	// fence the draws that read the current region
+	void EndFrame();
+
+	// reserve an aligned range of the current region and return
+	// where to write it - the range stays valid until the region
+	// comes around again
+	void* Allocate(size_t bytes, GLintptr& offset);
+	// bind a range returned by Allocate to a uniform block binding
+	void Bind(GLuint binding, GLintptr offset, size_t bytes);
+
+	bool IsPersistent() const { return m_bPersistent; }
+	const UNIFORM_RING_STATS& GetStats() const { return m_stats; }
+
+private:
+	std::string m_label;
+	size_t m_regionBytes;
+	size_t m_alignment;
+	GLBufferHandle m_buffer;
+	bool m_bPersistent;
+	// the persistent mapping, or the copy in memory
+	uint8_t* m_pMapped;
+	std::vector<uint8_t> m_shadow;
+
+	uint32_t m_region;
+	size_t m_regionOffset;
+	GLsync m_fences[REGION_COUNT];
+	UNIFORM_RING_STATS m_stats;
+
+	// create the buffer, replacing any previous one
+	void CreateBuffer(size_t regionBytes);
+	void DeleteFences();
+};
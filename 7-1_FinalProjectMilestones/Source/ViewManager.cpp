@@ -20,8 +20,6 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -52,6 +50,8 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_view = glm::mat4(1.0f);
+	m_projection = glm::mat4(1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -269,14 +269,54 @@ void ViewManager::PrepareSceneView()
 	{
 		projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
 	}
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	// keep the matrices for culling and other per-frame work - the
+	// scene writes them into its per-frame uniform block, with the
+	// view position taken from the view matrix
+	m_view = view;
+	m_projection = projection;
+}
+
+/***********************************************************
+ *  PrepareHeadlessView()
+ *
+ *  This method is used for setting the view and projection
+ *  matrices from the camera for an image of the passed in
+ *  size.  Nothing is read from a window or set into a
+ *  shader, so it works without an OpenGL context.
+ ***********************************************************/
+void ViewManager::PrepareHeadlessView(int width, int height)
+{
+	float aspectRatio = (float)width / (float)std::max(height, 1);
+
+	m_view = g_pCamera->GetViewMatrix();
+	if (bOrthographicProjection)
+	{
+		m_projection = glm::ortho(-5.0f * aspectRatio, 5.0f * aspectRatio, -5.0f, 5.0f, 0.1f, 100.0f);
+	}
+	else
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		m_projection = glm::perspective(glm::radians(g_pCamera->Zoom), aspectRatio, 0.1f, 100.0f);
 	}
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *  GetWindowWidth()
+ *
+ *  This method is used for getting the width of the
+ *  display window.
+ ***********************************************************/
+int ViewManager::GetWindowWidth()
+{
+	return(WINDOW_WIDTH);
+}
+
+/***********************************************************
+ *  GetWindowHeight()
+ *
+ *  This method is used for getting the height of the
+ *  display window.
+ ***********************************************************/
+int ViewManager::GetWindowHeight()
+{
+	return(WINDOW_HEIGHT);
+}
@@ -35,6 +35,9 @@ private:
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// view and projection matrices of the current frame
+	glm::mat4 m_view;
+	glm::mat4 m_projection;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
@@ -45,4 +48,18 @@ public:
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// set the matrices from the camera for an image of the passed
+	// in size, without a window or shader - used when rendering
+	// with the software backend
+	void PrepareHeadlessView(int width, int height);
+
+	// size of the display window
+	static int GetWindowWidth();
+	static int GetWindowHeight();
+
+	// get the matrices set by the last PrepareSceneView()
+	glm::mat4 GetViewMatrix() const { return m_view; }
+	glm::mat4 GetProjectionMatrix() const { return m_projection; }
+	glm::mat4 GetViewProjection() const { return m_projection * m_view; }
 };
\ No newline at end of file
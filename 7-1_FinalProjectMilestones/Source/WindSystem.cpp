@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+// windsystem.cpp
+// ============
+// global wind parameters for the vertex shader foliage animation
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "WindSystem.h"
+#include "GLDebug.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	const float g_TwoPi = 6.28318530718f;
+
+	// a light breeze along the X axis
+	const glm::vec3 g_DefaultDirection = glm::vec3(1.0f, 0.0f, 0.3f);
+	const float g_DefaultStrength = 0.15f;
+	const float g_DefaultFrequency = 1.3f;
+	const float g_DefaultGustStrength = 0.05f;
+	const float g_DefaultGustFrequency = 0.21f;
+	// the leaves flutter this many times faster than the sway
+	const float g_FlutterScale = 3.7f;
+}
+
+/***********************************************************
+ *  WindSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+WindSystem::WindSystem()
+{
+	m_uniforms.parameters = glm::vec4(0.0f);
+	m_frequency = 0.0f;
+	m_gustFrequency = 0.0f;
+	SetWind(g_DefaultDirection, g_DefaultStrength, g_DefaultFrequency);
+	SetGusts(g_DefaultGustStrength, g_DefaultGustFrequency);
+}
+
+/***********************************************************
+ *  SetWind()
+ *
+ *  This method is used for setting the direction, strength
+ *  and frequency of the steady sway.
+ ***********************************************************/
+void WindSystem::SetWind(glm::vec3 direction, float strength, float frequency)
+{
+	float length = std::sqrt(glm::dot(direction, direction));
+	if (length > 0.0f)
+	{
+		direction = direction * (1.0f / length);
+	}
+
+	m_uniforms.direction = glm::vec4(direction.x, direction.y, direction.z, strength);
+	m_frequency = frequency;
+}
+
+/***********************************************************
+ *  SetGusts()
+ *
+ *  This method is used for setting the slow gusts layered
+ *  on top of the steady sway.
+ ***********************************************************/
+void WindSystem::SetGusts(float strength, float frequency)
+{
+	m_uniforms.parameters.w = strength;
+	m_gustFrequency = frequency;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the wind for this
+ *  frame and binding the uniform block.  The buffer is
+ *  created on first use, once an OpenGL context exists.
+ ***********************************************************/
+void WindSystem::Update(double timeSeconds)
+{
+	if (!m_buffer.IsValid())
+	{
+		m_buffer = GLBufferHandle::Create("wind uniforms");
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer.GetName());
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(WIND_UNIFORMS), NULL, GL_DYNAMIC_DRAW);
+		GL_DEBUG_LABEL(GLResourceManager::GLRES_BUFFER, m_buffer.GetName(), "wind uniforms");
+		GLResourceManager::SetMemory(
+			GLResourceManager::GLRES_BUFFER,
+			m_buffer.GetName(),
+			MemoryTracker::MEMTAG_SCENE,
+			sizeof(WIND_UNIFORMS));
+	}
+	else
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer.GetName());
+	}
+
+	WIND_UNIFORMS uniforms = GetUniforms(timeSeconds);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(WIND_UNIFORMS), &uniforms);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, WIND_BLOCK_BINDING, m_buffer.GetName());
+}
+
+/***********************************************************
+ *  GetUniforms()
+ *
+ *  This method is used for getting the wind parameters at
+ *  the passed in time.  Each term's angle is wrapped to its
+ *  own period in double precision, so the shader keeps its
+ *  float precision in long runs and the motion never jumps.
+ ***********************************************************/
+WIND_UNIFORMS WindSystem::GetUniforms(double timeSeconds) const
+{
+	WIND_UNIFORMS uniforms = m_uniforms;
+	uniforms.parameters.x = (float)std::fmod(timeSeconds * m_frequency, (double)g_TwoPi);
+	uniforms.parameters.y = (float)std::fmod(timeSeconds * m_gustFrequency, (double)g_TwoPi);
+	uniforms.parameters.z = (float)std::fmod(timeSeconds * m_frequency * g_FlutterScale, (double)g_TwoPi);
+	return(uniforms);
+}
+
+/***********************************************************
+ *  GetInstancePhase()
+ *
+ *  This method is used for hashing a position into a phase
+ *  between zero and two pi.
+ ***********************************************************/
+float WindSystem::GetInstancePhase(glm::vec3 position)
+{
+	float hash = std::sin(position.x * 12.9898f + position.y * 78.233f + position.z * 37.719f) * 43758.5453f;
+	return((hash - std::floor(hash)) * g_TwoPi);
+}
+
+/***********************************************************
+ *  ApplyWind()
+ *
+ *  This method is used for bending a world space vertex
+ *  away from the wind exactly as the scene vertex shader
+ *  does, so the software renderers match the OpenGL path.
+ ***********************************************************/
+glm::vec3 WindSystem::ApplyWind(
+	const WIND_UNIFORMS& wind,
+	glm::vec3 worldPosition,
+	glm::vec3 instanceOrigin,
+	float stiffness,
+	float phase)
+{
+	if (stiffness <= 0.0f)
+	{
+		return(worldPosition);
+	}
+
+	float height = std::max(worldPosition.y - instanceOrigin.y, 0.0f);
+
+	float sway = std::sin(wind.parameters.x + phase) * wind.direction.w;
+	float gust = (std::sin(wind.parameters.y + phase * 0.25f) * 0.5f + 0.5f) * wind.parameters.w;
+	float flutter = std::sin(wind.parameters.z + glm::dot(worldPosition, glm::vec3(1.7f, 0.9f, 1.3f))) * wind.direction.w * 0.15f;
+
+	return(worldPosition + glm::vec3(wind.direction) * ((sway + gust + flutter) * height / stiffness));
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// windsystem.h
+// ============
+// global wind parameters for the vertex shader foliage animation
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLResources.h"
+
+#include <glm/glm.hpp>
+
+// uniform block binding point of the wind parameters
+const GLuint WIND_BLOCK_BINDING = 0;
+
+/***********************************************************
+ *  WIND_UNIFORMS
+ *
+ *  The wind parameters shared by every swaying instance.
+ *  The layout matches the std140 WindBlock in
+ *  Shaders/sceneVertex.glsl.
+ ***********************************************************/
+struct WIND_UNIFORMS
+{
+	// xyz - normalized direction, w - sway strength
+	glm::vec4 direction;
+	// x - sway angle, y - gust angle, z - flutter angle, each
+	// wrapped to one period, w - gust strength
+	glm::vec4 parameters;
+};
+
+static_assert(sizeof(WIND_UNIFORMS) == 32, "WIND_UNIFORMS must match the std140 shader layout");
+
+/***********************************************************
+ *  WindSystem
+ *
+ *  This class owns the uniform buffer holding the global
+ *  wind.  The foliage is bent in the vertex shader using
+ *  these values and the phase and stiffness stored in each
+ *  instance record, so the only CPU work per frame is one
+ *  32 byte upload no matter how many instances sway.
+ ***********************************************************/
+class WindSystem
+{
+public:
+	// constructor
+	WindSystem();
+
+	// change the wind - the direction does not need to be normalized
+	void SetWind(glm::vec3 direction, float strength, float frequency);
+	void SetGusts(float strength, float frequency);
+
+	// upload the wind for the passed in time and bind the block
+	void Update(double timeSeconds);
+	// the wind as the shader sees it at the passed in time
+	WIND_UNIFORMS GetUniforms(double timeSeconds) const;
+
+	// phase offset of an instance at the passed in position, so
+	// neighbouring plants do not sway in lockstep
+	static float GetInstancePhase(glm::vec3 position);
+	// CPU version of ApplyWind() in Shaders/sceneVertex.glsl, used
+	// by the software renderers
+	static glm::vec3 ApplyWind(
+		const WIND_UNIFORMS& wind,
+		glm::vec3 worldPosition,
+		glm::vec3 instanceOrigin,
+		float stiffness,
+		float phase);
+
+private:
+	WIND_UNIFORMS m_uniforms;
+	// radians a second of the sway and the gusts
+	float m_frequency;
+	float m_gustFrequency;
+	GLBufferHandle m_buffer;
+};